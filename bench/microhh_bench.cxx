@@ -0,0 +1,239 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Micro-benchmark of the hot CPU kernels on synthetic fields, without input files.
+// The memory roof is the bandwidth of a triad over fields of the same size, such that
+// the percentage shows how close the memory-bound kernels get to the attainable bandwidth.
+//
+// usage: microhh_bench [itot jtot ktot [niter]]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+#include "diff_kernels.h"
+#include "thermo_moist_functions.h"
+
+#ifdef FLOAT_SINGLE
+using TF = float;
+#else
+using TF = double;
+#endif
+
+namespace
+{
+    struct Bench_grid
+    {
+        int itot, jtot, ktot;
+        int igc, jgc, kgc;
+        int icells, jcells, kcells, ijcells, ncells;
+        int istart, iend, jstart, jend, kstart, kend;
+
+        Bench_grid(const int itot_in, const int jtot_in, const int ktot_in) :
+            itot(itot_in), jtot(jtot_in), ktot(ktot_in), igc(2), jgc(2), kgc(2)
+        {
+            icells = itot + 2*igc;
+            jcells = jtot + 2*jgc;
+            kcells = ktot + 2*kgc;
+            ijcells = icells*jcells;
+            ncells = ijcells*kcells;
+
+            istart = igc;
+            iend = itot + igc;
+            jstart = jgc;
+            jend = jtot + jgc;
+            kstart = kgc;
+            kend = ktot + kgc;
+        }
+
+        double npoints() const { return static_cast<double>(itot)*jtot*ktot; }
+    };
+
+    std::vector<TF> random_field(const int n, const TF offset, const TF amplitude, std::mt19937& gen)
+    {
+        std::uniform_real_distribution<TF> dist(-amplitude, amplitude);
+        std::vector<TF> fld(n);
+        for (auto& value : fld)
+            value = offset + dist(gen);
+        return fld;
+    }
+
+    // Best time per call in seconds, after one warm-up call.
+    double time_kernel(const std::function<void()>& kernel, const int niter)
+    {
+        kernel();
+
+        double best = 1.e30;
+        for (int n=0; n<niter; ++n)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            kernel();
+            const auto end = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(end - start).count());
+        }
+        return best;
+    }
+
+    void report(
+            const std::string& name, const double time, const double bytes, const double flops,
+            const double roof_bandwidth)
+    {
+        const double bandwidth = bytes / time * 1.e-9;
+
+        if (flops > 0.)
+            std::printf("%-24s %10.3f %10.2f %10.2f %8.1f\n",
+                    name.c_str(), 1.e3*time, bandwidth, flops / time * 1.e-9, 100.*bandwidth/roof_bandwidth);
+        else
+            std::printf("%-24s %10.3f %10.2f %10s %8.1f\n",
+                    name.c_str(), 1.e3*time, bandwidth, "-", 100.*bandwidth/roof_bandwidth);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 1 && argc != 4 && argc != 5)
+    {
+        std::fprintf(stderr, "usage: %s [itot jtot ktot [niter]]\n", argv[0]);
+        return 1;
+    }
+
+    const int itot  = (argc > 1) ? std::atoi(argv[1]) : 256;
+    const int jtot  = (argc > 1) ? std::atoi(argv[2]) : 256;
+    const int ktot  = (argc > 1) ? std::atoi(argv[3]) : 128;
+    const int niter = (argc > 4) ? std::atoi(argv[4]) : 10;
+
+    if (itot < 1 || jtot < 1 || ktot < 4 || niter < 1)
+    {
+        std::fprintf(stderr, "ERROR: the grid needs at least 1x1x4 points and one iteration\n");
+        return 1;
+    }
+
+    const Bench_grid g(itot, jtot, ktot);
+    const double npoints = g.npoints();
+    const double fld_bytes = npoints*sizeof(TF);
+
+    std::mt19937 gen(1);
+
+    // Synthetic fields: a turbulent velocity field, a scalar, and a moist state near saturation.
+    std::vector<TF> u = random_field(g.ncells, TF(5.), TF(1.), gen);
+    std::vector<TF> v = random_field(g.ncells, TF(0.), TF(1.), gen);
+    std::vector<TF> w = random_field(g.ncells, TF(0.), TF(1.), gen);
+    std::vector<TF> s = random_field(g.ncells, TF(300.), TF(1.), gen);
+    std::vector<TF> qt = random_field(g.ncells, TF(0.015), TF(0.002), gen);
+    std::vector<TF> evisc = random_field(g.ncells, TF(1.), TF(0.1), gen);
+    std::vector<TF> tend(g.ncells, TF(0.));
+    std::vector<TF> out(g.ncells, TF(0.));
+
+    std::vector<TF> z(g.kcells), dzi(g.kcells), dzhi(g.kcells), rhoref(g.kcells, TF(1.)), rhorefh(g.kcells, TF(1.));
+    std::vector<TF> p(g.kcells), exn(g.kcells);
+    const TF dz = TF(20.);
+    for (int k=0; k<g.kcells; ++k)
+    {
+        z[k] = (k - g.kstart + TF(0.5))*dz;
+        dzi[k] = TF(1.)/dz;
+        dzhi[k] = TF(1.)/dz;
+        p[k] = TF(1.e5)*std::exp(-std::max(z[k], TF(0.))/TF(8000.));
+        exn[k] = std::pow(p[k]/TF(1.e5), TF(Constants::Rd<double>/Constants::cp<double>));
+    }
+
+    std::vector<TF> flux2d(g.ijcells, TF(0.));
+
+    const TF dxi = TF(1.)/TF(50.);
+    const TF dyi = TF(1.)/TF(50.);
+
+    std::printf("Grid %d x %d x %d, %d iterations, %zu byte floats\n", itot, jtot, ktot, niter, sizeof(TF));
+    std::printf("%-24s %10s %10s %10s %8s\n", "kernel", "time (ms)", "GB/s", "GFLOP/s", "% roof");
+
+    // Memory roof: out = u + 2*v, two reads and one write per point.
+    const double time_triad = time_kernel([&]()
+    {
+        #pragma omp parallel for
+        for (int k=g.kstart; k<g.kend; ++k)
+            for (int j=g.jstart; j<g.jend; ++j)
+                #pragma ivdep
+                for (int i=g.istart; i<g.iend; ++i)
+                {
+                    const int ijk = i + j*g.icells + k*g.ijcells;
+                    out[ijk] = u[ijk] + TF(2.)*v[ijk];
+                }
+    }, niter);
+    const double roof_bandwidth = 3.*fld_bytes / time_triad * 1.e-9;
+    report("triad", time_triad, 3.*fld_bytes, 2.*npoints, roof_bandwidth);
+
+    // The flop counts are counted from the interior loops of the kernels.
+    const double time_strain2 = time_kernel([&]()
+    {
+        Diff_kernels::calc_strain2<TF, Surface_model::Disabled>(
+                out.data(), u.data(), v.data(), w.data(),
+                flux2d.data(), flux2d.data(),
+                z.data(), dzi.data(), dzhi.data(), dxi, dyi,
+                g.istart, g.iend, g.jstart, g.jend, g.kstart, g.kend,
+                g.icells, g.ijcells);
+    }, niter);
+    report("calc_strain2", time_strain2, 4.*fld_bytes, 110.*npoints, roof_bandwidth);
+
+    const double time_diff_c = time_kernel([&]()
+    {
+        Diff_kernels::diff_c<TF, Surface_model::Disabled>(
+                tend.data(), s.data(), dzi.data(), dzhi.data(),
+                dxi*dxi, dyi*dyi, evisc.data(),
+                flux2d.data(), flux2d.data(), rhoref.data(), rhorefh.data(),
+                TF(1./3.), TF(1.e-5),
+                g.istart, g.iend, g.jstart, g.jend, g.kstart, g.kend,
+                g.icells, g.ijcells);
+    }, niter);
+    report("diff_c", time_diff_c, 4.*fld_bytes, 48.*npoints, roof_bandwidth);
+
+    const double time_diff_u = time_kernel([&]()
+    {
+        Diff_kernels::diff_u<TF, Surface_model::Disabled>(
+                tend.data(), u.data(), v.data(), w.data(), dzi.data(), dzhi.data(),
+                dxi, dyi, evisc.data(),
+                flux2d.data(), flux2d.data(), rhoref.data(), rhorefh.data(),
+                TF(1.e-5),
+                g.istart, g.iend, g.jstart, g.jend, g.kstart, g.kend,
+                g.icells, g.ijcells);
+    }, niter);
+    report("diff_u", time_diff_u, 6.*fld_bytes, 0., roof_bandwidth);
+
+    // The iterations of the saturation adjustment depend on the state, so no flops are reported.
+    const double time_sat_adjust = time_kernel([&]()
+    {
+        #pragma omp parallel for
+        for (int k=g.kstart; k<g.kend; ++k)
+            for (int j=g.jstart; j<g.jend; ++j)
+                for (int i=g.istart; i<g.iend; ++i)
+                {
+                    const int ijk = i + j*g.icells + k*g.ijcells;
+                    out[ijk] = Thermo_moist_functions::sat_adjust(s[ijk], qt[ijk], p[k], exn[k]).ql;
+                }
+    }, niter);
+    report("sat_adjust", time_sat_adjust, 3.*fld_bytes, 0., roof_bandwidth);
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+"""
+Performance regression suite. Runs a fixed set of short cases with a fixed time step at a few
+grid sizes and process layouts, collects the module timers from (case).timing, and writes the
+mean wall clock time per module to a JSON file. If a baseline JSON file from an earlier run is
+given, every module that became slower than the threshold is reported, and the script fails.
+
+usage: python run_perf_set.py [--output perf.json] [--baseline perf_ref.json] [--threshold 0.1]
+"""
+
+import argparse
+import json
+import sys
+import os
+sys.path.append('../python/')
+import microhh_tools as mht
+
+modes = ['cpu', 'cpumpi', 'gpu']
+precs = ['dp', 'sp']
+
+# Number of time steps per run. The time step is fixed, such that every run does the same work.
+nsteps = 20
+
+# Time step per case; rico_radiation uses the GPU radiation and is only run on the GPU.
+# The input of weakscaling has a fixed vertical grid, such that only its horizontal size is set.
+cases = {
+    'drycblles': {'dt': 1., 'modes': modes, 'fixed_ktot': False},
+    'bomex': {'dt': 1., 'modes': modes, 'fixed_ktot': False},
+    'rico': {'dt': 1., 'modes': modes, 'fixed_ktot': False},
+    'weakscaling': {'dt': 0.001, 'modes': modes, 'fixed_ktot': True},
+    'rico_radiation': {'dt': 1., 'modes': ['gpu'], 'fixed_ktot': False}}
+
+sizes = {
+    'small': {'itot': 32, 'jtot': 32, 'ktot': 32},
+    'medium': {'itot': 64, 'jtot': 64, 'ktot': 64}}
+
+layouts_mpi = [(2, 1), (2, 2)]
+
+# Sections that take less than this time (s) are too noisy to compare against the baseline.
+min_time = 0.05
+
+
+def perf_options(dt, size, npx, npy, fixed_ktot):
+    endtime = nsteps*dt
+    grid = {key: value for key, value in size.items() if not (fixed_ktot and key == 'ktot')}
+    return {
+        'master': {'npx': npx, 'npy': npy},
+        'grid': grid,
+        'time': {'adaptivestep': False, 'dt': dt, 'endtime': endtime, 'savetime': endtime},
+        'stats': {'swstats': 0},
+        'cross': {'swcross': 0},
+        'dump': {'swdump': 0},
+        'column': {'swcolumn': 0},
+        'timer': {'swtimer': 1, 'interval': nsteps}}
+
+
+def compare(results, baseline, threshold):
+    nregressions = 0
+    for key, result in sorted(results.items()):
+        if key not in baseline:
+            mht.print_warning('{} is not in the baseline'.format(key))
+            continue
+
+        for name, time in result['sections'].items():
+            time_ref = baseline[key]['sections'].get(name)
+            if time_ref is None or max(time, time_ref) < min_time:
+                continue
+
+            ratio = time / time_ref
+            message = '{} {}: {:.3f} s vs {:.3f} s ({:+.1f}%)'.format(
+                    key, name, time, time_ref, 100.*(ratio-1.))
+
+            if ratio > 1. + threshold:
+                mht.print_error(message)
+                nregressions += 1
+            else:
+                print(message)
+
+    return nregressions
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='MicroHH performance regression suite')
+    parser.add_argument('--output', default='perf.json', help='JSON file with the timings')
+    parser.add_argument('--baseline', default=None, help='JSON file to compare the timings against')
+    parser.add_argument('--threshold', default=0.1, type=float, help='allowed relative slowdown per module')
+    args = parser.parse_args()
+
+    results = {}
+    failed = []
+
+    for prec in precs:
+        for mode in modes:
+            # Likely MicroHH binary locations:
+            ex1 = 'microhh_{}_{}'.format(prec, mode)
+            ex2 = '../build_{}_{}/microhh'.format(prec, mode)
+            if os.path.exists(ex1):
+                microhh_exec = ex1
+            elif os.path.exists(ex2):
+                microhh_exec = ex2
+            else:
+                mht.print_warning('Can not find an executable for \"{}\" + \"{}\", skipping'.format(prec, mode))
+                continue
+
+            layouts = layouts_mpi if mode == 'cpumpi' else [(1, 1)]
+
+            perf_cases = []
+            for name, settings in cases.items():
+                if mode not in settings['modes']:
+                    continue
+
+                for size_name, size in sizes.items():
+                    for npx, npy in layouts:
+                        key = '{}_{}_{}x{}_{}_{}'.format(name, size_name, npx, npy, prec, mode)
+                        perf_cases.append(mht.Case(
+                            name,
+                            options=perf_options(settings['dt'], size, npx, npy, settings['fixed_ktot']),
+                            rundir='perf_{}'.format(key)))
+
+            mht.run_cases(perf_cases, microhh_exec, mode)
+
+            for case in perf_cases:
+                key = case.rundir[len('perf_'):]
+                if not case.success:
+                    failed.append(key)
+                    continue
+
+                timing = mht.read_timing('{0}/{1}/{0}.timing'.format(case.casedir, case.rundir))
+                results[key] = {
+                    'time': case.time,
+                    'sections': {name: section['wall_mean'] for name, section in timing.items()}}
+
+    with open(args.output, 'w') as f:
+        json.dump(results, f, indent=4, sort_keys=True)
+
+    if failed:
+        sys.exit('Failed runs: {}'.format(', '.join(failed)))
+
+    if args.baseline is not None:
+        with open(args.baseline, 'r') as f:
+            baseline = json.load(f)
+
+        nregressions = compare(results, baseline, args.threshold)
+        if nregressions > 0:
+            sys.exit('{} module timings are more than {:.0f}% slower than the baseline'.format(
+                nregressions, 100.*args.threshold))
@@ -0,0 +1,131 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ACTUATOR_LINE_H
+#define ACTUATOR_LINE_H
+
+#include <vector>
+#include "turbine.h"
+#include "cuda_buffer.h"
+
+class Master;
+class Input;
+template<typename> class Grid;
+template<typename> class Fields;
+
+/**
+ * Rotating actuator line model for all turbines of a windfarm.
+ * Reads the following parameters from (case).ini file
+ *
+ * [turbine]
+ * nblades         ; number of blades (default 3)
+ * nelements       ; number of blade elements per blade (default 32)
+ * chord           ; blade chord (m, default 0.05 diam)
+ * cl_alpha        ; lift slope (rad-1, default 2 pi)
+ * cl_max          ; maximum lift coefficient (default 1.5)
+ * cd              ; drag coefficient (default 0.01)
+ * alpha_design    ; design angle of attack of the Betz twist (deg, default 6)
+ * epsilon         ; width of the Gaussian force projection (m, default 2 dx)
+ * tip_cfl         ; maximum tip displacement per sub-rotation in grid spacings (default 0.5)
+ *
+ * The blades of all turbines are stored as one structure-of-arrays of blade
+ * elements, with element `e = (t*nblades + b)*nelements + s`.
+ * The rotation is integrated per full time step. During a time step the forces are
+ * smeared over the swept sector in sub-rotations that satisfy `tip_cfl`, decoupled
+ * from the Runge-Kutta substeps.
+ */
+template<typename TF>
+class Actuator_line
+{
+    public:
+        Actuator_line(Master&, Grid<TF>&, Fields<TF>&, Input&);
+        ~Actuator_line();
+
+        void create(const std::vector<Turbine<TF>>&); ///< Setup the blade elements.
+
+        int get_n_elements() const { return n_elem; }
+
+        void advance(const std::vector<Turbine<TF>>&, double); ///< Rotate the blades to the given time.
+        void sample(TF* const);  ///< Local velocities at the blade elements, zero if not on this rank.
+        void exec(std::vector<Turbine<TF>>&, const TF* const, double); ///< Blade forces from the reduced velocities, and their projection.
+
+        #ifdef USECUDA
+        void prepare_device();
+        void clear_device();
+        #endif
+
+    private:
+        Master& master;
+        Grid<TF>& grid;
+        Fields<TF>& fields;
+
+        int nblades;
+        int nelements;
+        TF chord;
+        TF cl_alpha;
+        TF cl_max;
+        TF cd;
+        TF alpha_design;
+        TF epsilon;
+        TF tip_cfl;
+
+        int nturb;
+        int n_elem;
+
+        // Per turbine
+        std::vector<TF> radius;
+        std::vector<TF> x_hub;
+        std::vector<TF> y_hub;
+        std::vector<TF> z_hub;
+        std::vector<TF> yaw;
+        std::vector<TF> omega;
+        std::vector<TF> azimuth_start; ///< Azimuth at the start of the current time step
+        std::vector<TF> azimuth;       ///< Azimuth at the end of the current time step
+        std::vector<int> nsub;         ///< Number of sub-rotations over the swept sector
+        double time_last;
+
+        // Per blade element
+        std::vector<TF> elem_r;     ///< Radial position
+        std::vector<TF> elem_dr;    ///< Radial width
+        std::vector<TF> elem_twist; ///< Twist angle
+        std::vector<int> elem_ijk;  ///< Local u, v and w index (3 per element), -1 if not on this rank
+        std::vector<TF> elem_fn;    ///< Rotor-normal force
+        std::vector<TF> elem_ft;    ///< Tangential force
+
+        void set_sample_indices();
+
+        #ifdef USECUDA
+        cuda_vector<TF> turb_g;      ///< Per turbine hub x, y, z, radius, yaw, azimuth_start, azimuth, omega
+        cuda_vector<int> nsub_g;
+        cuda_vector<TF> elem_r_g;
+        cuda_vector<TF> elem_dr_g;
+        cuda_vector<TF> elem_twist_g;
+        cuda_vector<int> elem_ijk_g;
+        cuda_vector<TF> elem_vel_g;
+        cuda_vector<TF> elem_fn_g;
+        cuda_vector<TF> elem_ft_g;
+        std::vector<TF> turb;
+        #endif
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ACTUATOR_LINE_KERNELS_H
+#define ACTUATOR_LINE_KERNELS_H
+
+#include <cmath>
+#include "fast_math.h"
+
+namespace Actuator_line_kernels
+{
+    namespace fm = Fast_math;
+
+    // Unit vectors of a blade at azimuth `theta` in a rotor with yaw `yaw`: the rotor normal
+    // `n`, the radial direction `r` and the direction of rotation `t`.
+    template<typename TF> CUDA_MACRO inline
+    void blade_vectors(
+            TF& nx, TF& ny,
+            TF& rx, TF& ry, TF& rz,
+            TF& tx, TF& ty, TF& tz,
+            const TF yaw, const TF theta)
+    {
+        nx = cos(yaw);
+        ny = sin(yaw);
+
+        // Radial and tangential direction in the rotor plane spanned by (-sin yaw, cos yaw, 0) and (0, 0, 1).
+        const TF st = sin(theta);
+        const TF ct = cos(theta);
+
+        rx = -st*ny;
+        ry =  st*nx;
+        rz =  ct;
+
+        tx = -ct*ny;
+        ty =  ct*nx;
+        tz = -st;
+    }
+
+    // Rotor-normal and tangential force of a blade element per unit density, from the velocity
+    // normal to the rotor `un` and the velocity of the blade relative to the flow `ut`.
+    template<typename TF> CUDA_MACRO inline
+    void blade_element_force(
+            TF& fn, TF& ft,
+            const TF un, const TF ut, const TF dr, const TF twist,
+            const TF chord, const TF cl_alpha, const TF cl_max, const TF cd)
+    {
+        const TF phi = atan2(un, ut);
+        const TF alpha = phi - twist;
+
+        const TF cl = fmin(fmax(cl_alpha*alpha, -cl_max), cl_max);
+
+        const TF q = TF(0.5) * (un*un + ut*ut) * chord * dr;
+        const TF lift = q*cl;
+        const TF drag = q*cd;
+
+        fn = lift*cos(phi) + drag*sin(phi);
+        ft = lift*sin(phi) - drag*cos(phi);
+    }
+
+    // Normalised 3D Gaussian projection kernel.
+    template<typename TF> CUDA_MACRO inline
+    TF gaussian(const TF d2, const TF epsilon)
+    {
+        const TF pi = TF(3.14159265358979323846);
+        return exp(-d2/fm::pow2(epsilon)) / (fm::pow3(epsilon) * pow(pi, TF(1.5)));
+    }
+}
+#endif
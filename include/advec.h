@@ -24,6 +24,7 @@
 #define ADVEC_H
 
 #include <string>
+#include <vector>
 #include <memory>
 #include "field3d_operators.h"
 
@@ -32,6 +33,7 @@ class Input;
 template<typename> class Grid;
 template<typename> class Fields;
 template<typename> class Stats;
+template<typename> class Thermo;
 
 enum class Advection_type {
     Disabled, Advec_2, Advec_4, Advec_4m,
@@ -56,9 +58,23 @@ class Advec
         virtual unsigned long get_time_limit(unsigned long, double) = 0; ///< Get the maximum time step imposed by advection scheme
         virtual double get_cfl(double) = 0; ///< Retrieve the CFL number.
 
+        // Split of get_time_limit() for the fused time step limit in Model, that reduces all limits at once.
+        virtual double get_cfl_local(double dt) { return get_cfl(dt); } ///< CFL number of this process.
+        virtual unsigned long get_time_limit_from_cfl(unsigned long, double); ///< Time step limit from the reduced CFL number.
+
         virtual void get_advec_flux(Field3d<TF>&, const Field3d<TF>&) = 0;
         virtual Advection_type get_switch() const = 0;
 
+        const std::vector<std::string>& get_split_list() const { return split_list; }
+
+        // Add a gravitational settling velocity to the vertical velocity with which a scalar is advected.
+        // Returns false if the scheme cannot, in which case the caller has to apply the settling itself.
+        virtual bool set_settling_velocity(const std::string&, const TF) { return false; }
+
+        // Add the buoyancy of `thermo` in the advection kernel of w, on the steps of Thermo::do_fused_buoyancy().
+        // Returns false if the scheme cannot.
+        virtual bool set_fused_buoyancy(const Thermo<TF>&) { return false; }
+
     protected:
         Master& master; ///< Pointer to master class.
         Grid<TF>& grid; ///< Pointer to grid class.
@@ -67,5 +83,8 @@ class Advec
 
         double cflmax; ///< Maximum allowed value for the CFL criterion.
         const double cflmin; ///< Minimum value for CFL used to avoid overflows.
+
+        std::vector<std::string> split_list; ///< Scalars that are advected by Advec_split instead.
+        bool is_split(const std::string&) const;
 };
 #endif
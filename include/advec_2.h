@@ -45,10 +45,15 @@ class Advec_2 : public Advec<TF>
         void exec(Stats<TF>&); ///< Execute the advection scheme.
         unsigned long get_time_limit(long unsigned int, double); ///< Get the limit on the time step imposed by the advection scheme.
         double get_cfl(double); ///< Get the CFL number.
+        #ifndef USECUDA
+        double get_cfl_local(double); ///< Get the CFL number of this process, without the reduction.
+        #endif
 
         void get_advec_flux(Field3d<TF>&, const Field3d<TF>&);
         Advection_type get_switch() const { return Advection_type::Advec_2; }
 
+        bool set_fused_buoyancy(const Thermo<TF>&);
+
     private:
         using Advec<TF>::master;
         using Advec<TF>::grid;
@@ -57,6 +62,9 @@ class Advec_2 : public Advec<TF>
 
         using Advec<TF>::cflmax;
         using Advec<TF>::cflmin;
+        using Advec<TF>::is_split;
+
+        const Thermo<TF>* thermo = nullptr; ///< Source of the fused buoyancy of w.
 
         const std::string tend_name = "advec";
         const std::string tend_longname = "Advection";
@@ -0,0 +1,394 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ADVEC_2I4_KERNELS_CUH
+#define ADVEC_2I4_KERNELS_CUH
+
+#include "finite_difference.h"
+#include "cuda_tiling.h"
+
+namespace Advec_2i4_kernels
+{
+    using namespace Finite_difference::O2;
+    using namespace Finite_difference::O4;
+
+    // The edge levels make the launcher take the branch free interior path away from the
+    // walls. With a z tile factor, each thread marches over a contiguous part of a column,
+    // such that the vertical neighbours of the fourth order stencils are reused in registers.
+    template<typename TF>
+    struct advec_u_g
+    {
+        DEFINE_GRID_KERNEL("advec_2i4::advec_u", 2)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g,
+                const int i, const int j, const int k,
+                const Level level,
+                TF* __restrict__ ut, const TF* __restrict__ u,
+                const TF* __restrict__ v, const TF* __restrict__ w,
+                const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
+                const TF* __restrict__ dzi, const TF dxi, const TF dyi)
+        {
+            const int ii1 = 1*g.istride;
+            const int ii2 = 2*g.istride;
+            const int jj1 = 1*g.jstride;
+            const int jj2 = 2*g.jstride;
+            const int kk1 = 1*g.kstride;
+            const int kk2 = 2*g.kstride;
+
+            const int ijk = g(i, j, k);
+
+            if (level.distance_to_start() == 0)
+            {
+                ut[ijk] +=
+                    - (  interp2(u[ijk        ], u[ijk+ii1]) * interp4c(u[ijk-ii1], u[ijk    ], u[ijk+ii1], u[ijk+ii2])
+                       - interp2(u[ijk-ii1    ], u[ijk    ]) * interp4c(u[ijk-ii2], u[ijk-ii1], u[ijk    ], u[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk-ii1+jj1], v[ijk+jj1]) * interp4c(u[ijk-jj1], u[ijk    ], u[ijk+jj1], u[ijk+jj2])
+                       - interp2(v[ijk-ii1    ], v[ijk    ]) * interp4c(u[ijk-jj2], u[ijk-jj1], u[ijk    ], u[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * interp2(w[ijk-ii1+kk1], w[ijk+kk1]) * interp2(u[ijk    ], u[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_start() == 1)
+            {
+                ut[ijk] +=
+                    - (  interp2(u[ijk        ], u[ijk+ii1]) * interp4c(u[ijk-ii1], u[ijk    ], u[ijk+ii1], u[ijk+ii2])
+                       - interp2(u[ijk-ii1    ], u[ijk    ]) * interp4c(u[ijk-ii2], u[ijk-ii1], u[ijk    ], u[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk-ii1+jj1], v[ijk+jj1]) * interp4c(u[ijk-jj1], u[ijk    ], u[ijk+jj1], u[ijk+jj2])
+                       - interp2(v[ijk-ii1    ], v[ijk    ]) * interp4c(u[ijk-jj2], u[ijk-jj1], u[ijk    ], u[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * interp2(w[ijk-ii1+kk1], w[ijk+kk1]) * interp4c(u[ijk-kk1], u[ijk    ], u[ijk+kk1], u[ijk+kk2])
+                       - rhorefh[k  ] * interp2(w[ijk-ii1    ], w[ijk    ]) * interp2(u[ijk-kk1], u[ijk    ]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_end() == 1)
+            {
+                ut[ijk] +=
+                    - (  interp2(u[ijk        ], u[ijk+ii1]) * interp4c(u[ijk-ii1], u[ijk    ], u[ijk+ii1], u[ijk+ii2])
+                       - interp2(u[ijk-ii1    ], u[ijk    ]) * interp4c(u[ijk-ii2], u[ijk-ii1], u[ijk    ], u[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk-ii1+jj1], v[ijk+jj1]) * interp4c(u[ijk-jj1], u[ijk    ], u[ijk+jj1], u[ijk+jj2])
+                       - interp2(v[ijk-ii1    ], v[ijk    ]) * interp4c(u[ijk-jj2], u[ijk-jj1], u[ijk    ], u[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * interp2(w[ijk-ii1+kk1], w[ijk+kk1]) * interp2(u[ijk    ], u[ijk+kk1])
+                       - rhorefh[k  ] * interp2(w[ijk-ii1    ], w[ijk    ]) * interp4c(u[ijk-kk2], u[ijk-kk1], u[ijk    ], u[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_end() == 0)
+            {
+                ut[ijk] +=
+                    - (  interp2(u[ijk        ], u[ijk+ii1]) * interp4c(u[ijk-ii1], u[ijk    ], u[ijk+ii1], u[ijk+ii2])
+                       - interp2(u[ijk-ii1    ], u[ijk    ]) * interp4c(u[ijk-ii2], u[ijk-ii1], u[ijk    ], u[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk-ii1+jj1], v[ijk+jj1]) * interp4c(u[ijk-jj1], u[ijk    ], u[ijk+jj1], u[ijk+jj2])
+                       - interp2(v[ijk-ii1    ], v[ijk    ]) * interp4c(u[ijk-jj2], u[ijk-jj1], u[ijk    ], u[ijk+jj1]) ) * dyi
+
+                    - ( -rhorefh[k] * interp2(w[ijk-ii1    ], w[ijk    ]) * interp2(u[ijk-kk1], u[ijk    ]) ) / rhoref[k] * dzi[k];
+            }
+            else
+            {
+                ut[ijk] +=
+                    - (  interp2(u[ijk        ], u[ijk+ii1]) * interp4c(u[ijk-ii1], u[ijk    ], u[ijk+ii1], u[ijk+ii2])
+                       - interp2(u[ijk-ii1    ], u[ijk    ]) * interp4c(u[ijk-ii2], u[ijk-ii1], u[ijk    ], u[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk-ii1+jj1], v[ijk+jj1]) * interp4c(u[ijk-jj1], u[ijk    ], u[ijk+jj1], u[ijk+jj2])
+                       - interp2(v[ijk-ii1    ], v[ijk    ]) * interp4c(u[ijk-jj2], u[ijk-jj1], u[ijk    ], u[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * interp2(w[ijk-ii1+kk1], w[ijk+kk1]) * interp4c(u[ijk-kk1], u[ijk    ], u[ijk+kk1], u[ijk+kk2])
+                       - rhorefh[k  ] * interp2(w[ijk-ii1    ], w[ijk    ]) * interp4c(u[ijk-kk2], u[ijk-kk1], u[ijk    ], u[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+        }
+    };
+
+    template<typename TF>
+    struct advec_v_g
+    {
+        DEFINE_GRID_KERNEL("advec_2i4::advec_v", 2)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g,
+                const int i, const int j, const int k,
+                const Level level,
+                TF* __restrict__ vt, const TF* __restrict__ u,
+                const TF* __restrict__ v, const TF* __restrict__ w,
+                const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
+                const TF* __restrict__ dzi, const TF dxi, const TF dyi)
+        {
+            const int ii1 = 1*g.istride;
+            const int ii2 = 2*g.istride;
+            const int jj1 = 1*g.jstride;
+            const int jj2 = 2*g.jstride;
+            const int kk1 = 1*g.kstride;
+            const int kk2 = 2*g.kstride;
+
+            const int ijk = g(i, j, k);
+
+            if (level.distance_to_start() == 0)
+            {
+                vt[ijk] +=
+                    - (  interp2(u[ijk+ii1-jj1], u[ijk+ii1]) * interp4c(v[ijk-ii1], v[ijk    ], v[ijk+ii1], v[ijk+ii2])
+                       - interp2(u[ijk    -jj1], u[ijk    ]) * interp4c(v[ijk-ii2], v[ijk-ii1], v[ijk    ], v[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk        ], v[ijk+jj1]) * interp4c(v[ijk-jj1], v[ijk    ], v[ijk+jj1], v[ijk+jj2])
+                       - interp2(v[ijk-jj1    ], v[ijk    ]) * interp4c(v[ijk-jj2], v[ijk-jj1], v[ijk    ], v[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * interp2(w[ijk-jj1+kk1], w[ijk+kk1]) * interp2(v[ijk    ], v[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_start() == 1)
+            {
+                vt[ijk] +=
+                    - (  interp2(u[ijk+ii1-jj1], u[ijk+ii1]) * interp4c(v[ijk-ii1], v[ijk    ], v[ijk+ii1], v[ijk+ii2])
+                       - interp2(u[ijk    -jj1], u[ijk    ]) * interp4c(v[ijk-ii2], v[ijk-ii1], v[ijk    ], v[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk        ], v[ijk+jj1]) * interp4c(v[ijk-jj1], v[ijk    ], v[ijk+jj1], v[ijk+jj2])
+                       - interp2(v[ijk-jj1    ], v[ijk    ]) * interp4c(v[ijk-jj2], v[ijk-jj1], v[ijk    ], v[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * interp2(w[ijk-jj1+kk1], w[ijk+kk1]) * interp4c(v[ijk-kk1], v[ijk    ], v[ijk+kk1], v[ijk+kk2])
+                       - rhorefh[k  ] * interp2(w[ijk-jj1    ], w[ijk    ]) * interp2(v[ijk-kk1], v[ijk    ]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_end() == 1)
+            {
+                vt[ijk] +=
+                    - (  interp2(u[ijk+ii1-jj1], u[ijk+ii1]) * interp4c(v[ijk-ii1], v[ijk    ], v[ijk+ii1], v[ijk+ii2])
+                       - interp2(u[ijk    -jj1], u[ijk    ]) * interp4c(v[ijk-ii2], v[ijk-ii1], v[ijk    ], v[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk        ], v[ijk+jj1]) * interp4c(v[ijk-jj1], v[ijk    ], v[ijk+jj1], v[ijk+jj2])
+                       - interp2(v[ijk-jj1    ], v[ijk    ]) * interp4c(v[ijk-jj2], v[ijk-jj1], v[ijk    ], v[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * interp2(w[ijk-jj1+kk1], w[ijk+kk1]) * interp2(v[ijk    ], v[ijk+kk1])
+                       - rhorefh[k  ] * interp2(w[ijk-jj1    ], w[ijk    ]) * interp4c(v[ijk-kk2], v[ijk-kk1], v[ijk    ], v[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_end() == 0)
+            {
+                vt[ijk] +=
+                    - (  interp2(u[ijk+ii1-jj1], u[ijk+ii1]) * interp4c(v[ijk-ii1], v[ijk    ], v[ijk+ii1], v[ijk+ii2])
+                       - interp2(u[ijk    -jj1], u[ijk    ]) * interp4c(v[ijk-ii2], v[ijk-ii1], v[ijk    ], v[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk        ], v[ijk+jj1]) * interp4c(v[ijk-jj1], v[ijk    ], v[ijk+jj1], v[ijk+jj2])
+                       - interp2(v[ijk-jj1    ], v[ijk    ]) * interp4c(v[ijk-jj2], v[ijk-jj1], v[ijk    ], v[ijk+jj1]) ) * dyi
+
+                    - (- rhorefh[k  ] * interp2(w[ijk-jj1    ], w[ijk    ]) * interp2(v[ijk-kk1], v[ijk    ]) ) / rhoref[k] * dzi[k];
+            }
+            else
+            {
+                vt[ijk] +=
+                    - (  interp2(u[ijk+ii1-jj1], u[ijk+ii1]) * interp4c(v[ijk-ii1], v[ijk    ], v[ijk+ii1], v[ijk+ii2])
+                       - interp2(u[ijk    -jj1], u[ijk    ]) * interp4c(v[ijk-ii2], v[ijk-ii1], v[ijk    ], v[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk        ], v[ijk+jj1]) * interp4c(v[ijk-jj1], v[ijk    ], v[ijk+jj1], v[ijk+jj2])
+                       - interp2(v[ijk-jj1    ], v[ijk    ]) * interp4c(v[ijk-jj2], v[ijk-jj1], v[ijk    ], v[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * interp2(w[ijk-jj1+kk1], w[ijk+kk1]) * interp4c(v[ijk-kk1], v[ijk    ], v[ijk+kk1], v[ijk+kk2])
+                       - rhorefh[k  ] * interp2(w[ijk-jj1    ], w[ijk    ]) * interp4c(v[ijk-kk2], v[ijk-kk1], v[ijk    ], v[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+        }
+    };
+
+    template<typename TF>
+    struct advec_w_g
+    {
+        DEFINE_GRID_KERNEL("advec_2i4::advec_w", 1)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g,
+                const int i, const int j, const int k,
+                const Level level,
+                TF* __restrict__ wt, const TF* __restrict__ u,
+                const TF* __restrict__ v, const TF* __restrict__ w,
+                const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
+                const TF* __restrict__ dzhi, const TF dxi, const TF dyi)
+        {
+            const int ii1 = 1*g.istride;
+            const int ii2 = 2*g.istride;
+            const int jj1 = 1*g.jstride;
+            const int jj2 = 2*g.jstride;
+            const int kk1 = 1*g.kstride;
+            const int kk2 = 2*g.kstride;
+
+            const int ijk = g(i, j, k);
+
+            if (level.distance_to_start() == 0)
+            {
+                wt[ijk] +=
+                    - (  interp2(u[ijk+ii1-kk1], u[ijk+ii1]) * interp4c(w[ijk-ii1], w[ijk    ], w[ijk+ii1], w[ijk+ii2])
+                       - interp2(u[ijk    -kk1], u[ijk    ]) * interp4c(w[ijk-ii2], w[ijk-ii1], w[ijk    ], w[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk+jj1-kk1], v[ijk+jj1]) * interp4c(w[ijk-jj1], w[ijk    ], w[ijk+jj1], w[ijk+jj2])
+                       - interp2(v[ijk    -kk1], v[ijk    ]) * interp4c(w[ijk-jj2], w[ijk-jj1], w[ijk    ], w[ijk+jj1]) ) * dyi
+
+                    - (  rhoref[k  ] * interp2(w[ijk        ], w[ijk+kk1]) * interp4c(w[ijk-kk1], w[ijk    ], w[ijk+kk1], w[ijk+kk2])
+                       - rhoref[k-1] * interp2(w[ijk-kk1    ], w[ijk    ]) * interp2(w[ijk-kk1], w[ijk    ]) ) / rhorefh[k] * dzhi[k];
+            }
+            else if (level.distance_to_end() == 0)
+            {
+                wt[ijk] +=
+                    - (  interp2(u[ijk+ii1-kk1], u[ijk+ii1]) * interp4c(w[ijk-ii1], w[ijk    ], w[ijk+ii1], w[ijk+ii2])
+                       - interp2(u[ijk    -kk1], u[ijk    ]) * interp4c(w[ijk-ii2], w[ijk-ii1], w[ijk    ], w[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk+jj1-kk1], v[ijk+jj1]) * interp4c(w[ijk-jj1], w[ijk    ], w[ijk+jj1], w[ijk+jj2])
+                       - interp2(v[ijk    -kk1], v[ijk    ]) * interp4c(w[ijk-jj2], w[ijk-jj1], w[ijk    ], w[ijk+jj1]) ) * dyi
+
+                    - (  rhoref[k  ] * interp2(w[ijk        ], w[ijk+kk1]) * interp2(w[ijk    ], w[ijk+kk1])
+                       - rhoref[k-1] * interp2(w[ijk-kk1    ], w[ijk    ]) * interp4c(w[ijk-kk2], w[ijk-kk1], w[ijk    ], w[ijk+kk1]) ) / rhorefh[k] * dzhi[k];
+            }
+            else
+            {
+                wt[ijk] +=
+                    - (  interp2(u[ijk+ii1-kk1], u[ijk+ii1]) * interp4c(w[ijk-ii1], w[ijk    ], w[ijk+ii1], w[ijk+ii2])
+                       - interp2(u[ijk    -kk1], u[ijk    ]) * interp4c(w[ijk-ii2], w[ijk-ii1], w[ijk    ], w[ijk+ii1]) ) * dxi
+
+                    - (  interp2(v[ijk+jj1-kk1], v[ijk+jj1]) * interp4c(w[ijk-jj1], w[ijk    ], w[ijk+jj1], w[ijk+jj2])
+                       - interp2(v[ijk    -kk1], v[ijk    ]) * interp4c(w[ijk-jj2], w[ijk-jj1], w[ijk    ], w[ijk+jj1]) ) * dyi
+
+                    - (  rhoref[k  ] * interp2(w[ijk        ], w[ijk+kk1]) * interp4c(w[ijk-kk1], w[ijk    ], w[ijk+kk1], w[ijk+kk2])
+                       - rhoref[k-1] * interp2(w[ijk-kk1    ], w[ijk    ]) * interp4c(w[ijk-kk2], w[ijk-kk1], w[ijk    ], w[ijk+kk1]) ) / rhorefh[k] * dzhi[k];
+            }
+        }
+    };
+
+    template<typename TF>
+    struct advec_s_g
+    {
+        DEFINE_GRID_KERNEL("advec_2i4::advec_s", 2)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g,
+                const int i, const int j, const int k,
+                const Level level,
+                TF* __restrict__ st, const TF* __restrict__ s, const TF* __restrict__ u,
+                const TF* __restrict__ v, const TF* __restrict__ w,
+                const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
+                const TF* __restrict__ dzi, const TF dxi, const TF dyi)
+        {
+            const int ii1 = 1*g.istride;
+            const int ii2 = 2*g.istride;
+            const int jj1 = 1*g.jstride;
+            const int jj2 = 2*g.jstride;
+            const int kk1 = 1*g.kstride;
+            const int kk2 = 2*g.kstride;
+
+            const int ijk = g(i, j, k);
+
+            if (level.distance_to_start() == 0)
+            {
+                st[ijk] +=
+                    - (  u[ijk+ii1] * interp4c(s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2])
+                       - u[ijk    ] * interp4c(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1]) ) * dxi
+
+                    - (  v[ijk+jj1] * interp4c(s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2])
+                       - v[ijk    ] * interp4c(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * w[ijk+kk1] * interp2(s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_start() == 1)
+            {
+                st[ijk] +=
+                    - (  u[ijk+ii1] * interp4c(s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2])
+                       - u[ijk    ] * interp4c(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1]) ) * dxi
+
+                    - (  v[ijk+jj1] * interp4c(s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2])
+                       - v[ijk    ] * interp4c(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * w[ijk+kk1] * interp4c(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                       - rhorefh[k  ] * w[ijk    ] * interp2(s[ijk-kk1], s[ijk    ]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_end() == 1)
+            {
+                st[ijk] +=
+                    - (  u[ijk+ii1] * interp4c(s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2])
+                       - u[ijk    ] * interp4c(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1]) ) * dxi
+
+                    - (  v[ijk+jj1] * interp4c(s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2])
+                       - v[ijk    ] * interp4c(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * w[ijk+kk1] * interp2(s[ijk    ], s[ijk+kk1])
+                       - rhorefh[k  ] * w[ijk    ] * interp4c(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+            else if (level.distance_to_end() == 0)
+            {
+                st[ijk] +=
+                    - (  u[ijk+ii1] * interp4c(s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2])
+                       - u[ijk    ] * interp4c(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1]) ) * dxi
+
+                    - (  v[ijk+jj1] * interp4c(s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2])
+                       - v[ijk    ] * interp4c(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
+
+                    - (- rhorefh[k  ] * w[ijk    ] * interp2(s[ijk-kk1], s[ijk    ]) ) / rhoref[k] * dzi[k];
+            }
+            else
+            {
+                st[ijk] +=
+                    - (  u[ijk+ii1] * interp4c(s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2])
+                       - u[ijk    ] * interp4c(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1]) ) * dxi
+
+                    - (  v[ijk+jj1] * interp4c(s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2])
+                       - v[ijk    ] * interp4c(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
+
+                    - (  rhorefh[k+1] * w[ijk+kk1] * interp4c(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                       - rhorefh[k  ] * w[ijk    ] * interp4c(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+            }
+        }
+    };
+
+    template<typename TF>
+    struct calc_cfl_g
+    {
+        DEFINE_GRID_KERNEL("advec_2i4::calc_cfl_g", 1)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g,
+                const int i, const int j, const int k,
+                const Level level,
+                TF* const __restrict__ tmp1,
+                const TF* __restrict__ u, const TF* __restrict__ v, const TF* __restrict__ w,
+                const TF* __restrict__ dzi, const TF dxi, const TF dyi)
+        {
+            const int ii1 = 1*g.istride;
+            const int ii2 = 2*g.istride;
+            const int jj1 = 1*g.jstride;
+            const int jj2 = 2*g.jstride;
+            const int kk1 = 1*g.kstride;
+            const int kk2 = 2*g.kstride;
+
+            const int ijk = g(i, j, k);
+
+            if (level.distance_to_start() == 0 || level.distance_to_end() == 0)
+                tmp1[ijk] = fabs(interp4c(u[ijk-ii1], u[ijk    ], u[ijk+ii1], u[ijk+ii2]))*dxi
+                          + fabs(interp4c(v[ijk-jj1], v[ijk    ], v[ijk+jj1], v[ijk+jj2]))*dyi
+                          + fabs(interp2(w[ijk    ], w[ijk+kk1]))*dzi[k];
+            else
+                tmp1[ijk] = fabs(interp4c(u[ijk-ii1], u[ijk], u[ijk+ii1], u[ijk+ii2]))*dxi
+                          + fabs(interp4c(v[ijk-jj1], v[ijk], v[ijk+jj1], v[ijk+jj2]))*dyi
+                          + fabs(interp4c(w[ijk-kk1], w[ijk], w[ijk+kk1], w[ijk+kk2]))*dzi[k];
+        }
+    };
+}
+#endif
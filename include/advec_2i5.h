@@ -23,6 +23,7 @@
 #ifndef ADVEC_2i5_H
 #define ADVEC_2i5_H
 
+#include <map>
 #include "advec.h"
 
 class Master;
@@ -45,10 +46,15 @@ class Advec_2i5 : public Advec<TF>
         void exec(Stats<TF>&); ///< Execute the advection scheme.
         unsigned long get_time_limit(long unsigned int, double); ///< Get the limit on the time step imposed by the advection scheme.
         double get_cfl(double); ///< Get the CFL number.
+        #ifndef USECUDA
+        double get_cfl_local(double); ///< Get the CFL number of this process, without the reduction.
+        #endif
 
         void get_advec_flux(Field3d<TF>&, const Field3d<TF>&);
         Advection_type get_switch() const { return Advection_type::Advec_2i5; }
 
+        bool set_settling_velocity(const std::string&, const TF);
+
     private:
         using Advec<TF>::master;
         using Advec<TF>::grid;
@@ -57,6 +63,7 @@ class Advec_2i5 : public Advec<TF>
 
         using Advec<TF>::cflmax;
         using Advec<TF>::cflmin;
+        using Advec<TF>::is_split;
 
         const std::string tend_name = "advec";
         const std::string tend_longname = "Advection";
@@ -64,5 +71,23 @@ class Advec_2i5 : public Advec<TF>
         std::vector<std::string> fluxlimit_list;
         std::vector<std::string> sp_limit;
         std::vector<std::string> sp_no_limit;
+
+        // CPU kernels of each scalar, with or without flux limiter, selected once in create().
+        using Advec_s_kernel = void (*)(
+                TF*, const TF*, const TF*, const TF*, const TF*, const TF, const TF*, const TF, const TF,
+                const TF*, const TF*, const int, const int, const int, const int, const int, const int,
+                const int, const int);
+        using Advec_flux_s_kernel = void (*)(
+                TF*, const TF*, const TF*, const int, const int, const int, const int, const int, const int,
+                const int, const int);
+
+        struct Scalar_kernels
+        {
+            Advec_s_kernel advec;
+            Advec_flux_s_kernel flux;
+        };
+        std::map<std::string, Scalar_kernels> scalar_kernels;
+
+        std::map<std::string, TF> w_settle; ///< Settling velocities that are added to w of a scalar.
 };
 #endif
@@ -339,6 +339,102 @@ namespace Advec_2i5_kernels
     };
 
 
+    // Update the tendency of one scalar with the velocities and reference densities
+    // around the grid point already loaded, such that kernels that advect several
+    // scalars in one pass load those only once.
+    template<typename TF, typename Level>
+    CUDA_DEVICE
+    void advec_s_point(
+            TF* __restrict__ st, const TF* __restrict__ s, const int ijk, const Level level,
+            const int ii, const int jj, const int kk,
+            const TF u0, const TF u1, const TF v0, const TF v1, const TF w0, const TF w1,
+            const TF rhoh0, const TF rhoh1, const TF rhoi, const TF dzik,
+            const TF dxi, const TF dyi)
+    {
+        const int ii1 = 1*ii;
+        const int ii2 = 2*ii;
+        const int ii3 = 3*ii;
+        const int jj1 = 1*jj;
+        const int jj2 = 2*jj;
+        const int jj3 = 3*jj;
+        const int kk1 = 1*kk;
+        const int kk2 = 2*kk;
+        const int kk3 = 3*kk;
+
+        st[ijk] +=
+                - ( u1 * interp6_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
+                    - u0 * interp6_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
+
+                + ( fabs(u1) * interp5_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
+                    - fabs(u0) * interp5_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
+
+                - ( v1 * interp6_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
+                    - v0 * interp6_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi
+
+                + ( fabs(v1) * interp5_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
+                    - fabs(v0) * interp5_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi;
+
+        if (level.distance_to_start() == 0)
+        {
+            st[ijk] +=
+                    // w*ds/dz -> second order interpolation for fluxtop, fluxbot=0 as w=0
+                    - ( rhoh1 * w1 * interp2(s[ijk    ], s[ijk+kk1])) * rhoi * dzik;
+        }
+        else if (level.distance_to_start() == 1)
+        {
+            st[ijk] +=
+                    // w*ds/dz -> second order interpolation for fluxbot, fourth order for fluxtop
+                    - ( rhoh1 * w1 * interp4_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                        - rhoh0 * w0 * interp2(s[ijk-kk1], s[ijk    ]) ) * rhoi * dzik
+
+                    + ( rhoh1 * fabs(w1) * interp3_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])) * rhoi * dzik;
+        }
+        else if (level.distance_to_start() == 2)
+        {
+            st[ijk] +=
+                    // w*ds/dz -> fourth order interpolation for fluxbot, sixth for fluxtop
+                    - ( rhoh1 * w1 * interp6_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
+                        - rhoh0 * w0 * interp4_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) * rhoi * dzik
+
+                    + ( rhoh1 * fabs(w1) * interp5_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
+                        - rhoh0 * fabs(w0) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) * rhoi * dzik;
+        }
+        else if (level.distance_to_end() == 2)
+        {
+            st[ijk] +=
+                    // w*ds/dz -> fourth order interpolation for fluxtop, sixth order for fluxbot
+                    - ( rhoh1 * w1 * interp4_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                        - rhoh0 * w0 * interp6_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) * rhoi * dzik
+
+                    + ( rhoh1 * fabs(w1) * interp3_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                        - rhoh0 * fabs(w0) * interp5_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) * rhoi * dzik;
+        }
+        else if (level.distance_to_end() == 1)
+        {
+            st[ijk] +=
+                    // w*ds/dz -> second order interpolation for fluxtop, fourth order for fluxbot
+                    - ( rhoh1 * w1 * interp2(s[ijk    ], s[ijk+kk1])
+                        - rhoh0 * w0 * interp4_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) * rhoi * dzik
+
+                    + ( -rhoh0 * fabs(w0) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) * rhoi * dzik;
+        }
+        else if (level.distance_to_end() == 0)
+        {
+            st[ijk] +=
+                    // w*ds/dz -> second order interpolation for fluxbot, fluxtop=0 as w=0
+                    - (- rhoh0 * w0 * interp2(s[ijk-kk1], s[ijk    ]) ) * rhoi * dzik;
+        }
+        else
+        {
+            st[ijk] +=
+                    - ( rhoh1 * w1 * interp6_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
+                        - rhoh0 * w0 * interp6_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) * rhoi * dzik
+
+                    + ( rhoh1 * fabs(w1) * interp5_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
+                        - rhoh0 * fabs(w0) * interp5_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) * rhoi * dzik;
+        }
+    }
+
     template<typename TF>
     struct advec_s_g
     {
@@ -356,90 +452,61 @@ namespace Advec_2i5_kernels
             const int jj = g.jstride;
             const int kk = g.kstride;
 
-            const int ii1 = 1;
-            const int ii2 = 2;
-            const int ii3 = 3;
-            const int jj1 = 1*jj;
-            const int jj2 = 2*jj;
-            const int jj3 = 3*jj;
-            const int kk1 = 1*kk;
-            const int kk2 = 2*kk;
-            const int kk3 = 3*kk;
-
             const int ijk = i*ii + j*jj + k*kk;
 
-            st[ijk] +=
-                    - ( u[ijk+ii1] * interp6_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
-                        - u[ijk    ] * interp6_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
-
-                    + ( fabs(u[ijk+ii1]) * interp5_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
-                        - fabs(u[ijk    ]) * interp5_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
-
-                    - ( v[ijk+jj1] * interp6_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
-                        - v[ijk    ] * interp6_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi
-
-                    + ( fabs(v[ijk+jj1]) * interp5_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
-                        - fabs(v[ijk    ]) * interp5_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi;
-
-            if (level.distance_to_start() == 0)
-            {
-                st[ijk] +=
-                        // w*ds/dz -> second order interpolation for fluxtop, fluxbot=0 as w=0
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp2(s[ijk    ], s[ijk+kk1])) * rhorefi[k] * dzi[k];
-            }
-            else if (level.distance_to_start() == 1)
-            {
-                st[ijk] +=
-                        // w*ds/dz -> second order interpolation for fluxbot, fourth order for fluxtop
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp4_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                            - rhorefh[k  ] * w[ijk    ] * interp2(s[ijk-kk1], s[ijk    ]) ) * rhorefi[k] * dzi[k]
+            advec_s_point(
+                    st, s, ijk, level, ii, jj, kk,
+                    u[ijk], u[ijk+ii], v[ijk], v[ijk+jj], w[ijk], w[ijk+kk],
+                    rhorefh[k], rhorefh[k+1], rhorefi[k], dzi[k], dxi, dyi);
+        }
+    };
 
-                        + ( rhorefh[k+1] * fabs(w[ijk+kk1]) * interp3_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])) * rhorefi[k] * dzi[k];
-            }
-            else if (level.distance_to_start() == 2)
-            {
-                st[ijk] +=
-                        // w*ds/dz -> fourth order interpolation for fluxbot, sixth for fluxtop
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp6_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
-                            - rhorefh[k  ] * w[ijk    ] * interp4_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) * rhorefi[k] * dzi[k]
+    // Set of scalars of which the tendencies are computed in one kernel.
+    template<typename TF, int N>
+    struct Scalar_batch
+    {
+        TF* st[N];
+        const TF* s[N];
+    };
 
-                        + ( rhorefh[k+1] * fabs(w[ijk+kk1]) * interp5_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
-                            - rhorefh[k  ] * fabs(w[ijk    ]) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) * rhorefi[k] * dzi[k];
-            }
-            else if (level.distance_to_end() == 2)
-            {
-                st[ijk] +=
-                        // w*ds/dz -> fourth order interpolation for fluxtop, sixth order for fluxbot
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp4_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                            - rhorefh[k  ] * w[ijk    ] * interp6_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) * rhorefi[k] * dzi[k]
+    // Advection of a batch of N scalars, which shares the loads of the velocities,
+    // reference densities and grid spacing between the scalars.
+    template<typename TF, int N>
+    struct advec_s_batch_g
+    {
+        DEFINE_GRID_KERNEL("advec_2i5::advec_s_batch", 3)
 
-                        + ( rhorefh[k+1] * fabs(w[ijk+kk1]) * interp3_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                            - rhorefh[k  ] * fabs(w[ijk    ]) * interp5_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) * rhorefi[k] * dzi[k];
-            }
-            else if (level.distance_to_end() == 1)
-            {
-                st[ijk] +=
-                        // w*ds/dz -> second order interpolation for fluxtop, fourth order for fluxbot
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp2(s[ijk    ], s[ijk+kk1])
-                            - rhorefh[k  ] * w[ijk    ] * interp4_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) * rhorefi[k] * dzi[k]
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(Grid_layout g, const int i, const int j, const int k, const Level level,
+                const Scalar_batch<TF, N> batch,
+                const TF* __restrict__ u, const TF* __restrict__ v,  const TF* __restrict__ w,
+                const TF* __restrict__ rhorefi, const TF* __restrict__ rhorefh,
+                const TF* __restrict__ dzi, const TF dxi, const TF dyi)
+        {
+            const int ii = g.istride;
+            const int jj = g.jstride;
+            const int kk = g.kstride;
 
-                        + ( -rhorefh[k  ] * fabs(w[ijk    ]) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) * rhorefi[k] * dzi[k];
-            }
-            else if (level.distance_to_end() == 0)
-            {
-                st[ijk] +=
-                        // w*ds/dz -> second order interpolation for fluxbot, fluxtop=0 as w=0
-                        - (- rhorefh[k  ] * w[ijk    ] * interp2(s[ijk-kk1], s[ijk    ]) ) * rhorefi[k] * dzi[k];
-            }
-            else
-            {
-                st[ijk] +=
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp6_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
-                            - rhorefh[k  ] * w[ijk    ] * interp6_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) * rhorefi[k] * dzi[k]
+            const int ijk = i*ii + j*jj + k*kk;
 
-                        + ( rhorefh[k+1] * fabs(w[ijk+kk1]) * interp5_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
-                            - rhorefh[k  ] * fabs(w[ijk    ]) * interp5_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) * rhorefi[k] * dzi[k];
-            }
+            const TF u0 = u[ijk];
+            const TF u1 = u[ijk+ii];
+            const TF v0 = v[ijk];
+            const TF v1 = v[ijk+jj];
+            const TF w0 = w[ijk];
+            const TF w1 = w[ijk+kk];
+
+            const TF rhoh0 = rhorefh[k];
+            const TF rhoh1 = rhorefh[k+1];
+            const TF rhoi = rhorefi[k];
+            const TF dzik = dzi[k];
+
+            #pragma unroll
+            for (int n=0; n<N; ++n)
+                advec_s_point(
+                        batch.st[n], batch.s[n], ijk, level, ii, jj, kk,
+                        u0, u1, v0, v1, w0, w1, rhoh0, rhoh1, rhoi, dzik, dxi, dyi);
         }
     };
 
@@ -45,6 +45,9 @@ class Advec_2i62 : public Advec<TF>
         void exec(Stats<TF>&); ///< Execute the advection scheme.
         unsigned long get_time_limit(long unsigned int, double); ///< Get the limit on the time step imposed by the advection scheme.
         double get_cfl(double); ///< Get the CFL number.
+        #ifndef USECUDA
+        double get_cfl_local(double); ///< Get the CFL number of this process, without the reduction.
+        #endif
 
         void get_advec_flux(Field3d<TF>&, const Field3d<TF>&);
         Advection_type get_switch() const { return Advection_type::Advec_2i62; }
@@ -41,6 +41,7 @@ class Advec_disabled : public Advec<TF>
         void exec(Stats<TF>&); ///< Execute the advection scheme.
         unsigned long get_time_limit(unsigned long, double); ///< Get the maximum time step imposed by advection scheme
         double get_cfl(double); ///< Retrieve the CFL number.
+        unsigned long get_time_limit_from_cfl(unsigned long, double);
 
         void get_advec_flux(Field3d<TF>&, const Field3d<TF>&);
         Advection_type get_switch() const { return Advection_type::Disabled; }
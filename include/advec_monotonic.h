@@ -23,81 +23,59 @@
 #define ADVEC_MONOTONIC_H
 
 #include <cmath>
+#include <limits>
+#include <algorithm>
 
 namespace Advec_monotonic
 {
-    // Implementation flux limiter according to Koren, 1993.
+    // Limited upwind interpolation of Koren, 1993, given the upwind (s_up), the
+    // far upwind (s_upup) and the downwind (s_down) value. The limiters below pick
+    // their stencil with selects instead of branches, such that the i-loops of
+    // advec_s_lim vectorize.
     template<typename TF>
-    inline TF flux_lim(const TF u, const TF sm2, const TF sm1, const TF sp1, const TF sp2)
+    inline TF koren(const TF s_upup, const TF s_up, const TF s_down)
     {
         const TF eps = std::numeric_limits<TF>::epsilon();
 
-        if (u >= TF(0.))
-        {
-            const TF denom = copysign(1, sm1-sm2) * std::max(std::abs(sm1-sm2), eps);
-            const TF two_r = TF(2.) * (sp1-sm1) / denom;
-            const TF phi = std::max(
-                    TF(0.),
-                    std::min( two_r, std::min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
-            return u*(sm1 + TF(0.5)*phi*(sm1 - sm2));
-        }
-        else
-        {
-            const TF denom = copysign(1, sp1-sp2) * std::max(std::abs(sp1-sp2), eps);
-            const TF two_r = TF(2.) * (sm1-sp1) / denom;
-            const TF phi = std::max(
-                    TF(0.),
-                    std::min( two_r, std::min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
-            return u*(sp1 + TF(0.5)*phi*(sp1 - sp2));
-        }
+        const TF denom = std::copysign(TF(1.), s_up-s_upup) * std::max(std::abs(s_up-s_upup), eps);
+        const TF two_r = TF(2.) * (s_down-s_up) / denom;
+        const TF phi = std::max(
+                TF(0.),
+                std::min( two_r, std::min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
+        return s_up + TF(0.5)*phi*(s_up - s_upup);
     }
 
     // Implementation flux limiter according to Koren, 1993.
     template<typename TF>
-    inline TF flux_lim_bot(const TF u, const TF sm2, const TF sm1, const TF sp1, const TF sp2)
+    inline TF flux_lim(const TF u, const TF sm2, const TF sm1, const TF sp1, const TF sp2)
     {
-        const TF eps = std::numeric_limits<TF>::epsilon();
+        const bool pos = (u >= TF(0.));
+        return u*koren(pos ? sm2 : sp2, pos ? sm1 : sp1, pos ? sp1 : sm1);
+    }
 
-        if (u >= TF(0.))
-        {
-            return u*sm1;
-        }
-        else
-        {
-            const TF denom = copysign(1, sp1-sp2) * std::max(std::abs(sp1-sp2), eps);
-            const TF two_r = TF(2.) * (sm1-sp1) / denom;
-            const TF phi = std::max(
-                    TF(0.),
-                    std::min( two_r, std::min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
-            return u*(sp1 + TF(0.5)*phi*(sp1 - sp2));
-        }
+    // Implementation flux limiter according to Koren, 1993.
+    template<typename TF>
+    inline TF flux_lim_bot(const TF u, const TF sm2, const TF sm1, const TF sp1, const TF sp2)
+    {
+        // First order upwind if the flow comes from the wall side.
+        const TF s_lim = koren(sp2, sp1, sm1);
+        return u*((u >= TF(0.)) ? sm1 : s_lim);
     }
 
     // Implementation flux limiter according to Koren, 1993.
     template<typename TF>
     inline TF flux_lim_top(const TF u, const TF sm2, const TF sm1, const TF sp1, const TF sp2)
     {
-        const TF eps = std::numeric_limits<TF>::epsilon();
-
-        if (u >= TF(0.))
-        {
-            const TF denom = copysign(1, sm1-sm2) * std::max(std::abs(sm1-sm2), eps);
-            const TF two_r = TF(2.) * (sp1-sm1) / denom;
-            const TF phi = std::max(
-                    TF(0.),
-                    std::min( two_r, std::min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
-            return u*(sm1 + TF(0.5)*phi*(sm1 - sm2));
-        }
-        else
-        {
-            return u*sp1;
-        }
+        // First order upwind if the flow comes from the wall side.
+        const TF s_lim = koren(sm2, sm1, sp1);
+        return u*((u >= TF(0.)) ? s_lim : sp1);
     }
 
     template<typename TF>
     void advec_s_lim(
             TF* const restrict st, const TF* const restrict s,
             const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
+            const TF w_settle,
             const TF* const restrict dzi, const TF dx, const TF dy,
             const TF* const restrict rhoref, const TF* const restrict rhorefh,
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
@@ -126,8 +104,8 @@ namespace Advec_monotonic
                              - ( flux_lim(v[ijk+jj1], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2])
                                - flux_lim(v[ijk    ], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
 
-                             - ( rhorefh[k+1] * flux_lim(w[ijk+kk1], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                               - rhorefh[k  ] * flux_lim(w[ijk    ], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+                             - ( rhorefh[k+1] * flux_lim(w[ijk+kk1]+w_settle, s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                               - rhorefh[k  ] * flux_lim(w[ijk    ]+w_settle, s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
                 }
 
         int k = kstart;
@@ -144,7 +122,7 @@ namespace Advec_monotonic
                            - flux_lim(v[ijk    ], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
 
                          // No flux through bottom wall.
-                         - ( rhorefh[k+1] * flux_lim_bot(w[ijk+kk1], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])) / rhoref[k] * dzi[k];
+                         - ( rhorefh[k+1] * flux_lim_bot(w[ijk+kk1]+w_settle, s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])) / rhoref[k] * dzi[k];
             }
 
         k = kstart+1;
@@ -160,8 +138,8 @@ namespace Advec_monotonic
                          - ( flux_lim(v[ijk+jj1], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2])
                            - flux_lim(v[ijk    ], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
 
-                         - ( rhorefh[k+1] * flux_lim    (w[ijk+kk1], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                           - rhorefh[k  ] * flux_lim_bot(w[ijk    ], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+                         - ( rhorefh[k+1] * flux_lim    (w[ijk+kk1]+w_settle, s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                           - rhorefh[k  ] * flux_lim_bot(w[ijk    ]+w_settle, s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
             }
 
         k = kend-2;
@@ -178,8 +156,8 @@ namespace Advec_monotonic
                            - flux_lim(v[ijk    ], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
 
                          // No flux through bottom wall.
-                         - ( rhorefh[k+1] * flux_lim_top(w[ijk+kk1], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                           - rhorefh[k  ] * flux_lim    (w[ijk    ], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+                         - ( rhorefh[k+1] * flux_lim_top(w[ijk+kk1]+w_settle, s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                           - rhorefh[k  ] * flux_lim    (w[ijk    ]+w_settle, s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
             }
 
         k = kend-1;
@@ -196,7 +174,7 @@ namespace Advec_monotonic
                            - flux_lim(v[ijk    ], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi
 
                          - ( // No flux through boundary
-                           - rhorefh[k  ] * flux_lim_top(w[ijk    ], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+                           - rhorefh[k  ] * flux_lim_top(w[ijk    ]+w_settle, s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
             }
     }
 
@@ -0,0 +1,91 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ADVEC_SPLIT_H
+#define ADVEC_SPLIT_H
+
+#include <string>
+#include <vector>
+
+#include "boundary_cyclic.h"
+
+class Master;
+class Input;
+template<typename> class Grid;
+template<typename> class Fields;
+template<typename> class Advec;
+template<typename> class Timeloop;
+
+/**
+ * Time split advection of passive scalars.
+ * The scalars in `splitlist` of [advec] are left out of the Eulerian advection of every substep,
+ * and are instead advected once per `splitsteps` time steps, over the whole interval. The displacement
+ * through every face is integrated over the interval with the trapezoidal rule of the velocities at the
+ * start and end of each time step. The scalars are transported with a directionally split flux form
+ * scheme with monotonized central slopes, that runs in as many substeps as needed to keep the Courant
+ * number below `splitcflmax`. A pseudo density is transported with the same fluxes (Easter, 1993), such
+ * that a uniform scalar stays uniform. Diffusion, sources and decay stay in the regular time steps.
+ * Reads the following parameters from (case).ini file
+ *
+ * [advec]
+ * splitlist   ; scalars that are advected over the interval
+ * splitsteps  ; number of time steps of the interval
+ * splitcflmax ; maximum Courant number of the substeps of the interval, default 0.5
+ */
+
+template<typename TF>
+class Advec_split
+{
+    public:
+        Advec_split(Master&, Grid<TF>&, Fields<TF>&, Advec<TF>&, Input&);
+        ~Advec_split();
+
+        void init();
+        void create(Timeloop<TF>&);
+
+        bool get_switch() const { return !split_list.empty(); }
+
+        void begin_step(Timeloop<TF>&); ///< Add the velocities at the start of the time step.
+        void exec(Timeloop<TF>&);       ///< Add the velocities at the end of the time step, and advect at the end of the interval.
+
+    private:
+        Master& master;
+        Grid<TF>& grid;
+        Fields<TF>& fields;
+        Boundary_cyclic<TF> boundary_cyclic;
+
+        std::vector<std::string> split_list;
+        int splitsteps;
+        TF splitcflmax;
+
+        int nsteps; ///< Number of time steps in the current interval.
+
+        // Displacements (m) through the west, south and bottom faces of the cells over the interval.
+        std::vector<TF> xdisp;
+        std::vector<TF> ydisp;
+        std::vector<TF> zdisp;
+
+        void add_velocities(double);
+        void advect();
+};
+#endif
@@ -79,45 +79,18 @@ class Aerosol
         bool sw_aerosol;
         bool sw_timedep;
 
-        // Arrays
-        // to fill with input values
-        std::vector<TF> aermr01;
-        std::vector<TF> aermr02;
-        std::vector<TF> aermr03;
-        std::vector<TF> aermr04;
-        std::vector<TF> aermr05;
-        std::vector<TF> aermr06;
-        std::vector<TF> aermr07;
-        std::vector<TF> aermr08;
-        std::vector<TF> aermr09;
-        std::vector<TF> aermr10;
-        std::vector<TF> aermr11;
-
-        std::unique_ptr<Timedep<TF>> tdep_aermr01;
-        std::unique_ptr<Timedep<TF>> tdep_aermr02;
-        std::unique_ptr<Timedep<TF>> tdep_aermr03;
-        std::unique_ptr<Timedep<TF>> tdep_aermr04;
-        std::unique_ptr<Timedep<TF>> tdep_aermr05;
-        std::unique_ptr<Timedep<TF>> tdep_aermr06;
-        std::unique_ptr<Timedep<TF>> tdep_aermr07;
-        std::unique_ptr<Timedep<TF>> tdep_aermr08;
-        std::unique_ptr<Timedep<TF>> tdep_aermr09;
-        std::unique_ptr<Timedep<TF>> tdep_aermr10;
-        std::unique_ptr<Timedep<TF>> tdep_aermr11;
+        // Mass mixing ratios of the aerosol species, ordered as [species][kcells].
+        const std::vector<std::string> species = {
+                "aermr01", "aermr02", "aermr03", "aermr04", "aermr05", "aermr06",
+                "aermr07", "aermr08", "aermr09", "aermr10", "aermr11"};
+        std::vector<TF> aermr;
+
+        // All species share a single time dependent input block and interpolation.
+        std::unique_ptr<Timedep<TF>> tdep_aermr;
 
         #ifdef USECUDA
         // GPU functions and variables
-        TF* aermr01_g;  ///< Pointer to GPU array.
-        TF* aermr02_g;
-        TF* aermr03_g;
-        TF* aermr04_g;
-        TF* aermr05_g;
-        TF* aermr06_g;
-        TF* aermr07_g;
-        TF* aermr08_g;
-        TF* aermr09_g;
-        TF* aermr10_g;
-        TF* aermr11_g;
+        TF* aermr_g;  ///< Pointer to GPU array.
         #endif
 
 };
@@ -67,6 +67,22 @@ struct Field3dBc
     Boundary_type bctop; ///< Switch for the top boundary.
 };
 
+/**
+ * Pointers to a prognostic field and its boundary fields with its boundary types, as the entry
+ * of the table from which the bottom and top ghost cells of all fields are set at once.
+ */
+template<typename TF>
+struct Ghost_cell_bc
+{
+    TF* fld;
+    TF* fld_bot;
+    TF* grad_bot;
+    TF* fld_top;
+    TF* grad_top;
+    Boundary_type bcbot;
+    Boundary_type bctop;
+};
+
 /**
  * Base class for the boundary scheme.
  * This class handles the case when the boundary is turned off. Derived classes are
@@ -96,6 +112,11 @@ class Boundary
         virtual void set_ghost_cells_w(Boundary_w_type); ///< Update the boundary conditions.
 
         void set_prognostic_cyclic_bcs();
+
+        // Split-phase version of set_prognostic_cyclic_bcs, the interior of the prognostic fields
+        // may be read, but not written, between both calls.
+        void begin_prognostic_cyclic_bcs();
+        void finish_prognostic_cyclic_bcs();
         void set_prognostic_outflow_bcs();
 
         virtual void exec(Thermo<TF>&, Radiation<TF>&, Microphys<TF>&, Timeloop<TF>&);
@@ -105,6 +126,7 @@ class Boundary
 
         virtual void load(const int, Thermo<TF>&) {};
         virtual void save(const int, Thermo<TF>&) {};
+        virtual void get_checkpoint_data(std::vector<std::vector<TF>*>&) {}; ///< Add the 2D state that is saved in the restarts.
 
         // Get functions for various 2D fields
         virtual const std::vector<TF>& get_z0m() const;
@@ -148,6 +170,20 @@ class Boundary
         typedef std::map<std::string, Field3dBc<TF>> BcMap;
         BcMap sbc;
 
+        // Handles of the momentum fields and the scalar bcs in the order of the scalar handles of
+        // Fields, resolved once in process_bcs(), such that the ghost cells need no map lookups.
+        int u_handle;
+        int v_handle;
+        int w_handle;
+        std::vector<Field3dBc<TF>*> sbc_list;
+
+        // Table of u, v and the scalars for the batched ghost cells, with the
+        // host pointers and, on the GPU, a device copy with the device pointers.
+        std::vector<Ghost_cell_bc<TF>> ghost_cell_bcs;
+        #ifdef USECUDA
+        cuda_vector<Ghost_cell_bc<TF>> ghost_cell_bcs_g;
+        #endif
+
         std::map<std::string, Timedep<TF>*> tdep_bc;
 
         // Spatial sbot input:
@@ -168,9 +204,20 @@ class Boundary
         unsigned long itime_sbot_2d_prev;
         unsigned long itime_sbot_2d_next;
 
+        // The time level after next is read while the current interval is integrated, into a buffer
+        // that is unpacked into sbot_2d_next when the time loop passes itime_sbot_2d_next.
+        std::map<std::string, std::vector<TF>> sbot_2d_buffer;
+        std::map<std::string, Field3d_io_request> sbot_2d_request;
+        std::map<std::string, bool> sbot_2d_started; ///< The read of the buffer is in flight.
+        int iotime_sbot_2d_prefetch;
+
+        void start_sbot_2d_prefetch(unsigned long, unsigned long); ///< Starts the read of the sbot fields at a time.
+        int finish_sbot_2d_prefetch(); ///< Moves next to prev and completes the read into next, returns the errors.
+
         void process_bcs(Input&); ///< Process the boundary condition settings from the ini file.
+        std::vector<Ghost_cell_bc<TF>> get_ghost_cell_bcs(bool); ///< Table of the ghost cell bcs, with host or device pointers.
         void process_time_dependent(Input&, Netcdf_handle&, Timeloop<TF>&); ///< Process the time dependent settings from the ini file.
-        void process_inflow(Input&, Netcdf_handle&); ///< Process the time dependent settings from the ini file.
+        void process_inflow(Input&, Netcdf_handle&, Timeloop<TF>&); ///< Process the time dependent settings from the ini file.
 
         #ifdef USECUDA
         std::map<std::string, TF*> inflow_profiles_g;
@@ -27,6 +27,12 @@
 #include <mpi.h>
 #endif
 
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "cuda_buffer.h"
+
 class Master;
 template<typename> class Grid;
 
@@ -43,10 +49,17 @@ class Boundary_cyclic
         void exec(TF* const restrict, Edge=Edge::Both_edges); // Fills the ghost cells in the periodic directions.
         void exec_2d(TF* const restrict); // Fills the ghost cells of one slice in the periodic direction.
 
+        // Split-phase exchange: begin_exchange posts the halo exchange of a field and returns, such that
+        // work on the interior can overlap the communication, finish_exchange completes all pending fields.
+        // Only the innermost ihalo and jhalo ghost cells are exchanged, by default all of them.
+        void begin_exchange(TF*, int ihalo=-1, int jhalo=-1);
+        void finish_exchange();
+        void set_batch(const bool); // Packs all pending fields into one buffer per neighbour in finish_exchange.
+
         void exec(unsigned int* const restrict, Edge=Edge::Both_edges); // Fills the ghost cells in the periodic directions.
         void exec_2d(unsigned int* const restrict); // Fills the ghost cells of one slice in the periodic direction.
 
-        void exec_g(TF*);   // Fills the ghost cells in the periodic directions.
+        void exec_g(TF*, int ihalo=-1, int jhalo=-1); // Fills the innermost ghost cells in the periodic directions.
         void exec_2d_g(TF*); // Fills the ghost cells of one slice in the periodic directions.
 
     private:
@@ -56,6 +69,7 @@ class Boundary_cyclic
         void init_mpi();
         void exit_mpi();
         bool mpi_types_allocated;
+        bool sw_batch;
 
         #ifdef USEMPI
         MPI_Datatype eastwestedge;     ///< MPI datatype containing the ghostcells at the east-west sides.
@@ -66,6 +80,37 @@ class Boundary_cyclic
         MPI_Datatype northsouthedge_uint;   ///< MPI datatype containing the ghostcells at the north-south sides.
         MPI_Datatype eastwestedge2d_uint;   ///< MPI datatype containing the ghostcells for one slice at the east-west sides.
         MPI_Datatype northsouthedge2d_uint; ///< MPI datatype containing the ghostcells for one slice at the north-south sides.
+
+        std::vector<TF*> pending_fields;         ///< Fields with a posted, but not yet completed, exchange.
+        std::vector<std::pair<int, int>> pending_halos; ///< Halo widths in x and y of the pending fields.
+        std::vector<MPI_Request> pending_reqs;   ///< Requests of the posted exchanges.
+
+        // Datatypes of the edges of the given width, for halos that are narrower than the ghost cells.
+        std::map<int, MPI_Datatype> eastwest_halo_types;
+        std::map<int, MPI_Datatype> northsouth_halo_types;
+        MPI_Datatype get_eastwest_type(int);
+        MPI_Datatype get_northsouth_type(int);
+
+        void exchange_batch(
+                const std::vector<TF*>&,
+                const int, const int, const int, const int, const int,
+                const int, const int, const int, const int, const int,
+                const int, const int);
+
+        std::vector<TF> send_buffer_1; ///< Contiguous buffers for the batched ghost cells of all pending fields.
+        std::vector<TF> send_buffer_2;
+        std::vector<TF> recv_buffer_1;
+        std::vector<TF> recv_buffer_2;
+
+        #ifdef USECUDA
+        void exec_mpi_g(TF*, const int, const int, const int); // Exchanges the ghost cells from device buffers.
+
+        // Contiguous device buffers for the packed ghost cells, allocated at first use.
+        cuda_vector<TF> send_buffer_1_g;
+        cuda_vector<TF> send_buffer_2_g;
+        cuda_vector<TF> recv_buffer_1_g;
+        cuda_vector<TF> recv_buffer_2_g;
+        #endif
         #endif
 };
 #endif
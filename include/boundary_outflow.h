@@ -23,16 +23,38 @@
 #ifndef BOUNDARY_OUTFLOW_H
 #define BOUNDARY_OUTFLOW_H
 
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
 #ifdef USEMPI
 #include <mpi.h>
 #endif
 
 class Master;
+class Input;
 template<typename> class Grid;
+template<typename> class Timeloop;
 
 enum class Edge_location {West, East, South, North};
 enum class Flow_direction {Inflow, Outflow};
 
+/**
+ * Inflow and outflow conditions for the scalars at the lateral edges.
+ * At inflow edges the ghost cells are set from an inflow profile, or with swtimedep_lbc from
+ * time varying boundary slabs of (ktot, jtot) values at the west and east and (ktot, itot) at
+ * the south and north edges. The slabs are read every lbc_loadtime from the binary files
+ * (scalar)_lbc_(edge).(iotime), of which each process at an inflow edge only reads its own
+ * part. The time level after the next one is read in the background, and the slabs are
+ * interpolated in time on the device in GPU runs.
+ * Reads the following parameters from (case).ini file
+ *
+ * [boundary]
+ * flow_direction[edge] ; inflow or outflow per edge
+ * swtimedep_lbc        ; enable the time varying boundary slabs
+ * lbc_loadtime         ; time between the boundary slabs (s)
+ */
 template<typename TF>
 class Boundary_outflow
 {
@@ -40,7 +62,15 @@ class Boundary_outflow
         Boundary_outflow(Master&, Grid<TF>&, Input&); // Constuctor of the boundary class.
         ~Boundary_outflow();                          // Destructor of the boundary class.
 
-        void exec(TF* const restrict, const TF* const restrict);
+        void create(const std::vector<std::string>&, Timeloop<TF>&); ///< Load the first boundary slabs.
+        void update_time_dependent(Timeloop<TF>&);                     ///< Interpolate the boundary slabs in time.
+
+        void exec(TF* const restrict, const TF* const restrict, const std::string& name="");
+
+        #ifdef USECUDA
+        void prepare_device();
+        void clear_device();
+        #endif
 
     private:
         Master& master; // Reference to master class.
@@ -48,5 +78,44 @@ class Boundary_outflow
 
         // Switch between in/outflow:
         std::map<Edge_location, Flow_direction> flow_direction;
+
+        // Inflow values with strides in the vertical and along the edge, which are zero along
+        // the edge for a profile.
+        struct Inflow_values
+        {
+            const TF* data;
+            int kk;
+            int ii;
+        };
+
+        // Boundary slabs of (kcells, cells along the edge) values, including the ghost cells.
+        struct Lbc_slab
+        {
+            std::vector<TF> prev;
+            std::vector<TF> next;
+            std::vector<TF> now;
+            std::vector<TF> prefetched;
+            std::future<int> prefetch; ///< Reads `prefetched`, returns the number of errors.
+
+            #ifdef USECUDA
+            TF* prev_g;
+            TF* next_g;
+            TF* now_g;
+            #endif
+        };
+
+        bool swtimedep_lbc;
+        unsigned long iloadtime_lbc;
+        unsigned long itime_lbc_prev;
+        unsigned long itime_lbc_next;
+        unsigned long iiotimeprec;
+        std::map<std::string, std::map<Edge_location, Lbc_slab>> lbc_slabs;
+
+        bool is_local_edge(Edge_location) const;
+        int get_edge_cells(Edge_location) const;
+        int load_slab(std::vector<TF>&, const std::string&, Edge_location, unsigned long) const;
+        void start_prefetch(Lbc_slab&, const std::string&, Edge_location, unsigned long);
+        bool advance_slabs(unsigned long); ///< Move to the next time levels, returns whether the slabs changed.
+        Inflow_values get_inflow(const std::string&, Edge_location, const TF* const);
 };
 #endif
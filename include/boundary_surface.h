@@ -24,6 +24,7 @@
 #define BOUNDARY_SURFACE_H
 
 #include "boundary.h"
+#include "node_shared_vector.h"
 #include "stats.h"
 
 template<typename> class Diff;
@@ -52,6 +53,7 @@ class Boundary_surface : public Boundary<TF>
 
         void load(const int, Thermo<TF>&);
         void save(const int, Thermo<TF>&);
+        void get_checkpoint_data(std::vector<std::vector<TF>*>&);
 
         #ifdef USECUDA
         // GPU functions and variables
@@ -92,8 +94,9 @@ class Boundary_surface : public Boundary<TF>
 
         TF ustarin;
 
-        std::vector<float> zL_sl;
-        std::vector<float> f_sl;
+        // The lookup table is equal on all processes, such that it is stored once per node.
+        Node_shared_vector<float> zL_sl;
+        Node_shared_vector<float> f_sl;
         std::vector<int> nobuk;
 
         std::vector<TF> z0m;
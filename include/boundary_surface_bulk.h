@@ -52,6 +52,7 @@ class Boundary_surface_bulk : public Boundary<TF>
 
         void load(const int, Thermo<TF>&);
         void save(const int, Thermo<TF>&);
+        void get_checkpoint_data(std::vector<std::vector<TF>*>&);
 
         #ifdef USECUDA
         // GPU functions and variables
@@ -204,6 +204,7 @@ namespace Boundary_surface_kernels
         const int ii=1;
         const int jj=icells;
 
+        #pragma omp parallel for
         for (int j=jstart; j<jend; ++j)
             #pragma ivdep
             for (int i=istart; i<iend; ++i)
@@ -233,6 +234,7 @@ namespace Boundary_surface_kernels
             const int jstart, const int jend,
             const int icells)
     {
+        #pragma omp parallel for
         for (int j=jstart; j<jend; ++j)
             #pragma ivdep
             for (int i=istart; i<iend; ++i)
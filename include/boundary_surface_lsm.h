@@ -24,6 +24,7 @@
 #define BOUNDARY_SURFACE_LSM_H
 
 #include "boundary.h"
+#include "node_shared_vector.h"
 #include "stats.h"
 #include "field3d_operators.h"
 
@@ -104,6 +105,7 @@ class Boundary_surface_lsm : public Boundary<TF>
 
         void load(const int, Thermo<TF>&);
         void save(const int, Thermo<TF>&);
+        void get_checkpoint_data(std::vector<std::vector<TF>*>&);
 
         #ifdef USECUDA
         // GPU functions and variables
@@ -146,6 +148,8 @@ class Boundary_surface_lsm : public Boundary<TF>
         using Boundary<TF>::sbc;
 
         void get_tiled_mean(std::vector<TF>&, std::string, TF);
+        void get_tiled_mean_stats(std::vector<TF>&, const std::string&);
+        void exec_soil(TF* const, TF* const);
 
         bool sw_constant_z0;
         bool sw_homogeneous;
@@ -160,8 +164,9 @@ class Boundary_surface_lsm : public Boundary<TF>
         std::vector<std::string> tile_names {"veg", "soil" ,"wet"};
         Tile_map<TF> tiles;
 
-        std::vector<float> zL_sl;
-        std::vector<float> f_sl;
+        // The lookup table is equal on all processes, such that it is stored once per node.
+        Node_shared_vector<float> zL_sl;
+        Node_shared_vector<float> f_sl;
         std::vector<int> nobuk;
 
         std::vector<TF> z0m;
@@ -206,6 +211,14 @@ class Boundary_surface_lsm : public Boundary<TF>
         std::vector<TF> source;         // Source term (unit s-1)
         std::vector<TF> root_fraction;  // Root fraction per soil layer (-)
 
+        // Soil tendencies reused in between the soil updates once every dt_soil.
+        double dt_soil;
+        unsigned long idt_soil;
+        unsigned long soil_period_last = 0;
+        bool soil_tend_valid = false;
+        std::vector<TF> soil_t_tend;     // Soil temperature tendency (K s-1)
+        std::vector<TF> soil_theta_tend; // Soil moisture tendency (m3 m-3 s-1)
+
         // Lookup table data obtained from input NetCDF file:
         std::vector<TF> theta_res;  // Residual soil moisture content (m3 m-3)
         std::vector<TF> theta_wp;   // Soil moisture content at wilting point (m3 m-3)
@@ -232,6 +245,10 @@ class Boundary_surface_lsm : public Boundary<TF>
         void print_ij(const TF*);
         void get_tiled_mean_g(TF*, std::string, TF);
 
+        // Tiled means of the fluxes in the statistics and cross-sections, which backward_device()
+        // calculates on the device, such that the tile fields themselves stay there.
+        std::map<std::string, std::vector<TF>> tiled_mean_stats;
+
         // Surface layer:
         float* zL_sl_g;
         float* f_sl_g;
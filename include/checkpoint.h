@@ -0,0 +1,101 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <vector>
+
+class Master;
+class Input;
+template<typename> class Fields;
+template<typename> class Boundary;
+template<typename> class Thermo;
+template<typename> class Timeloop;
+
+/**
+ * Partner checkpoints of the model state, for a fast recovery after the failure of a node.
+ * Every `interval` iterations, each process packs its subdomain of the prognostic fields, the 2D
+ * state of the surface scheme, the updated base state of the thermodynamics and the time into a
+ * buffer, sends a copy to its partner process on the next node and writes both its own buffer and
+ * the copy of the other process to `path`.
+ * With a path in node-local memory (/dev/shm), the checkpoint costs two memory copies and one
+ * message, and survives the loss of a process or a node, as long as a process and its partner do not
+ * fail together. At startup of a run, a checkpoint that is newer than the restart files on disk is
+ * restored, where the processes without their own buffer, e.g. on a replaced node, receive it from
+ * their partner. The checkpoints are only valid for the same case and the same decomposition,
+ * such that `path` has to be unique per run. The restart files are loaded at their own time, before
+ * the state is replaced by the checkpoint. The time dependent input follows from the time of the
+ * checkpoint. The particles are not included, such that they cannot be combined with the checkpoints.
+ * Reads the following parameters from (case).ini file
+ *
+ * [checkpoint]
+ * swcheckpoint ; enable the partner checkpoints
+ * interval     ; interval in iterations
+ * path         ; directory of the checkpoint files, preferably node-local memory
+ */
+template<typename TF>
+class Checkpoint
+{
+    public:
+        Checkpoint(Master&, Fields<TF>&, Input&, const std::string&);
+        ~Checkpoint();
+
+        void load(Timeloop<TF>&);  ///< Find the newest checkpoint and restore the time, before the modules are created.
+        void create(Thermo<TF>&, Boundary<TF>&); ///< Register the state and restore it from the checkpoint, if found by load().
+
+        bool do_checkpoint(int);
+        void exec(Timeloop<TF>&);
+
+    private:
+        Master& master;
+        Fields<TF>& fields;
+        std::string sim_name;
+
+        bool swcheckpoint;
+        int interval;
+        std::string path;
+
+        int partner_send; ///< Process that holds the copy of this process.
+        int partner_recv; ///< Process of which this process holds the copy.
+
+        // Header in front of the state, which identifies the checkpoint.
+        struct Header
+        {
+            unsigned long itime;
+            unsigned long idt;
+            int iteration;
+            int mpiid;
+            long long nbytes;
+        };
+
+        std::vector<std::vector<TF>*> state; ///< Arrays in the packed order.
+        std::vector<char> restored;            ///< Packed state of the checkpoint found by load().
+
+        std::string get_filename(int, bool) const;
+        bool read_file(std::vector<char>&, const std::string&);
+        bool write_file(const std::vector<char>&, const std::string&);
+        void exchange(const std::vector<char>&, std::vector<char>&, int, int);
+};
+#endif
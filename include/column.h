@@ -68,6 +68,7 @@ class Column
         {
             Netcdf_variable<TF> ncvar;
             std::vector<TF> data;
+            std::vector<TF> buffer; ///< Samples that are not written yet, as [time][height].
         };
 
         // Struct for time series.
@@ -75,6 +76,7 @@ class Column
         {
             Netcdf_variable<TF> ncvar;
             TF data;
+            std::vector<TF> buffer;
         };
 
         using Prof_map = std::map<std::string, Prof_var>;
@@ -89,6 +91,8 @@ class Column
             std::unique_ptr<Netcdf_variable<TF>> time_var;
             Prof_map profs;
             Time_map time_series;
+            std::vector<TF> time_buffer;
+            std::vector<int> iter_buffer;
         };
 
         std::vector<Column_struct> columns;
@@ -96,6 +100,20 @@ class Column
         #ifdef USECUDA
         int* col_i_g;
         int* col_j_g;
+
+        // The device profiles and time series of the local columns are gathered into one packed
+        // buffer, with a slot of n_local_columns*kcells values per profile and n_local_columns
+        // values per time series, which is copied to the host once per sample in exec().
+        int n_local_columns;
+        std::vector<Column_struct*> local_columns; ///< Local columns in the order of col_i_g and col_j_g.
+        std::map<std::string, int> prof_slots;
+        std::map<std::string, int> time_slots;
+        std::vector<int> prof_pending; ///< Slots that are gathered but not yet copied to the host.
+        std::vector<int> time_pending;
+        TF* gather_g;
+        std::vector<TF> gather_host;
+        bool gather_host_registered;
+        void fetch_gathered_columns();
         #endif
 
     protected:
@@ -107,7 +125,13 @@ class Column
 
         int statistics_counter;
         double sampletime;
+        double sampleoffset;
         unsigned long isampletime;
+        unsigned long isampleoffset;
+
+        int nbuffer;     ///< Number of samples that are kept in memory before they are written.
+        int nbuffered;   ///< Number of samples in memory.
+        void flush();
 
 };
 #endif
@@ -0,0 +1,170 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CPU_TILING_H
+#define CPU_TILING_H
+
+#include <algorithm>
+
+#include "defines.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// CPU counterpart of cuda_tiling.h. Stencil loops that march in k over a block
+// of j-rows keep the planes of their vertical stencil in cache, where a sweep over
+// full planes evicts them on large subdomains. The block and level loops are collapsed,
+// such that a subdomain with fewer blocks than threads (e.g. a 2D run) still uses all
+// threads, while the static schedule gives each thread a contiguous march in k:
+//
+//     const Cpu_tiling::J_blocks blocks(jstart, jend, Cpu_tiling::calc_jblock<TF>(icells, jmax, 7, 2));
+//     #pragma omp parallel for collapse(2)
+//     for (int b=0; b<blocks.size(); ++b)
+//         for (int k=kstart; k<kend; ++k)
+//             for (int j=blocks.start(b); j<blocks.end(b); ++j)
+//                 #pragma ivdep
+//                 for (int i=istart; i<iend; ++i)
+
+#ifndef CPU_TILING_CACHE_BYTES
+#define CPU_TILING_CACHE_BYTES (512*1024)
+#endif
+
+// Number of columns of the tiles of Column_tiles.
+#ifndef CPU_TILING_NCOLUMN
+#define CPU_TILING_NCOLUMN 64
+#endif
+
+namespace Cpu_tiling
+{
+    // Number of j-rows per block such that n_planes vertical planes of n_fields
+    // fields fit in the cache budget, while every thread still gets a block.
+    template<typename TF>
+    inline int calc_jblock(const int icells, const int jmax, const int n_planes, const int n_fields)
+    {
+        const long bytes_per_row = static_cast<long>(icells) * n_planes * n_fields * sizeof(TF);
+        int jblock = static_cast<int>(std::max(1L, CPU_TILING_CACHE_BYTES / bytes_per_row));
+
+        #ifdef _OPENMP
+        const int nthreads = omp_get_max_threads();
+        jblock = std::min(jblock, (jmax + nthreads - 1) / nthreads);
+        #endif
+
+        return std::max(1, std::min(jblock, jmax));
+    }
+
+    class J_blocks
+    {
+        public:
+            J_blocks(const int jstart, const int jend, const int jblock) :
+                jstart_(jstart), jend_(jend), jblock_(std::max(jblock, 1))
+            {}
+
+            int size() const { return (jend_ - jstart_ + jblock_ - 1) / jblock_; }
+            int start(const int b) const { return jstart_ + b*jblock_; }
+            int end(const int b) const { return std::min(jstart_ + (b+1)*jblock_, jend_); }
+
+        private:
+            const int jstart_;
+            const int jend_;
+            const int jblock_;
+    };
+
+    // Column physics that marches in k within a column strides over full planes in the
+    // i-fastest layout. Column_tiles copies blocks of ncol interior columns, counted
+    // i-fastest over the subdomain, into contiguous tiles of ncol x kcells, in which a
+    // column step is ncol elements. A tile behaves as a 3D field with istart=0, iend=size(b),
+    // jstart=0, jend=1 and jj=kk=ncol, such that the existing kernels run on it unchanged:
+    //
+    //     const Cpu_tiling::Column_tiles<TF> tiles(istart, iend, jstart, jend, icells, ijcells);
+    //     #pragma omp parallel for
+    //     for (int b=0; b<tiles.n_tiles(); ++b)
+    //     {
+    //         tiles.gather(fld_tile, fld, b, kstart-1, kend+1);
+    //         kernel(..., 0, 0, kstart, tiles.size(b), 1, kend, tiles.ncol(), tiles.ncol());
+    //         tiles.scatter_add(fldt, fldt_tile, b, kstart, kend);
+    //     }
+    template<typename TF>
+    class Column_tiles
+    {
+        public:
+            Column_tiles(
+                    const int istart, const int iend, const int jstart, const int jend,
+                    const int icells, const int ijcells, const int ncol=CPU_TILING_NCOLUMN) :
+                istart_(istart), jstart_(jstart), imax_(iend-istart),
+                ncolumns_((iend-istart)*(jend-jstart)),
+                icells_(icells), ijcells_(ijcells), ncol_(std::max(ncol, 1))
+            {}
+
+            int n_tiles() const { return (ncolumns_ + ncol_ - 1) / ncol_; }
+            int ncol() const { return ncol_; }
+            int size(const int b) const { return std::min(ncol_, ncolumns_ - b*ncol_); }
+
+            // Index in the 2D field of column n of tile b.
+            int ij(const int b, const int n) const
+            {
+                const int c = b*ncol_ + n;
+                return istart_ + c%imax_ + (jstart_ + c/imax_)*icells_;
+            }
+
+            // Copy levels [kbegin, kend) of the columns of tile b into the tile.
+            void gather(
+                    TF* const restrict tile, const TF* const restrict fld,
+                    const int b, const int kbegin, const int kend) const
+            {
+                const int n_b = size(b);
+                for (int k=kbegin; k<kend; ++k)
+                    for (int n=0; n<n_b; ++n)
+                        tile[n + k*ncol_] = fld[ij(b, n) + k*ijcells_];
+            }
+
+            // Add levels [kbegin, kend) of the tile to the columns of tile b.
+            void scatter_add(
+                    TF* const restrict fld, const TF* const restrict tile,
+                    const int b, const int kbegin, const int kend) const
+            {
+                const int n_b = size(b);
+                for (int k=kbegin; k<kend; ++k)
+                    for (int n=0; n<n_b; ++n)
+                        fld[ij(b, n) + k*ijcells_] += tile[n + k*ncol_];
+            }
+
+            // Copy the 2D tile of tile b into a 2D field.
+            void scatter_2d(TF* const restrict fld, const TF* const restrict tile, const int b) const
+            {
+                const int n_b = size(b);
+                for (int n=0; n<n_b; ++n)
+                    fld[ij(b, n)] = tile[n];
+            }
+
+        private:
+            const int istart_;
+            const int jstart_;
+            const int imax_;
+            const int ncolumns_;
+            const int icells_;
+            const int ijcells_;
+            const int ncol_;
+    };
+}
+#endif
@@ -23,8 +23,14 @@
 #ifndef CROSS_H
 #define CROSS_H
 
+#include <map>
+#include <memory>
+
 class Master;
 class Input;
+class Io_server;
+class Netcdf_file;
+template<typename> class Netcdf_variable;
 template<typename> class Grid;
 template<typename> class Soil_grid;
 template<typename> class Fields;
@@ -35,7 +41,7 @@ template<typename TF>
 class Cross
 {
     public:
-        Cross(Master&, Grid<TF>&, Soil_grid<TF>&, Fields<TF>&, Input&);
+        Cross(Master&, Grid<TF>&, Soil_grid<TF>&, Fields<TF>&, Io_server&, Input&);
         ~Cross();
 
         void init();
@@ -49,6 +55,11 @@ class Cross
         //int exec(double, unsigned long, int);
 
         bool do_cross(unsigned long);
+        void flush(); ///< Writes the cross-sections that are aggregated under swaggregate.
+
+        /// Local indices, including the ghost cells, of the xy, xz and yz planes that
+        /// cross_simple() reads of a field at the given location on this process.
+        void get_local_planes(std::vector<int>&, std::vector<int>&, std::vector<int>&, const std::array<int,3>&);
 
         int cross_simple(TF*, const TF, const std::string&, const int, const std::array<int,3>&);
         int cross_lngrad(TF*, std::string, int);
@@ -62,13 +73,17 @@ class Cross
         Grid<TF>& grid;
         Soil_grid<TF>& soil_grid;
         Fields<TF>& fields;
+        Io_server& io_server;
         Field3d_io<TF> field3d_io;
 
         bool swcross;
         TF sampletime;
+        double sampleoffset;
         unsigned long isampletime;
+        unsigned long isampleoffset;
 
         std::vector<std::string> crosslist; ///< List with all crosses from the ini file.
+        std::vector<std::string> sparselist; ///< Crosses of which only the non-zero values are saved.
 
         std::vector<int> jxz;   ///< Index of nearest full y position of xz input
         std::vector<int> ixz;   ///< Index of nearest full x position of yz input
@@ -87,5 +102,42 @@ class Cross
 
         //int check_list(std::vector<std::string> *, FieldMap *, std::string crossname);
         int check_save(int, char *);
+
+        // Time-appended NetCDF output, one file per variable and slice type written collectively by all processes.
+        struct Cross_nc_file
+        {
+            std::unique_ptr<Netcdf_file> file;
+            std::unique_ptr<Netcdf_variable<TF>> var;
+            std::unique_ptr<Netcdf_variable<int>> iotime_var;
+            int nrecords;
+            int last_iotime;
+        };
+
+        bool swnetcdf;
+        std::map<std::string, Cross_nc_file> nc_files;
+
+        // Local parts of the binary slices of the current output time, which are written at once.
+        struct Pending_slice
+        {
+            std::string filename;
+            std::string type;
+            int islice;
+            int kmax;
+            std::vector<TF> data;
+        };
+
+        bool swaggregate;
+        int nioranks;
+        std::vector<Pending_slice> pending_slices;
+
+        int save_slice(TF*, const TF, TF*, char*, const std::string&, const int, const int, const int, const bool sparse=false);
+        int get_slice_count(const Pending_slice&, const int);
+
+        int save_slice_netcdf(
+                TF*, const TF, const std::string&, const std::string&,
+                const std::vector<int>&, const int, const int, const int, const int, const int);
+        void write_slice_netcdf(
+                TF*, const TF, const std::string&, const std::string&,
+                const std::vector<int>&, const int, const int, const int, const int, const int);
 };
 #endif
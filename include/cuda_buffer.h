@@ -104,6 +104,33 @@ void cuda_copy(Src&& src, Dst&& dst)
             src.size_in_bytes());
 }
 
+/**
+ * Device memory allocated through `cuda_raw_buffer`, in bytes.
+ */
+struct cuda_memory_usage
+{
+    size_t current = 0;
+    size_t high_water_mark = 0;
+};
+
+/**
+ * Serve the allocations of `cuda_raw_buffer` from the stream-ordered memory pool of the device (`cudaMallocAsync`).
+ * The pool keeps freed memory for later allocations instead of returning it to the driver.
+ */
+void cuda_enable_memory_pool(bool enable);
+
+/**
+ * Allocate the memory of `cuda_raw_buffer` as unified memory (`cudaMallocManaged`) that prefers to reside on the
+ * device. The driver pages data between host and device on demand, such that the allocations may exceed the device
+ * memory. Cannot be combined with the memory pool.
+ */
+void cuda_enable_managed_memory(bool enable);
+
+/**
+ * Current and peak device memory allocated through `cuda_raw_buffer`.
+ */
+cuda_memory_usage cuda_get_memory_usage();
+
 /**
  * Represents memory buffer allocated on a CUDA device using `cudaMalloc`. Memory is automatically freed on
  * destruction.
@@ -142,6 +169,8 @@ struct cuda_raw_buffer
 
 private:
     void *ptr_ = nullptr;
+    size_t size_ = 0;
+    bool from_pool_ = false; // Allocated from the memory pool, which has to be released in stream order.
 };
 
 
@@ -0,0 +1,59 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CUDA_GRAPH_H
+#define CUDA_GRAPH_H
+
+#include <functional>
+#include <cuda_runtime.h>
+
+class Master;
+
+/**
+ * Records a sequence of kernel launches into a CUDA graph the first time it is
+ * executed and replays the graph afterwards. The kernels launched through
+ * launch_grid_kernel() during the recording use the capture stream; any other
+ * device work in the sequence (kernels on the default stream, memory copies or
+ * synchronizations) invalidates the recording, after which the graph is disabled
+ * and the sequence is executed launch by launch again.
+ */
+class Cuda_graph
+{
+    public:
+        Cuda_graph(Master&, bool);
+        ~Cuda_graph();
+
+        void exec(const std::function<void()>&); ///< Record or replay the launches.
+        void clear();                            ///< Discard the graph, such that it is recorded again.
+
+        bool is_enabled() const { return swgraph; }
+        bool is_captured() const { return graph_exec != nullptr; }
+
+    private:
+        Master& master;
+
+        bool swgraph;
+        cudaStream_t stream;
+        cudaGraphExec_t graph_exec;
+};
+#endif
@@ -27,10 +27,13 @@
 #include <type_traits>
 #include <functional>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include "tools.h"
 #include "cuda_buffer.h"
 #include "cuda_tiling.h"
+#include "cuda_streams.h"
 
 #ifdef ENABLE_KERNEL_LAUNCHER
 #include "kernel_launcher.h"
@@ -41,6 +44,7 @@ struct GridKernel: kernel_launcher::IKernelDescriptor {
         GridFunctor meta,
         kernel_launcher::TypeInfo functor_type,
         std::vector<kernel_launcher::TypeInfo> param_types,
+        std::vector<std::string> constant_args,
         Grid_layout grid);
     kernel_launcher::KernelBuilder build() const override;
     bool equals(const IKernelDescriptor& that) const override;
@@ -49,6 +53,7 @@ struct GridKernel: kernel_launcher::IKernelDescriptor {
     GridFunctor meta;
     kernel_launcher::TypeInfo functor_type;
     std::vector<kernel_launcher::TypeInfo> param_types;
+    std::vector<std::string> constant_args; ///< Values of the arguments compiled in as constants, empty if not.
     Grid_layout grid;
 };
 
@@ -100,6 +105,22 @@ struct convert_kernel_arg<cuda_vector<T>>: convert_kernel_arg<cuda_span<const T>
 template <typename T>
 struct convert_kernel_arg<const cuda_vector<T>>: convert_kernel_arg<cuda_span<const T>> {};
 
+// The integer arguments of the grid kernels are the grid dimensions, ghost cells and level
+// indices, which are fixed during a run. The runtime compiled kernels get them as constants.
+template <typename T>
+struct kernel_constant_arg {
+    static std::string call(const T&) {
+        return {};
+    }
+};
+
+template <>
+struct kernel_constant_arg<int> {
+    static std::string call(const int value) {
+        return std::to_string(value);
+    }
+};
+
 template <typename F, typename... Args>
 void launch_grid_kernel(
         const Grid_layout &gd,
@@ -117,15 +138,20 @@ void launch_grid_kernel(
             kernel_launcher::into_kernel_arg(convert_kernel_arg<Args>::call(args))...
     };
 
+    std::vector<std::string> constant_args = {
+            kernel_constant_arg<typename std::remove_cv<typename convert_kernel_arg<Args>::type>::type>::call(args)...
+    };
+
     GridKernel kernel(
         meta,
         kernel_launcher::TypeInfo::of<F>(),
         std::move(param_types),
+        std::move(constant_args),
         gd
     );
 
     bool success = launch_kernel(
-            nullptr,
+            Cuda_streams::get_launch_stream(),
             std::move(kernel),
             kernel_args);
 
@@ -148,7 +174,9 @@ void launch_grid_kernel(
             (problem_size.z / block_size.z) + bool(problem_size.z % block_size.z != 0)
     };
 
-    grid_tiling_kernel<F><<<grid_size, block_size>>>(
+    // The stream is the default stream, unless the launch is recorded into a CUDA graph
+    // or issued in a Cuda_streams region.
+    grid_tiling_kernel<F><<<grid_size, block_size, 0, Cuda_streams::get_launch_stream()>>>(
             gd,
             typename convert_kernel_arg<Args>::type(args)...);
     cuda_check_error();
@@ -0,0 +1,64 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CUDA_STREAMS_H
+#define CUDA_STREAMS_H
+
+#include <vector>
+#include <cuda_runtime.h>
+
+/**
+ * Fork-join region for independent kernel launches. The constructor makes the
+ * streams of a small pool wait for the work issued so far on the launch stream,
+ * select() directs the following launch_grid_kernel() calls to one of the pool
+ * streams, and the destructor makes the launch stream wait for all pool streams
+ * again. Only launches through launch_grid_kernel() may be issued inside the
+ * region, as other kernels are not ordered with the pool streams. Regions cannot
+ * be nested.
+ */
+class Cuda_streams
+{
+    public:
+        Cuda_streams();
+        ~Cuda_streams();
+
+        void select(const int); ///< Launch the following kernels on branch n.
+
+        static cudaStream_t get_launch_stream() { return launch_stream; }
+        static void set_launch_stream(cudaStream_t stream) { launch_stream = stream; }
+
+        static void set_pool_size(const int); ///< Number of streams, one disables the concurrent launches.
+        static void clear_pool();
+
+    private:
+        cudaStream_t parent;
+        int nused;
+
+        static thread_local cudaStream_t launch_stream;
+
+        static int pool_size;
+        static std::vector<cudaStream_t> streams;
+        static std::vector<cudaEvent_t> events;
+        static cudaEvent_t fork_event;
+};
+#endif
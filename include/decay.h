@@ -32,6 +32,7 @@ class Input;
 template<typename> class Grid;
 template<typename> class Fields;
 template<typename> class Stats;
+template<typename> class Timeloop;
 
 /**
  * Class that creates a decay term for scalars.
@@ -48,7 +49,7 @@ class Decay
 
         void init(Input&);           ///< Initialize the arrays that contain the profiles.
         void create(Input&, Stats<TF>&);   ///< Read the profiles of the forces from the input.
-        void exec(double, Stats<TF>&);     ///< Add the tendencies belonging to the decay processes.
+        void exec(double, Stats<TF>&, Timeloop<TF>&); ///< Add the tendencies belonging to the decay processes.
 
         void get_mask(Stats<TF>&, std::string);
         bool has_mask(std::string);
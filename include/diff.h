@@ -47,12 +47,18 @@ class Diff
         virtual void exec_viscosity(Stats<TF>&, Thermo<TF>&) = 0;
         virtual void init() = 0;
         virtual void exec(Stats<TF>&) = 0;
+        virtual void exec_implicit(double, Stats<TF>&) {} ///< Implicit part of the vertical diffusion, after all tendencies.
         virtual void exec_stats(Stats<TF>&, Thermo<TF>&) = 0;
         virtual void diff_flux(Field3d<TF>&, const Field3d<TF>&) = 0;
 
         virtual unsigned long get_time_limit(unsigned long, double) = 0;
         virtual double get_dn(double) = 0;
 
+        // Split of get_time_limit() for the fused time step limit in Model, that reduces all limits at once.
+        // By default, the local number is the reduced one and the limit does not depend on it.
+        virtual double get_dn_local(double dt) { return get_dn(dt); }
+        virtual unsigned long get_time_limit_from_dn(unsigned long idt, double dt, double) { return get_time_limit(idt, dt); }
+
         static std::shared_ptr<Diff> factory(Master&, Grid<TF>&, Fields<TF>&, Boundary<TF>&, Input&);
 
         #ifdef USECUDA
@@ -0,0 +1,159 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DIFF_4_KERNELS_CUH
+#define DIFF_4_KERNELS_CUH
+
+#include "finite_difference.h"
+#include "cuda_tiling.h"
+
+namespace Diff_4_kernels
+{
+    using namespace Finite_difference::O4;
+
+    // Horizontal part of the fourth order Laplacian, shared by all locations.
+    template<typename TF>
+    CUDA_DEVICE TF diff_h(
+            const TF* __restrict__ a, const int ijk, const int jj,
+            const TF dxidxi, const TF dyidyi)
+    {
+        const int ii1 = 1;
+        const int ii2 = 2;
+        const int ii3 = 3;
+        const int jj1 = 1*jj;
+        const int jj2 = 2*jj;
+        const int jj3 = 3*jj;
+
+        return (cdg3<TF>*a[ijk-ii3] + cdg2<TF>*a[ijk-ii2] + cdg1<TF>*a[ijk-ii1] + cdg0<TF>*a[ijk] + cdg1<TF>*a[ijk+ii1] + cdg2<TF>*a[ijk+ii2] + cdg3<TF>*a[ijk+ii3])*dxidxi
+             + (cdg3<TF>*a[ijk-jj3] + cdg2<TF>*a[ijk-jj2] + cdg1<TF>*a[ijk-jj1] + cdg0<TF>*a[ijk] + cdg1<TF>*a[ijk+jj1] + cdg2<TF>*a[ijk+jj2] + cdg3<TF>*a[ijk+jj3])*dyidyi;
+    }
+
+    // The edge level of one makes the launcher take the branch free interior path
+    // for all levels but the bottom and top one, and lets the tuner march each
+    // thread over multiple levels such that the vertical neighbours stay cached.
+    template<typename TF>
+    struct diff_c_g
+    {
+        DEFINE_GRID_KERNEL("diff_4::diff_c", 1)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g,
+                const int i, const int j, const int k,
+                const Level level,
+                TF* __restrict__ at, const TF* __restrict__ a,
+                const TF* __restrict__ dzi4, const TF* __restrict__ dzhi4,
+                const TF dxidxi, const TF dyidyi, const TF visc)
+        {
+            const int ijk = g(i, j, k);
+            const int jj = g.jstride;
+            const int kk1 = 1*g.kstride;
+            const int kk2 = 2*g.kstride;
+            const int kk3 = 3*g.kstride;
+
+            TF tend = diff_h(a, ijk, jj, dxidxi, dyidyi);
+
+            // bottom boundary
+            if (level.distance_to_start() == 0)
+            {
+                tend += ( cg0<TF>*(bg0<TF>*a[ijk-kk2] + bg1<TF>*a[ijk-kk1] + bg2<TF>*a[ijk    ] + bg3<TF>*a[ijk+kk1]) * dzhi4[k-1]
+                        + cg1<TF>*(cg0<TF>*a[ijk-kk2] + cg1<TF>*a[ijk-kk1] + cg2<TF>*a[ijk    ] + cg3<TF>*a[ijk+kk1]) * dzhi4[k  ]
+                        + cg2<TF>*(cg0<TF>*a[ijk-kk1] + cg1<TF>*a[ijk    ] + cg2<TF>*a[ijk+kk1] + cg3<TF>*a[ijk+kk2]) * dzhi4[k+1]
+                        + cg3<TF>*(cg0<TF>*a[ijk    ] + cg1<TF>*a[ijk+kk1] + cg2<TF>*a[ijk+kk2] + cg3<TF>*a[ijk+kk3]) * dzhi4[k+2] ) * dzi4[k];
+            }
+            // top boundary
+            else if (level.distance_to_end() == 0)
+            {
+                tend += ( cg0<TF>*(cg0<TF>*a[ijk-kk3] + cg1<TF>*a[ijk-kk2] + cg2<TF>*a[ijk-kk1] + cg3<TF>*a[ijk    ]) * dzhi4[k-1]
+                        + cg1<TF>*(cg0<TF>*a[ijk-kk2] + cg1<TF>*a[ijk-kk1] + cg2<TF>*a[ijk    ] + cg3<TF>*a[ijk+kk1]) * dzhi4[k  ]
+                        + cg2<TF>*(cg0<TF>*a[ijk-kk1] + cg1<TF>*a[ijk    ] + cg2<TF>*a[ijk+kk1] + cg3<TF>*a[ijk+kk2]) * dzhi4[k+1]
+                        + cg3<TF>*(tg0<TF>*a[ijk-kk1] + tg1<TF>*a[ijk    ] + tg2<TF>*a[ijk+kk1] + tg3<TF>*a[ijk+kk2]) * dzhi4[k+2] ) * dzi4[k];
+            }
+            // interior
+            else
+            {
+                tend += ( cg0<TF>*(cg0<TF>*a[ijk-kk3] + cg1<TF>*a[ijk-kk2] + cg2<TF>*a[ijk-kk1] + cg3<TF>*a[ijk    ]) * dzhi4[k-1]
+                        + cg1<TF>*(cg0<TF>*a[ijk-kk2] + cg1<TF>*a[ijk-kk1] + cg2<TF>*a[ijk    ] + cg3<TF>*a[ijk+kk1]) * dzhi4[k  ]
+                        + cg2<TF>*(cg0<TF>*a[ijk-kk1] + cg1<TF>*a[ijk    ] + cg2<TF>*a[ijk+kk1] + cg3<TF>*a[ijk+kk2]) * dzhi4[k+1]
+                        + cg3<TF>*(cg0<TF>*a[ijk    ] + cg1<TF>*a[ijk+kk1] + cg2<TF>*a[ijk+kk2] + cg3<TF>*a[ijk+kk3]) * dzhi4[k+2] ) * dzi4[k];
+            }
+
+            at[ijk] += visc * tend;
+        }
+    };
+
+    // Launched from kstart+1, as the vertical velocity at the surface has no tendency.
+    template<typename TF>
+    struct diff_w_g
+    {
+        DEFINE_GRID_KERNEL("diff_4::diff_w", 1)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g,
+                const int i, const int j, const int k,
+                const Level level,
+                TF* __restrict__ at, const TF* __restrict__ a,
+                const TF* __restrict__ dzi4, const TF* __restrict__ dzhi4,
+                const TF dxidxi, const TF dyidyi, const TF visc)
+        {
+            const int ijk = g(i, j, k);
+            const int jj = g.jstride;
+            const int kk1 = 1*g.kstride;
+            const int kk2 = 2*g.kstride;
+            const int kk3 = 3*g.kstride;
+
+            TF tend = diff_h(a, ijk, jj, dxidxi, dyidyi);
+
+            // bottom boundary
+            if (level.distance_to_start() == 0)
+            {
+                tend += ( cg0<TF>*(bg0<TF>*a[ijk-kk2] + bg1<TF>*a[ijk-kk1] + bg2<TF>*a[ijk    ] + bg3<TF>*a[ijk+kk1]) * dzi4[k-1]
+                        + cg1<TF>*(cg0<TF>*a[ijk-kk2] + cg1<TF>*a[ijk-kk1] + cg2<TF>*a[ijk    ] + cg3<TF>*a[ijk+kk1]) * dzi4[k  ]
+                        + cg2<TF>*(cg0<TF>*a[ijk-kk1] + cg1<TF>*a[ijk    ] + cg2<TF>*a[ijk+kk1] + cg3<TF>*a[ijk+kk2]) * dzi4[k+1]
+                        + cg3<TF>*(cg0<TF>*a[ijk    ] + cg1<TF>*a[ijk+kk1] + cg2<TF>*a[ijk+kk2] + cg3<TF>*a[ijk+kk3]) * dzi4[k+2] ) * dzhi4[k];
+            }
+            // top boundary
+            else if (level.distance_to_end() == 0)
+            {
+                tend += ( cg0<TF>*(cg0<TF>*a[ijk-kk3] + cg1<TF>*a[ijk-kk2] + cg2<TF>*a[ijk-kk1] + cg3<TF>*a[ijk    ]) * dzi4[k-2]
+                        + cg1<TF>*(cg0<TF>*a[ijk-kk2] + cg1<TF>*a[ijk-kk1] + cg2<TF>*a[ijk    ] + cg3<TF>*a[ijk+kk1]) * dzi4[k-1]
+                        + cg2<TF>*(cg0<TF>*a[ijk-kk1] + cg1<TF>*a[ijk    ] + cg2<TF>*a[ijk+kk1] + cg3<TF>*a[ijk+kk2]) * dzi4[k  ]
+                        + cg3<TF>*(tg0<TF>*a[ijk-kk1] + tg1<TF>*a[ijk    ] + tg2<TF>*a[ijk+kk1] + tg3<TF>*a[ijk+kk2]) * dzi4[k+1] ) * dzhi4[k];
+            }
+            // interior
+            else
+            {
+                tend += ( cg0<TF>*(cg0<TF>*a[ijk-kk3] + cg1<TF>*a[ijk-kk2] + cg2<TF>*a[ijk-kk1] + cg3<TF>*a[ijk    ]) * dzi4[k-2]
+                        + cg1<TF>*(cg0<TF>*a[ijk-kk2] + cg1<TF>*a[ijk-kk1] + cg2<TF>*a[ijk    ] + cg3<TF>*a[ijk+kk1]) * dzi4[k-1]
+                        + cg2<TF>*(cg0<TF>*a[ijk-kk1] + cg1<TF>*a[ijk    ] + cg2<TF>*a[ijk+kk1] + cg3<TF>*a[ijk+kk2]) * dzi4[k  ]
+                        + cg3<TF>*(cg0<TF>*a[ijk    ] + cg1<TF>*a[ijk+kk1] + cg2<TF>*a[ijk+kk2] + cg3<TF>*a[ijk+kk3]) * dzi4[k+1] ) * dzhi4[k];
+            }
+
+            at[ijk] += visc * tend;
+        }
+    };
+}
+#endif
@@ -23,9 +23,12 @@
 #ifndef DIFF_KERNELS_H
 #define DIFF_KERNELS_H
 
+#include <vector>
+
 #include "fast_math.h"
 #include "boundary.h"
 #include "constants.h"
+#include "cpu_tiling.h"
 
 namespace Diff_kernels
 {
@@ -102,43 +105,50 @@ namespace Diff_kernels
                 }
         }
 
-        for (int k=kstart+k_offset; k<kend; ++k)
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    strain2[ijk] = TF(2.)*(
-                                   // du/dx + du/dx
-                                   + fm::pow2((u[ijk+ii]-u[ijk])*dxi)
-
-                                   // dv/dy + dv/dy
-                                   + fm::pow2((v[ijk+jj]-v[ijk])*dyi)
-
-                                   // dw/dz + dw/dz
-                                   + fm::pow2((w[ijk+kk]-w[ijk])*dzi[k])
-
-                                   // du/dy + dv/dx
-                                   + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -jj])*dyi  + (v[ijk      ]-v[ijk-ii   ])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-jj])*dyi  + (v[ijk+ii   ]-v[ijk      ])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk   +jj]-u[ijk      ])*dyi  + (v[ijk   +jj]-v[ijk-ii+jj])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk+ii+jj]-u[ijk+ii   ])*dyi  + (v[ijk+ii+jj]-v[ijk   +jj])*dxi)
-
-                                   // du/dz + dw/dx
-                                   + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-ii   ])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-kk])*dzhi[k  ] + (w[ijk+ii   ]-w[ijk      ])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk   +kk]-u[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-ii+kk])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk+ii+kk]-u[ijk+ii   ])*dzhi[k+1] + (w[ijk+ii+kk]-w[ijk   +kk])*dxi)
-
-                                   // dv/dz + dw/dy
-                                   + TF(0.125)*fm::pow2((v[ijk      ]-v[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-jj   ])*dyi)
-                                   + TF(0.125)*fm::pow2((v[ijk+jj   ]-v[ijk+jj-kk])*dzhi[k  ] + (w[ijk+jj   ]-w[ijk      ])*dyi)
-                                   + TF(0.125)*fm::pow2((v[ijk   +kk]-v[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-jj+kk])*dyi)
-                                   + TF(0.125)*fm::pow2((v[ijk+jj+kk]-v[ijk+jj   ])*dzhi[k+1] + (w[ijk+jj+kk]-w[ijk   +kk])*dyi) );
-
-                    // Add a small number to avoid zero divisions.
-                    strain2[ijk] += Constants::dsmall;
-                }
+        // The j-blocks march in k, such that the two planes of u, v, and w that the
+        // strain rate needs stay in cache.
+        const Cpu_tiling::J_blocks blocks(
+                jstart, jend, Cpu_tiling::calc_jblock<TF>(jj, jend-jstart, 2, 3));
+
+        #pragma omp parallel for collapse(2)
+        for (int b=0; b<blocks.size(); ++b)
+            for (int k=kstart+k_offset; k<kend; ++k)
+                for (int j=blocks.start(b); j<blocks.end(b); ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        strain2[ijk] = TF(2.)*(
+                                       // du/dx + du/dx
+                                       + fm::pow2((u[ijk+ii]-u[ijk])*dxi)
+
+                                       // dv/dy + dv/dy
+                                       + fm::pow2((v[ijk+jj]-v[ijk])*dyi)
+
+                                       // dw/dz + dw/dz
+                                       + fm::pow2((w[ijk+kk]-w[ijk])*dzi[k])
+
+                                       // du/dy + dv/dx
+                                       + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -jj])*dyi  + (v[ijk      ]-v[ijk-ii   ])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-jj])*dyi  + (v[ijk+ii   ]-v[ijk      ])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk   +jj]-u[ijk      ])*dyi  + (v[ijk   +jj]-v[ijk-ii+jj])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk+ii+jj]-u[ijk+ii   ])*dyi  + (v[ijk+ii+jj]-v[ijk   +jj])*dxi)
+
+                                       // du/dz + dw/dx
+                                       + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-ii   ])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-kk])*dzhi[k  ] + (w[ijk+ii   ]-w[ijk      ])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk   +kk]-u[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-ii+kk])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk+ii+kk]-u[ijk+ii   ])*dzhi[k+1] + (w[ijk+ii+kk]-w[ijk   +kk])*dxi)
+
+                                       // dv/dz + dw/dy
+                                       + TF(0.125)*fm::pow2((v[ijk      ]-v[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-jj   ])*dyi)
+                                       + TF(0.125)*fm::pow2((v[ijk+jj   ]-v[ijk+jj-kk])*dzhi[k  ] + (w[ijk+jj   ]-w[ijk      ])*dyi)
+                                       + TF(0.125)*fm::pow2((v[ijk   +kk]-v[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-jj+kk])*dyi)
+                                       + TF(0.125)*fm::pow2((v[ijk+jj+kk]-v[ijk+jj   ])*dzhi[k+1] + (w[ijk+jj+kk]-w[ijk   +kk])*dyi) );
+
+                        // Add a small number to avoid zero divisions.
+                        strain2[ijk] += Constants::dsmall;
+                    }
     }
 
     template <typename TF, Surface_model surface_model>
@@ -218,6 +228,7 @@ namespace Diff_kernels
                 }
         }
 
+        #pragma omp parallel for
         for (int k=kstart+k_offset; k<kend-k_offset; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -321,6 +332,7 @@ namespace Diff_kernels
                 }
         }
 
+        #pragma omp parallel for
         for (int k=kstart+k_offset; k<kend-k_offset; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -366,6 +378,7 @@ namespace Diff_kernels
     {
         const int ii = 1;
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -460,6 +473,7 @@ namespace Diff_kernels
                 }
         }
 
+        #pragma omp parallel for
         for (int k=kstart+k_offset; k<kend-k_offset; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -492,24 +506,95 @@ namespace Diff_kernels
             const int istart, const int iend,
             const int jstart, const int jend,
             const int kstart, const int kend,
-            const int jj, const int kk)
+            const int jj, const int kk,
+            const bool sw_implicit = false)
     {
         const TF tPrfac_i = TF(1)/std::min(TF(1.), tPr);
+        const TF dzfac = sw_implicit ? TF(0.) : TF(1.);
         TF dnmul = 0;
 
         // get the maximum time step for diffusion
+        #pragma omp parallel for reduction(max:dnmul)
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
                 for (int i=istart; i<iend; ++i)
                 {
                     const int ijk = i + j*jj + k*kk;
-                    dnmul = std::max(dnmul, std::abs(evisc[ijk]*tPrfac_i*(dxidxi + dyidyi + dzi[k]*dzi[k])));
+                    dnmul = std::max(dnmul, std::abs(evisc[ijk]*tPrfac_i*(dxidxi + dyidyi + dzfac*dzi[k]*dzi[k])));
                 }
 
         return dnmul;
     }
 
+    // Replace the tendency at of levels kstart to kend-1 by the solution of (I - subdt*Dz) x = at, with Dz
+    // the vertical diffusion operator. This is the backward Euler step of the vertical diffusion in delta form,
+    // that adds the implicit part to the explicit tendency that already contains the full diffusion. The
+    // functors return subdt times the coefficients of the lower and upper neighbour of the cell. Outside of
+    // the range the increment is zero, such that a zero coefficient at the edge keeps the boundary flux fixed.
+    template<typename TF, typename Coef_bot, typename Coef_top>
+    void solve_implicit_vertical(
+            TF* const restrict at,
+            Coef_bot&& coef_bot, Coef_top&& coef_top,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        const int kmax = kend - kstart;
+
+        #pragma omp parallel
+        {
+            // Upper diagonal of the eliminated system of the columns of one row.
+            std::vector<TF> gamma(kmax*jj);
+
+            #pragma omp for
+            for (int j=jstart; j<jend; ++j)
+            {
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + kstart*kk;
+                    const TF cb = coef_bot(ijk, kstart);
+                    const TF ct = coef_top(ijk, kstart);
+                    const TF pivot_i = TF(1.) / (TF(1.) + cb + ct);
+
+                    gamma[i] = -ct * pivot_i;
+                    at[ijk] *= pivot_i;
+                }
+
+                for (int k=kstart+1; k<kend; ++k)
+                {
+                    const int kg = (k-kstart)*jj;
+
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        const TF cb = coef_bot(ijk, k);
+                        const TF ct = coef_top(ijk, k);
+                        const TF pivot_i = TF(1.) / (TF(1.) + cb + ct + cb*gamma[i+kg-jj]);
+
+                        gamma[i+kg] = -ct * pivot_i;
+                        at[ijk] = (at[ijk] + cb*at[ijk-kk]) * pivot_i;
+                    }
+                }
+
+                for (int k=kend-2; k>=kstart; --k)
+                {
+                    const int kg = (k-kstart)*jj;
+
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        at[ijk] -= gamma[i+kg]*at[ijk+kk];
+                    }
+                }
+            }
+        }
+    }
+
     template <typename TF, Surface_model surface_model>
     void calc_diff_flux_c(
             TF* const restrict out,
@@ -32,6 +32,91 @@ namespace Diff_les_kernels
     namespace most = Monin_obukhov;
     namespace fm = Fast_math;
 
+    // Total strain rate at the cell centre, shared by the kernels that need it.
+    template<typename TF, bool surface_model_enabled, typename Level>
+    CUDA_DEVICE
+    TF calc_strain2(
+            Grid_layout gd, int i, int j, int k, Level level,
+            const TF* __restrict__ u,
+            const TF* __restrict__ v,
+            const TF* __restrict__ w,
+            const TF* __restrict__ dudz,
+            const TF* __restrict__ dvdz,
+            const TF* __restrict__ dzi,
+            const TF* __restrict__ dzhi,
+            const TF dxi, const TF dyi)
+    {
+        const int ii = 1;
+        const int jj = gd.jstride;
+        const int kk = gd.kstride;
+        const int ij  = i*ii + j*jj;
+        const int ijk = i*ii + j*jj + k*kk;
+
+        if (level.distance_to_start() == 0 && surface_model_enabled)
+        {
+            const TF strain2 = TF(2.)*(
+                    // du/dx + du/dx
+                    + fm::pow2((u[ijk+ii]-u[ijk])*dxi)
+
+                    // dv/dy + dv/dy
+                    + fm::pow2((v[ijk+jj]-v[ijk])*dyi)
+
+                    // dw/dz + dw/dz
+                    + fm::pow2((w[ijk+kk]-w[ijk])*dzi[k])
+
+                    // du/dy + dv/dx
+                    + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -jj])*dyi  + (v[ijk      ]-v[ijk-ii   ])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-jj])*dyi  + (v[ijk+ii   ]-v[ijk      ])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk   +jj]-u[ijk      ])*dyi  + (v[ijk   +jj]-v[ijk-ii+jj])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk+ii+jj]-u[ijk+ii   ])*dyi  + (v[ijk+ii+jj]-v[ijk   +jj])*dxi)
+
+                    // du/dz + dw/dx
+                    + TF(0.5)*fm::pow2(dudz[ij])
+                    + TF(0.125)*fm::pow2((w[ijk      ]-w[ijk-ii   ])*dxi)
+                    + TF(0.125)*fm::pow2((w[ijk+ii   ]-w[ijk      ])*dxi)
+                    + TF(0.125)*fm::pow2((w[ijk   +kk]-w[ijk-ii+kk])*dxi)
+                    + TF(0.125)*fm::pow2((w[ijk+ii+kk]-w[ijk   +kk])*dxi)
+
+                    // dv/dz + dw/dy
+                    + TF(0.5)*fm::pow2(dvdz[ij])
+                    + TF(0.125)*fm::pow2((w[ijk      ]-w[ijk-jj   ])*dyi)
+                    + TF(0.125)*fm::pow2((w[ijk+jj   ]-w[ijk      ])*dyi)
+                    + TF(0.125)*fm::pow2((w[ijk   +kk]-w[ijk-jj+kk])*dyi)
+                    + TF(0.125)*fm::pow2((w[ijk+jj+kk]-w[ijk   +kk])*dyi) );
+
+            // add a small number to avoid zero divisions
+            return strain2 + Constants::dsmall;
+        }
+        else
+        {
+            const TF strain2 = TF(2.)*(
+                    // du/dx + du/dx
+                    + fm::pow2((u[ijk+ii]-u[ijk])*dxi)
+                    // dv/dy + dv/dy
+                    + fm::pow2((v[ijk+jj]-v[ijk])*dyi)
+                    // dw/dz + dw/dz
+                    + fm::pow2((w[ijk+kk]-w[ijk])*dzi[k])
+                    // du/dy + dv/dx
+                    + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -jj])*dyi  + (v[ijk      ]-v[ijk-ii   ])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-jj])*dyi  + (v[ijk+ii   ]-v[ijk      ])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk   +jj]-u[ijk      ])*dyi  + (v[ijk   +jj]-v[ijk-ii+jj])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk+ii+jj]-u[ijk+ii   ])*dyi  + (v[ijk+ii+jj]-v[ijk   +jj])*dxi)
+                    // du/dz + dw/dx
+                    + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-ii   ])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-kk])*dzhi[k  ] + (w[ijk+ii   ]-w[ijk      ])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk   +kk]-u[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-ii+kk])*dxi)
+                    + TF(0.125)*fm::pow2((u[ijk+ii+kk]-u[ijk+ii   ])*dzhi[k+1] + (w[ijk+ii+kk]-w[ijk   +kk])*dxi)
+                    // dv/dz + dw/dy
+                    + TF(0.125)*fm::pow2((v[ijk      ]-v[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-jj   ])*dyi)
+                    + TF(0.125)*fm::pow2((v[ijk+jj   ]-v[ijk+jj-kk])*dzhi[k  ] + (w[ijk+jj   ]-w[ijk      ])*dyi)
+                    + TF(0.125)*fm::pow2((v[ijk   +kk]-v[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-jj+kk])*dyi)
+                    + TF(0.125)*fm::pow2((v[ijk+jj+kk]-v[ijk+jj   ])*dzhi[k+1] + (w[ijk+jj+kk]-w[ijk   +kk])*dyi) );
+
+            // add a small number to avoid zero divisions
+            return strain2 + Constants::dsmall;
+        }
+    }
+
     template<typename TF, bool surface_model_enabled>
     struct calc_strain2_g
     {
@@ -51,75 +136,10 @@ namespace Diff_les_kernels
                 const TF* __restrict__ dzhi,
                 const TF dxi, const TF dyi)
         {
-            const int ii = 1;
-            const int jj = gd.jstride;
-            const int kk = gd.kstride;
-            const int ij  = i*ii + j*jj;
-            const int ijk = i*ii + j*jj + k*kk;
+            const int ijk = i + j*gd.jstride + k*gd.kstride;
 
-            if (level.distance_to_start() == 0 && surface_model_enabled)
-            {
-                strain2[ijk] = TF(2.)*(
-                        // du/dx + du/dx
-                        + fm::pow2((u[ijk+ii]-u[ijk])*dxi)
-
-                        // dv/dy + dv/dy
-                        + fm::pow2((v[ijk+jj]-v[ijk])*dyi)
-
-                        // dw/dz + dw/dz
-                        + fm::pow2((w[ijk+kk]-w[ijk])*dzi[k])
-
-                        // du/dy + dv/dx
-                        + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -jj])*dyi  + (v[ijk      ]-v[ijk-ii   ])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-jj])*dyi  + (v[ijk+ii   ]-v[ijk      ])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk   +jj]-u[ijk      ])*dyi  + (v[ijk   +jj]-v[ijk-ii+jj])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk+ii+jj]-u[ijk+ii   ])*dyi  + (v[ijk+ii+jj]-v[ijk   +jj])*dxi)
-
-                        // du/dz + dw/dx
-                        + TF(0.5)*fm::pow2(dudz[ij])
-                        + TF(0.125)*fm::pow2((w[ijk      ]-w[ijk-ii   ])*dxi)
-                        + TF(0.125)*fm::pow2((w[ijk+ii   ]-w[ijk      ])*dxi)
-                        + TF(0.125)*fm::pow2((w[ijk   +kk]-w[ijk-ii+kk])*dxi)
-                        + TF(0.125)*fm::pow2((w[ijk+ii+kk]-w[ijk   +kk])*dxi)
-
-                        // dv/dz + dw/dy
-                        + TF(0.5)*fm::pow2(dvdz[ij])
-                        + TF(0.125)*fm::pow2((w[ijk      ]-w[ijk-jj   ])*dyi)
-                        + TF(0.125)*fm::pow2((w[ijk+jj   ]-w[ijk      ])*dyi)
-                        + TF(0.125)*fm::pow2((w[ijk   +kk]-w[ijk-jj+kk])*dyi)
-                        + TF(0.125)*fm::pow2((w[ijk+jj+kk]-w[ijk   +kk])*dyi) );
-
-                // add a small number to avoid zero divisions
-                strain2[ijk] += Constants::dsmall;
-            }
-            else
-            {
-                strain2[ijk] = TF(2.)*(
-                        // du/dx + du/dx
-                        + fm::pow2((u[ijk+ii]-u[ijk])*dxi)
-                        // dv/dy + dv/dy
-                        + fm::pow2((v[ijk+jj]-v[ijk])*dyi)
-                        // dw/dz + dw/dz
-                        + fm::pow2((w[ijk+kk]-w[ijk])*dzi[k])
-                        // du/dy + dv/dx
-                        + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -jj])*dyi  + (v[ijk      ]-v[ijk-ii   ])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-jj])*dyi  + (v[ijk+ii   ]-v[ijk      ])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk   +jj]-u[ijk      ])*dyi  + (v[ijk   +jj]-v[ijk-ii+jj])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk+ii+jj]-u[ijk+ii   ])*dyi  + (v[ijk+ii+jj]-v[ijk   +jj])*dxi)
-                        // du/dz + dw/dx
-                        + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-ii   ])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-kk])*dzhi[k  ] + (w[ijk+ii   ]-w[ijk      ])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk   +kk]-u[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-ii+kk])*dxi)
-                        + TF(0.125)*fm::pow2((u[ijk+ii+kk]-u[ijk+ii   ])*dzhi[k+1] + (w[ijk+ii+kk]-w[ijk   +kk])*dxi)
-                        // dv/dz + dw/dy
-                        + TF(0.125)*fm::pow2((v[ijk      ]-v[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-jj   ])*dyi)
-                        + TF(0.125)*fm::pow2((v[ijk+jj   ]-v[ijk+jj-kk])*dzhi[k  ] + (w[ijk+jj   ]-w[ijk      ])*dyi)
-                        + TF(0.125)*fm::pow2((v[ijk   +kk]-v[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-jj+kk])*dyi)
-                        + TF(0.125)*fm::pow2((v[ijk+jj+kk]-v[ijk+jj   ])*dzhi[k+1] + (w[ijk+jj+kk]-w[ijk   +kk])*dyi) );
-
-                // add a small number to avoid zero divisions
-                strain2[ijk] += Constants::dsmall;
-            }
+            strain2[ijk] = calc_strain2<TF, surface_model_enabled>(
+                    gd, i, j, k, level, u, v, w, dudz, dvdz, dzi, dzhi, dxi, dyi);
         }
     };
 
@@ -40,10 +40,17 @@ class Diff_smag2 : public Diff<TF>
         Diffusion_type get_switch() const;
         unsigned long get_time_limit(unsigned long, double);
         double get_dn(double);
+        #ifndef USECUDA
+        double get_dn_local(double);
+        unsigned long get_time_limit_from_dn(unsigned long, double, double);
+        #endif
 
         void create(Stats<TF>&, const bool);
         void init();
         void exec(Stats<TF>&);
+        #ifndef USECUDA
+        void exec_implicit(double, Stats<TF>&);
+        #endif
         void exec_viscosity(Stats<TF>&, Thermo<TF>&);
         void diff_flux(Field3d<TF>&, const Field3d<TF>&);
         void exec_stats(Stats<TF>&, Thermo<TF>&);
@@ -75,8 +82,11 @@ class Diff_smag2 : public Diff<TF>
         double cs;
 
         bool sw_mason;  ///< Switch for use of Mason's wall correction
+        bool sw_implicit; ///< Switch for the implicit vertical diffusion
 
         const std::string tend_name = "diff";
         const std::string tend_longname = "Diffusion";
+        const std::string tend_name_implicit = "diff_implicit";
+        const std::string tend_longname_implicit = "Implicit vertical diffusion";
 };
 #endif
@@ -26,12 +26,14 @@
 #include "cuda_tiling.h"
 #include "fast_math.h"
 #include "monin_obukhov.h"
+#include "diff_kl_kernels.cuh"
 
 namespace Diff_smag2_kernels
 {
     namespace most = Monin_obukhov;
     namespace fm = Fast_math;
 
+    // Strain rate and eddy viscosity in one pass, such that the strain rate is not stored.
     template<typename TF, bool surface_model_enabled>
     struct evisc_g
     {
@@ -42,20 +44,29 @@ namespace Diff_smag2_kernels
         void operator()(
             Grid_layout gd, int i, int j, int k, Level level,
             TF* __restrict__ evisc,
+            const TF* __restrict__ u,
+            const TF* __restrict__ v,
+            const TF* __restrict__ w,
+            const TF* __restrict__ dudz,
+            const TF* __restrict__ dvdz,
             const TF* __restrict__ N2,
             const TF* __restrict__ bgradbot,
             const TF* __restrict__ mlen0,
             const TF* __restrict__ z0m,
             const TF* __restrict__ z,
+            const TF* __restrict__ dzi,
+            const TF* __restrict__ dzhi,
+            const TF dxi, const TF dyi,
             const TF tPri)
         {
-//            const TF n_mason = TF(2);
-
             const int jj = gd.jstride;
             const int kk = gd.kstride;
             const int ij  = i + j*jj;
             const int ijk = i + j*jj + k*kk;
 
+            const TF strain2 = Diff_les_kernels::calc_strain2<TF, surface_model_enabled>(
+                    gd, i, j, k, level, u, v, w, dudz, dvdz, dzi, dzhi, dxi, dyi);
+
             if constexpr (surface_model_enabled)
             {
                 TF RitPrratio;
@@ -63,12 +74,12 @@ namespace Diff_smag2_kernels
                 if (level.distance_to_start() == 0)
                 {
                     // calculate smagorinsky constant times filter width squared, use wall damping according to Mason
-                    RitPrratio = bgradbot[ij] / evisc[ijk] * tPri;
+                    RitPrratio = bgradbot[ij] / strain2 * tPri;
                 }
                 else
                 {
                     // Add the buoyancy production to the TKE
-                    RitPrratio = N2[ijk] / evisc[ijk] * tPri;
+                    RitPrratio = N2[ijk] / strain2 * tPri;
                 }
 
                 RitPrratio = fmin(RitPrratio, TF(1.-Constants::dsmall));
@@ -77,15 +88,14 @@ namespace Diff_smag2_kernels
                 const TF m = mlen0[k];
                 const TF r = fm::pow2(Constants::kappa<TF>*(z[k] + z0m[ij]));
                 const TF mlen_squared = (m * r) / (m + r); // == 1/(1/r + 1/m)
-                evisc[ijk] = mlen_squared * sqrt(evisc[ijk] * (TF(1.) - RitPrratio));
-
+                evisc[ijk] = mlen_squared * sqrt(strain2 * (TF(1.) - RitPrratio));
             }
             else
             {
-                // calculate smagorinsky constant times filter width squared, use wall damping according to Mason
-                TF RitPrratio = N2[ijk] / evisc[ijk] * tPri;
+                // calculate smagorinsky constant times filter width squared, do not use wall damping with resolved walls
+                TF RitPrratio = N2[ijk] / strain2 * tPri;
                 RitPrratio = fmin(RitPrratio, TF(1.-Constants::dsmall));
-                evisc[ijk] = fm::pow2(mlen0[k]) * sqrt(evisc[ijk] * (TF(1.)-RitPrratio));
+                evisc[ijk] = fm::pow2(mlen0[k]) * sqrt(strain2 * (TF(1.)-RitPrratio));
             }
         }
     };
@@ -41,6 +41,10 @@ class Diff_tke2 : public Diff<TF>
         Diffusion_type get_switch() const;
         unsigned long get_time_limit(unsigned long, double);
         double get_dn(double);
+        #ifndef USECUDA
+        double get_dn_local(double);
+        unsigned long get_time_limit_from_dn(unsigned long, double, double);
+        #endif
 
         void create(Stats<TF>&, const bool);
         void init();
@@ -266,5 +266,74 @@ namespace Diff_tke2_kernels
             at[ijk] += evisc[ijk] * strain2[ijk];
         }
     };
+
+    // Eddy viscosities of `evisc_g` and `evisc_heat_g` together with the buoyancy, dissipation and shear
+    // tendencies of the SGS TKE, for the steps without tendency statistics. The three kernels share the
+    // length scale, and the tendency is updated in the order of the separate kernels.
+    template<typename TF, bool sw_surface_model, bool sw_mason>
+    struct evisc_sgstke_tend_g
+    {
+        DEFINE_GRID_KERNEL("diff_tke2::evisc_sgstke_tend", sw_surface_model ? 1 : 0)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout gd,
+                int i, int j, int k,
+                Level level,
+                TF* const __restrict__ evisc,
+                TF* const __restrict__ evisch,
+                TF* const __restrict__ at,
+                const TF* const __restrict__ sgstke,
+                const TF* const __restrict__ strain2,
+                const TF* const __restrict__ N2,
+                const TF* const __restrict__ bgradbot,
+                const TF* const __restrict__ z,
+                const TF* const __restrict__ z0m,
+                const TF* const __restrict__ mlen0,
+                const TF cn, const TF cm,
+                const TF ch1, const TF ch2,
+                const TF ce1, const TF ce2)
+        {
+            const int ij  = i + j*gd.jstride;
+            const int ijk = i + j*gd.jstride + k*gd.kstride;
+
+            const TF n_mason = TF(2.);
+
+            if constexpr (!sw_surface_model)
+                asm("trap;");
+            else
+            {
+                const TF N2_ijk = (level.distance_to_start() == 0) ? bgradbot[ij] : N2[ijk];
+
+                TF mlen = mlen0[k];
+                if ( N2_ijk > 0 ) // Only if stably stratified, adapt length scale
+                    mlen = cn * sqrt(sgstke[ijk] / N2_ijk);
+
+                TF fac = min(mlen0[k], mlen);
+
+                if constexpr (sw_mason) // Apply Mason's wall correction here
+                {
+                    if constexpr (n_mason == 2)
+                        fac = sqrt(TF(1.) / ( TF(1.)/fm::pow2(fac) + TF(1.)/(fm::pow2(Constants::kappa<TF>*(z[k]+z0m[ij]))) ) );
+                    else
+                        fac = pow(TF(1.) / (TF(1.)/pow(fac, TF(n_mason)) + TF(1.)/
+                                    (pow(Constants::kappa<TF>*(z[k]+z0m[ij]), TF(n_mason)))), TF(1.)/TF(n_mason));
+                }
+
+                const TF evisc_ijk = cm * fac * sqrt(sgstke[ijk]);
+                const TF evisch_ijk = (ch1 + ch2 * fac / mlen0[k]) * evisc_ijk;
+
+                TF tend = at[ijk];
+                tend -= evisch_ijk * N2_ijk;
+                tend -= (ce1 + ce2 * fac / mlen0[k]) * pow(sgstke[ijk], TF(3./2.)) / fac;
+                tend += evisc_ijk * strain2[ijk];
+
+                evisc[ijk] = evisc_ijk;
+                evisch[ijk] = evisch_ijk;
+                at[ijk] = tend;
+            }
+        }
+    };
 }
 #endif
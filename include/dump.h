@@ -23,16 +23,26 @@
 #ifndef DUMP_H
 #define DUMP_H
 
+#include <map>
+#include <memory>
+
+#ifdef USEADIOS2
+#include <adios2.h>
+#endif
+
 class Master;
 class Input;
+class Io_server;
+class Netcdf_file;
 template<typename> class Grid;
 template<typename> class Fields;
+template<typename> class Netcdf_variable;
 
 template<typename TF>
 class Dump
 {
     public:
-        Dump(Master&, Grid<TF>&, Fields<TF>&, Input&);
+        Dump(Master&, Grid<TF>&, Fields<TF>&, Io_server&, Input&);
         ~Dump();
 
         void init();
@@ -43,18 +53,67 @@ class Dump
         std::vector<std::string>& get_dumplist();
 
         bool do_dump(unsigned long, unsigned long);
+        bool do_dump_var(const std::string&) const; ///< Whether the variable is in the group of the last do_dump.
         void save_dump(TF*, const std::string&, int);
+        void flush(); ///< Finish the output of the current dump time.
 
     private:
         Master& master;
         Grid<TF>& grid;
         Fields<TF>& fields;
+        Io_server& io_server;
         Field3d_io<TF> field3d_io;
 
         std::vector<std::string> dumplist; // List with all dumps from the ini file.
+        std::vector<std::string> sparselist; // Dumps of which only the non-zero values are saved.
         bool swdump;                       // Statistics on/off switch
         bool swdoubledump;                 // On/off switch for two consecutive dumps in time
         double sampletime;
+        double sampleoffset;
         unsigned long isampletime;
+        unsigned long isampleoffset;
+
+        // The dump list is divided round-robin in nspread groups, of which group n is written
+        // at n*spreadtime after the sample time.
+        int nspread;
+        double spreadtime;
+        unsigned long ispreadtime;
+        std::map<std::string, int> spread_group;
+        int igroup; ///< Group that is due at the time of the last do_dump.
+
+        // Time-appended NetCDF output, one file per variable that is written collectively by all processes.
+        struct Dump_nc_file
+        {
+            std::unique_ptr<Netcdf_file> file;
+            std::unique_ptr<Netcdf_variable<TF>> var;
+            std::unique_ptr<Netcdf_variable<int>> iotime_var;
+            int nrecords;
+        };
+
+        bool swnetcdf;
+        std::map<std::string, Dump_nc_file> nc_files;
+
+        bool swsubset; // Save only a strided box of the fields.
+        bool swfloat;  // Save the fields in single precision.
+        Field3d_subset subset;
+        int coarsen;   // Save the averages over blocks of coarsen x coarsen columns.
+
+        void save_dump_netcdf(TF*, const std::string&, int);
+
+        // Output through an ADIOS2 engine, with a step per dump time that holds all variables.
+        bool swadios2;
+        std::string adios2_engine;
+        std::string adios2_name;
+        std::vector<std::string> adios2_parameters; // Engine parameters as key=value.
+
+        #ifdef USEADIOS2
+        std::unique_ptr<adios2::ADIOS> adios;
+        adios2::IO adios_io;
+        adios2::Engine adios_engine;
+        int adios_iotime; // Time of the open step, -1 if no step is open.
+
+        void open_adios2();
+        void save_dump_adios2(TF*, const std::string&, int);
+        #endif
 };
 #endif
@@ -0,0 +1,98 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DUMP_AVERAGE_H
+#define DUMP_AVERAGE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+class Master;
+class Input;
+template<typename> class Grid;
+template<typename> class Fields;
+template<typename> class Dump;
+template<typename> class Timeloop;
+
+/**
+ * Online time averages of 3D fields.
+ * The prognostic fields in `fields` are sampled every `sampletime`. Their running means and sums
+ * of squared deviations, and those of the pairs in `covariances`, are updated with Welford's
+ * algorithm, which avoids the cancellation of raw second moments. At the end of every averaging
+ * interval, the mean (name_mean), the variance (name_var) and the covariances (name1_name2_cov)
+ * of the interval are written as dumps, named after the time at the end of the interval.
+ * Both fields of a covariance are interpolated to the cell centre, where the covariance is located.
+ * Reads the following parameters from (case).ini file
+ *
+ * [dumpaverage]
+ * swdumpaverage ; enable the time averages
+ * fields        ; prognostic fields to average
+ * covariances   ; pairs of prognostic fields as name1*name2, e.g. w*thl
+ * sampletime    ; interval between the samples (s)
+ * avgtime       ; averaging interval (s), which has to divide the savetime
+ */
+
+template<typename TF>
+class Dump_average
+{
+    public:
+        Dump_average(Master&, Grid<TF>&, Fields<TF>&, Input&);
+        ~Dump_average();
+
+        void init();
+        void create(Timeloop<TF>&);
+
+        unsigned long get_time_limit(unsigned long);
+        bool get_switch() { return swdumpaverage; }
+        bool do_sample(unsigned long);
+
+        void exec(Dump<TF>&, unsigned long, int); ///< Write the finished interval and add the sample.
+
+    private:
+        Master& master;
+        Grid<TF>& grid;
+        Fields<TF>& fields;
+
+        bool swdumpaverage;
+        double sampletime;
+        double avgtime;
+        unsigned long isampletime;
+        unsigned long iavgtime;
+
+        std::vector<std::string> names;
+        std::vector<std::pair<std::string, std::string>> covariances;
+
+        int nsamples; ///< Number of samples in the current interval.
+        std::vector<std::vector<TF>> mean;
+        std::vector<std::vector<TF>> m2; ///< Sum of the squared deviations from the running mean.
+
+        // Running means at the cell centre of the two fields of a covariance,
+        // and the sum of the products of their deviations.
+        std::vector<std::vector<TF>> cov_mean_a;
+        std::vector<std::vector<TF>> cov_mean_b;
+        std::vector<std::vector<TF>> cov_m2;
+
+        void add_sample();
+        void save(Dump<TF>&, int);
+};
+#endif
@@ -23,6 +23,11 @@
 #ifndef FAST_MATH_H
 #define FAST_MATH_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
 // In case the code is compiled with NVCC, add the macros for CUDA
 #ifdef __CUDACC__
 #  define CUDA_MACRO __host__ __device__
@@ -61,5 +66,147 @@ namespace Fast_math
     {
         return a*a*a*a*a*a*a*a*a;
     }
+
+    // The modules of which the transcendental functions are approximated, set with the
+    // FASTMATH list at build time (e.g. -DFASTMATH="microphys;surface;lsm").
+    #ifdef USEFASTMATH_MICROPHYS
+    constexpr bool sw_microphys = true;
+    #else
+    constexpr bool sw_microphys = false;
+    #endif
+
+    #ifdef USEFASTMATH_SURFACE
+    constexpr bool sw_surface = true;
+    #else
+    constexpr bool sw_surface = false;
+    #endif
+
+    #ifdef USEFASTMATH_LSM
+    constexpr bool sw_lsm = true;
+    #else
+    constexpr bool sw_lsm = false;
+    #endif
+
+    // Bit layout of the IEEE 754 types, used to split off and set the exponent, and the range
+    // of the arguments of exp of which 2^n is a normal number and the result does not overflow.
+    template<typename TF> struct Ieee754;
+
+    template<> struct Ieee754<double>
+    {
+        using Int = std::int64_t;
+        static constexpr int nmantissa = 52;
+        static constexpr int bias = 1023;
+        static constexpr double exp_min = -708.3;
+        static constexpr double exp_max =  709.0;
+    };
+
+    template<> struct Ieee754<float>
+    {
+        using Int = std::int32_t;
+        static constexpr int nmantissa = 23;
+        static constexpr int bias = 127;
+        static constexpr float exp_min = -87.3f;
+        static constexpr float exp_max =  88.3f;
+    };
+
+    /**
+     * Exponential as 2^n * exp(r), with |r| <= ln(2)/2 and exp(r) from its degree 7 Taylor polynomial.
+     * The truncation error of the polynomial is below 1e-8, which bounds the relative error in double
+     * precision; in single precision, the rounding limits it to about an ulp (below 5e-7). The argument is
+     * clipped to the range of the type, such that the smallest result is about the smallest normal number
+     * instead of a denormal or zero, and the largest is finite. Without branches or calls, the loops
+     * around it vectorize.
+     */
+    template<typename TF>
+    inline TF exp_approx(const TF x)
+    {
+        using Int = typename Ieee754<TF>::Int;
+
+        constexpr TF log2e = TF(1.4426950408889634);
+        constexpr TF ln2_hi = TF(6.93145751953125e-1);
+        constexpr TF ln2_lo = TF(1.42860682030941723212e-6);
+
+        const TF xc = std::min(std::max(x, TF(Ieee754<TF>::exp_min)), TF(Ieee754<TF>::exp_max));
+        const TF n = std::floor(xc*log2e + TF(0.5));
+        const TF r = (xc - n*ln2_hi) - n*ln2_lo;
+
+        const TF p =
+            TF(1) + r*(TF(1) + r*(TF(1./2.) + r*(TF(1./6.) + r*(TF(1./24.)
+            + r*(TF(1./120.) + r*(TF(1./720.) + r*TF(1./5040.)))))));
+
+        const Int bits = (static_cast<Int>(n) + Ieee754<TF>::bias) << Ieee754<TF>::nmantissa;
+        TF scale;
+        std::memcpy(&scale, &bits, sizeof(TF));
+
+        return p*scale;
+    }
+
+    /**
+     * Natural logarithm of a positive normal number as e*ln(2) + log(m), with sqrt(1/2) <= m < sqrt(2).
+     * log(m) follows from the series of 2*atanh(s) with s = (m-1)/(m+1), of which the terms up
+     * to s^9 give a relative error below 1e-9.
+     */
+    template<typename TF>
+    inline TF log_approx(const TF x)
+    {
+        using Int = typename Ieee754<TF>::Int;
+        constexpr Int mantissa_mask = (Int(1) << Ieee754<TF>::nmantissa) - 1;
+        constexpr Int one_bits = Int(Ieee754<TF>::bias) << Ieee754<TF>::nmantissa;
+        constexpr TF ln2 = TF(6.93147180559945309417e-1);
+
+        Int bits;
+        std::memcpy(&bits, &x, sizeof(TF));
+
+        Int e = (bits >> Ieee754<TF>::nmantissa) - Ieee754<TF>::bias;
+        bits = (bits & mantissa_mask) | one_bits;
+
+        TF m;
+        std::memcpy(&m, &bits, sizeof(TF));
+
+        // Move the mantissa from [1, 2) to [sqrt(1/2), sqrt(2)).
+        const bool is_large = m > TF(1.4142135623730951);
+        m = is_large ? TF(0.5)*m : m;
+        e = is_large ? e+1 : e;
+
+        const TF s = (m - TF(1)) / (m + TF(1));
+        const TF s2 = s*s;
+        const TF log_m =
+            TF(2)*s*(TF(1) + s2*(TF(1./3.) + s2*(TF(1./5.) + s2*(TF(1./7.) + s2*TF(1./9.)))));
+
+        return static_cast<TF>(e)*ln2 + log_m;
+    }
+
+    // Transcendental functions for the modules in the FASTMATH list. The GPU keeps its
+    // own implementations, which have hardware support.
+    template<bool sw_approx, typename TF>
+    CUDA_MACRO inline TF exp(const TF x)
+    {
+        #ifdef __CUDA_ARCH__
+        return std::exp(x);
+        #else
+        return sw_approx ? exp_approx(x) : std::exp(x);
+        #endif
+    }
+
+    template<bool sw_approx, typename TF>
+    CUDA_MACRO inline TF log(const TF x)
+    {
+        #ifdef __CUDA_ARCH__
+        return std::log(x);
+        #else
+        return sw_approx ? log_approx(x) : std::log(x);
+        #endif
+    }
+
+    // Power of a positive base, of which the relative error grows with |b*log(a)|.
+    template<bool sw_approx, typename TF>
+    CUDA_MACRO inline TF pow(const TF a, const TF b)
+    {
+        #ifdef __CUDA_ARCH__
+        return std::pow(a, b);
+        #else
+        return sw_approx ? exp_approx(b*log_approx(a)) : std::pow(a, b);
+        #endif
+    }
 }
 #endif
@@ -27,13 +27,14 @@
 #include "transpose.h"
 
 class Master;
+class Input;
 template<typename> class Grid;
 
 template<typename TF>
 class FFT
 {
     public:
-        FFT(Master&, Grid<TF>&);
+        FFT(Master&, Grid<TF>&, Input&);
         ~FFT();
 
         void exec_forward (TF* const restrict, TF* const restrict);
@@ -56,5 +57,11 @@ class FFT
         fftwf_plan jplanff, jplanbf; // FFTW3 plans for forward and backward transforms in y-direction.
 
         bool has_fftw_plan;
+        unsigned int fftw_flags; // Planner rigour of the FFTW plans.
+
+        int nfftchunks; // Number of chunks of slices in which the FFTs and xy-transposes are pipelined.
+        bool swfftautotune; // Tune the number of chunks at the start of the run.
+
+        void autotune();
 };
 #endif
@@ -43,7 +43,7 @@ class Field3d
                 const std::array<int,3>&);
         ~Field3d();
 
-        int init();
+        int init(const bool swhugepages=false);
 
         // Variables at CPU.
         std::vector<TF> fld;
@@ -61,6 +61,7 @@ class Field3d
         std::string group;
 
         std::array<int,3> loc;
+        std::array<int,2> halo; ///< Width of the ghost cells in x and y that the periodic exchange fills.
 
         TF visc;
 
@@ -23,11 +23,39 @@
 #ifndef FIELD3D_IO_H
 #define FIELD3D_IO_H
 
+#ifdef USEMPI
+#include <mpi.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
 #include "transpose.h"
 
 class Master;
 template<typename> class Grid;
 
+// Handle of a 3D field save of which the writing is still in progress.
+struct Field3d_io_request
+{
+    #ifdef USEMPI
+    MPI_File fh;
+    MPI_Request request;
+    MPI_Datatype subarray;
+    #endif
+};
+
+// Box of global interior indices [start, end) of which every stride-th point is saved.
+struct Field3d_subset
+{
+    int istart, iend;
+    int jstart, jend;
+    int kstart, kend;
+    int stride;
+};
+
 template<typename TF>
 class Field3d_io
 {
@@ -36,15 +64,77 @@ class Field3d_io
         ~Field3d_io();
 
         int save_field3d(TF*, TF*, TF*, const char*, const TF, int, int); // Saves a full 3d field.
+
+        #if defined(USECUDA) && defined(USECUFILE)
+        // Saves a full 3d field from device memory with GPUDirect Storage, in the file-per-rank format.
+        int save_field3d_device(TF*, TF*, const char*, const TF, int, int);
+        #endif
         int load_field3d(TF*, TF*, TF*, const char*, const TF, int, int); // Loads a full 3d field.
 
+        // Starts saving a full 3d field from a buffer that has to stay alive until save_field3d_end.
+        int save_field3d_begin(TF*, TF*, TF*, const char*, const TF, int, int, Field3d_io_request&);
+        int save_field3d_end(Field3d_io_request&);
+
+        // Starts reading a full 3d field into a buffer, load_field3d_end unpacks it into the field,
+        // such that the read of the next field can overlap the unpacking of the current one.
+        int load_field3d_begin(TF*, const char*, int, int, Field3d_io_request&);
+        int load_field3d_end(TF*, TF*, TF*, const TF, int, int, Field3d_io_request&);
+
+        // Per-level checksums of a 3d field that do not depend on the decomposition.
+        std::vector<uint64_t> calc_checksums(const TF*, int, int);
+        int save_checksums(const TF*, const char*, int, int);
+        int check_checksums(const TF*, const char*, int, int);
+        bool has_compression() const { return compress_level > 0; }
+        bool has_file_per_rank() const { return file_per_rank; }
+
+        // Save or load a set of full 3d fields in a single file with a header that indexes the fields by name.
+        int save_restart_file(const std::vector<std::pair<std::string, TF*>>&, TF*, TF*, const char*, int, int);
+        int load_restart_file(const std::vector<std::pair<std::string, TF*>>&, TF*, TF*, const char*, int, int);
+        void set_io_hints(const int, const int); // Sets the striping factor and number of collective buffering nodes.
+        void set_compression(const int, const TF); // Sets the compression level (0 is off) and lossy error bound (0 is lossless).
+        void set_file_per_rank(const bool sw) { file_per_rank = sw; } // Saves and loads every block in a file of its own.
+
+        // Saves a strided box of a 3d field, optionally converted to single precision.
+        int save_field3d_subset(TF*, const char*, const Field3d_subset&, const bool);
+        int save_field3d_coarse(TF*, const char*, const int, const bool); // Saves the averages over blocks of n x n columns.
+
+        // Save only the non-zero values of a 3d field, or of a local block i + j*ni + k*ni*nj that starts at
+        // global index (i0, j0, k0) of a ni_tot x nj_tot domain, as global indices and values.
+        int save_field3d_sparse(TF*, const char*);
+        int save_block_sparse(const std::vector<TF>&, int, int, int, int, int, int, int, int, const char*);
+
         int save_xz_slice(TF*, TF, TF*, const char*, int, int, int); // Saves a xz-slice from a 3d field.
         int save_yz_slice(TF*, TF, TF*, const char*, int, int, int); // Saves a yz-slice from a 3d field.
         int save_xy_slice(TF*, TF, TF*, const char*, int kslice=0);  // Saves a xy-slice from a 3d field.
         int load_xy_slice(TF*, TF*, const char*, int kslice=-1); // Loads a xy-slice.
 
+        // Starts reading a xy-slice into a buffer of imax*jmax elements, load_xy_slice_end unpacks it
+        // into the field, such that the read can overlap the time integration.
+        int load_xy_slice_begin(TF*, const char*, Field3d_io_request&);
+        int load_xy_slice_end(TF*, TF*, Field3d_io_request&, int kslice=-1);
+
     private:
         Master& master;
         Grid<TF>& grid;
+
+        int striping_factor;
+        int cb_nodes;
+
+        #ifdef USEMPI
+        MPI_Info create_restart_info() const; ///< Striping and collective buffering hints of the restart file.
+        #endif
+
+        int compress_level;
+        TF compress_error;
+
+        int save_field3d_compressed(TF*, TF*, TF*, const char*, const TF, int, int);
+        int load_field3d_compressed(TF*, TF*, TF*, const char*, const TF, int, int);
+
+        bool file_per_rank;
+
+        int save_field3d_per_rank(TF*, TF*, const char*, const TF, int, int);
+        int load_field3d_per_rank(TF*, TF*, const char*, const TF, int, int);
+        int save_per_rank_manifest(const char*, int);
+        int check_per_rank_manifest(const char*, int);
 };
 #endif
@@ -23,6 +23,8 @@
 #ifndef FIELD3D_OPERATORS_H
 #define FIELD3D_OPERATORS_H
 
+#include <vector>
+
 #include "field3d.h"
 
 class Master;
@@ -38,6 +40,7 @@ class Field3d_operators
         ~Field3d_operators();
 
         void calc_mean_profile(TF* const, const TF* const); // Calculate mean profile into fld_mean
+        void calc_mean_profiles(const std::vector<TF*>&, const std::vector<const TF*>&); // Mean profiles of several fields in one reduction
         void calc_mean_profile_nogc(TF* const, const TF* const, bool); // Calculate mean profile into fld_mean
         void subtract_mean_profile(TF* const, const TF* const); // Calculate mean profile into fld_mean
         TF calc_mean_2d(const TF* const); // Calculate mean from 2D field
@@ -46,6 +49,7 @@ class Field3d_operators
 
         #ifdef USECUDA
         void calc_mean_profile_g(TF* const, const TF* const); // Calculate mean profile into fld_mean
+        void calc_mean_profiles_g(const std::vector<TF*>&, const std::vector<const TF*>&); // Mean profiles of several fields in one reduction
         TF calc_mean_2d_g(const TF* const); // Calculate mean from 2D (xy) field.
         TF calc_mean_g(const TF* const); // Calculate volume-weighted mean.
         TF calc_max_g(const TF* const);
@@ -84,6 +84,24 @@ class Fields
         void create_cross(Cross<TF>&);    ///< Initialization of the single column output.
 
         void exec();
+
+        // Range of the interior in which a scalar has to be advected and diffused. The box is
+        // closed from below by kstart of the grid and from above by the active top kend.
+        struct Active_box
+        {
+            int istart, iend, jstart, jend, kend;
+        };
+        Active_box get_active_box(const std::string&) const;
+        void update_active_boxes(); ///< Needs the ghost cells of the active box scalars.
+
+        // Slowly varying scalars are diffused only every slowsteps-th time step, with the tendency
+        // scaled by slowsteps, such that the diffusion of the skipped steps is applied at once.
+        bool has_slow_scalars() const { return !slow_steps.empty(); }
+        bool is_slow_skipped(const std::string&) const; ///< Whether the diffusion of the scalar is skipped in this time step.
+        int get_slow_steps_max() const;
+        void begin_slow_tendencies(int); ///< Save the tendencies of the slow scalars that are diffused in this time step.
+        void end_slow_tendencies();      ///< Scale the diffusion tendencies of the slow scalars.
+
         void get_mask(Stats<TF>&, std::string);
         void exec_stats(Stats<TF>&);   ///< Calculate the statistics
         void exec_column(Column<TF>&);   ///< Output the column
@@ -118,9 +136,12 @@ class Fields
         void save(int);
         void load(int);
 
-        TF check_momentum();
-        TF check_tke();
-        TF check_mass();
+        bool get_async_save() const { return swasyncsave; }
+        bool has_device_save() const { return swgds; } ///< The 3D fields are saved from device memory.
+        void save_begin(int); ///< Snapshots the prognostic fields and starts writing them in the background.
+        void save_finish();   ///< Completes all restart writes that are still in progress.
+
+        void check_conservation(TF&, TF&, TF&); ///< Mean momentum, kinetic energy and mass of the first scalar.
 
         bool has_mask(std::string);
 
@@ -146,9 +167,72 @@ class Fields
         Field_2d_map<TF> ap2d; ///< Map containing all prognostic 2D fields.
         Field_2d_map<TF> at2d; ///< Map containing all prognostic 2D field tendencies.
 
+        // Dense registry of the prognostic fields, which is built once all fields are allocated.
+        // Handle n refers to the n-th prognostic field, with the momentum fields first and the scalars
+        // after them, both in the order of their maps. The scalars thus have the handles from
+        // get_scalar_handle_begin() to get_nprog(), in the order of `sp`.
+        int get_handle(const std::string&) const; ///< Resolve a name once, outside of the hot paths.
+        int get_nprog() const { return prog_fields.size(); }
+        int get_scalar_handle_begin() const { return n_momentum_handles; }
+        Field3d<TF>& get_prog(const int h) { return *prog_fields[h]; }
+        Field3d<TF>& get_tend(const int h) { return *prog_tends[h]; }
+        const std::string& get_prog_name(const int h) const { return prog_names[h]; }
+
         std::shared_ptr<Field3d<TF>> get_tmp();
         void release_tmp(std::shared_ptr<Field3d<TF>>&);
 
+        /// Tmp field that is returned to its pool when the handle goes out of scope.
+        class Scoped_tmp
+        {
+            public:
+                Scoped_tmp(Fields<TF>& fieldsin, std::shared_ptr<Field3d<TF>> tmpin, const bool on_devicein) :
+                    fields(fieldsin), tmp(std::move(tmpin)), on_device(on_devicein)
+                {}
+
+                Scoped_tmp(Scoped_tmp&& other) :
+                    fields(other.fields), tmp(std::move(other.tmp)), on_device(other.on_device)
+                {}
+
+                Scoped_tmp(const Scoped_tmp&) = delete;
+                Scoped_tmp& operator=(const Scoped_tmp&) = delete;
+
+                ~Scoped_tmp() { release(); }
+
+                Field3d<TF>* operator->() const { return tmp.get(); }
+                Field3d<TF>& operator*() const { return *tmp; }
+
+                /// Return the field to the pool before the end of the scope.
+                void release()
+                {
+                    if (tmp == nullptr)
+                        return;
+
+                    #ifdef USECUDA
+                    if (on_device)
+                    {
+                        fields.release_tmp_g(tmp);
+                        return;
+                    }
+                    #endif
+
+                    fields.release_tmp(tmp);
+                }
+
+            private:
+                Fields<TF>& fields;
+                std::shared_ptr<Field3d<TF>> tmp;
+                const bool on_device;
+        };
+
+        Scoped_tmp get_scoped_tmp() { return Scoped_tmp(*this, get_tmp(), false); }
+        #ifdef USECUDA
+        Scoped_tmp get_scoped_tmp_g() { return Scoped_tmp(*this, get_tmp_g(), true); }
+        #endif
+
+        /// Free the pooled tmp fields beyond the most that were in use at once since the previous call,
+        /// such that the pools shrink again after a burst of borrows in the output steps. Only with swtrimtmp.
+        void trim_tmp();
+
         std::shared_ptr<std::vector<TF>> get_tmp_xy();
         void release_tmp_xy(std::shared_ptr<std::vector<TF>>&);
 
@@ -157,6 +241,23 @@ class Fields
         void release_tmp_g(std::shared_ptr<Field3d<TF>>&);
         #endif
 
+        /// Field that is shared between modules within a substep, such as the squared strain rate "strain2".
+        /// On return, `is_current` tells whether it has been computed in this substep already. If not,
+        /// the caller has to compute it, after which it counts as current until the next substep.
+        /// The field lives on the device in GPU builds.
+        std::shared_ptr<Field3d<TF>> get_substep_diagnostic(const std::string&, bool& is_current);
+        void set_substep(unsigned long, int); ///< Set the time stamp of the current substep.
+
+        int get_output_snapshots() const { return noutputsnapshots; } ///< Number of host snapshots for the standalone output.
+        int get_free_output_snapshot();        ///< Snapshot that no output task uses, or -1 if all are in use.
+        void set_output_snapshot(int);         ///< Let exec_cross() and exec_dump() read from a snapshot, or from the fields for -1.
+        void release_output_snapshot(int);     ///< Hand back a snapshot of which the output has been written.
+
+        int get_ntmp() const { return ntmp_allocated; }     ///< Number of host tmp fields that are allocated.
+        int get_ntmp_g() const { return ntmp_allocated_g; } ///< Number of device tmp fields that are allocated.
+        int get_ntmp_peak() const { return ntmp_peak; }     ///< Most host tmp fields in use at once.
+        int get_ntmp_peak_g() const { return ntmp_peak_g; } ///< Most device tmp fields in use at once.
+
         std::vector<TF> rhoref;  ///< Reference density at full levels
         std::vector<TF> rhorefh; ///< Reference density at half levels
 
@@ -170,7 +271,9 @@ class Fields
          */
         void prepare_device();  ///< Allocation of all fields at device
         void forward_device();  ///< Copy of all fields from host to device
-        void backward_device(); ///< Copy of all fields required for statistics and output from device to host
+        void backward_device(bool copy_3d=true); ///< Copy of all fields required for statistics and output from device to host, optionally without the 3D fields
+        void backward_device_output(Cross<TF>&, int snapshot=-1); ///< Copy of only the data in the cross-sections and dumps of this class, optionally to an output snapshot
+        bool has_standalone_output() const { return cross_standalone && dump_standalone; } ///< No other class writes cross-sections or dumps
         void clear_device();    ///< Deallocation of all fields at device
 
         void forward_field_device(TF*, TF*, int);  ///< Copy of a single array from host to device
@@ -195,14 +298,93 @@ class Fields
 
         bool calc_mean_profs;
 
+        // Scalars that are only advected and diffused in the box around their non-negligible values.
+        std::vector<std::string> activebox_list;
+        TF activebox_threshold;
+        int activebox_margin;
+        std::map<std::string, Active_box> active_boxes;
+
+        std::map<std::string, int> slow_steps; ///< Number of time steps between the diffusion of a slow scalar.
+        std::map<std::string, std::vector<TF>> slow_tend_start; ///< Tendencies before the diffusion.
+        int slow_iteration;
+
+        // Double-buffered snapshots of the prognostic fields for the asynchronous restarts. A new
+        // restart set is staged in one slot while the previous one drains from the other.
+        struct Save_slot
+        {
+            std::vector<TF> buffer;
+            std::vector<Field3d_io_request> requests;
+            int iotime;
+            bool pending;
+        };
+
+        bool swasyncsave;
+        bool swrestartfile; ///< Write all prognostic fields of a restart time to one file.
+        Save_slot save_slots[2];
+        int save_slot_next;
+
+        void finish_save_slot(Save_slot&);
+
+        bool swchecksum; ///< Write checksums of the restart fields.
+        bool swhugepages; ///< Request transparent huge pages for the 3d fields.
+        bool swgds;       ///< Write the restarts of the 3d fields from the device with GPUDirect Storage.
+        #if defined(USECUDA) && defined(USECUFILE)
+        void save_device(int);
+        #endif
+        int save_checksums(int);
+        void check_checksums(int);
+
         int n_tmp_fields;   ///< Number of temporary fields.
+        int ntmp_allocated;   ///< Number of host tmp fields allocated, including the lazily added ones, minus the trimmed ones.
+        int ntmp_allocated_g; ///< Number of device tmp fields allocated, minus the trimmed ones.
+        bool swtrimtmp;       ///< Shrink the tmp pools in trim_tmp().
+        int ntmp_in_use;      ///< Number of host tmp fields that are borrowed.
+        int ntmp_in_use_g;
+        int ntmp_peak;        ///< Most host tmp fields in use at once during the run.
+        int ntmp_peak_g;
+        int ntmp_peak_trim;   ///< Most host tmp fields in use at once since the previous trim.
+        int ntmp_peak_trim_g;
+        #ifdef USECUDA
+        void trim_tmp_g();
+        #endif
         int n_tmp_fields_xy;   ///< Number of temporary fields.
 
+        std::vector<std::string> prog_names;
+        std::vector<Field3d<TF>*> prog_fields;
+        std::vector<Field3d<TF>*> prog_tends;
+        int n_momentum_handles;
+        void init_registry();
+
         std::vector<std::shared_ptr<Field3d<TF>>> atmp;
         std::vector<std::shared_ptr<Field3d<TF>>> atmp_g;
 
         std::vector<std::shared_ptr<std::vector<TF>>> atmp_xy;
 
+        // Host copies of the fields in the standalone cross-sections and dumps. Every output task
+        // writes from its own copy, such that the next output step does not have to wait for it.
+        struct Output_snapshot
+        {
+            Field_map<TF> a;
+            int busy;
+        };
+
+        int noutputsnapshots;
+        int output_snapshot_active;
+        std::vector<Output_snapshot> output_snapshots;
+        Field_map<TF>& get_output_fields();
+
+        // Diagnostics shared within a substep, stamped with the time and substep of their calculation.
+        struct Substep_diagnostic
+        {
+            std::shared_ptr<Field3d<TF>> fld;
+            unsigned long itime;
+            int substep;
+        };
+
+        std::map<std::string, Substep_diagnostic> substep_diagnostics;
+        unsigned long substep_itime;
+        int substep;
+
         std::mutex tmp_fld_mutex;
         // cross sections
         std::vector<std::string> crosslist; ///< List with all crosses from the ini file.
@@ -217,6 +399,9 @@ class Fields
         std::vector<std::string> cross_fluxtop;
         std::vector<std::string> cross_path;
 
+        bool cross_standalone = true; ///< All cross-sections in the ini file are fields of this class.
+        bool dump_standalone = true;  ///< All dumps in the ini file are fields of this class.
+
         void check_added_cross(
                 const std::string&,
                 const std::string&,
@@ -255,7 +440,7 @@ class Fields
          *Device (GPU) functions and variables
          */
         void forward_field3d_device(Field3d<TF> *);  ///< Copy of a complete Field3d instance from host to device
-        void backward_field3d_device(Field3d<TF> *); ///< Copy of a complete Field3d instance from device to host
+        void backward_field3d_device(Field3d<TF> *); ///< Queue the copy of a complete Field3d instance from device to host
 
         void forward_soil_field3d_device(Soil_field3d<TF> *);  ///< Copy of a complete Soil_field3d instance from host to device
         void backward_soil_field3d_device(Soil_field3d<TF> *); ///< Copy of a complete Soil_field3d instance from device to host
@@ -149,6 +149,58 @@ namespace Force_kernels
             st[ijk] += prof[k];
         }
     };
+
+    // Large-scale source, nudging and subsidence of a single field in one pass over its tendency. The
+    // terms that are not active have a nullptr as profile, and are added in the order of the separate
+    // kernels. With mean subsidence, `s` is the mean profile, otherwise the 3D field.
+    template<typename TF, bool sw_wls_local>
+    struct large_scale_tendencies_g
+    {
+        DEFINE_GRID_KERNEL("force::large_scale_tendencies", 0)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g, const int i, const int j, const int k, const Level level,
+                TF* const __restrict__ st,
+                const TF* const __restrict__ s,
+                const TF* const __restrict__ sls,
+                const TF* const __restrict__ nudge_tend,
+                const TF* const __restrict__ wls,
+                const TF* const __restrict__ dzhi)
+        {
+            const int kk = g.kstride;
+            const int ijk = g(i, j, k);
+
+            TF tend = st[ijk];
+
+            if (sls != nullptr)
+                tend += sls[k];
+
+            if (nudge_tend != nullptr)
+                tend += nudge_tend[k];
+
+            if (wls != nullptr)
+            {
+                if constexpr (sw_wls_local)
+                {
+                    if (wls[k] > TF(0))
+                        tend -= wls[k] * (s[ijk]-s[ijk-kk])*dzhi[k];
+                    else
+                        tend -= wls[k] * (s[ijk+kk]-s[ijk])*dzhi[k+1];
+                }
+                else
+                {
+                    if (wls[k] > TF(0))
+                        tend -= wls[k] * (s[k]-s[k-1])*dzhi[k];
+                    else
+                        tend -= wls[k] * (s[k+1]-s[k])*dzhi[k+1];
+                }
+            }
+
+            st[ijk] = tend;
+        }
+    };
 }
 
 #endif //FORCE_KERNELS_CUH
@@ -66,6 +66,9 @@ struct Grid_data
     int jgc; // Number of ghost cells in the y-direction.
     int kgc; // Number of ghost cells in the z-direction.
 
+    int ihalo; // Width of the ghost cells in the x-direction that the stencils of the time integration read.
+    int jhalo; // Width of the ghost cells in the y-direction that the stencils of the time integration read.
+
     int icells;  // Number of grid cells in the x-direction including ghost cells for one process.
     int jcells;  // Number of grid cells in the y-direction including ghost cells for one process.
     int ijcells; // Number of grid cells in the xy-plane including ghost cells for one process.
@@ -101,6 +104,8 @@ struct Grid_data
     TF dzhi4bot;
     TF dzhi4top;
 
+    bool uniform_z; // Equidistant vertical grid, in which dzi and dzhi are constant over all levels.
+
     std::vector<TF> x;  // Grid coordinate of cell center in x-direction.
     std::vector<TF> y;  // Grid coordinate of cell center in y-direction.
     std::vector<TF> z;  // Grid coordinate of cell center in z-direction.
@@ -163,6 +168,7 @@ class Grid
         Grid_order get_spatial_order() const { return spatial_order; }
 
         void set_minimum_ghost_cells(int, int, int);
+        void set_minimum_padding_cells(int, int, int); ///< Ghost cells that the periodic exchange of the prognostic fields does not need.
 
         // MPI functions
         void init_mpi(); // Creates the MPI data types used in grid operations.
@@ -172,6 +178,11 @@ class Grid
         void interpolate_2nd(TF*, const TF*, const int[3], const int[3]); // Second order interpolation
         void interpolate_4th(TF*, const TF*, const int[3], const int[3]); // Fourth order interpolation
 
+        #ifdef USECUDA
+        void interpolate_2nd_g(TF*, const TF*, const int[3], const int[3]); // Second order interpolation of device fields
+        void interpolate_4th_g(TF*, const TF*, const int[3], const int[3]); // Fourth order interpolation of device fields
+        #endif
+
         void update_time_dependent(Timeloop<TF>&); ///< Update the time dependent parameters.
 
         // GPU functions
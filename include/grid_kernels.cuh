@@ -0,0 +1,75 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef GRID_KERNELS_CUH
+#define GRID_KERNELS_CUH
+
+#include "finite_difference.h"
+#include "cuda_tiling.h"
+
+namespace Grid_kernels
+{
+    // Second order interpolation of `in` at ijk to the location shifted by iih, jjh and kkh, with the
+    // same bottom and top treatment as Grid::interpolate_2nd. The flags mark the first and last level.
+    template<typename TF> CUDA_DEVICE
+    TF interp_2nd(
+            const TF* const __restrict__ in, const int ijk,
+            const int iih, const int jjh, const int kkh,
+            const bool is_bot, const bool is_top)
+    {
+        // Assuming zero at the bottom boundary.
+        if (is_bot && kkh < 0)
+            return TF(0.25)*(TF(0.5)*in[ijk        ] + TF(0.5)*in[ijk+iih    ])
+                 + TF(0.25)*(TF(0.5)*in[ijk    +jjh] + TF(0.5)*in[ijk+iih+jjh]);
+
+        // Assuming a constant gradient at the top boundary.
+        if (is_top && kkh > 0)
+            return TF( 1. )*(TF(0.5)*in[ijk            ] + TF(0.5)*in[ijk+iih        ])
+                 + TF( 1. )*(TF(0.5)*in[ijk    +jjh    ] + TF(0.5)*in[ijk+iih+jjh    ])
+                 - TF(0.5 )*(TF(0.5)*in[ijk        -kkh] + TF(0.5)*in[ijk+iih    -kkh])
+                 - TF(0.5 )*(TF(0.5)*in[ijk    +jjh-kkh] + TF(0.5)*in[ijk+iih+jjh-kkh]);
+
+        return TF(0.25)*(TF(0.5)*in[ijk            ] + TF(0.5)*in[ijk+iih        ])
+             + TF(0.25)*(TF(0.5)*in[ijk    +jjh    ] + TF(0.5)*in[ijk+iih+jjh    ])
+             + TF(0.25)*(TF(0.5)*in[ijk        +kkh] + TF(0.5)*in[ijk+iih    +kkh])
+             + TF(0.25)*(TF(0.5)*in[ijk    +jjh+kkh] + TF(0.5)*in[ijk+iih+jjh+kkh]);
+    }
+
+    // Fourth order horizontal interpolation as in Grid::interpolate_4th, with the shifts of one cell.
+    template<typename TF> CUDA_DEVICE
+    TF interp_4th(
+            const TF* const __restrict__ in, const int ijk,
+            const int iih1, const int jjh1)
+    {
+        using namespace Finite_difference::O4;
+
+        const int iih2 = 2*iih1;
+        const int jjh2 = 2*jjh1;
+
+        return ci0<TF>*(ci0<TF>*in[ijk-iih1-jjh1] + ci1<TF>*in[ijk-jjh1] + ci2<TF>*in[ijk+iih1-jjh1] + ci3<TF>*in[ijk+iih2-jjh1])
+             + ci1<TF>*(ci0<TF>*in[ijk-iih1     ] + ci1<TF>*in[ijk     ] + ci2<TF>*in[ijk+iih1     ] + ci3<TF>*in[ijk+iih2     ])
+             + ci2<TF>*(ci0<TF>*in[ijk-iih1+jjh1] + ci1<TF>*in[ijk+jjh1] + ci2<TF>*in[ijk+iih1+jjh1] + ci3<TF>*in[ijk+iih2+jjh1])
+             + ci3<TF>*(ci0<TF>*in[ijk-iih1+jjh2] + ci1<TF>*in[ijk+jjh2] + ci2<TF>*in[ijk+iih1+jjh2] + ci3<TF>*in[ijk+iih2+jjh2]);
+    }
+}
+#endif
@@ -71,6 +71,11 @@ struct Ghost_cells
     std::vector<TF> c_idw;     // size = number of ghost cells x n_idw_points
     std::vector<TF> c_idw_sum; // size = number of ghost cells
 
+    // Flattened 3D indices of the ghost cells and interpolation points, precomputed
+    // such that the interpolation does not need to rebuild them on every call:
+    std::vector<int> ijk;      // size = number of ghost cells
+    std::vector<int> ip_ijk;   // size = number of ghost cells x n_idw_points
+
     // Spatially varying scalar (and momentum..) boundary conditions
     std::map<std::string, std::vector<TF>> sbot;
     std::vector<TF> mbot;
@@ -155,6 +160,7 @@ class Immersed_boundary
         IB_type sw_ib;
 
         int n_idw_points;       // Number of interpolation points in IDW interpolation
+        bool sw_ghost_cell_cache; // Read the ghost cells from, or write them to, ib_ghost_cells_(loc).(mpiid)
 
         // Boundary conditions for scalars
         Boundary_type sbcbot;
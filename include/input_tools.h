@@ -83,26 +83,32 @@ namespace Input_tools
         return item;
     }
 
-    inline bool get_line_from_input(std::ifstream& infile, std::string& line, Master& master)
+    // Read the entire file on the main process and distribute it with a single broadcast,
+    // such that the other processes do not need a collective per line.
+    inline bool get_file_from_input(const std::string& file_name, std::string& content, Master& master)
     {
-        int has_line = false;
+        int file_size = -1;
         if (master.get_mpiid() == 0)
         {
-            if (std::getline(infile, line))
-                has_line = true;
+            std::ifstream infile(file_name, std::ios::binary);
+            if (infile)
+            {
+                std::ostringstream ss;
+                ss << infile.rdbuf();
+                content = ss.str();
+                file_size = content.size();
+            }
         }
 
-        master.broadcast(&has_line, 1);
-        if (has_line)
-        {
-            // Broadcasting a std::string. This is ugly!
-            int line_size = line.size();
-            master.broadcast(&line_size, 1);
-            if (master.get_mpiid() != 0)
-                line.resize(line_size);
-            master.broadcast(const_cast<char*>(line.data()), line_size);
-        }
-        return has_line;
+        master.broadcast(&file_size, 1);
+        if (file_size < 0)
+            return false;
+
+        if (master.get_mpiid() != 0)
+            content.resize(file_size);
+        master.broadcast(const_cast<char*>(content.data()), file_size);
+
+        return true;
     }
 }
 #endif
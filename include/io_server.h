@@ -0,0 +1,88 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IO_SERVER_H
+#define IO_SERVER_H
+
+#include <string>
+#include <vector>
+#include <list>
+
+#ifdef USEMPI
+#include <mpi.h>
+#endif
+
+class Master;
+
+// Location of a block of data in a binary file with an [nk][nj_tot][ni_tot] layout.
+struct Io_block
+{
+    int ni_tot;
+    int nj_tot;
+    int i0, j0, k0; // Start indices of the block in the file.
+    int ni, nj, nk; // Size of the block.
+    int itemsize;
+    int nparts;     // Number of blocks of all processes together that complete the file.
+};
+
+class Io_server
+{
+    public:
+        Io_server(Master&);
+        ~Io_server();
+
+        bool is_enabled() const;
+
+        // Compute processes: send a packed block to a server and return directly.
+        void write_block(const std::string&, const void*, const Io_block&);
+        void finish();
+
+        // Server processes: write the received blocks until all compute processes have finished.
+        void exec();
+
+    private:
+        Master& master;
+
+        #ifdef USEMPI
+        struct Io_header
+        {
+            char filename[256];
+            Io_block block;
+        };
+
+        struct Pending_send
+        {
+            Io_header header;
+            std::vector<char> data;
+            MPI_Request requests[2];
+        };
+
+        // The blocks are sent from the output tasks, so the list is only accessed in the
+        // critical section io_server_sends.
+        std::list<Pending_send> pending_sends;
+        bool shutdown_sent;
+
+        void clean_pending_sends(bool);
+        void send_shutdown();
+        #endif
+};
+#endif
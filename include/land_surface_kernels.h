@@ -196,7 +196,7 @@ namespace Land_surface_kernels
                 f2[ij] = TF(1)/std::min( TF(1), std::max(TF(1e-9), theta_mean_n[ij]) );
 
                 // f3: reduction vegetation resistance as f(VPD):
-                f3[ij] = TF(1)/exp(-gD[ij] * vpd[ij]);
+                f3[ij] = TF(1)/fm::exp<fm::sw_lsm>(-gD[ij] * vpd[ij]);
 
                 // f2b: reduction soil resistance as f(theta)
                 const TF theta_min = c_veg[ij] * theta_wp[si] + (TF(1)-c_veg[ij]) * theta_res[si];
@@ -270,6 +270,7 @@ namespace Land_surface_kernels
         const int jj = icells;
         const int kk = ijcells;
 
+        #pragma omp parallel for
         for (int j=0; j<jcells; ++j)
             #pragma ivdep
             for (int i=0; i<icells; ++i)
@@ -768,17 +768,26 @@ template<typename TF> __global__
         cuda_safe_call(cudaMemcpy(tile.S_g, tile.S.data(), memsize_tf, cudaMemcpyHostToDevice));
     }
 
+    // Copy the fields of a tile that are part of the restart files.
     template<typename TF>
-    void backward_device_tile(Surface_tile<TF>& tile, const int ijcells)
+    void backward_device_tile_restart(Surface_tile<TF>& tile, const int ijcells)
     {
         const int memsize_tf  = ijcells * sizeof(TF);
-        const int memsize_int = ijcells * sizeof(int);
 
-        cuda_safe_call(cudaMemcpy(tile.fraction.data(), tile.fraction_g, memsize_tf, cudaMemcpyDeviceToHost));
         cuda_safe_call(cudaMemcpy(tile.thl_bot.data(), tile.thl_bot_g, memsize_tf, cudaMemcpyDeviceToHost));
         cuda_safe_call(cudaMemcpy(tile.qt_bot.data(), tile.qt_bot_g, memsize_tf, cudaMemcpyDeviceToHost));
-
         cuda_safe_call(cudaMemcpy(tile.obuk.data(), tile.obuk_g, memsize_tf, cudaMemcpyDeviceToHost));
+    }
+
+    template<typename TF>
+    void backward_device_tile(Surface_tile<TF>& tile, const int ijcells)
+    {
+        const int memsize_tf  = ijcells * sizeof(TF);
+        const int memsize_int = ijcells * sizeof(int);
+
+        backward_device_tile_restart(tile, ijcells);
+
+        cuda_safe_call(cudaMemcpy(tile.fraction.data(), tile.fraction_g, memsize_tf, cudaMemcpyDeviceToHost));
         cuda_safe_call(cudaMemcpy(tile.ustar.data(), tile.ustar_g, memsize_tf, cudaMemcpyDeviceToHost));
         cuda_safe_call(cudaMemcpy(tile.bfluxbot.data(), tile.bfluxbot_g, memsize_tf, cudaMemcpyDeviceToHost));
         cuda_safe_call(cudaMemcpy(tile.ra.data(), tile.ra_g, memsize_tf, cudaMemcpyDeviceToHost));
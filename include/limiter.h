@@ -33,6 +33,7 @@ template<typename> class Grid;
 template<typename> class Fields;
 template<typename> class Stats;
 template<typename> class Diff;
+template<typename> class Timeloop;
 
 template<typename TF>
 class Limiter
@@ -42,7 +43,7 @@ class Limiter
         ~Limiter();                                       // Destructor of the decay class.
 
         void create(Stats<TF>&); // Read the profiles of the forces from the input.
-        void exec(double, Stats<TF>&); // Add the tendencies belonging to the decay processes.
+        void exec(double, Stats<TF>&, Timeloop<TF>&); // Add the tendencies belonging to the decay processes.
 
     private:
         Master& master;
@@ -26,11 +26,24 @@
 #ifdef USEMPI
 #include <mpi.h>
 #endif
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <string>
+#include <thread>
+#include <vector>
 #include "input.h"
 
 class Input;
 
+// Communication sites of which the traffic is counted with swcommstats.
+enum class Comm_site
+{
+    Halo, Halo_2d, Halo_mask,
+    Transpose_zx, Transpose_xz, Transpose_xy, Transpose_yx, Transpose_yz, Transpose_zy,
+    Reduction, Io, Other, Count
+};
+
 struct MPI_data
 {
     int nprocs;
@@ -40,6 +53,9 @@ struct MPI_data
     int mpicoordx;
     int mpicoordy;
 
+    int nioservers; // Number of processes that are reserved as I/O servers.
+    bool ioserver;  // Whether this process is an I/O server.
+
     #ifdef USEMPI
     int nnorth;
     int nsouth;
@@ -49,6 +65,9 @@ struct MPI_data
     MPI_Comm commxy;
     MPI_Comm commx;
     MPI_Comm commy;
+    MPI_Comm commworld; // All processes of the member, including the I/O servers.
+    MPI_Comm commmember; // All processes of the ensemble member, MPI_COMM_WORLD outside of ensembles.
+    MPI_Comm commnode; // Processes of commxy that share the memory of a node.
     #endif
 };
 
@@ -61,8 +80,11 @@ class Master
         void start();
         void init(Input&);
 
+        /// Split the processes into equal groups of consecutive ranks that each run one member, returns the member.
+        int split_ensemble(int);
+
         double get_wall_clock_time();
-        bool at_wall_clock_limit();
+        double get_wall_clock_time_left() { return wall_clock_end - get_wall_clock_time(); }
 
         // Overload the broadcast function.
         void broadcast(char*, int, int mpiid_to_send=0);
@@ -86,6 +108,16 @@ class Master
         void min(double*, int);
         void min(float*, int);
 
+        /// Gather `datasize` values of every process in process order on `mpiid_to_recv`.
+        void gather(const double*, double*, int, int mpiid_to_recv=0);
+
+        // Memory shared by the processes of a node, for read-only tables that are equal on all processes.
+        // The storage is held by the first process of the node. The calls are collective over the node.
+        void* allocate_node_shared(std::size_t, int&); ///< Returns the memory and sets the id of the allocation.
+        void sync_node_shared(int); ///< Make the writes of the first process of the node visible to the others.
+        void free_node_shared(int);
+        bool is_node_root() const { return mpiid_node == 0; }
+
         void print_message(const char *format, ...);
         void print_message(const std::ostringstream&);
         void print_message(const std::string&);
@@ -95,27 +127,73 @@ class Master
         void print_warning(const std::string&);
 
         int get_mpiid() const { return md.mpiid; }
+        bool is_io_server() const { return md.ioserver; }
         const MPI_data& get_MPI_data() const { return md; }
+        int get_npthreads() const { return npthreads; }
+        bool get_packed_transpose() const { return swpackedtranspose; }
+        bool has_thread_multiple() const { return thread_multiple; } ///< Any thread may communicate.
+        double get_mpi_wait_time() const { return mpi_wait_time; } ///< Total time spent in wait_all().
+
+        // Accounting of the sent bytes, messages and wait time per communication site.
+        bool get_comm_stats() const { return swcommstats; }
+        void add_comm(Comm_site, double, int, double wait_time=0.);
+        void print_comm_stats(); ///< Summary over all processes, has to be called by all of them.
 
         #ifdef USEMPI
         MPI_Request* get_request_ptr();
-        void wait_all();
+        void wait_all(Comm_site site=Comm_site::Other);
+        void wait_all(int, MPI_Request*, Comm_site); ///< MPI_Waitall on requests that are not from get_request_ptr().
+        void add_comm(Comm_site, MPI_Datatype, int); ///< Count messages of one element of a datatype.
+
+        // Non-blocking sums, completed with MPI_Wait on the returned request.
+        void sum_begin(double*, int, MPI_Request*);
+        void sum_begin(float*, int, MPI_Request*);
         #endif
 
     private:
         bool initialized;
+        bool owns_mpi; // MPI was started by this class and not by a program that embeds the model.
         bool allocated;
+        bool thread_multiple; // The MPI library provides MPI_THREAD_MULTIPLE.
 
         double wall_clock_start;
         double wall_clock_end;
+        double mpi_wait_time;
+
+        static constexpr int ncomm_sites = static_cast<int>(Comm_site::Count);
+        bool swcommstats;
+        std::array<double, ncomm_sites> comm_bytes;
+        std::array<double, ncomm_sites> comm_messages;
+        std::array<double, ncomm_sites> comm_time;
 
         MPI_data md;
+        int mpiid_node; ///< Rank within the processes of the node.
+        int npthreads;
+        bool swpackedtranspose;
+
+        std::vector<int> get_cpu_affinity() const; ///< CPUs in the affinity mask of this process.
+        static std::string format_cpu_list(const std::vector<int>&);
+        void check_affinity();                     ///< Report the placement and stop on overlapping masks.
 
         #ifdef USEMPI
+        void report_locality(); ///< Report the fraction of the transpose partners on the same node.
+
+        // A thread that calls into the MPI library at a fixed interval, such that the non-blocking
+        // communication progresses while the other threads compute.
+        std::thread progress_thread;
+        std::atomic<bool> progress_stop;
+        MPI_Comm commprogress;
+        void start_progress_thread(int);
+        void stop_progress_thread();
+
         MPI_Request* reqs;
         int reqsn;
 
+        std::vector<MPI_Win> node_windows;
+
         int check_error(int);
+        #else
+        std::vector<std::vector<char>> node_buffers;
         #endif
 };
 #endif
@@ -0,0 +1,64 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+class Master;
+
+/**
+ * Memory allocated by the modules during their initialization.
+ * The host and device memory in use is sampled around each tracked call, such that the
+ * difference is attributed to the module without the need to register every allocation.
+ * The host memory is the heap in use according to glibc, the device memory the memory
+ * allocated through cuda_raw_buffer. The tmp fields, which are allocated lazily, are
+ * reported separately together with the peak memory of the run.
+ */
+class Memory_tracker
+{
+    public:
+        explicit Memory_tracker(Master&);
+
+        void track(const std::string&, const std::function<void()>&); ///< Attribute the memory allocated in the call to a module.
+
+        void print(); ///< Breakdown per module over all processes, has to be called by all of them.
+        void print_peak(int, int, int, int); ///< Peak memory of the run, and the number of host and device tmp fields allocated and in use at once.
+
+    private:
+        Master& master;
+
+        struct Module
+        {
+            double host_bytes;
+            double device_bytes;
+        };
+
+        std::vector<std::string> names; ///< Modules in order of their first use.
+        std::map<std::string, Module> modules;
+};
+#endif
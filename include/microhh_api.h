@@ -0,0 +1,78 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MICROHH_API_H
+#define MICROHH_API_H
+
+/**
+ * C interface to run MicroHH as a library inside a coupled program.
+ * The model is created from the same command line as the executable. It is then advanced
+ * a number of time steps at a time. In between, the fields can be read and modified in place
+ * through views, of which the pointers point to the arrays of the model itself: host memory
+ * in CPU builds and device memory in GPU builds. The view of a prognostic field includes its
+ * tendency, to which a coupled component can add from the tendency callback, in every substep.
+ * The arrays are in the precision of the build (itemsize), with the i-index running fastest.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct Microhh_model Microhh_model;
+
+typedef struct
+{
+    void* data;    // Field including the ghost cells.
+    void* tend;    // Tendency of a prognostic field, NULL otherwise.
+    int itemsize;  // Size in bytes of a value.
+    int on_device; // The pointers refer to GPU memory.
+
+    int icells, jcells, kcells; // Dimensions of the local block, including the ghost cells.
+    int istart, iend;           // Interior of the local block.
+    int jstart, jend;
+    int kstart, kend;
+    int i0, j0;                 // Global index of the first interior point of the block.
+    int loc[3];                 // Staggered location, 1 at the cell face in that direction.
+} Microhh_field_view;
+
+/// Create, initialize and load the model as in the executable, returns NULL on error.
+Microhh_model* microhh_create(int argc, char** argv);
+
+/// Run at most nsteps time steps, returns 1 if the run continues, 0 if it is finished and -1 on error.
+int microhh_advance(Microhh_model*, int nsteps);
+
+/// Fill the view of a field, returns 0 on success and -1 if the field does not exist.
+int microhh_get_field(Microhh_model*, const char* name, Microhh_field_view*);
+
+/// Simulated time in seconds.
+double microhh_get_time(Microhh_model*);
+
+/// Function called in every substep before the forcings, to add to the tendencies.
+void microhh_set_tendency_callback(Microhh_model*, void (*callback)(void*), void* user_data);
+
+/// Finish the run, write the pending output and free the model.
+void microhh_destroy(Microhh_model*);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
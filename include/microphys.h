@@ -57,6 +57,11 @@ class Microphys
         virtual void create(Input&, Netcdf_handle&, Stats<TF>&, Cross<TF>&, Dump<TF>&, Column<TF>&) = 0;
         virtual unsigned long get_time_limit(unsigned long, double) = 0;
 
+        // Split of get_time_limit() for the fused time step limit in Model, that reduces all limits at once.
+        // By default, there is no local number and the limit does not depend on it.
+        virtual double get_sedimentation_cfl_local(double) { return 0.; }
+        virtual unsigned long get_time_limit_from_cfl(unsigned long idt, double dt, double) { return get_time_limit(idt, dt); }
+
         virtual void exec(Thermo<TF>&, const double, Stats<TF>&) = 0;
         virtual void exec_stats(Stats<TF>&, Thermo<TF>&, const double) = 0; ///< Calculate the statistics
         virtual void exec_column(Column<TF>&) = 0;
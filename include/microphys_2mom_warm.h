@@ -34,6 +34,7 @@
 
 #include "microphys.h"
 #include "field3d_operators.h"
+#include "fast_math.h"
 
 class Master;
 class Input;
@@ -96,7 +97,7 @@ namespace Micro_2mom_warm_functions
     template<typename TF> CUDA_MACRO
     inline TF calc_rain_diameter(const TF mr)
     {
-        return pow(mr/pirhow<TF>, TF(1.)/TF(3.));
+        return Fast_math::pow<Fast_math::sw_microphys>(mr/pirhow<TF>, TF(1.)/TF(3.));
     }
 
     // Shape parameter mu_r
@@ -112,7 +113,7 @@ namespace Micro_2mom_warm_functions
     template<typename TF> CUDA_MACRO
     inline TF calc_lambda_r(const TF mur, const TF dr)
     {
-        return pow((mur+3)*(mur+2)*(mur+1), TF(1.)/TF(3.)) / dr;
+        return Fast_math::pow<Fast_math::sw_microphys>((mur+3)*(mur+2)*(mur+1), TF(1.)/TF(3.)) / dr;
     }
 
     template<typename TF> CUDA_MACRO
@@ -171,6 +172,10 @@ class Microphys_2mom_warm : public Microphys<TF>
         TF get_Ni0() { return static_cast<TF>(1e5); } // CvH: this is a temporary fix with previous default value, Ni0 is 3D in tomita!
 
         unsigned long get_time_limit(unsigned long, double);
+        #ifndef USECUDA
+        double get_sedimentation_cfl_local(double);
+        unsigned long get_time_limit_from_cfl(unsigned long, double, double);
+        #endif
 
         #ifdef USECUDA
         void get_surface_rain_rate_g(TF*);
@@ -188,12 +193,20 @@ class Microphys_2mom_warm : public Microphys<TF>
 
         bool swmicrobudget;     // Output full microphysics budget terms
         TF cflmax;              // Max CFL number in microphysics sedimentation
+        bool swsedimentsubcycle; // Sub-cycle the sedimentation instead of limiting the time step
 
         std::vector<std::string> crosslist;                  // Cross-sections handled by this class
         std::vector<std::string> available_masks = {"qr"};   // Vector with the masks that fields can provide
 
         TF Nc0; // Cloud droplet number concentration.
 
+        void sedimentation_subcycled(
+                std::vector<std::shared_ptr<Field3d<TF>>>&, std::vector<TF>&,
+                TF* const, TF* const, TF* const, TF* const,
+                TF* const, TF* const, TF* const, TF* const,
+                TF* const, TF* const, TF* const, TF* const,
+                const double, const int, const int);
+
         // Surface precipitation statistics
         std::vector<TF> rr_bot;   // 2D surface sedimentation flux (kg m-2 s-1 == mm s-1)
 
@@ -73,6 +73,10 @@ class Microphys_nsw6 : public Microphys<TF>
         TF get_Ni0() { return static_cast<TF>(1e5); } // CvH: this is a temporary fix with previous default value, Ni0 is 3D in tomita!
 
         unsigned long get_time_limit(unsigned long, double);
+        #ifndef USECUDA
+        double get_sedimentation_cfl_local(double);
+        unsigned long get_time_limit_from_cfl(unsigned long, double, double);
+        #endif
 
         #ifdef USECUDA
         void get_surface_rain_rate_g(TF*);
@@ -90,6 +94,7 @@ class Microphys_nsw6 : public Microphys<TF>
 
         bool swmicrobudget;     // Output full microphysics budget terms
         double cflmax;          // Max CFL number in microphysics sedimentation
+        bool swsedimentsubcycle; // Sub-cycle the sedimentation instead of limiting the time step
 
         std::vector<std::string> crosslist; // Cross-sections handled by this class
 
@@ -107,6 +112,7 @@ class Microphys_nsw6 : public Microphys<TF>
         TF* rr_bot_g;
         TF* rs_bot_g;
         TF* rg_bot_g;
+        int* species_present_g; // Rain, snow and graupel present in the domain (bits 0, 1, 2).
         #endif
 
 };
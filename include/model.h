@@ -25,9 +25,14 @@
 
 #include <string>
 #include <memory>
+#include <functional>
 
 class Master;
 class Input;
+class Io_server;
+class Cuda_graph;
+class Timer;
+class Memory_tracker;
 class Data_block;
 class Netcdf_file;
 
@@ -41,12 +46,14 @@ template<typename> class Boundary;
 template<typename> class Immersed_boundary;
 template<typename> class Buffer;
 template<typename> class Advec;
+template<typename> class Advec_split;
 template<typename> class Diff;
 template<typename> class Pres;
 template<typename> class Force;
 template<typename> class Aerosol;
 template<typename> class Background;
 template<typename> class Particle_bin;
+template<typename> class Particles;
 template<typename> class Thermo;
 template<typename> class Microphys;
 template<typename> class Radiation;
@@ -62,6 +69,12 @@ template<typename> class Budget;
 template<typename> class Column;
 template<typename> class Cross;
 template<typename> class Dump;
+template<typename> class Dump_average;
+template<typename> class Quicklook;
+template<typename> class Checkpoint;
+template<typename> class Objects;
+template<typename> class Spectra;
+template<typename> class Spectral_nudge;
 
 enum class Sim_mode;
 
@@ -76,6 +89,18 @@ class Model
         void load_or_save();
         void exec();
 
+        // Library mode, see microhh_api.h: exec() in parts, with in-memory access to the fields in between.
+        void start_exec();
+        bool advance(int); ///< Run at most n time steps (all if n <= 0), returns false once the run is finished.
+        void finish_exec();
+
+        /// Function that adds the tendencies of a coupled component, called in every substep before the forcings.
+        void set_external_tendency(std::function<void()> f) { external_tendency = f; }
+
+        Grid<TF>& get_grid() { return *grid; }
+        Fields<TF>& get_fields() { return *fields; }
+        Timeloop<TF>& get_timeloop() { return *timeloop; }
+
     private:
         Master& master;
 
@@ -95,6 +120,7 @@ class Model
         std::shared_ptr<Immersed_boundary<TF>> ib;
         std::shared_ptr<Buffer<TF>> buffer;
         std::shared_ptr<Advec<TF>> advec;
+        std::shared_ptr<Advec_split<TF>> advec_split;
         std::shared_ptr<Diff<TF>> diff;
         std::shared_ptr<Pres<TF>> pres;
         std::shared_ptr<Force<TF>> force;
@@ -110,18 +136,46 @@ class Model
         std::shared_ptr<Source<TF>> source;
 
         std::shared_ptr<Particle_bin<TF>> particle_bin;
+        std::shared_ptr<Particles<TF>> particles;
         std::shared_ptr<Windfarm<TF>> windfarm;
+        std::shared_ptr<Spectral_nudge<TF>> spectral_nudge;
 
         std::shared_ptr<Stats<TF>> stats;
         std::shared_ptr<Budget<TF>> budget;
         std::shared_ptr<Column<TF>> column;
         std::shared_ptr<Cross<TF>> cross;
         std::shared_ptr<Dump<TF>> dump;
+        std::shared_ptr<Dump_average<TF>> dump_average;
+        std::shared_ptr<Quicklook<TF>> quicklook;
+        std::shared_ptr<Checkpoint<TF>> checkpoint;
+        std::shared_ptr<Objects<TF>> objects;
+        std::shared_ptr<Spectra<TF>> spectra;
+        std::shared_ptr<Io_server> io_server;
+        std::shared_ptr<Timer> timer;
+        std::shared_ptr<Memory_tracker> memory;
+
+        #ifdef USECUDA
+        std::shared_ptr<Cuda_graph> cuda_graph;
+        bool swcudamempool;
+        bool swcudamanaged;
+        #endif
 
         Sim_mode sim_mode;
         std::string sim_name;
         bool cpu_up_to_date = false;
 
+        bool exec_started = false;
+        bool exec_finished = false;
+        int nthreads_out = 1;           // Threads of the parallel region around the time loop.
+        bool defer_output_tasks = true; // Run the statistics and save tasks in the background.
+        std::function<void()> external_tendency;
+
+        // CFL and diffusion number per unit time step from the last set_time_step(), for the status output.
+        bool has_stability = false;
+        unsigned long stability_itime = 0;
+        double cfl_per_dt = 0.;
+        double dn_per_dt = 0.;
+
         void load();
         void save();
 
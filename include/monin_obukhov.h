@@ -44,7 +44,7 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF phim_unstable(const TF zeta)
     {
         // Wilson, 2001 functions, see Wyngaard, page 222.
-        return std::pow(TF(1.) + TF(3.6)*std::pow(std::abs(zeta), TF(2./3.)), TF(-1./2.));
+        return fm::pow<fm::sw_surface>(TF(1.) + TF(3.6)*fm::pow<fm::sw_surface>(std::abs(zeta), TF(2./3.)), TF(-1./2.));
     }
 
     template<typename TF>
@@ -67,7 +67,7 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF phih_unstable(const TF zeta)
     {
         // Wilson, 2001 functions, see Wyngaard, page 222.
-        return std::pow(TF(1.) + TF(7.9)*std::pow(std::abs(zeta), TF(2./3.)), TF(-1./2.));
+        return fm::pow<fm::sw_surface>(TF(1.) + TF(7.9)*fm::pow<fm::sw_surface>(std::abs(zeta), TF(2./3.)), TF(-1./2.));
     }
 
     template<typename TF>
@@ -93,7 +93,7 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF psim_unstable(const TF zeta)
     {
         // Wilson, 2001 functions, see Wyngaard, page 222.
-        return TF(3.)*std::log( ( TF(1.) + TF(1.)/phim_unstable(zeta) ) / TF(2.));
+        return TF(3.)*fm::log<fm::sw_surface>( ( TF(1.) + TF(1.)/phim_unstable(zeta) ) / TF(2.));
     }
 
     template<typename TF>
@@ -108,14 +108,14 @@ namespace Monin_obukhov
         constexpr TF c = TF(5);
         constexpr TF d = TF(0.35);
 
-        return -b * (zeta - (c/d)) * std::exp(-d * zeta) - a*zeta - (b*c)/d;
+        return -b * (zeta - (c/d)) * fm::exp<fm::sw_surface>(-d * zeta) - a*zeta - (b*c)/d;
     }
 
     template<typename TF>
     CUDA_MACRO inline TF psih_unstable(const TF zeta)
     {
         // Wilson, 2001 functions, see Wyngaard, page 222.
-        return TF(3.) * std::log( ( TF(1.) + TF(1.) / phih_unstable(zeta) ) / TF(2.));
+        return TF(3.) * fm::log<fm::sw_surface>( ( TF(1.) + TF(1.) / phih_unstable(zeta) ) / TF(2.));
     }
 
     template<typename TF>
@@ -130,7 +130,7 @@ namespace Monin_obukhov
         constexpr TF c = TF(5);
         constexpr TF d = TF(0.35);
 
-        return -b * (zeta - (c/d)) * std::exp(-d * zeta) - std::pow(TF(1)+ b*a*zeta, TF(1.5)) -(b*c)/d + TF(1);
+        return -b * (zeta - (c/d)) * fm::exp<fm::sw_surface>(-d * zeta) - fm::pow<fm::sw_surface>(TF(1)+ b*a*zeta, TF(1.5)) -(b*c)/d + TF(1);
 
     }
 
@@ -138,16 +138,16 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF fm(const TF zsl, const TF z0m, const TF L)
     {
         return (L <= TF(0.))
-            ? Constants::kappa<TF> / (std::log(zsl/z0m) - psim_unstable(zsl/L) + psim_unstable(z0m/L))
-            : Constants::kappa<TF> / (std::log(zsl/z0m) - psim_stable  (zsl/L) + psim_stable  (z0m/L));
+            ? Constants::kappa<TF> / (fm::log<fm::sw_surface>(zsl/z0m) - psim_unstable(zsl/L) + psim_unstable(z0m/L))
+            : Constants::kappa<TF> / (fm::log<fm::sw_surface>(zsl/z0m) - psim_stable  (zsl/L) + psim_stable  (z0m/L));
     }
 
     template<typename TF>
     CUDA_MACRO inline TF fh(const TF zsl, const TF z0h, const TF L)
     {
         return (L <= TF(0.))
-            ? Constants::kappa<TF> / (std::log(zsl/z0h) - psih_unstable(zsl/L) + psih_unstable(z0h/L))
-            : Constants::kappa<TF> / (std::log(zsl/z0h) - psih_stable  (zsl/L) + psih_stable  (z0h/L));
+            ? Constants::kappa<TF> / (fm::log<fm::sw_surface>(zsl/z0h) - psih_unstable(zsl/L) + psih_unstable(z0h/L))
+            : Constants::kappa<TF> / (fm::log<fm::sw_surface>(zsl/z0h) - psih_stable  (zsl/L) + psih_stable  (z0h/L));
     }
 }
 #endif
@@ -89,7 +89,8 @@ class Netcdf_handle
         template<typename T>
         Netcdf_variable<T> add_variable(
                 const std::string&,
-                const std::vector<std::string>&);
+                const std::vector<std::string>&,
+                const std::vector<int>& chunk_sizes = {});
 
         template<typename T>
         T get_variable(
@@ -139,21 +140,31 @@ class Netcdf_handle
 
         virtual int get_dim_id(const std::string&) = 0;
 
+        bool is_parallel() const { return parallel; }
+
     protected:
         Master& master;
         Netcdf_handle* parent;
+        bool parallel; ///< All processes access the file collectively.
         int mpiid_to_write;
         int ncid;
         int root_ncid;
         std::map<std::string, int> dims;
         std::map<std::string, Netcdf_group> groups;
         int record_counter;
+
+        /// First error of the puts since the last check, held by the file of the handle.
+        int deferred_error;
+
+        bool is_writer() const;
+        void defer_error(const int);
+        void check_deferred_error(int);
 };
 
 class Netcdf_file : public Netcdf_handle
 {
     public:
-        Netcdf_file(Master&, const std::string&, Netcdf_mode, const int mpiid_to_write_int=0);
+        Netcdf_file(Master&, const std::string&, Netcdf_mode, const int mpiid_to_write_int=0, const bool parallel=false);
         virtual ~Netcdf_file();
 
         // Do not allow copying or moving of file
@@ -0,0 +1,80 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NODE_SHARED_VECTOR_H
+#define NODE_SHARED_VECTOR_H
+
+#include <cstddef>
+#include "master.h"
+
+/**
+ * Array of read-only data that is equal on all processes, of which there is a single copy per node.
+ * The memory is held by the first process of the node, which is the only one that writes to it,
+ * after which sync() makes the data visible to the other processes of the node. Resizing, syncing
+ * and destruction are collective over the processes of a node, such that all of them have to
+ * create their vectors in the same order.
+ */
+template<typename T>
+class Node_shared_vector
+{
+    public:
+        Node_shared_vector() : master(nullptr), ptr(nullptr), n(0), id(-1) {}
+        ~Node_shared_vector() { release(); }
+
+        Node_shared_vector(const Node_shared_vector&) = delete;
+        Node_shared_vector& operator=(const Node_shared_vector&) = delete;
+
+        /// Allocate uninitialized memory for `n` elements, which replaces the previous contents.
+        void resize(Master& masterin, const std::size_t nin)
+        {
+            release();
+            master = &masterin;
+            n = nin;
+            ptr = static_cast<T*>(master->allocate_node_shared(n*sizeof(T), id));
+        }
+
+        bool is_writer() const { return master->is_node_root(); }
+        void sync() { master->sync_node_shared(id); }
+
+        T* data() { return ptr; }
+        const T* data() const { return ptr; }
+        std::size_t size() const { return n; }
+
+        T& operator[](const std::size_t i) { return ptr[i]; }
+        const T& operator[](const std::size_t i) const { return ptr[i]; }
+
+    private:
+        Master* master;
+        T* ptr;
+        std::size_t n;
+        int id;
+
+        void release()
+        {
+            if (id >= 0)
+                master->free_node_shared(id);
+            ptr = nullptr;
+            n = 0;
+            id = -1;
+        }
+};
+#endif
@@ -0,0 +1,54 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NVTX_RANGE_H
+#define NVTX_RANGE_H
+
+#ifdef USENVTX
+#include <nvtx3/nvToolsExt.h>
+#endif
+
+/**
+ * Named range that shows up in the timeline of Nsight Systems for the lifetime of the object.
+ * The ranges are only pushed in builds with USENVTX, otherwise the object compiles away.
+ */
+class Nvtx_range
+{
+    public:
+        explicit Nvtx_range(const char* name)
+        {
+            #ifdef USENVTX
+            nvtxRangePushA(name);
+            #endif
+        }
+
+        ~Nvtx_range()
+        {
+            #ifdef USENVTX
+            nvtxRangePop();
+            #endif
+        }
+
+        Nvtx_range(const Nvtx_range&) = delete;
+        Nvtx_range& operator=(const Nvtx_range&) = delete;
+};
+#endif
@@ -0,0 +1,108 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECTS_H
+#define OBJECTS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "boundary_cyclic.h"
+
+class Master;
+class Input;
+class Netcdf_file;
+template<typename> class Grid;
+template<typename> class Fields;
+template<typename> class Stats;
+template<typename> class Timeloop;
+template<typename> class Netcdf_variable;
+
+// Labels the connected objects (clouds, cores, thermals) of the statistics masks across all
+// processes and writes their size, base, top, mass flux and the lifetime of their track.
+template<typename TF>
+class Objects
+{
+    public:
+        Objects(Master&, Grid<TF>&, Fields<TF>&, Input&);
+        ~Objects();
+
+        void init();
+        void create(const Timeloop<TF>&, Stats<TF>&, const std::string&);
+
+        unsigned long get_time_limit(unsigned long);
+        bool get_switch() { return swobjects; }
+        bool do_objects(unsigned long);
+
+        void exec(Stats<TF>&, const double);
+
+    private:
+        Master& master;
+        Grid<TF>& grid;
+        Fields<TF>& fields;
+        Boundary_cyclic<TF> boundary_cyclic;
+
+        bool swobjects;
+        double sampletime;
+        unsigned long isampletime;
+        unsigned long isampleoffset; ///< Offset of the statistics, at which the objects are sampled.
+        int nmin; ///< Minimum number of grid points of an object that is written.
+
+        // Properties of one object, summed over its grid points.
+        struct Object
+        {
+            double npoints;
+            double volume;
+            double base;
+            double top;
+            double rhow;
+        };
+
+        struct Object_mask
+        {
+            std::vector<unsigned int> labels;      ///< Object label per grid point, 0 outside the mask.
+            std::vector<unsigned int> labels_prev; ///< Labels of the previous sample, used for the tracking.
+
+            // Tracking state, only used on the process that writes.
+            std::map<unsigned int, int> tracks_prev; ///< Track of each object of the previous sample.
+            std::map<int, double> track_start;       ///< Time at which each track started.
+            int ntracks;
+            bool has_prev;
+
+            std::unique_ptr<Netcdf_file> data_file;
+            std::map<std::string, std::unique_ptr<Netcdf_variable<TF>>> vars;
+            std::unique_ptr<Netcdf_variable<int>> track_var;
+            int nrecords;
+        };
+
+        std::vector<std::string> masklist;
+        std::map<std::string, Object_mask> object_masks;
+
+        void label_objects(std::vector<unsigned int>&, const std::vector<unsigned int>&, const unsigned int);
+        void calc_objects(std::map<unsigned int, Object>&, const std::vector<unsigned int>&);
+        void calc_overlap(std::map<std::pair<unsigned int, unsigned int>, int>&, const Object_mask&);
+        void track_objects(Object_mask&, const std::map<unsigned int, Object>&,
+                const std::map<std::pair<unsigned int, unsigned int>, int>&, const double);
+};
+#endif
@@ -23,12 +23,17 @@
 #ifndef PARTICLE_BIN_H
 #define PARTICLE_BIN_H
 
+#include <map>
+#include <set>
+#include <string>
+
 class Master;
 class Input;
 template<typename> class Grid;
 template<typename> class Fields;
 template<typename> class Stats;
 template<typename> class Timeloop;
+template<typename> class Advec;
 
 template<typename TF>
 class Particle_bin
@@ -38,7 +43,7 @@ class Particle_bin
         ~Particle_bin();
 
         void exec(Stats<TF>&);
-        void create(Timeloop<TF>&);
+        void create(Timeloop<TF>&, Advec<TF>&);
         unsigned long get_time_limit();
 
     private:
@@ -52,5 +57,8 @@ class Particle_bin
 
         // Gravitational settling velocities, negative downward.
         std::map<std::string, TF> w_particle;
+
+        bool sw_advec; ///< Switch to add the settling velocities to the vertical velocity in the advection.
+        std::set<std::string> in_advec; ///< Scalars of which the advection applies the settling.
 };
 #endif
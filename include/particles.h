@@ -0,0 +1,112 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <array>
+#include <vector>
+
+#include "cuda_buffer.h"
+
+class Master;
+class Input;
+template<typename> class Grid;
+template<typename> class Fields;
+template<typename> class Timeloop;
+
+/**
+ * Lagrangian particle tracker.
+ * Particles are advected with the trilinearly interpolated velocity, either as passive
+ * tracers or as inertial particles with a response time and gravitational settling.
+ * Their positions are integrated with the low-storage Runge-Kutta scheme of the fields.
+ * Reads the following parameters from (case).ini file
+ *
+ * [particles]
+ * swparticles  ; enable the particle tracker
+ * nparticles   ; total number of particles
+ * seed         ; seed of the random initial positions
+ * x0, x1       ; bounds of the release box in x (m), default whole domain
+ * y0, y1       ; bounds of the release box in y (m), default whole domain
+ * z0, z1       ; bounds of the release box in z (m), default whole domain
+ * tau          ; response time (s), 0 for passive tracers
+ * sampletime   ; output interval of the positions (s)
+ */
+
+template<typename TF>
+class Particles
+{
+    public:
+        Particles(Master&, Grid<TF>&, Fields<TF>&, Input&);
+        ~Particles();
+
+        void create(Timeloop<TF>&);
+        void create_cold_start();   ///< Release the particles at random positions in the release box.
+
+        void exec(Timeloop<TF>&);   ///< Advance the particles over one substep.
+
+        bool do_output(unsigned long);
+        unsigned long get_time_limit(unsigned long);
+
+        void save(int);
+        void load(int);
+
+        #ifdef USECUDA
+        void prepare_device();
+        void clear_device();
+        void forward_device();
+        void backward_device();
+        #endif
+
+    private:
+        Master& master;
+        Grid<TF>& grid;
+        Fields<TF>& fields;
+
+        // Far more particles than ranks give a reasonable load balance, so the
+        // positions are kept as a structure-of-arrays of the local particles.
+        enum Particle_var {X=0, Y, Z, U, V, W, Xt, Yt, Zt, Ut, Vt, Wt, n_vars};
+        static constexpr int n_out_vars = 6; ///< Positions and velocities in the output.
+
+        bool swparticles;
+        int nparticles;
+        int seed;
+        TF x0, x1, y0, y1, z0, z1;
+        TF tau;
+        double sampletime;
+        unsigned long isampletime;
+
+        int np;                  ///< Number of particles on this rank.
+        std::vector<int> id;
+        std::array<std::vector<TF>, n_vars> var;
+
+        int count_misplaced(bool) const;
+        void exchange(bool);
+        void migrate();
+
+        #ifdef USECUDA
+        int np_capacity;         ///< Number of particles that fit in the device buffers.
+        cuda_vector<TF> var_g;   ///< All variables, with a stride of `np_capacity`.
+        cuda_vector<int> nmisplaced_g;
+        #endif
+};
+#endif
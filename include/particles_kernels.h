@@ -0,0 +1,156 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PARTICLES_KERNELS_H
+#define PARTICLES_KERNELS_H
+
+#include <cmath>
+#include "fast_math.h"
+
+namespace Particles_kernels
+{
+    // Index of the last level of `z` at or below `zp`, searched in [kstart-1, kend-1].
+    template<typename TF> CUDA_MACRO inline
+    int find_level(const TF* const z, const int kstart, const int kend, const TF zp)
+    {
+        int lo = kstart-1;
+        int hi = kend;
+
+        while (hi-lo > 1)
+        {
+            const int mid = (lo+hi)/2;
+            if (z[mid] <= zp)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    template<typename TF> CUDA_MACRO inline
+    TF trilinear(
+            const TF* const fld, const int ijk,
+            const TF fx, const TF fy, const TF fz,
+            const int jj, const int kk)
+    {
+        const TF f00 = (TF(1)-fx)*fld[ijk      ] + fx*fld[ijk+1      ];
+        const TF f10 = (TF(1)-fx)*fld[ijk+jj   ] + fx*fld[ijk+1+jj   ];
+        const TF f01 = (TF(1)-fx)*fld[ijk   +kk] + fx*fld[ijk+1   +kk];
+        const TF f11 = (TF(1)-fx)*fld[ijk+jj+kk] + fx*fld[ijk+1+jj+kk];
+
+        return (TF(1)-fz)*((TF(1)-fy)*f00 + fy*f10)
+             +        fz *((TF(1)-fy)*f01 + fy*f11);
+    }
+
+    // Interpolate one velocity component to the particle position. The offsets `ox` and `oy`
+    // are 0 for a component located at the cell faces, and 0.5 at the cell centers.
+    template<typename TF> CUDA_MACRO inline
+    TF interpolate(
+            const TF* const fld, const TF* const z,
+            const TF xp, const TF yp, const TF zp,
+            const TF xstart, const TF ystart, const TF ox, const TF oy,
+            const TF dxi, const TF dyi,
+            const int istart, const int iend, const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        const TF xi = (xp-xstart)*dxi - ox;
+        const TF yj = (yp-ystart)*dyi - oy;
+
+        // Clip round-off at the east and north edge of the subdomain.
+        const int ic = istart + static_cast<int>(floor(xi));
+        const int jc = jstart + static_cast<int>(floor(yj));
+        const int i = (ic < iend) ? ic : iend-1;
+        const int j = (jc < jend) ? jc : jend-1;
+        const int k = find_level(z, kstart, kend, zp);
+
+        const TF fx = xi - (i-istart);
+        const TF fy = yj - (j-jstart);
+        const TF fz = (zp-z[k]) / (z[k+1]-z[k]);
+
+        return trilinear(fld, i + j*jj + k*kk, fx, fy, fz, jj, kk);
+    }
+
+    // Low-storage Runge-Kutta substep of one particle. Passive particles move with the fluid,
+    // inertial particles relax to it with response time `tau` while settling under gravity.
+    template<typename TF> CUDA_MACRO inline
+    void advance_particle(
+            TF& x, TF& y, TF& z, TF& u, TF& v, TF& w,
+            TF& xt, TF& yt, TF& zt, TF& ut, TF& vt, TF& wt,
+            const TF uf, const TF vf, const TF wf,
+            const TF tau, const TF grav, const TF cA, const TF cBdt,
+            const TF xsize, const TF ysize, const TF zsize)
+    {
+        if (tau > TF(0))
+        {
+            xt = cA*xt + u;
+            yt = cA*yt + v;
+            zt = cA*zt + w;
+            ut = cA*ut + (uf-u)/tau;
+            vt = cA*vt + (vf-v)/tau;
+            wt = cA*wt + (wf-w)/tau - grav;
+
+            u += cBdt*ut;
+            v += cBdt*vt;
+            w += cBdt*wt;
+        }
+        else
+        {
+            u = uf;
+            v = vf;
+            w = wf;
+
+            xt = cA*xt + u;
+            yt = cA*yt + v;
+            zt = cA*zt + w;
+        }
+
+        x += cBdt*xt;
+        y += cBdt*yt;
+        z += cBdt*zt;
+
+        // Periodic in the horizontal, reflecting at the bottom and top.
+        if (x < TF(0))
+            x += xsize;
+        else if (x >= xsize)
+            x -= xsize;
+
+        if (y < TF(0))
+            y += ysize;
+        else if (y >= ysize)
+            y -= ysize;
+
+        if (z < TF(0))
+        {
+            z = -z;
+            w = -w;
+            zt = -zt;
+        }
+        else if (z > zsize)
+        {
+            z = TF(2)*zsize - z;
+            w = -w;
+            zt = -zt;
+        }
+    }
+}
+#endif
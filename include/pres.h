@@ -25,6 +25,7 @@
 
 #ifdef USECUDA
 #include <cufft.h>
+#include "cuda_buffer.h"
 #endif
 
 #include "field3d_operators.h"
@@ -36,6 +37,12 @@ template<typename> class Fields;
 template<typename> class FFT;
 template<typename> class Stats;
 
+#ifdef USECUDA
+// Backend of the FFTs in the pressure solver on the GPU: the FFTW transforms with the MPI
+// transposes of the CPU solver on a host copy of the field, or cuFFT on a single device.
+enum class Fft_backend {Host, Cufft};
+#endif
+
 template<typename TF>
 class Pres
 {
@@ -66,21 +73,21 @@ class Pres
         Field3d_operators<TF> field3d_operators;
 
         #ifdef USECUDA
+        void set_fft_backend();
         void make_cufft_plan();
+        void set_cufft_work_area(TF*);
         void fft_forward (TF*, TF*, TF*);
-        void fft_backward(TF*, TF*, TF*);
+        void fft_backward(TF*, TF*, TF*); ///< Leaves the unnormalized result in the last argument.
+
+        std::string fft_backend_name;
+        Fft_backend fft_backend;
 
         bool FFT_per_slice;
         bool force_FFT_per_slice;
-        cufftHandle iplanf;
-        cufftHandle jplanf;
-        cufftHandle iplanb;
-        cufftHandle jplanb;
-        #endif
-
-    private:
-        #ifdef USECUDA
-        void check_cufft_memory();
+        cufftHandle planf; ///< Batched two-dimensional forward transform of the horizontal slices.
+        cufftHandle planb; ///< Batched two-dimensional backward transform of the horizontal slices.
+        size_t cufft_work_size;
+        cuda_vector<TF> cufft_work_g; ///< Work area of the plans, only if it does not fit in a temporary field.
         #endif
 };
 #endif
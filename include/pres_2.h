@@ -62,9 +62,16 @@ class Pres_2 : public Pres<TF>
         std::vector<TF> bmatj;
         std::vector<TF> a;
         std::vector<TF> c;
-        std::vector<TF> work2d;
+
+        // Inverse pivots and upper diagonal of the eliminated tridiagonal systems of all
+        // wave numbers in the local transposed block, stored if the factorization is cached.
+        bool swcachelu;
+        std::vector<double> pivot_inv;
+        std::vector<double> gamma;
 
         #ifdef USECUDA
+        using Pres<TF>::set_fft_backend;
+        using Pres<TF>::fft_backend;
         using Pres<TF>::make_cufft_plan;
         using Pres<TF>::fft_forward;
         using Pres<TF>::fft_backward;
@@ -73,7 +80,6 @@ class Pres_2 : public Pres<TF>
         cuda_vector<TF> bmatj_g;
         cuda_vector<TF> a_g;
         cuda_vector<TF> c_g;
-        cuda_vector<TF> work2d_g;
         #endif
 
         void input(TF* const restrict,
@@ -85,6 +91,8 @@ class Pres_2 : public Pres<TF>
         void solve(TF* const restrict, TF* const restrict, TF*,
                    const TF* const restrict, const TF* const restrict);
 
+        void set_diagonal(TF* const restrict, const TF* const restrict, const TF* const restrict);
+
         void output(TF* const restrict, TF* const restrict, TF* const restrict,
                     const TF* const restrict, const TF* const restrict);
 
@@ -97,7 +97,8 @@ namespace Pres_2_kernels
             // b[ijk] = dz[k+kgc]*dz[k+kgc] * (bmati[iindex]+bmatj[jindex]) - (a[k]+c[k]);
             //  if(iindex == 0 && jindex == 0)
 
-            b[ijk] = dz[k+kstart]*dz[k+kstart] * rhoref[k+kstart]*(bmati[i]+bmatj[j]) - (a[k]+c[k]);
+            b[ijk] = double(dz[k+kstart])*dz[k+kstart] * rhoref[k+kstart]*(double(bmati[i])+bmatj[j])
+                   - (double(a[k])+c[k]);
             p[ijk] = dz[k+kstart]*dz[k+kstart] * p[ijk];
 
             if (level.distance_to_start() == 0)
@@ -139,16 +140,19 @@ namespace Pres_2_kernels
             const int ij = g(i, j, k);  // k=0
             const int kk = g.kstride;
 
-            TF work2d = b[ij];
-            p[ij] /= work2d;
+            // Carry the pivot and forward recurrence in double, as on the CPU.
+            double work2d = b[ij];
+            double p_prev = p[ij] / work2d;
+            p[ij] = p_prev;
 
             for (int k=1; k<kmax; k++)
             {
                 const int ijk = ij + k*kk;
-                work3d[ijk] = c[k-1] / work2d;
-                work2d = b[ijk] - a[k]*work3d[ijk];
-                p[ijk] -= a[k]*p[ijk-kk];
-                p[ijk] /= work2d;
+                const double gamma = c[k-1] / work2d;
+                work3d[ijk] = gamma;
+                work2d = b[ijk] - a[k]*gamma;
+                p_prev = (p[ijk] - a[k]*p_prev) / work2d;
+                p[ijk] = p_prev;
             }
 
             for (int k=kmax-2; k>=0; k--)
@@ -173,6 +177,7 @@ namespace Pres_2_kernels
                 const Level level,
                 TF* const __restrict__ p,
                 const TF* const __restrict__ work3d,
+                const TF norm,
                 const int istart, const int jstart, const int kstart,
                 const int jj_gc, const int kk_gc)
         {
@@ -187,7 +192,7 @@ namespace Pres_2_kernels
             const int ijk  = i + j*jj + k*kk;
             const int ijkp = i+istart + (j+jstart)*jjp + (k+kstart)*kkp;
 
-            p[ijkp] = work3d[ijk];
+            p[ijkp] = norm*work3d[ijk];
 
             if (level.distance_to_start() == 0)
                 p[ijkp-kkp] = p[ijkp];
@@ -68,7 +68,20 @@ class Pres_4 : public Pres<TF>
         std::vector<TF> m6;
         std::vector<TF> m7;
 
+        // LU factors of the heptadiagonal matrices of all wave numbers in the
+        // local transposed block, stored if the factorization is cached.
+        bool swcachelu;
+        std::vector<TF> lu1;
+        std::vector<TF> lu2;
+        std::vector<TF> lu3;
+        std::vector<TF> lu4;
+        std::vector<TF> lu5;
+        std::vector<TF> lu6;
+        std::vector<TF> lu7;
+
         #ifdef USECUDA
+        using Pres<TF>::set_fft_backend;
+        using Pres<TF>::fft_backend;
         using Pres<TF>::make_cufft_plan;
         using Pres<TF>::fft_forward;
         using Pres<TF>::fft_backward;
@@ -109,10 +122,25 @@ class Pres_4 : public Pres<TF>
         void output(TF* restrict, TF* restrict, TF* restrict,
                     const TF* restrict, const TF* restrict);
 
+        void set_matrix(TF* restrict, TF* restrict, TF* restrict, TF* restrict,
+                        TF* restrict, TF* restrict, TF* restrict,
+                        const TF* restrict, const TF* restrict, const TF* restrict, const TF* restrict,
+                        const TF* restrict, const TF* restrict, const TF* restrict,
+                        const TF* restrict, const TF* restrict,
+                        const int, const int);
+
         void hdma(TF* restrict, TF* restrict, TF* restrict, TF* restrict,
                   TF* restrict, TF* restrict, TF* restrict, TF* restrict,
                   int);
 
+        void hdma_factorize(TF* restrict, TF* restrict, TF* restrict, TF* restrict,
+                            TF* restrict, TF* restrict, TF* restrict,
+                            const int);
+
+        void hdma_substitute(const TF* restrict, const TF* restrict, const TF* restrict, const TF* restrict,
+                             const TF* restrict, const TF* restrict, const TF* restrict, TF* restrict,
+                             const int);
+
         TF calc_divergence(const TF* restrict, const TF* restrict, const TF* restrict, const TF* restrict);
 
         const std::string tend_name = "pres";
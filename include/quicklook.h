@@ -0,0 +1,94 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUICKLOOK_H
+#define QUICKLOOK_H
+
+#include <string>
+#include <vector>
+
+class Master;
+class Input;
+template<typename> class Grid;
+template<typename> class Fields;
+template<typename> class Thermo;
+template<typename> class Microphys;
+template<typename> class Timeloop;
+
+/**
+ * Low resolution xy snapshots for monitoring a running simulation.
+ * Every `sampletime`, the fields in `fields` are averaged over blocks of `blocksize` by `blocksize`
+ * grid points. The blocks are reduced over all processes, and the first process writes them into
+ * one small NetCDF file per sample, (simname).quicklook.(iotime).nc, next to the other output.
+ * A field is either a prognostic field at the level nearest to `height[name]`, the liquid water
+ * path `lwp`, or the surface rain rate `rr_bot`.
+ * Reads the following parameters from (case).ini file
+ *
+ * [quicklook]
+ * swquicklook ; enable the quick-look output
+ * sampletime  ; interval between the snapshots (s)
+ * blocksize   ; number of grid points per block in both directions, which has to divide imax and jmax
+ * fields      ; names of the fields
+ * height      ; height of the level of a prognostic field, per field as height[name] (m)
+ */
+
+template<typename TF>
+class Quicklook
+{
+    public:
+        Quicklook(Master&, Grid<TF>&, Fields<TF>&, Input&);
+        ~Quicklook();
+
+        void init();
+        void create(Thermo<TF>&, const std::string&);
+
+        unsigned long get_time_limit(unsigned long);
+        bool get_switch() { return swquicklook; }
+        bool do_quicklook(unsigned long);
+
+        void exec(Thermo<TF>&, Microphys<TF>&, double, int);
+
+    private:
+        Master& master;
+        Grid<TF>& grid;
+        Fields<TF>& fields;
+
+        bool swquicklook;
+        double sampletime;
+        unsigned long isampletime;
+        int blocksize;
+        std::string sim_name;
+
+        // Field and its level, which is only used for the prognostic fields.
+        struct Quicklook_var
+        {
+            std::string name;
+            TF height;
+            int k;
+        };
+        std::vector<Quicklook_var> vars;
+
+        std::vector<TF> blocks; ///< Block averages of one field over the entire domain.
+
+        void calc_blocks(const TF* const, const int);
+};
+#endif
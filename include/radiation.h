@@ -80,6 +80,9 @@ class Radiation
                 Aerosol<TF>&, Background<TF>&) = 0;
         virtual void exec_column(Column<TF>&, Thermo<TF>&, Timeloop<TF>&) = 0;
 
+        // Whether the radiation runs as a task next to the time integration.
+        virtual bool get_switch_async() const { return false; }
+
         #ifdef USECUDA
         virtual TF* get_surface_radiation_g(const std::string&) = 0;
         virtual void prepare_device() = 0;
@@ -23,6 +23,9 @@
 #ifndef RADIATION_RRTMGP_H
 #define RADIATION_RRTMGP_H
 
+#include <exception>
+#include <future>
+
 #include "radiation.h"
 #include "field3d_operators.h"
 #include "boundary_cyclic.h"
@@ -91,6 +94,8 @@ class Radiation_rrtmgp : public Radiation<TF>
                 Aerosol<TF>&, Background<TF>&);
         void exec_column(Column<TF>&, Thermo<TF>&, Timeloop<TF>&) {};
 
+        bool get_switch_async() const { return sw_async; }
+
         #ifdef USECUDA
         TF* get_surface_radiation_g(const std::string&);
         void prepare_device();
@@ -221,6 +226,26 @@ class Radiation_rrtmgp : public Radiation<TF>
         bool sw_homogenize_hr_sw;
         bool sw_homogenize_hr_lw;
 
+        int n_coarse; ///< Size of the n_coarse x n_coarse blocks of columns that share one radiation solve.
+        int n_col_block_cpu; ///< Number of columns per block of the CPU solvers, 0 fits the blocks in L2.
+
+        // Asynchronous radiation: the solve runs as an OpenMP task next to the time integration,
+        // and its result is applied one radiation step later.
+        bool sw_async;
+        bool async_initialized = false;
+        bool async_pending = false;
+        bool async_result_ready = false;
+        std::exception_ptr async_exception;
+
+        std::vector<Float> thlt_rad_async;
+        std::vector<Float> lw_flux_dn_sfc_async;
+        std::vector<Float> lw_flux_up_sfc_async;
+        std::vector<Float> sw_flux_dn_sfc_async;
+        std::vector<Float> sw_flux_up_sfc_async;
+
+        void wait_async_radiation();
+        void apply_async_radiation();
+
         // Make sure that the sw radiation is tuned at the first `exec()`. This
         // ensures that sw is tuned for the full 3D field, and not for the column stats.
         bool sw_is_tuned = false;
@@ -228,6 +253,53 @@ class Radiation_rrtmgp : public Radiation<TF>
         double dt_rad;
         unsigned long idt_rad;
 
+        // Adaptive radiation interval: the solve at a radiation step is skipped if the state that matters
+        // most for the fluxes has changed little since the last solve.
+        bool sw_adaptive;
+        double dt_rad_max;
+        unsigned long idt_rad_max;
+        Float adaptive_lwp_threshold;  ///< Threshold of the rms change of the liquid water path (kg m-2).
+        Float adaptive_tsfc_threshold; ///< Threshold of the maximum change of the surface temperature (K).
+        unsigned long itime_last_rad;
+        std::vector<Float> lwp_last;   ///< Liquid water path per column at the last solve.
+        std::vector<Float> t_sfc_last; ///< Surface temperature per column at the last solve.
+
+        bool check_adaptive_update(Thermo<TF>&, Timeloop<TF>&);
+
+        // Incremental radiation: at a radiation step, only the columns of which the liquid or ice water path,
+        // or the norm of the temperature or water vapor profile has changed beyond its threshold since their
+        // last solve are packed into dense blocks and solved. The other columns keep their fluxes.
+        bool sw_incremental;
+        Float incremental_lwp_threshold; ///< Threshold of the change of the liquid water path (kg m-2).
+        Float incremental_iwp_threshold; ///< Threshold of the change of the ice water path (kg m-2).
+        Float incremental_t_threshold;   ///< Threshold of the change of the rms temperature and the surface temperature (K).
+        Float incremental_h2o_threshold; ///< Threshold of the relative change of the rms water vapor mixing ratio (-).
+
+        // Column state at the last solve of each column.
+        std::vector<Float> col_lwp_last;
+        std::vector<Float> col_iwp_last;
+        std::vector<Float> col_t_last;
+        std::vector<Float> col_h2o_last;
+        std::vector<Float> col_t_sfc_last;
+
+        // Fluxes of all columns of the last solve, without ghost cells.
+        std::vector<Float> lw_flux_up_last;
+        std::vector<Float> lw_flux_dn_last;
+        std::vector<Float> sw_flux_up_last;
+        std::vector<Float> sw_flux_dn_last;
+        std::vector<Float> sw_flux_dn_dir_last;
+        std::vector<Float> aod550_last;
+
+        // Load balancing: the processes of which the columns of the solve cost more than the mean send their
+        // last cloudy columns to the processes below the mean, which return the fluxes after each solve.
+        bool sw_load_balance;
+        Float load_balance_cloud_cost; ///< Cost of a cloudy column relative to a clear one (-).
+
+        bool select_incremental_columns(
+                std::vector<int>&,
+                const Field3d<Float>&, const Field3d<Float>&, const Field3d<Float>&,
+                const Field3d<Float>&, const Field3d<Float>&, Timeloop<TF>&);
+
         std::vector<std::string> crosslist;
 
         // RRTMGP related variables.
@@ -348,5 +420,31 @@ class Radiation_rrtmgp : public Radiation<TF>
         Rte_lw_gpu rte_lw_gpu;
         Rte_sw_gpu rte_sw_gpu;
         #endif
+
+        // Prefetch of the shortwave background column. With a time dependent solar zenith angle and a constant
+        // background, the sun location and the incoming fluxes of the next radiation step only depend on the time.
+        // They are solved on a host thread next to the time loop, and used if the top pressure has not changed.
+        bool sw_prefetch_background;
+        unsigned long itime_prefetch;
+        Float p_top_prefetch;
+        Float mu0_prefetch;
+        Float tsi_scaling_prefetch;
+        bool is_day_prefetch;
+
+        std::unique_ptr<Optical_props_arry> optical_props_sw_prefetch;
+        std::unique_ptr<Optical_props_2str> aerosol_props_sw_prefetch;
+        Array<Float,2> sw_flux_up_col_prefetch;
+        Array<Float,2> sw_flux_dn_col_prefetch;
+        Array<Float,2> sw_flux_dn_dir_col_prefetch;
+        Array<Float,2> sw_flux_net_col_prefetch;
+        Array<Float,2> sw_flux_dn_dir_inc_prefetch;
+        Array<Float,2> sw_flux_dn_dif_inc_prefetch;
+
+        // Declared last, such that the destructor waits for the thread before the buffers are freed.
+        std::future<void> background_prefetch;
+
+        std::pair<Float, Float> calc_sun_location(Timeloop<TF>&, double);
+        void start_background_prefetch(Timeloop<TF>&, const Float);
+        bool apply_background_prefetch(unsigned long, const Float, const bool);
 };
 #endif
@@ -243,6 +243,8 @@ class Radiation_rrtmgp_rt : public Radiation<TF>
         unsigned long idt_rad;
 
         Int rays_per_pixel;
+        Int rays_per_pixel_min;
+        bool sw_adaptive_rays;
         int kngrid_i;
         int kngrid_j;
         int kngrid_k;
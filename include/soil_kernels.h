@@ -24,12 +24,15 @@
 #define SOIL_KERNELS_H
 
 #include "constants.h"
+#include "fast_math.h"
 #include "boundary_surface_lsm.h"
 
 using namespace Constants;
 
 namespace Soil_kernels
 {
+    namespace fm = Fast_math;
+
     template<typename TF>
     inline TF calc_diffusivity_vg(
             const TF vg_a, const TF vg_l, const TF vg_m, const TF gamma_sat,
@@ -38,17 +41,17 @@ namespace Soil_kernels
         const TF vg_mi = TF(1) / vg_m;
 
         return (TF(1) - vg_m) * gamma_sat / (vg_a * vg_m * (theta_sat - theta_res))
-                    * pow(theta_norm, (vg_l - vg_mi))
-                    * (pow((TF(1) - pow(theta_norm, vg_mi)), -vg_m)
-                    + pow((TF(1) - pow(theta_norm, vg_mi)), vg_m) - TF(2));
+                    * fm::pow<fm::sw_lsm>(theta_norm, (vg_l - vg_mi))
+                    * (fm::pow<fm::sw_lsm>((TF(1) - fm::pow<fm::sw_lsm>(theta_norm, vg_mi)), -vg_m)
+                    + fm::pow<fm::sw_lsm>((TF(1) - fm::pow<fm::sw_lsm>(theta_norm, vg_mi)), vg_m) - TF(2));
     }
 
     template<typename TF>
     inline TF calc_conductivity_vg(
             const TF theta_norm, const TF vg_l, const TF vg_m, const TF gamma_sat)
     {
-        return gamma_sat * pow(theta_norm, vg_l)
-                    * pow((TF(1) - pow((TF(1) - pow(theta_norm, (1. / vg_m))), vg_m)), 2);
+        return gamma_sat * fm::pow<fm::sw_lsm>(theta_norm, vg_l)
+                    * fm::pow2(TF(1) - fm::pow<fm::sw_lsm>((TF(1) - fm::pow<fm::sw_lsm>(theta_norm, (TF(1) / vg_m))), vg_m));
     }
 
     template<typename TF>
@@ -233,9 +236,9 @@ namespace Soil_kernels
                     const int si = soil_index[ijk];
 
                     // Heat conductivity at saturation (from IFS code..)
-                    const TF gamma_T_sat = pow(Constants::gamma_T_matrix<TF>, (TF(1) - theta_sat[si]))
-                                            * pow(Constants::gamma_T_water<TF>, theta[ijk])
-                                            * pow(TF(2.2), (theta_sat[si] - theta[ijk]));
+                    const TF gamma_T_sat = fm::pow<fm::sw_lsm>(Constants::gamma_T_matrix<TF>, (TF(1) - theta_sat[si]))
+                                            * fm::pow<fm::sw_lsm>(Constants::gamma_T_water<TF>, theta[ijk])
+                                            * fm::pow<fm::sw_lsm>(TF(2.2), (theta_sat[si] - theta[ijk]));
 
                     // Kersten number for fine soils [IFS eq 8.64] (-)
                     const TF kersten = log10(std::max(TF(0.1), theta[ijk] / theta_sat[si])) + TF(1);
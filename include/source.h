@@ -53,6 +53,10 @@ class Source
             std::vector<int> range_x;
             std::vector<int> range_y;
             std::vector<int> range_z;
+
+            // Normalized spatial weights on the cells in range.
+            std::vector<int> ijk;
+            std::vector<TF> weight;
         };
 
         std::vector<Shape> shape;
@@ -91,6 +95,8 @@ class Source
         std::set<int> unique_profile_indexes;
         std::map<int, std::vector<TF>> profile_z;
 
+        void calc_weights(const int);
+
         TF calc_norm(
                 const TF* const, const TF, const TF, const TF,
                 const TF* const, const TF, const TF, const TF,
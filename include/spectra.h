@@ -0,0 +1,61 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPECTRA_H
+#define SPECTRA_H
+
+#include <string>
+#include <vector>
+
+class Master;
+class Input;
+template<typename> class Grid;
+template<typename> class Fields;
+template<typename> class FFT;
+template<typename> class Stats;
+
+// Computes the x- and y-spectra of 3D fields at selected heights with the FFTs of the pressure
+// solver and writes them as statistics, such that no 3D dumps are needed for spectral analysis.
+template<typename TF>
+class Spectra
+{
+    public:
+        Spectra(Master&, Grid<TF>&, Fields<TF>&, FFT<TF>&, Input&);
+        ~Spectra();
+
+        void create(Stats<TF>&);
+        void exec_stats(Stats<TF>&);
+
+    private:
+        Master& master;
+        Grid<TF>& grid;
+        Fields<TF>& fields;
+        FFT<TF>& fft;
+
+        bool swspectra;
+        std::vector<std::string> spectralist;
+        std::vector<TF> heights;
+        std::vector<int> kspec; ///< Grid level of each height, without ghost cells.
+
+        void calc_spectra(std::vector<TF>&, std::vector<TF>&, const std::string&);
+};
+#endif
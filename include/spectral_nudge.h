@@ -0,0 +1,89 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SPECTRAL_NUDGE_H
+#define SPECTRAL_NUDGE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "field3d_io.h"
+
+class Master;
+class Input;
+template<typename> class Grid;
+template<typename> class Fields;
+template<typename> class FFT;
+template<typename> class Timeloop;
+
+/**
+ * Spectral nudging of the large horizontal scales towards 3D target fields, e.g. of a host model.
+ * The difference between a field and its target is transformed with the FFTs of the pressure
+ * solver, all horizontal wave numbers above the cut-off are removed, and the remaining large
+ * scales are relaxed with time scale `tau`. The tendency is only recomputed every `interval`
+ * iterations and is added unchanged to the substeps in between, in order to save the FFTs.
+ * The targets are read from (name)_nudge.0000000, in the format of the restart files.
+ * Reads the following parameters from (case).ini file
+ *
+ * [spectralnudge]
+ * swspectralnudge ; enable the spectral nudging
+ * nudgelist       ; prognostic fields to nudge
+ * nwavex, nwavey  ; highest nudged wave number in x- and y-direction
+ * tau             ; relaxation time scale (s)
+ * zmin            ; height below which the fields are not nudged (m)
+ * interval        ; number of iterations between the updates of the tendency
+ */
+template<typename TF>
+class Spectral_nudge
+{
+    public:
+        Spectral_nudge(Master&, Grid<TF>&, Fields<TF>&, FFT<TF>&, Input&);
+        ~Spectral_nudge();
+
+        void create();
+        void exec(Timeloop<TF>&); ///< Add the large scale nudging tendencies.
+
+    private:
+        Master& master;
+        Grid<TF>& grid;
+        Fields<TF>& fields;
+        FFT<TF>& fft;
+        Field3d_io<TF> field3d_io;
+
+        bool swspectralnudge;
+        std::vector<std::string> nudgelist;
+        int nwavex;
+        int nwavey;
+        TF tau;
+        TF zmin;
+        int interval;
+
+        bool has_tendency; ///< The tendencies are computed at least once.
+
+        std::map<std::string, std::vector<TF>> targets;    ///< Target fields including ghost cells.
+        std::map<std::string, std::vector<TF>> tendencies; ///< Nudging tendencies of the last update.
+
+        void calc_tendency(std::vector<TF>&, const std::string&);
+};
+#endif
@@ -24,6 +24,11 @@
 #define STATS_H
 
 #include <regex>
+
+#ifdef USEMPI
+#include <mpi.h>
+#endif
+
 #include "boundary_cyclic.h"
 
 class Master;
@@ -49,6 +54,7 @@ struct Prof_var
     Netcdf_variable<TF> ncvar;
     std::vector<TF> data;
     Level_type level;
+    std::vector<TF> buffer; ///< Samples that are not written yet, without ghost cells.
 };
 
 // Struct for time series
@@ -57,6 +63,7 @@ struct Time_series_var
 {
     Netcdf_variable<TF> ncvar;
     TF data;
+    std::vector<TF> buffer;
 };
 
 // Typedefs for containers of profiles and time series
@@ -76,13 +83,20 @@ struct Mask
     std::vector<int> nmask;
     std::vector<int> nmaskh;
     int nmask_bot;
+    std::vector<int> nmask_sub;  ///< Number of subsampled points in the mask at the full levels.
+    std::vector<int> nmaskh_sub; ///< Number of subsampled points in the mask at the half levels.
 
     std::unique_ptr<Netcdf_file> data_file;
     std::unique_ptr<Netcdf_variable<int>> iter_var;
     std::unique_ptr<Netcdf_variable<TF>> time_var;
+    std::vector<int> iter_buffer;
+    std::vector<TF> time_buffer;
     Prof_map<TF> profs;
     Prof_map<TF> soil_profs;
     Prof_map<TF> background_profs;
+    Prof_map<TF> spectra;
+    Prof_map<TF> hists; ///< Histograms per level, as fraction of the points in the mask per bin.
+    std::map<std::string, Netcdf_variable<TF>> hist_bin_vars; ///< Bin centres of the histograms.
     Time_series_map<TF> tseries;
 };
 
@@ -107,6 +121,7 @@ class Stats
         bool do_statistics(unsigned long);
         bool do_tendency() {return swtendency; }
         void set_tendency(bool);
+        bool is_doing_tendency() const { return doing_tendency; }
 
         void initialize_masks();
         void finalize_masks();
@@ -115,6 +130,7 @@ class Stats
         void set_mask_thres(std::string, Field3d<TF>&, Field3d<TF>&, TF, Stats_mask_type );
 
         void exec(const int, const double, const unsigned long);
+        void finish_exec(); ///< Completes the reduction and writing of statistics under swasyncwrite.
 
         // Interface functions.
         void add_dimension(const std::string&, const int);
@@ -146,6 +162,12 @@ class Stats
                 const std::string&, const std::string&,
                 const std::string&, const std::string&, Stats_whitelist_type=Stats_whitelist_type::Default);
 
+        // Spectra as function of time, height and wave number, that are identical for all masks.
+        void add_spectrum(
+                const std::string&, const std::string&,
+                const std::string&, const std::string&, const std::string&, const std::string&);
+        void set_spectrum(const std::string&, const std::vector<TF>&);
+
         void calc_mask_stats(
                 std::pair<const std::string, Mask<TF>>&,
                 const std::string&, const Field3d<TF>&, const TF, const TF);
@@ -165,6 +187,8 @@ class Stats
         void calc_stats_path(const std::string&, const Field3d<TF>&);
         void calc_stats_cover(const std::string&, const Field3d<TF>&, const TF, const TF);
         void calc_stats_frac(const std::string&, const Field3d<TF>&, const TF, const TF);
+        void calc_stats_hist(const std::string&, const Field3d<TF>&, const TF);
+        void calc_joint_hist(const std::string&, const Field3d<TF>&, const std::string&, const Field3d<TF>&);
 
         void calc_stats_2d(const std::string&, const std::vector<TF>&, const TF);
         void calc_stats_soil(const std::string, const std::vector<TF>&, const TF);
@@ -176,6 +200,18 @@ class Stats
         void set_time_series(const std::string&, const TF);
 
         Mask_map<TF>& get_masks() { return masks; }
+        const std::vector<unsigned int>& get_mask_field() const { return mfield; }
+        double get_sampletime() const { return sampletime; }
+        unsigned long get_isampleoffset() const { return isampleoffset; }
+
+        #ifdef USECUDA
+        void prepare_device();
+        void clear_device();
+        void calc_stats_g(const std::string&, const Field3d<TF>&, const TF, const TF); ///< Mean and moments from the device field.
+        void calc_covariance_g(const std::string&, const Field3d<TF>&, const TF, const TF, const int,
+                               const std::string&, const Field3d<TF>&, const TF, const TF, const int); ///< Covariance from the device fields.
+        void calc_joint_hist_g(const std::string&, const Field3d<TF>&, const std::string&, const Field3d<TF>&);
+        #endif
 
     private:
         Master& master;
@@ -202,17 +238,107 @@ class Stats
 
         int statistics_counter;
         double sampletime;
+        double sampleoffset;
         unsigned long isampletime;
+        unsigned long isampleoffset;
 
         // Container for all stats, masks as uppermost in hierarchy
         Mask_map<TF> masks;
         std::vector<std::string> masklist;
         std::vector<unsigned int> mfield;
         std::vector<unsigned int> mfield_bot;
+        std::vector<unsigned int> mfield_k; ///< Flags of the masks that have points at each level of this process.
 
         // Tendency calculations
         std::map<std::string, std::vector<std::string>> tendency_order;
 
+        // Histograms per level of prognostic fields, and joint histograms of pairs of them at the
+        // cell centre. The bins span a fixed range from histrange, or without one, the range of the
+        // first sample widened by half of it, which stays fixed for the rest of the run.
+        struct Hist_bins
+        {
+            TF min;
+            TF max;
+            bool is_set;
+        };
+        int nhistbins;
+
+        // The moments and covariances are computed from every substride-th point in both horizontal
+        // directions, the means, fluxes and gradients always from all points.
+        int substride;
+        std::vector<std::string> histlist;
+        std::vector<std::pair<std::string, std::string>> joint_histlist;
+        std::map<std::string, Hist_bins> hist_bins;
+
+        const Hist_bins& get_hist_bins(const std::string&, const Field3d<TF>&, const TF);
+
+        // Profiles of which the reduction over all processes is deferred until the statistics are
+        // written, such that all of them are summed in a single call.
+        struct Deferred_sum
+        {
+            TF* data;
+            const int* nmask;
+            int size;
+        };
+        std::vector<Deferred_sum> deferred_sums;
+        std::vector<TF> deferred_buffer;
+
+        void sum_deferred(TF* const, const int* const);
+        void sum_deferred_block(TF* const, const int); ///< Deferred sum of a block without fill values.
+        void pack_deferred();
+        void reduce_deferred();
+        void reduce_deferred_begin();
+        void reduce_deferred_end();
+
+        // With swasyncwrite, exec only starts the reduction of the deferred profiles,
+        // and finish_exec completes it and writes the output one call later.
+        bool swasyncwrite;
+        bool write_pending;
+        int pending_iteration;
+        double pending_time;
+        unsigned long pending_itime;
+
+        void write(const int, const double, const unsigned long);
+
+        // The samples are written to the files in blocks of nbuffer samples, with a single sync
+        // per block. A block is closed early by the last sample before a restart save.
+        int nbuffer;
+        int nbuffered;
+        unsigned long isavetime;
+        void flush();
+
+        #ifdef USEMPI
+        MPI_Request deferred_request;
+        #endif
+
+        #ifdef USECUDA
+        // Device copies of the mask field and the work profiles, such that the mean and moments
+        // of the prognostic fields are reduced on the GPU and only kcells values are copied back.
+        cuda_vector<unsigned int> mfield_g;
+        cuda_vector<TF> prof_g;
+        cuda_vector<TF> mean_g;
+        cuda_vector<TF> mean2_g;
+        std::vector<TF> prof_tmp;
+
+        void upload_masks_g();
+        void calc_masked_sum_g(
+                TF* const, const Field3d<TF>&, const TF* const, const TF,
+                const unsigned int, const int, const int, const int);
+        void calc_masked_cov_sum_g(
+                TF* const, const Field3d<TF>&, const TF* const, const TF, const int,
+                const Field3d<TF>&, const TF* const, const TF, const int,
+                const unsigned int, const int, const int);
+        void calc_stats_mean_g(const std::string&, const Field3d<TF>&, const TF);
+        void calc_stats_moments_g(const std::string&, const Field3d<TF>&, const TF);
+        void calc_stats_hist_g(const std::string&, const Field3d<TF>&, const TF);
+
+        cuda_vector<TF> hist_g;
+        void calc_hist_sum_g(
+                TF* const, const Field3d<TF>&, const TF, const Hist_bins&,
+                const Field3d<TF>* const, const Hist_bins* const,
+                const unsigned int, const int, const int);
+        #endif
+
         void calc_flux_2nd(
                 TF*, const TF* const, const TF* const, const TF, TF* const, const TF* const, TF*,
                 const int*, const unsigned int* const, const unsigned int, const int* const,
@@ -223,11 +349,11 @@ class Stats
                 const int, const int, const int, const int, const int, const int, const int, const int);
         void calc_grad_2nd(
                 TF* const restrict, const TF* const restrict, const TF* const restrict,
-                const unsigned int* const, const unsigned int, const int* const,
+                const unsigned int* const, const unsigned int* const, const unsigned int, const int* const,
                 const int, const int, const int, const int, const int, const int, const int, const int);
         void calc_grad_4th(
                 TF* const restrict, const TF* const restrict, const TF* const restrict,
-                const unsigned int* const, const unsigned int, const int* const,
+                const unsigned int* const, const unsigned int* const, const unsigned int, const int* const,
                 const int, const int, const int, const int, const int, const int, const int, const int);
         void calc_diff_2nd(
                 TF* restrict, TF* restrict, const TF* restrict, TF, const int*,
@@ -97,6 +97,13 @@ class Thermo
         virtual TF get_buoyancy_diffusivity() = 0;
 
         virtual void update_time_dependent(Timeloop<TF>&) = 0;
+        virtual void get_checkpoint_data(std::vector<std::vector<TF>*>&) {} ///< Add the state that is saved in the restarts.
+
+        // With swfusebuoyancy, the advection of w adds the buoyancy tendency on the steps without tendency
+        // statistics, from the buoyancy at one half level at a time, instead of the separate pass in exec().
+        bool get_switch_fuse_buoyancy() const { return sw_fuse_buoyancy; }
+        virtual bool do_fused_buoyancy(const Stats<TF>&) const { return false; }
+        virtual void calc_buoyancy_plane_w(TF* const, TF* const, const int) const {} ///< Buoyancy at level k, with 4 planes of work space.
 
         #ifdef USECUDA
         // GPU functions and variables.
@@ -124,5 +131,6 @@ class Thermo
         Fields<TF>& fields;
 
         Thermo_type swthermo;
+        bool sw_fuse_buoyancy;
 };
 #endif
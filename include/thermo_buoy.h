@@ -52,6 +52,8 @@ class Thermo_buoy : public Thermo<TF>
         virtual ~Thermo_buoy(); ///< Destructor of the dry thermodynamics class.
 
         void exec(const double, Stats<TF>&); ///< Add the tendencies belonging to the buoyancy.
+        bool do_fused_buoyancy(const Stats<TF>&) const;
+        void calc_buoyancy_plane_w(TF* const, TF* const, const int) const;
         void create(Input&, Netcdf_handle&, Stats<TF>&, Column<TF>&, Cross<TF>&, Dump<TF>&, Timeloop<TF>&);
         unsigned long get_time_limit(unsigned long, double); ///< Compute the time limit (n/a for thermo_buoy)
         void create_stats(Stats<TF>&) {};    ///< Initialization of the fields statistics.
@@ -127,6 +129,7 @@ class Thermo_buoy : public Thermo<TF>
         using Thermo<TF>::master;
         using Thermo<TF>::grid;
         using Thermo<TF>::fields;
+        using Thermo<TF>::sw_fuse_buoyancy;
 
         struct background_state
         {
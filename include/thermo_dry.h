@@ -58,6 +58,8 @@ class Thermo_dry : public Thermo<TF>
         void init();
         void create(Input&, Netcdf_handle&, Stats<TF>&, Column<TF>&, Cross<TF>&, Dump<TF>&, Timeloop<TF>&);
         void exec(const double, Stats<TF>&); // Add the tendencies belonging to the buoyancy.
+        bool do_fused_buoyancy(const Stats<TF>&) const;
+        void calc_buoyancy_plane_w(TF* const, TF* const, const int) const;
         unsigned long get_time_limit(unsigned long, double); // Compute the time limit (n/a for thermo_dry).
         void create_stats(Stats<TF>&);   // Initialization of the statistics.
 
@@ -136,6 +138,7 @@ class Thermo_dry : public Thermo<TF>
         using Thermo<TF>::master;
         using Thermo<TF>::grid;
         using Thermo<TF>::fields;
+        using Thermo<TF>::sw_fuse_buoyancy;
 
         Boundary_cyclic<TF> boundary_cyclic;
 
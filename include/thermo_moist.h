@@ -23,6 +23,9 @@
 #ifndef THERMO_MOIST_H
 #define THERMO_MOIST_H
 
+#include <map>
+#include <memory>
+
 #include "boundary_cyclic.h"
 #include "timedep.h"
 #include "thermo.h"
@@ -63,10 +66,13 @@ class Thermo_moist : public Thermo<TF>
         void create_stats(Stats<TF>&);   ///< Initialization of the statistics.
 
         void exec(const double, Stats<TF>&); ///< Add the tendencies belonging to the buoyancy.
+        bool do_fused_buoyancy(const Stats<TF>&) const;
+        void calc_buoyancy_plane_w(TF* const, TF* const, const int) const;
         unsigned long get_time_limit(unsigned long, double); ///< Compute the time limit (n/a for thermo_dry)
 
         void save(const int);
         void load(const int);
+        void get_checkpoint_data(std::vector<std::vector<TF>*>&);
 
         void exec_stats(Stats<TF>&);
         void exec_cross(Cross<TF>&, unsigned long);
@@ -128,6 +134,7 @@ class Thermo_moist : public Thermo<TF>
         using Thermo<TF>::master;
         using Thermo<TF>::grid;
         using Thermo<TF>::fields;
+        using Thermo<TF>::sw_fuse_buoyancy;
 
         Boundary_cyclic<TF> boundary_cyclic;
         Field3d_operators<TF> field3d_operators;
@@ -185,6 +192,34 @@ class Thermo_moist : public Thermo<TF>
         Background_state bs;
         Background_state bs_stats;
 
+        // Saturation adjustment of the current substep, filled on first request.
+        bool swsatadjustcache;
+        bool sat_adjust_cache_valid;
+        std::vector<TF> sat_adjust_cache_ql;
+        std::vector<TF> sat_adjust_cache_qi;
+        std::vector<TF> sat_adjust_cache_qs;
+        std::vector<TF> sat_adjust_cache_T;
+        bool get_cached_thermo_field(Field3d<TF>&, const std::string&, const TF* const);
+
+        // Diagnostic fields of the current output step, computed on the first request of the
+        // statistics, cross-sections, dumps or columns and shared by all of them.
+        bool swoutputcache;
+        std::map<std::string, std::shared_ptr<Field3d<TF>>> output_cache;
+        void clear_output_cache();
+
+        void calc_thermo_field(Field3d<TF>&, const std::string&, const bool, const bool);
+
+        // With swupdatebasestate, the base state is only recalculated every `basestate_interval`
+        // iterations, and then only if the mean thl or qt changed more than their tolerance
+        // since the last update.
+        int basestate_interval;
+        int basestate_iteration; ///< Iteration of the current step, all its substeps share the decision to update.
+        TF basestate_tol_thl;
+        TF basestate_tol_qt;
+        std::vector<TF> thl_mean_basestate; ///< Mean profiles of the last update of the base state.
+        std::vector<TF> qt_mean_basestate;
+        bool do_update_basestate();
+
         std::unique_ptr<Timedep<TF>> tdep_pbot;
         const std::string tend_name = "buoy";
         const std::string tend_longname = "Buoyancy";
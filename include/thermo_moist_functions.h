@@ -294,6 +294,56 @@ namespace Thermo_moist_functions
         return ans;
     }
 
+    // Saturation adjustment of n consecutive points at a single pressure and Exner level,
+    // written to vectorize. Warm points (Tl >= T0) take a fixed number of Newton steps on
+    // the liquid-only root function without early exit, and unsaturated points are masked
+    // out with selects afterwards. Newton converges quadratically from Tl, such that four
+    // steps reach the tolerance of sat_adjust() for all atmospheric states. The rare cold
+    // points, which need the mixed-phase solver, are redone with sat_adjust() in a second
+    // scalar pass.
+    template<typename TF, int n_newton=4>
+    inline void sat_adjust_row(
+            TF* const restrict ql, TF* const restrict qi,
+            const TF* const restrict thl, const TF* const restrict qt,
+            const TF p, const TF exn, const int n)
+    {
+        int n_cold = 0;
+
+        #pragma ivdep
+        for (int i=0; i<n; ++i)
+        {
+            const TF tl = thl[i] * exn;
+            TF tnr = tl;
+
+            for (int iter=0; iter<n_newton; ++iter)
+            {
+                const TF qs = qsat_liq(p, tnr);
+                const TF f = tnr - tl - Lv<TF>/cp<TF>*(qt[i] - qs);
+                const TF f_prime = TF(1.) + Lv<TF>/cp<TF>*dqsatdT_liq(p, tnr);
+                tnr -= f / f_prime;
+            }
+
+            const bool saturated = (qt[i] - qsat_liq(p, tl)) > TF(0.);
+            ql[i] = saturated ? std::max(TF(0.), qt[i] - qsat_liq(p, tnr)) : TF(0.);
+            qi[i] = TF(0.);
+
+            n_cold += (tl < T0<TF>);
+        }
+
+        if (n_cold > 0)
+        {
+            for (int i=0; i<n; ++i)
+            {
+                if (thl[i]*exn < T0<TF>)
+                {
+                    const Struct_sat_adjust<TF> ssa = sat_adjust(thl[i], qt[i], p, exn);
+                    ql[i] = ssa.ql;
+                    qi[i] = ssa.qi;
+                }
+            }
+        }
+    }
+
     template<typename TF>
     void calc_base_state(
             TF* restrict pref,
@@ -0,0 +1,188 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef THERMO_MOIST_KERNELS_CUH
+#define THERMO_MOIST_KERNELS_CUH
+
+#include "constants.h"
+#include "fast_math.h"
+#include "thermo_moist_functions.h"
+#include "cuda_tiling.h"
+
+namespace Thermo_moist_kernels
+{
+    using namespace Constants;
+    using namespace Thermo_moist_functions;
+
+    template<typename TF>
+    CUDA_DEVICE Struct_sat_adjust<TF> sat_adjust_g(
+            const TF thl, const TF qt, const TF p, const TF exn)
+    {
+        using Fast_math::pow2;
+
+        int niter = 0;
+        const int nitermax = 10;
+
+        TF tnr_old = TF(1.e9);
+
+        const TF tl = thl * exn;
+        TF qs = qsat_liq(p, tl);
+
+        Struct_sat_adjust<TF> ans =
+        {
+            TF(0.), // ql
+            TF(0.), // qi
+            tl, // t
+            qs, // qs
+        };
+
+        // Calculate if q-qs(Tl) <= 0. If so, return 0. Else continue with saturation adjustment.
+        if (qt-ans.qs <= TF(0.))
+            return ans;
+
+        /* Saturation adjustment solver.
+         * Root finding function is f(T) = T - tnr - Lv/cp*qt + alpha_w * Lv/cp*qs(T) + alpha_i*Ls/cp*qs(T)
+         * dq_sat/dT derivatives can be rewritten using Claussius-Clapeyron (desat/dT = L{v,s}*esat / (Rv*T^2)).
+         */
+
+        TF tnr = tl;
+
+        // Warm adjustment.
+        if (tl >= T0<TF>)
+        {
+            while (fabs(tnr-tnr_old)/tnr_old > TF(1.e-5) && niter < nitermax)
+            {
+                tnr_old = tnr;
+                qs = qsat_liq(p, tnr);
+                const TF f =
+                    tnr - tl - Lv<TF>/cp<TF>*(qt - qs);
+
+                const TF f_prime = TF(1.) + Lv<TF>/cp<TF>*dqsatdT_liq(p, tnr);
+
+                tnr -= f / f_prime;
+
+                niter += 1;
+            }
+
+            qs = qsat_liq(p, tnr);
+            ans.ql = fmax(TF(0.), qt - qs);
+            ans.t  = tnr;
+            ans.qs = qs;
+        }
+        // Cold adjustment.
+        else
+        {
+            while (fabs(tnr-tnr_old)/tnr_old > TF(1.e-5) && niter < nitermax)
+            {
+                tnr_old = tnr;
+                qs = qsat(p, tnr);
+                const TF alpha_w = water_fraction(tnr);
+                const TF alpha_i = TF(1.) - alpha_w;
+                const TF dalphadT = (alpha_w > TF(0.) && alpha_w < TF(1.)) ? TF(0.025) : TF(0.);
+                const TF dqsatdT_w = dqsatdT_liq(p, tnr);
+                const TF dqsatdT_i = dqsatdT_ice(p, tnr);
+
+                const TF f =
+                    tnr - tl - alpha_w*Lv<TF>/cp<TF>*qt - alpha_i*Ls<TF>/cp<TF>*qt
+                             + alpha_w*Lv<TF>/cp<TF>*qs + alpha_i*Ls<TF>/cp<TF>*qs;
+
+                const TF f_prime = TF(1.)
+                    - dalphadT*Lv<TF>/cp<TF>*qt + dalphadT*Ls<TF>/cp<TF>*qt
+                    + dalphadT*Lv<TF>/cp<TF>*qs - dalphadT*Ls<TF>/cp<TF>*qs
+                    + alpha_w*Lv<TF>/cp<TF>*dqsatdT_w
+                    + alpha_i*Ls<TF>/cp<TF>*dqsatdT_i;
+
+                tnr -= f / f_prime;
+
+                niter += 1;
+            }
+
+            const TF alpha_w = water_fraction(tnr);
+            const TF alpha_i = TF(1.) - alpha_w;
+
+            qs = qsat(p, tnr);
+            const TF qlqi = fmax(TF(0.), qt - qs);
+
+            ans.ql = alpha_w*qlqi;
+            ans.qi = alpha_i*qlqi;
+            ans.t  = tnr;
+            ans.qs = qs;
+        }
+
+        // Raise exception if nitermax is reached.
+        if (niter == nitermax)
+        {
+            printf("ERROR: saturation adjustment did not converge: thl=%f, qt=%f, p=%f\n", thl, qt, p);
+            asm("trap;");
+        }
+
+        return ans;
+    }
+
+    template<typename TF>
+    struct calc_buoyancy_tend_2nd_g
+    {
+        DEFINE_GRID_KERNEL("thermo_moist::calc_buoyancy_tend_2nd", 0)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g, const int i, const int j, const int k, const Level level,
+                TF* __restrict__ wt, const TF* __restrict__ th, const TF* __restrict__ qt,
+                const TF* __restrict__ thvrefh, const TF* __restrict__ exnh, const TF* __restrict__ ph)
+        {
+            const int ijk = g(i, j, k);
+            const int kk = g.kstride;
+
+            // Half level temperature and moisture content
+            const TF thh = static_cast<TF>(0.5) * (th[ijk-kk] + th[ijk]); // Half level liq. water pot. temp.
+            const TF qth = static_cast<TF>(0.5) * (qt[ijk-kk] + qt[ijk]); // Half level specific hum.
+
+            Struct_sat_adjust<TF> ssa = sat_adjust_g(thh, qth, ph[k], exnh[k]);
+
+            // Calculate tendency.
+            if (ssa.ql + ssa.qi > 0)
+                wt[ijk] += buoyancy(exnh[k], thh, qth, ssa.ql, ssa.qi, thvrefh[k]);
+            else
+                wt[ijk] += buoyancy_no_ql(thh, qth, thvrefh[k]);
+        }
+    };
+
+    template<typename TF>
+    struct calc_liquid_water_g
+    {
+        DEFINE_GRID_KERNEL("thermo_moist::calc_liquid_water", 0)
+
+        template <typename Level>
+        CUDA_DEVICE
+        void operator()(
+                Grid_layout g, const int i, const int j, const int k, const Level level,
+                TF* __restrict__ ql, const TF* __restrict__ th, const TF* __restrict__ qt,
+                const TF* __restrict__ exn, const TF* __restrict__ p)
+        {
+            const int ijk = g(i, j, k);
+            ql[ijk] = sat_adjust_g(th[ijk], qt[ijk], p[k], exn[k]).ql;
+        }
+    };
+}
+#endif
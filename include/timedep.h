@@ -26,6 +26,7 @@
 #include "master.h"
 #include "grid.h"
 #include "timeloop.h"
+#include "node_shared_vector.h"
 
 class Master;
 template<typename> class Grid;
@@ -37,6 +38,10 @@ class Timedep
 {
     public:
         Timedep(Master&, Grid<TF>&, const std::string, const bool);
+
+        // Several profiles with the same time dimension share one block of input data ordered as
+        // [time][variable][k], and are updated at once into consecutive profiles of the output.
+        Timedep(Master&, Grid<TF>&, const std::vector<std::string>&, const bool);
         ~Timedep();
 
         void create_timedep(Netcdf_handle&, const std::string);
@@ -58,11 +63,22 @@ class Timedep
     private:
         Master& master;
         Grid<TF>& grid;
-        const std::string varname;
+        const std::vector<std::string> varnames;
 
         Timedep_switch sw;
 
         std::vector<double> time;
-        std::vector<TF> data;
+        std::vector<unsigned long> itime_in; ///< Input times converted once to integer time.
+        Node_shared_vector<TF> data; ///< Single copy per node of the input data.
+
+        // The time bracket and factors of the last update, and the profile it was written to, such
+        // that the substeps at the same time and the steps within one bracket skip the search.
+        Interpolation_factors<TF> ifac;
+        unsigned long itime_ifac;
+        unsigned long itime_prof;
+        const TF* prof_last;
+
+        const Interpolation_factors<TF>& get_interpolation_factors(Timeloop<TF>&);
+        bool is_up_to_date(const TF*, Timeloop<TF>&);
 };
 #endif
@@ -25,6 +25,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <ctime>
 
 class Master;
@@ -59,15 +60,22 @@ class Timeloop
         void set_time_step_limit();
         void set_time_step_limit(unsigned long);
         double get_sub_time_step() const;
+        double get_sub_time_step_tendency_factor() const;
 
         Interpolation_factors<TF> get_interpolation_factors(const std::vector<double>&);
 
         void exec();
 
+        // Exponential decay and lower limit of a prognostic field that the CPU update of the current
+        // substep applies, instead of separate passes over the tendency by Decay and Limiter.
+        void add_rk_decay(const std::string&, TF);
+        void add_rk_limit(const std::string&, TF);
+
         double check();
 
         void save(int, unsigned long, unsigned long, int);
         void load(int);
+        void set_checkpoint_time(unsigned long, unsigned long, int); ///< Continue from the time of a checkpoint.
 
         // Query functions for main loop
         bool in_substep();
@@ -87,12 +95,20 @@ class Timeloop
         int get_iteration() const { return iteration; }
         int get_substep() const { return substep; }
 
+        /// Projected wall clock time (s) to reach the end time, or -1 if there are no measured steps yet.
+        double get_wall_time_remaining() const;
+
         // Functions for UTC time support.
         bool has_utc_time() const { return flag_utc_time; }
         std::string get_datetime_utc_start_string() const;
-        double calc_day_of_year() const;
-        double calc_hour_of_day() const;
-        int get_year() const;
+        double calc_day_of_year() const { return calc_day_of_year(time); }
+        double calc_hour_of_day() const { return calc_hour_of_day(time); }
+        int get_year() const { return get_year(time); }
+
+        // The same at a given model time, e.g. that of the next radiation step.
+        double calc_day_of_year(double) const;
+        double calc_hour_of_day(double) const;
+        int get_year(double) const;
 
     private:
         Master& master;
@@ -136,6 +152,33 @@ class Timeloop
         unsigned long isavetime;
         unsigned long idtlim;
         unsigned long iiotimeprec;
+
+        // Measured performance, for the wall clock limit and the projected run time.
+        double wall_clock_margin; ///< Wall clock time (s) reserved for writing the final restart files.
+        double wall_time_prev;
+        double wall_per_step;     ///< Running mean of the wall clock time per time step.
+        double wall_per_sim_time; ///< Running mean of the wall clock time per simulated second.
+
+        // With swautosave, the restart files are saved every nsave_interval-th savetime, with the interval
+        // at the Young/Daly optimum sqrt(2*save_cost*mtbf) of the measured save cost and the failure rate.
+        bool swautosave;
+        double mtbf;       ///< Mean wall clock time (s) between failures.
+        double save_cost;  ///< Running mean of the wall clock time (s) of a save.
+        bool save_step;    ///< Whether the restart files were saved after the last step.
+        int nsave_interval;
+        int nsave_skipped; ///< Number of save times since the last save.
+
+        void set_save_interval();
+
+        bool at_wall_clock_limit();
+
+        struct Rk_hook
+        {
+            TF decay_rate = TF(0.);
+            bool limit = false;
+            TF min_value = TF(0.);
+        };
+        std::map<std::string, Rk_hook> rk_hooks; ///< Hooks of the current substep, cleared by exec().
 };
 
 
@@ -144,4 +187,16 @@ inline unsigned long convert_to_itime(const double time_var)
 {
     return static_cast<unsigned long>(ifactor * time_var + 0.5);
 }
+
+// Output that is sampled at the times ioffset + n*isampletime, with ioffset < isampletime, such that
+// outputs with commensurate sample times can be staggered instead of all landing on the same step.
+inline bool is_sample_time(const unsigned long itime, const unsigned long isampletime, const unsigned long ioffset)
+{
+    return (itime + isampletime - ioffset) % isampletime == 0;
+}
+
+inline unsigned long get_sample_time_limit(const unsigned long itime, const unsigned long isampletime, const unsigned long ioffset)
+{
+    return isampletime - (itime + isampletime - ioffset) % isampletime;
+}
 #endif
@@ -0,0 +1,168 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef USECUDA
+#include <cuda_runtime.h>
+#endif
+
+#ifdef USENVML
+#include <nvml.h>
+#endif
+
+#ifdef USEPAPI
+#include <papi.h>
+#endif
+
+class Master;
+class Input;
+
+/**
+ * Timers of the module calls in the time loop.
+ * Each section accumulates the wall clock time between start() and stop(), the part of it
+ * spent waiting in Master::wait_all() and, on the GPU, the device time between two events
+ * on the default stream. Every `interval` iterations, the times are reduced over all
+ * processes and their minimum, mean and maximum are appended to (casename).timing,
+ * such that load imbalance shows up as a spread. Sections of which the maximum over the
+ * processes exceeds the mean by more than `imbalance` are also reported with a histogram
+ * of the time per process. In builds with USENVTX, each section is also pushed as an
+ * NVTX range, regardless of swtimer.
+ * With swenergy, each section also accumulates the energy of the CPU packages from the RAPL
+ * counters in /sys/class/powercap and, in builds with USENVML, of the GPU from the NVML energy
+ * counter, which are reported in J per iteration. The counters cover the whole package or device,
+ * such that processes that share one each report its full energy. To attribute the energy of the
+ * asynchronous kernels, the device is synchronized at the start and stop of each section.
+ * In builds with USEPAPI, the hardware counters in `papievents` are read at the start and stop
+ * of each section on every `papistride`-th process, and their totals over the run are written
+ * to (casename).papi by finish(). The counters count the thread that calls the timer.
+ * Reads the following parameters from (case).ini file
+ *
+ * [timer]
+ * swtimer   ; enable the timers
+ * interval  ; output interval in iterations
+ * imbalance ; max/mean ratio above which a section is reported
+ * swenergy  ; enable the energy accounting
+ * papievents ; PAPI events to count, e.g. PAPI_TOT_CYC,PAPI_TOT_INS,PAPI_L3_TCM (USEPAPI)
+ * papistride ; count on the processes of which the id is a multiple of papistride (USEPAPI)
+ */
+class Timer
+{
+    public:
+        Timer(Master&, Input&, const std::string&);
+        ~Timer();
+
+        void start(const std::string&);
+        void stop(const std::string&);
+
+        /// Ignore the timers, e.g. during the capture of a CUDA graph that the events would invalidate.
+        void suspend() { suspended = true; }
+        void resume() { suspended = false; }
+
+        void exec(int, double); ///< Write and reset the timings at the output interval.
+        void finish(); ///< Write the summary of the hardware counters of the run.
+
+        /// Max/mean ratio over the processes of the wall clock time of the last output interval.
+        double get_imbalance(const std::string&) const;
+
+    private:
+        Master& master;
+
+        struct Section
+        {
+            int ncalls;
+            double wall_start;
+            double wall_time;
+            double mpi_start;
+            double mpi_time;
+            double gpu_time;
+            double imbalance;
+            double cpu_energy_start;
+            double cpu_energy;
+            double gpu_energy_start;
+            double gpu_energy;
+
+            // Totals of the run for the summary of the hardware counters.
+            int ncalls_total;
+            double wall_time_total;
+            std::vector<long long> papi_start{};
+            std::vector<long long> papi_count{};
+
+            #ifdef USECUDA
+            cudaEvent_t event_start;
+            cudaEvent_t event_stop;
+            bool pending; ///< The last stop event has not been added to `gpu_time` yet.
+            #endif
+        };
+
+        bool swtimer;
+        bool swenergy;
+        bool suspended;
+        int interval;
+        double imbalance_threshold;
+
+        std::string sim_name;
+        std::FILE* timing_file;
+
+        std::vector<std::string> names; ///< Sections in order of their first use.
+        std::map<std::string, Section> sections;
+
+        void report_imbalance(const std::vector<double>&);
+
+        // Energy counters, accumulated in J since the start such that deltas survive a wrap.
+        struct Rapl_domain
+        {
+            std::string path;
+            double max_range; ///< Range of the counter in uJ, after which it wraps.
+            double last;      ///< Last reading in uJ.
+        };
+
+        std::vector<Rapl_domain> rapl_domains;
+        double cpu_energy_total;
+        double gpu_energy_total;
+        unsigned long long gpu_energy_last; ///< Last reading of the NVML counter in mJ.
+        #ifdef USENVML
+        nvmlDevice_t nvml_device;
+        bool has_nvml;
+        #endif
+
+        std::vector<std::string> papi_events;
+        bool use_papi; ///< This process counts the events.
+        int papi_event_set;
+        std::vector<long long> papi_values;
+
+        void init_papi();
+        void init_energy();
+        double read_cpu_energy();
+        double read_gpu_energy();
+
+        #ifdef USECUDA
+        void add_gpu_time(Section&);
+        #endif
+};
+#endif
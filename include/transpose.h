@@ -27,7 +27,10 @@
 #include <mpi.h>
 #endif
 
+#include <vector>
+
 #include "defines.h"
+#include "master.h"
 
 class Master;
 template<typename> class Grid;
@@ -39,7 +42,7 @@ class Transpose
         Transpose(Master&, Grid<TF>&);
         ~Transpose();
 
-        void init();
+        void init(const int nchunks=1);
 
         void exec_zx(TF* const restrict, TF* const restrict); ///< Changes the transpose orientation from z to x.
         void exec_xz(TF* const restrict, TF* const restrict); ///< Changes the transpose orientation from x to z.
@@ -48,14 +51,24 @@ class Transpose
         void exec_yz(TF* const restrict, TF* const restrict); ///< Changes the transpose orientation from y to z.
         void exec_zy(TF* const restrict, TF* const restrict); ///< Changes the transpose orientation from z to y.
 
+        // Non-blocking transposes of one chunk of slices, to pipeline them with the FFTs.
+        void exec_xy_begin(TF* const restrict, TF* const restrict, const int); ///< Posts the xy-transpose of a chunk.
+        void exec_yx_begin(TF* const restrict, TF* const restrict, const int); ///< Posts the yx-transpose of a chunk.
+        void exec_chunk_finish(const int); ///< Waits for the transpose of a chunk.
+        int get_nchunks() const { return nchunks; }
+        void set_nchunks(const int); ///< Changes the number of chunks after init(), e.g. to tune it.
+
     private:
         Master& master;
         Grid<TF>& grid;
 
         void init_mpi();
+        void init_chunk_mpi();
         void exit_mpi();
         bool mpi_types_allocated;
 
+        int nchunks; ///< Number of chunks of slices for the pipelined transposes.
+
         #ifdef USEMPI
         MPI_Datatype transposez;  ///< MPI datatype containing base blocks for z-orientation in zx-transpose.
         MPI_Datatype transposez2; ///< MPI datatype containing base blocks for z-orientation in zy-transpose.
@@ -63,6 +76,45 @@ class Transpose
         MPI_Datatype transposex2; ///< MPI datatype containing base blocks for x-orientation in xy-transpose.
         MPI_Datatype transposey;  ///< MPI datatype containing base blocks for y-orientation in xy-transpose.
         MPI_Datatype transposey2; ///< MPI datatype containing base blocks for y-orientation in zy-transpose.
+        MPI_Datatype transposex2_chunk; ///< MPI datatype containing one chunk of transposex2.
+        MPI_Datatype transposey_chunk;  ///< MPI datatype containing one chunk of transposey.
+
+        std::vector<std::vector<MPI_Request>> chunk_reqs; ///< Requests of the pending chunk transposes.
+        std::vector<Comm_site> chunk_sites;               ///< Directions of the pending chunk transposes.
+
+        // Strided layout of the block that is exchanged with process n, starting at n*offset.
+        struct Block_layout
+        {
+            int offset;
+            int count;
+            int blocklen;
+            int stride;
+        };
+
+        // Persistent requests on the packed buffers for one transpose direction.
+        struct Transpose_plan
+        {
+            int np;
+            Block_layout send;
+            Block_layout recv;
+            Comm_site site;
+            std::vector<MPI_Request> reqs;
+        };
+
+        void init_plan(Transpose_plan&, const int, MPI_Comm, const Block_layout&, const Block_layout&, Comm_site);
+        void exec_plan(Transpose_plan&, TF* const restrict, const TF* const restrict);
+
+        bool sw_packed; ///< Use packed buffers and persistent requests instead of the MPI datatypes.
+
+        std::vector<TF> send_buffer;
+        std::vector<TF> recv_buffer;
+
+        Transpose_plan plan_zx;
+        Transpose_plan plan_xz;
+        Transpose_plan plan_xy;
+        Transpose_plan plan_yx;
+        Transpose_plan plan_yz;
+        Transpose_plan plan_zy;
         #endif
 };
 #endif
@@ -47,6 +47,7 @@ template<typename> class Stats;
  * turbstarttime   ; start time for turbines (s)
  * swturbstats     ; enable turbine statistics
  * turbstatperiod  ; period for turbine statistics (s)
+ * swmodel         ; rotor model, "disk" (default) or "line" (see actuator_line.h)
  */
 
 template<typename TF>
@@ -56,14 +57,35 @@ class Turbine
         Turbine(Master&, Grid<TF>&, Fields<TF>&, Input&, TF, TF, TF);
         ~Turbine();
 
-        void create();                ///< Setup turbine parameters.
-        void exec(Stats<TF>&, double);///< Apply turbine forcing.
+        void create();                ///< Setup the local part of the disk stencil.
+
+        TF get_weight_sum() const;    ///< Local sum of the unnormalised disk weights.
+        void normalise_weights(TF);   ///< Normalise the weights with the sum over all ranks.
+
+        bool is_active(double time) const { return time >= turbstarttime; }
+        bool is_yaw_update(double time) const { return is_active(time) && swdynyaw && time >= next_yaw; }
+
+        int get_yaw_reference_index() const; ///< Local index of the upstream reference point, -1 if not on this rank.
+        void update_yaw(TF, TF);             ///< Relax the yaw towards the wind direction at the reference point.
+
+        void calc_disk_sums(TF&, TF&, const TF* const, const TF* const) const; ///< Local weighted sums of u and v over the disk.
+        void set_disk_velocity(TF, TF);      ///< Set thrust and power from the disk sums over all ranks.
+        void apply_forcing(TF* const, TF* const) const; ///< Apply actuator disk forcing to the local cells.
 
         TF get_power() const { return power; }
+        void set_power(TF p) { power = p; }
+        TF get_yaw() const { return yaw; }
+        TF get_thrust() const { return thrust; }
+        TF get_disk_velocity() const { return umean; }
+
+        TF get_x() const { return xpos; }
+        TF get_y() const { return ypos; }
+        TF get_hub_height() const { return hhub; }
+        TF get_diam() const { return diam; }
+        TF get_tsr() const { return tsr; }
 
-        // GPU interface
-        void prepare_device();
-        void clear_device();
+        const std::vector<int>& get_indices() const { return indices; }
+        const std::vector<TF>& get_weights() const { return weights; }
 
     private:
         Master& master;  ///< Reference to global simulation controller
@@ -89,15 +111,12 @@ class Turbine
         TF area;         ///< Disk area (m^2)
         int k_hub;       ///< Grid index of hub height
 
-        std::vector<int> indices; ///< Grid indices covered by disk
+        std::vector<int> indices; ///< Local grid indices covered by disk
         std::vector<TF> weights;  ///< Corresponding Gaussian weights
 
+        TF umean;        ///< Disk-averaged rotor-normal velocity (m s-1)
+        TF thrust;       ///< Instantaneous thrust per unit weight
         TF power;        ///< Instantaneous turbine power (W)
-
-        // GPU containers
-        #ifdef USECUDA
-        cuda_vector<TF> dummy_g; ///< placeholder for future GPU data
-        #endif
 };
 
 #endif
@@ -25,7 +25,10 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include "turbine.h"
+#include "actuator_line.h"
+#include "cuda_buffer.h"
 
 class Master;
 class Input;
@@ -59,8 +62,10 @@ class Windfarm
 
         TF get_farm_power() const { return farm_power; }
 
+        #ifdef USECUDA
         void prepare_device();
         void clear_device();
+        #endif
 
     private:
         Master& master;   ///< Global simulation controller
@@ -78,10 +83,27 @@ class Windfarm
         std::string layoutfile; ///< Optional manual layout file
 
         TF diam;          ///< Turbine diameter (m)
+        std::string swmodel; ///< Rotor model: actuator disk ("disk") or rotating actuator line ("line")
+
+        std::unique_ptr<Actuator_line<TF>> actuator_line; ///< Blades of all turbines for swmodel=line
         
         TF farm_power;    ///< Aggregate power output (W)
 
         std::vector<Turbine<TF>> turbines; ///< Container of turbines
+
+        /// Per turbine, the disk sums of u and v and the u and v at the yaw reference point.
+        static constexpr int n_sums = 4;
+
+        #ifdef USECUDA
+        // Disk stencils of all turbines, concatenated such that they are handled in one launch.
+        std::vector<int> cell_offsets; ///< Start of the cells of each turbine (size nturb+1)
+        cuda_vector<int> cell_offsets_g;
+        cuda_vector<int> cell_turbine_g; ///< Turbine of each cell
+        cuda_vector<int> indices_g;      ///< Grid index of each cell
+        cuda_vector<TF> weights_g;       ///< Disk weight of each cell
+        cuda_vector<TF> disk_sums_g;     ///< Disk sums of u and v of each turbine
+        cuda_vector<TF> force_g;         ///< Forcing in x and y of each turbine
+        #endif
 };
 
 #endif
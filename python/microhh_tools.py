@@ -244,6 +244,34 @@ class Read_statistics:
         return 'Available variables:\n{}'.format(', '.join(self.names.keys()))
 
 
+def read_timing(timing_file):
+    """
+    Read the (case).timing file of the module timers. Returns per section the number of calls,
+    and the minimum, mean and maximum over the processes of the wall, MPI wait and GPU time,
+    summed over all output intervals in the file.
+    """
+    time_keys = [
+        'wall_min', 'wall_mean', 'wall_max',
+        'mpi_min', 'mpi_mean', 'mpi_max',
+        'gpu_min', 'gpu_mean', 'gpu_max']
+
+    sections = {}
+    with open(timing_file, 'r') as f:
+        for row in csv.DictReader(f):
+            # A restarted run appends its own header.
+            if row['iteration'] == 'iteration':
+                continue
+
+            section = sections.setdefault(
+                row['section'], dict({'ncalls': 0}, **{key: 0. for key in time_keys}))
+
+            section['ncalls'] += int(row['ncalls'])
+            for key in time_keys:
+                section[key] += float(row[key])
+
+    return sections
+
+
 class Read_grid:
     """ Read the grid file from MicroHH.
         If no file name is provided, grid.0000000 from the current directory is read """
@@ -288,23 +316,54 @@ class Read_grid:
                     n * self.TF)))
 
 
+def read_sparse(grid, filename):
+    """
+    Read a sparse binary file from MicroHH, which holds the number of non-zero values,
+    their global indices in the dense field and the values themselves.
+    Returns the indices and the values.
+    """
+    with open(filename, 'rb') as f:
+        n = int(np.fromfile(f, dtype='{}u8'.format(grid.en), count=1)[0])
+        index = np.fromfile(f, dtype='{}u8'.format(grid.en), count=n)
+        values = np.fromfile(f, dtype='{}{}'.format(grid.en, grid.prec), count=n)
+
+    return index, values
+
+
 class Read_binary:
-    """ Read a binary file from MicroHH. """
+    """
+    Read a binary file from MicroHH. Without the file, its sparse version
+    (filename.sparse) is read, of which the zeros are filled in.
+    """
 
     def __init__(self, grid, filename):
         self.en = grid.en
         self.prec = grid.prec
         self.TF = grid.TF
+        self.sparse = None
 
         try:
-            self.file = open(filename, 'rb')
+            if not os.path.exists(filename) and os.path.exists(filename + '.sparse'):
+                self.sparse = read_sparse(grid, filename + '.sparse')
+                self.pos = 0
+            else:
+                self.file = open(filename, 'rb')
         except BaseException:
             raise Exception('Cannot find file {}'.format(filename))
 
     def close(self):
-        self.file.close()
+        if self.sparse is None:
+            self.file.close()
 
     def read(self, n):
+        if self.sparse is not None:
+            index, values = self.sparse
+            data = np.zeros(n)
+            in_range = (index >= self.pos) & (index < self.pos + n)
+            data[index[in_range] - self.pos] = values[in_range]
+            self.pos += n
+            return data
+
         return np.array(
             st.unpack(
                 '{0}{1}{2}'.format(
@@ -587,9 +646,11 @@ def execute(command):
     return sp.returncode
 
 
-def run_cases(cases, executable, mode, outputfile=''):
+def run_cases(cases, executable, mode, outputfile='', launcher='mpiexec --oversubscribe -n {ntasks}'):
     """
-    Function that iterates over a list of cases and runs all of them
+    Function that iterates over a list of cases and runs all of them.
+    In mode `cpumpi`, the command is prefixed with `launcher`, in which
+    {ntasks} is replaced by the number of MPI tasks (e.g. 'srun -n {ntasks}').
     """
 
     if not os.path.exists(executable):
@@ -655,8 +716,8 @@ def run_cases(cases, executable, mode, outputfile=''):
                 if mode == 'cpu' or mode == 'gpu':
                     execute('{} {} {}'.format(executable, phase, case.name))
                 elif mode == 'cpumpi':
-                    execute('mpiexec --oversubscribe -n {} {} {} {}'.format(
-                        ntasks, executable, phase, case.name))
+                    execute('{} {} {} {}'.format(
+                        launcher.format(ntasks=ntasks), executable, phase, case.name))
                 else:
                     raise ValueError('{} is an illegal value for mode'.format(mode))
 
@@ -1009,6 +1070,91 @@ def run_restart(
     return 0
 
 
+def create_ensemble(case_name, member_options, casedir='.', files=None, input_script=None):
+    """
+    Create the member directories (case)_000, (case)_001, ... of an ensemble that runs in a single
+    MPI job as `mpiexec -n (nmembers*nprocs) microhh run (case) (nmembers)`. Every member gets a copy
+    of `files` (the .ini file and input script by default), with the options of its entry in
+    `member_options` (a list of dicts of dicts as in Case) applied to its .ini file, after which
+    `input_script` ((case)_input.py by default) is run in its directory.
+    """
+    if files is None:
+        files = ['{}.ini'.format(case_name), '{}_input.py'.format(case_name)]
+    if input_script is None:
+        input_script = '{}_input.py'.format(case_name)
+
+    rootdir = os.getcwd()
+    member_dirs = []
+
+    for member, options in enumerate(member_options):
+        member_dir = os.path.join(casedir, '{}_{:03d}'.format(case_name, member))
+        os.makedirs(member_dir, exist_ok=True)
+
+        for fname in files:
+            shutil.copy(os.path.join(casedir, fname), member_dir)
+
+        ini_file = os.path.join(member_dir, '{}.ini'.format(case_name))
+        nl = Read_namelist(ini_file, ducktype=False)
+        for group, group_dict in options.items():
+            for variable, value in group_dict.items():
+                nl.set_value(group, variable, value)
+        nl.save(ini_file, allow_overwrite=True)
+
+        if input_script:
+            os.chdir(member_dir)
+            try:
+                execute('{} {}'.format(sys.executable, input_script))
+            finally:
+                os.chdir(rootdir)
+
+        member_dirs.append(member_dir)
+
+    return member_dirs
+
+
+def merge_ensemble_statistics(case_name, nmembers, mask='default', starttime=0, casedir='.', outputfile=None):
+    """
+    Merge the statistics files of the ensemble members into (case).(mask).(starttime).ensemble.nc,
+    in which every variable that is not a dimension gets a leading `member` dimension.
+    All members need to have the same grid and output times.
+    """
+    stat_name = '{}.{}.{:07d}.nc'.format(case_name, mask, starttime)
+    if outputfile is None:
+        outputfile = os.path.join(casedir, stat_name.replace('.nc', '.ensemble.nc'))
+
+    members = [
+        nc.Dataset(os.path.join(casedir, '{}_{:03d}'.format(case_name, m), stat_name), 'r')
+        for m in range(nmembers)]
+
+    def copy_group(src_groups, dst):
+        src = src_groups[0]
+        for name, dim in src.dimensions.items():
+            dst.createDimension(name, len(dim))
+
+        for name, var in src.variables.items():
+            is_dim = name in src.dimensions
+            dims = var.dimensions if is_dim else ('member',) + var.dimensions
+            dst_var = dst.createVariable(name, var.dtype, dims)
+            dst_var.setncatts({key: var.getncattr(key) for key in var.ncattrs() if key != '_FillValue'})
+
+            if is_dim:
+                dst_var[:] = var[:]
+            else:
+                for m, group in enumerate(src_groups):
+                    dst_var[m] = group.variables[name][:]
+
+        for name in src.groups:
+            copy_group([group.groups[name] for group in src_groups], dst.createGroup(name))
+
+    with nc.Dataset(outputfile, 'w') as f:
+        f.createDimension('member', nmembers)
+        f.createVariable('member', 'i4', ('member',))[:] = np.arange(nmembers)
+        copy_group(members, f)
+
+    for member in members:
+        member.close()
+
+
 def copy_or_link(src, dst, link = False):
     if os.path.exists(dst):
         if os.path.isfile(dst):
@@ -0,0 +1,145 @@
+"""
+Scaling study driver around cases/weakscaling. For every npx x npy layout, a variant of the
+case is generated and run for a fixed number of time steps with the module timers enabled.
+The times are written as a table to (prefix).txt and the efficiency, together with the split
+of the time per step into computation and time spent waiting for MPI, is plotted to (prefix).pdf.
+
+In weak scaling, the grid and domain grow with the layout, such that every process keeps the
+itot x jtot points of weakscaling.ini. In strong scaling, the grid is fixed to --itot x --jtot.
+
+usage: python run_scaling.py --type weak --layouts 1x1 2x1 2x2 4x2 4x4 --launcher 'srun -n {ntasks}'
+"""
+
+import argparse
+import sys
+import numpy as np
+sys.path.append('../python/')
+import microhh_tools as mht
+
+case_name = 'weakscaling'
+case_dir = '../cases/weakscaling'
+
+
+def parse_layout(layout):
+    npx, npy = layout.split('x')
+    return int(npx), int(npy)
+
+
+def scaling_options(nl, npx, npy, args):
+    dt = nl['time']['dt']
+    endtime = args.nsteps*dt
+
+    if args.type == 'weak':
+        grid = {
+            'itot': nl['grid']['itot']*npx,
+            'jtot': nl['grid']['jtot']*npy,
+            'xsize': nl['grid']['xsize']*npx,
+            'ysize': nl['grid']['ysize']*npy}
+    else:
+        grid = {
+            'itot': args.itot,
+            'jtot': args.jtot,
+            'xsize': nl['grid']['xsize']*args.itot/nl['grid']['itot'],
+            'ysize': nl['grid']['ysize']*args.jtot/nl['grid']['jtot']}
+
+    return {
+        'master': {'npx': npx, 'npy': npy},
+        'grid': grid,
+        'time': {'adaptivestep': False, 'endtime': endtime, 'savetime': endtime},
+        'timer': {'swtimer': 1, 'interval': args.nsteps}}
+
+
+def plot(prefix, type, procs, time, time_mpi):
+    import matplotlib
+    matplotlib.use('Agg')
+    import matplotlib.pyplot as pl
+
+    if type == 'weak':
+        efficiency = time[0] / time
+    else:
+        efficiency = (time[0]*procs[0]) / (time*procs)
+
+    fig, (ax1, ax2) = pl.subplots(1, 2, figsize=(10, 4))
+
+    ax1.plot(procs, efficiency, 'bo-')
+    ax1.axhline(1., color='k', linewidth=0.5)
+    ax1.set_xscale('log', base=2)
+    ax1.set_ylim(0., 1.2)
+    ax1.set_xlabel('#processes')
+    ax1.set_ylabel('efficiency')
+    ax1.set_title('{} scaling'.format(type))
+    ax1.grid()
+
+    x = np.arange(procs.size)
+    ax2.bar(x, time-time_mpi, label='computation')
+    ax2.bar(x, time_mpi, bottom=time-time_mpi, label='MPI wait')
+    ax2.set_xticks(x)
+    ax2.set_xticklabels(['{:d}'.format(p) for p in procs])
+    ax2.set_xlabel('#processes')
+    ax2.set_ylabel('time per step (s)')
+    ax2.legend(loc=0, frameon=False)
+
+    fig.tight_layout()
+    fig.savefig('{}.pdf'.format(prefix))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='MicroHH scaling study')
+    parser.add_argument('--type', default='weak', choices=['weak', 'strong'])
+    parser.add_argument('--layouts', nargs='+', default=['1x1', '2x1', '2x2', '4x2', '4x4'], help='npx x npy layouts')
+    parser.add_argument('--executable', default='../build/microhh')
+    parser.add_argument('--launcher', default='mpiexec -n {ntasks}', help='MPI launcher, {ntasks} is replaced by the number of tasks')
+    parser.add_argument('--nsteps', default=20, type=int, help='number of time steps per run')
+    parser.add_argument('--itot', default=256, type=int, help='grid points in x for strong scaling')
+    parser.add_argument('--jtot', default=256, type=int, help='grid points in y for strong scaling')
+    parser.add_argument('--prefix', default=None, help='name of the output files, (type)scaling by default')
+    args = parser.parse_args()
+
+    prefix = args.prefix if args.prefix else '{}scaling'.format(args.type)
+
+    nl = mht.Read_namelist('{}/{}.ini'.format(case_dir, case_name))
+
+    cases = []
+    for layout in args.layouts:
+        npx, npy = parse_layout(layout)
+        cases.append(mht.Case(
+            case_name,
+            casedir=case_dir,
+            rundir='{}_{}x{}'.format(prefix, npx, npy),
+            options=scaling_options(nl, npx, npy, args)))
+
+    mht.run_cases(cases, args.executable, 'cpumpi', launcher=args.launcher)
+
+    procs = []
+    time = []
+    time_mpi = []
+
+    with open('{}.txt'.format(prefix), 'w') as f:
+        f.write('{:>8s} {:>6s} {:>6s} {:>14s} {:>14s} {:>14s}\n'.format(
+            'procs', 'npx', 'npy', 'time_step', 'time_mpi', 'time_run'))
+
+        for case in cases:
+            npx = case.options['master']['npx']
+            npy = case.options['master']['npy']
+
+            if not case.success:
+                mht.print_warning('Layout {}x{} failed, skipping'.format(npx, npy))
+                continue
+
+            timing = mht.read_timing('{}/{}/{}.timing'.format(case.casedir, case.rundir, case_name))
+
+            # The mean over the processes of the time per step, summed over all modules.
+            time_step = sum(section['wall_mean'] for section in timing.values()) / args.nsteps
+            time_step_mpi = sum(section['mpi_mean'] for section in timing.values()) / args.nsteps
+
+            f.write('{:8d} {:6d} {:6d} {:14.6E} {:14.6E} {:14.6E}\n'.format(
+                npx*npy, npx, npy, time_step, time_step_mpi, case.time))
+
+            procs.append(npx*npy)
+            time.append(time_step)
+            time_mpi.append(time_step_mpi)
+
+    if len(procs) == 0:
+        sys.exit('None of the layouts ran successfully')
+
+    plot(prefix, args.type, np.array(procs), np.array(time), np.array(time_mpi))
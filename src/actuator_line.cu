@@ -0,0 +1,313 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "actuator_line.h"
+#include "actuator_line_kernels.h"
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "tools.h"
+
+#ifdef USECUDA
+namespace
+{
+    using namespace Actuator_line_kernels;
+
+    // Per turbine properties in `turb`.
+    constexpr int n_turb_props = 9;
+    enum Turb_prop {X_hub=0, Y_hub, Z_hub, Radius, Yaw, Azimuth_start, Azimuth, Omega, Active};
+
+    template<typename TF> __global__
+    void sample_g(
+            TF* const __restrict__ vel,
+            const TF* const __restrict__ u, const TF* const __restrict__ v, const TF* const __restrict__ w,
+            const int* const __restrict__ elem_ijk, const int n_elem)
+    {
+        const int e = blockIdx.x*blockDim.x + threadIdx.x;
+
+        if (e < n_elem)
+        {
+            vel[3*e  ] = (elem_ijk[3*e  ] >= 0) ? u[elem_ijk[3*e  ]] : TF(0);
+            vel[3*e+1] = (elem_ijk[3*e+1] >= 0) ? v[elem_ijk[3*e+1]] : TF(0);
+            vel[3*e+2] = (elem_ijk[3*e+2] >= 0) ? w[elem_ijk[3*e+2]] : TF(0);
+        }
+    }
+
+    // Blade element forces of all elements of all turbines.
+    template<typename TF> __global__
+    void blade_element_force_g(
+            TF* const __restrict__ fn, TF* const __restrict__ ft,
+            const TF* const __restrict__ vel, const TF* const __restrict__ turb,
+            const TF* const __restrict__ elem_r, const TF* const __restrict__ elem_dr,
+            const TF* const __restrict__ elem_twist,
+            const TF chord, const TF cl_alpha, const TF cl_max, const TF cd,
+            const int nblades, const int nelements, const int n_elem)
+    {
+        const int e = blockIdx.x*blockDim.x + threadIdx.x;
+
+        if (e < n_elem)
+        {
+            const int t = e / (nblades*nelements);
+            const int b = (e / nelements) % nblades;
+            const TF* const tp = &turb[n_turb_props*t];
+
+            if (tp[Active] == TF(0))
+            {
+                fn[e] = TF(0);
+                ft[e] = TF(0);
+                return;
+            }
+
+            const TF theta = tp[Azimuth] + TF(2.*M_PI)*b/nblades;
+
+            TF nx, ny, rx, ry, rz, tx, ty, tz;
+            blade_vectors(nx, ny, rx, ry, rz, tx, ty, tz, tp[Yaw], theta);
+
+            const TF un = vel[3*e]*nx + vel[3*e+1]*ny;
+            const TF us = tp[Omega]*elem_r[e] - (vel[3*e]*tx + vel[3*e+1]*ty + vel[3*e+2]*tz);
+
+            blade_element_force(
+                    fn[e], ft[e], un, us, elem_dr[e], elem_twist[e],
+                    chord, cl_alpha, cl_max, cd);
+        }
+    }
+
+    // Gaussian projection of the element forces, one block per element. The threads
+    // cover the box of 3 epsilon around the element, the sub-rotations are looped over.
+    template<typename TF> __global__
+    void project_forces_g(
+            TF* const __restrict__ ut, TF* const __restrict__ vt, TF* const __restrict__ wt,
+            const TF* const __restrict__ fn, const TF* const __restrict__ ft,
+            const TF* const __restrict__ turb, const int* const __restrict__ nsub,
+            const TF* const __restrict__ elem_r,
+            const TF* const __restrict__ x, const TF* const __restrict__ y,
+            const TF* const __restrict__ z, const TF* const __restrict__ zh,
+            const TF epsilon, const TF dx, const TF dy,
+            const int nblades, const int nelements,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        const int e = blockIdx.x;
+        const int t = e / (nblades*nelements);
+        const int b = (e / nelements) % nblades;
+        const TF* const tp = &turb[n_turb_props*t];
+
+        if (fn[e] == TF(0) && ft[e] == TF(0))
+            return;
+
+        const TF dist = TF(3)*epsilon;
+        const int ni = static_cast<int>(ceil(TF(2)*dist/dx)) + 2;
+        const int nj = static_cast<int>(ceil(TF(2)*dist/dy)) + 2;
+
+        const int n_sub = nsub[t];
+
+        for (int n=0; n<n_sub; ++n)
+        {
+            const TF frac = (n + TF(0.5)) / n_sub;
+            const TF theta = tp[Azimuth_start] + frac*(tp[Azimuth] - tp[Azimuth_start]) + TF(2.*M_PI)*b/nblades;
+
+            TF nx, ny, rx, ry, rz, tx, ty, tz;
+            blade_vectors(nx, ny, rx, ry, rz, tx, ty, tz, tp[Yaw], theta);
+
+            const TF xe = tp[X_hub] + elem_r[e]*rx;
+            const TF ye = tp[Y_hub] + elem_r[e]*ry;
+            const TF ze = tp[Z_hub] + elem_r[e]*rz;
+
+            // The force on the flow opposes the force on the blade.
+            const TF fx = -(fn[e]*nx + ft[e]*tx) / n_sub;
+            const TF fy = -(fn[e]*ny + ft[e]*ty) / n_sub;
+            const TF fz = -(           ft[e]*tz) / n_sub;
+
+            const int i0 = istart + static_cast<int>(floor((xe - dist - x[istart])/dx)) - 1;
+            const int j0 = jstart + static_cast<int>(floor((ye - dist - y[jstart])/dy)) - 1;
+
+            // Vertical range of the cells within reach of the element.
+            int k0 = kend;
+            int k1 = kstart;
+            for (int k=kstart; k<kend; ++k)
+                if (zh[k+1] > ze-dist && zh[k] < ze+dist)
+                {
+                    k0 = min(k0, k);
+                    k1 = max(k1, k+2);
+                }
+            k1 = min(k1, kend);
+            const int nk = max(k1-k0, 0);
+
+            for (int m=threadIdx.x; m<ni*nj*nk; m+=blockDim.x)
+            {
+                const int i = i0 + m%ni;
+                const int j = j0 + (m/ni)%nj;
+                const int k = k0 + m/(ni*nj);
+
+                if (i < istart || i >= iend || j < jstart || j >= jend)
+                    continue;
+
+                const int ijk = i + j*icells + k*ijcells;
+
+                // The horizontal grid is equidistant, so the half levels follow from the full levels.
+                const TF xh = x[i] - TF(0.5)*dx;
+                const TF yh = y[j] - TF(0.5)*dy;
+
+                TF d2 = fm::pow2(xh-xe) + fm::pow2(y[j]-ye) + fm::pow2(z[k]-ze);
+                if (d2 < dist*dist)
+                    atomicAdd(&ut[ijk], fx*gaussian(d2, epsilon));
+
+                d2 = fm::pow2(x[i]-xe) + fm::pow2(yh-ye) + fm::pow2(z[k]-ze);
+                if (d2 < dist*dist)
+                    atomicAdd(&vt[ijk], fy*gaussian(d2, epsilon));
+
+                d2 = fm::pow2(x[i]-xe) + fm::pow2(y[j]-ye) + fm::pow2(zh[k]-ze);
+                if (k > kstart && d2 < dist*dist)
+                    atomicAdd(&wt[ijk], fz*gaussian(d2, epsilon));
+            }
+        }
+    }
+}
+
+template<typename TF>
+void Actuator_line<TF>::prepare_device()
+{
+    turb.resize(n_turb_props*nturb);
+
+    turb_g.allocate(n_turb_props*nturb);
+    nsub_g.allocate(nturb);
+    elem_r_g.from_vector(elem_r);
+    elem_dr_g.from_vector(elem_dr);
+    elem_twist_g.from_vector(elem_twist);
+    elem_ijk_g.from_vector(elem_ijk);
+    elem_vel_g.allocate(3*n_elem);
+    elem_fn_g.allocate(n_elem);
+    elem_ft_g.allocate(n_elem);
+}
+
+template<typename TF>
+void Actuator_line<TF>::clear_device()
+{
+    turb_g.free();
+    nsub_g.free();
+    elem_r_g.free();
+    elem_dr_g.free();
+    elem_twist_g.free();
+    elem_ijk_g.free();
+    elem_vel_g.free();
+    elem_fn_g.free();
+    elem_ft_g.free();
+}
+
+template<typename TF>
+void Actuator_line<TF>::sample(TF* const vel)
+{
+    if (n_elem == 0)
+        return;
+
+    // The sample indices change with the rotation.
+    cuda_copy<int>(elem_ijk.data(), elem_ijk_g, 3*n_elem);
+
+    const int blocki = 128;
+    const int gridi = n_elem/blocki + (n_elem%blocki > 0);
+
+    sample_g<TF><<<gridi, blocki>>>(
+            elem_vel_g,
+            fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+            elem_ijk_g, n_elem);
+    cuda_check_error();
+
+    cuda_copy<TF>(elem_vel_g, vel, 3*n_elem);
+}
+
+template<typename TF>
+void Actuator_line<TF>::exec(std::vector<Turbine<TF>>& turbines, const TF* const vel, const double time)
+{
+    if (n_elem == 0)
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    for (int t=0; t<nturb; ++t)
+    {
+        // The rotor runs at the design tip speed ratio of the disk-averaged inflow.
+        omega[t] = turbines[t].is_active(time)
+            ? turbines[t].get_tsr() * std::max(turbines[t].get_disk_velocity(), TF(0)) / radius[t]
+            : TF(0);
+
+        TF* const tp = &turb[n_turb_props*t];
+        tp[X_hub] = x_hub[t];
+        tp[Y_hub] = y_hub[t];
+        tp[Z_hub] = z_hub[t];
+        tp[Radius] = radius[t];
+        tp[Yaw] = yaw[t];
+        tp[Azimuth_start] = azimuth_start[t];
+        tp[Azimuth] = azimuth[t];
+        tp[Omega] = omega[t];
+        tp[Active] = turbines[t].is_active(time) ? TF(1) : TF(0);
+    }
+
+    cuda_copy<TF>(turb.data(), turb_g, n_turb_props*nturb);
+    cuda_copy<int>(nsub.data(), nsub_g, nturb);
+    cuda_copy<TF>(vel, elem_vel_g, 3*n_elem);
+
+    const int blocki = 128;
+    const int gridi = n_elem/blocki + (n_elem%blocki > 0);
+
+    blade_element_force_g<TF><<<gridi, blocki>>>(
+            elem_fn_g, elem_ft_g, elem_vel_g, turb_g,
+            elem_r_g, elem_dr_g, elem_twist_g,
+            chord, cl_alpha, cl_max, cd,
+            nblades, nelements, n_elem);
+    cuda_check_error();
+
+    // The power of each turbine follows from the torque of its elements.
+    cuda_copy<TF>(elem_ft_g, elem_ft.data(), n_elem);
+
+    for (int t=0; t<nturb; ++t)
+    {
+        if (!turbines[t].is_active(time))
+            continue;
+
+        TF torque = TF(0);
+        for (int e=t*nblades*nelements; e<(t+1)*nblades*nelements; ++e)
+            torque += elem_ft[e]*elem_r[e];
+
+        turbines[t].set_power(torque*omega[t]);
+    }
+
+    project_forces_g<TF><<<n_elem, 256>>>(
+            fields.mt.at("u")->fld_g, fields.mt.at("v")->fld_g, fields.mt.at("w")->fld_g,
+            elem_fn_g, elem_ft_g, turb_g, nsub_g, elem_r_g,
+            gd.x_g, gd.y_g, gd.z_g, gd.zh_g,
+            epsilon, gd.dx, gd.dy,
+            nblades, nelements,
+            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+            gd.icells, gd.ijcells);
+    cuda_check_error();
+}
+#endif
+
+
+#ifdef FLOAT_SINGLE
+template class Actuator_line<float>;
+#else
+template class Actuator_line<double>;
+#endif
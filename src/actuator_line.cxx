@@ -0,0 +1,352 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "actuator_line.h"
+#include "actuator_line_kernels.h"
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "input.h"
+
+namespace
+{
+    using namespace Actuator_line_kernels;
+
+    // Local index of the grid point nearest to `pos` on an equidistant horizontal grid with
+    // its first point at `offset`, or -1 if the point is on another rank.
+    template<typename TF>
+    int nearest_local_index(
+            const TF pos, const TF offset, const TF dx,
+            const int mpicoord, const int nmax, const int start)
+    {
+        const int i = static_cast<int>(std::floor((pos - offset)/dx + TF(0.5))) - mpicoord*nmax;
+        return (i >= 0 && i < nmax) ? i + start : -1;
+    }
+
+    template<typename TF>
+    int nearest_vertical_index(const TF pos, const std::vector<TF>& z, const int kstart, const int kend)
+    {
+        int k_min = kstart;
+        for (int k=kstart+1; k<kend; ++k)
+            if (std::abs(z[k] - pos) < std::abs(z[k_min] - pos))
+                k_min = k;
+        return k_min;
+    }
+
+    // Add the force `f` of a blade element at (`xe`, `ye`, `ze`), projected with a Gaussian
+    // kernel, to the tendency `at` on the grid (`x`, `y`, `z`), within 3 `epsilon`.
+    template<typename TF>
+    void project_force(
+            TF* const restrict at, const TF f,
+            const TF xe, const TF ye, const TF ze,
+            const TF* const restrict x, const TF* const restrict y, const TF* const restrict z,
+            const TF epsilon, const TF dx, const TF dy,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        const TF dist = TF(3)*epsilon;
+
+        const int i0 = std::max(istart, istart + static_cast<int>(std::floor((xe - dist - x[istart])/dx)));
+        const int i1 = std::min(iend,   istart + static_cast<int>(std::ceil ((xe + dist - x[istart])/dx)) + 1);
+        const int j0 = std::max(jstart, jstart + static_cast<int>(std::floor((ye - dist - y[jstart])/dy)));
+        const int j1 = std::min(jend,   jstart + static_cast<int>(std::ceil ((ye + dist - y[jstart])/dy)) + 1);
+
+        for (int k=kstart; k<kend; ++k)
+        {
+            const TF dz2 = fm::pow2(z[k] - ze);
+            if (dz2 > dist*dist)
+                continue;
+
+            for (int j=j0; j<j1; ++j)
+                for (int i=i0; i<i1; ++i)
+                {
+                    const TF d2 = fm::pow2(x[i] - xe) + fm::pow2(y[j] - ye) + dz2;
+                    if (d2 < dist*dist)
+                        at[i + j*icells + k*ijcells] += f * gaussian(d2, epsilon);
+                }
+        }
+    }
+}
+
+template<typename TF>
+Actuator_line<TF>::Actuator_line(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& input) :
+    master(masterin), grid(gridin), fields(fieldsin)
+{
+    auto& gd = grid.get_grid_data();
+
+    const TF diam = input.get_item<TF>("turbine", "diam", "");
+
+    nblades      = input.get_item<int>("turbine", "nblades", "", 3);
+    nelements    = input.get_item<int>("turbine", "nelements", "", 32);
+    chord        = input.get_item<TF>("turbine", "chord", "", TF(0.05)*diam);
+    cl_alpha     = input.get_item<TF>("turbine", "cl_alpha", "", TF(2.*M_PI));
+    cl_max       = input.get_item<TF>("turbine", "cl_max", "", TF(1.5));
+    cd           = input.get_item<TF>("turbine", "cd", "", TF(0.01));
+    alpha_design = input.get_item<TF>("turbine", "alpha_design", "", TF(6)) * TF(M_PI/180.);
+    epsilon      = input.get_item<TF>("turbine", "epsilon", "", TF(2)*gd.dx);
+    tip_cfl      = input.get_item<TF>("turbine", "tip_cfl", "", TF(0.5));
+
+    if (nblades < 1 || nelements < 1)
+        throw std::runtime_error("The actuator line needs at least one blade and one blade element");
+
+    nturb = 0;
+    n_elem = 0;
+    time_last = -1.;
+}
+
+template<typename TF>
+Actuator_line<TF>::~Actuator_line()
+{
+}
+
+template<typename TF>
+void Actuator_line<TF>::create(const std::vector<Turbine<TF>>& turbines)
+{
+    nturb = turbines.size();
+    n_elem = nturb*nblades*nelements;
+
+    radius.resize(nturb);
+    x_hub.resize(nturb);
+    y_hub.resize(nturb);
+    z_hub.resize(nturb);
+    yaw.resize(nturb);
+    omega.resize(nturb, TF(0));
+    azimuth_start.resize(nturb, TF(0));
+    azimuth.resize(nturb, TF(0));
+    nsub.resize(nturb, 1);
+
+    elem_r.resize(n_elem);
+    elem_dr.resize(n_elem);
+    elem_twist.resize(n_elem);
+    elem_ijk.resize(3*n_elem);
+    elem_fn.resize(n_elem, TF(0));
+    elem_ft.resize(n_elem, TF(0));
+
+    for (int t=0; t<nturb; ++t)
+    {
+        radius[t] = TF(0.5)*turbines[t].get_diam();
+        x_hub[t] = turbines[t].get_x();
+        y_hub[t] = turbines[t].get_y();
+        z_hub[t] = turbines[t].get_hub_height();
+        yaw[t] = turbines[t].get_yaw();
+
+        // Equidistant elements, twisted such that the blade runs at the design angle
+        // of attack in the Betz optimum inflow at the design tip speed ratio.
+        const TF dr = radius[t] / nelements;
+        const TF tsr = turbines[t].get_tsr();
+
+        for (int b=0; b<nblades; ++b)
+            for (int s=0; s<nelements; ++s)
+            {
+                const int e = (t*nblades + b)*nelements + s;
+                elem_r[e] = (s + TF(0.5))*dr;
+                elem_dr[e] = dr;
+                elem_twist[e] = std::atan(TF(2)*radius[t] / (TF(3)*tsr*elem_r[e])) - alpha_design;
+            }
+    }
+
+    set_sample_indices();
+}
+
+template<typename TF>
+void Actuator_line<TF>::advance(const std::vector<Turbine<TF>>& turbines, const double time)
+{
+    auto& gd = grid.get_grid_data();
+
+    for (int t=0; t<nturb; ++t)
+        yaw[t] = turbines[t].get_yaw();
+
+    // The blades rotate once per time step, all RK substeps use the same swept sector.
+    if (time_last >= 0. && time > time_last)
+    {
+        const TF dt = time - time_last;
+
+        for (int t=0; t<nturb; ++t)
+        {
+            azimuth_start[t] = azimuth[t];
+            azimuth[t] = std::fmod(azimuth[t] + omega[t]*dt, TF(2.*M_PI));
+            if (azimuth[t] < azimuth_start[t])
+                azimuth_start[t] -= TF(2.*M_PI);
+
+            const TF tip_displacement = omega[t]*radius[t]*dt;
+            nsub[t] = std::max(1, static_cast<int>(std::ceil(tip_displacement / (tip_cfl*std::min(gd.dx, gd.dy)))));
+        }
+
+        set_sample_indices();
+    }
+    else if (time_last < 0.)
+        set_sample_indices();
+
+    time_last = time;
+}
+
+template<typename TF>
+void Actuator_line<TF>::set_sample_indices()
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int jj = gd.icells;
+    const int kk = gd.ijcells;
+
+    for (int t=0; t<nturb; ++t)
+        for (int b=0; b<nblades; ++b)
+        {
+            TF nx, ny, rx, ry, rz, tx, ty, tz;
+            blade_vectors(nx, ny, rx, ry, rz, tx, ty, tz, yaw[t], azimuth[t] + TF(2.*M_PI)*b/nblades);
+
+            for (int s=0; s<nelements; ++s)
+            {
+                const int e = (t*nblades + b)*nelements + s;
+
+                const TF xe = x_hub[t] + elem_r[e]*rx;
+                const TF ye = y_hub[t] + elem_r[e]*ry;
+                const TF ze = z_hub[t] + elem_r[e]*rz;
+
+                // Nearest grid point of each velocity component on its staggered location.
+                const int iu = nearest_local_index(xe, TF(0),         gd.dx, md.mpicoordx, gd.imax, gd.istart);
+                const int ic = nearest_local_index(xe, TF(0.5)*gd.dx, gd.dx, md.mpicoordx, gd.imax, gd.istart);
+                const int jv = nearest_local_index(ye, TF(0),         gd.dy, md.mpicoordy, gd.jmax, gd.jstart);
+                const int jc = nearest_local_index(ye, TF(0.5)*gd.dy, gd.dy, md.mpicoordy, gd.jmax, gd.jstart);
+                const int kc = nearest_vertical_index(ze, gd.z,  gd.kstart, gd.kend);
+                const int kw = nearest_vertical_index(ze, gd.zh, gd.kstart, gd.kend);
+
+                elem_ijk[3*e  ] = (iu >= 0 && jc >= 0) ? iu + jc*jj + kc*kk : -1;
+                elem_ijk[3*e+1] = (ic >= 0 && jv >= 0) ? ic + jv*jj + kc*kk : -1;
+                elem_ijk[3*e+2] = (ic >= 0 && jc >= 0) ? ic + jc*jj + kw*kk : -1;
+            }
+        }
+}
+
+#ifndef USECUDA
+template<typename TF>
+void Actuator_line<TF>::sample(TF* const vel)
+{
+    const TF* const u = fields.mp.at("u")->fld.data();
+    const TF* const v = fields.mp.at("v")->fld.data();
+    const TF* const w = fields.mp.at("w")->fld.data();
+
+    for (int e=0; e<n_elem; ++e)
+    {
+        vel[3*e  ] = (elem_ijk[3*e  ] >= 0) ? u[elem_ijk[3*e  ]] : TF(0);
+        vel[3*e+1] = (elem_ijk[3*e+1] >= 0) ? v[elem_ijk[3*e+1]] : TF(0);
+        vel[3*e+2] = (elem_ijk[3*e+2] >= 0) ? w[elem_ijk[3*e+2]] : TF(0);
+    }
+}
+
+template<typename TF>
+void Actuator_line<TF>::exec(std::vector<Turbine<TF>>& turbines, const TF* const vel, const double time)
+{
+    auto& gd = grid.get_grid_data();
+
+    TF* const ut = fields.mt.at("u")->fld.data();
+    TF* const vt = fields.mt.at("v")->fld.data();
+    TF* const wt = fields.mt.at("w")->fld.data();
+
+    for (int t=0; t<nturb; ++t)
+    {
+        if (!turbines[t].is_active(time))
+            continue;
+
+        // The rotor runs at the design tip speed ratio of the disk-averaged inflow.
+        omega[t] = turbines[t].get_tsr() * std::max(turbines[t].get_disk_velocity(), TF(0)) / radius[t];
+
+        TF torque = TF(0);
+
+        for (int b=0; b<nblades; ++b)
+        {
+            const TF theta = azimuth[t] + TF(2.*M_PI)*b/nblades;
+
+            TF nx, ny, rx, ry, rz, tx, ty, tz;
+            blade_vectors(nx, ny, rx, ry, rz, tx, ty, tz, yaw[t], theta);
+
+            for (int s=0; s<nelements; ++s)
+            {
+                const int e = (t*nblades + b)*nelements + s;
+
+                const TF un = vel[3*e]*nx + vel[3*e+1]*ny;
+                const TF us = omega[t]*elem_r[e] - (vel[3*e]*tx + vel[3*e+1]*ty + vel[3*e+2]*tz);
+
+                blade_element_force(
+                        elem_fn[e], elem_ft[e], un, us, elem_dr[e], elem_twist[e],
+                        chord, cl_alpha, cl_max, cd);
+
+                torque += elem_ft[e]*elem_r[e];
+            }
+        }
+
+        turbines[t].set_power(torque*omega[t]);
+
+        // Project the forces on the flow, smeared over the sector swept in this time step.
+        for (int n=0; n<nsub[t]; ++n)
+        {
+            const TF frac = (n + TF(0.5)) / nsub[t];
+            const TF azimuth_sub = azimuth_start[t] + frac*(azimuth[t] - azimuth_start[t]);
+
+            for (int b=0; b<nblades; ++b)
+            {
+                const TF theta = azimuth_sub + TF(2.*M_PI)*b/nblades;
+
+                TF nx, ny, rx, ry, rz, tx, ty, tz;
+                blade_vectors(nx, ny, rx, ry, rz, tx, ty, tz, yaw[t], theta);
+
+                for (int s=0; s<nelements; ++s)
+                {
+                    const int e = (t*nblades + b)*nelements + s;
+
+                    const TF xe = x_hub[t] + elem_r[e]*rx;
+                    const TF ye = y_hub[t] + elem_r[e]*ry;
+                    const TF ze = z_hub[t] + elem_r[e]*rz;
+
+                    // The force on the flow opposes the force on the blade.
+                    const TF fx = -(elem_fn[e]*nx + elem_ft[e]*tx) / nsub[t];
+                    const TF fy = -(elem_fn[e]*ny + elem_ft[e]*ty) / nsub[t];
+                    const TF fz = -(                elem_ft[e]*tz) / nsub[t];
+
+                    project_force(ut, fx, xe, ye, ze, gd.xh.data(), gd.y.data(), gd.z.data(),
+                            epsilon, gd.dx, gd.dy, gd.istart, gd.iend, gd.jstart, gd.jend,
+                            gd.kstart, gd.kend, gd.icells, gd.ijcells);
+                    project_force(vt, fy, xe, ye, ze, gd.x.data(), gd.yh.data(), gd.z.data(),
+                            epsilon, gd.dx, gd.dy, gd.istart, gd.iend, gd.jstart, gd.jend,
+                            gd.kstart, gd.kend, gd.icells, gd.ijcells);
+                    project_force(wt, fz, xe, ye, ze, gd.x.data(), gd.y.data(), gd.zh.data(),
+                            epsilon, gd.dx, gd.dy, gd.istart, gd.iend, gd.jstart, gd.jend,
+                            gd.kstart+1, gd.kend, gd.icells, gd.ijcells);
+                }
+            }
+        }
+    }
+}
+#endif
+
+#ifdef FLOAT_SINGLE
+template class Actuator_line<float>;
+#else
+template class Actuator_line<double>;
+#endif
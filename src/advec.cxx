@@ -20,6 +20,7 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <memory>
 #include "grid.h"
 #include "fields.h"
@@ -44,6 +45,7 @@ Advec<TF>::Advec(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input
     cflmin(1.E-5)
 {
     cflmax = input.get_item<TF>("advec", "cflmax", "", 1.);
+    split_list = input.get_list<std::string>("advec", "splitlist", "", std::vector<std::string>());
 }
 
 template<typename TF>
@@ -51,6 +53,19 @@ Advec<TF>::~Advec()
 {
 }
 
+template<typename TF>
+bool Advec<TF>::is_split(const std::string& name) const
+{
+    return std::find(split_list.begin(), split_list.end(), name) != split_list.end();
+}
+
+template<typename TF>
+unsigned long Advec<TF>::get_time_limit_from_cfl(const unsigned long idt, const double cfl)
+{
+    // Prevent zero divisions.
+    return idt * cflmax / std::max(cflmin, cfl);
+}
+
 template<typename TF>
 std::shared_ptr<Advec<TF>> Advec<TF>::factory(
         Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& inputin)
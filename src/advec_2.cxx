@@ -26,6 +26,7 @@
 #include "grid.h"
 #include "fields.h"
 #include "stats.h"
+#include "thermo.h"
 #include "advec_2.h"
 #include "defines.h"
 #include "constants.h"
@@ -50,7 +51,7 @@ namespace
     template<typename TF>
     TF calc_cfl(const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
             const TF* const restrict dzi, const TF dx, const TF dy,
-            const TF dt, Master& master,
+            const TF dt,
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
@@ -61,6 +62,7 @@ namespace
 
         TF cfl = 0;
 
+        #pragma omp parallel for reduction(max:cfl)
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -70,8 +72,6 @@ namespace
                     cfl = std::max(cfl, std::abs(interp2(u[ijk], u[ijk+ii]))*dxi + std::abs(interp2(v[ijk], v[ijk+jj]))*dyi + std::abs(interp2(w[ijk], w[ijk+kk]))*dzi[k]);
                 }
 
-        master.max(&cfl, 1);
-
         cfl = cfl*dt;
 
         return cfl;
@@ -90,6 +90,7 @@ namespace
         const TF dxi = TF(1.)/dx;
         const TF dyi = TF(1.)/dy;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -121,6 +122,7 @@ namespace
         const TF dxi = TF(1.)/dx;
         const TF dyi = TF(1.)/dy;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -152,6 +154,7 @@ namespace
         const TF dxi = TF(1.)/dx;
         const TF dyi = TF(1.)/dy;
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -170,6 +173,51 @@ namespace
                 }
     }
 
+    // Advection of w with the buoyancy of `thermo` added in the same pass. The buoyancy of a level is
+    // computed into a plane per thread, such that wt is read and written once.
+    template<typename TF>
+    void advec_w_buoyancy(TF* const restrict wt,
+            const TF* const restrict u, const TF* const restrict v, TF* const restrict w,
+            const TF* const restrict dzhi, const TF dx, const TF dy,
+            const TF* const restrict rhoref, const TF* const restrict rhorefh,
+            const Thermo<TF>& thermo,
+            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        const int ii = 1;
+
+        const TF dxi = TF(1.)/dx;
+        const TF dyi = TF(1.)/dy;
+
+        #pragma omp parallel
+        {
+            std::vector<TF> b(kk);
+            std::vector<TF> work(4*kk);
+
+            #pragma omp for
+            for (int k=kstart+1; k<kend; ++k)
+            {
+                thermo.calc_buoyancy_plane_w(b.data(), work.data(), k);
+
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        wt[ijk] += b[i + j*jj]
+                                 - ( interp2(u[ijk+ii-kk], u[ijk+ii]) * interp2(w[ijk   ], w[ijk+ii])
+                                   - interp2(u[ijk   -kk], u[ijk   ]) * interp2(w[ijk-ii], w[ijk   ]) ) * dxi
+
+                                 - ( interp2(v[ijk+jj-kk], v[ijk+jj]) * interp2(w[ijk   ], w[ijk+jj])
+                                   - interp2(v[ijk   -kk], v[ijk   ]) * interp2(w[ijk-jj], w[ijk   ]) ) * dyi
+
+                                 - ( rhoref[k  ] * interp2(w[ijk   ], w[ijk+kk]) * interp2(w[ijk   ], w[ijk+kk])
+                                   - rhoref[k-1] * interp2(w[ijk-kk], w[ijk   ]) * interp2(w[ijk-kk], w[ijk   ]) ) / rhorefh[k] * dzhi[k];
+                    }
+            }
+        }
+    }
+
     template<typename TF>
     void advec_s(TF* const restrict st, const TF* const restrict s,
             const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
@@ -183,6 +231,7 @@ namespace
         const TF dxi = TF(1.)/dx;
         const TF dyi = TF(1.)/dy;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -209,6 +258,7 @@ namespace
     {
         const int ii = 1;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -225,6 +275,7 @@ namespace
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -241,6 +292,7 @@ namespace
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -256,6 +308,7 @@ namespace
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -279,12 +332,12 @@ void Advec_2<TF>::create(Stats<TF>& stats)
 
 #ifndef USECUDA
 template<typename TF>
-double Advec_2<TF>::get_cfl(double dt)
+double Advec_2<TF>::get_cfl_local(double dt)
 {
     auto& gd = grid.get_grid_data();
     TF cfl = calc_cfl<TF>(fields.mp.at("u")->fld.data(),fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
                           gd.dzi.data(), gd.dx, gd.dy,
-                          dt, master,
+                          dt,
                           gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
                           gd.icells, gd.ijcells);
 
@@ -293,19 +346,17 @@ double Advec_2<TF>::get_cfl(double dt)
 }
 
 template<typename TF>
-unsigned long Advec_2<TF>::get_time_limit(unsigned long idt, double dt)
+double Advec_2<TF>::get_cfl(double dt)
 {
-    // Calculate cfl and prevent zero divisons.
-    auto& gd = grid.get_grid_data();
-
-    double cfl = calc_cfl<TF>(fields.mp.at("u")->fld.data(),fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
-            gd.dzi.data(), gd.dx, gd.dy,
-            dt, master,
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    double cfl = get_cfl_local(dt);
+    master.max(&cfl, 1);
+    return cfl;
+}
 
-    cfl = std::max(cflmin, cfl);
-    return idt * cflmax / cfl;
+template<typename TF>
+unsigned long Advec_2<TF>::get_time_limit(unsigned long idt, double dt)
+{
+    return this->get_time_limit_from_cfl(idt, get_cfl(dt));
 }
 
 
@@ -327,20 +378,35 @@ void Advec_2<TF>::exec(Stats<TF>& stats)
             gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
             gd.icells, gd.ijcells);
 
-    advec_w(fields.mt.at("w")->fld.data(),
-            fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
-            gd.dzhi.data(), gd.dx, gd.dy,
-            fields.rhoref.data(), fields.rhorefh.data(),
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    if (thermo != nullptr && thermo->do_fused_buoyancy(stats))
+        advec_w_buoyancy(fields.mt.at("w")->fld.data(),
+                fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
+                gd.dzhi.data(), gd.dx, gd.dy,
+                fields.rhoref.data(), fields.rhorefh.data(),
+                *thermo,
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
+    else
+        advec_w(fields.mt.at("w")->fld.data(),
+                fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
+                gd.dzhi.data(), gd.dx, gd.dy,
+                fields.rhoref.data(), fields.rhorefh.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
 
     for (auto& it : fields.st)
+    {
+        if (is_split(it.first))
+            continue;
+
+        const auto box = fields.get_active_box(it.first);
         advec_s(it.second->fld.data(), fields.sp.at(it.first)->fld.data(),
                 fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
                 gd.dzi.data(), gd.dx, gd.dy,
                 fields.rhoref.data(), fields.rhorefh.data(),
-                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                box.istart, box.iend, box.jstart, box.jend, gd.kstart, box.kend,
                 gd.icells, gd.ijcells);
+    }
 
     stats.calc_tend(*fields.mt.at("u"), tend_name);
     stats.calc_tend(*fields.mt.at("v"), tend_name);
@@ -350,6 +416,13 @@ void Advec_2<TF>::exec(Stats<TF>& stats)
 }
 #endif
 
+template<typename TF>
+bool Advec_2<TF>::set_fused_buoyancy(const Thermo<TF>& thermoin)
+{
+    thermo = &thermoin;
+    return true;
+}
+
 template<typename TF>
 void Advec_2<TF>::get_advec_flux(
         Field3d<TF>& advec_flux, const Field3d<TF>& fld)
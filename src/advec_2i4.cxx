@@ -53,7 +53,7 @@ namespace
     TF calc_cfl(
             const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
             const TF* const restrict dzi, const TF dxi, const TF dyi,
-            const TF dt, Master& master,
+            const TF dt,
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
@@ -77,6 +77,7 @@ namespace
                                   + std::abs(interp2(w[ijk    ], w[ijk+kk1]))*dzi[k]);
             }
 
+        #pragma omp parallel for reduction(max:cfl)
         for (k=kstart+1; k<kend-1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -99,8 +100,6 @@ namespace
                                   + std::abs(interp2(w[ijk    ], w[ijk+kk1]))*dzi[k]);
             }
 
-        master.max(&cfl, 1);
-
         cfl = cfl*dt;
 
         return cfl;
@@ -162,6 +161,7 @@ namespace
                            - rhorefh[k  ] * interp2(w[ijk-ii1    ], w[ijk    ]) * interp2(u[ijk-kk1], u[ijk    ]) ) / rhoref[k] * dzi[k];
             }
 
+        #pragma omp parallel for
         for (k=kstart+2; k<kend-2; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -277,6 +277,7 @@ namespace
                            - rhorefh[k  ] * interp2(w[ijk-jj1    ], w[ijk    ]) * interp2(v[ijk-kk1], v[ijk    ]) ) / rhoref[k] * dzi[k];
             }
 
+        #pragma omp parallel for
         for (k=kstart+2; k<kend-2; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -373,6 +374,7 @@ namespace
                            - rhoref[k-1] * interp2(w[ijk-kk1    ], w[ijk    ]) * interp2(w[ijk-kk1], w[ijk    ]) ) / rhorefh[k] * dzhi[k];
             }
 
+        #pragma omp parallel for
         for (k=kstart+2; k<kend-1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -464,6 +466,7 @@ namespace
                            - rhorefh[k  ] * w[ijk    ] * interp2(s[ijk-kk1], s[ijk    ]) ) / rhoref[k] * dzi[k];
             }
 
+        #pragma omp parallel for
         for (k=kstart+2; k<kend-2; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -536,6 +539,7 @@ namespace
                 st[ijk] = interp2(w[ijk-ii1], w[ijk]) * interp2(s[ijk-kk1], s[ijk]);
             }
 
+        #pragma omp parallel for
         for (int k=kstart+2; k<kend-1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -576,6 +580,7 @@ namespace
                 st[ijk] = interp2(w[ijk-jj1], w[ijk]) * interp2(s[ijk-kk1], s[ijk]);
             }
 
+        #pragma omp parallel for
         for (int k=kstart+2; k<kend-1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -605,6 +610,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -634,6 +640,7 @@ namespace
                 st[ijk] = w[ijk] * interp2(s[ijk-kk1], s[ijk]);
             }
 
+        #pragma omp parallel for
         for (int k=kstart+2; k<kend-1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -667,13 +674,13 @@ void Advec_2i4<TF>::create(Stats<TF>& stats)
 
 #ifndef USECUDA
 template<typename TF>
-double Advec_2i4<TF>::get_cfl(double dt)
+double Advec_2i4<TF>::get_cfl_local(double dt)
 {
     auto& gd = grid.get_grid_data();
     TF cfl = calc_cfl<TF>(
             fields.mp.at("u")->fld.data(),fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
             gd.dzi.data(), gd.dxi, gd.dyi,
-            dt, master,
+            dt,
             gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
             gd.icells, gd.ijcells);
 
@@ -682,20 +689,17 @@ double Advec_2i4<TF>::get_cfl(double dt)
 }
 
 template<typename TF>
-unsigned long Advec_2i4<TF>::get_time_limit(unsigned long idt, double dt)
+double Advec_2i4<TF>::get_cfl(double dt)
 {
-    // Calculate cfl and prevent zero divisons.
-    auto& gd = grid.get_grid_data();
-
-    double cfl = calc_cfl<TF>(
-            fields.mp.at("u")->fld.data(),fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
-            gd.dzi.data(), gd.dxi, gd.dyi,
-            dt, master,
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    double cfl = get_cfl_local(dt);
+    master.max(&cfl, 1);
+    return cfl;
+}
 
-    cfl = std::max(cflmin, cfl);
-    return idt * cflmax / cfl;
+template<typename TF>
+unsigned long Advec_2i4<TF>::get_time_limit(unsigned long idt, double dt)
+{
+    return this->get_time_limit_from_cfl(idt, get_cfl(dt));
 }
 
 template<typename TF>
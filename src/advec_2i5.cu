@@ -20,6 +20,8 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include "advec_2i5.h"
 #include "advec_2i5_kernels.cuh"
 #include "grid.h"
@@ -30,9 +32,35 @@
 #include "finite_difference.h"
 #include "field3d_operators.h"
 #include "cuda_launcher.h"
+#include "cuda_streams.h"
 
 
 #ifdef USECUDA
+namespace
+{
+    // Maximum number of scalars in one fused advection kernel.
+    constexpr int max_batch_size = 4;
+
+    template<typename TF, int N>
+    void launch_advec_s_batch(
+            const Grid_layout& grid_layout, const Grid_data<TF>& gd, Fields<TF>& fields,
+            const std::vector<std::string>& names, const int ns)
+    {
+        Advec_2i5_kernels::Scalar_batch<TF, N> batch;
+
+        for (int n=0; n<N; ++n)
+        {
+            batch.st[n] = fields.st.at(names[ns+n])->fld_g;
+            batch.s[n]  = fields.sp.at(names[ns+n])->fld_g;
+        }
+
+        launch_grid_kernel<Advec_2i5_kernels::advec_s_batch_g<TF, N>>(
+                grid_layout, batch,
+                fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+                fields.rhorefi_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
+    }
+}
+
 template<typename TF>
 unsigned long Advec_2i5<TF>::get_time_limit(unsigned long idt, double dt)
 {
@@ -88,43 +116,71 @@ void Advec_2i5<TF>::exec(Stats<TF>& stats)
             gd.jstride,
             gd.kstride};
 
-    launch_grid_kernel<Advec_2i5_kernels::advec_u_g<TF>>(
-            grid_layout,
-            fields.mt.at("u")->fld_g.view(),
-            fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-            fields.rhorefi_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
-
-    launch_grid_kernel<Advec_2i5_kernels::advec_v_g<TF>>(
-            grid_layout,
-            fields.mt.at("v")->fld_g.view(),
-            fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-            fields.rhorefi_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
-
-    launch_grid_kernel<Advec_2i5_kernels::advec_w_g<TF>>(
-            grid_layout,
-            fields.mt.at("w")->fld_g.view(),
-            fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-            fields.rhoref_g, fields.rhorefhi_g, gd.dzhi_g, gd.dxi, gd.dyi);
-
-    for (const std::string& s : sp_limit)
+    // The tendencies of the individual fields are independent, such that they can be
+    // computed concurrently on the streams of the pool.
     {
-        launch_grid_kernel<Advec_2i5_kernels::advec_s_lim_g<TF>>(
+        Cuda_streams streams;
+        int branch = 3;
+
+        streams.select(0);
+        launch_grid_kernel<Advec_2i5_kernels::advec_u_g<TF>>(
                 grid_layout,
-                fields.st.at(s)->fld_g.view(), fields.sp.at(s)->fld_g,
+                fields.mt.at("u")->fld_g.view(),
                 fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
                 fields.rhorefi_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
-    }
 
-    for (const std::string& s : sp_no_limit)
-    {
-        launch_grid_kernel<Advec_2i5_kernels::advec_s_g<TF>>(
+        streams.select(1);
+        launch_grid_kernel<Advec_2i5_kernels::advec_v_g<TF>>(
                 grid_layout,
-                fields.st.at(s)->fld_g.view(), fields.sp.at(s)->fld_g,
+                fields.mt.at("v")->fld_g.view(),
                 fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
                 fields.rhorefi_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
+
+        streams.select(2);
+        launch_grid_kernel<Advec_2i5_kernels::advec_w_g<TF>>(
+                grid_layout,
+                fields.mt.at("w")->fld_g.view(),
+                fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+                fields.rhoref_g, fields.rhorefhi_g, gd.dzhi_g, gd.dxi, gd.dyi);
+
+        for (const std::string& s : sp_limit)
+        {
+            streams.select(branch++);
+            launch_grid_kernel<Advec_2i5_kernels::advec_s_lim_g<TF>>(
+                    grid_layout,
+                    fields.st.at(s)->fld_g.view(), fields.sp.at(s)->fld_g,
+                    fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+                    fields.rhorefi_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
+        }
+
+        // The scalars without limiter are advected in batches, which load the velocities only once.
+        const int nscalars = sp_no_limit.size();
+        for (int ns=0; ns<nscalars; ns+=max_batch_size)
+        {
+            streams.select(branch++);
+
+            const int nbatch = std::min(max_batch_size, nscalars-ns);
+
+            if (nbatch == 4)
+                launch_advec_s_batch<TF, 4>(grid_layout, gd, fields, sp_no_limit, ns);
+            else if (nbatch == 3)
+                launch_advec_s_batch<TF, 3>(grid_layout, gd, fields, sp_no_limit, ns);
+            else if (nbatch == 2)
+                launch_advec_s_batch<TF, 2>(grid_layout, gd, fields, sp_no_limit, ns);
+            else
+            {
+                const std::string& s = sp_no_limit[ns];
+                launch_grid_kernel<Advec_2i5_kernels::advec_s_g<TF>>(
+                        grid_layout,
+                        fields.st.at(s)->fld_g.view(), fields.sp.at(s)->fld_g,
+                        fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+                        fields.rhorefi_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
+            }
+        }
     }
 
-    cudaDeviceSynchronize();
+    if (stats.is_doing_tendency())
+        cudaDeviceSynchronize();
     stats.calc_tend(*fields.mt.at("u"), tend_name);
     stats.calc_tend(*fields.mt.at("v"), tend_name);
     stats.calc_tend(*fields.mt.at("w"), tend_name);
@@ -31,6 +31,7 @@
 #include "constants.h"
 #include "finite_difference.h"
 #include "advec_monotonic.h"
+#include "cpu_tiling.h"
 
 template<typename TF>
 Advec_2i5<TF>::Advec_2i5(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& inputin) :
@@ -63,7 +64,7 @@ namespace
             const TF* const restrict w,
             const TF* const restrict dzi,
             const TF dx, const TF dy,
-            const TF dt, Master& master,
+            const TF dt,
             const int istart, const int iend,
             const int jstart, const int jend,
             const int kstart, const int kend,
@@ -108,6 +109,7 @@ namespace
                                   + std::abs(interp4_ws(            w[ijk-kk1], w[ijk    ], w[ijk+kk1], w[ijk+kk2]            ))*dzi[k]);
             }
 
+        #pragma omp parallel for reduction(max:cfl)
         for (k=kstart+2; k<kend-2; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -142,7 +144,6 @@ namespace
                                   + std::abs(interp2(                           w[ijk    ], w[ijk+kk1]                        ))*dzi[k]);
             }
 
-        master.max(&cfl, 1);
         cfl = cfl*dt;
         return cfl;
     }
@@ -178,6 +179,7 @@ namespace
         const TF dyi = TF(1.)/dy;
 
         // Calculate horizontal terms
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -201,6 +203,7 @@ namespace
                 }
 
         // Vertical terms interior with full 5/6th order vertical
+        #pragma omp parallel for
         for (int k=kstart+3; k<kend-3; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -330,6 +333,7 @@ namespace
         const TF dyi = TF(1.)/dy;
 
         // Calculate horizontal terms
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -353,6 +357,7 @@ namespace
                 }
 
         // Vertical terms interior with full 5/6th order vertical
+        #pragma omp parallel for
         for (int k=kstart+3; k<kend-3; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -480,6 +485,7 @@ namespace
         const TF dyi = TF(1.)/dy;
 
         // Calculate horizontal terms
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -503,6 +509,7 @@ namespace
                 }
 
         // Vertical terms interior with full 5/6th order vertical
+        #pragma omp parallel for
         for (int k=kstart+3; k<kend-2; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -578,6 +585,36 @@ namespace
             }
     }
 
+    // Horizontal advection terms of a scalar at a single point.
+    template<typename TF>
+    inline TF advec_s_h(
+            const TF* const restrict s,
+            const TF* const restrict u,
+            const TF* const restrict v,
+            const int ijk, const int jj1,
+            const TF dxi, const TF dyi)
+    {
+        const int ii1 = 1;
+        const int ii2 = 2;
+        const int ii3 = 3;
+
+        const int jj2 = 2*jj1;
+        const int jj3 = 3*jj1;
+
+        return
+            - ( u[ijk+ii1] * interp6_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
+              - u[ijk    ] * interp6_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
+
+            + ( std::abs(u[ijk+ii1]) * interp5_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
+              - std::abs(u[ijk    ]) * interp5_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
+
+            - ( v[ijk+jj1] * interp6_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
+              - v[ijk    ] * interp6_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi
+
+            + ( std::abs(v[ijk+jj1]) * interp5_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
+              - std::abs(v[ijk    ]) * interp5_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi;
+    }
+
     template<typename TF>
     void advec_s(
             TF* const restrict st,
@@ -585,6 +622,7 @@ namespace
             const TF* const restrict u,
             const TF* const restrict v,
             const TF* const restrict w,
+            const TF w_settle,
             const TF* const restrict dzi,
             const TF dx, const TF dy,
             const TF* const restrict rhoref,
@@ -594,13 +632,7 @@ namespace
             const int kstart, const int kend,
             const int jj, const int kk)
     {
-        const int ii1 = 1;
-        const int ii2 = 2;
-        const int ii3 = 3;
-
         const int jj1 = jj;
-        const int jj2 = 2*jj;
-        const int jj3 = 3*jj;
 
         const int kk1 = kk;
         const int kk2 = 2*kk;
@@ -609,41 +641,45 @@ namespace
         const TF dxi = TF(1.)/dx;
         const TF dyi = TF(1.)/dy;
 
-        // Calculate horizontal terms
-        for (int k=kstart; k<kend; ++k)
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
+        // The interior levels get the horizontal and full 5/6th order vertical terms
+        // in one sweep, such that s is read and st is updated only once. The levels
+        // near the walls only get their horizontal terms here.
+        // The j-blocks march in k, such that the seven planes of the vertical stencil
+        // of s and w stay in cache.
+        const Cpu_tiling::J_blocks blocks(
+                jstart, jend, Cpu_tiling::calc_jblock<TF>(jj, jend-jstart, 7, 2));
+
+        #pragma omp parallel for collapse(2)
+        for (int b=0; b<blocks.size(); ++b)
+            for (int k=kstart; k<kend; ++k)
+            {
+                if (k >= kstart+3 && k < kend-3)
                 {
-                    const int ijk = i + j*jj1 + k*kk1;
-                    st[ijk] +=
-                            - ( u[ijk+ii1] * interp6_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
-                              - u[ijk    ] * interp6_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
-
-                            + ( std::abs(u[ijk+ii1]) * interp5_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
-                              - std::abs(u[ijk    ]) * interp5_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
-
-                            - ( v[ijk+jj1] * interp6_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
-                              - v[ijk    ] * interp6_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi
-
-                            + ( std::abs(v[ijk+jj1]) * interp5_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
-                              - std::abs(v[ijk    ]) * interp5_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi;
+                    for (int j=blocks.start(b); j<blocks.end(b); ++j)
+                        #pragma ivdep
+                        for (int i=istart; i<iend; ++i)
+                        {
+                            const int ijk = i + j*jj1 + k*kk1;
+                            st[ijk] += advec_s_h(s, u, v, ijk, jj1, dxi, dyi)
+
+                                    - ( rhorefh[k+1] * (w[ijk+kk1]+w_settle) * interp6_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
+                                      - rhorefh[k  ] * (w[ijk    ]+w_settle) * interp6_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) / rhoref[k] * dzi[k]
+
+                                    + ( rhorefh[k+1] * std::abs((w[ijk+kk1]+w_settle)) * interp5_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
+                                      - rhorefh[k  ] * std::abs((w[ijk    ]+w_settle)) * interp5_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) / rhoref[k] * dzi[k];
+                        }
                 }
-
-        // Vertical terms interior with full 5/6th order vertical
-        for (int k=kstart+3; k<kend-3; ++k)
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
+                else
                 {
-                    const int ijk = i + j*jj1 + k*kk1;
-                    st[ijk] +=
-                            - ( rhorefh[k+1] * w[ijk+kk1] * interp6_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
-                              - rhorefh[k  ] * w[ijk    ] * interp6_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) / rhoref[k] * dzi[k]
-
-                            + ( rhorefh[k+1] * std::abs(w[ijk+kk1]) * interp5_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
-                              - rhorefh[k  ] * std::abs(w[ijk    ]) * interp5_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) / rhoref[k] * dzi[k];
+                    for (int j=blocks.start(b); j<blocks.end(b); ++j)
+                        #pragma ivdep
+                        for (int i=istart; i<iend; ++i)
+                        {
+                            const int ijk = i + j*jj1 + k*kk1;
+                            st[ijk] += advec_s_h(s, u, v, ijk, jj1, dxi, dyi);
+                        }
                 }
+            }
 
         // Calculate vertical terms with reduced order near boundaries
         int k = kstart;
@@ -654,7 +690,7 @@ namespace
                 const int ijk = i + j*jj1 + k*kk1;
                 st[ijk] +=
                         // w*ds/dz -> second order interpolation for fluxtop, fluxbot=0 as w=0
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp2(s[ijk    ], s[ijk+kk1])) / rhoref[k] * dzi[k];
+                        - ( rhorefh[k+1] * (w[ijk+kk1]+w_settle) * interp2(s[ijk    ], s[ijk+kk1])) / rhoref[k] * dzi[k];
             }
 
         k = kstart+1;
@@ -665,10 +701,10 @@ namespace
                 const int ijk = i + j*jj1 + k*kk1;
                 st[ijk] +=
                         // w*ds/dz -> second order interpolation for fluxbot, fourth order for fluxtop
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp4_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                          - rhorefh[k  ] * w[ijk    ] * interp2(s[ijk-kk1], s[ijk    ]) ) / rhoref[k] * dzi[k]
+                        - ( rhorefh[k+1] * (w[ijk+kk1]+w_settle) * interp4_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                          - rhorefh[k  ] * (w[ijk    ]+w_settle) * interp2(s[ijk-kk1], s[ijk    ]) ) / rhoref[k] * dzi[k]
 
-                        + ( rhorefh[k+1] * std::abs(w[ijk+kk1]) * interp3_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])) / rhoref[k] * dzi[k];
+                        + ( rhorefh[k+1] * std::abs((w[ijk+kk1]+w_settle)) * interp3_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])) / rhoref[k] * dzi[k];
             }
 
         k = kstart+2;
@@ -679,11 +715,11 @@ namespace
                 const int ijk = i + j*jj1 + k*kk1;
                 st[ijk] +=
                         // w*ds/dz -> fourth order interpolation for fluxbot, sixth for fluxtop
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp6_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
-                          - rhorefh[k  ] * w[ijk    ] * interp4_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k]
+                        - ( rhorefh[k+1] * (w[ijk+kk1]+w_settle) * interp6_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
+                          - rhorefh[k  ] * (w[ijk    ]+w_settle) * interp4_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k]
 
-                        + ( rhorefh[k+1] * std::abs(w[ijk+kk1]) * interp5_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
-                          - rhorefh[k  ] * std::abs(w[ijk    ]) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+                        + ( rhorefh[k+1] * std::abs((w[ijk+kk1]+w_settle)) * interp5_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2], s[ijk+kk3])
+                          - rhorefh[k  ] * std::abs((w[ijk    ]+w_settle)) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
             }
 
         k = kend-3;
@@ -694,11 +730,11 @@ namespace
                 const int ijk = i + j*jj1 + k*kk1;
                 st[ijk] +=
                         // w*ds/dz -> fourth order interpolation for fluxtop, sixth order for fluxbot
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp4_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                          - rhorefh[k  ] * w[ijk    ] * interp6_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) / rhoref[k] * dzi[k]
+                        - ( rhorefh[k+1] * (w[ijk+kk1]+w_settle) * interp4_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                          - rhorefh[k  ] * (w[ijk    ]+w_settle) * interp6_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) / rhoref[k] * dzi[k]
 
-                        + ( rhorefh[k+1] * std::abs(w[ijk+kk1]) * interp3_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                          - rhorefh[k  ] * std::abs(w[ijk    ]) * interp5_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) / rhoref[k] * dzi[k];
+                        + ( rhorefh[k+1] * std::abs((w[ijk+kk1]+w_settle)) * interp3_ws(s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
+                          - rhorefh[k  ] * std::abs((w[ijk    ]+w_settle)) * interp5_ws(s[ijk-kk3], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2]) ) / rhoref[k] * dzi[k];
             }
 
         k = kend-2;
@@ -709,10 +745,10 @@ namespace
                 const int ijk = i + j*jj1 + k*kk1;
                 st[ijk] +=
                         // w*ds/dz -> second order interpolation for fluxtop, fourth order for fluxbot
-                        - ( rhorefh[k+1] * w[ijk+kk1] * interp2(s[ijk    ], s[ijk+kk1])
-                          - rhorefh[k  ] * w[ijk    ] * interp4_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k]
+                        - ( rhorefh[k+1] * (w[ijk+kk1]+w_settle) * interp2(s[ijk    ], s[ijk+kk1])
+                          - rhorefh[k  ] * (w[ijk    ]+w_settle) * interp4_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k]
 
-                        + ( -rhorefh[k  ] * std::abs(w[ijk    ]) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
+                        + ( -rhorefh[k  ] * std::abs((w[ijk    ]+w_settle)) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
             }
 
         k = kend-1;
@@ -723,7 +759,7 @@ namespace
                 const int ijk = i + j*jj1 + k*kk1;
                 st[ijk] +=
                         // w*ds/dz -> second order interpolation for fluxbot, fluxtop=0 as w=0
-                        - (- rhorefh[k  ] * w[ijk    ] * interp2(s[ijk-kk1], s[ijk    ]) ) / rhoref[k] * dzi[k];
+                        - (- rhorefh[k  ] * (w[ijk    ]+w_settle) * interp2(s[ijk-kk1], s[ijk    ]) ) / rhoref[k] * dzi[k];
             }
     }
 
@@ -758,6 +794,7 @@ namespace
                         - std::abs(interp2(w[ijk-ii1], w[ijk])) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]);
             }
 
+        #pragma omp parallel for
         for (int k=kstart+3; k<kend-2; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -820,6 +857,7 @@ namespace
                         - std::abs(interp2(w[ijk-jj1], w[ijk])) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]);
             }
 
+        #pragma omp parallel for
         for (int k=kstart+3; k<kend-2; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -860,6 +898,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -900,6 +939,7 @@ namespace
                         - std::abs(w[ijk]) * interp3_ws(s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]);
             }
 
+        #pragma omp parallel for
         for (int k=kstart+3; k<kend-2; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -937,10 +977,19 @@ void Advec_2i5<TF>::create(Stats<TF>& stats)
 {
     for (auto& s : fields.sp)
     {
+        if (is_split(s.first))
+            continue;
+
         if (std::find(fluxlimit_list.begin(), fluxlimit_list.end(), s.first) != fluxlimit_list.end())
+        {
             sp_limit.push_back(s.first);
+            scalar_kernels.emplace(s.first, Scalar_kernels{advec_s_lim<TF>, advec_flux_s_lim<TF>});
+        }
         else
+        {
             sp_no_limit.push_back(s.first);
+            scalar_kernels.emplace(s.first, Scalar_kernels{advec_s<TF>, advec_flux_s<TF>});
+        }
     }
 
     stats.add_tendency(*fields.mt.at("u"), "z", tend_name, tend_longname);
@@ -952,7 +1001,7 @@ void Advec_2i5<TF>::create(Stats<TF>& stats)
 
 #ifndef USECUDA
 template<typename TF>
-double Advec_2i5<TF>::get_cfl(double dt)
+double Advec_2i5<TF>::get_cfl_local(double dt)
 {
     auto& gd = grid.get_grid_data();
     TF cfl = calc_cfl<TF>(
@@ -960,7 +1009,7 @@ double Advec_2i5<TF>::get_cfl(double dt)
             fields.mp.at("v")->fld.data(),
             fields.mp.at("w")->fld.data(),
             gd.dzi.data(), gd.dx, gd.dy,
-            dt, master,
+            dt,
             gd.istart, gd.iend,
             gd.jstart, gd.jend,
             gd.kstart, gd.kend,
@@ -971,24 +1020,17 @@ double Advec_2i5<TF>::get_cfl(double dt)
 }
 
 template<typename TF>
-unsigned long Advec_2i5<TF>::get_time_limit(unsigned long idt, double dt)
+double Advec_2i5<TF>::get_cfl(double dt)
 {
-    // Calculate cfl and prevent zero divisons.
-    auto& gd = grid.get_grid_data();
-
-    double cfl = calc_cfl<TF>(
-            fields.mp.at("u")->fld.data(),
-            fields.mp.at("v")->fld.data(),
-            fields.mp.at("w")->fld.data(),
-            gd.dzi.data(), gd.dx, gd.dy,
-            dt, master,
-            gd.istart, gd.iend,
-            gd.jstart, gd.jend,
-            gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    double cfl = get_cfl_local(dt);
+    master.max(&cfl, 1);
+    return cfl;
+}
 
-    cfl = std::max(cflmin, cfl);
-    return idt * cflmax / cfl;
+template<typename TF>
+unsigned long Advec_2i5<TF>::get_time_limit(unsigned long idt, double dt)
+{
+    return this->get_time_limit_from_cfl(idt, get_cfl(dt));
 }
 
 
@@ -1029,29 +1071,17 @@ void Advec_2i5<TF>::exec(Stats<TF>& stats)
             gd.kstart, gd.kend,
             gd.icells, gd.ijcells);
 
-    for (const std::string& s : sp_no_limit)
+    for (auto& sk : scalar_kernels)
     {
-        advec_s(fields.st.at(s)->fld.data(),
-                fields.sp.at(s)->fld.data(),
-                fields.mp.at("u")->fld.data(),
-                fields.mp.at("v")->fld.data(),
-                fields.mp.at("w")->fld.data(),
-                gd.dzi.data(), gd.dx, gd.dy,
-                fields.rhoref.data(), fields.rhorefh.data(),
-                gd.istart, gd.iend,
-                gd.jstart, gd.jend,
-                gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
-    }
-
-    for (const std::string& s : sp_limit)
-    {
-        advec_s_lim(
-                fields.st.at(s)->fld.data(), fields.sp.at(s)->fld.data(),
+        const auto box = fields.get_active_box(sk.first);
+        auto it_settle = w_settle.find(sk.first);
+        sk.second.advec(
+                fields.st.at(sk.first)->fld.data(), fields.sp.at(sk.first)->fld.data(),
                 fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
+                (it_settle != w_settle.end()) ? it_settle->second : TF(0.),
                 gd.dzi.data(), gd.dx, gd.dy,
                 fields.rhoref.data(), fields.rhorefh.data(),
-                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                box.istart, box.iend, box.jstart, box.jend, gd.kstart, box.kend,
                 gd.icells, gd.ijcells);
     }
 
@@ -1092,22 +1122,36 @@ void Advec_2i5<TF>::get_advec_flux(
     }
     else if (fld.loc == gd.sloc)
     {
-        if (std::find(sp_limit.begin(), sp_limit.end(), fld.name) != sp_limit.end())
-            advec_flux_s_lim(
-                    advec_flux.fld.data(), fld.fld.data(), fields.mp.at("w")->fld.data(),
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells);
-        else
-            advec_flux_s(
-                    advec_flux.fld.data(), fld.fld.data(), fields.mp.at("w")->fld.data(),
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells);
+        // Fields that are not prognostic scalars use the unlimited flux.
+        auto it = scalar_kernels.find(fld.name);
+        Advec_flux_s_kernel flux_kernel = (it != scalar_kernels.end()) ? it->second.flux : advec_flux_s<TF>;
+
+        flux_kernel(
+                advec_flux.fld.data(), fld.fld.data(), fields.mp.at("w")->fld.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
     }
     else
         throw std::runtime_error("Advec_2i5 cannot deliver flux field at that location");
 }
 
 
+template<typename TF>
+bool Advec_2i5<TF>::set_settling_velocity(const std::string& name, const TF w)
+{
+    // The GPU kernels and the split advection do not take a settling velocity.
+    #ifdef USECUDA
+    return false;
+    #else
+    if (is_split(name))
+        return false;
+
+    w_settle[name] = w;
+    return true;
+    #endif
+}
+
+
 #ifdef FLOAT_SINGLE
 template class Advec_2i5<float>;
 #else
@@ -28,329 +28,8 @@
 #include "constants.h"
 #include "finite_difference.h"
 #include "field3d_operators.h"
-
-
-namespace
-{
-    using namespace Finite_difference::O2;
-    using namespace Finite_difference::O6;
-
-
-    template<typename TF> __global__
-    void advec_u_g(TF* __restrict__ ut, const TF* __restrict__ u,
-                   const TF* __restrict__ v,  const TF* __restrict__ w,
-                   const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
-                   const TF* __restrict__ dzi, const TF dxi, const TF dyi,
-                   const int jj, int kk,
-                   const int istart, const int jstart, const int kstart,
-                   const int iend,   const int jend,   const int kend)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        const int ii1 = 1;
-        const int ii2 = 2;
-        const int ii3 = 3;
-        const int jj1 = 1*jj;
-        const int jj2 = 2*jj;
-        const int jj3 = 3*jj;
-        const int kk1 = 1*kk;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj + k*kk;
-
-            ut[ijk] +=
-                // u*du/dx
-                - ( interp2(u[ijk        ], u[ijk+ii1]) * interp6_ws(u[ijk-ii2], u[ijk-ii1], u[ijk    ], u[ijk+ii1], u[ijk+ii2], u[ijk+ii3])
-                  - interp2(u[ijk-ii1    ], u[ijk    ]) * interp6_ws(u[ijk-ii3], u[ijk-ii2], u[ijk-ii1], u[ijk    ], u[ijk+ii1], u[ijk+ii2]) ) * dxi
-
-                // v*du/dy
-                - ( interp2(v[ijk-ii1+jj1], v[ijk+jj1]) * interp6_ws(u[ijk-jj2], u[ijk-jj1], u[ijk    ], u[ijk+jj1], u[ijk+jj2], u[ijk+jj3])
-                  - interp2(v[ijk-ii1    ], v[ijk    ]) * interp6_ws(u[ijk-jj3], u[ijk-jj2], u[ijk-jj1], u[ijk    ], u[ijk+jj1], u[ijk+jj2]) ) * dyi
-
-                - ( rhorefh[k+1] * interp2(w[ijk-ii1+kk1], w[ijk+kk1]) * interp2(u[ijk    ], u[ijk+kk1])
-                  - rhorefh[k  ] * interp2(w[ijk-ii1    ], w[ijk    ]) * interp2(u[ijk-kk1], u[ijk    ]) ) / rhoref[k] * dzi[k];
-        }
-    }
-
-
-    template<typename TF> __global__
-    void advec_v_g(TF* __restrict__ vt, const TF* __restrict__ u,
-                   const TF* __restrict__ v,  const TF* __restrict__ w,
-                   const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
-                   const TF* __restrict__ dzi, const TF dxi, const TF dyi,
-                   const int jj, int kk,
-                   const int istart, const int jstart, const int kstart,
-                   const int iend,   const int jend,   const int kend)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        const int ii1 = 1;
-        const int ii2 = 2;
-        const int ii3 = 3;
-        const int jj1 = 1*jj;
-        const int jj2 = 2*jj;
-        const int jj3 = 3*jj;
-        const int kk1 = 1*kk;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj + k*kk;
-
-            vt[ijk] +=
-                // u*dv/dx
-                - ( interp2(u[ijk+ii1-jj1], u[ijk+ii1]) * interp6_ws(v[ijk-ii2], v[ijk-ii1], v[ijk    ], v[ijk+ii1], v[ijk+ii2], v[ijk+ii3])
-                  - interp2(u[ijk    -jj1], u[ijk    ]) * interp6_ws(v[ijk-ii3], v[ijk-ii2], v[ijk-ii1], v[ijk    ], v[ijk+ii1], v[ijk+ii2]) ) * dxi
-
-                // v*dv/dy
-                - ( interp2(v[ijk        ], v[ijk+jj1]) * interp6_ws(v[ijk-jj2], v[ijk-jj1], v[ijk    ], v[ijk+jj1], v[ijk+jj2], v[ijk+jj3])
-                  - interp2(v[ijk-jj1    ], v[ijk    ]) * interp6_ws(v[ijk-jj3], v[ijk-jj2], v[ijk-jj1], v[ijk    ], v[ijk+jj1], v[ijk+jj2]) ) * dyi
-
-                - ( rhorefh[k+1] * interp2(w[ijk-jj1+kk1], w[ijk+kk1]) * interp2(v[ijk    ], v[ijk+kk1])
-                  - rhorefh[k  ] * interp2(w[ijk-jj1    ], w[ijk    ]) * interp2(v[ijk-kk1], v[ijk    ]) ) / rhoref[k] * dzi[k];
-        }
-    }
-
-
-    template<typename TF> __global__
-    void advec_w_g(TF* __restrict__ wt, const TF* __restrict__ u,
-                   const TF* __restrict__ v,  const TF* __restrict__ w,
-                   const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
-                   const TF* __restrict__ dzhi, const TF dxi, const TF dyi,
-                   const int jj, int kk,
-                   const int istart, const int jstart, const int kstart,
-                   const int iend,   const int jend,   const int kend)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart + 1;
-
-        const int ii1 = 1;
-        const int ii2 = 2;
-        const int ii3 = 3;
-        const int jj1 = 1*jj;
-        const int jj2 = 2*jj;
-        const int jj3 = 3*jj;
-        const int kk1 = 1*kk;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj + k*kk;
-
-            wt[ijk] +=
-                // u*dw/dx
-                - ( interp2(u[ijk+ii1-kk], u[ijk+ii1]) * interp6_ws(w[ijk-ii2], w[ijk-ii1], w[ijk    ], w[ijk+ii1], w[ijk+ii2], w[ijk+ii3])
-                  - interp2(u[ijk    -kk], u[ijk    ]) * interp6_ws(w[ijk-ii3], w[ijk-ii2], w[ijk-ii1], w[ijk    ], w[ijk+ii1], w[ijk+ii2]) ) * dxi
-
-                // v*dw/dy
-                - ( interp2(v[ijk+jj1-kk], v[ijk+jj1]) * interp6_ws(w[ijk-jj2], w[ijk-jj1], w[ijk    ], w[ijk+jj1], w[ijk+jj2], w[ijk+jj3])
-                  - interp2(v[ijk    -kk], v[ijk    ]) * interp6_ws(w[ijk-jj3], w[ijk-jj2], w[ijk-jj1], w[ijk    ], w[ijk+jj1], w[ijk+jj2]) ) * dyi
-
-                - ( rhoref[k  ] * interp2(w[ijk    ], w[ijk+kk1]) * interp2(w[ijk    ], w[ijk+kk1])
-                  - rhoref[k-1] * interp2(w[ijk-kk1], w[ijk    ]) * interp2(w[ijk-kk1], w[ijk    ]) ) / rhorefh[k] * dzhi[k];
-        }
-    }
-
-
-    template<typename TF> __global__
-    void advec_s_g(
-            TF* __restrict__ st, const TF* __restrict__ s,
-            const TF* __restrict__ u, const TF* __restrict__ v,  const TF* __restrict__ w,
-            const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
-            const TF* __restrict__ dzi, const TF dxi, const TF dyi,
-            const int jj, int kk,
-            const int istart, const int jstart, const int kstart,
-            const int iend, const int jend, const int kend)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        const int ii1 = 1;
-        const int ii2 = 2;
-        const int ii3 = 3;
-        const int jj1 = 1*jj;
-        const int jj2 = 2*jj;
-        const int jj3 = 3*jj;
-        const int kk1 = 1*kk;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj + k*kk;
-
-            st[ijk] +=
-                - ( u[ijk+ii1] * interp6_ws(s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2], s[ijk+ii3])
-                  - u[ijk    ] * interp6_ws(s[ijk-ii3], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2]) ) * dxi
-
-                - ( v[ijk+jj1] * interp6_ws(s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2], s[ijk+jj3])
-                  - v[ijk    ] * interp6_ws(s[ijk-jj3], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2]) ) * dyi
-
-                - ( rhorefh[k+1] * w[ijk+kk1] * interp2(s[ijk    ], s[ijk+kk1])
-                  - rhorefh[k  ] * w[ijk    ] * interp2(s[ijk-kk1], s[ijk    ]) ) / rhoref[k] * dzi[k];
-        }
-    }
-
-
-    // Implementation flux limiter according to Koren, 1993.
-    template<typename TF> __device__
-    inline TF flux_lim_g(const TF u, const TF sm2, const TF sm1, const TF sp1, const TF sp2)
-    {
-        const TF eps = TF(1.e-12);
-
-        if (u >= TF(0.))
-        {
-            const TF two_r = TF(2.) * (sp1-sm1+eps) / (sm1-sm2+eps);
-            const TF phi = max(
-                    TF(0.),
-                    min( two_r, min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
-            return u*(sm1 + TF(0.5)*phi*(sm1 - sm2));
-        }
-        else
-        {
-            const TF two_r = TF(2.) * (sm1-sp1+eps) / (sp1-sp2+eps);
-            const TF phi = max(
-                    TF(0.),
-                    min( two_r, min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
-            return u*(sp1 + TF(0.5)*phi*(sp1 - sp2));
-        }
-    }
-
-    template<typename TF> __device__
-    inline TF flux_lim_bot_g(const TF u, const TF sm2, const TF sm1, const TF sp1, const TF sp2)
-    {
-        const TF eps = TF(1.e-12);
-
-        if (u >= TF(0.))
-        {
-            return u*sm1;
-        }
-        else
-        {
-            const TF two_r = TF(2.) * (sm1-sp1+eps) / (sp1-sp2+eps);
-            const TF phi = max(
-                    TF(0.),
-                    min( two_r, min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
-            return u*(sp1 + TF(0.5)*phi*(sp1 - sp2));
-        }
-    }
-
-    template<typename TF> __device__
-    inline TF flux_lim_top_g(const TF u, const TF sm2, const TF sm1, const TF sp1, const TF sp2)
-    {
-        const TF eps = TF(1.e-12);
-
-        if (u >= TF(0.))
-        {
-            const TF two_r = TF(2.) * (sp1-sm1+eps) / (sm1-sm2+eps);
-            const TF phi = max(
-                    TF(0.),
-                    min( two_r, min( TF(1./3.)*(TF(1.)+two_r), TF(2.)) ) );
-            return u*(sm1 + TF(0.5)*phi*(sm1 - sm2));
-        }
-        else
-        {
-            return u*sp1;
-        }
-    }
-
-    template<typename TF> __global__
-    void advec_s_lim_g(
-            TF* __restrict__ st, const TF* __restrict__ s,
-            const TF* __restrict__ u, const TF* __restrict__ v,  const TF* __restrict__ w,
-            const TF* __restrict__ rhoref, const TF* __restrict__ rhorefh,
-            const TF* __restrict__ dzi, const TF dxi, const TF dyi,
-            const int jj, int kk,
-            const int istart, const int jstart, const int kstart,
-            const int iend, const int jend, const int kend)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        const int ii1 = 1;
-        const int ii2 = 2;
-        const int jj1 = 1*jj;
-        const int jj2 = 2*jj;
-        const int kk1 = 1*kk;
-        const int kk2 = 2*kk;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj1 + k*kk1;
-            st[ijk] +=
-                     - ( flux_lim_g(u[ijk+ii1], s[ijk-ii1], s[ijk    ], s[ijk+ii1], s[ijk+ii2])
-                       - flux_lim_g(u[ijk    ], s[ijk-ii2], s[ijk-ii1], s[ijk    ], s[ijk+ii1]) ) * dxi
-
-                     - ( flux_lim_g(v[ijk+jj1], s[ijk-jj1], s[ijk    ], s[ijk+jj1], s[ijk+jj2])
-                       - flux_lim_g(v[ijk    ], s[ijk-jj2], s[ijk-jj1], s[ijk    ], s[ijk+jj1]) ) * dyi;
-
-            if (k >= kstart+2 && k < kend-2)
-            {
-                st[ijk] +=
-                         - ( rhorefh[k+1] * flux_lim_g(w[ijk+kk], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                           - rhorefh[k  ] * flux_lim_g(w[ijk   ], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
-            }
-            else if (k == kstart)
-            {
-                st[ijk] +=
-                         - ( rhorefh[k+1] * flux_lim_bot_g(w[ijk+kk1], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])) / rhoref[k] * dzi[k];
-            }
-            else if (k == kstart+1)
-            {
-                st[ijk] +=
-                         - ( rhorefh[k+1] * flux_lim_g    (w[ijk+kk1], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                           - rhorefh[k  ] * flux_lim_bot_g(w[ijk    ], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
-            }
-            else if (k == kend-2)
-            {
-                st[ijk] +=
-                         - ( rhorefh[k+1] * flux_lim_top_g(w[ijk+kk1], s[ijk-kk1], s[ijk    ], s[ijk+kk1], s[ijk+kk2])
-                           - rhorefh[k  ] * flux_lim_g    (w[ijk    ], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
-            }
-            else if (k == kend-1)
-            {
-                st[ijk] +=
-                         - (
-                           - rhorefh[k  ] * flux_lim_top_g(w[ijk    ], s[ijk-kk2], s[ijk-kk1], s[ijk    ], s[ijk+kk1]) ) / rhoref[k] * dzi[k];
-            }
-        }
-    }
-
-
-    template<typename TF> __global__
-    void calc_cfl_g(TF* const __restrict__ tmp1,
-                    const TF* __restrict__ u, const TF* __restrict__ v, const TF* __restrict__ w,
-                    const TF* __restrict__ dzi, const TF dxi, const TF dyi,
-                    const int jj, const int kk,
-                    const int istart, const int jstart, const int kstart,
-                    const int iend, const int jend, const int kend)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        const int ii1 = 1;
-        const int ii2 = 2;
-        const int ii3 = 3;
-        const int jj1 = 1*jj;
-        const int jj2 = 2*jj;
-        const int jj3 = 3*jj;
-        const int kk1 = 1*kk;
-
-        const int ijk = i + j*jj + k*kk;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            tmp1[ijk] = fabs(interp6_ws(u[ijk-ii2], u[ijk-ii1], u[ijk], u[ijk+ii1], u[ijk+ii2], u[ijk+ii3]))*dxi
-                      + fabs(interp6_ws(v[ijk-jj2], v[ijk-jj1], v[ijk], v[ijk+jj1], v[ijk+jj2], v[ijk+jj3]))*dyi
-                      + fabs(interp2(w[ijk], w[ijk+kk1]))*dzi[k];
-        }
-    }
-}
+#include "advec_2i62_kernels.cuh"
+#include "cuda_launcher.h"
 
 
 #ifdef USECUDA
@@ -370,23 +49,22 @@ template<typename TF>
 double Advec_2i62<TF>::get_cfl(const double dt)
 {
     const Grid_data<TF>& gd = grid.get_grid_data();
-    const int blocki = gd.ithread_block;
-    const int blockj = gd.jthread_block;
-    const int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
-    const int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
 
-    dim3 gridGPU (gridi, gridj, gd.kcells);
-    dim3 blockGPU(blocki, blockj, 1);
+    Grid_layout grid_layout = {
+            gd.istart, gd.iend,
+            gd.jstart, gd.jend,
+            gd.kstart, gd.kend,
+            gd.istride,
+            gd.jstride,
+            gd.kstride};
 
     auto tmp1 = fields.get_tmp_g();
 
-    calc_cfl_g<TF><<<gridGPU, blockGPU>>>(
-        tmp1->fld_g,
-        fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-        gd.dzi_g, gd.dxi, gd.dyi,
-        gd.icells, gd.ijcells,
-        gd.istart, gd.jstart, gd.kstart,
-        gd.iend, gd.jend, gd.kend);
+    launch_grid_kernel<Advec_2i62_kernels::calc_cfl_g<TF>>(
+            grid_layout,
+            tmp1->fld_g.view(),
+            fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+            gd.dzi_g, gd.dxi, gd.dyi);
     cuda_check_error();
 
     TF cfl = field3d_operators.calc_max_g(tmp1->fld_g);
@@ -402,68 +80,59 @@ template<typename TF>
 void Advec_2i62<TF>::exec(Stats<TF>& stats)
 {
     const Grid_data<TF>& gd = grid.get_grid_data();
-    const int blocki = gd.ithread_block;
-    const int blockj = gd.jthread_block;
-    const int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
-    const int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
-
-    dim3 gridGPU (gridi, gridj, gd.kmax);
-    dim3 blockGPU(blocki, blockj, 1);
 
-    advec_u_g<TF><<<gridGPU, blockGPU>>>(
-        fields.mt.at("u")->fld_g,
-        fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-        fields.rhoref_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi,
-        gd.icells, gd.ijcells,
-        gd.istart, gd.jstart, gd.kstart,
-        gd.iend, gd.jend, gd.kend);
-    cuda_check_error();
-
-    advec_v_g<TF><<<gridGPU, blockGPU>>>(
-        fields.mt.at("v")->fld_g,
-        fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-        fields.rhoref_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi,
-        gd.icells, gd.ijcells,
-        gd.istart, gd.jstart, gd.kstart,
-        gd.iend, gd.jend, gd.kend);
-    cuda_check_error();
-
-    advec_w_g<TF><<<gridGPU, blockGPU>>>(
-        fields.mt.at("w")->fld_g,
-        fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-        fields.rhoref_g, fields.rhorefh_g, gd.dzhi_g, gd.dxi, gd.dyi,
-        gd.icells, gd.ijcells,
-        gd.istart, gd.jstart, gd.kstart,
-        gd.iend, gd.jend, gd.kend);
-    cuda_check_error();
+    using namespace Advec_2i62_kernels;
+
+    Grid_layout grid_layout = {
+            gd.istart, gd.iend,
+            gd.jstart, gd.jend,
+            gd.kstart, gd.kend,
+            gd.istride,
+            gd.jstride,
+            gd.kstride};
+
+    Grid_layout grid_layout_w = {
+            gd.istart, gd.iend,
+            gd.jstart, gd.jend,
+            gd.kstart+1, gd.kend,
+            gd.istride,
+            gd.jstride,
+            gd.kstride};
+
+    launch_grid_kernel<advec_u_g<TF>>(
+            grid_layout,
+            fields.mt.at("u")->fld_g.view(),
+            fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+            fields.rhoref_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
+
+    launch_grid_kernel<advec_v_g<TF>>(
+            grid_layout,
+            fields.mt.at("v")->fld_g.view(),
+            fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+            fields.rhoref_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
+
+    launch_grid_kernel<advec_w_g<TF>>(
+            grid_layout_w,
+            fields.mt.at("w")->fld_g.view(),
+            fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
+            fields.rhoref_g, fields.rhorefh_g, gd.dzhi_g, gd.dxi, gd.dyi);
 
     for (const std::string& s : sp_limit)
-    {
-        advec_s_lim_g<TF><<<gridGPU, blockGPU>>>(
-                fields.st.at(s)->fld_g, fields.sp.at(s)->fld_g,
+        launch_grid_kernel<advec_s_lim_g<TF>>(
+                grid_layout,
+                fields.st.at(s)->fld_g.view(), fields.sp.at(s)->fld_g,
                 fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-                fields.rhoref_g, fields.rhorefh_g,
-                gd.dzi_g, gd.dxi, gd.dyi,
-                gd.icells, gd.ijcells,
-                gd.istart, gd.jstart, gd.kstart,
-                gd.iend, gd.jend, gd.kend);
-    }
-    cuda_check_error();
+                fields.rhoref_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
 
     for (const std::string& s : sp_no_limit)
-    {
-        advec_s_g<TF><<<gridGPU, blockGPU>>>(
-                fields.st.at(s)->fld_g, fields.sp.at(s)->fld_g,
+        launch_grid_kernel<advec_s_g<TF>>(
+                grid_layout,
+                fields.st.at(s)->fld_g.view(), fields.sp.at(s)->fld_g,
                 fields.mp.at("u")->fld_g, fields.mp.at("v")->fld_g, fields.mp.at("w")->fld_g,
-                fields.rhoref_g, fields.rhorefh_g,
-                gd.dzi_g, gd.dxi, gd.dyi,
-                gd.icells, gd.ijcells,
-                gd.istart, gd.jstart, gd.kstart,
-                gd.iend, gd.jend, gd.kend);
-    }
-    cuda_check_error();
+                fields.rhoref_g, fields.rhorefh_g, gd.dzi_g, gd.dxi, gd.dyi);
 
-    cudaDeviceSynchronize();
+    if (stats.is_doing_tendency())
+        cudaDeviceSynchronize();
     stats.calc_tend(*fields.mt.at("u"), tend_name);
     stats.calc_tend(*fields.mt.at("v"), tend_name);
     stats.calc_tend(*fields.mt.at("w"), tend_name);
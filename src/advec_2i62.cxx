@@ -62,7 +62,7 @@ namespace
             const TF* const restrict w,
             const TF* const restrict dzi,
             const TF dx, const TF dy,
-            const TF dt, Master& master,
+            const TF dt,
             const int istart, const int iend,
             const int jstart, const int jend,
             const int kstart, const int kend,
@@ -85,6 +85,7 @@ namespace
 
         TF cfl = 0;
 
+        #pragma omp parallel for reduction(max:cfl)
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -96,7 +97,6 @@ namespace
                                       + std::abs(interp2(w[ijk], w[ijk+kk1]))*dzi[k]);
                 }
 
-        master.max(&cfl, 1);
         cfl = cfl*dt;
         return cfl;
     }
@@ -132,6 +132,7 @@ namespace
         const TF dyi = TF(1.)/dy;
 
         // Calculate horizontal terms
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -183,6 +184,7 @@ namespace
         const TF dyi = TF(1.)/dy;
 
         // Calculate horizontal terms
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -234,6 +236,7 @@ namespace
         const TF dyi = TF(1.)/dy;
 
         // Calculate horizontal terms
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -286,6 +289,7 @@ namespace
         const TF dyi = TF(1.)/dy;
 
         // Calculate horizontal terms
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -312,6 +316,7 @@ namespace
     {
         const int ii = 1;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -329,6 +334,7 @@ namespace
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -348,6 +354,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -364,6 +371,7 @@ namespace
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -395,7 +403,7 @@ void Advec_2i62<TF>::create(Stats<TF>& stats)
 
 #ifndef USECUDA
 template<typename TF>
-double Advec_2i62<TF>::get_cfl(double dt)
+double Advec_2i62<TF>::get_cfl_local(double dt)
 {
     auto& gd = grid.get_grid_data();
     TF cfl = calc_cfl<TF>(
@@ -403,7 +411,7 @@ double Advec_2i62<TF>::get_cfl(double dt)
             fields.mp.at("v")->fld.data(),
             fields.mp.at("w")->fld.data(),
             gd.dzi.data(), gd.dx, gd.dy,
-            dt, master,
+            dt,
             gd.istart, gd.iend,
             gd.jstart, gd.jend,
             gd.kstart, gd.kend,
@@ -414,24 +422,17 @@ double Advec_2i62<TF>::get_cfl(double dt)
 }
 
 template<typename TF>
-unsigned long Advec_2i62<TF>::get_time_limit(unsigned long idt, double dt)
+double Advec_2i62<TF>::get_cfl(double dt)
 {
-    // Calculate cfl and prevent zero divisons.
-    auto& gd = grid.get_grid_data();
-
-    double cfl = calc_cfl<TF>(
-            fields.mp.at("u")->fld.data(),
-            fields.mp.at("v")->fld.data(),
-            fields.mp.at("w")->fld.data(),
-            gd.dzi.data(), gd.dx, gd.dy,
-            dt, master,
-            gd.istart, gd.iend,
-            gd.jstart, gd.jend,
-            gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    double cfl = get_cfl_local(dt);
+    master.max(&cfl, 1);
+    return cfl;
+}
 
-    cfl = std::max(cflmin, cfl);
-    return idt * cflmax / cfl;
+template<typename TF>
+unsigned long Advec_2i62<TF>::get_time_limit(unsigned long idt, double dt)
+{
+    return this->get_time_limit_from_cfl(idt, get_cfl(dt));
 }
 
 
@@ -491,7 +492,7 @@ void Advec_2i62<TF>::exec(Stats<TF>& stats)
     {
         advec_s_lim(
                 fields.st.at(s)->fld.data(), fields.sp.at(s)->fld.data(),
-                fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
+                fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(), TF(0.),
                 gd.dzi.data(), gd.dx, gd.dy,
                 fields.rhoref.data(), fields.rhorefh.data(),
                 gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
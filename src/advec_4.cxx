@@ -51,7 +51,7 @@ namespace
     TF calc_cfl(
             const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
             const TF* const restrict dzi, const TF dx, const TF dy,
-            const TF dt, Master& master,
+            const TF dt,
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
@@ -67,6 +67,7 @@ namespace
 
         TF cfl = 0;
 
+        #pragma omp parallel for reduction(max:cfl)
         for (int k=kstart; k<kend; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -78,8 +79,6 @@ namespace
                                       + std::abs(interp4c(w[ijk-kk1], w[ijk], w[ijk+kk1], w[ijk+kk2]))*dzi[k]);
                 }
 
-        master.max(&cfl, 1);
-
         cfl = cfl*dt;
 
         return cfl;
@@ -132,6 +131,7 @@ namespace
                          * dzi4[kstart];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend-1; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -232,6 +232,7 @@ namespace
                          * dzi4[kstart];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend-1; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -332,6 +333,7 @@ namespace
                          * dzhi4[kstart+1];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+2; k<kend-1; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -432,6 +434,7 @@ namespace
                          * dzi4[kstart];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend-1; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -496,6 +499,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -517,6 +521,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -536,6 +541,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -555,6 +561,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -578,12 +585,12 @@ void Advec_4<TF>::create(Stats<TF>& stats)
 
 #ifndef USECUDA
 template<typename TF>
-double Advec_4<TF>::get_cfl(double dt)
+double Advec_4<TF>::get_cfl_local(double dt)
 {
     auto& gd = grid.get_grid_data();
     TF cfl = calc_cfl<TF>(fields.mp.at("u")->fld.data(),fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
                           gd.dzi.data(), gd.dx, gd.dy,
-                          dt, master,
+                          dt,
                           gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
                           gd.icells, gd.ijcells);
 
@@ -592,19 +599,17 @@ double Advec_4<TF>::get_cfl(double dt)
 }
 
 template<typename TF>
-unsigned long Advec_4<TF>::get_time_limit(unsigned long idt, double dt)
+double Advec_4<TF>::get_cfl(double dt)
 {
-    // Calculate cfl and prevent zero divisons.
-    auto& gd = grid.get_grid_data();
-
-    double cfl = calc_cfl<TF>(fields.mp.at("u")->fld.data(),fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
-            gd.dzi.data(), gd.dx, gd.dy,
-            dt, master,
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    double cfl = get_cfl_local(dt);
+    master.max(&cfl, 1);
+    return cfl;
+}
 
-    cfl = std::max(cflmin, cfl);
-    return idt * cflmax / cfl;
+template<typename TF>
+unsigned long Advec_4<TF>::get_time_limit(unsigned long idt, double dt)
+{
+    return this->get_time_limit_from_cfl(idt, get_cfl(dt));
 }
 
 template<typename TF>
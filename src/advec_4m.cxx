@@ -52,7 +52,7 @@ namespace
     TF calc_cfl(
             const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
             const TF* const restrict dzi, const TF dx, const TF dy,
-            const TF dt, Master& master,
+            const TF dt,
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int jj, const int kk)
     {
@@ -68,6 +68,7 @@ namespace
 
         TF cfl = 0;
 
+        #pragma omp parallel for reduction(max:cfl)
         for (int k=kstart; k<kend; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -80,8 +81,6 @@ namespace
                                       + std::abs(ci0<TF>*w[ijk-kk1] + ci1<TF>*w[ijk] + ci2<TF>*w[ijk+kk1] + ci3<TF>*w[ijk+kk2])*dzi[k]) );
                 }
 
-        master.max(&cfl, 1);
-
         cfl = cfl*dt;
 
         return cfl;
@@ -132,6 +131,7 @@ namespace
                            * dzi4[kstart];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend-1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -226,6 +226,7 @@ namespace
                            * dzi4[kstart];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend-1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -297,6 +298,7 @@ namespace
         const TF dyi = 1./dy;
 
         // Assume that w at the boundaries is zero.
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -367,6 +369,7 @@ namespace
                            * dzi4[kstart];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend-1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -427,6 +430,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -448,6 +452,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -467,6 +472,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -486,6 +492,7 @@ namespace
         const int kk1 = 1*kk;
         const int kk2 = 2*kk;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -509,12 +516,12 @@ void Advec_4m<TF>::create(Stats<TF>& stats)
 
 #ifndef USECUDA
 template<typename TF>
-double Advec_4m<TF>::get_cfl(double dt)
+double Advec_4m<TF>::get_cfl_local(double dt)
 {
     auto& gd = grid.get_grid_data();
     TF cfl = calc_cfl<TF>(fields.mp.at("u")->fld.data(),fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
                           gd.dzi.data(), gd.dx, gd.dy,
-                          dt, master,
+                          dt,
                           gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
                           gd.icells, gd.ijcells);
 
@@ -523,19 +530,17 @@ double Advec_4m<TF>::get_cfl(double dt)
 }
 
 template<typename TF>
-unsigned long Advec_4m<TF>::get_time_limit(unsigned long idt, double dt)
+double Advec_4m<TF>::get_cfl(double dt)
 {
-    // Calculate cfl and prevent zero divisons.
-    auto& gd = grid.get_grid_data();
-
-    double cfl = calc_cfl<TF>(fields.mp.at("u")->fld.data(),fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
-            gd.dzi.data(), gd.dx, gd.dy,
-            dt, master,
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    double cfl = get_cfl_local(dt);
+    master.max(&cfl, 1);
+    return cfl;
+}
 
-    cfl = std::max(cflmin, cfl);
-    return idt * cflmax / cfl;
+template<typename TF>
+unsigned long Advec_4m<TF>::get_time_limit(unsigned long idt, double dt)
+{
+    return this->get_time_limit_from_cfl(idt, get_cfl(dt));
 }
 
 template<typename TF>
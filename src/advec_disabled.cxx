@@ -44,6 +44,12 @@ unsigned long Advec_disabled<TF>::get_time_limit(unsigned long idt, const double
     return Constants::ulhuge;
 }
 
+template<typename TF>
+unsigned long Advec_disabled<TF>::get_time_limit_from_cfl(unsigned long idt, const double cfl)
+{
+    return Constants::ulhuge;
+}
+
 template<typename TF>
 double Advec_disabled<TF>::get_cfl(const double dt)
 {
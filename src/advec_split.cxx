@@ -0,0 +1,387 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "input.h"
+#include "advec.h"
+#include "advec_split.h"
+#include "timeloop.h"
+#include "defines.h"
+
+namespace
+{
+    // Monotonized central slope of a cell from the values of the cell and its neighbours.
+    template<typename TF>
+    inline TF mc_slope(const TF qm, const TF q, const TF qp)
+    {
+        const TF dl = q - qm;
+        const TF dr = qp - q;
+
+        if (dl*dr <= TF(0.))
+            return TF(0.);
+
+        return std::copysign(
+                std::min({TF(2.)*std::abs(dl), TF(0.5)*std::abs(dl+dr), TF(2.)*std::abs(dr)}), dl);
+    }
+
+    // Flux through the face between the cells with qm and q, of the profile that is swept over
+    // the face by displacement disp, with Courant number c of the upwind cell.
+    template<typename TF>
+    inline TF face_flux(const TF disp, const TF c, const TF qmm, const TF qm, const TF q, const TF qp)
+    {
+        if (disp >= TF(0.))
+            return disp * (qm + TF(0.5)*(TF(1.)-c)*mc_slope(qmm, qm, q));
+        else
+            return disp * (q  - TF(0.5)*(TF(1.)-c)*mc_slope(qm, q, qp));
+    }
+
+    // Sweep in the x (ii=1) or y (ii=jj) direction, of which the ghost cells have to be up to date.
+    template<typename TF>
+    void sweep_horizontal(
+            TF* const restrict q, TF* const restrict flux,
+            const TF* const restrict disp, const TF dxi, const int ii,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        const int ii2 = 2*ii;
+        const int iend_face = (ii == 1) ? iend+1 : iend;
+        const int jend_face = (ii == 1) ? jend : jend+1;
+
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend_face; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend_face; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const TF c = std::abs(disp[ijk])*dxi;
+                    flux[ijk] = face_flux(disp[ijk], c, q[ijk-ii2], q[ijk-ii], q[ijk], q[ijk+ii]);
+                }
+
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    q[ijk] -= (flux[ijk+ii] - flux[ijk]) * dxi;
+                }
+    }
+
+    // Sweep in the vertical direction. The walls are closed, and the cells at the walls have no slope.
+    // The displacement is weighted with the density of the face, relative to that of the upwind cell.
+    template<typename TF>
+    void sweep_vertical(
+            TF* const restrict q, TF* const restrict flux,
+            const TF* const restrict disp,
+            const TF* const restrict dzi,
+            const TF* const restrict rhoref, const TF* const restrict rhorefh,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        const int kk2 = 2*kk;
+
+        #pragma omp parallel for
+        for (int j=jstart; j<jend; ++j)
+            #pragma ivdep
+            for (int i=istart; i<iend; ++i)
+            {
+                flux[i + j*jj + kstart*kk] = TF(0.);
+                flux[i + j*jj + kend  *kk] = TF(0.);
+            }
+
+        #pragma omp parallel for
+        for (int k=kstart+1; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const TF d = disp[ijk];
+
+                    if (d >= TF(0.))
+                    {
+                        const TF c = d*dzi[k-1];
+                        const TF slope = (k-1 > kstart) ? mc_slope(q[ijk-kk2], q[ijk-kk], q[ijk]) : TF(0.);
+                        flux[ijk] = rhorefh[k]/rhoref[k-1] * d * (q[ijk-kk] + TF(0.5)*(TF(1.)-c)*slope);
+                    }
+                    else
+                    {
+                        const TF c = -d*dzi[k];
+                        const TF slope = (k < kend-1) ? mc_slope(q[ijk-kk], q[ijk], q[ijk+kk]) : TF(0.);
+                        flux[ijk] = rhorefh[k]/rhoref[k] * d * (q[ijk] - TF(0.5)*(TF(1.)-c)*slope);
+                    }
+                }
+
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    q[ijk] -= (flux[ijk+kk] - flux[ijk]) * dzi[k];
+                }
+    }
+}
+
+template<typename TF>
+Advec_split<TF>::Advec_split(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Advec<TF>& advecin, Input& inputin) :
+    master(masterin), grid(gridin), fields(fieldsin), boundary_cyclic(masterin, gridin)
+{
+    split_list = advecin.get_split_list();
+    nsteps = 0;
+
+    if (!split_list.empty())
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("splitlist in [advec] is not implemented on the GPU");
+        #endif
+
+        if (advecin.get_switch() != Advection_type::Advec_2 && advecin.get_switch() != Advection_type::Advec_2i5)
+            throw std::runtime_error("splitlist in [advec] is only supported with swadvec = 2 or 2i5");
+
+        splitsteps = inputin.get_item<int>("advec", "splitsteps", "");
+        splitcflmax = inputin.get_item<TF>("advec", "splitcflmax", "", 0.5);
+
+        if (splitsteps < 1)
+            throw std::runtime_error("splitsteps in [advec] has to be at least 1");
+
+        // The slopes of the cells next to a face need two ghost cells.
+        grid.set_minimum_ghost_cells(2, 2, 1);
+    }
+    else
+    {
+        inputin.flag_as_used("advec", "splitsteps", "");
+        inputin.flag_as_used("advec", "splitcflmax", "");
+    }
+}
+
+template<typename TF>
+Advec_split<TF>::~Advec_split()
+{
+}
+
+template<typename TF>
+void Advec_split<TF>::init()
+{
+    if (split_list.empty())
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    boundary_cyclic.init();
+
+    xdisp.assign(gd.ncells, TF(0.));
+    ydisp.assign(gd.ncells, TF(0.));
+    zdisp.assign(gd.ncells, TF(0.));
+}
+
+template<typename TF>
+void Advec_split<TF>::create(Timeloop<TF>& timeloop)
+{
+    for (auto& name : split_list)
+        if (fields.sp.find(name) == fields.sp.end())
+            throw std::runtime_error("Field \"" + name + "\" in splitlist of [advec] is not a prognostic scalar");
+}
+
+template<typename TF>
+void Advec_split<TF>::begin_step(Timeloop<TF>& timeloop)
+{
+    if (split_list.empty() || timeloop.in_substep())
+        return;
+
+    add_velocities(TF(0.5)*timeloop.get_dt());
+}
+
+template<typename TF>
+void Advec_split<TF>::exec(Timeloop<TF>& timeloop)
+{
+    if (split_list.empty() || timeloop.in_substep())
+        return;
+
+    add_velocities(TF(0.5)*timeloop.get_dt());
+    ++nsteps;
+
+    // The interval is closed before the restart files are written, which do not hold the displacements.
+    if (nsteps == splitsteps
+            || timeloop.get_itime() % timeloop.get_isavetime() == 0
+            || timeloop.is_finished())
+    {
+        advect();
+
+        nsteps = 0;
+        std::fill(xdisp.begin(), xdisp.end(), TF(0.));
+        std::fill(ydisp.begin(), ydisp.end(), TF(0.));
+        std::fill(zdisp.begin(), zdisp.end(), TF(0.));
+    }
+}
+
+template<typename TF>
+void Advec_split<TF>::add_velocities(const double dt)
+{
+    auto& gd = grid.get_grid_data();
+    const TF fac = dt;
+
+    const TF* const restrict u = fields.mp.at("u")->fld.data();
+    const TF* const restrict v = fields.mp.at("v")->fld.data();
+    const TF* const restrict w = fields.mp.at("w")->fld.data();
+
+    // Only the interior is up to date at the end of a time step, the ghost cells are exchanged in advect().
+    #pragma omp parallel for
+    for (int k=gd.kstart; k<gd.kend; ++k)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+            #pragma ivdep
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*gd.icells + k*gd.ijcells;
+                xdisp[ijk] += fac*u[ijk];
+                ydisp[ijk] += fac*v[ijk];
+                zdisp[ijk] += fac*w[ijk];
+            }
+}
+
+template<typename TF>
+void Advec_split<TF>::advect()
+{
+    auto& gd = grid.get_grid_data();
+
+    const int jj = gd.icells;
+    const int kk = gd.ijcells;
+    const TF dxi = TF(1.)/gd.dx;
+    const TF dyi = TF(1.)/gd.dy;
+
+    boundary_cyclic.exec(xdisp.data());
+    boundary_cyclic.exec(ydisp.data());
+
+    // The interval is divided in substeps that keep the largest Courant number below splitcflmax.
+    double cmax = 0.;
+
+    #pragma omp parallel for reduction(max:cmax)
+    for (int k=gd.kstart; k<gd.kend; ++k)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*jj + k*kk;
+                const TF dzi_max = (k > gd.kstart) ? std::max(gd.dzi[k-1], gd.dzi[k]) : TF(0.);
+                cmax = std::max({cmax,
+                        double(std::abs(xdisp[ijk])*dxi),
+                        double(std::abs(ydisp[ijk])*dyi),
+                        double(std::abs(zdisp[ijk])*dzi_max)});
+            }
+
+    master.max(&cmax, 1);
+
+    const int nsub = std::max(1, static_cast<int>(std::ceil(cmax / splitcflmax)));
+    const TF fac = TF(1.)/nsub;
+
+    for (auto* disp : {&xdisp, &ydisp, &zdisp})
+        for (auto& d : *disp)
+            d *= fac;
+
+    auto rho = fields.get_tmp();
+    auto flux = fields.get_tmp();
+
+    const TF* const restrict rhoref = fields.rhoref.data();
+
+    // Multiply or divide the interior by the density of the cell.
+    auto scale = [&](TF* const restrict q, const TF* const restrict den, const bool multiply)
+    {
+        #pragma omp parallel for
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                #pragma ivdep
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    q[ijk] = multiply ? q[ijk]*rhoref[k] : q[ijk]/den[ijk];
+                }
+    };
+
+    auto sweep = [&](TF* const restrict q, const int dir)
+    {
+        if (dir == 0)
+        {
+            boundary_cyclic.exec(q);
+            sweep_horizontal<TF>(
+                    q, flux->fld.data(), xdisp.data(), dxi, 1,
+                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, jj, kk);
+        }
+        else if (dir == 1)
+        {
+            boundary_cyclic.exec(q);
+            sweep_horizontal<TF>(
+                    q, flux->fld.data(), ydisp.data(), dyi, jj,
+                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, jj, kk);
+        }
+        else
+            sweep_vertical<TF>(
+                    q, flux->fld.data(), zdisp.data(), gd.dzi.data(),
+                    rhoref, fields.rhorefh.data(),
+                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, jj, kk);
+    };
+
+    for (int n=0; n<nsub; ++n)
+    {
+        // The pseudo density restarts from the reference density in every substep.
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            std::fill(rho->fld.begin() + k*kk, rho->fld.begin() + (k+1)*kk, rhoref[k]);
+
+        for (auto& name : split_list)
+            scale(fields.sp.at(name)->fld.data(), nullptr, true);
+
+        // Alternate the order of the sweeps, such that the splitting error cancels over two substeps.
+        for (int d=0; d<3; ++d)
+        {
+            const int dir = (n % 2 == 0) ? d : 2-d;
+
+            sweep(rho->fld.data(), dir);
+            for (auto& name : split_list)
+                sweep(fields.sp.at(name)->fld.data(), dir);
+        }
+
+        for (auto& name : split_list)
+            scale(fields.sp.at(name)->fld.data(), rho->fld.data(), false);
+    }
+
+    fields.release_tmp(rho);
+    fields.release_tmp(flux);
+}
+
+
+#ifdef FLOAT_SINGLE
+template class Advec_split<float>;
+#else
+template class Advec_split<double>;
+#endif
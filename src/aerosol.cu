@@ -31,65 +31,25 @@
 template<typename TF>
 void Aerosol<TF>::prepare_device()
 {
-    if (sw_aerosol && sw_timedep)
+    // The profiles are also needed on the device without time dependency.
+    if (sw_aerosol)
     {
-        auto &gd = grid.get_grid_data();
-        const int nmemsize = gd.kcells * sizeof(TF);
+        const int nmemsize = aermr.size() * sizeof(TF);
 
-        cuda_safe_call(cudaMalloc(&aermr01_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr02_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr03_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr04_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr05_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr06_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr07_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr08_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr09_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr10_g, nmemsize));
-        cuda_safe_call(cudaMalloc(&aermr11_g, nmemsize));
-
-        cuda_safe_call(cudaMemcpy(aermr01_g, aermr01.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr02_g, aermr02.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr03_g, aermr03.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr04_g, aermr04.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr05_g, aermr05.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr06_g, aermr06.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr07_g, aermr07.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr08_g, aermr08.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr09_g, aermr09.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr10_g, aermr10.data(), nmemsize, cudaMemcpyHostToDevice));
-        cuda_safe_call(cudaMemcpy(aermr11_g, aermr11.data(), nmemsize, cudaMemcpyHostToDevice));
+        cuda_safe_call(cudaMalloc(&aermr_g, nmemsize));
+        cuda_safe_call(cudaMemcpy(aermr_g, aermr.data(), nmemsize, cudaMemcpyHostToDevice));
     }
 }
 
 template<typename TF>
 void Aerosol<TF>::clear_device()
 {
-    if (sw_aerosol && sw_timedep)
+    if (sw_aerosol)
     {
-        cuda_safe_call(cudaFree(aermr01_g));
-        cuda_safe_call(cudaFree(aermr02_g));
-        cuda_safe_call(cudaFree(aermr03_g));
-        cuda_safe_call(cudaFree(aermr04_g));
-        cuda_safe_call(cudaFree(aermr05_g));
-        cuda_safe_call(cudaFree(aermr06_g));
-        cuda_safe_call(cudaFree(aermr07_g));
-        cuda_safe_call(cudaFree(aermr08_g));
-        cuda_safe_call(cudaFree(aermr09_g));
-        cuda_safe_call(cudaFree(aermr10_g));
-        cuda_safe_call(cudaFree(aermr11_g));
+        cuda_safe_call(cudaFree(aermr_g));
 
-        tdep_aermr01->clear_device();
-        tdep_aermr02->clear_device();
-        tdep_aermr03->clear_device();
-        tdep_aermr04->clear_device();
-        tdep_aermr05->clear_device();
-        tdep_aermr06->clear_device();
-        tdep_aermr07->clear_device();
-        tdep_aermr08->clear_device();
-        tdep_aermr09->clear_device();
-        tdep_aermr10->clear_device();
-        tdep_aermr11->clear_device();
+        if (sw_timedep)
+            tdep_aermr->clear_device();
     }
 }
 
@@ -101,19 +61,7 @@ void Aerosol<TF>::update_time_dependent(Timeloop<TF>& timeloop)
         return;
 
     if (sw_timedep)
-    {
-        tdep_aermr01 ->update_time_dependent_prof_g(aermr01_g, timeloop);
-        tdep_aermr02 ->update_time_dependent_prof_g(aermr02_g, timeloop);
-        tdep_aermr03 ->update_time_dependent_prof_g(aermr03_g, timeloop);
-        tdep_aermr04 ->update_time_dependent_prof_g(aermr04_g, timeloop);
-        tdep_aermr05 ->update_time_dependent_prof_g(aermr05_g, timeloop);
-        tdep_aermr06 ->update_time_dependent_prof_g(aermr06_g, timeloop);
-        tdep_aermr07 ->update_time_dependent_prof_g(aermr07_g, timeloop);
-        tdep_aermr08 ->update_time_dependent_prof_g(aermr08_g, timeloop);
-        tdep_aermr09 ->update_time_dependent_prof_g(aermr09_g, timeloop);
-        tdep_aermr10 ->update_time_dependent_prof_g(aermr10_g, timeloop);
-        tdep_aermr11 ->update_time_dependent_prof_g(aermr11_g, timeloop);
-    }
+        tdep_aermr->update_time_dependent_prof_g(aermr_g, timeloop);
 }
 
 template<typename TF>
@@ -122,33 +70,14 @@ void Aerosol<TF>::get_radiation_fields(std::unique_ptr<Aerosol_concs_gpu>& aeros
     auto& gd = grid.get_grid_data();
     const int ncol = 1;
 
-    Array_gpu<Float,2> aermr01_a(aermr01_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr02_a(aermr02_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr03_a(aermr03_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr04_a(aermr04_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr05_a(aermr05_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr06_a(aermr06_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr07_a(aermr07_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr08_a(aermr08_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr09_a(aermr09_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr10_a(aermr10_g, {1, int(gd.kcells)});
-    Array_gpu<Float,2> aermr11_a(aermr11_g, {1, int(gd.kcells)});
-
     const int kstart = gd.kgc+1;
     const int kend = gd.ktot + gd.kgc;
 
-    aerosol_concs_gpu->set_vmr("aermr01", aermr01_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr02", aermr02_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr03", aermr03_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr04", aermr04_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr05", aermr05_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr06", aermr06_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr07", aermr07_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr08", aermr08_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr09", aermr09_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr10", aermr10_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-    aerosol_concs_gpu->set_vmr("aermr11", aermr11_a.subset({ {{1, ncol}, {kstart, kend}}} ));
-
+    for (size_t n=0; n<species.size(); ++n)
+    {
+        Array_gpu<Float,2> aermr_a(aermr_g + n*gd.kcells, {1, int(gd.kcells)});
+        aerosol_concs_gpu->set_vmr(species[n], aermr_a.subset({ {{1, ncol}, {kstart, kend}}} ));
+    }
 }
 #endif
 
@@ -77,23 +77,6 @@ namespace
         }
     }
 
-    template<typename TF> __global__
-    void copy_xy_g(
-            TF* const __restrict__ out,
-            const TF* const __restrict__ in,
-            const int icells,
-            const int jcells)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y;
-
-        if (i < icells && j < jcells)
-        {
-            const int ij  = i + j*icells;
-            out[ij] = in[ij];
-        }
-    }
-
     template<typename TF> __global__
     void interp_sbot_time_g(
             TF* const __restrict__ fld_out,
@@ -115,112 +98,81 @@ namespace
     }
 
 
+    // The bottom and top ghost cells of all fields in the table, with one field per blockIdx.z.
     template<typename TF> __global__
-    void calc_ghost_cells_bot_2nd_g(TF* __restrict__ a, const TF* __restrict__ dzh, Boundary_type sw,
-                                    TF* __restrict__ abot, TF* __restrict__ agradbot,
-                                    const int icells, const int jcells, const int kstart)
+    void calc_ghost_cells_2nd_g(const Ghost_cell_bc<TF>* __restrict__ bcs, const TF* __restrict__ dzh,
+                                const int icells, const int jcells, const int kstart, const int kend)
     {
         const int i = blockIdx.x*blockDim.x + threadIdx.x;
         const int j = blockIdx.y*blockDim.y + threadIdx.y;
+        const Ghost_cell_bc<TF> bc = bcs[blockIdx.z];
 
-        const int kk  = icells*jcells;
-        const int ij  = i + j*icells;
-        const int ijk = i + j*icells + kstart*kk;
+        const int kk   = icells*jcells;
+        const int ij   = i + j*icells;
+        const int ijkb = i + j*icells + kstart*kk;
+        const int ijkt = i + j*icells + (kend-1)*kk;
 
         if (i < icells && j < jcells)
         {
-            if (sw == Boundary_type::Dirichlet_type)
-                a[ijk-kk] = TF(2.)*abot[ij] - a[ijk];
-
-            else if (sw == Boundary_type::Neumann_type || sw == Boundary_type::Flux_type)
-                a[ijk-kk] = -agradbot[ij]*dzh[kstart] + a[ijk];
-        }
-    }
+            if (bc.bcbot == Boundary_type::Dirichlet_type)
+                bc.fld[ijkb-kk] = TF(2.)*bc.fld_bot[ij] - bc.fld[ijkb];
 
-    template<typename TF> __global__
-    void calc_ghost_cells_top_2nd_g(TF* __restrict__ a, const TF* __restrict__ dzh, const Boundary_type sw,
-                                    TF* __restrict__ atop, const TF* __restrict__ agradtop,
-                                    const int icells, const int jcells, const int kend)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y;
+            else if (bc.bcbot == Boundary_type::Neumann_type || bc.bcbot == Boundary_type::Flux_type)
+                bc.fld[ijkb-kk] = -bc.grad_bot[ij]*dzh[kstart] + bc.fld[ijkb];
 
-        const int kk  = icells*jcells;
-        const int ij  = i + j*icells;
-        const int ijk = i + j*icells + (kend-1)*kk;
+            if (bc.bctop == Boundary_type::Dirichlet_type)
+                bc.fld[ijkt+kk] = TF(2.)*bc.fld_top[ij] - bc.fld[ijkt];
 
-        if (i < icells && j < jcells)
-        {
-            if (sw == Boundary_type::Dirichlet_type)
-                a[ijk+kk] = TF(2.)*atop[ij] - a[ijk];
-
-            else if (sw == Boundary_type::Off_type)
+            else if (bc.bctop == Boundary_type::Off_type)
             {
-                atop[ij] = TF(3./2.)*a[ijk] - TF(1./2.)*a[ijk-kk];
-                a[ijk+kk] = TF(2.)*atop[ij] - a[ijk];
+                bc.fld_top[ij] = TF(3./2.)*bc.fld[ijkt] - TF(1./2.)*bc.fld[ijkt-kk];
+                bc.fld[ijkt+kk] = TF(2.)*bc.fld_top[ij] - bc.fld[ijkt];
             }
 
-            else if (sw == Boundary_type::Neumann_type || sw == Boundary_type::Flux_type)
-                a[ijk+kk] = agradtop[ij]*dzh[kend] + a[ijk];
+            else if (bc.bctop == Boundary_type::Neumann_type || bc.bctop == Boundary_type::Flux_type)
+                bc.fld[ijkt+kk] = bc.grad_top[ij]*dzh[kend] + bc.fld[ijkt];
         }
     }
 
     template<typename TF> __global__
-    void calc_ghost_cells_bot_4th_g(TF* __restrict__ a, const TF* __restrict__ z, const Boundary_type sw,
-                                    const TF* __restrict__ abot, const TF* __restrict__ agradbot,
-                                    const int icells, const int jcells, const int kstart)
+    void calc_ghost_cells_4th_g(const Ghost_cell_bc<TF>* __restrict__ bcs, const TF* __restrict__ z,
+                                const int icells, const int jcells, const int kstart, const int kend)
     {
         const int i = blockIdx.x*blockDim.x + threadIdx.x;
         const int j = blockIdx.y*blockDim.y + threadIdx.y;
+        const Ghost_cell_bc<TF> bc = bcs[blockIdx.z];
 
         const int kk1 = 1*icells*jcells;
         const int kk2 = 2*icells*jcells;
 
-        const int ij  = i + j*icells;
-        const int ijk = i + j*icells + kstart*kk1;
+        const int ij   = i + j*icells;
+        const int ijkb = i + j*icells + kstart*kk1;
+        const int ijkt = i + j*icells + (kend-1)*kk1;
 
         if (i < icells && j < jcells)
         {
-            if (sw == Boundary_type::Dirichlet_type)
+            if (bc.bcbot == Boundary_type::Dirichlet_type)
             {
-                a[ijk-kk1] = TF(8./3.)*abot[ij] - TF(2.)*a[ijk] + TF(1./3.)*a[ijk+kk1];
-                a[ijk-kk2] = TF(8.)*abot[ij] - TF(9.)*a[ijk] + TF(2.)*a[ijk+kk1];
+                bc.fld[ijkb-kk1] = TF(8./3.)*bc.fld_bot[ij] - TF(2.)*bc.fld[ijkb] + TF(1./3.)*bc.fld[ijkb+kk1];
+                bc.fld[ijkb-kk2] = TF(8.)*bc.fld_bot[ij] - TF(9.)*bc.fld[ijkb] + TF(2.)*bc.fld[ijkb+kk1];
             }
 
-            else if (sw == Boundary_type::Neumann_type || sw == Boundary_type::Flux_type)
+            else if (bc.bcbot == Boundary_type::Neumann_type || bc.bcbot == Boundary_type::Flux_type)
             {
-                a[ijk-kk1] = TF(-1.)*grad4(z[kstart-2], z[kstart-1], z[kstart], z[kstart+1])*agradbot[ij] + a[ijk    ];
-                a[ijk-kk2] = TF(-3.)*grad4(z[kstart-2], z[kstart-1], z[kstart], z[kstart+1])*agradbot[ij] + a[ijk+kk1];
+                bc.fld[ijkb-kk1] = TF(-1.)*grad4(z[kstart-2], z[kstart-1], z[kstart], z[kstart+1])*bc.grad_bot[ij] + bc.fld[ijkb    ];
+                bc.fld[ijkb-kk2] = TF(-3.)*grad4(z[kstart-2], z[kstart-1], z[kstart], z[kstart+1])*bc.grad_bot[ij] + bc.fld[ijkb+kk1];
             }
-        }
-    }
 
-    template<typename TF> __global__
-    void calc_ghost_cells_top_4th_g(TF* __restrict__ a, const TF* __restrict__ z, const Boundary_type sw,
-                                    const TF* __restrict__ atop, const TF* __restrict__ agradtop,
-                                    const int icells, const int jcells, const int kend)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y;
-
-        const int kk1 = 1*icells*jcells;
-        const int kk2 = 2*icells*jcells;
-
-        const int ij  = i + j*icells;
-        const int ijk = i + j*icells + (kend-1)*kk1;
-
-        if( i < icells && j < jcells)
-        {
-            if (sw == Boundary_type::Dirichlet_type)
+            if (bc.bctop == Boundary_type::Dirichlet_type)
             {
-                a[ijk+kk1] = TF(8./3.)*atop[ij] - TF(2.)*a[ijk] + TF(1./3.)*a[ijk-kk1];
-                a[ijk+kk2] = TF(8.)*atop[ij] - TF(9.)*a[ijk] + TF(2.)*a[ijk-kk1];
+                bc.fld[ijkt+kk1] = TF(8./3.)*bc.fld_top[ij] - TF(2.)*bc.fld[ijkt] + TF(1./3.)*bc.fld[ijkt-kk1];
+                bc.fld[ijkt+kk2] = TF(8.)*bc.fld_top[ij] - TF(9.)*bc.fld[ijkt] + TF(2.)*bc.fld[ijkt-kk1];
             }
 
-            else if (sw == Boundary_type::Neumann_type || sw == Boundary_type::Flux_type)
+            else if (bc.bctop == Boundary_type::Neumann_type || bc.bctop == Boundary_type::Flux_type)
             {
-                a[ijk+kk1] = TF(1.)*grad4(z[kend-2], z[kend-1], z[kend], z[kend+1])*agradtop[ij] + a[ijk    ];
-                a[ijk+kk2] = TF(3.)*grad4(z[kend-2], z[kend-1], z[kend], z[kend+1])*agradtop[ij] + a[ijk-kk1];
+                bc.fld[ijkt+kk1] = TF(1.)*grad4(z[kend-2], z[kend-1], z[kend], z[kend+1])*bc.grad_top[ij] + bc.fld[ijkt    ];
+                bc.fld[ijkt+kk2] = TF(3.)*grad4(z[kend-2], z[kend-1], z[kend], z[kend+1])*bc.grad_top[ij] + bc.fld[ijkt-kk1];
             }
         }
     }
@@ -313,90 +265,23 @@ void Boundary<TF>::set_ghost_cells()
     const int gridi  = gd.icells/blocki + (gd.icells%blocki > 0);
     const int gridj  = gd.jcells/blockj + (gd.jcells%blockj > 0);
 
-    dim3 grid2dGPU (gridi, gridj);
+    // All fields of the table are handled in a single launch.
+    dim3 grid2dGPU (gridi, gridj, ghost_cell_bcs_g.size());
     dim3 block2dGPU(blocki, blockj);
 
     if (grid.get_spatial_order() == Grid_order::Second)
     {
-        calc_ghost_cells_bot_2nd_g<TF><<<grid2dGPU, block2dGPU>>>(
-            fields.mp.at("u")->fld_g, gd.dzh_g, mbcbot,
-            fields.mp.at("u")->fld_bot_g, fields.mp.at("u")->grad_bot_g,
-            gd.icells, gd.jcells, gd.kstart);
-        cuda_check_error();
-
-        calc_ghost_cells_top_2nd_g<TF><<<grid2dGPU, block2dGPU>>>(
-            fields.mp.at("u")->fld_g, gd.dzh_g, mbctop,
-            fields.mp.at("u")->fld_top_g, fields.mp.at("u")->grad_top_g,
-            gd.icells, gd.jcells, gd.kend);
+        calc_ghost_cells_2nd_g<TF><<<grid2dGPU, block2dGPU>>>(
+            ghost_cell_bcs_g, gd.dzh_g,
+            gd.icells, gd.jcells, gd.kstart, gd.kend);
         cuda_check_error();
-
-        calc_ghost_cells_bot_2nd_g<TF><<<grid2dGPU, block2dGPU>>>(
-            fields.mp.at("v")->fld_g, gd.dzh_g, mbcbot,
-            fields.mp.at("v")->fld_bot_g, fields.mp.at("v")->grad_bot_g,
-            gd.icells, gd.jcells, gd.kstart);
-        cuda_check_error();
-
-        calc_ghost_cells_top_2nd_g<TF><<<grid2dGPU, block2dGPU>>>(
-            fields.mp.at("v")->fld_g, gd.dzh_g, mbctop,
-            fields.mp.at("v")->fld_top_g, fields.mp.at("v")->grad_top_g,
-            gd.icells, gd.jcells, gd.kend);
-        cuda_check_error();
-
-        for (auto& it : fields.sp)
-        {
-            calc_ghost_cells_bot_2nd_g<TF><<<grid2dGPU, block2dGPU>>>(
-                it.second->fld_g, gd.dzh_g, sbc.at(it.first).bcbot,
-                it.second->fld_bot_g, it.second->grad_bot_g,
-                gd.icells, gd.jcells, gd.kstart);
-            cuda_check_error();
-
-            calc_ghost_cells_top_2nd_g<TF><<<grid2dGPU, block2dGPU>>>(
-                it.second->fld_g, gd.dzh_g, sbc.at(it.first).bctop,
-                it.second->fld_top_g, it.second->grad_top_g,
-                gd.icells, gd.jcells, gd.kend);
-            cuda_check_error();
-        }
     }
     else if (grid.get_spatial_order() == Grid_order::Fourth)
     {
-        calc_ghost_cells_bot_4th_g<TF><<<grid2dGPU, block2dGPU>>>(
-            fields.mp.at("u")->fld_g, gd.z_g, mbcbot,
-            fields.mp.at("u")->fld_bot_g, fields.mp.at("u")->grad_bot_g,
-            gd.icells, gd.jcells, gd.kstart);
+        calc_ghost_cells_4th_g<TF><<<grid2dGPU, block2dGPU>>>(
+            ghost_cell_bcs_g, gd.z_g,
+            gd.icells, gd.jcells, gd.kstart, gd.kend);
         cuda_check_error();
-
-        calc_ghost_cells_top_4th_g<TF><<<grid2dGPU, block2dGPU>>>(
-            fields.mp.at("u")->fld_g, gd.z_g, mbctop,
-            fields.mp.at("u")->fld_top_g, fields.mp.at("u")->grad_top_g,
-            gd.icells, gd.jcells, gd.kend);
-        cuda_check_error();
-
-        calc_ghost_cells_bot_4th_g<TF><<<grid2dGPU, block2dGPU>>>(
-            fields.mp.at("v")->fld_g, gd.z_g, mbcbot,
-            fields.mp.at("v")->fld_bot_g, fields.mp.at("v")->grad_bot_g,
-            gd.icells, gd.jcells, gd.kstart);
-        cuda_check_error();
-
-        calc_ghost_cells_top_4th_g<TF><<<grid2dGPU, block2dGPU>>>(
-            fields.mp.at("v")->fld_g, gd.z_g, mbctop,
-            fields.mp.at("v")->fld_top_g, fields.mp.at("v")->grad_top_g,
-            gd.icells, gd.jcells, gd.kend);
-        cuda_check_error();
-
-        for (auto& it : fields.sp)
-        {
-            calc_ghost_cells_bot_4th_g<TF><<<grid2dGPU, block2dGPU>>>(
-                it.second->fld_g, gd.z_g, sbc.at(it.first).bcbot,
-                it.second->fld_bot_g, it.second->grad_bot_g,
-                gd.icells, gd.jcells, gd.kstart);
-            cuda_check_error();
-
-            calc_ghost_cells_top_4th_g<TF><<<grid2dGPU, block2dGPU>>>(
-                it.second->fld_g, gd.z_g, sbc.at(it.first).bctop,
-                it.second->fld_top_g, it.second->grad_top_g,
-                gd.icells, gd.jcells, gd.kend);
-            cuda_check_error();
-        }
     }
 }
 
@@ -538,7 +423,6 @@ void Boundary<TF>::update_time_dependent(Timeloop<TF>& timeloop)
 
     if (swtimedep_sbot_2d)
     {
-        auto tmp_cpu = fields.get_tmp();
         auto tmp_gpu = fields.get_tmp_g();
 
         unsigned long itime = timeloop.get_itime();
@@ -553,45 +437,19 @@ void Boundary<TF>::update_time_dependent(Timeloop<TF>& timeloop)
 
         if (itime > itime_sbot_2d_next)
         {
-            // Read new surface sbot fields
+            // Complete the read of the new surface sbot fields and start the next one.
             unsigned long iiotimeprec = timeloop.get_iiotimeprec();
 
             itime_sbot_2d_prev = itime_sbot_2d_next;
             itime_sbot_2d_next = itime_sbot_2d_prev + iloadtime_sbot_2d;
-            const int iotime1 = int(itime_sbot_2d_next / iiotimeprec);
 
-            int nerror = 0;
+            int nerror = finish_sbot_2d_prefetch();
 
             for (auto& fld : sbot_2d_list)
             {
-                // Swap 2D input fields at both CPU and GPU.
-                // CPU is not strictly necessary, but it keeps the
-                // CPU and GPU fields identical...
-                sbot_2d_prev.at(fld) = sbot_2d_next.at(fld);
+                // Swap the 2D input fields at the GPU as at the CPU, and copy the new field.
+                std::swap(sbot_2d_prev_g.at(fld), sbot_2d_next_g.at(fld));
 
-                copy_xy_g<TF><<<grid2dGPU, block2dGPU>>>(
-                        sbot_2d_prev_g.at(fld),
-                        sbot_2d_next_g.at(fld),
-                        gd.icells, gd.jcells);
-
-                // Read new time step
-                char filename[256];
-                std::string name = fld + "_bot_in";
-                std::sprintf(filename, "%s.%07d", name.c_str(), iotime1);
-                master.print_message("Loading \"%s\" ... ", filename);
-
-                if (field3d_io.load_xy_slice(
-                        sbot_2d_next.at(fld).data(), tmp_cpu->fld.data(), filename))
-                {
-                    master.print_message("FAILED\n");
-                    nerror += 1;
-                }
-                else
-                    master.print_message("OK\n");
-
-                boundary_cyclic.exec_2d(sbot_2d_next.at(fld).data());
-
-                // Copy new field to the GPU.
                 cuda_safe_call(cudaMemcpy(
                         sbot_2d_next_g.at(fld),
                         sbot_2d_next.at(fld).data(),
@@ -602,6 +460,8 @@ void Boundary<TF>::update_time_dependent(Timeloop<TF>& timeloop)
             master.sum(&nerror, 1);
             if (nerror)
                 throw std::runtime_error("Error loading time dependent sbot fields");
+
+            start_sbot_2d_prefetch(itime_sbot_2d_next + iloadtime_sbot_2d, iiotimeprec);
         }
 
         // Interpolate sbot to current time
@@ -630,7 +490,6 @@ void Boundary<TF>::update_time_dependent(Timeloop<TF>& timeloop)
                     set_flux_grad);
         }
 
-        fields.release_tmp(tmp_cpu);
         fields.release_tmp_g(tmp_gpu);
     }
     else
@@ -658,19 +517,31 @@ void Boundary<TF>::update_time_dependent(Timeloop<TF>& timeloop)
         for (auto& it : tdep_outflow)
             it.second->update_time_dependent_prof_g(inflow_profiles_g.at(it.first), timeloop);
     }
+
+    boundary_outflow.update_time_dependent(timeloop);
 }
 
 template<typename TF>
-void Boundary<TF>::set_prognostic_cyclic_bcs()
+void Boundary<TF>::begin_prognostic_cyclic_bcs()
 {
-    /* Set cyclic boundary conditions of the
-       prognostic 3D fields */
-    boundary_cyclic.exec_g(fields.mp.at("u")->fld_g);
-    boundary_cyclic.exec_g(fields.mp.at("v")->fld_g);
-    boundary_cyclic.exec_g(fields.mp.at("w")->fld_g);
+    // The exchanges of the device fields are completed directly.
+    // Every field only exchanges the ghost cells that its stencils read.
+    auto exec_g = [&](Field3d<TF>& fld)
+    {
+        boundary_cyclic.exec_g(fld.fld_g, fld.halo[0], fld.halo[1]);
+    };
+
+    exec_g(*fields.mp.at("u"));
+    exec_g(*fields.mp.at("v"));
+    exec_g(*fields.mp.at("w"));
 
     for (auto& it : fields.sp)
-        boundary_cyclic.exec_g(it.second->fld_g);
+        exec_g(*it.second);
+}
+
+template<typename TF>
+void Boundary<TF>::finish_prognostic_cyclic_bcs()
+{
 }
 
 template<typename TF>
@@ -678,7 +549,7 @@ void Boundary<TF>::set_prognostic_outflow_bcs()
 {
     // Overwrite here the ghost cells for the scalars with outflow BCs
     for (auto& s : scalar_outflow)
-        boundary_outflow.exec(fields.sp.at(s)->fld_g, inflow_profiles_g.at(s));
+        boundary_outflow.exec(fields.sp.at(s)->fld_g, inflow_profiles_g.at(s), s);
 }
 
 template<typename TF>
@@ -720,6 +591,13 @@ void Boundary<TF>::prepare_device(Thermo<TF>& thermo)
         cuda_safe_call(cudaMemcpy(inflow_profiles_g.at(scalar), inflow_profiles.at(scalar).data(), kmemsize, cudaMemcpyHostToDevice));
     }
 
+    boundary_outflow.prepare_device();
+
+    // The device pointers of the fields exist only now.
+    ghost_cell_bcs_g.allocate(ghost_cell_bcs.size());
+    const std::vector<Ghost_cell_bc<TF>> bcs_g = get_ghost_cell_bcs(true);
+    cuda_safe_call(cudaMemcpy(ghost_cell_bcs_g, bcs_g.data(), bcs_g.size()*sizeof(Ghost_cell_bc<TF>), cudaMemcpyHostToDevice));
+
     if (swtimedep_sbot_2d)
     {
         for (auto& scalar : sbot_2d_list)
@@ -745,6 +623,8 @@ void Boundary<TF>::clear_device(Thermo<TF>& thermo)
     for (auto& scalar : scalar_outflow)
         cuda_safe_call(cudaFree(inflow_profiles_g.at(scalar)));
 
+    boundary_outflow.clear_device();
+
     if (swtimedep_sbot_2d)
     {
         for (auto& scalar : sbot_2d_list)
@@ -160,6 +160,10 @@ Boundary<TF>::Boundary(
         boundary_cyclic(master, grid), boundary_outflow(master, grid, inputin), field3d_io(master, grid)
 {
     swboundary = "default";
+
+    // Send the halos of all prognostic fields in one message per neighbour.
+    const bool swbatchcyclic = inputin.get_item<bool>("boundary", "swbatchcyclic", "", false);
+    boundary_cyclic.set_batch(swbatchcyclic);
 }
 
 template<typename TF>
@@ -169,6 +173,17 @@ Boundary<TF>::~Boundary()
     // CvH: is this necessary?
     sbc.clear();
 
+    // Complete the read that is still in flight at the end of the run.
+    if (swtimedep_sbot_2d)
+    {
+        auto& gd = grid.get_grid_data();
+        std::vector<TF> tmp(gd.ijcells);
+
+        for (auto& fld : sbot_2d_list)
+            if (sbot_2d_started.at(fld))
+                field3d_io.load_xy_slice_end(tmp.data(), sbot_2d_buffer.at(fld).data(), sbot_2d_request.at(fld));
+    }
+
     // clean up time dependent data
     // for (auto& i : timedepdata)
     //     delete[] i.second;
@@ -270,6 +285,48 @@ void Boundary<TF>::process_bcs(Input& input)
 
     // Read the scalars for which free inflow / outflow conditions are applied.
     scalar_outflow = input.get_list<std::string>("boundary", "scalar_outflow", "", std::vector<std::string>());
+
+    u_handle = fields.get_handle("u");
+    v_handle = fields.get_handle("v");
+    w_handle = fields.get_handle("w");
+
+    sbc_list.clear();
+    for (int h=fields.get_scalar_handle_begin(); h<fields.get_nprog(); ++h)
+        sbc_list.push_back(&sbc.at(fields.get_prog_name(h)));
+
+    ghost_cell_bcs = get_ghost_cell_bcs(false);
+}
+
+template<typename TF>
+std::vector<Ghost_cell_bc<TF>> Boundary<TF>::get_ghost_cell_bcs(const bool device)
+{
+    std::vector<Ghost_cell_bc<TF>> bcs;
+
+    auto add_field = [&](Field3d<TF>& fld, const Boundary_type bcbot, const Boundary_type bctop)
+    {
+        #ifdef USECUDA
+        if (device)
+        {
+            bcs.push_back({fld.fld_g, fld.fld_bot_g, fld.grad_bot_g, fld.fld_top_g, fld.grad_top_g, bcbot, bctop});
+            return;
+        }
+        #endif
+
+        bcs.push_back({
+                fld.fld.data(), fld.fld_bot.data(), fld.grad_bot.data(),
+                fld.fld_top.data(), fld.grad_top.data(), bcbot, bctop});
+    };
+
+    add_field(fields.get_prog(u_handle), mbcbot, mbctop);
+    add_field(fields.get_prog(v_handle), mbcbot, mbctop);
+
+    for (int h=fields.get_scalar_handle_begin(); h<fields.get_nprog(); ++h)
+    {
+        const Field3dBc<TF>& bc = *sbc_list[h - fields.get_scalar_handle_begin()];
+        add_field(fields.get_prog(h), bc.bcbot, bc.bctop);
+    }
+
+    return bcs;
 }
 
 template<typename TF>
@@ -300,7 +357,7 @@ void Boundary<TF>::create(
         Cross<TF>& cross, Timeloop<TF>& timeloop)
 {
     process_time_dependent(input, input_nc, timeloop);
-    process_inflow(input, input_nc);
+    process_inflow(input, input_nc, timeloop);
 }
 
 template<typename TF>
@@ -409,12 +466,69 @@ void Boundary<TF>::process_time_dependent(
             throw std::runtime_error("Error loading time dependent sbot fields");
 
         fields.release_tmp(tmp);
+
+        for (auto& fld : sbot_2d_list)
+        {
+            sbot_2d_buffer.emplace(fld, std::vector<TF>(gd.imax*gd.jmax));
+            sbot_2d_request.emplace(fld, Field3d_io_request());
+            sbot_2d_started.emplace(fld, false);
+        }
+
+        start_sbot_2d_prefetch(itime_sbot_2d_next + iloadtime_sbot_2d, iiotimeprec);
+    }
+}
+
+template <typename TF>
+void Boundary<TF>::start_sbot_2d_prefetch(const unsigned long itime, const unsigned long iiotimeprec)
+{
+    // A missing file is only an error once the time level is needed, as the run can end before.
+    iotime_sbot_2d_prefetch = int(itime / iiotimeprec);
+
+    for (auto& fld : sbot_2d_list)
+    {
+        char filename[256];
+        std::string name = fld + "_bot_in";
+        std::snprintf(filename, 256, "%s.%07d", name.c_str(), iotime_sbot_2d_prefetch);
+
+        sbot_2d_started.at(fld) = !field3d_io.load_xy_slice_begin(
+                sbot_2d_buffer.at(fld).data(), filename, sbot_2d_request.at(fld));
+    }
+}
+
+template <typename TF>
+int Boundary<TF>::finish_sbot_2d_prefetch()
+{
+    int nerror = 0;
+
+    for (auto& fld : sbot_2d_list)
+    {
+        // The old next time level becomes prev, the read fills the other buffer.
+        sbot_2d_prev.at(fld).swap(sbot_2d_next.at(fld));
+
+        char filename[256];
+        std::string name = fld + "_bot_in";
+        std::snprintf(filename, 256, "%s.%07d", name.c_str(), iotime_sbot_2d_prefetch);
+        master.print_message("Loading \"%s\" ... ", filename);
+
+        if (!sbot_2d_started.at(fld) || field3d_io.load_xy_slice_end(
+                sbot_2d_next.at(fld).data(), sbot_2d_buffer.at(fld).data(), sbot_2d_request.at(fld)))
+        {
+            master.print_message("FAILED\n");
+            nerror += 1;
+        }
+        else
+            master.print_message("OK\n");
+
+        sbot_2d_started.at(fld) = false;
+        boundary_cyclic.exec_2d(sbot_2d_next.at(fld).data());
     }
+
+    return nerror;
 }
 
 template<typename TF>
 void Boundary<TF>::process_inflow(
-        Input& input, Netcdf_handle& input_nc)
+        Input& input, Netcdf_handle& input_nc, Timeloop<TF>& timeloop)
 {
     auto& gd = grid.get_grid_data();
 
@@ -443,21 +557,44 @@ void Boundary<TF>::process_inflow(
             inflow_profiles.emplace(scalar, prof);
         }
     }
+
+    // The time varying boundary slabs replace the inflow profiles at the inflow edges.
+    boundary_outflow.create(scalar_outflow, timeloop);
 }
 
-#ifndef USECUDA
 template<typename TF>
 void Boundary<TF>::set_prognostic_cyclic_bcs()
 {
     /* Set cyclic boundary conditions of the
        prognostic 3D fields */
+    begin_prognostic_cyclic_bcs();
+    finish_prognostic_cyclic_bcs();
+}
+
+#ifndef USECUDA
+template<typename TF>
+void Boundary<TF>::begin_prognostic_cyclic_bcs()
+{
+    // Post the exchanges of all fields before waiting for any of them,
+    // such that the messages of the different fields are in flight together.
+    // Every field only exchanges the ghost cells that its stencils read.
+    auto begin_exchange = [&](Field3d<TF>& fld)
+    {
+        boundary_cyclic.begin_exchange(fld.fld.data(), fld.halo[0], fld.halo[1]);
+    };
 
-    boundary_cyclic.exec(fields.mp.at("u")->fld.data());
-    boundary_cyclic.exec(fields.mp.at("v")->fld.data());
-    boundary_cyclic.exec(fields.mp.at("w")->fld.data());
+    begin_exchange(*fields.mp.at("u"));
+    begin_exchange(*fields.mp.at("v"));
+    begin_exchange(*fields.mp.at("w"));
 
     for (auto& it : fields.sp)
-        boundary_cyclic.exec(it.second->fld.data());
+        begin_exchange(*it.second);
+}
+
+template<typename TF>
+void Boundary<TF>::finish_prognostic_cyclic_bcs()
+{
+    boundary_cyclic.finish_exchange();
 }
 #endif
 
@@ -468,7 +605,7 @@ void Boundary<TF>::set_prognostic_outflow_bcs()
 {
     // Overwrite here the ghost cells for the scalars with outflow BCs
     for (auto& s : scalar_outflow)
-        boundary_outflow.exec(fields.sp.at(s)->fld.data(), inflow_profiles.at(s).data());
+        boundary_outflow.exec(fields.sp.at(s)->fld.data(), inflow_profiles.at(s).data(), s);
 }
 #endif
 
@@ -489,41 +626,19 @@ void Boundary<TF>::update_time_dependent(Timeloop<TF>& timeloop)
 
         if (itime > itime_sbot_2d_next)
         {
-            // Read new surface sbot fields
+            // Complete the read of the new surface sbot fields and start the next one.
             unsigned long iiotimeprec = timeloop.get_iiotimeprec();
 
             itime_sbot_2d_prev = itime_sbot_2d_next;
             itime_sbot_2d_next = itime_sbot_2d_prev + iloadtime_sbot_2d;
-            const int iotime1 = int(itime_sbot_2d_next / iiotimeprec);
-
-            int nerror = 0;
-
-            // Swap 2D input fields
-            for (auto& fld : sbot_2d_list)
-            {
-                sbot_2d_prev.at(fld) = sbot_2d_next.at(fld);
-
-                // Read new time step
-                char filename[256];
-                std::string name = fld + "_bot_in";
-                std::snprintf(filename, 256, "%s.%07d", name.c_str(), iotime1);
-                master.print_message("Loading \"%s\" ... ", filename);
-
-                if (field3d_io.load_xy_slice(
-                        sbot_2d_next.at(fld).data(), tmp->fld.data(), filename))
-                {
-                    master.print_message("FAILED\n");
-                    nerror += 1;
-                }
-                else
-                    master.print_message("OK\n");
 
-                boundary_cyclic.exec_2d(sbot_2d_next.at(fld).data());
-            }
+            int nerror = finish_sbot_2d_prefetch();
 
             master.sum(&nerror, 1);
             if (nerror)
                 throw std::runtime_error("Error loading time dependent sbot fields");
+
+            start_sbot_2d_prefetch(itime_sbot_2d_next + iloadtime_sbot_2d, iiotimeprec);
         }
 
         // Interpolate sbot to current time
@@ -592,6 +707,8 @@ void Boundary<TF>::update_time_dependent(Timeloop<TF>& timeloop)
         for (auto& it : tdep_outflow)
             it.second->update_time_dependent_prof(inflow_profiles.at(it.first), timeloop);
     }
+
+    boundary_outflow.update_time_dependent(timeloop);
 }
 #endif
 
@@ -697,152 +814,102 @@ void Boundary<TF>::set_values()
 
 namespace
 {
+    // The bottom and top ghost cells of all fields in the table, in a single sweep per field.
     template<typename TF>
-    void calc_ghost_cells_bot_2nd(TF* const restrict a, const TF* const restrict dzh, Boundary_type boundary_type,
-                                  TF* const restrict abot, TF* const restrict agradbot,
-                                  const int kstart, const int icells, const int jcells, const int ijcells)
+    void calc_ghost_cells_2nd(const Ghost_cell_bc<TF>* const bcs, const int nfields, const TF* const restrict dzh,
+                              const int kstart, const int kend, const int icells, const int jcells, const int ijcells)
     {
         const int jj = icells;
         const int kk = ijcells;
 
-        if (boundary_type == Boundary_type::Dirichlet_type)
-        {
-            for (int j=0; j<jcells; ++j)
-                #pragma ivdep
-                for (int i=0; i<icells; ++i)
-                {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + kstart*kk;
-                    a[ijk-kk] = TF(2.)*abot[ij] - a[ijk];
-                }
-        }
-        else if (boundary_type == Boundary_type::Neumann_type || boundary_type == Boundary_type::Flux_type)
+        for (int n=0; n<nfields; ++n)
         {
-            for (int j=0; j<jcells; ++j)
-                #pragma ivdep
-                for (int i=0; i<icells; ++i)
-                {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + kstart*kk;
-                    a[ijk-kk] = -agradbot[ij]*dzh[kstart] + a[ijk];
-                }
-        }
-    }
+            TF* const restrict a = bcs[n].fld;
+            const TF* const restrict abot = bcs[n].fld_bot;
+            const TF* const restrict agradbot = bcs[n].grad_bot;
+            TF* const restrict atop = bcs[n].fld_top;
+            const TF* const restrict agradtop = bcs[n].grad_top;
 
-    template<typename TF>
-    void calc_ghost_cells_top_2nd(TF* const restrict a, const TF* const restrict dzh, Boundary_type boundary_type,
-                                  TF* const restrict atop, TF* const restrict agradtop,
-                                  const int kend, const int icells, const int jcells, const int ijcells)
-    {
-        const int jj = icells;
-        const int kk = ijcells;
+            const Boundary_type bcbot = bcs[n].bcbot;
+            const Boundary_type bctop = bcs[n].bctop;
 
-        if (boundary_type == Boundary_type::Dirichlet_type || boundary_type == Boundary_type::Off_type)
-        {
-            if (boundary_type == Boundary_type::Off_type)
-            {
-                for (int j=0; j<jcells; ++j)
-                    #pragma ivdep
-                    for (int i=0; i<icells; ++i)
-                    {
-                        const int ij  = i + j*jj;
-                        const int ijk = i + j*jj + (kend-1)*kk;
-                        atop[ij] = TF(3./2.)*a[ijk] - TF(1./2.)*a[ijk-kk];
-                    }
-            }
-
-            for (int j=0; j<jcells; ++j)
-                #pragma ivdep
-                for (int i=0; i<icells; ++i)
-                {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + (kend-1)*kk;
-                    a[ijk+kk] = TF(2.)*atop[ij] - a[ijk];
-                }
-        }
-        else if (boundary_type == Boundary_type::Neumann_type || boundary_type == Boundary_type::Flux_type)
-        {
             for (int j=0; j<jcells; ++j)
                 #pragma ivdep
                 for (int i=0; i<icells; ++i)
                 {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + (kend-1)*kk;
-                    a[ijk+kk] = agradtop[ij]*dzh[kend] + a[ijk];
+                    const int ij   = i + j*jj;
+                    const int ijkb = i + j*jj + kstart*kk;
+                    const int ijkt = i + j*jj + (kend-1)*kk;
+
+                    if (bcbot == Boundary_type::Dirichlet_type)
+                        a[ijkb-kk] = TF(2.)*abot[ij] - a[ijkb];
+                    else if (bcbot == Boundary_type::Neumann_type || bcbot == Boundary_type::Flux_type)
+                        a[ijkb-kk] = -agradbot[ij]*dzh[kstart] + a[ijkb];
+
+                    if (bctop == Boundary_type::Off_type)
+                        atop[ij] = TF(3./2.)*a[ijkt] - TF(1./2.)*a[ijkt-kk];
+
+                    if (bctop == Boundary_type::Dirichlet_type || bctop == Boundary_type::Off_type)
+                        a[ijkt+kk] = TF(2.)*atop[ij] - a[ijkt];
+                    else if (bctop == Boundary_type::Neumann_type || bctop == Boundary_type::Flux_type)
+                        a[ijkt+kk] = agradtop[ij]*dzh[kend] + a[ijkt];
                 }
         }
     }
 
     template<typename TF>
-    void calc_ghost_cells_bot_4th(TF* const restrict a, const TF* const restrict z, Boundary_type boundary_type,
-                                  TF* const restrict abot, TF* restrict agradbot,
-                                  const int kstart, const int icells, const int jcells, const int ijcells)
+    void calc_ghost_cells_4th(const Ghost_cell_bc<TF>* const bcs, const int nfields, const TF* const restrict z,
+                              const int kstart, const int kend, const int icells, const int jcells, const int ijcells)
     {
+        using Finite_difference::O4::grad4;
+
         const int jj  = icells;
         const int kk1 = 1*ijcells;
         const int kk2 = 2*ijcells;
 
-        if (boundary_type == Boundary_type::Dirichlet_type)
-        {
-            for (int j=0; j<jcells; ++j)
-                #pragma ivdep
-                for (int i=0; i<icells; ++i)
-                {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + kstart*kk1;
-                    a[ijk-kk1] = TF(8./3.)*abot[ij] - TF(2.)*a[ijk] + TF(1./3.)*a[ijk+kk1];
-                    a[ijk-kk2] = TF(8.)*abot[ij] - TF(9.)*a[ijk] + TF(2.)*a[ijk+kk1];
-                }
-        }
-        else if (boundary_type == Boundary_type::Neumann_type || boundary_type == Boundary_type::Flux_type)
-        {
-            using Finite_difference::O4::grad4;
+        const TF dzhib = grad4(z[kstart-2], z[kstart-1], z[kstart], z[kstart+1]);
+        const TF dzhit = grad4(z[kend-2], z[kend-1], z[kend], z[kend+1]);
 
-            for (int j=0; j<jcells; ++j)
-                #pragma ivdep
-                for (int i=0; i<icells; ++i)
-                {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + kstart*kk1;
-                    a[ijk-kk1] = TF(-1.)*grad4(z[kstart-2], z[kstart-1], z[kstart], z[kstart+1])*agradbot[ij] + a[ijk    ];
-                    a[ijk-kk2] = TF(-3.)*grad4(z[kstart-2], z[kstart-1], z[kstart], z[kstart+1])*agradbot[ij] + a[ijk+kk1];
-                }
-        }
-    }
+        for (int n=0; n<nfields; ++n)
+        {
+            TF* const restrict a = bcs[n].fld;
+            const TF* const restrict abot = bcs[n].fld_bot;
+            const TF* const restrict agradbot = bcs[n].grad_bot;
+            const TF* const restrict atop = bcs[n].fld_top;
+            const TF* const restrict agradtop = bcs[n].grad_top;
 
-    template<typename TF>
-    void calc_ghost_cells_top_4th(TF* const restrict a, const TF* const restrict z, Boundary_type boundary_type,
-                                  TF* const restrict atop, TF* const restrict agradtop,
-                                  const int kend, const int icells, const int jcells, const int ijcells)
-    {
-        const int jj  = icells;
-        const int kk1 = 1*ijcells;
-        const int kk2 = 2*ijcells;
+            const Boundary_type bcbot = bcs[n].bcbot;
+            const Boundary_type bctop = bcs[n].bctop;
 
-        if (boundary_type == Boundary_type::Dirichlet_type)
-        {
             for (int j=0; j<jcells; ++j)
                 #pragma ivdep
                 for (int i=0; i<icells; ++i)
                 {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + (kend-1)*kk1;
-                    a[ijk+kk1] = TF(8./3.)*atop[ij] - TF(2.)*a[ijk] + TF(1./3.)*a[ijk-kk1];
-                    a[ijk+kk2] = TF(8.)*atop[ij] - TF(9.)*a[ijk] + TF(2.)*a[ijk-kk1];
-                }
-        }
-        else if (boundary_type == Boundary_type::Neumann_type || boundary_type == Boundary_type::Flux_type)
-        {
-            using Finite_difference::O4::grad4;
+                    const int ij   = i + j*jj;
+                    const int ijkb = i + j*jj + kstart*kk1;
+                    const int ijkt = i + j*jj + (kend-1)*kk1;
 
-            for (int j=0; j<jcells; ++j)
-                #pragma ivdep
-                for (int i=0; i<icells; ++i)
-                {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + (kend-1)*kk1;
-                    a[ijk+kk1] = TF(1.)*grad4(z[kend-2], z[kend-1], z[kend], z[kend+1])*agradtop[ij] + a[ijk    ];
-                    a[ijk+kk2] = TF(3.)*grad4(z[kend-2], z[kend-1], z[kend], z[kend+1])*agradtop[ij] + a[ijk-kk1];
+                    if (bcbot == Boundary_type::Dirichlet_type)
+                    {
+                        a[ijkb-kk1] = TF(8./3.)*abot[ij] - TF(2.)*a[ijkb] + TF(1./3.)*a[ijkb+kk1];
+                        a[ijkb-kk2] = TF(8.)*abot[ij] - TF(9.)*a[ijkb] + TF(2.)*a[ijkb+kk1];
+                    }
+                    else if (bcbot == Boundary_type::Neumann_type || bcbot == Boundary_type::Flux_type)
+                    {
+                        a[ijkb-kk1] = TF(-1.)*dzhib*agradbot[ij] + a[ijkb    ];
+                        a[ijkb-kk2] = TF(-3.)*dzhib*agradbot[ij] + a[ijkb+kk1];
+                    }
+
+                    if (bctop == Boundary_type::Dirichlet_type)
+                    {
+                        a[ijkt+kk1] = TF(8./3.)*atop[ij] - TF(2.)*a[ijkt] + TF(1./3.)*a[ijkt-kk1];
+                        a[ijkt+kk2] = TF(8.)*atop[ij] - TF(9.)*a[ijkt] + TF(2.)*a[ijkt-kk1];
+                    }
+                    else if (bctop == Boundary_type::Neumann_type || bctop == Boundary_type::Flux_type)
+                    {
+                        a[ijkt+kk1] = TF(1.)*dzhit*agradtop[ij] + a[ijkt    ];
+                        a[ijkt+kk2] = TF(3.)*dzhit*agradtop[ij] + a[ijkt-kk1];
+                    }
                 }
         }
     }
@@ -933,63 +1000,22 @@ template<typename TF>
 void Boundary<TF>::set_ghost_cells()
 {
     auto& gd = grid.get_grid_data();
+    Field3d<TF>& w = fields.get_prog(w_handle);
 
     if (grid.get_spatial_order() == Grid_order::Second)
     {
-        calc_ghost_cells_bot_2nd<TF>(fields.mp.at("u")->fld.data(), gd.dzh.data(), mbcbot,
-                fields.mp.at("u")->fld_bot.data(), fields.mp.at("u")->grad_bot.data(),
-                gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-        calc_ghost_cells_top_2nd<TF>(fields.mp.at("u")->fld.data(), gd.dzh.data(), mbctop,
-                fields.mp.at("u")->fld_top.data(), fields.mp.at("u")->grad_top.data(),
-                gd.kend, gd.icells, gd.jcells, gd.ijcells);
-
-        calc_ghost_cells_bot_2nd<TF>(fields.mp.at("v")->fld.data(), gd.dzh.data(), mbcbot,
-                fields.mp.at("v")->fld_bot.data(), fields.mp.at("v")->grad_bot.data(),
-                gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-        calc_ghost_cells_top_2nd<TF>(fields.mp.at("v")->fld.data(), gd.dzh.data(), mbctop,
-                fields.mp.at("v")->fld_top.data(), fields.mp.at("v")->grad_top.data(),
-                gd.kend, gd.icells, gd.jcells, gd.ijcells);
-
-        for (auto& it : fields.sp)
-        {
-            calc_ghost_cells_bot_2nd<TF>(it.second->fld.data(), gd.dzh.data(),
-                    sbc.at(it.first).bcbot, it.second->fld_bot.data(), it.second->grad_bot.data(),
-                    gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-            calc_ghost_cells_top_2nd<TF>(it.second->fld.data(), gd.dzh.data(),
-                    sbc.at(it.first).bctop, it.second->fld_top.data(), it.second->grad_top.data(),
-                    gd.kend, gd.icells, gd.jcells, gd.ijcells);
-        }
+        calc_ghost_cells_2nd<TF>(ghost_cell_bcs.data(), ghost_cell_bcs.size(), gd.dzh.data(),
+                gd.kstart, gd.kend, gd.icells, gd.jcells, gd.ijcells);
     }
     else if (grid.get_spatial_order() == Grid_order::Fourth)
     {
-        calc_ghost_cells_bot_4th<TF>(fields.mp.at("u")->fld.data(), gd.z.data(), mbcbot,
-                fields.mp.at("u")->fld_bot.data(), fields.mp.at("u")->grad_bot.data(),
-                gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-        calc_ghost_cells_top_4th<TF>(fields.mp.at("u")->fld.data(), gd.z.data(), mbctop,
-                fields.mp.at("u")->fld_top.data(), fields.mp.at("u")->grad_top.data(),
-                gd.kend, gd.icells, gd.jcells, gd.ijcells);
+        calc_ghost_cells_4th<TF>(ghost_cell_bcs.data(), ghost_cell_bcs.size(), gd.z.data(),
+                gd.kstart, gd.kend, gd.icells, gd.jcells, gd.ijcells);
 
-        calc_ghost_cells_bot_4th<TF>(fields.mp.at("v")->fld.data(), gd.z.data(), mbcbot,
-                fields.mp.at("v")->fld_bot.data(), fields.mp.at("v")->grad_bot.data(),
+        calc_ghost_cells_botw_4th<TF>(w.fld.data(),
                 gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-        calc_ghost_cells_top_4th<TF>(fields.mp.at("v")->fld.data(), gd.z.data(), mbctop,
-                fields.mp.at("v")->fld_top.data(), fields.mp.at("v")->grad_top.data(),
+        calc_ghost_cells_topw_4th<TF>(w.fld.data(),
                 gd.kend, gd.icells, gd.jcells, gd.ijcells);
-
-        calc_ghost_cells_botw_4th<TF>(fields.mp.at("w")->fld.data(),
-                gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-        calc_ghost_cells_topw_4th<TF>(fields.mp.at("w")->fld.data(),
-                gd.kend, gd.icells, gd.jcells, gd.ijcells);
-
-        for (auto& it : fields.sp)
-        {
-            calc_ghost_cells_bot_4th<TF>(it.second->fld.data(), gd.z.data(), sbc.at(it.first).bcbot,
-                    it.second->fld_bot.data(), it.second->grad_bot.data(),
-                    gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-            calc_ghost_cells_top_4th<TF>(it.second->fld.data(), gd.z.data(), sbc.at(it.first).bctop,
-                    it.second->fld_top.data(), it.second->grad_top.data(),
-                    gd.kend, gd.icells, gd.jcells, gd.ijcells);
-        }
     }
 
     // Update the boundary fields that are a slave of the boundary condition.
@@ -1000,21 +1026,22 @@ template<typename TF>
 void Boundary<TF>::set_ghost_cells_w(const Boundary_w_type boundary_w_type)
 {
     const Grid_data<TF>& gd = grid.get_grid_data();
+    Field3d<TF>& w = fields.get_prog(w_handle);
 
     if (grid.get_spatial_order() == Grid_order::Fourth)
     {
         if (boundary_w_type == Boundary_w_type::Normal_type)
         {
-            calc_ghost_cells_botw_4th<TF>(fields.mp.at("w")->fld.data(),
+            calc_ghost_cells_botw_4th<TF>(w.fld.data(),
                     gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-            calc_ghost_cells_topw_4th<TF>(fields.mp.at("w")->fld.data(),
+            calc_ghost_cells_topw_4th<TF>(w.fld.data(),
                     gd.kend, gd.icells, gd.jcells, gd.ijcells);
         }
         else if (boundary_w_type == Boundary_w_type::Conservation_type)
         {
-            calc_ghost_cells_botw_cons_4th<TF>(fields.mp.at("w")->fld.data(),
+            calc_ghost_cells_botw_cons_4th<TF>(w.fld.data(),
                     gd.kstart, gd.icells, gd.jcells, gd.ijcells);
-            calc_ghost_cells_topw_cons_4th<TF>(fields.mp.at("w")->fld.data(),
+            calc_ghost_cells_topw_cons_4th<TF>(w.fld.data(),
                     gd.kend, gd.icells, gd.jcells, gd.ijcells);
         }
     }
@@ -1090,42 +1117,54 @@ template<typename TF>
 void Boundary<TF>::update_slave_bcs()
 {
     const Grid_data<TF>& gd = grid.get_grid_data();
+    Field3d<TF>& u = fields.get_prog(u_handle);
+    Field3d<TF>& v = fields.get_prog(v_handle);
 
     if (grid.get_spatial_order() == Grid_order::Second)
     {
-        calc_slave_bc_bot<TF,2>(fields.mp.at("u")->fld_bot.data(), fields.mp.at("u")->grad_bot.data(), fields.mp.at("u")->flux_bot.data(),
-                                fields.mp.at("u")->fld.data(), gd.dzhi.data(),
-                                mbcbot, fields.mp.at("u")->visc,
+        calc_slave_bc_bot<TF,2>(u.fld_bot.data(), u.grad_bot.data(), u.flux_bot.data(),
+                                u.fld.data(), gd.dzhi.data(),
+                                mbcbot, u.visc,
                                 gd.kstart, gd.icells, gd.jcells, gd.ijcells);
 
-        calc_slave_bc_bot<TF,2>(fields.mp.at("v")->fld_bot.data(), fields.mp.at("v")->grad_bot.data(), fields.mp.at("v")->flux_bot.data(),
-                                fields.mp.at("v")->fld.data(), gd.dzhi.data(),
-                                mbcbot, fields.mp.at("v")->visc,
+        calc_slave_bc_bot<TF,2>(v.fld_bot.data(), v.grad_bot.data(), v.flux_bot.data(),
+                                v.fld.data(), gd.dzhi.data(),
+                                mbcbot, v.visc,
                                 gd.kstart, gd.icells, gd.jcells, gd.ijcells);
 
-        for (auto& it : fields.sp)
-            calc_slave_bc_bot<TF,2>(it.second->fld_bot.data(), it.second->grad_bot.data(), it.second->flux_bot.data(),
-                                    it.second->fld.data(), gd.dzhi.data(),
-                                    sbc.at(it.first).bcbot, it.second->visc,
+        for (int h=fields.get_scalar_handle_begin(); h<fields.get_nprog(); ++h)
+        {
+            Field3d<TF>& sc = fields.get_prog(h);
+            const Field3dBc<TF>& bc = *sbc_list[h - fields.get_scalar_handle_begin()];
+
+            calc_slave_bc_bot<TF,2>(sc.fld_bot.data(), sc.grad_bot.data(), sc.flux_bot.data(),
+                                    sc.fld.data(), gd.dzhi.data(),
+                                    bc.bcbot, sc.visc,
                                     gd.kstart, gd.icells, gd.jcells, gd.ijcells);
+        }
     }
     else if (grid.get_spatial_order() == Grid_order::Fourth)
     {
-        calc_slave_bc_bot<TF,4>(fields.mp.at("u")->fld_bot.data(), fields.mp.at("u")->grad_bot.data(), fields.mp.at("u")->flux_bot.data(),
-                                fields.mp.at("u")->fld.data(), gd.dzhi4.data(),
-                                mbcbot, fields.mp.at("u")->visc,
+        calc_slave_bc_bot<TF,4>(u.fld_bot.data(), u.grad_bot.data(), u.flux_bot.data(),
+                                u.fld.data(), gd.dzhi4.data(),
+                                mbcbot, u.visc,
                                 gd.kstart, gd.icells, gd.jcells, gd.ijcells);
 
-        calc_slave_bc_bot<TF,4>(fields.mp.at("v")->fld_bot.data(), fields.mp.at("v")->grad_bot.data(), fields.mp.at("v")->flux_bot.data(),
-                                fields.mp.at("v")->fld.data(), gd.dzhi4.data(),
-                                mbcbot, fields.mp.at("v")->visc,
+        calc_slave_bc_bot<TF,4>(v.fld_bot.data(), v.grad_bot.data(), v.flux_bot.data(),
+                                v.fld.data(), gd.dzhi4.data(),
+                                mbcbot, v.visc,
                                 gd.kstart, gd.icells, gd.jcells, gd.ijcells);
 
-        for (auto& it : fields.sp)
-            calc_slave_bc_bot<TF,4>(it.second->fld_bot.data(), it.second->grad_bot.data(), it.second->flux_bot.data(),
-                                    it.second->fld.data(), gd.dzhi4.data(),
-                                    sbc.at(it.first).bcbot, it.second->visc,
+        for (int h=fields.get_scalar_handle_begin(); h<fields.get_nprog(); ++h)
+        {
+            Field3d<TF>& sc = fields.get_prog(h);
+            const Field3dBc<TF>& bc = *sbc_list[h - fields.get_scalar_handle_begin()];
+
+            calc_slave_bc_bot<TF,4>(sc.fld_bot.data(), sc.grad_bot.data(), sc.flux_bot.data(),
+                                    sc.fld.data(), gd.dzhi4.data(),
+                                    bc.bcbot, sc.visc,
                                     gd.kstart, gd.icells, gd.jcells, gd.ijcells);
+        }
     }
 }
 
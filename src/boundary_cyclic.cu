@@ -20,6 +20,9 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
+#include "master.h"
 #include "grid.h"
 #include "tools.h"
 #include "boundary_cyclic.h"
@@ -31,7 +34,7 @@ namespace
                              const int icells, const int jcells, const int kcells,
                              const int istart, const int jstart,
                              const int iend,   const int jend,
-                             const int igc,    const int jgc)
+                             const int ihalo,  const int jhalo)
     {
         const int i = blockIdx.x*blockDim.x + threadIdx.x;
         const int j = blockIdx.y*blockDim.y + threadIdx.y;
@@ -41,10 +44,10 @@ namespace
         const int kk = icells*jcells;
 
         // East-west
-        if (k < kcells && j < jcells && i < igc)
+        if (k < kcells && j < jcells && i < ihalo)
         {
-            const int ijk0 = i          + j*jj + k*kk;
-            const int ijk1 = iend-igc+i + j*jj + k*kk;
+            const int ijk0 = istart-ihalo+i + j*jj + k*kk;
+            const int ijk1 = iend-ihalo+i   + j*jj + k*kk;
             const int ijk2 = i+iend     + j*jj + k*kk;
             const int ijk3 = i+istart   + j*jj + k*kk;
 
@@ -58,7 +61,7 @@ namespace
                              const int icells, const int jcells, const int kcells,
                              const int istart, const int jstart,
                              const int iend,   const int jend,
-                             const int igc,    const int jgc)
+                             const int ihalo,  const int jhalo)
     {
         const int i = blockIdx.x*blockDim.x + threadIdx.x;
         const int j = blockIdx.y*blockDim.y + threadIdx.y;
@@ -70,10 +73,10 @@ namespace
         // North-south
         if (jend-jstart == 1)
         {
-            if (k < kcells && j < jgc && i < icells)
+            if (k < kcells && j < jhalo && i < icells)
             {
                 const int ijkref   = i + jstart*jj   + k*kk;
-                const int ijknorth = i + j*jj        + k*kk;
+                const int ijknorth = i + (jstart-jhalo+j)*jj + k*kk;
                 const int ijksouth = i + (jend+j)*jj + k*kk;
                 data[ijknorth] = data[ijkref];
                 data[ijksouth] = data[ijkref];
@@ -81,10 +84,10 @@ namespace
         }
         else
         {
-            if (k < kcells && j < jgc && i < icells)
+            if (k < kcells && j < jhalo && i < icells)
             {
-                const int ijk0 = i + j           *jj + k*kk;
-                const int ijk1 = i + (jend-jgc+j)*jj + k*kk;
+                const int ijk0 = i + (jstart-jhalo+j)*jj + k*kk;
+                const int ijk1 = i + (jend-jhalo+j)  *jj + k*kk;
                 const int ijk2 = i + (j+jend  )  *jj + k*kk;
                 const int ijk3 = i + (j+jstart)  *jj + k*kk;
 
@@ -93,20 +96,70 @@ namespace
             }
         }
     }
+
+    #ifdef USEMPI
+    template<typename TF> MPI_Datatype mpi_fp_type();
+    template<> MPI_Datatype mpi_fp_type<double>() { return MPI_DOUBLE; }
+    template<> MPI_Datatype mpi_fp_type<float>() { return MPI_FLOAT; }
+
+    // Copy a block of ni*nj*nk cells starting at (i0, j0, 0) into a contiguous buffer.
+    template<typename TF> __global__
+    void pack_block_g(TF* const __restrict__ buffer, const TF* const __restrict__ data,
+                      const int i0, const int j0,
+                      const int ni, const int nj, const int nk,
+                      const int icells, const int ijcells)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y;
+        const int k = blockIdx.z;
+
+        if (i < ni && j < nj && k < nk)
+        {
+            const int ijkb = i + j*ni + k*ni*nj;
+            const int ijk  = (i+i0) + (j+j0)*icells + k*ijcells;
+            buffer[ijkb] = data[ijk];
+        }
+    }
+
+    // Copy a contiguous buffer back into a block of ni*nj*nk cells starting at (i0, j0, 0).
+    template<typename TF> __global__
+    void unpack_block_g(TF* const __restrict__ data, const TF* const __restrict__ buffer,
+                        const int i0, const int j0,
+                        const int ni, const int nj, const int nk,
+                        const int icells, const int ijcells)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y;
+        const int k = blockIdx.z;
+
+        if (i < ni && j < nj && k < nk)
+        {
+            const int ijkb = i + j*ni + k*ni*nj;
+            const int ijk  = (i+i0) + (j+j0)*icells + k*ijcells;
+            data[ijk] = buffer[ijkb];
+        }
+    }
+    #endif
 }
 
+#ifndef USEMPI
 template<typename TF>
-void Boundary_cyclic<TF>::exec_g(TF* data)
+void Boundary_cyclic<TF>::exec_g(TF* data, int ihalo, int jhalo)
 {
     auto& gd = grid.get_grid_data();
 
-    const int blocki_x = gd.igc;
-    const int blockj_x = 256 / gd.igc + (256%gd.igc > 0);
+    if (ihalo == -1)
+        ihalo = gd.igc;
+    if (jhalo == -1)
+        jhalo = gd.jgc;
+
+    const int blocki_x = ihalo;
+    const int blockj_x = 256 / ihalo + (256%ihalo > 0);
     const int gridi_x  = 1;
     const int gridj_x  = gd.jcells/blockj_x + (gd.jcells%blockj_x > 0);
 
-    const int blocki_y = 256 / gd.jgc + (256%gd.jgc > 0);
-    const int blockj_y = gd.jgc;
+    const int blocki_y = 256 / jhalo + (256%jhalo > 0);
+    const int blockj_y = jhalo;
     const int gridi_y  = gd.icells/blocki_y + (gd.icells%blocki_y > 0);
     const int gridj_y  = 1;
 
@@ -118,11 +171,11 @@ void Boundary_cyclic<TF>::exec_g(TF* data)
 
     boundary_cyclic_x_g<TF><<<gridGPUx,blockGPUx>>>(
         data, gd.icells, gd.jcells, gd.kcells,
-        gd.istart, gd.jstart, gd.iend, gd.jend, gd.igc, gd.jgc);
+        gd.istart, gd.jstart, gd.iend, gd.jend, ihalo, jhalo);
 
     boundary_cyclic_y_g<TF><<<gridGPUy,blockGPUy>>>(
         data, gd.icells, gd.jcells, gd.kcells,
-        gd.istart, gd.jstart, gd.iend, gd.jend, gd.igc, gd.jgc);
+        gd.istart, gd.jstart, gd.iend, gd.jend, ihalo, jhalo);
 
     cuda_check_error();
 }
@@ -159,6 +212,117 @@ void Boundary_cyclic<TF>::exec_2d_g(TF* data)
     cuda_check_error();
 }
 
+#else
+template<typename TF>
+void Boundary_cyclic<TF>::exec_mpi_g(TF* data, const int kcells, const int ihalo, const int jhalo)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    // Allocate the buffers for the largest of both edges on the first call.
+    const int nbuffer = std::max(gd.igc*gd.jcells, gd.icells*gd.jgc)*gd.kcells;
+    if (send_buffer_1_g.size() == 0)
+    {
+        send_buffer_1_g.allocate(nbuffer);
+        send_buffer_2_g.allocate(nbuffer);
+        recv_buffer_1_g.allocate(nbuffer);
+        recv_buffer_2_g.allocate(nbuffer);
+    }
+
+    const int blocki = 32;
+    const int blockj = 8;
+    dim3 blockGPU(blocki, blockj, 1);
+
+    // Communicate east-west edges.
+    {
+        const int ncount = ihalo*gd.jcells*kcells;
+
+        dim3 gridGPU(ihalo/blocki + (ihalo%blocki > 0), gd.jcells/blockj + (gd.jcells%blockj > 0), kcells);
+
+        pack_block_g<TF><<<gridGPU, blockGPU>>>(
+            send_buffer_1_g, data, gd.iend-ihalo, 0, ihalo, gd.jcells, kcells, gd.icells, gd.ijcells);
+        pack_block_g<TF><<<gridGPU, blockGPU>>>(
+            send_buffer_2_g, data, gd.istart, 0, ihalo, gd.jcells, kcells, gd.icells, gd.ijcells);
+        cuda_check_error();
+
+        // The buffers need to be complete before MPI can access them.
+        cuda_safe_call(cudaDeviceSynchronize());
+
+        MPI_Isend(send_buffer_1_g, ncount, mpi_fp_type<TF>(), md.neast, 1, md.commxy, master.get_request_ptr());
+        MPI_Irecv(recv_buffer_1_g, ncount, mpi_fp_type<TF>(), md.nwest, 1, md.commxy, master.get_request_ptr());
+        MPI_Isend(send_buffer_2_g, ncount, mpi_fp_type<TF>(), md.nwest, 2, md.commxy, master.get_request_ptr());
+        MPI_Irecv(recv_buffer_2_g, ncount, mpi_fp_type<TF>(), md.neast, 2, md.commxy, master.get_request_ptr());
+        master.add_comm(Comm_site::Halo, 2.*ncount*sizeof(TF), 2);
+        master.wait_all(Comm_site::Halo);
+
+        unpack_block_g<TF><<<gridGPU, blockGPU>>>(
+            data, recv_buffer_1_g, gd.istart-ihalo, 0, ihalo, gd.jcells, kcells, gd.icells, gd.ijcells);
+        unpack_block_g<TF><<<gridGPU, blockGPU>>>(
+            data, recv_buffer_2_g, gd.iend, 0, ihalo, gd.jcells, kcells, gd.icells, gd.ijcells);
+        cuda_check_error();
+    }
+
+    // If the run is 3D, perform the cyclic boundary routine for the north-south direction.
+    if (gd.jtot > 1)
+    {
+        const int ncount = gd.icells*jhalo*kcells;
+
+        dim3 gridGPU(gd.icells/blocki + (gd.icells%blocki > 0), jhalo/blockj + (jhalo%blockj > 0), kcells);
+
+        pack_block_g<TF><<<gridGPU, blockGPU>>>(
+            send_buffer_1_g, data, 0, gd.jend-jhalo, gd.icells, jhalo, kcells, gd.icells, gd.ijcells);
+        pack_block_g<TF><<<gridGPU, blockGPU>>>(
+            send_buffer_2_g, data, 0, gd.jstart, gd.icells, jhalo, kcells, gd.icells, gd.ijcells);
+        cuda_check_error();
+
+        cuda_safe_call(cudaDeviceSynchronize());
+
+        MPI_Isend(send_buffer_1_g, ncount, mpi_fp_type<TF>(), md.nnorth, 1, md.commxy, master.get_request_ptr());
+        MPI_Irecv(recv_buffer_1_g, ncount, mpi_fp_type<TF>(), md.nsouth, 1, md.commxy, master.get_request_ptr());
+        MPI_Isend(send_buffer_2_g, ncount, mpi_fp_type<TF>(), md.nsouth, 2, md.commxy, master.get_request_ptr());
+        MPI_Irecv(recv_buffer_2_g, ncount, mpi_fp_type<TF>(), md.nnorth, 2, md.commxy, master.get_request_ptr());
+        master.add_comm(Comm_site::Halo, 2.*ncount*sizeof(TF), 2);
+        master.wait_all(Comm_site::Halo);
+
+        unpack_block_g<TF><<<gridGPU, blockGPU>>>(
+            data, recv_buffer_1_g, 0, gd.jstart-jhalo, gd.icells, jhalo, kcells, gd.icells, gd.ijcells);
+        unpack_block_g<TF><<<gridGPU, blockGPU>>>(
+            data, recv_buffer_2_g, 0, gd.jend, gd.icells, jhalo, kcells, gd.icells, gd.ijcells);
+        cuda_check_error();
+    }
+    // In case of 2D, fill all the ghost cells in the y-direction with the same value.
+    else
+    {
+        const int blocki_y = 256 / gd.jgc + (256%gd.jgc > 0);
+        const int blockj_y = gd.jgc;
+        const int gridi_y  = gd.icells/blocki_y + (gd.icells%blocki_y > 0);
+        const int gridj_y  = 1;
+
+        dim3 gridGPUy (gridi_y,  gridj_y,  kcells);
+        dim3 blockGPUy(blocki_y, blockj_y, 1);
+
+        boundary_cyclic_y_g<TF><<<gridGPUy,blockGPUy>>>(
+            data, gd.icells, gd.jcells, kcells,
+            gd.istart, gd.jstart, gd.iend, gd.jend, gd.igc, gd.jgc);
+        cuda_check_error();
+    }
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::exec_g(TF* data, int ihalo, int jhalo)
+{
+    auto& gd = grid.get_grid_data();
+    exec_mpi_g(data, gd.kcells, (ihalo == -1) ? gd.igc : ihalo, (jhalo == -1) ? gd.jgc : jhalo);
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::exec_2d_g(TF* data)
+{
+    auto& gd = grid.get_grid_data();
+    exec_mpi_g(data, 1, gd.igc, gd.jgc);
+}
+#endif
+
 
 #ifdef FLOAT_SINGLE
 template class Boundary_cyclic<float>;
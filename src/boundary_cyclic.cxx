@@ -20,6 +20,8 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include "master.h"
 #include "grid.h"
 #include "boundary_cyclic.h"
@@ -28,7 +30,8 @@ template<typename TF>
 Boundary_cyclic<TF>::Boundary_cyclic(Master& masterin, Grid<TF>& gridin) :
     master(masterin),
     grid(gridin),
-    mpi_types_allocated(false)
+    mpi_types_allocated(false),
+    sw_batch(false)
 {
 }
 
@@ -50,6 +53,35 @@ namespace
     template<typename TF> MPI_Datatype mpi_fp_type();
     template<> MPI_Datatype mpi_fp_type<double>() { return MPI_DOUBLE; }
     template<> MPI_Datatype mpi_fp_type<float>() { return MPI_FLOAT; }
+
+    // Copy a block of ghost or edge cells of each field into one contiguous buffer, or back.
+    template<typename TF, bool pack>
+    void copy_block(
+            TF* const restrict buffer, const std::vector<TF*>& fields,
+            const int i0, const int ni, const int j0, const int nj, const int nk,
+            const int jj, const int kk)
+    {
+        const int block = ni*nj*nk;
+
+        for (size_t n=0; n<fields.size(); ++n)
+        {
+            TF* const restrict data = fields[n];
+
+            for (int k=0; k<nk; ++k)
+                for (int j=0; j<nj; ++j)
+                    #pragma ivdep
+                    for (int i=0; i<ni; ++i)
+                    {
+                        const int ijk = (i0+i) + (j0+j)*jj + k*kk;
+                        const int ijkb = n*block + i + j*ni + k*ni*nj;
+
+                        if (pack)
+                            buffer[ijkb] = data[ijk];
+                        else
+                            data[ijk] = buffer[ijkb];
+                    }
+        }
+    }
 }
 
 template<typename TF>
@@ -109,9 +141,54 @@ void Boundary_cyclic<TF>::exit_mpi()
 
         MPI_Type_free(&eastwestedge2d);
         MPI_Type_free(&northsouthedge2d);
+
+        for (auto& it : eastwest_halo_types)
+            MPI_Type_free(&it.second);
+        for (auto& it : northsouth_halo_types)
+            MPI_Type_free(&it.second);
     }
 }
 
+template<typename TF>
+MPI_Datatype Boundary_cyclic<TF>::get_eastwest_type(const int ihalo)
+{
+    auto& gd = grid.get_grid_data();
+
+    if (ihalo == gd.igc)
+        return eastwestedge;
+
+    auto it = eastwest_halo_types.find(ihalo);
+    if (it == eastwest_halo_types.end())
+    {
+        MPI_Datatype type;
+        MPI_Type_vector(gd.jcells*gd.kcells, ihalo, gd.icells, mpi_fp_type<TF>(), &type);
+        MPI_Type_commit(&type);
+        it = eastwest_halo_types.emplace(ihalo, type).first;
+    }
+
+    return it->second;
+}
+
+template<typename TF>
+MPI_Datatype Boundary_cyclic<TF>::get_northsouth_type(const int jhalo)
+{
+    auto& gd = grid.get_grid_data();
+
+    if (jhalo == gd.jgc)
+        return northsouthedge;
+
+    auto it = northsouth_halo_types.find(jhalo);
+    if (it == northsouth_halo_types.end())
+    {
+        MPI_Datatype type;
+        MPI_Type_vector(gd.kcells, gd.icells*jhalo, gd.icells*gd.jcells, mpi_fp_type<TF>(), &type);
+        MPI_Type_commit(&type);
+        it = northsouth_halo_types.emplace(jhalo, type).first;
+    }
+
+    return it->second;
+}
+
 template<typename TF>
 void Boundary_cyclic<TF>::exec(TF* const restrict data, Edge edge)
 {
@@ -133,7 +210,8 @@ void Boundary_cyclic<TF>::exec(TF* const restrict data, Edge edge)
         MPI_Irecv(&data[ westin], ncount, eastwestedge, md.nwest, 1, md.commxy, master.get_request_ptr());
         MPI_Isend(&data[westout], ncount, eastwestedge, md.nwest, 2, md.commxy, master.get_request_ptr());
         MPI_Irecv(&data[ eastin], ncount, eastwestedge, md.neast, 2, md.commxy, master.get_request_ptr());
-        master.wait_all();
+        master.add_comm(Comm_site::Halo, eastwestedge, 2);
+        master.wait_all(Comm_site::Halo);
     }
 
     if (edge == Edge::North_south_edge || edge == Edge::Both_edges)
@@ -152,7 +230,8 @@ void Boundary_cyclic<TF>::exec(TF* const restrict data, Edge edge)
             MPI_Irecv(&data[ southin], ncount, northsouthedge, md.nsouth, 1, md.commxy, master.get_request_ptr());
             MPI_Isend(&data[southout], ncount, northsouthedge, md.nsouth, 2, md.commxy, master.get_request_ptr());
             MPI_Irecv(&data[ northin], ncount, northsouthedge, md.nnorth, 2, md.commxy, master.get_request_ptr());
-            master.wait_all();
+            master.add_comm(Comm_site::Halo, northsouthedge, 2);
+            master.wait_all(Comm_site::Halo);
         }
         // In case of 2D, fill all the ghost cells in the y-direction with the same value.
         else
@@ -200,7 +279,8 @@ void Boundary_cyclic<TF>::exec_2d(TF* const restrict data)
     MPI_Irecv(&data[ westin], ncount, eastwestedge2d, md.nwest, 1, md.commxy, master.get_request_ptr());
     MPI_Isend(&data[westout], ncount, eastwestedge2d, md.nwest, 2, md.commxy, master.get_request_ptr());
     MPI_Irecv(&data[ eastin], ncount, eastwestedge2d, md.neast, 2, md.commxy, master.get_request_ptr());
-    master.wait_all();
+    master.add_comm(Comm_site::Halo_2d, eastwestedge2d, 2);
+    master.wait_all(Comm_site::Halo_2d);
 
     // If the run is 3D, apply the BCs.
     if (gd.jtot > 1)
@@ -210,7 +290,8 @@ void Boundary_cyclic<TF>::exec_2d(TF* const restrict data)
         MPI_Irecv(&data[ southin], ncount, northsouthedge2d, md.nsouth, 1, md.commxy, master.get_request_ptr());
         MPI_Isend(&data[southout], ncount, northsouthedge2d, md.nsouth, 2, md.commxy, master.get_request_ptr());
         MPI_Irecv(&data[ northin], ncount, northsouthedge2d, md.nnorth, 2, md.commxy, master.get_request_ptr());
-        master.wait_all();
+        master.add_comm(Comm_site::Halo_2d, northsouthedge2d, 2);
+        master.wait_all(Comm_site::Halo_2d);
     }
     // In case of 2D, fill all the ghost cells with the current value.
     else
@@ -254,7 +335,8 @@ void Boundary_cyclic<TF>::exec(unsigned int* const restrict data, Edge edge)
         MPI_Irecv(&data[ westin], ncount, eastwestedge_uint, md.nwest, 1, md.commxy, master.get_request_ptr());
         MPI_Isend(&data[westout], ncount, eastwestedge_uint, md.nwest, 2, md.commxy, master.get_request_ptr());
         MPI_Irecv(&data[ eastin], ncount, eastwestedge_uint, md.neast, 2, md.commxy, master.get_request_ptr());
-        master.wait_all();
+        master.add_comm(Comm_site::Halo_mask, eastwestedge_uint, 2);
+        master.wait_all(Comm_site::Halo_mask);
     }
 
     if (edge == Edge::North_south_edge || edge == Edge::Both_edges)
@@ -273,7 +355,8 @@ void Boundary_cyclic<TF>::exec(unsigned int* const restrict data, Edge edge)
             MPI_Irecv(&data[ southin], ncount, northsouthedge_uint, md.nsouth, 1, md.commxy, master.get_request_ptr());
             MPI_Isend(&data[southout], ncount, northsouthedge_uint, md.nsouth, 2, md.commxy, master.get_request_ptr());
             MPI_Irecv(&data[ northin], ncount, northsouthedge_uint, md.nnorth, 2, md.commxy, master.get_request_ptr());
-            master.wait_all();
+            master.add_comm(Comm_site::Halo_mask, northsouthedge_uint, 2);
+            master.wait_all(Comm_site::Halo_mask);
         }
         // In case of 2D, fill all the ghost cells in the y-direction with the same value.
         else
@@ -321,7 +404,8 @@ void Boundary_cyclic<TF>::exec_2d(unsigned int* const restrict data)
     MPI_Irecv(&data[ westin], ncount, eastwestedge2d_uint, md.nwest, 1, md.commxy, master.get_request_ptr());
     MPI_Isend(&data[westout], ncount, eastwestedge2d_uint, md.nwest, 2, md.commxy, master.get_request_ptr());
     MPI_Irecv(&data[ eastin], ncount, eastwestedge2d_uint, md.neast, 2, md.commxy, master.get_request_ptr());
-    master.wait_all();
+    master.add_comm(Comm_site::Halo_mask, eastwestedge2d_uint, 2);
+    master.wait_all(Comm_site::Halo_mask);
 
     // If the run is 3D, apply the BCs.
     if (gd.jtot > 1)
@@ -331,7 +415,8 @@ void Boundary_cyclic<TF>::exec_2d(unsigned int* const restrict data)
         MPI_Irecv(&data[ southin], ncount, northsouthedge2d_uint, md.nsouth, 1, md.commxy, master.get_request_ptr());
         MPI_Isend(&data[southout], ncount, northsouthedge2d_uint, md.nsouth, 2, md.commxy, master.get_request_ptr());
         MPI_Irecv(&data[ northin], ncount, northsouthedge2d_uint, md.nnorth, 2, md.commxy, master.get_request_ptr());
-        master.wait_all();
+        master.add_comm(Comm_site::Halo_mask, northsouthedge2d_uint, 2);
+        master.wait_all(Comm_site::Halo_mask);
     }
     // In case of 2D, fill all the ghost cells with the current value.
     else
@@ -354,6 +439,204 @@ void Boundary_cyclic<TF>::exec_2d(unsigned int* const restrict data)
     }
 }
 
+template<typename TF>
+void Boundary_cyclic<TF>::set_batch(const bool sw_batch_in)
+{
+    sw_batch = sw_batch_in;
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::begin_exchange(TF* data, int ihalo, int jhalo)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    if (ihalo == -1)
+        ihalo = gd.igc;
+    if (jhalo == -1)
+        jhalo = gd.jgc;
+
+    // In batch mode all fields are packed and sent together in finish_exchange.
+    if (sw_batch)
+    {
+        pending_fields.push_back(data);
+        pending_halos.emplace_back(ihalo, jhalo);
+        return;
+    }
+
+    const int ncount = 1;
+    const MPI_Datatype eastwesthalo = get_eastwest_type(ihalo);
+
+    // Give each pending field its own pair of tags.
+    const int tag = 2*pending_fields.size() + 1;
+
+    const int eastout = gd.iend-ihalo;
+    const int westin  = gd.istart-ihalo;
+    const int westout = gd.istart;
+    const int eastin  = gd.iend;
+
+    // Only the east-west edges can be posted directly, the north-south edges include
+    // the corners and have to wait until the east-west ghost cells have arrived.
+    const size_t n = pending_reqs.size();
+    pending_reqs.resize(n+4);
+
+    MPI_Isend(&data[eastout], ncount, eastwesthalo, md.neast, tag  , md.commxy, &pending_reqs[n  ]);
+    MPI_Irecv(&data[ westin], ncount, eastwesthalo, md.nwest, tag  , md.commxy, &pending_reqs[n+1]);
+    MPI_Isend(&data[westout], ncount, eastwesthalo, md.nwest, tag+1, md.commxy, &pending_reqs[n+2]);
+    MPI_Irecv(&data[ eastin], ncount, eastwesthalo, md.neast, tag+1, md.commxy, &pending_reqs[n+3]);
+    master.add_comm(Comm_site::Halo, eastwesthalo, 2);
+
+    pending_fields.push_back(data);
+    pending_halos.emplace_back(ihalo, jhalo);
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::exchange_batch(
+        const std::vector<TF*>& batch_fields,
+        const int i_out_1, const int i_out_2, const int i_in_1, const int i_in_2, const int ni,
+        const int j_out_1, const int j_out_2, const int j_in_1, const int j_in_2, const int nj,
+        const int neighbour_1, const int neighbour_2)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int jj = gd.icells;
+    const int kk = gd.ijcells;
+
+    const int nbatch = ni*nj*gd.kcells*batch_fields.size();
+
+    if (send_buffer_1.size() < static_cast<size_t>(nbatch))
+    {
+        send_buffer_1.resize(nbatch);
+        send_buffer_2.resize(nbatch);
+        recv_buffer_1.resize(nbatch);
+        recv_buffer_2.resize(nbatch);
+    }
+
+    copy_block<TF, true>(send_buffer_1.data(), batch_fields, i_out_1, ni, j_out_1, nj, gd.kcells, jj, kk);
+    copy_block<TF, true>(send_buffer_2.data(), batch_fields, i_out_2, ni, j_out_2, nj, gd.kcells, jj, kk);
+
+    // One message per neighbour per direction for all fields together.
+    MPI_Request reqs[4];
+    MPI_Isend(send_buffer_1.data(), nbatch, mpi_fp_type<TF>(), neighbour_1, 1, md.commxy, &reqs[0]);
+    MPI_Irecv(recv_buffer_1.data(), nbatch, mpi_fp_type<TF>(), neighbour_2, 1, md.commxy, &reqs[1]);
+    MPI_Isend(send_buffer_2.data(), nbatch, mpi_fp_type<TF>(), neighbour_2, 2, md.commxy, &reqs[2]);
+    MPI_Irecv(recv_buffer_2.data(), nbatch, mpi_fp_type<TF>(), neighbour_1, 2, md.commxy, &reqs[3]);
+    master.add_comm(Comm_site::Halo, 2.*nbatch*sizeof(TF), 2);
+    master.wait_all(4, reqs, Comm_site::Halo);
+
+    copy_block<TF, false>(recv_buffer_1.data(), batch_fields, i_in_1, ni, j_in_1, nj, gd.kcells, jj, kk);
+    copy_block<TF, false>(recv_buffer_2.data(), batch_fields, i_in_2, ni, j_in_2, nj, gd.kcells, jj, kk);
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::finish_exchange()
+{
+    if (pending_fields.empty())
+        return;
+
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int ncount = 1;
+
+    // The batches hold the fields with the same halo widths, which are in practice all fields.
+    auto get_batch = [&](const std::pair<int, int>& halo)
+    {
+        std::vector<TF*> batch_fields;
+        for (size_t n=0; n<pending_fields.size(); ++n)
+            if (pending_halos[n] == halo)
+                batch_fields.push_back(pending_fields[n]);
+        return batch_fields;
+    };
+
+    std::vector<std::pair<int, int>> halos;
+    for (auto& halo : pending_halos)
+        if (std::find(halos.begin(), halos.end(), halo) == halos.end())
+            halos.push_back(halo);
+
+    // Complete the east-west edges.
+    if (sw_batch)
+        for (auto& halo : halos)
+        {
+            const int ihalo = halo.first;
+            exchange_batch(
+                    get_batch(halo),
+                    gd.iend-ihalo, gd.istart, gd.istart-ihalo, gd.iend, ihalo,
+                    0, 0, 0, 0, gd.jcells,
+                    md.neast, md.nwest);
+        }
+    else
+    {
+        master.wait_all(pending_reqs.size(), pending_reqs.data(), Comm_site::Halo);
+        pending_reqs.clear();
+    }
+
+    // If the run is 3D, exchange the north-south edges of all pending fields at once.
+    if (gd.jtot > 1)
+    {
+        if (sw_batch)
+            for (auto& halo : halos)
+            {
+                const int jhalo = halo.second;
+                exchange_batch(
+                        get_batch(halo),
+                        0, 0, 0, 0, gd.icells,
+                        gd.jend-jhalo, gd.jstart, gd.jstart-jhalo, gd.jend, jhalo,
+                        md.nnorth, md.nsouth);
+            }
+        else
+        {
+            pending_reqs.resize(4*pending_fields.size());
+
+            for (size_t n=0; n<pending_fields.size(); ++n)
+            {
+                TF* const data = pending_fields[n];
+                const int tag = 2*n + 1;
+
+                const int jhalo = pending_halos[n].second;
+                const MPI_Datatype northsouthhalo = get_northsouth_type(jhalo);
+
+                const int northout = (gd.jend-jhalo)*gd.icells;
+                const int southin  = (gd.jstart-jhalo)*gd.icells;
+                const int southout = gd.jstart*gd.icells;
+                const int northin  = gd.jend  *gd.icells;
+
+                MPI_Isend(&data[northout], ncount, northsouthhalo, md.nnorth, tag  , md.commxy, &pending_reqs[4*n  ]);
+                MPI_Irecv(&data[ southin], ncount, northsouthhalo, md.nsouth, tag  , md.commxy, &pending_reqs[4*n+1]);
+                MPI_Isend(&data[southout], ncount, northsouthhalo, md.nsouth, tag+1, md.commxy, &pending_reqs[4*n+2]);
+                MPI_Irecv(&data[ northin], ncount, northsouthhalo, md.nnorth, tag+1, md.commxy, &pending_reqs[4*n+3]);
+                master.add_comm(Comm_site::Halo, northsouthhalo, 2);
+            }
+
+            master.wait_all(pending_reqs.size(), pending_reqs.data(), Comm_site::Halo);
+            pending_reqs.clear();
+        }
+    }
+    // In case of 2D, fill all the ghost cells in the y-direction with the same value.
+    else
+    {
+        const int jj = gd.icells;
+        const int kk = gd.icells*gd.jcells;
+
+        for (TF* const data : pending_fields)
+            for (int k=gd.kstart; k<gd.kend; ++k)
+                for (int j=0; j<gd.jgc; ++j)
+                    #pragma ivdep
+                    for (int i=0; i<gd.icells; ++i)
+                    {
+                        const int ijkref   = i + gd.jstart*jj   + k*kk;
+                        const int ijknorth = i + j*jj           + k*kk;
+                        const int ijksouth = i + (gd.jend+j)*jj + k*kk;
+                        data[ijknorth] = data[ijkref];
+                        data[ijksouth] = data[ijkref];
+                    }
+    }
+
+    pending_fields.clear();
+    pending_halos.clear();
+}
+
 #else
 
 template<typename TF>
@@ -442,6 +725,56 @@ void Boundary_cyclic<TF>::exec(TF* restrict data, Edge edge)
     }
 }
 
+template<typename TF>
+void Boundary_cyclic<TF>::begin_exchange(TF* data, int ihalo, int jhalo)
+{
+    // Without MPI there is nothing to overlap, so the ghost cells are set directly.
+    auto& gd = grid.get_grid_data();
+
+    // The 2D runs copy the interior to all ghost cells in the y-direction.
+    const bool full_halo = (ihalo == -1 || ihalo == gd.igc) && (jhalo == -1 || jhalo == gd.jgc);
+    if (full_halo || gd.jtot == 1)
+    {
+        exec(data);
+        return;
+    }
+
+    const int jj = gd.icells;
+    const int kk = gd.icells*gd.jcells;
+
+    for (int k=0; k<gd.kcells; ++k)
+        for (int j=0; j<gd.jcells; ++j)
+            #pragma ivdep
+            for (int i=0; i<ihalo; ++i)
+            {
+                const int ijkw  = gd.istart-ihalo+i + j*jj + k*kk;
+                const int ijke  = gd.iend+i         + j*jj + k*kk;
+                data[ijkw] = data[ijkw + gd.imax];
+                data[ijke] = data[ijke - gd.imax];
+            }
+
+    for (int k=0; k<gd.kcells; ++k)
+        for (int j=0; j<jhalo; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.icells; ++i)
+            {
+                const int ijks = i + (gd.jstart-jhalo+j)*jj + k*kk;
+                const int ijkn = i + (gd.jend+j        )*jj + k*kk;
+                data[ijks] = data[ijks + gd.jmax*jj];
+                data[ijkn] = data[ijkn - gd.jmax*jj];
+            }
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::set_batch(const bool)
+{
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::finish_exchange()
+{
+}
+
 template<typename TF>
 void Boundary_cyclic<TF>::exec_2d(TF* restrict data)
 {
@@ -24,6 +24,7 @@
 
 #include "master.h"
 #include "grid.h"
+#include "timeloop.h"
 #include "boundary_outflow.h"
 #include "tools.h"
 
@@ -31,7 +32,7 @@ namespace
 {
     template<typename TF, Edge_location location, Flow_direction direction> __global__
     void compute_inoutflow_2nd_g(
-            TF* const restrict a, const TF* const restrict inflow_prof,
+            TF* const restrict a, const TF* const restrict inflow_prof, const int in_kk, const int in_ii,
             const int istart, const int iend, const int igc,
             const int jstart, const int jend, const int jgc,
             const int icells, const int jcells, const int kcells,
@@ -64,7 +65,7 @@ namespace
                 }
 
                 if (direction == Flow_direction::Inflow)
-                    a[ijk_gc] = a[ijk_d] - (i+1)*TF(2)*(a[ijk_d] - inflow_prof[k]);
+                    a[ijk_gc] = a[ijk_d] - (i+1)*TF(2)*(a[ijk_d] - inflow_prof[k*in_kk + j*in_ii]);
                 else
                     a[ijk_gc] = a[ijk];
             }
@@ -87,13 +88,27 @@ namespace
                 }
 
                 if (direction == Flow_direction::Inflow)
-                    a[ijk_gc] = a[ijk_d] - (j+1)*TF(2)*(a[ijk_d] - inflow_prof[k]);
+                    a[ijk_gc] = a[ijk_d] - (j+1)*TF(2)*(a[ijk_d] - inflow_prof[k*in_kk + i*in_ii]);
                 else
                     a[ijk_gc] = a[ijk];
             }
         }
     }
 
+    template<typename TF> __global__
+    void interp_slab_time_g(
+            TF* const restrict now,
+            const TF* const restrict prev,
+            const TF* const restrict next,
+            const TF fac0, const TF fac1,
+            const int n)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x;
+
+        if (i < n)
+            now[i] = fac0*prev[i] + fac1*next[i];
+    }
+
     template<typename TF> __global__
     void compute_outflow_4th(
             TF* const restrict a,
@@ -143,10 +158,83 @@ namespace
 }
 
 #ifdef USECUDA
+template<typename TF>
+void Boundary_outflow<TF>::prepare_device()
+{
+    for (auto& scalar : lbc_slabs)
+        for (auto& it : scalar.second)
+        {
+            Lbc_slab& slab = it.second;
+            const int memsize = slab.now.size()*sizeof(TF);
+
+            cuda_safe_call(cudaMalloc(&slab.prev_g, memsize));
+            cuda_safe_call(cudaMalloc(&slab.next_g, memsize));
+            cuda_safe_call(cudaMalloc(&slab.now_g, memsize));
+
+            cuda_safe_call(cudaMemcpy(slab.prev_g, slab.prev.data(), memsize, cudaMemcpyHostToDevice));
+            cuda_safe_call(cudaMemcpy(slab.next_g, slab.next.data(), memsize, cudaMemcpyHostToDevice));
+            cuda_safe_call(cudaMemcpy(slab.now_g, slab.now.data(), memsize, cudaMemcpyHostToDevice));
+        }
+}
+
+template<typename TF>
+void Boundary_outflow<TF>::clear_device()
+{
+    for (auto& scalar : lbc_slabs)
+        for (auto& it : scalar.second)
+        {
+            cuda_safe_call(cudaFree(it.second.prev_g));
+            cuda_safe_call(cudaFree(it.second.next_g));
+            cuda_safe_call(cudaFree(it.second.now_g));
+        }
+}
+
+template<typename TF>
+void Boundary_outflow<TF>::update_time_dependent(Timeloop<TF>& timeloop)
+{
+    if (!swtimedep_lbc)
+        return;
+
+    const unsigned long itime = timeloop.get_itime();
+
+    // Only a new time level is copied to the device, the interpolation runs on the device.
+    if (advance_slabs(itime))
+    {
+        for (auto& scalar : lbc_slabs)
+            for (auto& it : scalar.second)
+            {
+                Lbc_slab& slab = it.second;
+                const int memsize = slab.now.size()*sizeof(TF);
+
+                cuda_safe_call(cudaMemcpy(slab.prev_g, slab.prev.data(), memsize, cudaMemcpyHostToDevice));
+                cuda_safe_call(cudaMemcpy(slab.next_g, slab.next.data(), memsize, cudaMemcpyHostToDevice));
+            }
+    }
+
+    const TF fac1 = TF(itime - itime_lbc_prev) / TF(itime_lbc_next - itime_lbc_prev);
+    const TF fac0 = TF(1) - fac1;
+
+    for (auto& scalar : lbc_slabs)
+        for (auto& it : scalar.second)
+        {
+            Lbc_slab& slab = it.second;
+            const int n = slab.now.size();
+
+            const int blocki = 256;
+            const int gridi = n/blocki + (n%blocki > 0);
+
+            interp_slab_time_g<TF><<<gridi, blocki>>>(
+                    slab.now_g, slab.prev_g, slab.next_g, fac0, fac1, n);
+        }
+
+    cuda_check_error();
+}
+
 template<typename TF>
 void Boundary_outflow<TF>::exec(
     TF* const restrict data,
-    const TF* const restrict inflow_prof)
+    const TF* const restrict inflow_prof,
+    const std::string& name)
 {
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
@@ -209,17 +297,18 @@ void Boundary_outflow<TF>::exec(
         if (md.mpicoordx == 0)
         {
             const Edge_location edge = Edge_location::West;
+            const Inflow_values inflow = get_inflow(name, edge, inflow_prof);
 
             if (flow_direction[edge] == Flow_direction::Inflow)
                 compute_inoutflow_2nd_g<TF, edge, Flow_direction::Inflow><<<gridGPU_x, blockGPU_x>>>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
                         gd.ijcells);
             else
                 compute_inoutflow_2nd_g<TF, edge, Flow_direction::Outflow><<<gridGPU_x, blockGPU_x>>>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
@@ -229,17 +318,18 @@ void Boundary_outflow<TF>::exec(
         if (md.mpicoordx == md.npx-1)
         {
             const Edge_location edge = Edge_location::East;
+            const Inflow_values inflow = get_inflow(name, edge, inflow_prof);
 
             if (flow_direction[edge] == Flow_direction::Inflow)
                 compute_inoutflow_2nd_g<TF, edge, Flow_direction::Inflow><<<gridGPU_x, blockGPU_x>>>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
                         gd.ijcells);
             else
                 compute_inoutflow_2nd_g<TF, edge, Flow_direction::Outflow><<<gridGPU_x, blockGPU_x>>>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
@@ -249,17 +339,18 @@ void Boundary_outflow<TF>::exec(
         if (md.mpicoordy == 0)
         {
             const Edge_location edge = Edge_location::South;
+            const Inflow_values inflow = get_inflow(name, edge, inflow_prof);
 
             if (flow_direction[edge] == Flow_direction::Inflow)
                 compute_inoutflow_2nd_g<TF, edge, Flow_direction::Inflow><<<gridGPU_y, blockGPU_y>>>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
                         gd.ijcells);
             else
                 compute_inoutflow_2nd_g<TF, edge, Flow_direction::Outflow><<<gridGPU_y, blockGPU_y>>>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
@@ -269,17 +360,18 @@ void Boundary_outflow<TF>::exec(
         if (md.mpicoordy == md.npy-1)
         {
             const Edge_location edge = Edge_location::North;
+            const Inflow_values inflow = get_inflow(name, edge, inflow_prof);
 
             if (flow_direction[edge] == Flow_direction::Inflow)
                 compute_inoutflow_2nd_g<TF, edge, Flow_direction::Inflow><<<gridGPU_y, blockGPU_y>>>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
                         gd.ijcells);
             else
                 compute_inoutflow_2nd_g<TF, edge, Flow_direction::Outflow><<<gridGPU_y, blockGPU_y>>>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
@@ -27,6 +27,18 @@
 
 namespace
 {
+    const char* get_edge_name(const Edge_location edge)
+    {
+        if (edge == Edge_location::West)
+            return "west";
+        else if (edge == Edge_location::East)
+            return "east";
+        else if (edge == Edge_location::South)
+            return "south";
+        else
+            return "north";
+    }
+
     template<typename TF, Edge_location location>
     void set_neumann(
             TF* const restrict a,
@@ -84,7 +96,7 @@ namespace
 
     template<typename TF, Edge_location location, Flow_direction direction>
     void compute_inoutflow_2nd(
-            TF* const restrict a, const TF* const restrict inflow_prof,
+            TF* const restrict a, const TF* const restrict inflow_prof, const int in_kk, const int in_ii,
             const int istart, const int iend, const int igc,
             const int jstart, const int jend, const int jgc,
             const int icells, const int jcells, const int kcells,
@@ -116,7 +128,7 @@ namespace
                         }
 
                         if (direction == Flow_direction::Inflow)
-                            a[ijk_gc] = a[ijk_d] - (i+1)*TF(2)*(a[ijk_d] - inflow_prof[k]);
+                            a[ijk_gc] = a[ijk_d] - (i+1)*TF(2)*(a[ijk_d] - inflow_prof[k*in_kk + j*in_ii]);
                         else
                             a[ijk_gc] = a[ijk];
                     }
@@ -141,7 +153,7 @@ namespace
                         }
 
                         if (direction == Flow_direction::Inflow)
-                            a[ijk_gc] = a[ijk_d] - (j+1)*TF(2)*(a[ijk_d] - inflow_prof[k]);
+                            a[ijk_gc] = a[ijk_d] - (j+1)*TF(2)*(a[ijk_d] - inflow_prof[k*in_kk + i*in_ii]);
                         else
                             a[ijk_gc] = a[ijk];
                     }
@@ -224,6 +236,18 @@ Boundary_outflow<TF>::Boundary_outflow(Master& masterin, Grid<TF>& gridin, Input
         process_lbc("south", Edge_location::South);
         process_lbc("west",  Edge_location::West);
     }
+
+    swtimedep_lbc = inputin.get_item<bool>("boundary", "swtimedep_lbc", "", false);
+    if (swtimedep_lbc)
+    {
+        if (outflow_list.empty())
+            throw std::runtime_error("swtimedep_lbc requires scalar_outflow");
+
+        const double lbc_loadtime = inputin.get_item<double>("boundary", "lbc_loadtime", "");
+        iloadtime_lbc = convert_to_itime(lbc_loadtime);
+    }
+    else
+        inputin.flag_as_used("boundary", "lbc_loadtime", "");
 }
 
 template<typename TF>
@@ -231,11 +255,222 @@ Boundary_outflow<TF>::~Boundary_outflow()
 {
 }
 
+template<typename TF>
+bool Boundary_outflow<TF>::is_local_edge(const Edge_location edge) const
+{
+    auto& md = master.get_MPI_data();
+
+    if (edge == Edge_location::West)
+        return md.mpicoordx == 0;
+    else if (edge == Edge_location::East)
+        return md.mpicoordx == md.npx-1;
+    else if (edge == Edge_location::South)
+        return md.mpicoordy == 0;
+    else
+        return md.mpicoordy == md.npy-1;
+}
+
+template<typename TF>
+int Boundary_outflow<TF>::get_edge_cells(const Edge_location edge) const
+{
+    auto& gd = grid.get_grid_data();
+    return (edge == Edge_location::West || edge == Edge_location::East) ? gd.jcells : gd.icells;
+}
+
+template<typename TF>
+int Boundary_outflow<TF>::load_slab(
+        std::vector<TF>& slab, const std::string& name, const Edge_location edge, const unsigned long itime) const
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const bool along_y = (edge == Edge_location::West || edge == Edge_location::East);
+    const int ntot   = along_y ? gd.jtot : gd.itot;
+    const int nmax   = along_y ? gd.jmax : gd.imax;
+    const int ngc    = along_y ? gd.jgc : gd.igc;
+    const int ncells = along_y ? gd.jcells : gd.icells;
+    const int offset = along_y ? md.mpicoordy*gd.jmax : md.mpicoordx*gd.imax;
+
+    char filename[256];
+    std::snprintf(filename, 256, "%s_lbc_%s.%07d", name.c_str(), get_edge_name(edge), int(itime / iiotimeprec));
+
+    std::FILE* pFile = std::fopen(filename, "rb");
+    if (pFile == nullptr)
+        return 1;
+
+    // Only the part of the edge of this process is read, including the ghost cells that are
+    // inside the domain. The ghost cells outside the domain take the nearest value.
+    const int nstart = std::max(offset-ngc, 0);
+    const int nend = std::min(offset+nmax+ngc, ntot);
+
+    int nerror = 0;
+    for (int k=0; k<gd.ktot; ++k)
+    {
+        TF* const row = &slab[(k+gd.kstart)*ncells];
+        const long position = (static_cast<long>(k)*ntot + nstart) * sizeof(TF);
+
+        if (std::fseek(pFile, position, SEEK_SET) != 0
+                || std::fread(row + ngc + nstart-offset, sizeof(TF), nend-nstart, pFile) != static_cast<size_t>(nend-nstart))
+        {
+            nerror = 1;
+            break;
+        }
+
+        for (int n=0; n<ngc+nstart-offset; ++n)
+            row[n] = row[ngc+nstart-offset];
+        for (int n=ngc+nend-offset; n<ncells; ++n)
+            row[n] = row[ngc+nend-offset-1];
+    }
+
+    std::fclose(pFile);
+
+    for (int k=0; k<gd.kstart; ++k)
+        std::copy(&slab[gd.kstart*ncells], &slab[(gd.kstart+1)*ncells], &slab[k*ncells]);
+    for (int k=gd.kend; k<gd.kcells; ++k)
+        std::copy(&slab[(gd.kend-1)*ncells], &slab[gd.kend*ncells], &slab[k*ncells]);
+
+    return nerror;
+}
+
+template<typename TF>
+void Boundary_outflow<TF>::start_prefetch(
+        Lbc_slab& slab, const std::string& name, const Edge_location edge, const unsigned long itime)
+{
+    // The reads do not communicate, such that they can run in a thread next to the time loop.
+    slab.prefetch = std::async(
+            std::launch::async,
+            [this, &slab, name, edge, itime]() { return load_slab(slab.prefetched, name, edge, itime); });
+}
+
+template<typename TF>
+void Boundary_outflow<TF>::create(const std::vector<std::string>& scalars, Timeloop<TF>& timeloop)
+{
+    if (!swtimedep_lbc)
+        return;
+
+    if (grid.get_spatial_order() != Grid_order::Second)
+        throw std::runtime_error("swtimedep_lbc requires the second order scheme");
+
+    auto& gd = grid.get_grid_data();
+
+    const unsigned long itime = timeloop.get_itime();
+    iiotimeprec = timeloop.get_iiotimeprec();
+
+    itime_lbc_prev = itime / iloadtime_lbc * iloadtime_lbc;
+    itime_lbc_next = itime_lbc_prev + iloadtime_lbc;
+
+    master.print_message("Loading lateral boundary slabs for time %d and %d\n",
+            int(itime_lbc_prev / iiotimeprec), int(itime_lbc_next / iiotimeprec));
+
+    int nerror = 0;
+
+    for (auto& name : scalars)
+        for (auto& it : flow_direction)
+        {
+            const Edge_location edge = it.first;
+            if (it.second != Flow_direction::Inflow || !is_local_edge(edge))
+                continue;
+
+            Lbc_slab& slab = lbc_slabs[name][edge];
+            const int nslab = gd.kcells*get_edge_cells(edge);
+
+            slab.prev.resize(nslab);
+            slab.next.resize(nslab);
+            slab.prefetched.resize(nslab);
+
+            nerror += load_slab(slab.prev, name, edge, itime_lbc_prev);
+            nerror += load_slab(slab.next, name, edge, itime_lbc_next);
+            slab.now = slab.prev;
+
+            start_prefetch(slab, name, edge, itime_lbc_next + iloadtime_lbc);
+        }
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        throw std::runtime_error("Error loading the lateral boundary slabs");
+}
+
+template<typename TF>
+bool Boundary_outflow<TF>::advance_slabs(const unsigned long itime)
+{
+    if (itime <= itime_lbc_next)
+        return false;
+
+    // Jumps over more than one interval are completed one interval at a time.
+    while (itime > itime_lbc_next)
+    {
+        itime_lbc_prev = itime_lbc_next;
+        itime_lbc_next = itime_lbc_prev + iloadtime_lbc;
+
+        int nerror = 0;
+
+        for (auto& scalar : lbc_slabs)
+            for (auto& it : scalar.second)
+            {
+                Lbc_slab& slab = it.second;
+
+                slab.prev.swap(slab.next);
+                nerror += slab.prefetch.get();
+                slab.next.swap(slab.prefetched);
+
+                start_prefetch(slab, scalar.first, it.first, itime_lbc_next + iloadtime_lbc);
+            }
+
+        master.sum(&nerror, 1);
+        if (nerror)
+            throw std::runtime_error(
+                    "Error loading the lateral boundary slabs of time " + std::to_string(itime_lbc_next / iiotimeprec));
+    }
+
+    return true;
+}
+
+template<typename TF>
+typename Boundary_outflow<TF>::Inflow_values Boundary_outflow<TF>::get_inflow(
+        const std::string& name, const Edge_location edge, const TF* const inflow_prof)
+{
+    auto it = lbc_slabs.find(name);
+    if (it != lbc_slabs.end() && it->second.count(edge) > 0)
+    {
+        #ifdef USECUDA
+        return {it->second.at(edge).now_g, get_edge_cells(edge), 1};
+        #else
+        return {it->second.at(edge).now.data(), get_edge_cells(edge), 1};
+        #endif
+    }
+
+    return {inflow_prof, 1, 0};
+}
+
+#ifndef USECUDA
+template<typename TF>
+void Boundary_outflow<TF>::update_time_dependent(Timeloop<TF>& timeloop)
+{
+    if (!swtimedep_lbc)
+        return;
+
+    const unsigned long itime = timeloop.get_itime();
+    advance_slabs(itime);
+
+    const TF fac1 = TF(itime - itime_lbc_prev) / TF(itime_lbc_next - itime_lbc_prev);
+    const TF fac0 = TF(1) - fac1;
+
+    for (auto& scalar : lbc_slabs)
+        for (auto& it : scalar.second)
+        {
+            Lbc_slab& slab = it.second;
+            for (size_t n=0; n<slab.now.size(); ++n)
+                slab.now[n] = fac0*slab.prev[n] + fac1*slab.next[n];
+        }
+}
+#endif
+
 #ifndef USECUDA
 template<typename TF>
 void Boundary_outflow<TF>::exec(
         TF* const restrict data,
-        const TF* const restrict inflow_prof)
+        const TF* const restrict inflow_prof,
+        const std::string& name)
 {
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
@@ -263,17 +498,18 @@ void Boundary_outflow<TF>::exec(
         if (md.mpicoordx == 0)
         {
             const Edge_location edge = Edge_location::West;
+            const Inflow_values inflow = get_inflow(name, edge, inflow_prof);
 
             if (flow_direction[edge] == Flow_direction::Inflow)
                 compute_inoutflow_2nd<TF, edge, Flow_direction::Inflow>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
                         gd.ijcells);
             else
                 compute_inoutflow_2nd<TF, edge, Flow_direction::Outflow>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
@@ -283,17 +519,18 @@ void Boundary_outflow<TF>::exec(
         if (md.mpicoordx == md.npx-1)
         {
             const Edge_location edge = Edge_location::East;
+            const Inflow_values inflow = get_inflow(name, edge, inflow_prof);
 
             if (flow_direction[edge] == Flow_direction::Inflow)
                 compute_inoutflow_2nd<TF, edge, Flow_direction::Inflow>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
                         gd.ijcells);
             else
                 compute_inoutflow_2nd<TF, edge, Flow_direction::Outflow>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
@@ -303,17 +540,18 @@ void Boundary_outflow<TF>::exec(
         if (md.mpicoordy == 0)
         {
             const Edge_location edge = Edge_location::South;
+            const Inflow_values inflow = get_inflow(name, edge, inflow_prof);
 
             if (flow_direction[edge] == Flow_direction::Inflow)
                 compute_inoutflow_2nd<TF, edge, Flow_direction::Inflow>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
                         gd.ijcells);
             else
                 compute_inoutflow_2nd<TF, edge, Flow_direction::Outflow>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
@@ -323,17 +561,18 @@ void Boundary_outflow<TF>::exec(
         if (md.mpicoordy == md.npy-1)
         {
             const Edge_location edge = Edge_location::North;
+            const Inflow_values inflow = get_inflow(name, edge, inflow_prof);
 
             if (flow_direction[edge] == Flow_direction::Inflow)
                 compute_inoutflow_2nd<TF, edge, Flow_direction::Inflow>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
                         gd.ijcells);
             else
                 compute_inoutflow_2nd<TF, edge, Flow_direction::Outflow>(
-                        data, inflow_prof,
+                        data, inflow.data, inflow.kk, inflow.ii,
                         gd.istart, gd.iend, gd.igc,
                         gd.jstart, gd.jend, gd.kgc,
                         gd.icells, gd.jcells, gd.kcells,
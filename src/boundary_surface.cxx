@@ -93,6 +93,7 @@ namespace
         // Case 2: fixed buoyancy surface value and free ustar
         else if (mbcbot == Boundary_type::Dirichlet_type && thermobc == Boundary_type::Flux_type)
         {
+            #pragma omp parallel for
             for (int j=0; j<jcells; ++j)
                 #pragma ivdep
                 for (int i=0; i<icells; ++i)
@@ -112,6 +113,7 @@ namespace
         }
         else if (mbcbot == Boundary_type::Dirichlet_type && thermobc == Boundary_type::Dirichlet_type)
         {
+            #pragma omp parallel for
             for (int j=0; j<jcells; ++j)
                 #pragma ivdep
                 for (int i=0; i<icells; ++i)
@@ -398,7 +400,7 @@ void Boundary_surface<TF>::create(
 {
     const std::string group_name = "default";
     Boundary<TF>::process_time_dependent(input, input_nc, timeloop);
-    Boundary<TF>::process_inflow(input, input_nc);
+    Boundary<TF>::process_inflow(input, input_nc, timeloop);
 
     // add variables to the statistics
     if (stats.get_switch())
@@ -691,6 +693,17 @@ void Boundary_surface<TF>::save(const int iotime, Thermo<TF>& thermo)
     fields.release_tmp(tmp1);
 }
 
+template<typename TF>
+void Boundary_surface<TF>::get_checkpoint_data(std::vector<std::vector<TF>*>& state)
+{
+    // The same 2D fields as in the restart files.
+    state.insert(state.end(), {&dudz_mo, &dvdz_mo, &dbdz_mo, &obuk});
+
+    for (auto& it : fields.sp)
+        if (sbc.at(it.first).bcbot == Boundary_type::Flux_type)
+            state.push_back(&it.second->grad_bot);
+}
+
 template<typename TF>
 void Boundary_surface<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
 {
@@ -821,15 +834,19 @@ void Boundary_surface<TF>::init_solver()
 {
     auto& gd = grid.get_grid_data();
 
-    zL_sl.resize(nzL_lut);
-    f_sl.resize(nzL_lut);
+    zL_sl.resize(master, nzL_lut);
+    f_sl.resize(master, nzL_lut);
+
+    if (zL_sl.is_writer())
+        bsk::prepare_lut(
+            zL_sl.data(),
+            f_sl.data(),
+            z0m[0], z0h[0],
+            gd.z[gd.kstart], nzL_lut,
+            mbcbot, thermobc);
 
-    bsk::prepare_lut(
-        zL_sl.data(),
-        f_sl.data(),
-        z0m[0], z0h[0],
-        gd.z[gd.kstart], nzL_lut,
-        mbcbot, thermobc);
+    zL_sl.sync();
+    f_sl.sync();
 }
 
 #ifndef USECUDA
@@ -129,7 +129,7 @@ void Boundary_surface_bulk<TF>::create(
     const std::string group_name = "default";
 
     Boundary<TF>::process_time_dependent(input, input_nc, timeloop);
-    Boundary<TF>::process_inflow(input, input_nc);
+    Boundary<TF>::process_inflow(input, input_nc, timeloop);
 
     // add variables to the statistics
     if (stats.get_switch())
@@ -298,6 +298,12 @@ void Boundary_surface_bulk<TF>::save(const int iotime, Thermo<TF>& thermo)
     fields.release_tmp(tmp1);
 }
 
+template<typename TF>
+void Boundary_surface_bulk<TF>::get_checkpoint_data(std::vector<std::vector<TF>*>& state)
+{
+    state.insert(state.end(), {&dudz_mo, &dvdz_mo, &dbdz_mo});
+}
+
 template<typename TF>
 void Boundary_surface_bulk<TF>::exec_stats(Stats<TF>& stats)
 {
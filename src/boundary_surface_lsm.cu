@@ -1083,10 +1083,26 @@ void Boundary_surface_lsm<TF>::backward_device(Thermo<TF>& thermo)
     cuda_safe_call(cudaMemcpy(dvdz_mo.data(), dvdz_mo_g, tf_memsize_ij, cudaMemcpyDeviceToHost));
     cuda_safe_call(cudaMemcpy(dbdz_mo.data(), dbdz_mo_g, tf_memsize_ij, cudaMemcpyDeviceToHost));
 
-    // TODO: which fields are needed from the land-surface?
-    // Nearly all tile fields are used in the statistics:
+    // The tile fields are only needed on the host for the restart files, unless the
+    // statistics per tile are written.
     for (auto& tile : tiles)
-        lsmk::backward_device_tile(tile.second, gd.ijcells);
+    {
+        if (sw_tile_stats)
+            lsmk::backward_device_tile(tile.second, gd.ijcells);
+        else
+            lsmk::backward_device_tile_restart(tile.second, gd.ijcells);
+    }
+
+    // The other statistics and the cross-sections only use the tiled means of the fluxes.
+    auto tmp = fields.get_tmp_g();
+
+    for (auto& it : tiled_mean_stats)
+    {
+        get_tiled_mean_g(tmp->fld_bot_g, it.first, TF(1));
+        cuda_safe_call(cudaMemcpy(it.second.data(), tmp->fld_bot_g, tf_memsize_ij, cudaMemcpyDeviceToHost));
+    }
+
+    fields.release_tmp_g(tmp);
 }
 
 template<typename TF>
@@ -48,6 +48,7 @@
 #include "netcdf_interface.h"
 #include "radiation.h"
 #include "microphys.h"
+#include "timeloop.h"
 
 #include "boundary_surface_kernels.h"
 #include "land_surface_kernels.h"
@@ -65,6 +66,25 @@ namespace
 
 namespace
 {
+    template<typename TF>
+    void add_soil_tendency(
+            TF* const restrict tend,
+            const TF* const restrict tend_soil,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*icells + k*ijcells;
+                    tend[ijk] += tend_soil[ijk];
+                }
+    }
+
     template<typename TF>
     void calc_tiled_mean(
             TF* const restrict fld,
@@ -269,6 +289,9 @@ Boundary_surface_lsm<TF>::Boundary_surface_lsm(
     sw_tile_stats     = inputin.get_item<bool>("land_surface", "swtilestats", "", false);
     sw_tile_stats_col = inputin.get_item<bool>("land_surface", "swtilestats_column", "", false);
 
+    // Interval of the soil diffusion updates, 0 updates the soil every (sub)step.
+    dt_soil = inputin.get_item<double>("land_surface", "dt_soil", "", 0.);
+
     // BvS: for now, read surface emission from radiation group. This needs
     // to be coupled correctly, also for 2D varying emissivities.
     emis_sfc = inputin.get_item<TF>("radiation", "emis_sfc", "");
@@ -290,6 +313,14 @@ Boundary_surface_lsm<TF>::Boundary_surface_lsm(
     if (sw_homogeneous && sw_water)
         throw std::runtime_error("Homogeneous land-surface with water is not supported!\n");
 
+    if (dt_soil < 0.)
+        throw std::runtime_error("dt_soil cannot be negative");
+
+    #ifdef USECUDA
+    if (dt_soil > 0.)
+        throw std::runtime_error("dt_soil > 0 is not (yet) implemented on the GPU");
+    #endif
+
     //#ifdef USECUDA
     //ustar_g = 0;
     //obuk_g  = 0;
@@ -739,6 +770,62 @@ void Boundary_surface_lsm<TF>::exec(
     //
     // Calculate soil tendencies
     //
+    // With dt_soil > 0, the soil tendencies are only recalculated at the first substep
+    // once every dt_soil, and the stored tendencies are added in between.
+    if (idt_soil > 0)
+    {
+        const unsigned long soil_period = timeloop.get_itime() / idt_soil;
+
+        if (timeloop.get_substep() == 0 && (!soil_tend_valid || soil_period != soil_period_last))
+        {
+            std::fill(soil_t_tend.begin(), soil_t_tend.end(), TF(0));
+            std::fill(soil_theta_tend.begin(), soil_theta_tend.end(), TF(0));
+
+            exec_soil(soil_t_tend.data(), soil_theta_tend.data());
+
+            soil_period_last = soil_period;
+            soil_tend_valid = true;
+        }
+
+        add_soil_tendency(
+                fields.sts.at("t")->fld.data(), soil_t_tend.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, sgd.kstart, sgd.kend,
+                gd.icells, gd.ijcells);
+
+        add_soil_tendency(
+                fields.sts.at("theta")->fld.data(), soil_theta_tend.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, sgd.kstart, sgd.kend,
+                gd.icells, gd.ijcells);
+    }
+    else
+        exec_soil(fields.sts.at("t")->fld.data(), fields.sts.at("theta")->fld.data());
+
+    fields.release_tmp_xy(dutot);
+
+    fields.release_tmp_xy(T_bot);
+    fields.release_tmp_xy(T_a);
+    fields.release_tmp_xy(vpd);
+    fields.release_tmp_xy(qsat_bot);
+    fields.release_tmp_xy(dqsatdT_bot);
+
+    fields.release_tmp(buoy);
+    fields.release_tmp_xy(b_bot);
+
+    fields.release_tmp_xy(rain_rate);
+
+    fields.release_tmp_xy(f1);
+    fields.release_tmp_xy(f2);
+    fields.release_tmp_xy(f2b);
+    fields.release_tmp_xy(f3);
+    fields.release_tmp_xy(theta_mean_n);
+}
+
+template<typename TF>
+void Boundary_surface_lsm<TF>::exec_soil(TF* const t_tend, TF* const theta_tend)
+{
+    auto& gd = grid.get_grid_data();
+    auto& sgd = soil_grid.get_grid_data();
+
     auto tmp1 = fields.get_tmp();
 
     // Only soil moisture has a source and conductivity term
@@ -791,7 +878,7 @@ void Boundary_surface_lsm<TF>::exec(
 
     // Calculate diffusive tendency
     sk::diff_explicit<TF, sw_source_term_t, sw_conductivity_term_t>(
-            fields.sts.at("t")->fld.data(),
+            t_tend,
             fields.sps.at("t")->fld.data(),
             diffusivity_h.data(),
             conductivity_h.data(),
@@ -904,7 +991,7 @@ void Boundary_surface_lsm<TF>::exec(
 
     // Calculate diffusive tendency
     sk::diff_explicit<TF, sw_source_term_theta, sw_conductivity_term_theta>(
-            fields.sts.at("theta")->fld.data(),
+            theta_tend,
             fields.sps.at("theta")->fld.data(),
             diffusivity_h.data(),
             conductivity_h.data(),
@@ -918,25 +1005,6 @@ void Boundary_surface_lsm<TF>::exec(
             gd.icells, gd.ijcells);
 
     fields.release_tmp(tmp1);
-
-    fields.release_tmp_xy(dutot);
-
-    fields.release_tmp_xy(T_bot);
-    fields.release_tmp_xy(T_a);
-    fields.release_tmp_xy(vpd);
-    fields.release_tmp_xy(qsat_bot);
-    fields.release_tmp_xy(dqsatdT_bot);
-
-    fields.release_tmp(buoy);
-    fields.release_tmp_xy(b_bot);
-
-    fields.release_tmp_xy(rain_rate);
-
-    fields.release_tmp_xy(f1);
-    fields.release_tmp_xy(f2);
-    fields.release_tmp_xy(f2b);
-    fields.release_tmp_xy(f3);
-    fields.release_tmp_xy(theta_mean_n);
 }
 #endif
 
@@ -1033,6 +1101,11 @@ void Boundary_surface_lsm<TF>::init_land_surface()
     for (auto& tile : tiles)
         lsmk::init_tile(tile.second, gd.ijcells);
 
+    #ifdef USECUDA
+    for (auto& name : {"H", "LE", "G", "S"})
+        tiled_mean_stats.emplace(name, std::vector<TF>(gd.ijcells));
+    #endif
+
     tiles.at("veg" ).long_name = "vegetation";
     tiles.at("soil").long_name = "bare soil";
     tiles.at("wet" ).long_name = "wet skin";
@@ -1066,6 +1139,13 @@ void Boundary_surface_lsm<TF>::init_land_surface()
     source.resize(sgd.ncells);
     root_fraction.resize(sgd.ncells);
 
+    idt_soil = convert_to_itime(dt_soil);
+    if (idt_soil > 0)
+    {
+        soil_t_tend.resize(sgd.ncells);
+        soil_theta_tend.resize(sgd.ncells);
+    }
+
     // Resize the lookup table with van Genuchten parameters
     const int size = nc_lookup_table->get_dimension_size("index");
 
@@ -1174,7 +1254,11 @@ void Boundary_surface_lsm<TF>::create(
     auto& sgd = soil_grid.get_grid_data();
 
     Boundary<TF>::process_time_dependent(input, input_nc, timeloop);
-    Boundary<TF>::process_inflow(input, input_nc);
+    Boundary<TF>::process_inflow(input, input_nc, timeloop);
+
+    // A restart has to start at a soil update, otherwise the reused tendencies are lost.
+    if (idt_soil > 0 && timeloop.get_isavetime() % idt_soil != 0)
+        throw std::runtime_error("Restart \"savetime\" is not an (integer) multiple of \"dt_soil\"");
 
     // Setup statiscics, cross-sections and column statistics
     create_stats(stats, column, cross);
@@ -1554,6 +1638,16 @@ void Boundary_surface_lsm<TF>::save(const int iotime, Thermo<TF>& thermo)
     fields.release_tmp(tmp2);
 }
 
+template<typename TF>
+void Boundary_surface_lsm<TF>::get_checkpoint_data(std::vector<std::vector<TF>*>& state)
+{
+    // The soil fields and the liquid water reservoir are prognostic fields, which are already included.
+    state.insert(state.end(), {&dudz_mo, &dvdz_mo, &dbdz_mo});
+
+    for (auto& tile : tiles)
+        state.insert(state.end(), {&tile.second.thl_bot, &tile.second.qt_bot, &tile.second.obuk});
+}
+
 template<typename TF>
 void Boundary_surface_lsm<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
 {
@@ -1572,7 +1666,7 @@ void Boundary_surface_lsm<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime
             cross.cross_plane(fields.ap2d.at("wl")->fld.data(), no_offset, var, iotime);
         else if (var == "H" || var == "LE" || var == "G" || var == "S")
         {
-            get_tiled_mean(tmp->fld_bot, var, TF(1));
+            get_tiled_mean_stats(tmp->fld_bot, var);
             cross.cross_plane(tmp->fld_bot.data(), no_offset, var, iotime);
         }
     }
@@ -1594,16 +1688,16 @@ void Boundary_surface_lsm<TF>::exec_stats(Stats<TF>& stats)
     // Land-surface
     stats.calc_stats_2d("wl", fields.ap2d.at("wl")->fld, no_offset);
 
-    get_tiled_mean(*fld_mean, "H", TF(1));
+    get_tiled_mean_stats(*fld_mean, "H");
     stats.calc_stats_2d("H", *fld_mean, no_offset);
 
-    get_tiled_mean(*fld_mean, "LE", TF(1));
+    get_tiled_mean_stats(*fld_mean, "LE");
     stats.calc_stats_2d("LE", *fld_mean, no_offset);
 
-    get_tiled_mean(*fld_mean, "G", TF(1));
+    get_tiled_mean_stats(*fld_mean, "G");
     stats.calc_stats_2d("G", *fld_mean, no_offset);
 
-    get_tiled_mean(*fld_mean, "S", TF(1));
+    get_tiled_mean_stats(*fld_mean, "S");
     stats.calc_stats_2d("S", *fld_mean, no_offset);
 
     // Soil
@@ -1717,15 +1811,19 @@ void Boundary_surface_lsm<TF>::init_solver()
 {
     auto& gd = grid.get_grid_data();
 
-    zL_sl.resize(nzL_lut);
-    f_sl.resize(nzL_lut);
+    zL_sl.resize(master, nzL_lut);
+    f_sl.resize(master, nzL_lut);
 
-    bsk::prepare_lut(
-        zL_sl.data(),
-        f_sl.data(),
-        z0m[0], z0h[0],
-        gd.z[gd.kstart], nzL_lut,
-        mbcbot, thermobc);
+    if (zL_sl.is_writer())
+        bsk::prepare_lut(
+            zL_sl.data(),
+            f_sl.data(),
+            z0m[0], z0h[0],
+            gd.z[gd.kstart], nzL_lut,
+            mbcbot, thermobc);
+
+    zL_sl.sync();
+    f_sl.sync();
 }
 
 template<typename TF>
@@ -1811,6 +1909,17 @@ void Boundary_surface_lsm<TF>::get_tiled_mean(
             gd.icells);
 }
 
+template<typename TF>
+void Boundary_surface_lsm<TF>::get_tiled_mean_stats(std::vector<TF>& fld_out, const std::string& name)
+{
+    #ifdef USECUDA
+    const std::vector<TF>& fld_mean = tiled_mean_stats.at(name);
+    std::copy(fld_mean.begin(), fld_mean.end(), fld_out.begin());
+    #else
+    get_tiled_mean(fld_out, name, TF(1));
+    #endif
+}
+
 
 #ifdef FLOAT_SINGLE
 template class Boundary_surface_lsm<float>;
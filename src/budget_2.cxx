@@ -1364,6 +1364,30 @@ void Budget_2<TF>::exec_stats(Stats<TF>& stats)
 
     auto& masks = stats.get_masks();
 
+    // The fields that do not depend on the mask mean are computed once for all masks.
+    auto wx = fields.get_tmp();
+    auto wy = fields.get_tmp();
+
+    // Interpolate w to the locations of u and v.
+    constexpr int wloc [3] = {0,0,1};
+    constexpr int wxloc[3] = {1,0,1};
+    constexpr int wyloc[3] = {0,1,1};
+
+    grid.interpolate_2nd(wx->fld.data(), fields.mp.at("w")->fld.data(), wloc, wxloc);
+    grid.interpolate_2nd(wy->fld.data(), fields.mp.at("w")->fld.data(), wloc, wyloc);
+
+    std::shared_ptr<Field3d<TF>> b;
+    if (thermo.get_switch() != Thermo_type::Disabled)
+    {
+        // Acquire the buoyancy, cyclic=true, is_stat=true.
+        b = fields.get_tmp();
+        thermo.get_thermo_field(*b, "b", true, true);
+
+        // Calculate the mean of the fields.
+        field3d_operators.calc_mean_profile(b->fld_mean.data(), b->fld.data());
+        field3d_operators.calc_mean_profile(fields.sd.at("p")->fld_mean.data(), fields.sd.at("p")->fld.data());
+    }
+
     // The loop over masks inside of budget is necessary, because the mask mean is 
     // required in order to compute the budget terms.
     for (auto& m : masks)
@@ -1376,17 +1400,6 @@ void Budget_2<TF>::exec_stats(Stats<TF>& stats)
         constexpr TF no_offset = 0.;
         constexpr TF no_threshold = 0.;
 
-        auto wx = fields.get_tmp();
-        auto wy = fields.get_tmp();
-
-        // Interpolate w to the locations of u and v.
-        constexpr int wloc [3] = {0,0,1};
-        constexpr int wxloc[3] = {1,0,1};
-        constexpr int wyloc[3] = {0,1,1};
-
-        grid.interpolate_2nd(wx->fld.data(), fields.mp.at("w")->fld.data(), wloc, wxloc);
-        grid.interpolate_2nd(wy->fld.data(), fields.mp.at("w")->fld.data(), wloc, wyloc);
-
         auto u2_shear = fields.get_tmp();
         auto v2_shear = fields.get_tmp();
         auto tke_shear = fields.get_tmp();
@@ -1541,9 +1554,6 @@ void Budget_2<TF>::exec_stats(Stats<TF>& stats)
             }
         }
 
-        fields.release_tmp(wx);
-        fields.release_tmp(wy);
-
         auto w2_pres = fields.get_tmp();
         auto tke_pres = fields.get_tmp();
         auto uw_pres = fields.get_tmp();
@@ -1624,14 +1634,6 @@ void Budget_2<TF>::exec_stats(Stats<TF>& stats)
             // Get the buoyancy diffusivity from the thermo class
             const TF diff_b = thermo.get_buoyancy_diffusivity();
 
-            // Acquire the buoyancy, cyclic=true, is_stat=true.
-            auto b = fields.get_tmp();
-            thermo.get_thermo_field(*b, "b", true, true);
-
-            // Calculate the mean of the fields.
-            field3d_operators.calc_mean_profile(b->fld_mean.data(), b->fld.data());
-            field3d_operators.calc_mean_profile(fields.sd.at("p")->fld_mean.data(), fields.sd.at("p")->fld.data());
-
             auto w2_buoy = fields.get_tmp();
             auto tke_buoy = fields.get_tmp();
             auto uw_buoy = fields.get_tmp();
@@ -1740,9 +1742,14 @@ void Budget_2<TF>::exec_stats(Stats<TF>& stats)
 
             fields.release_tmp(bw_pres);
             fields.release_tmp(bw_rdstr);
-            fields.release_tmp(b);
         }
     }
+
+    fields.release_tmp(wx);
+    fields.release_tmp(wy);
+
+    if (b)
+        fields.release_tmp(b);
 }
 
 
@@ -2755,6 +2755,36 @@ void Budget_4<TF>::exec_stats(Stats<TF>& stats)
 
     auto& masks = stats.get_masks();
 
+    // The buoyancy, its means and the sorted profile do not depend on the mask,
+    // and are computed once for all masks.
+    std::shared_ptr<Field3d<TF>> b;
+    if (thermo.get_switch() != Thermo_type::Disabled)
+    {
+        b = fields.get_tmp();
+
+        // Compute the buoyancy, cyclic is true, and stat is true.
+        thermo.get_thermo_field(*b, "b", true, true);
+
+        field3d_operators.calc_mean_profile(b->fld_mean.data(), b->fld.data());
+        field3d_operators.calc_mean_profile(fields.sd.at("p")->fld_mean.data(), b->fld.data());
+
+        auto b_sort = fields.get_tmp();
+
+        // Calculate the sorted buoyancy profile.
+        // CvH: This does not work out well with the masking.
+        calc_sorted_prof(
+                b->fld.data(), b_sort->fld.data(), b_sort->fld_mean.data(),
+                gd.z.data(), gd.dz.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells,
+                gd.itot, gd.jtot, gd.nmax,
+                grid.get_spatial_order(), master);
+
+        stats.set_prof("b_sort", b_sort->fld_mean);
+
+        fields.release_tmp(b_sort);
+    }
+
     // The loop over masks inside of budget is necessary, because the mask mean is
     // required in order to compute the budget terms.
     for (auto& m : masks)
@@ -2923,14 +2953,6 @@ void Budget_4<TF>::exec_stats(Stats<TF>& stats)
         // Calculate the buoyancy term of the TKE budget.
         if (thermo.get_switch() != Thermo_type::Disabled)
         {
-            auto b = fields.get_tmp();
-
-            // Compute the buoyancy, cyclic is true, and stat is true.
-            thermo.get_thermo_field(*b, "b", true, true);
-
-            field3d_operators.calc_mean_profile(b->fld_mean.data(), b->fld.data());
-            field3d_operators.calc_mean_profile(fields.sd.at("p")->fld_mean.data(), b->fld.data());
-
             auto w2_buoy  = fields.get_tmp();
             auto tke_buoy = fields.get_tmp();
             auto uw_buoy  = fields.get_tmp();
@@ -3011,27 +3033,14 @@ void Budget_4<TF>::exec_stats(Stats<TF>& stats)
             fields.release_tmp(bw_rdstr);
             fields.release_tmp(bw_diss);
             fields.release_tmp(bw_pres);
-
-            auto b_sort = std::move(bz);
-
-            // Calculate the sorted buoyancy profile.
-            // CvH: This does not work out well with the masking.
-            calc_sorted_prof(
-                    b->fld.data(), b_sort->fld.data(), b_sort->fld_mean.data(),
-                    gd.z.data(), gd.dz.data(),
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells,
-                    gd.itot, gd.jtot, gd.nmax,
-                    grid.get_spatial_order(), master);
-
-            stats.set_prof("b_sort", b_sort->fld_mean);
-
-            fields.release_tmp(b);
-            fields.release_tmp(b_sort);
+            fields.release_tmp(bz);
         }
 
         fields.release_tmp(w_prime);
     }
+
+    if (b)
+        fields.release_tmp(b);
 }
 
 
@@ -161,7 +161,8 @@ void Buffer<TF>::exec(Stats<TF>& stats)
                         sigma_z);
         }
 
-        cudaDeviceSynchronize();
+        if (stats.is_doing_tendency())
+            cudaDeviceSynchronize();
         stats.calc_tend(*fields.mt.at("u"), tend_name);
         stats.calc_tend(*fields.mt.at("v"), tend_name);
         stats.calc_tend(*fields.mt.at("w"), tend_name);
@@ -0,0 +1,324 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "master.h"
+#include "input.h"
+#include "fields.h"
+#include "soil_field3d.h"
+#include "boundary.h"
+#include "thermo.h"
+#include "timeloop.h"
+#include "checkpoint.h"
+
+template<typename TF>
+Checkpoint<TF>::Checkpoint(Master& masterin, Fields<TF>& fieldsin, Input& inputin, const std::string& sim_name_in) :
+    master(masterin), fields(fieldsin), sim_name(sim_name_in)
+{
+    swcheckpoint = inputin.get_item<bool>("checkpoint", "swcheckpoint", "", false);
+
+    if (swcheckpoint)
+    {
+        // The particles are not part of the packed state, as their number per process varies.
+        if (inputin.get_item<bool>("particles", "swparticles", "", false))
+            throw std::runtime_error("swcheckpoint is not implemented with swparticles");
+
+        interval = inputin.get_item<int>("checkpoint", "interval", "", 100);
+        path = inputin.get_item<std::string>("checkpoint", "path", "", "/dev/shm");
+
+        if (interval < 1)
+            throw std::runtime_error("The checkpoint interval has to be at least one iteration");
+    }
+    else
+    {
+        inputin.flag_as_used("checkpoint", "interval", "");
+        inputin.flag_as_used("checkpoint", "path", "");
+    }
+
+    partner_send = 0;
+    partner_recv = 0;
+}
+
+template<typename TF>
+Checkpoint<TF>::~Checkpoint()
+{
+}
+
+template<typename TF>
+std::string Checkpoint<TF>::get_filename(const int mpiid, const bool is_copy) const
+{
+    char filename[256];
+    std::snprintf(filename, 256, "%s/%s.checkpoint.%05d%s",
+            path.c_str(), sim_name.c_str(), mpiid, is_copy ? ".partner" : "");
+    return std::string(filename);
+}
+
+template<typename TF>
+bool Checkpoint<TF>::read_file(std::vector<char>& buffer, const std::string& filename)
+{
+    buffer.clear();
+
+    std::FILE* file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+
+    if (size > 0)
+    {
+        buffer.resize(size);
+        if (std::fread(buffer.data(), 1, size, file) != static_cast<size_t>(size))
+            buffer.clear();
+    }
+
+    std::fclose(file);
+    return !buffer.empty();
+}
+
+template<typename TF>
+bool Checkpoint<TF>::write_file(const std::vector<char>& buffer, const std::string& filename)
+{
+    // The file is written under a temporary name first, such that a failure
+    // during the write leaves the previous checkpoint intact.
+    const std::string filename_tmp = filename + ".tmp";
+
+    std::FILE* file = std::fopen(filename_tmp.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    const bool success = (std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size());
+    if (std::fclose(file) != 0 || !success)
+        return false;
+
+    return (std::rename(filename_tmp.c_str(), filename.c_str()) == 0);
+}
+
+template<typename TF>
+void Checkpoint<TF>::exchange(
+        const std::vector<char>& send, std::vector<char>& recv, const int mpiid_send, const int mpiid_recv)
+{
+    #ifdef USEMPI
+    auto& md = master.get_MPI_data();
+
+    if (mpiid_send != md.mpiid)
+    {
+        long long nsend = send.size();
+        long long nrecv;
+        MPI_Sendrecv(&nsend, 1, MPI_LONG_LONG, mpiid_send, 0,
+                     &nrecv, 1, MPI_LONG_LONG, mpiid_recv, 0, md.commxy, MPI_STATUS_IGNORE);
+
+        if (nsend > INT_MAX || nrecv > INT_MAX)
+            throw std::runtime_error("The checkpoint of a process cannot exceed 2 GB");
+
+        recv.resize(nrecv);
+        MPI_Sendrecv(send.data(), nsend, MPI_BYTE, mpiid_send, 1,
+                     recv.data(), nrecv, MPI_BYTE, mpiid_recv, 1, md.commxy, MPI_STATUS_IGNORE);
+        return;
+    }
+    #endif
+
+    recv = send;
+}
+
+template<typename TF>
+void Checkpoint<TF>::load(Timeloop<TF>& timeloop)
+{
+    if (!swcheckpoint)
+        return;
+
+    auto& md = master.get_MPI_data();
+
+    // The partner is the process with the same rank on the next node, assuming that
+    // the processes on a node have consecutive ranks.
+    int nprocs_node = 1;
+    #ifdef USEMPI
+    MPI_Comm_size(md.commnode, &nprocs_node);
+    #endif
+
+    partner_send = (md.mpiid + nprocs_node) % md.nprocs;
+    partner_recv = (md.mpiid - nprocs_node % md.nprocs + md.nprocs) % md.nprocs;
+
+    if (partner_send == md.mpiid)
+        master.print_warning("All processes are on one node, the checkpoints have no partner copy\n");
+
+    auto is_valid = [&](const std::vector<char>& buffer)
+    {
+        if (buffer.size() < sizeof(Header))
+            return false;
+
+        Header header;
+        std::memcpy(&header, buffer.data(), sizeof(Header));
+        return (header.mpiid == md.mpiid && header.nbytes == static_cast<long long>(buffer.size() - sizeof(Header)));
+    };
+
+    std::vector<char> own;
+    int has_own = read_file(own, get_filename(md.mpiid, false)) && is_valid(own);
+
+    // Tell the process that holds the copy whether it is needed.
+    int partner_has_own = has_own;
+    #ifdef USEMPI
+    MPI_Sendrecv(&has_own, 1, MPI_INT, partner_send, 2,
+                 &partner_has_own, 1, MPI_INT, partner_recv, 2, md.commxy, MPI_STATUS_IGNORE);
+    #endif
+
+    std::vector<char> copy;
+    if (!partner_has_own)
+        read_file(copy, get_filename(partner_recv, true));
+
+    // Only the copies of the processes that lost their own checkpoint are sent.
+    std::vector<char> recovered;
+    exchange(copy, recovered, partner_recv, partner_send);
+
+    int nrecovered = 0;
+    if (!has_own && is_valid(recovered))
+    {
+        own.swap(recovered);
+        has_own = true;
+        nrecovered = 1;
+    }
+
+    // The checkpoint is only used if all processes have the same one.
+    Header header = {0, 0, 0, md.mpiid, 0};
+    if (has_own)
+        std::memcpy(&header, own.data(), sizeof(Header));
+
+    unsigned long itime_checkpoint = header.itime;
+    master.broadcast(&itime_checkpoint, 1);
+
+    int nmatch = (has_own && header.itime == itime_checkpoint);
+    int nfound = has_own;
+    master.sum(&nmatch, 1);
+    master.sum(&nfound, 1);
+    master.sum(&nrecovered, 1);
+
+    if (nfound == 0)
+        return;
+
+    if (nmatch != md.nprocs || itime_checkpoint <= timeloop.get_itime())
+    {
+        master.print_warning("No complete checkpoint newer than the restart files, the checkpoints are ignored\n");
+        return;
+    }
+
+    master.print_message("Restoring the checkpoint of iteration %d, %d processes from their partner\n",
+            header.iteration, nrecovered);
+
+    // The restart files are loaded at the time they were saved. The modules are created at the time of
+    // the checkpoint, which replaces their state at the end of the load.
+    timeloop.set_checkpoint_time(header.itime, header.idt, header.iteration);
+
+    restored.swap(own);
+}
+
+template<typename TF>
+void Checkpoint<TF>::create(Thermo<TF>& thermo, Boundary<TF>& boundary)
+{
+    if (!swcheckpoint)
+        return;
+
+    // The maps are ordered, such that the order of the arrays is equal on all runs.
+    state.clear();
+    for (auto& it : fields.ap)
+        state.push_back(&it.second->fld);
+    for (auto& it : fields.ap2d)
+        state.push_back(&it.second->fld);
+    for (auto& it : fields.sps)
+        state.push_back(&it.second->fld);
+
+    thermo.get_checkpoint_data(state);
+    boundary.get_checkpoint_data(state);
+
+    if (restored.empty())
+        return;
+
+    long long nbytes = 0;
+    for (auto v : state)
+        nbytes += v->size()*sizeof(TF);
+
+    int nerror = (nbytes != static_cast<long long>(restored.size() - sizeof(Header)));
+    master.sum(&nerror, 1);
+    if (nerror)
+        throw std::runtime_error("The checkpoint does not match the state of the model");
+
+    const char* ptr = restored.data() + sizeof(Header);
+    for (auto v : state)
+    {
+        std::memcpy(v->data(), ptr, v->size()*sizeof(TF));
+        ptr += v->size()*sizeof(TF);
+    }
+
+    std::vector<char>().swap(restored);
+}
+
+template<typename TF>
+bool Checkpoint<TF>::do_checkpoint(const int iteration)
+{
+    return (swcheckpoint && iteration % interval == 0);
+}
+
+template<typename TF>
+void Checkpoint<TF>::exec(Timeloop<TF>& timeloop)
+{
+    auto& md = master.get_MPI_data();
+
+    Header header = {timeloop.get_itime(), timeloop.get_idt(), timeloop.get_iteration(), md.mpiid, 0};
+    for (auto v : state)
+        header.nbytes += v->size()*sizeof(TF);
+
+    std::vector<char> buffer(sizeof(Header) + header.nbytes);
+    std::memcpy(buffer.data(), &header, sizeof(Header));
+
+    char* ptr = buffer.data() + sizeof(Header);
+    for (auto v : state)
+    {
+        std::memcpy(ptr, v->data(), v->size()*sizeof(TF));
+        ptr += v->size()*sizeof(TF);
+    }
+
+    std::vector<char> copy;
+    exchange(buffer, copy, partner_send, partner_recv);
+
+    // A failed checkpoint does not stop the run, as the restart files remain.
+    int nerror = 0;
+    if (!write_file(buffer, get_filename(md.mpiid, false)))
+        ++nerror;
+    if (partner_recv != md.mpiid && !write_file(copy, get_filename(partner_recv, true)))
+        ++nerror;
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        master.print_warning("Writing the checkpoint of iteration %d failed on %d processes\n", header.iteration, nerror);
+}
+
+
+#ifdef FLOAT_SINGLE
+template class Checkpoint<float>;
+#else
+template class Checkpoint<double>;
+#endif
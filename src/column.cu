@@ -20,6 +20,7 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iostream>
 
 #include "master.h"
@@ -30,33 +31,62 @@
 #include "netcdf_interface.h"
 
 #ifdef USECUDA
+namespace
+{
+    // Copy the levels [0, nk) of the columns at (col_i, col_j) into out, as [column][level].
+    template<typename TF> __global__
+    void gather_columns_g(
+            TF* const __restrict__ out, const TF* const __restrict__ data, const TF offset,
+            const int* const __restrict__ col_i, const int* const __restrict__ col_j,
+            const int ncol, const int nk, const int icells, const int ijcells)
+    {
+        const int k = blockIdx.x*blockDim.x + threadIdx.x;
+        const int n = blockIdx.y;
+
+        if (k < nk && n < ncol)
+            out[n*nk + k] = data[col_i[n] + col_j[n]*icells + k*ijcells] + offset;
+    }
+}
+
 template<typename TF>
 void Column<TF>::calc_column(
         std::string profname, const TF* const restrict data, const TF offset, const bool copy_from_gpu)
 {
     auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
 
-    for (auto& col : columns)
+    if (n_local_columns == 0)
+        return;
+
+    const int slot = prof_slots.at(profname);
+
+    if (copy_from_gpu)
     {
-        if ( (col.coord[0] / gd.imax == md.mpicoordx ) && (col.coord[1] / gd.jmax == md.mpicoordy ) )
-        {
-            const int i_col = col.coord[0] % gd.imax + gd.istart;
-            const int j_col = col.coord[1] % gd.jmax + gd.jstart;
+        const int blocki = 128;
+        const int gridi  = gd.kcells/blocki + (gd.kcells%blocki > 0);
 
-            if (copy_from_gpu)
-            {
-                const int kbeg  = i_col + j_col * gd.icells;
+        dim3 gridGPU (gridi, n_local_columns);
+        dim3 blockGPU(blocki, 1);
 
-                cuda_safe_call(cudaMemcpy2D(
-                            col.profs.at(profname).data.data(),
-                            sizeof(TF), &data[kbeg], gd.ijcells*sizeof(TF), sizeof(TF), gd.kcells, cudaMemcpyDeviceToHost));
+        // The kernel reads the field before any later kernel on the stream can overwrite it,
+        // such that the field can be released directly after this call.
+        gather_columns_g<<<gridGPU, blockGPU>>>(
+                gather_g + slot*n_local_columns*gd.kcells, data, offset,
+                col_i_g, col_j_g, n_local_columns, gd.kcells, gd.icells, gd.ijcells);
+        cuda_check_error();
 
-                for (int k=0; k<gd.kcells; ++k)
-                    col.profs.at(profname).data[k] += offset;
-            }
-            else
+        prof_pending[slot] = 1;
+    }
+    else
+    {
+        auto& md = master.get_MPI_data();
+
+        for (auto& col : columns)
+        {
+            if ( (col.coord[0] / gd.imax == md.mpicoordx ) && (col.coord[1] / gd.jmax == md.mpicoordy ) )
             {
+                const int i_col = col.coord[0] % gd.imax + gd.istart;
+                const int j_col = col.coord[1] % gd.jmax + gd.jstart;
+
                 for (int k=0; k<gd.kcells; k++)
                 {
                     const int ijk = i_col + j_col*gd.icells + k*gd.ijcells;
@@ -64,6 +94,8 @@ void Column<TF>::calc_column(
                 }
             }
         }
+
+        prof_pending[slot] = 0;
     }
 }
 
@@ -72,22 +104,66 @@ void Column<TF>::calc_time_series(
         std::string name, const TF* const restrict data, const TF offset)
 {
     auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
 
-    for (auto& col : columns)
+    if (n_local_columns == 0)
+        return;
+
+    const int slot = time_slots.at(name);
+    const int offset_slots = prof_slots.size()*n_local_columns*gd.kcells;
+
+    dim3 gridGPU (1, n_local_columns);
+    dim3 blockGPU(1, 1);
+
+    gather_columns_g<<<gridGPU, blockGPU>>>(
+            gather_g + offset_slots + slot*n_local_columns, data, offset,
+            col_i_g, col_j_g, n_local_columns, 1, gd.icells, gd.ijcells);
+    cuda_check_error();
+
+    time_pending[slot] = 1;
+}
+
+template<typename TF>
+void Column<TF>::fetch_gathered_columns()
+{
+    if (n_local_columns == 0)
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    const bool any_pending =
+            std::find(prof_pending.begin(), prof_pending.end(), 1) != prof_pending.end() ||
+            std::find(time_pending.begin(), time_pending.end(), 1) != time_pending.end();
+
+    if (!any_pending)
+        return;
+
+    // One copy of all columns and variables of this sample.
+    cuda_safe_call(cudaMemcpyAsync(
+                gather_host.data(), gather_g, gather_host.size()*sizeof(TF), cudaMemcpyDeviceToHost, 0));
+    cuda_safe_call(cudaStreamSynchronize(0));
+
+    for (auto& p : prof_slots)
     {
-        // Check if coordinate is in range.
-        if ( (col.coord[0] / gd.imax == md.mpicoordx ) && (col.coord[1] / gd.jmax == md.mpicoordy ) )
-        {
-            const int i_col = col.coord[0] % gd.imax + gd.istart;
-            const int j_col = col.coord[1] % gd.jmax + gd.jstart;
-            const int ij = i_col + j_col*gd.icells;
+        if (!prof_pending[p.second])
+            continue;
 
-            cuda_safe_call(cudaMemcpy(
-                    &col.time_series.at(name).data, &data[ij], sizeof(TF), cudaMemcpyDeviceToHost));
+        const TF* const prof = gather_host.data() + p.second*n_local_columns*gd.kcells;
+        for (int n=0; n<n_local_columns; ++n)
+            std::copy(prof + n*gd.kcells, prof + (n+1)*gd.kcells, local_columns[n]->profs.at(p.first).data.begin());
 
-            col.time_series.at(name).data += offset;
-        }
+        prof_pending[p.second] = 0;
+    }
+
+    const TF* const times = gather_host.data() + prof_slots.size()*n_local_columns*gd.kcells;
+    for (auto& t : time_slots)
+    {
+        if (!time_pending[t.second])
+            continue;
+
+        for (int n=0; n<n_local_columns; ++n)
+            local_columns[n]->time_series.at(t.first).data = times[t.second*n_local_columns + n];
+
+        time_pending[t.second] = 0;
     }
 }
 
@@ -110,8 +186,13 @@ void Column<TF>::prepare_device()
     std::vector<int> col_j;
     get_column_locations(col_i, col_j);
 
-    if (col_i.size() > 0)
+    n_local_columns = col_i.size();
+
+    if (n_local_columns > 0)
     {
+        auto& gd = grid.get_grid_data();
+        auto& md = master.get_MPI_data();
+
         const int colsize = col_i.size() * sizeof(int);
 
         cuda_safe_call(cudaMalloc(&col_i_g, colsize));
@@ -119,18 +200,45 @@ void Column<TF>::prepare_device()
 
         cuda_safe_call(cudaMemcpy(col_i_g, col_i.data(), colsize, cudaMemcpyHostToDevice));
         cuda_safe_call(cudaMemcpy(col_j_g, col_j.data(), colsize, cudaMemcpyHostToDevice));
+
+        // The local columns, in the same order as get_column_locations().
+        for (auto& col : columns)
+            if ( (col.coord[0] / gd.imax == md.mpicoordx ) && (col.coord[1] / gd.jmax == md.mpicoordy ) )
+                local_columns.push_back(&col);
+
+        // All columns have the same variables.
+        for (auto& p : local_columns[0]->profs)
+            prof_slots.emplace(p.first, prof_slots.size());
+        for (auto& t : local_columns[0]->time_series)
+            time_slots.emplace(t.first, time_slots.size());
+
+        prof_pending.assign(prof_slots.size(), 0);
+        time_pending.assign(time_slots.size(), 0);
+
+        const int ngather = (prof_slots.size()*gd.kcells + time_slots.size()) * n_local_columns;
+        cuda_safe_call(cudaMalloc(&gather_g, ngather*sizeof(TF)));
+
+        // Page-locking is only an optimization, the copy works from pageable memory as well.
+        gather_host.resize(ngather);
+        gather_host_registered =
+                cudaHostRegister(gather_host.data(), ngather*sizeof(TF), cudaHostRegisterDefault) == cudaSuccess;
+        if (!gather_host_registered)
+            cudaGetLastError();
     }
 }
 
 template<typename TF>
 void Column<TF>::clear_device()
 {
-    int n = get_n_columns();
-
-    if (n > 0)
+    if (n_local_columns > 0)
     {
         cuda_safe_call(cudaFree(col_i_g));
         cuda_safe_call(cudaFree(col_j_g));
+        cuda_safe_call(cudaFree(gather_g));
+
+        if (gather_host_registered)
+            cudaHostUnregister(gather_host.data());
+        gather_host_registered = false;
     }
 }
 #endif
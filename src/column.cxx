@@ -44,9 +44,30 @@ Column<TF>::Column(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Inp
     swcolumn = inputin.get_item<bool>("column", "swcolumn", "", false);
 
     if (swcolumn)
+    {
         sampletime = inputin.get_item<double>("column", "sampletime", "");
+        sampleoffset = inputin.get_item<double>("column", "sampleoffset", "", 0.);
+
+        // The samples are written to the files in blocks of nbuffer, which saves many small
+        // writes and file syncs for dense networks of columns.
+        nbuffer = inputin.get_item<int>("column", "nbuffer", "", 1);
+        if (nbuffer < 1)
+            throw std::runtime_error("Column nbuffer has to be at least one sample");
+    }
     else
+    {
         inputin.flag_as_used("column", "sampletime", "");
+        inputin.flag_as_used("column", "sampleoffset", "");
+        inputin.flag_as_used("column", "nbuffer", "");
+    }
+
+    nbuffered = 0;
+
+    #ifdef USECUDA
+    n_local_columns = 0;
+    gather_g = nullptr;
+    gather_host_registered = false;
+    #endif
 
     inputin.flag_as_used("column", "coordinates", "x");
     inputin.flag_as_used("column", "coordinates", "y");
@@ -55,6 +76,9 @@ Column<TF>::Column(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Inp
 template<typename TF>
 Column<TF>::~Column()
 {
+    // Write the samples of the last incomplete block.
+    if (nbuffered > 0)
+        flush();
 }
 
 template<typename TF>
@@ -64,6 +88,10 @@ void Column<TF>::init()
         return;
 
     isampletime = convert_to_itime(sampletime);
+    isampleoffset = convert_to_itime(sampleoffset);
+    if (isampletime > 0 && isampleoffset >= isampletime)
+        throw std::runtime_error("The sampleoffset in [column] has to be smaller than the sampletime");
+
     statistics_counter = 0;
 }
 
@@ -185,7 +213,7 @@ unsigned long Column<TF>::get_time_limit(unsigned long itime)
     if (isampletime == 0)
         return Constants::ulhuge;
 
-    unsigned long idtlim = isampletime - itime % isampletime;
+    unsigned long idtlim = get_sample_time_limit(itime, isampletime, isampleoffset);
     return idtlim;
 }
 
@@ -201,7 +229,7 @@ bool Column<TF>::do_column(unsigned long itime)
         return true;
 
     // check if time for execution
-    if (itime % isampletime != 0)
+    if (!is_sample_time(itime, isampletime, isampleoffset))
         return false;
 
     // return true such that column are computed
@@ -215,41 +243,78 @@ void Column<TF>::exec(int iteration, double time, unsigned long itime)
     if (isampletime > 0)
         master.print_message("Saving columns for time %f\n", time);
 
+    #ifdef USECUDA
+    fetch_gathered_columns();
+    #endif
+
     auto& gd = grid.get_grid_data();
 
-    // Put the data into the NetCDF file.
+    // Store the sample in the buffers of the columns.
+    for (auto& col : columns)
+    {
+        col.time_buffer.push_back(time);
+        col.iter_buffer.push_back(iteration);
+
+        for (auto& p : col.profs)
+        {
+            const int ksize = p.second.ncvar.get_dim_sizes()[1];
+            p.second.buffer.insert(
+                    p.second.buffer.end(),
+                    p.second.data.begin() + gd.kstart,
+                    p.second.data.begin() + gd.kstart + ksize);
+        }
+
+        for (auto& t : col.time_series)
+            t.second.buffer.push_back(t.second.data);
+    }
+
+    ++nbuffered;
+    ++statistics_counter;
+
+    if (nbuffered == nbuffer)
+        flush();
+}
+
+template<typename TF>
+void Column<TF>::flush()
+{
+    // Put the buffered samples into the NetCDF files as one block per variable.
+    const int time_start = statistics_counter - nbuffered;
+
     for (auto& col : columns)
     {
-        const std::vector<int> time_index{statistics_counter};
+        const std::vector<int> time_index{time_start};
+        const std::vector<int> time_size{nbuffered};
 
         // Write the time and iteration number.
-        col.time_var->insert(time     , time_index);
-        col.iter_var->insert(iteration, time_index);
+        col.time_var->insert(col.time_buffer, time_index, time_size);
+        col.iter_var->insert(col.iter_buffer, time_index, time_size);
+
+        col.time_buffer.clear();
+        col.iter_buffer.clear();
 
-        const std::vector<int> time_height_index = {statistics_counter, 0};
+        const std::vector<int> time_height_index = {time_start, 0};
 
         for (auto& p : col.profs)
         {
             const int ksize = p.second.ncvar.get_dim_sizes()[1];
-            std::vector<int> time_height_size  = {1, ksize};
+            const std::vector<int> time_height_size = {nbuffered, ksize};
 
-            std::vector<TF> prof_nogc(
-                    p.second.data.begin() + gd.kstart,
-                    p.second.data.begin() + gd.kstart + ksize);
-
-            p.second.ncvar.insert(prof_nogc, time_height_index, time_height_size);
+            p.second.ncvar.insert(p.second.buffer, time_height_index, time_height_size);
+            p.second.buffer.clear();
         }
 
         for (auto& t : col.time_series)
         {
-            t.second.ncvar.insert(t.second.data, time_index);
+            t.second.ncvar.insert(t.second.buffer, time_index, time_size);
+            t.second.buffer.clear();
         }
 
         // Synchronize the NetCDF file
         col.data_file->sync();
     }
 
-    ++statistics_counter;
+    nbuffered = 0;
 }
 
 template<typename TF>
@@ -261,7 +326,7 @@ void Column<TF>::add_prof(std::string name, std::string longname, std::string un
     for (auto& col : columns)
     {
         Prof_var var{col.data_file->template add_variable<TF>(name, {"time", zloc}),
-            std::vector<TF>(gd.kcells)};
+            std::vector<TF>(gd.kcells), std::vector<TF>()};
 
         var.ncvar.add_attribute("units", unit);
         var.ncvar.add_attribute("long_name", longname);
@@ -282,7 +347,7 @@ void Column<TF>::add_time_series(std::string name, std::string longname, std::st
     // Create the NetCDF variable.
     for (auto& col : columns)
     {
-        Time_var var{col.data_file->template add_variable<TF>(name, {"time"}), TF(0)};
+        Time_var var{col.data_file->template add_variable<TF>(name, {"time"}), TF(0), std::vector<TF>()};
 
         var.ncvar.add_attribute("units", unit);
         var.ncvar.add_attribute("long_name", longname);
@@ -35,9 +35,17 @@
 #include "constants.h"
 #include "finite_difference.h"
 #include "timeloop.h"
+#include "netcdf_interface.h"
+#include "io_server.h"
 
 namespace
 {
+    #ifdef USEMPI
+    template<typename TF> MPI_Datatype mpi_fp_type();
+    template<> MPI_Datatype mpi_fp_type<double>() { return MPI_DOUBLE; }
+    template<> MPI_Datatype mpi_fp_type<float>() { return MPI_FLOAT; }
+    #endif
+
     template<typename TF>
     void calc_lngrad_4th(
             const TF* const restrict a, TF* const restrict lngrad,
@@ -253,16 +261,20 @@ namespace
 template<typename TF>
 Cross<TF>::Cross(
         Master& masterin, Grid<TF>& gridin, Soil_grid<TF>& soilgridin,
-        Fields<TF>& fieldsin, Input& inputin) :
+        Fields<TF>& fieldsin, Io_server& io_serverin, Input& inputin) :
     master(masterin), grid(gridin), soil_grid(soilgridin),
-    fields(fieldsin), field3d_io(master, grid)
+    fields(fieldsin), io_server(io_serverin), field3d_io(master, grid)
 {
     swcross = inputin.get_item<bool>("cross", "swcross", "", false);
+    swnetcdf = false;
+    swaggregate = false;
+    nioranks = 1;
 
     if (swcross)
     {
        // Get the time at which the cross sections are triggered.
         sampletime = inputin.get_item<double>("cross", "sampletime", "");
+        sampleoffset = inputin.get_item<double>("cross", "sampleoffset", "", 0.);
 
         // Get list of cross variables.
         crosslist = inputin.get_list<std::string>("cross", "crosslist", "", std::vector<std::string>());
@@ -281,11 +293,31 @@ Cross<TF>::Cross(
 
         // Get the list of vertical soil locations
         xy_soil = inputin.get_list<TF>("cross", "xy_soil", "", std::vector<TF>());
+
+        // Write the cross sections directly to time-appended NetCDF files instead of binary files.
+        swnetcdf = inputin.get_item<bool>("cross", "swnetcdf", "", false);
+
+        // Gather all binary slices of an output time in one exchange onto nioranks processes, which write them.
+        swaggregate = inputin.get_item<bool>("cross", "swaggregate", "", false);
+        nioranks = inputin.get_item<int>("cross", "nioranks", "", 1);
+
+        if (swaggregate && swnetcdf)
+            throw std::runtime_error("swaggregate and swnetcdf cannot be combined");
+
+        if (swaggregate && inputin.get_item<int>("master", "nioservers", "", 0) > 0)
+            throw std::runtime_error("swaggregate cannot be combined with I/O servers");
+
+        // Variables of which only the non-zero values are saved, such as cloud and rain fields.
+        sparselist = inputin.get_list<std::string>("cross", "sparselist", "", std::vector<std::string>());
+        if (!sparselist.empty() && (swnetcdf || swaggregate || inputin.get_item<int>("master", "nioservers", "", 0) > 0))
+            throw std::runtime_error("Sparse cross-sections can only be saved as binary files by all processes");
     }
     else
     {
         inputin.flag_as_used("cross", "sampletime", "");
+        inputin.flag_as_used("cross", "sampleoffset", "");
         inputin.flag_as_used("cross", "crosslist", "");
+        inputin.flag_as_used("cross", "sparselist", "");
         inputin.flag_as_used("cross", "xy", "");
         inputin.flag_as_used("cross", "xz", "");
         inputin.flag_as_used("cross", "yz", "");
@@ -311,6 +343,436 @@ int Cross<TF>::check_save(int error, char* filename)
     }
 }
 
+template<typename TF>
+int Cross<TF>::save_slice(
+        TF* const restrict data, const TF offset, TF* const restrict tmp, char* filename,
+        const std::string& type, const int islice, const int kstart, const int kend, const bool sparse)
+{
+    if (!sparse && !swaggregate && !io_server.is_enabled())
+    {
+        if (type == "xy")
+            return check_save(field3d_io.save_xy_slice(data, offset, tmp, filename, islice), filename);
+        else if (type == "xz")
+            return check_save(field3d_io.save_xz_slice(data, offset, tmp, filename, islice, kstart, kend), filename);
+        else
+            return check_save(field3d_io.save_yz_slice(data, offset, tmp, filename, islice, kstart, kend), filename);
+    }
+
+    // Store the local part of the slice, all slices of this output time are written in flush().
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    Pending_slice slice;
+    slice.filename = filename;
+    slice.type = type;
+    slice.islice = islice;
+    slice.kmax = kend - kstart;
+
+    if (type == "xy")
+    {
+        slice.data.resize(gd.imax*gd.jmax);
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+                slice.data[i + j*gd.imax] = data[i+gd.istart + (j+gd.jstart)*gd.icells + islice*gd.ijcells] + offset;
+    }
+    else if (type == "xz" && islice / gd.jmax == md.mpicoordy)
+    {
+        const int j = islice % gd.jmax + gd.jgc;
+
+        slice.data.resize(gd.imax*slice.kmax);
+        for (int k=0; k<slice.kmax; ++k)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+                slice.data[i + k*gd.imax] = data[i+gd.istart + j*gd.icells + (k+kstart)*gd.ijcells] + offset;
+    }
+    else if (type == "yz" && islice / gd.imax == md.mpicoordx)
+    {
+        const int i = islice % gd.imax + gd.igc;
+
+        slice.data.resize(gd.jmax*slice.kmax);
+        for (int k=0; k<slice.kmax; ++k)
+            for (int j=0; j<gd.jmax; ++j)
+                slice.data[j + k*gd.jmax] = data[i + (j+gd.jstart)*gd.icells + (k+kstart)*gd.ijcells] + offset;
+    }
+
+    // Save the non-zero values of the local part, in the order of the dense slice.
+    if (sparse)
+    {
+        int nerror;
+
+        if (type == "xy")
+            nerror = field3d_io.save_block_sparse(
+                    slice.data, gd.imax, gd.jmax, 1, md.mpicoordx*gd.imax, md.mpicoordy*gd.jmax, 0,
+                    gd.itot, gd.jtot, filename);
+        else if (type == "xz")
+            nerror = field3d_io.save_block_sparse(
+                    slice.data, slice.data.empty() ? 0 : gd.imax, 1, slice.kmax, md.mpicoordx*gd.imax, 0, 0,
+                    gd.itot, 1, filename);
+        else
+            nerror = field3d_io.save_block_sparse(
+                    slice.data, slice.data.empty() ? 0 : gd.jmax, 1, slice.kmax, md.mpicoordy*gd.jmax, 0, 0,
+                    gd.jtot, 1, filename);
+
+        return check_save(nerror, filename);
+    }
+
+    // Ship the local part to an I/O server, the slice has the same layout as in Field3d_io.
+    if (io_server.is_enabled())
+    {
+        if (slice.data.empty())
+            return 0;
+
+        Io_block block;
+        block.itemsize = sizeof(TF);
+        block.k0 = 0;
+        block.j0 = 0;
+
+        if (type == "xy")
+        {
+            block.ni_tot = gd.itot;
+            block.nj_tot = gd.jtot;
+            block.i0 = md.mpicoordx*gd.imax;
+            block.j0 = md.mpicoordy*gd.jmax;
+            block.ni = gd.imax;
+            block.nj = gd.jmax;
+            block.nk = 1;
+            block.nparts = md.npx*md.npy;
+        }
+        else if (type == "xz")
+        {
+            block.ni_tot = gd.itot;
+            block.nj_tot = 1;
+            block.i0 = md.mpicoordx*gd.imax;
+            block.ni = gd.imax;
+            block.nj = 1;
+            block.nk = slice.kmax;
+            block.nparts = md.npx;
+        }
+        else
+        {
+            block.ni_tot = gd.jtot;
+            block.nj_tot = 1;
+            block.i0 = md.mpicoordy*gd.jmax;
+            block.ni = gd.jmax;
+            block.nj = 1;
+            block.nk = slice.kmax;
+            block.nparts = md.npy;
+        }
+
+        io_server.write_block(slice.filename, slice.data.data(), block);
+        return 0;
+    }
+
+    pending_slices.push_back(std::move(slice));
+
+    return 0;
+}
+
+template<typename TF>
+int Cross<TF>::get_slice_count(const Pending_slice& slice, const int mpiid)
+{
+    // Number of values of the slice that are held by process mpiid.
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int mpicoordx = mpiid % md.npx;
+    const int mpicoordy = mpiid / md.npx;
+
+    if (slice.type == "xy")
+        return gd.imax*gd.jmax;
+    else if (slice.type == "xz")
+        return (slice.islice / gd.jmax == mpicoordy) ? gd.imax*slice.kmax : 0;
+    else
+        return (slice.islice / gd.imax == mpicoordx) ? gd.jmax*slice.kmax : 0;
+}
+
+template<typename TF>
+void Cross<TF>::flush()
+{
+    if (!swaggregate || pending_slices.empty())
+        return;
+
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int nslices = pending_slices.size();
+
+    // The slices are distributed in turn over nioranks evenly spaced processes.
+    auto get_io_rank = [&](const int n) { return (n % nioranks) * (md.nprocs / nioranks); };
+
+    // Send the local parts of all slices to their I/O process in a single exchange.
+    std::vector<int> send_counts(md.nprocs, 0);
+    std::vector<int> recv_counts(md.nprocs, 0);
+
+    for (int n=0; n<nslices; ++n)
+    {
+        send_counts[get_io_rank(n)] += pending_slices[n].data.size();
+
+        if (get_io_rank(n) == md.mpiid)
+            for (int p=0; p<md.nprocs; ++p)
+                recv_counts[p] += get_slice_count(pending_slices[n], p);
+    }
+
+    std::vector<int> send_displs(md.nprocs, 0);
+    std::vector<int> recv_displs(md.nprocs, 0);
+    for (int p=1; p<md.nprocs; ++p)
+    {
+        send_displs[p] = send_displs[p-1] + send_counts[p-1];
+        recv_displs[p] = recv_displs[p-1] + recv_counts[p-1];
+    }
+
+    std::vector<TF> send_buffer(send_displs[md.nprocs-1] + send_counts[md.nprocs-1]);
+    std::vector<TF> recv_buffer(recv_displs[md.nprocs-1] + recv_counts[md.nprocs-1]);
+
+    std::vector<int> send_pos(send_displs);
+    for (int n=0; n<nslices; ++n)
+    {
+        const int dest = get_io_rank(n);
+        std::copy(pending_slices[n].data.begin(), pending_slices[n].data.end(), send_buffer.begin() + send_pos[dest]);
+        send_pos[dest] += pending_slices[n].data.size();
+    }
+
+    #ifdef USEMPI
+    MPI_Alltoallv(
+            send_buffer.data(), send_counts.data(), send_displs.data(), mpi_fp_type<TF>(),
+            recv_buffer.data(), recv_counts.data(), recv_displs.data(), mpi_fp_type<TF>(), md.commxy);
+    #else
+    recv_buffer = send_buffer;
+    #endif
+
+    // Assemble and write the slices of this process, in the same layout as Field3d_io.
+    int nerror = 0;
+    std::vector<int> recv_pos(recv_displs);
+
+    for (int n=0; n<nslices; ++n)
+    {
+        if (get_io_rank(n) != md.mpiid)
+            continue;
+
+        const Pending_slice& slice = pending_slices[n];
+
+        int ni, nj;
+        if (slice.type == "xy")
+        {
+            ni = gd.itot;
+            nj = gd.jtot;
+        }
+        else if (slice.type == "xz")
+        {
+            ni = gd.itot;
+            nj = slice.kmax;
+        }
+        else
+        {
+            ni = gd.jtot;
+            nj = slice.kmax;
+        }
+
+        std::vector<TF> full(ni*nj);
+
+        for (int p=0; p<md.nprocs; ++p)
+        {
+            const int count = get_slice_count(slice, p);
+            if (count == 0)
+                continue;
+
+            const int mpicoordx = p % md.npx;
+            const int mpicoordy = p / md.npx;
+
+            int i0, j0, np_i, np_j;
+            if (slice.type == "xy")
+            {
+                i0 = mpicoordx*gd.imax;
+                j0 = mpicoordy*gd.jmax;
+                np_i = gd.imax;
+                np_j = gd.jmax;
+            }
+            else if (slice.type == "xz")
+            {
+                i0 = mpicoordx*gd.imax;
+                j0 = 0;
+                np_i = gd.imax;
+                np_j = slice.kmax;
+            }
+            else
+            {
+                i0 = mpicoordy*gd.jmax;
+                j0 = 0;
+                np_i = gd.jmax;
+                np_j = slice.kmax;
+            }
+
+            const TF* const piece = &recv_buffer[recv_pos[p]];
+            for (int j=0; j<np_j; ++j)
+                for (int i=0; i<np_i; ++i)
+                    full[(i+i0) + (j+j0)*ni] = piece[i + j*np_i];
+
+            recv_pos[p] += count;
+        }
+
+        FILE* pFile = fopen(slice.filename.c_str(), "wbx");
+        if (pFile == NULL)
+            ++nerror;
+        else
+        {
+            if (fwrite(full.data(), sizeof(TF), full.size(), pFile) != full.size())
+                ++nerror;
+            fclose(pFile);
+        }
+    }
+
+    pending_slices.clear();
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        master.print_warning("%d cross-sections could not be saved\n", nerror);
+}
+
+template<typename TF>
+int Cross<TF>::save_slice_netcdf(
+        TF* const restrict data, const TF offset, const std::string& name, const std::string& type,
+        const std::vector<int>& indices, const int n, const int islice, const int kstart, const int kend,
+        const int iotime)
+{
+    // The NetCDF interface throws on a failed call, which is reported as an error of this slice.
+    try
+    {
+        write_slice_netcdf(data, offset, name, type, indices, n, islice, kstart, kend, iotime);
+    }
+    catch (std::runtime_error& e)
+    {
+        master.print_warning("Saving %s cross section of \"%s\" failed: %s\n", type.c_str(), name.c_str(), e.what());
+        return 1;
+    }
+
+    return 0;
+}
+
+template<typename TF>
+void Cross<TF>::write_slice_netcdf(
+        TF* const restrict data, const TF offset, const std::string& name, const std::string& type,
+        const std::vector<int>& indices, const int n, const int islice, const int kstart, const int kend,
+        const int iotime)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int kmax = kend - kstart;
+
+    // Create the file at the first cross section of this run, with all slices of the type in one variable.
+    auto it = nc_files.find(name + "." + type);
+    if (it == nc_files.end())
+    {
+        char filename[256];
+        std::snprintf(filename, 256, "%s.%s.%07d.nc", name.c_str(), type.c_str(), iotime);
+        master.print_message("Creating \"%s\"\n", filename);
+
+        Cross_nc_file nc;
+        nc.file = std::make_unique<Netcdf_file>(master, filename, Netcdf_mode::Create, 0, true);
+
+        nc.file->add_dimension("time");
+        nc.file->add_dimension("index", indices.size());
+
+        std::vector<std::string> dim_names;
+        std::vector<int> chunk_sizes;
+
+        if (type == "xy")
+        {
+            nc.file->add_dimension("y", gd.jtot);
+            nc.file->add_dimension("x", gd.itot);
+            dim_names = {"time", "index", "y", "x"};
+            chunk_sizes = {1, 1, gd.jmax, gd.imax};
+        }
+        else if (type == "xz")
+        {
+            nc.file->add_dimension("z", kmax);
+            nc.file->add_dimension("x", gd.itot);
+            dim_names = {"time", "index", "z", "x"};
+            chunk_sizes = {1, 1, kmax, gd.imax};
+        }
+        else
+        {
+            nc.file->add_dimension("z", kmax);
+            nc.file->add_dimension("y", gd.jtot);
+            dim_names = {"time", "index", "z", "y"};
+            chunk_sizes = {1, 1, kmax, gd.jmax};
+        }
+
+        auto index_var = nc.file->template add_variable<int>("index", {"index"});
+        index_var.insert(indices, {0});
+
+        nc.iotime_var = std::make_unique<Netcdf_variable<int>>(
+                nc.file->template add_variable<int>("iotime", {"time"}));
+        nc.var = std::make_unique<Netcdf_variable<TF>>(
+                nc.file->template add_variable<TF>(name, dim_names, chunk_sizes));
+
+        nc.nrecords = 0;
+        nc.last_iotime = -1;
+
+        it = nc_files.emplace(name + "." + type, std::move(nc)).first;
+    }
+
+    Cross_nc_file& nc = it->second;
+
+    // The first slice of a new output time opens a new record.
+    if (iotime != nc.last_iotime)
+    {
+        if (nc.nrecords > 0)
+            nc.file->sync();
+
+        nc.iotime_var->insert(iotime, {nc.nrecords});
+        nc.last_iotime = iotime;
+        ++nc.nrecords;
+    }
+
+    // Processes that do not hold part of the slice take part in the collective write with an empty count.
+    std::vector<TF> slice;
+    std::vector<int> start = {nc.nrecords-1, n, 0, 0};
+    std::vector<int> count = {1, 1, 0, 0};
+
+    if (type == "xy")
+    {
+        slice.resize(gd.imax*gd.jmax);
+        for (int j=0; j<gd.jmax; ++j)
+            for (int i=0; i<gd.imax; ++i)
+                slice[i + j*gd.imax] = data[i+gd.istart + (j+gd.jstart)*gd.icells + islice*gd.ijcells] + offset;
+
+        start[2] = md.mpicoordy*gd.jmax;
+        start[3] = md.mpicoordx*gd.imax;
+        count[2] = gd.jmax;
+        count[3] = gd.imax;
+    }
+    else if (type == "xz" && islice / gd.jmax == md.mpicoordy)
+    {
+        const int j = islice % gd.jmax + gd.jgc;
+
+        slice.resize(gd.imax*kmax);
+        for (int k=0; k<kmax; ++k)
+            for (int i=0; i<gd.imax; ++i)
+                slice[i + k*gd.imax] = data[i+gd.istart + j*gd.icells + (k+kstart)*gd.ijcells] + offset;
+
+        start[3] = md.mpicoordx*gd.imax;
+        count[2] = kmax;
+        count[3] = gd.imax;
+    }
+    else if (type == "yz" && islice / gd.imax == md.mpicoordx)
+    {
+        const int i = islice % gd.imax + gd.igc;
+
+        slice.resize(gd.jmax*kmax);
+        for (int k=0; k<kmax; ++k)
+            for (int j=0; j<gd.jmax; ++j)
+                slice[j + k*gd.jmax] = data[i + (j+gd.jstart)*gd.icells + (k+kstart)*gd.ijcells] + offset;
+
+        start[3] = md.mpicoordy*gd.jmax;
+        count[2] = kmax;
+        count[3] = gd.jmax;
+    }
+
+    nc.var->insert(slice, start, count);
+}
+
 template<typename TF>
 void Cross<TF>::init()
 {
@@ -318,6 +780,14 @@ void Cross<TF>::init()
         return;
 
     isampletime = convert_to_itime(sampletime);
+    isampleoffset = convert_to_itime(sampleoffset);
+    if (isampleoffset >= isampletime)
+        throw std::runtime_error("The sampleoffset in [cross] has to be smaller than the sampletime");
+
+    // The number of processes is only known after the initialization of the master.
+    auto& md = master.get_MPI_data();
+    if (nioranks < 1 || nioranks > md.nprocs)
+        throw std::runtime_error("The nioranks in [cross] has to be between 1 and the number of processes");
 }
 
 template<typename TF>
@@ -513,7 +983,7 @@ unsigned long Cross<TF>::get_time_limit(unsigned long itime)
     if (!swcross)
         return Constants::ulhuge;
 
-    unsigned long idtlim = isampletime - itime % isampletime;
+    unsigned long idtlim = get_sample_time_limit(itime, isampletime, isampleoffset);
 
     return idtlim;
 }
@@ -527,7 +997,7 @@ bool Cross<TF>::do_cross(unsigned long itime)
 
 
     // check if time for execution
-    if (itime % isampletime != 0)
+    if (!is_sample_time(itime, isampletime, isampleoffset))
         return false;
 
     // return true such that cross are computed
@@ -570,6 +1040,30 @@ std::vector<std::string> Cross<TF>::get_enabled_variables(const std::vector<std:
 }
 
 
+template<typename TF>
+void Cross<TF>::get_local_planes(
+        std::vector<int>& kplanes, std::vector<int>& jplanes, std::vector<int>& iplanes, const std::array<int,3>& loc)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    kplanes.clear();
+    jplanes.clear();
+    iplanes.clear();
+
+    // The xy cross-sections are on every process, the xz and yz ones only on the processes that contain them.
+    for (const int k : (loc == gd.wloc) ? kxyh : kxy)
+        kplanes.push_back(k + gd.kgc);
+
+    for (const int j : (loc == gd.vloc) ? jxzh : jxz)
+        if (j / gd.jmax == md.mpicoordy)
+            jplanes.push_back(j % gd.jmax + gd.jgc);
+
+    for (const int i : (loc == gd.uloc) ? ixzh : ixz)
+        if (i / gd.imax == md.mpicoordx)
+            iplanes.push_back(i % gd.imax + gd.igc);
+}
+
 template<typename TF>
 int Cross<TF>::cross_simple(
         TF* restrict data, TF restrict offset, const std::string& name, const int iotime, const std::array<int, 3>& loc)
@@ -585,61 +1079,97 @@ int Cross<TF>::cross_simple(
     char locstr[4];
     std::snprintf(locstr, 4, "%1d%1d%1d", loc[0], loc[1], loc[2]);
 
+    // Sparse slices hold only the non-zero values, see Field3d_io::save_block_sparse.
+    const bool sparse = std::find(sparselist.begin(), sparselist.end(), name) != sparselist.end();
+    const char* format = sparse ? "%s.%s.%s.%05d.%07d.sparse" : "%s.%s.%s.%05d.%07d";
+
     // Loop over the index arrays to save all xz cross sections.
     if (loc == gd.vloc)
     {
-        for (auto& it: jxzh)
+        for (int n=0; n<static_cast<int>(jxzh.size()); ++n)
         {
-            std::snprintf(filename, 256, "%s.%s.%s.%05d.%07d", name.c_str(), "xz", locstr, it, iotime);
-            nerror += check_save(
-                    field3d_io.save_xz_slice(data, offset, tmp, filename, it, gd.kstart, gd.kend), filename);
+            const int it = jxzh[n];
+            if (swnetcdf)
+                nerror += save_slice_netcdf(data, offset, name, "xz", jxzh, n, it, gd.kstart, gd.kend, iotime);
+            else
+            {
+                std::snprintf(filename, 256, format, name.c_str(), "xz", locstr, it, iotime);
+                nerror += save_slice(data, offset, tmp, filename, "xz", it, gd.kstart, gd.kend, sparse);
+            }
         }
     }
     else
     {
-        for (auto& it: jxz)
+        for (int n=0; n<static_cast<int>(jxz.size()); ++n)
         {
-            std::snprintf(filename, 256, "%s.%s.%s.%05d.%07d", name.c_str(), "xz",  locstr, it, iotime);
-            nerror += check_save(
-                    field3d_io.save_xz_slice(data, offset, tmp, filename, it, gd.kstart, gd.kend), filename);
+            const int it = jxz[n];
+            if (swnetcdf)
+                nerror += save_slice_netcdf(data, offset, name, "xz", jxz, n, it, gd.kstart, gd.kend, iotime);
+            else
+            {
+                std::snprintf(filename, 256, format, name.c_str(), "xz",  locstr, it, iotime);
+                nerror += save_slice(data, offset, tmp, filename, "xz", it, gd.kstart, gd.kend, sparse);
+            }
         }
     }
 
     // Loop over the index arrays to save all yz cross sections.
     if (loc == gd.uloc)
     {
-        for (auto& it: ixzh)
+        for (int n=0; n<static_cast<int>(ixzh.size()); ++n)
         {
-            std::snprintf(filename, 256, "%s.%s.%s.%05d.%07d", name.c_str(), "yz",  locstr, it, iotime);
-            nerror += check_save(
-                    field3d_io.save_yz_slice(data, offset, tmp, filename, it, gd.kstart, gd.kend), filename);
+            const int it = ixzh[n];
+            if (swnetcdf)
+                nerror += save_slice_netcdf(data, offset, name, "yz", ixzh, n, it, gd.kstart, gd.kend, iotime);
+            else
+            {
+                std::snprintf(filename, 256, format, name.c_str(), "yz",  locstr, it, iotime);
+                nerror += save_slice(data, offset, tmp, filename, "yz", it, gd.kstart, gd.kend, sparse);
+            }
         }
     }
     else
     {
-        for (auto& it: ixz)
+        for (int n=0; n<static_cast<int>(ixz.size()); ++n)
         {
-            std::snprintf(filename, 256, "%s.%s.%s.%05d.%07d", name.c_str(), "yz",  locstr, it, iotime);
-            nerror += check_save(
-                    field3d_io.save_yz_slice(data, offset, tmp, filename, it, gd.kstart, gd.kend), filename);
+            const int it = ixz[n];
+            if (swnetcdf)
+                nerror += save_slice_netcdf(data, offset, name, "yz", ixz, n, it, gd.kstart, gd.kend, iotime);
+            else
+            {
+                std::snprintf(filename, 256, format, name.c_str(), "yz",  locstr, it, iotime);
+                nerror += save_slice(data, offset, tmp, filename, "yz", it, gd.kstart, gd.kend, sparse);
+            }
         }
     }
 
     if (loc == gd.wloc)
     {
         // loop over the index arrays to save all xy cross sections
-        for (auto& it: kxyh)
+        for (int n=0; n<static_cast<int>(kxyh.size()); ++n)
         {
-            std::snprintf(filename, 256, "%s.%s.%s.%05d.%07d", name.c_str(), "xy",  locstr, it, iotime);
-            nerror += check_save(field3d_io.save_xy_slice(data, offset, tmp, filename, it+gd.kgc), filename);
+            const int it = kxyh[n];
+            if (swnetcdf)
+                nerror += save_slice_netcdf(data, offset, name, "xy", kxyh, n, it+gd.kgc, 0, 0, iotime);
+            else
+            {
+                std::snprintf(filename, 256, format, name.c_str(), "xy",  locstr, it, iotime);
+                nerror += save_slice(data, offset, tmp, filename, "xy", it+gd.kgc, 0, 0, sparse);
+            }
         }
     }
     else
     {
-        for (auto& it: kxy)
+        for (int n=0; n<static_cast<int>(kxy.size()); ++n)
         {
-            std::snprintf(filename, 256, "%s.%s.%s.%05d.%07d", name.c_str(), "xy",  locstr, it, iotime);
-            nerror += check_save(field3d_io.save_xy_slice(data, offset, tmp, filename, it+gd.kgc), filename);
+            const int it = kxy[n];
+            if (swnetcdf)
+                nerror += save_slice_netcdf(data, offset, name, "xy", kxy, n, it+gd.kgc, 0, 0, iotime);
+            else
+            {
+                std::snprintf(filename, 256, format, name.c_str(), "xy",  locstr, it, iotime);
+                nerror += save_slice(data, offset, tmp, filename, "xy", it+gd.kgc, 0, 0, sparse);
+            }
         }
     }
     fields.release_tmp(tmpfld);
@@ -656,8 +1186,13 @@ int Cross<TF>::cross_plane(TF* restrict data, TF restrict offset, std::string na
     auto tmpfld = fields.get_tmp();
     auto tmp = tmpfld->fld.data();
 
-    std::snprintf(filename, 256, "%s.%s.%07d", name.c_str(), "xy.000", iotime);
-    nerror += check_save(field3d_io.save_xy_slice(data, offset, tmp, filename), filename);
+    if (swnetcdf)
+        nerror += save_slice_netcdf(data, offset, name, "xy", {0}, 0, 0, 0, 0, iotime);
+    else
+    {
+        std::snprintf(filename, 256, "%s.%s.%07d", name.c_str(), "xy.000", iotime);
+        nerror += save_slice(data, offset, tmp, filename, "xy", 0, 0, 0);
+    }
     fields.release_tmp(tmpfld);
     return nerror;
 }
@@ -686,26 +1221,42 @@ int Cross<TF>::cross_lngrad(TF* restrict a, std::string name, int iotime)
 
     // loop over the index arrays to save all xz cross sections
     TF no_offset = 0;
-    for (auto& it: jxz)
+    for (int n=0; n<static_cast<int>(jxz.size()); ++n)
     {
-        std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "xz.000", it, iotime);
-        nerror += check_save(
-                field3d_io.save_xz_slice(lngrad, no_offset, tmp, filename, it, gd.kstart, gd.kend),filename);
+        const int it = jxz[n];
+        if (swnetcdf)
+            nerror += save_slice_netcdf(lngrad, no_offset, name, "xz", jxz, n, it, gd.kstart, gd.kend, iotime);
+        else
+        {
+            std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "xz.000", it, iotime);
+            nerror += save_slice(lngrad, no_offset, tmp, filename, "xz", it, gd.kstart, gd.kend);
+        }
     }
 
     // loop over the index arrays to save all yz cross sections
-    for (auto& it: ixz)
+    for (int n=0; n<static_cast<int>(ixz.size()); ++n)
     {
-        std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "yz.000", it, iotime);
-        nerror += check_save(
-                field3d_io.save_yz_slice(lngrad, no_offset, tmp, filename, it, gd.kstart, gd.kend),filename);
+        const int it = ixz[n];
+        if (swnetcdf)
+            nerror += save_slice_netcdf(lngrad, no_offset, name, "yz", ixz, n, it, gd.kstart, gd.kend, iotime);
+        else
+        {
+            std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "yz.000", it, iotime);
+            nerror += save_slice(lngrad, no_offset, tmp, filename, "yz", it, gd.kstart, gd.kend);
+        }
     }
 
     // loop over the index arrays to save all xy cross sections
-    for (auto& it: kxy)
+    for (int n=0; n<static_cast<int>(kxy.size()); ++n)
     {
-        std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "xy.000", it, iotime);
-        nerror += check_save(field3d_io.save_xy_slice(lngrad, no_offset, tmp, filename, it+gd.kgc),filename);
+        const int it = kxy[n];
+        if (swnetcdf)
+            nerror += save_slice_netcdf(lngrad, no_offset, name, "xy", kxy, n, it+gd.kgc, 0, 0, iotime);
+        else
+        {
+            std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "xy.000", it, iotime);
+            nerror += save_slice(lngrad, no_offset, tmp, filename, "xy", it+gd.kgc, 0, 0);
+        }
     }
 
     fields.release_tmp(tmpfld);
@@ -784,24 +1335,40 @@ int Cross<TF>::cross_soil(
     auto tmpfld = fields.get_tmp();
     auto tmp = tmpfld->fld.data();
 
-    for (auto& it: jxz)
+    for (int n=0; n<static_cast<int>(jxz.size()); ++n)
     {
-        std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "xz.000", it, iotime);
-        nerror += check_save(
-                field3d_io.save_xz_slice(data, no_offset, tmp, filename, it, sgd.kstart, sgd.kend), filename);
+        const int it = jxz[n];
+        if (swnetcdf)
+            nerror += save_slice_netcdf(data, no_offset, name, "xz", jxz, n, it, sgd.kstart, sgd.kend, iotime);
+        else
+        {
+            std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "xz.000", it, iotime);
+            nerror += save_slice(data, no_offset, tmp, filename, "xz", it, sgd.kstart, sgd.kend);
+        }
     }
 
-    for (auto& it: ixz)
+    for (int n=0; n<static_cast<int>(ixz.size()); ++n)
     {
-        std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "yz.000", it, iotime);
-        nerror += check_save(
-                field3d_io.save_yz_slice(data, no_offset, tmp, filename, it, sgd.kstart, sgd.kend), filename);
+        const int it = ixz[n];
+        if (swnetcdf)
+            nerror += save_slice_netcdf(data, no_offset, name, "yz", ixz, n, it, sgd.kstart, sgd.kend, iotime);
+        else
+        {
+            std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "yz.000", it, iotime);
+            nerror += save_slice(data, no_offset, tmp, filename, "yz", it, sgd.kstart, sgd.kend);
+        }
     }
 
-    for (auto& it: kxy_soil)
+    for (int n=0; n<static_cast<int>(kxy_soil.size()); ++n)
     {
-        std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "xy.000", it, iotime);
-        nerror += check_save(field3d_io.save_xy_slice(data, no_offset, tmp, filename, it+sgd.kgc), filename);
+        const int it = kxy_soil[n];
+        if (swnetcdf)
+            nerror += save_slice_netcdf(data, no_offset, name, "xy", kxy_soil, n, it+sgd.kgc, 0, 0, iotime);
+        else
+        {
+            std::snprintf(filename, 256, "%s.%s.%05d.%07d", name.c_str(), "xy.000", it, iotime);
+            nerror += save_slice(data, no_offset, tmp, filename, "xy", it+sgd.kgc, 0, 0);
+        }
     }
 
     fields.release_tmp(tmpfld);
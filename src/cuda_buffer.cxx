@@ -22,6 +22,8 @@
  */
 
 #include <utility>
+#include <algorithm>
+#include <cstdint>
 #include "cuda_buffer.h"
 
 #ifdef USECUDA
@@ -42,9 +44,18 @@ cuda_raw_buffer::cuda_raw_buffer(cuda_raw_buffer&& that) noexcept
 cuda_raw_buffer& cuda_raw_buffer::operator=(cuda_raw_buffer&& that) noexcept
 {
     std::swap(ptr_, that.ptr_);
+    std::swap(size_, that.size_);
+    std::swap(from_pool_, that.from_pool_);
     return *this;
 }
 
+namespace
+{
+    bool use_memory_pool = false;
+    bool use_managed_memory = false;
+    cuda_memory_usage memory_usage;
+}
+
 #ifdef USECUDA
 static std::string allocation_failed_message(size_t allocation_attempt_size)
 {
@@ -66,13 +77,29 @@ void cuda_raw_buffer::reallocate(size_t size_in_bytes)
 #ifdef USECUDA
     if (ptr_)
     {
-        cuda_safe_call(cudaFree(ptr_));
+        // A pool allocation is released in stream order, such that kernels that still use it finish first.
+        // The kind of the allocation is stored per buffer, as the pool can be switched after the allocation.
+        if (from_pool_)
+            cuda_safe_call(cudaFreeAsync(ptr_, 0));
+        else
+            cuda_safe_call(cudaFree(ptr_));
+
         ptr_ = nullptr;
+        memory_usage.current -= size_;
+        size_ = 0;
+        from_pool_ = false;
     }
 
     if (size_in_bytes > 0)
     {
-        cudaError_t result = cudaMalloc(&ptr_, size_in_bytes);
+        cudaError_t result;
+
+        if (use_memory_pool)
+            result = cudaMallocAsync(&ptr_, size_in_bytes, 0);
+        else if (use_managed_memory)
+            result = cudaMallocManaged(&ptr_, size_in_bytes, cudaMemAttachGlobal);
+        else
+            result = cudaMalloc(&ptr_, size_in_bytes);
 
         if (result == cudaErrorMemoryAllocation)
         {
@@ -80,6 +107,19 @@ void cuda_raw_buffer::reallocate(size_t size_in_bytes)
         }
 
         cuda_safe_call(result);
+        from_pool_ = use_memory_pool;
+
+        // Keep the pages on the device as long as they fit, and evict them to the host otherwise.
+        if (use_managed_memory)
+        {
+            int device = -1;
+            cuda_safe_call(cudaGetDevice(&device));
+            cuda_safe_call(cudaMemAdvise(ptr_, size_in_bytes, cudaMemAdviseSetPreferredLocation, device));
+        }
+
+        size_ = size_in_bytes;
+        memory_usage.current += size_;
+        memory_usage.high_water_mark = std::max(memory_usage.high_water_mark, memory_usage.current);
     }
 #else
     if (size_in_bytes > 0)
@@ -89,6 +129,42 @@ void cuda_raw_buffer::reallocate(size_t size_in_bytes)
 #endif //USECUDA
 }
 
+void cuda_enable_memory_pool(bool enable)
+{
+    if (enable && use_managed_memory)
+        throw std::runtime_error("The CUDA memory pool cannot be combined with managed memory");
+
+#ifdef USECUDA
+    if (enable)
+    {
+        int device = -1;
+        cudaMemPool_t pool;
+
+        cuda_safe_call(cudaGetDevice(&device));
+        cuda_safe_call(cudaDeviceGetDefaultMemPool(&pool, device));
+
+        // Keep all freed memory in the pool, the model releases it only at the end of the run.
+        uint64_t threshold = std::numeric_limits<uint64_t>::max();
+        cuda_safe_call(cudaMemPoolSetAttribute(pool, cudaMemPoolAttrReleaseThreshold, &threshold));
+    }
+#endif //USECUDA
+
+    use_memory_pool = enable;
+}
+
+void cuda_enable_managed_memory(bool enable)
+{
+    if (enable && use_memory_pool)
+        throw std::runtime_error("Managed memory cannot be combined with the CUDA memory pool");
+
+    use_managed_memory = enable;
+}
+
+cuda_memory_usage cuda_get_memory_usage()
+{
+    return memory_usage;
+}
+
 void cuda_raw_copy(const void* src, void* dst, size_t nbytes)
 {
 #ifdef USECUDA
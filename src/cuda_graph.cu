@@ -0,0 +1,110 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "master.h"
+#include "tools.h"
+#include "cuda_streams.h"
+#include "cuda_graph.h"
+
+#ifdef USECUDA
+Cuda_graph::Cuda_graph(Master& masterin, bool swgraphin) :
+    master(masterin), swgraph(swgraphin), stream(nullptr), graph_exec(nullptr)
+{
+}
+
+Cuda_graph::~Cuda_graph()
+{
+    clear();
+}
+
+void Cuda_graph::exec(const std::function<void()>& launches)
+{
+    if (!swgraph)
+    {
+        launches();
+        return;
+    }
+
+    if (graph_exec == nullptr)
+    {
+        // The capture stream is a blocking stream, such that it is ordered with the
+        // kernels that the rest of the code launches on the default stream.
+        if (stream == nullptr)
+            cuda_safe_call(cudaStreamCreate(&stream));
+
+        cudaGraph_t graph = nullptr;
+        bool recorded = false;
+
+        cuda_safe_call(cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+        Cuda_streams::set_launch_stream(stream);
+
+        try
+        {
+            launches();
+            recorded = true;
+        }
+        catch (const Tools_g::cuda_exception&)
+        {
+            // In case of CUDACHECKS, the synchronization in the error check invalidates the capture.
+        }
+
+        Cuda_streams::set_launch_stream(nullptr);
+        cudaError_t err = cudaStreamEndCapture(stream, &graph);
+
+        if (recorded && err == cudaSuccess)
+            err = cudaGraphInstantiateWithFlags(&graph_exec, graph, 0);
+
+        if (graph != nullptr)
+            cudaGraphDestroy(graph);
+
+        if (!recorded || err != cudaSuccess)
+        {
+            // Reset the error state and run the launches without a graph from now on.
+            cudaGetLastError();
+            graph_exec = nullptr;
+            swgraph = false;
+
+            master.print_warning("Kernel sequence cannot be captured into a CUDA graph, disabling swcudagraph\n");
+            launches();
+            return;
+        }
+    }
+
+    cuda_safe_call(cudaGraphLaunch(graph_exec, stream));
+}
+
+void Cuda_graph::clear()
+{
+    if (graph_exec != nullptr)
+    {
+        cudaGraphExecDestroy(graph_exec);
+        graph_exec = nullptr;
+    }
+
+    if (stream != nullptr)
+    {
+        cudaStreamDestroy(stream);
+        stream = nullptr;
+    }
+}
+#endif
@@ -37,10 +37,12 @@ GridKernel::GridKernel(
         GridFunctor meta,
         kernel_launcher::TypeInfo functor_type,
         std::vector<kl::TypeInfo> param_types,
+        std::vector<std::string> constant_args,
         Grid_layout grid):
     meta(std::move(meta)),
     functor_type(functor_type),
     param_types(std::move(param_types)),
+    constant_args(std::move(constant_args)),
     grid(grid) {}
 
 bool GridKernel::equals(const IKernelDescriptor& that) const {
@@ -48,6 +50,7 @@ bool GridKernel::equals(const IKernelDescriptor& that) const {
         return g->meta.name == meta.name &&
                 g->functor_type == functor_type &&
                 g->param_types == param_types &&
+                g->constant_args == constant_args &&
                 g->grid == grid;
     }
 
@@ -74,7 +77,14 @@ kl::KernelBuilder GridKernel::build() const {
         }
 
         params << "a" << i;
-        args << "a" << i;
+
+        // The constant arguments are passed as literals, such that NVRTC can fold the index
+        // arithmetic and unroll the loops over them. The parameter itself is left unused.
+        if (!constant_args[i].empty()) {
+            args << constant_args[i];
+        } else {
+            args << "a" << i;
+        }
     }
 
     std::string source = R"(
@@ -0,0 +1,113 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <stdexcept>
+
+#include "tools.h"
+#include "cuda_streams.h"
+
+#ifdef USECUDA
+thread_local cudaStream_t Cuda_streams::launch_stream = nullptr;
+
+int Cuda_streams::pool_size = 1;
+std::vector<cudaStream_t> Cuda_streams::streams;
+std::vector<cudaEvent_t> Cuda_streams::events;
+cudaEvent_t Cuda_streams::fork_event = nullptr;
+
+Cuda_streams::Cuda_streams() :
+    parent(launch_stream), nused(0)
+{
+    if (pool_size < 2)
+        return;
+
+    // The pool is created the first time it is used, as the device is not set up before.
+    if (streams.empty())
+    {
+        streams.resize(pool_size);
+        events.resize(pool_size);
+
+        for (int n=0; n<pool_size; ++n)
+        {
+            cuda_safe_call(cudaStreamCreateWithFlags(&streams[n], cudaStreamNonBlocking));
+            cuda_safe_call(cudaEventCreateWithFlags(&events[n], cudaEventDisableTiming));
+        }
+        cuda_safe_call(cudaEventCreateWithFlags(&fork_event, cudaEventDisableTiming));
+    }
+
+    cuda_safe_call(cudaEventRecord(fork_event, parent));
+}
+
+Cuda_streams::~Cuda_streams()
+{
+    if (pool_size < 2)
+        return;
+
+    // Only the branches that received work have to be joined.
+    for (int n=0; n<nused; ++n)
+    {
+        cudaEventRecord(events[n], streams[n]);
+        cudaStreamWaitEvent(parent, events[n], 0);
+    }
+
+    launch_stream = parent;
+}
+
+void Cuda_streams::select(const int branch)
+{
+    if (pool_size < 2)
+        return;
+
+    const int n = branch % pool_size;
+
+    // Each branch waits once for the work that preceded the region.
+    for (; nused<=n; ++nused)
+        cuda_safe_call(cudaStreamWaitEvent(streams[nused], fork_event, 0));
+
+    launch_stream = streams[n];
+}
+
+void Cuda_streams::set_pool_size(const int n)
+{
+    if (n < 1)
+        throw std::runtime_error("The number of CUDA streams has to be at least one");
+
+    clear_pool();
+    pool_size = n;
+}
+
+void Cuda_streams::clear_pool()
+{
+    for (auto& stream : streams)
+        cudaStreamDestroy(stream);
+
+    for (auto& event : events)
+        cudaEventDestroy(event);
+
+    if (fork_event != nullptr)
+        cudaEventDestroy(fork_event);
+
+    streams.clear();
+    events.clear();
+    fork_event = nullptr;
+}
+#endif
@@ -52,7 +52,7 @@ namespace
 
 #ifdef USECUDA
 template <typename TF>
-void Decay<TF>::exec(double dt, Stats<TF>& stats)
+void Decay<TF>::exec(double dt, Stats<TF>& stats, Timeloop<TF>& timeloop)
 {
     auto& gd = grid.get_grid_data();
     const int blocki = gd.ithread_block;
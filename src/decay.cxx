@@ -28,6 +28,7 @@
 #include "grid.h"
 #include "fields.h"
 #include "stats.h"
+#include "timeloop.h"
 #include "decay.h"
 
 namespace
@@ -94,13 +95,21 @@ void Decay<TF>::create(Input& inputin, Stats<TF>& stats)
 
 #ifndef USECUDA
 template <typename TF>
-void Decay<TF>::exec(double dt, Stats<TF>& stats)
+void Decay<TF>::exec(double dt, Stats<TF>& stats, Timeloop<TF>& timeloop)
 {
     auto& gd = grid.get_grid_data();
     for (auto& it : dmap)
     {
         if (it.second.type == Decay_type::exponential)
         {
+            // Without the tendency statistics, the decay is applied in the time integration.
+            if (!stats.is_doing_tendency())
+            {
+                const TF rate = 1./(std::max(TF(it.second.timescale), TF(dt)));
+                timeloop.add_rk_decay(it.first, rate);
+                continue;
+            }
+
             enforce_exponential_decay<TF>(
                     fields.st.at(it.first)->fld.data(), fields.sp.at(it.first)->fld.data(), it.second.timescale, dt,
                     gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
@@ -30,10 +30,10 @@
 
 namespace
 {
-    template<typename TF> __global__
+    template<typename TF, bool uniform_z> __global__
     void diff_c_g(TF* __restrict__ const at, const TF* __restrict__ const a,
                   const TF* __restrict__ const dzi, const TF* __restrict__ const dzhi,
-                  const TF dxidxi, const TF dyidyi, const TF visc,
+                  const TF dxidxi, const TF dyidyi, const TF dzidzi, const TF visc,
                   const int jj,     const int kk,
                   const int istart, const int jstart, const int kstart,
                   const int iend,   const int jend,   const int kend)
@@ -47,20 +47,30 @@ namespace
             const int ijk = i + j*jj + k*kk;
             const int ii = 1;
 
-            at[ijk] += visc * (
-                + (  (a[ijk+ii] - a[ijk   ])
-                   - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
-                + (  (a[ijk+jj] - a[ijk   ])
-                   - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
-                + (  (a[ijk+kk] - a[ijk   ]) * dzhi[k+1]
-                   - (a[ijk   ] - a[ijk-kk]) * dzhi[k]   ) * dzi[k]);
+            // On an equidistant grid the vertical spacing is the scalar dzidzi.
+            if constexpr (uniform_z)
+                at[ijk] += visc * (
+                    + (  (a[ijk+ii] - a[ijk   ])
+                       - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
+                    + (  (a[ijk+jj] - a[ijk   ])
+                       - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
+                    + (  (a[ijk+kk] - a[ijk   ])
+                       - (a[ijk   ] - a[ijk-kk]) ) * dzidzi);
+            else
+                at[ijk] += visc * (
+                    + (  (a[ijk+ii] - a[ijk   ])
+                       - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
+                    + (  (a[ijk+jj] - a[ijk   ])
+                       - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
+                    + (  (a[ijk+kk] - a[ijk   ]) * dzhi[k+1]
+                       - (a[ijk   ] - a[ijk-kk]) * dzhi[k]   ) * dzi[k]);
         }
     }
 
-    template<typename TF> __global__
+    template<typename TF, bool uniform_z> __global__
     void diff_w_g(TF* __restrict__ const at, const TF* __restrict__ const a,
                   const TF* __restrict__ const dzi, const TF* __restrict__ const dzhi,
-                  const TF dxidxi, const TF dyidyi, const TF visc,
+                  const TF dxidxi, const TF dyidyi, const TF dzidzi, const TF visc,
                   const int jj,     const int kk,
                   const int istart, const int jstart, const int kstart,
                   const int iend,   const int jend,   const int kend)
@@ -74,13 +84,22 @@ namespace
             const int ijk = i + j*jj + k*kk;
             const int ii = 1;
 
-            at[ijk] += visc * (
-                + (  (a[ijk+ii] - a[ijk   ])
-                    - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
-                + (  (a[ijk+jj] - a[ijk   ])
-                    - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
-                + (  (a[ijk+kk] - a[ijk   ]) * dzi[k]
-                    - (a[ijk   ] - a[ijk-kk]) * dzi[k-1] ) * dzhi[k]);
+            if constexpr (uniform_z)
+                at[ijk] += visc * (
+                    + (  (a[ijk+ii] - a[ijk   ])
+                        - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
+                    + (  (a[ijk+jj] - a[ijk   ])
+                        - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
+                    + (  (a[ijk+kk] - a[ijk   ])
+                        - (a[ijk   ] - a[ijk-kk]) ) * dzidzi);
+            else
+                at[ijk] += visc * (
+                    + (  (a[ijk+ii] - a[ijk   ])
+                        - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
+                    + (  (a[ijk+jj] - a[ijk   ])
+                        - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
+                    + (  (a[ijk+kk] - a[ijk   ]) * dzi[k]
+                        - (a[ijk   ] - a[ijk-kk]) * dzi[k-1] ) * dzhi[k]);
         }
     }
 }
@@ -100,40 +119,44 @@ void Diff_2<TF>::exec(Stats<TF>& stats)
 
     const TF dxidxi = 1./(gd.dx*gd.dx);
     const TF dyidyi = 1./(gd.dy*gd.dy);
+    const TF dzidzi = gd.dzi[gd.kstart]*gd.dzi[gd.kstart];
 
+    // Select the kernels of the equidistant grid once for all fields.
+    auto diff_c_ptr = gd.uniform_z ? diff_c_g<TF, true> : diff_c_g<TF, false>;
+    auto diff_w_ptr = gd.uniform_z ? diff_w_g<TF, true> : diff_w_g<TF, false>;
 
-    diff_c_g<TF><<<gridGPU, blockGPU>>>(
+    diff_c_ptr<<<gridGPU, blockGPU>>>(
         fields.mt.at("u")->fld_g, fields.mp.at("u")->fld_g,
         gd.dzi_g, gd.dzhi_g,
-        dxidxi, dyidyi, fields.visc,
+        dxidxi, dyidyi, dzidzi, fields.visc,
         gd.icells, gd.ijcells,
         gd.istart,  gd.jstart, gd.kstart,
         gd.iend,    gd.jend,   gd.kend);
     cuda_check_error();
 
-    diff_c_g<TF><<<gridGPU, blockGPU>>>(
+    diff_c_ptr<<<gridGPU, blockGPU>>>(
         fields.mt.at("v")->fld_g, fields.mp.at("v")->fld_g,
         gd.dzi_g, gd.dzhi_g,
-        dxidxi, dyidyi, fields.visc,
+        dxidxi, dyidyi, dzidzi, fields.visc,
         gd.icells, gd.ijcells,
         gd.istart,  gd.jstart, gd.kstart,
         gd.iend,    gd.jend,   gd.kend);
     cuda_check_error();
 
-    diff_w_g<TF><<<gridGPU, blockGPU>>>(
+    diff_w_ptr<<<gridGPU, blockGPU>>>(
         fields.mt.at("w")->fld_g, fields.mp.at("w")->fld_g,
         gd.dzi_g, gd.dzhi_g,
-        dxidxi, dyidyi, fields.visc,
+        dxidxi, dyidyi, dzidzi, fields.visc,
         gd.icells, gd.ijcells,
         gd.istart,  gd.jstart, gd.kstart,
         gd.iend,    gd.jend,   gd.kend);
     cuda_check_error();
 
     for (auto &it : fields.st)
-        diff_c_g<TF><<<gridGPU, blockGPU>>>(
+        diff_c_ptr<<<gridGPU, blockGPU>>>(
             it.second->fld_g, fields.sp.at(it.first)->fld_g,
             gd.dzi_g, gd.dzhi_g,
-            dxidxi, dyidyi, fields.sp.at(it.first)->visc,
+            dxidxi, dyidyi, dzidzi, fields.sp.at(it.first)->visc,
             gd.icells, gd.ijcells,
             gd.istart,  gd.jstart, gd.kstart,
             gd.iend,    gd.jend,   gd.kend);
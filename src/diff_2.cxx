@@ -35,7 +35,9 @@
 
 namespace
 {
-    template<typename TF>
+    // With uniform_z, the grid is equidistant in the vertical and the vertical
+    // spacing is a single scalar, which removes the per level loads.
+    template<typename TF, bool uniform_z>
     void diff_c(TF* restrict at, const TF* restrict a, const TF visc,
                 const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
                 const int jj, const int kk, const TF dx, const TF dy, const TF* restrict dzi, const TF* restrict dzhi)
@@ -44,6 +46,29 @@ namespace
         const double dxidxi = 1/(dx*dx);
         const double dyidyi = 1/(dy*dy);
 
+        if constexpr (uniform_z)
+        {
+            const TF dzidzi = dzi[kstart]*dzi[kstart];
+
+            #pragma omp parallel for
+            for (int k=kstart; k<kend; k++)
+                for (int j=jstart; j<jend; j++)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; i++)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        at[ijk] += visc * (
+                                + ( (a[ijk+ii] - a[ijk   ])
+                                  - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
+                                + ( (a[ijk+jj] - a[ijk   ])
+                                  - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
+                                + ( (a[ijk+kk] - a[ijk   ])
+                                  - (a[ijk   ] - a[ijk-kk]) ) * dzidzi );
+                    }
+            return;
+        }
+
+        #pragma omp parallel for
         for (int k=kstart; k<kend; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -60,7 +85,7 @@ namespace
                 }
     }
 
-    template<typename TF>
+    template<typename TF, bool uniform_z>
     void diff_w(TF* restrict wt, const TF* restrict w, const TF visc,
                 const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
                 const int jj, const int kk, const TF dx, const TF dy, const TF* restrict dzi, const TF* restrict dzhi)
@@ -69,6 +94,29 @@ namespace
         const double dxidxi = 1/(dx*dx);
         const double dyidyi = 1/(dy*dy);
 
+        if constexpr (uniform_z)
+        {
+            const TF dzidzi = dzi[kstart]*dzi[kstart];
+
+            #pragma omp parallel for
+            for (int k=kstart+1; k<kend; k++)
+                for (int j=jstart; j<jend; j++)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; i++)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        wt[ijk] += visc * (
+                                + ( (w[ijk+ii] - w[ijk   ])
+                                  - (w[ijk   ] - w[ijk-ii]) ) * dxidxi
+                                + ( (w[ijk+jj] - w[ijk   ])
+                                  - (w[ijk   ] - w[ijk-jj]) ) * dyidyi
+                                + ( (w[ijk+kk] - w[ijk   ])
+                                  - (w[ijk   ] - w[ijk-kk]) ) * dzidzi );
+                    }
+            return;
+        }
+
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -166,22 +214,32 @@ void Diff_2<TF>::exec(Stats<TF>& stats)
 {
     auto& gd = grid.get_grid_data();
 
-    diff_c<TF>(fields.mt.at("u")->fld.data(), fields.mp.at("u")->fld.data(), fields.visc,
+    // Select the kernels of the equidistant grid once for all fields.
+    auto diff_c_ptr = gd.uniform_z ? diff_c<TF, true> : diff_c<TF, false>;
+    auto diff_w_ptr = gd.uniform_z ? diff_w<TF, true> : diff_w<TF, false>;
+
+    diff_c_ptr(fields.mt.at("u")->fld.data(), fields.mp.at("u")->fld.data(), fields.visc,
                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
                gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data());
 
-    diff_c<TF>(fields.mt.at("v")->fld.data(), fields.mp.at("v")->fld.data(), fields.visc,
+    diff_c_ptr(fields.mt.at("v")->fld.data(), fields.mp.at("v")->fld.data(), fields.visc,
                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
                gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data());
 
-    diff_w<TF>(fields.mt.at("w")->fld.data(), fields.mp.at("w")->fld.data(), fields.visc,
+    diff_w_ptr(fields.mt.at("w")->fld.data(), fields.mp.at("w")->fld.data(), fields.visc,
                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
                gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data());
 
     for (auto& it : fields.st)
-        diff_c<TF>(it.second->fld.data(), fields.sp.at(it.first)->fld.data(), fields.sp.at(it.first)->visc,
-                   gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
+    {
+        if (fields.is_slow_skipped(it.first))
+            continue;
+
+        const auto box = fields.get_active_box(it.first);
+        diff_c_ptr(it.second->fld.data(), fields.sp.at(it.first)->fld.data(), fields.sp.at(it.first)->visc,
+                   box.istart, box.iend, box.jstart, box.jend, gd.kstart, box.kend, gd.icells, gd.ijcells,
                    gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data());
+    }
 
     stats.calc_tend(*fields.mt.at("u"), tend_name);
     stats.calc_tend(*fields.mt.at("v"), tend_name);
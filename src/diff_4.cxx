@@ -72,6 +72,7 @@ namespace
                                 * dzi4[kstart];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend-1; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -139,6 +140,7 @@ namespace
                                 * dzhi4[kstart+1];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+2; k<kend-1; k++)
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -273,9 +275,14 @@ void Diff_4<TF>::exec(Stats<TF>& stats)
                      gd.dx, gd.dy, gd.dzi4.data(), gd.dzhi4.data());
 
         for (auto& it : fields.st)
+        {
+            if (fields.is_slow_skipped(it.first))
+                continue;
+
             diff_c<TF,0>(it.second->fld.data(), fields.sp.at(it.first)->fld.data(), fields.sp.at(it.first)->visc,
                          gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
                          gd.dx, gd.dy, gd.dzi4.data(), gd.dzhi4.data());
+        }
     }
     else
     {
@@ -292,9 +299,14 @@ void Diff_4<TF>::exec(Stats<TF>& stats)
                      gd.dx, gd.dy, gd.dzi4.data(), gd.dzhi4.data());
 
         for (auto& it : fields.st)
+        {
+            if (fields.is_slow_skipped(it.first))
+                continue;
+
             diff_c<TF,1>(it.second->fld.data(), fields.sp.at(it.first)->fld.data(), fields.sp.at(it.first)->visc,
                          gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
                          gd.dx, gd.dy, gd.dzi4.data(), gd.dzhi4.data());
+        }
     }
 
     stats.calc_tend(*fields.mt.at("u"), tend_name);
@@ -43,6 +43,7 @@
 
 // Kernel Launcher
 #include "cuda_launcher.h"
+#include "cuda_streams.h"
 #include "diff_smag2_kl_kernels.cuh"
 #include "diff_kl_kernels.cuh"
 
@@ -117,19 +118,19 @@ void Diff_smag2<TF>::exec_viscosity(Stats<TF>&, Thermo<TF>& thermo)
         auto& dudz_g  = boundary.get_dudz_g();
         auto& dvdz_g  = boundary.get_dvdz_g();
 
-        // Calculate total strain rate
-        launch_grid_kernel<Diff_les_kernels::calc_strain2_g<TF, true>>(
-            grid_layout,
-            fields.sd.at("evisc")->fld_g.view(),
-            fields.mp.at("u")->fld_g,
-            fields.mp.at("v")->fld_g,
-            fields.mp.at("w")->fld_g,
-            dudz_g, dvdz_g,
-            gd.dzi_g, gd.dzhi_g,
-            gd.dxi, gd.dyi);
-
         if (thermo.get_switch() == Thermo_type::Disabled)
         {
+            // Calculate total strain rate
+            launch_grid_kernel<Diff_les_kernels::calc_strain2_g<TF, true>>(
+                grid_layout,
+                fields.sd.at("evisc")->fld_g.view(),
+                fields.mp.at("u")->fld_g,
+                fields.mp.at("v")->fld_g,
+                fields.mp.at("w")->fld_g,
+                dudz_g, dvdz_g,
+                gd.dzi_g, gd.dzhi_g,
+                gd.dxi, gd.dyi);
+
             // Start with retrieving the stability information
             Diff_smag2_kernels::evisc_neutral_g<TF><<<gridGPU, blockGPU>>>(
                 fields.sd.at("evisc")->fld_g,
@@ -148,14 +149,20 @@ void Diff_smag2<TF>::exec_viscosity(Stats<TF>&, Thermo<TF>& thermo)
             // Get MO gradient buoyancy:
             auto& dbdz_g  = boundary.get_dbdz_g();
 
-            // Calculate eddy viscosity
+            // Calculate the strain rate and eddy viscosity in one pass.
             TF tPri = 1./tPr;
 
             launch_grid_kernel<Diff_smag2_kernels::evisc_g<TF, true>>(
                 grid_layout,
                 fields.sd.at("evisc")->fld_g.view(),
+                fields.mp.at("u")->fld_g,
+                fields.mp.at("v")->fld_g,
+                fields.mp.at("w")->fld_g,
+                dudz_g, dvdz_g,
                 tmp1->fld_g, dbdz_g,
                 mlen_g, z0m_g, gd.z_g,
+                gd.dzi_g, gd.dzhi_g,
+                gd.dxi, gd.dyi,
                 tPri);
 
             fields.release_tmp_g(tmp1);
@@ -166,20 +173,20 @@ void Diff_smag2<TF>::exec_viscosity(Stats<TF>&, Thermo<TF>& thermo)
     // Do not use surface model.
     else
     {
-        // Calculate total strain rate
-        launch_grid_kernel<Diff_les_kernels::calc_strain2_g<TF, false>>(
-            grid_layout,
-            fields.sd.at("evisc")->fld_g.view(),
-            fields.mp.at("u")->fld_g,
-            fields.mp.at("v")->fld_g,
-            fields.mp.at("w")->fld_g,
-            nullptr, nullptr,
-            gd.dzi_g, gd.dzhi_g,
-            gd.dxi, gd.dyi);
-
         // start with retrieving the stability information
         if (thermo.get_switch() == Thermo_type::Disabled)
         {
+            // Calculate total strain rate
+            launch_grid_kernel<Diff_les_kernels::calc_strain2_g<TF, false>>(
+                grid_layout,
+                fields.sd.at("evisc")->fld_g.view(),
+                fields.mp.at("u")->fld_g,
+                fields.mp.at("v")->fld_g,
+                fields.mp.at("w")->fld_g,
+                nullptr, nullptr,
+                gd.dzi_g, gd.dzhi_g,
+                gd.dxi, gd.dyi);
+
             Diff_smag2_kernels::evisc_neutral_vandriest_g<TF><<<gridGPU, blockGPU>>>(
                 fields.sd.at("evisc")->fld_g,
                 fields.mp.at("u")->fld_g,
@@ -200,14 +207,20 @@ void Diff_smag2<TF>::exec_viscosity(Stats<TF>&, Thermo<TF>& thermo)
             // As we only use the fluxbot field of tmp1 we store the N2 in the interior.
             thermo.get_thermo_field_g(*tmp1, "N2", false);
 
-            // Calculate eddy viscosity
+            // Calculate the strain rate and eddy viscosity in one pass.
             TF tPri = 1./tPr;
 
-            launch_grid_kernel<Diff_smag2_kernels::evisc_g<TF, true>>(
+            launch_grid_kernel<Diff_smag2_kernels::evisc_g<TF, false>>(
                 grid_layout,
                 fields.sd.at("evisc")->fld_g.view(),
+                fields.mp.at("u")->fld_g,
+                fields.mp.at("v")->fld_g,
+                fields.mp.at("w")->fld_g,
+                nullptr, nullptr,
                 tmp1->fld_g, nullptr,
                 mlen_g, nullptr, gd.z_g,
+                gd.dzi_g, gd.dzhi_g,
+                gd.dxi, gd.dyi,
                 tPri);
 
             fields.release_tmp_g(tmp1);
@@ -245,90 +258,102 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
     const TF dyidyi = TF(1)/(gd.dy * gd.dy);
     const TF tPri = TF(1)/tPr;
 
-    // Do not use surface model.
-    if (boundary.get_switch() == "default")
+    // The tendencies of the individual fields are independent, such that they can be
+    // computed concurrently on the streams of the pool.
     {
-        launch_grid_kernel<Diff_les_kernels::diff_uvw_g<TF, false>>(
-                grid_layout,
-                fields.mt.at("u")->fld_g.view(),
-                fields.mt.at("v")->fld_g.view(),
-                fields.mt.at("w")->fld_g.view(),
-                fields.sd.at("evisc")->fld_g,
-                fields.mp.at("u")->fld_g,
-                fields.mp.at("v")->fld_g,
-                fields.mp.at("w")->fld_g,
-                fields.mp.at("u")->flux_bot_g,
-                fields.mp.at("u")->flux_top_g,
-                fields.mp.at("v")->flux_bot_g,
-                fields.mp.at("v")->flux_top_g,
-                gd.dzi_g, gd.dzhi_g,
-                gd.dxi, gd.dyi,
-                fields.rhoref_g, fields.rhorefh_g,
-                fields.rhorefi_g, fields.rhorefhi_g,
-                fields.visc);
+        Cuda_streams streams;
+        int branch = 1;
 
-        cuda_check_error();
-
-        for (auto it : fields.st)
+        // Do not use surface model.
+        if (boundary.get_switch() == "default")
         {
-            launch_grid_kernel<Diff_les_kernels::diff_c_g<TF, false>>(
+            streams.select(0);
+            launch_grid_kernel<Diff_les_kernels::diff_uvw_g<TF, false>>(
                     grid_layout,
-                    it.second->fld_g.view(),
-                    fields.sp.at(it.first)->fld_g,
+                    fields.mt.at("u")->fld_g.view(),
+                    fields.mt.at("v")->fld_g.view(),
+                    fields.mt.at("w")->fld_g.view(),
                     fields.sd.at("evisc")->fld_g,
-                    fields.sp.at(it.first)->flux_bot_g,
-                    fields.sp.at(it.first)->flux_top_g,
+                    fields.mp.at("u")->fld_g,
+                    fields.mp.at("v")->fld_g,
+                    fields.mp.at("w")->fld_g,
+                    fields.mp.at("u")->flux_bot_g,
+                    fields.mp.at("u")->flux_top_g,
+                    fields.mp.at("v")->flux_bot_g,
+                    fields.mp.at("v")->flux_top_g,
                     gd.dzi_g, gd.dzhi_g,
-                    dxidxi, dyidyi,
-                    fields.rhorefi_g, fields.rhorefh_g,
-                    tPri, fields.sp.at(it.first)->visc);
-
-            cuda_check_error();
-        }
-    }
-    // Use surface model.
-    else
-    {
-        launch_grid_kernel<Diff_les_kernels::diff_uvw_g<TF, true>>(
-                grid_layout,
-                fields.mt.at("u")->fld_g.view(),
-                fields.mt.at("v")->fld_g.view(),
-                fields.mt.at("w")->fld_g.view(),
-                fields.sd.at("evisc")->fld_g,
-                fields.mp.at("u")->fld_g,
-                fields.mp.at("v")->fld_g,
-                fields.mp.at("w")->fld_g,
-                fields.mp.at("u")->flux_bot_g,
-                fields.mp.at("u")->flux_top_g,
-                fields.mp.at("v")->flux_bot_g,
-                fields.mp.at("v")->flux_top_g,
-                gd.dzi_g, gd.dzhi_g,
-                gd.dxi, gd.dyi,
-                fields.rhoref_g, fields.rhorefh_g,
-                fields.rhorefi_g, fields.rhorefhi_g,
-                fields.visc);
+                    gd.dxi, gd.dyi,
+                    fields.rhoref_g, fields.rhorefh_g,
+                    fields.rhorefi_g, fields.rhorefhi_g,
+                    fields.visc);
 
             cuda_check_error();
 
-        for (auto it : fields.st)
+            for (auto it : fields.st)
+            {
+                streams.select(branch++);
+                launch_grid_kernel<Diff_les_kernels::diff_c_g<TF, false>>(
+                        grid_layout,
+                        it.second->fld_g.view(),
+                        fields.sp.at(it.first)->fld_g,
+                        fields.sd.at("evisc")->fld_g,
+                        fields.sp.at(it.first)->flux_bot_g,
+                        fields.sp.at(it.first)->flux_top_g,
+                        gd.dzi_g, gd.dzhi_g,
+                        dxidxi, dyidyi,
+                        fields.rhorefi_g, fields.rhorefh_g,
+                        tPri, fields.sp.at(it.first)->visc);
+
+                cuda_check_error();
+            }
+        }
+        // Use surface model.
+        else
         {
-            launch_grid_kernel<Diff_les_kernels::diff_c_g<TF, true>>(
+            streams.select(0);
+            launch_grid_kernel<Diff_les_kernels::diff_uvw_g<TF, true>>(
                     grid_layout,
-                    it.second->fld_g.view(),
-                    fields.sp.at(it.first)->fld_g,
+                    fields.mt.at("u")->fld_g.view(),
+                    fields.mt.at("v")->fld_g.view(),
+                    fields.mt.at("w")->fld_g.view(),
                     fields.sd.at("evisc")->fld_g,
-                    fields.sp.at(it.first)->flux_bot_g,
-                    fields.sp.at(it.first)->flux_top_g,
+                    fields.mp.at("u")->fld_g,
+                    fields.mp.at("v")->fld_g,
+                    fields.mp.at("w")->fld_g,
+                    fields.mp.at("u")->flux_bot_g,
+                    fields.mp.at("u")->flux_top_g,
+                    fields.mp.at("v")->flux_bot_g,
+                    fields.mp.at("v")->flux_top_g,
                     gd.dzi_g, gd.dzhi_g,
-                    dxidxi, dyidyi,
-                    fields.rhorefi_g, fields.rhorefh_g,
-                    tPri, fields.sp.at(it.first)->visc);
+                    gd.dxi, gd.dyi,
+                    fields.rhoref_g, fields.rhorefh_g,
+                    fields.rhorefi_g, fields.rhorefhi_g,
+                    fields.visc);
 
             cuda_check_error();
+
+            for (auto it : fields.st)
+            {
+                streams.select(branch++);
+                launch_grid_kernel<Diff_les_kernels::diff_c_g<TF, true>>(
+                        grid_layout,
+                        it.second->fld_g.view(),
+                        fields.sp.at(it.first)->fld_g,
+                        fields.sd.at("evisc")->fld_g,
+                        fields.sp.at(it.first)->flux_bot_g,
+                        fields.sp.at(it.first)->flux_top_g,
+                        gd.dzi_g, gd.dzhi_g,
+                        dxidxi, dyidyi,
+                        fields.rhorefi_g, fields.rhorefh_g,
+                        tPri, fields.sp.at(it.first)->visc);
+
+                cuda_check_error();
+            }
         }
     }
 
-    cudaDeviceSynchronize();
+    if (stats.is_doing_tendency())
+        cudaDeviceSynchronize();
     stats.calc_tend(*fields.mt.at("u"), tend_name);
     stats.calc_tend(*fields.mt.at("v"), tend_name);
     stats.calc_tend(*fields.mt.at("w"), tend_name);
@@ -285,10 +285,29 @@ Diff_smag2<TF>::Diff_smag2(Master& masterin, Grid<TF>& gridin, Fields<TF>& field
     // Set the switch for use of Mason's wall correction
     sw_mason = inputin.get_item<bool>("diff", "swmason", "", true);
 
+    // Set the switch for the implicit vertical diffusion, that removes the vertical grid spacing
+    // from the diffusion number. The horizontal diffusion stays explicit.
+    sw_implicit = inputin.get_item<bool>("diff", "swimplicit", "", false);
+
     fields.init_diagnostic_field("evisc", "Eddy viscosity", "m2 s-1", group_name, gd.sloc);
 
     if (grid.get_spatial_order() != Grid_order::Second)
         throw std::runtime_error("Diff_smag2 only runs with second order grids");
+
+    if (sw_implicit)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("swimplicit is not implemented on the GPU");
+        #endif
+
+        // The boundary fluxes stay explicit, which is only stable for the parametrized surface fluxes.
+        if (boundaryin.get_switch() == "default")
+            throw std::runtime_error("swimplicit does not support resolved walls");
+
+        // The implicit part would diffuse the slow scalars every time step.
+        if (fields.has_slow_scalars())
+            throw std::runtime_error("swimplicit cannot be combined with the slowlist of [fields]");
+    }
 }
 
 template<typename TF>
@@ -310,11 +329,11 @@ Diffusion_type Diff_smag2<TF>::get_switch() const
 
 #ifndef USECUDA
 template<typename TF>
-unsigned long Diff_smag2<TF>::get_time_limit(const unsigned long idt, const double dt)
+double Diff_smag2<TF>::get_dn_local(const double dt)
 {
     auto& gd = grid.get_grid_data();
 
-    double dnmul = dk::calc_dnmul<TF>(
+    const double dnmul_local = dk::calc_dnmul<TF>(
         fields.sd.at("evisc")->fld.data(),
         gd.dzi.data(),
         1./(gd.dx*gd.dx),
@@ -323,35 +342,33 @@ unsigned long Diff_smag2<TF>::get_time_limit(const unsigned long idt, const doub
         gd.istart, gd.iend,
         gd.jstart, gd.jend,
         gd.kstart, gd.kend,
-        gd.icells, gd.ijcells);
-    master.max(&dnmul, 1);
+        gd.icells, gd.ijcells,
+        sw_implicit);
 
-    // Avoid zero division.
-    dnmul = std::max(Constants::dsmall, dnmul);
-
-    return idt * dnmax / (dt * dnmul);
+    return dnmul_local*dt;
 }
-#endif
 
-#ifndef USECUDA
 template<typename TF>
 double Diff_smag2<TF>::get_dn(const double dt)
 {
-    auto& gd = grid.get_grid_data();
+    double dn = get_dn_local(dt);
+    master.max(&dn, 1);
+    return dn;
+}
 
-    double dnmul = dk::calc_dnmul<TF>(
-        fields.sd.at("evisc")->fld.data(),
-        gd.dzi.data(),
-        1./(gd.dx*gd.dx),
-        1./(gd.dy*gd.dy),
-        tPr,
-        gd.istart, gd.iend,
-        gd.jstart, gd.jend,
-        gd.kstart, gd.kend,
-        gd.icells, gd.ijcells);
-    master.max(&dnmul, 1);
+template<typename TF>
+unsigned long Diff_smag2<TF>::get_time_limit(const unsigned long idt, const double dt)
+{
+    return get_time_limit_from_dn(idt, dt, get_dn(dt));
+}
+
+template<typename TF>
+unsigned long Diff_smag2<TF>::get_time_limit_from_dn(const unsigned long idt, const double dt, const double dn)
+{
+    // Avoid zero division.
+    dnmul = std::max(Constants::dsmall, dn/dt);
 
-    return dnmul*dt;
+    return idt * dnmax / (dt * dnmul);
 }
 #endif
 
@@ -438,6 +455,10 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
 
         for (auto it : fields.st)
         {
+            if (fields.is_slow_skipped(it.first))
+                continue;
+
+            const auto box = fields.get_active_box(it.first);
             dk::diff_c<TF, surface_model>(
                     it.second->fld.data(),
                     fields.sp.at(it.first)->fld.data(),
@@ -450,9 +471,9 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                     fields.rhorefh.data(),
                     tPr,
                     fields.sp.at(it.first)->visc,
-                    gd.istart, gd.iend,
-                    gd.jstart, gd.jend,
-                    gd.kstart, gd.kend,
+                    box.istart, box.iend,
+                    box.jstart, box.jend,
+                    gd.kstart, box.kend,
                     gd.icells, gd.ijcells);
         }
     };
@@ -470,6 +491,105 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
         stats.calc_tend(*it.second, tend_name);
 }
 
+template<typename TF>
+void Diff_smag2<TF>::exec_implicit(const double subdt, Stats<TF>& stats)
+{
+    if (!sw_implicit)
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    const int ii = 1;
+    const int jj = gd.icells;
+    const int kk = gd.ijcells;
+
+    const TF dt = subdt;
+    const TF* const restrict evisc = fields.sd.at("evisc")->fld.data();
+    const TF* const restrict dzi = gd.dzi.data();
+    const TF* const restrict dzhi = gd.dzhi.data();
+    const TF* const restrict rhoref = fields.rhoref.data();
+    const TF* const restrict rhorefh = fields.rhorefh.data();
+    const TF visc = fields.visc;
+
+    // The surface fluxes are kept fixed, such that the coefficients vanish at the bottom and top face.
+    auto solve_u_v = [&](TF* const restrict at, const int ij_offset)
+    {
+        auto coef_bot = [&](const int ijk, const int k)
+        {
+            if (k == gd.kstart)
+                return TF(0.);
+            const TF eviscb = TF(0.25)*(evisc[ijk-ij_offset-kk] + evisc[ijk-kk] + evisc[ijk-ij_offset] + evisc[ijk]) + visc;
+            return dt * rhorefh[k] * eviscb * dzhi[k] * dzi[k] / rhoref[k];
+        };
+
+        auto coef_top = [&](const int ijk, const int k)
+        {
+            if (k == gd.kend-1)
+                return TF(0.);
+            const TF evisct = TF(0.25)*(evisc[ijk-ij_offset] + evisc[ijk] + evisc[ijk-ij_offset+kk] + evisc[ijk+kk]) + visc;
+            return dt * rhorefh[k+1] * evisct * dzhi[k+1] * dzi[k] / rhoref[k];
+        };
+
+        dk::solve_implicit_vertical<TF>(
+                at, coef_bot, coef_top,
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                jj, kk);
+    };
+
+    solve_u_v(fields.mt.at("u")->fld.data(), ii);
+    solve_u_v(fields.mt.at("v")->fld.data(), jj);
+
+    // The vertical velocity is zero at the walls, which adds the coefficients of the walls to the diagonal.
+    auto coef_bot_w = [&](const int ijk, const int k)
+    {
+        return dt * TF(2.) * rhoref[k-1] * (evisc[ijk-kk] + visc) * dzi[k-1] * dzhi[k] / rhorefh[k];
+    };
+
+    auto coef_top_w = [&](const int ijk, const int k)
+    {
+        return dt * TF(2.) * rhoref[k] * (evisc[ijk] + visc) * dzi[k] * dzhi[k] / rhorefh[k];
+    };
+
+    dk::solve_implicit_vertical<TF>(
+            fields.mt.at("w")->fld.data(), coef_bot_w, coef_top_w,
+            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart+1, gd.kend,
+            jj, kk);
+
+    const TF tPr_i = TF(1.)/tPr;
+    for (auto& it : fields.st)
+    {
+        const TF svisc = fields.sp.at(it.first)->visc;
+
+        auto coef_bot_s = [&](const int ijk, const int k)
+        {
+            if (k == gd.kstart)
+                return TF(0.);
+            const TF eviscb = TF(0.5)*(evisc[ijk-kk] + evisc[ijk]) * tPr_i + svisc;
+            return dt * rhorefh[k] * eviscb * dzhi[k] * dzi[k] / rhoref[k];
+        };
+
+        auto coef_top_s = [&](const int ijk, const int k)
+        {
+            if (k == gd.kend-1)
+                return TF(0.);
+            const TF evisct = TF(0.5)*(evisc[ijk] + evisc[ijk+kk]) * tPr_i + svisc;
+            return dt * rhorefh[k+1] * evisct * dzhi[k+1] * dzi[k] / rhoref[k];
+        };
+
+        dk::solve_implicit_vertical<TF>(
+                it.second->fld.data(), coef_bot_s, coef_top_s,
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                jj, kk);
+    }
+
+    stats.calc_tend(*fields.mt.at("u"), tend_name_implicit);
+    stats.calc_tend(*fields.mt.at("v"), tend_name_implicit);
+    stats.calc_tend(*fields.mt.at("w"), tend_name_implicit);
+
+    for (auto it : fields.st)
+        stats.calc_tend(*it.second, tend_name_implicit);
+}
+
 template<typename TF>
 void Diff_smag2<TF>::exec_viscosity(Stats<TF>&, Thermo<TF>& thermo)
 {
@@ -622,6 +742,16 @@ void Diff_smag2<TF>::create_stats(Stats<TF>& stats)
 
         for (auto it : fields.st)
             stats.add_tendency(*it.second, "z", tend_name, tend_longname);
+
+        if (sw_implicit)
+        {
+            stats.add_tendency(*fields.mt.at("u"), "z", tend_name_implicit, tend_longname_implicit);
+            stats.add_tendency(*fields.mt.at("v"), "z", tend_name_implicit, tend_longname_implicit);
+            stats.add_tendency(*fields.mt.at("w"), "zh", tend_name_implicit, tend_longname_implicit);
+
+            for (auto it : fields.st)
+                stats.add_tendency(*it.second, "z", tend_name_implicit, tend_longname_implicit);
+        }
     }
 }
 
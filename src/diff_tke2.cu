@@ -39,6 +39,7 @@
 
 // Kernel Launcher
 #include "cuda_launcher.h"
+#include "cuda_streams.h"
 #include "diff_kl_kernels.cuh"
 #include "diff_tke2_kl_kernels.cuh"
 #include "cuda_buffer.h"
@@ -271,57 +272,67 @@ void Diff_tke2<TF>::exec(Stats<TF>& stats)
     // Dummy tPr value for `diff_c`.
     const TF tPr_i_dummy = 1;
 
-    launch_grid_kernel<Diff_les_kernels::diff_uvw_g<TF, true>>(
-            grid_layout,
-            fields.mt.at("u")->fld_g.view(),
-            fields.mt.at("v")->fld_g.view(),
-            fields.mt.at("w")->fld_g.view(),
-            fields.sd.at("evisc")->fld_g,
-            fields.mp.at("u")->fld_g,
-            fields.mp.at("v")->fld_g,
-            fields.mp.at("w")->fld_g,
-            fields.mp.at("u")->flux_bot_g,
-            fields.mp.at("u")->flux_top_g,
-            fields.mp.at("v")->flux_bot_g,
-            fields.mp.at("v")->flux_top_g,
-            gd.dzi_g, gd.dzhi_g, gd.dxi, gd.dyi,
-            fields.rhoref_g, fields.rhorefh_g,
-            fields.rhorefi_g, fields.rhorefhi_g,
-            fields.visc);
-
-    cuda_check_error();
-
-    for (auto it : fields.st)
+    // The tendencies of the individual fields are independent, such that they can be
+    // computed concurrently on the streams of the pool.
     {
-        cuda_vector<TF>* evisc_ptr;
+        Cuda_streams streams;
+        int branch = 1;
 
-        if (it.first == "sgstke")  // sgstke diffuses with eddy viscosity for momentum
-            evisc_ptr = &fields.sd.at("evisc")->fld_g;
-        else  // all other scalars, normally diffuse with eddy viscosity for heat/scalars
+        streams.select(0);
+        launch_grid_kernel<Diff_les_kernels::diff_uvw_g<TF, true>>(
+                grid_layout,
+                fields.mt.at("u")->fld_g.view(),
+                fields.mt.at("v")->fld_g.view(),
+                fields.mt.at("w")->fld_g.view(),
+                fields.sd.at("evisc")->fld_g,
+                fields.mp.at("u")->fld_g,
+                fields.mp.at("v")->fld_g,
+                fields.mp.at("w")->fld_g,
+                fields.mp.at("u")->flux_bot_g,
+                fields.mp.at("u")->flux_top_g,
+                fields.mp.at("v")->flux_bot_g,
+                fields.mp.at("v")->flux_top_g,
+                gd.dzi_g, gd.dzhi_g, gd.dxi, gd.dyi,
+                fields.rhoref_g, fields.rhorefh_g,
+                fields.rhorefi_g, fields.rhorefhi_g,
+                fields.visc);
+
+        cuda_check_error();
+
+        for (auto it : fields.st)
         {
-            if (!sw_buoy) // but not if there is no buoyancy (then eviscs not defined)
+            cuda_vector<TF>* evisc_ptr;
+
+            if (it.first == "sgstke")  // sgstke diffuses with eddy viscosity for momentum
                 evisc_ptr = &fields.sd.at("evisc")->fld_g;
-            else
-                evisc_ptr = &fields.sd.at("eviscs")->fld_g;
-        }
+            else  // all other scalars, normally diffuse with eddy viscosity for heat/scalars
+            {
+                if (!sw_buoy) // but not if there is no buoyancy (then eviscs not defined)
+                    evisc_ptr = &fields.sd.at("evisc")->fld_g;
+                else
+                    evisc_ptr = &fields.sd.at("eviscs")->fld_g;
+            }
 
-        launch_grid_kernel<Diff_les_kernels::diff_c_g<TF, true>>(
-                grid_layout,
-                it.second->fld_g.view(),
-                fields.sp.at(it.first)->fld_g,
-                *evisc_ptr,
-                fields.sp.at(it.first)->flux_bot_g,
-                fields.sp.at(it.first)->flux_top_g,
-                gd.dzi_g, gd.dzhi_g,
-                dxidxi, dyidyi,
-                fields.rhorefi_g,
-                fields.rhorefh_g,
-                tPr_i_dummy,
-                fields.sp.at(it.first)->visc);
+            streams.select(branch++);
+            launch_grid_kernel<Diff_les_kernels::diff_c_g<TF, true>>(
+                    grid_layout,
+                    it.second->fld_g.view(),
+                    fields.sp.at(it.first)->fld_g,
+                    *evisc_ptr,
+                    fields.sp.at(it.first)->flux_bot_g,
+                    fields.sp.at(it.first)->flux_top_g,
+                    gd.dzi_g, gd.dzhi_g,
+                    dxidxi, dyidyi,
+                    fields.rhorefi_g,
+                    fields.rhorefh_g,
+                    tPr_i_dummy,
+                    fields.sp.at(it.first)->visc);
+        }
+        cuda_check_error();
     }
-    cuda_check_error();
 
-    cudaDeviceSynchronize();
+    if (stats.is_doing_tendency())
+        cudaDeviceSynchronize();
     stats.calc_tend(*fields.mt.at("u"), tend_name);
     stats.calc_tend(*fields.mt.at("v"), tend_name);
     stats.calc_tend(*fields.mt.at("w"), tend_name);
@@ -366,18 +377,21 @@ void Diff_tke2<TF>::exec_viscosity(Stats<TF>& stats, Thermo<TF>& thermo)
     auto& dvdz_g  = boundary.get_dvdz_g();
     auto& z0m_g   = boundary.get_z0m_g();
 
-    auto str2_tmp = fields.get_tmp_g();
+    // The strain rate is shared through the fields, and only calculated once per substep.
+    bool str2_is_current;
+    auto str2_tmp = fields.get_substep_diagnostic("strain2", str2_is_current);
 
     // Calculate total strain rate
-    launch_grid_kernel<Diff_les_kernels::calc_strain2_g<TF, true>>(
-            grid_layout,
-            str2_tmp->fld_g.view(),
-            fields.mp.at("u")->fld_g,
-            fields.mp.at("v")->fld_g,
-            fields.mp.at("w")->fld_g,
-            dudz_g, dvdz_g,
-            gd.dzi_g, gd.dzhi_g,
-            gd.dxi, gd.dyi);
+    if (!str2_is_current)
+        launch_grid_kernel<Diff_les_kernels::calc_strain2_g<TF, true>>(
+                grid_layout,
+                str2_tmp->fld_g.view(),
+                fields.mp.at("u")->fld_g,
+                fields.mp.at("v")->fld_g,
+                fields.mp.at("w")->fld_g,
+                dudz_g, dvdz_g,
+                gd.dzi_g, gd.dzhi_g,
+                gd.dxi, gd.dyi);
 
     // Start with retrieving the stability information
     if (!sw_buoy)
@@ -430,6 +444,54 @@ void Diff_tke2<TF>::exec_viscosity(Stats<TF>& stats, Thermo<TF>& thermo)
                     gd.kstart, gd.kend,
                     gd.icells, gd.ijcells);
     }
+    else if (!stats.is_doing_tendency())
+    {
+        // Without the tendency statistics, the eddy viscosities and the
+        // SGS TKE tendency are computed in a single kernel.
+        auto buoy_tmp = fields.get_tmp_g();
+        thermo.get_thermo_field_g(*buoy_tmp, "N2", false);
+
+        auto& dbdz_g = boundary.get_dbdz_g();
+
+        if (sw_mason)
+            launch_grid_kernel<Diff_tke2_kernels::evisc_sgstke_tend_g<TF, true, true>>(
+                    grid_layout,
+                    fields.sd.at("evisc")->fld_g.view(),
+                    fields.sd.at("eviscs")->fld_g.view(),
+                    fields.st.at("sgstke")->fld_g.view(),
+                    fields.sp.at("sgstke")->fld_g,
+                    str2_tmp->fld_g,
+                    buoy_tmp->fld_g,
+                    dbdz_g,
+                    gd.z_g,
+                    z0m_g,
+                    mlen0_g,
+                    this->cn, this->cm,
+                    this->ch1, this->ch2,
+                    this->ce1, this->ce2);
+        else
+            launch_grid_kernel<Diff_tke2_kernels::evisc_sgstke_tend_g<TF, true, false>>(
+                    grid_layout,
+                    fields.sd.at("evisc")->fld_g.view(),
+                    fields.sd.at("eviscs")->fld_g.view(),
+                    fields.st.at("sgstke")->fld_g.view(),
+                    fields.sp.at("sgstke")->fld_g,
+                    str2_tmp->fld_g,
+                    buoy_tmp->fld_g,
+                    dbdz_g,
+                    gd.z_g,
+                    z0m_g,
+                    mlen0_g,
+                    this->cn, this->cm,
+                    this->ch1, this->ch2,
+                    this->ce1, this->ce2);
+
+        boundary_cyclic.exec_g(fields.sd.at("evisc")->fld_g);
+        boundary_cyclic.exec_g(fields.sd.at("eviscs")->fld_g);
+
+        fields.release_tmp_g(buoy_tmp);
+        return;
+    }
     else
     {
         // Assume buoyancy calculation is needed
@@ -544,9 +606,6 @@ void Diff_tke2<TF>::exec_viscosity(Stats<TF>& stats, Thermo<TF>& thermo)
 
     cudaDeviceSynchronize();
     stats.calc_tend(*fields.st.at("sgstke"), tend_name_shear);
-
-    // Release temporary fields
-    fields.release_tmp_g(str2_tmp);
 }
 
 template<typename TF>
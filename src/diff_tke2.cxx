@@ -58,6 +58,7 @@ namespace
         const int jj = icells;
         const int kk = ijcells;
 
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -331,6 +332,101 @@ namespace
         boundary_cyclic.exec(evisch);
     }
 
+    // Eddy viscosities of calc_evisc and calc_evisc_heat, and the buoyancy, dissipation and shear
+    // source terms of the SGS TKE, in a single pass over the domain. The expressions and the order of the
+    // additions to the tendency are those of the separate kernels, such that the results are identical.
+    template<typename TF, Surface_model surface_model, bool sw_mason>
+    void calc_evisc_sgstke_tend(
+            TF* const restrict evisc,
+            TF* const restrict evisch,
+            TF* const restrict at,
+            const TF* const restrict sgstke,
+            const TF* const restrict strain2,
+            const TF* const restrict N2,
+            const TF* const restrict bgradbot,
+            const TF* const restrict z,
+            const TF* const restrict dz,
+            const TF* const restrict z0m,
+            const TF dx, const TF dy,
+            const TF cn, const TF cm,
+            const TF ch1, const TF ch2,
+            const TF ce1, const TF ce2,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int icells, const int jcells, const int ijcells,
+            Boundary_cyclic<TF>& boundary_cyclic)
+    {
+        const int jj = icells;
+        const int kk = ijcells;
+
+        if (surface_model == Surface_model::Disabled)
+            throw std::runtime_error("Resolved wall not supported in Deardorff SGSm.");
+
+        constexpr int n_mason = 2;
+        const TF n_mason_diss = TF(2.);
+
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+        {
+            // Calculate geometric filter width, based on Deardorff (1980)
+            const TF mlen0 = std::pow(dx*dy*dz[k], TF(1./3.));
+
+            // The lowest level uses the surface buoyancy gradient.
+            const TF* const restrict N2k = (k == kstart) ? bgradbot : N2 + k*kk;
+
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ij = i + j*jj;
+                    const int ijk = i + j*jj + k*kk;
+                    const TF N2_ijk = N2k[ij];
+
+                    TF mlen = mlen0;
+                    if (N2_ijk > 0) // Only if stably stratified, adapt length scale
+                        mlen = cn * std::sqrt(sgstke[ijk] / N2_ijk);
+
+                    TF fac = std::min(mlen0, mlen);
+
+                    if constexpr (sw_mason) // Apply Mason's wall correction here
+                    {
+                        if constexpr (n_mason == 2)
+                            fac = std::sqrt(TF(1.) / ( TF(1.)/fm::pow2(fac) + TF(1.)/(fm::pow2(Constants::kappa<TF>*(z[k]+z0m[ij]))) ) );
+                        else
+                            fac = std::pow(TF(1.) / (TF(1.)/std::pow(fac, TF(n_mason)) + TF(1.)/
+                                        (std::pow(Constants::kappa<TF>*(z[k]+z0m[ij]), TF(n_mason)))), TF(1.)/TF(n_mason));
+                    }
+
+                    const TF evisc_ijk = cm * fac * std::sqrt(sgstke[ijk]);
+                    const TF evisch_ijk = (ch1 + ch2 * fac / mlen0 ) * evisc_ijk;
+
+                    // The dissipation evaluates its length scale as in sgstke_diss_tend.
+                    TF mlen_diss = mlen0;
+                    if (N2_ijk > 0)
+                        mlen_diss = cn * std::sqrt(sgstke[ijk]) / std::sqrt(N2_ijk);
+
+                    TF fac_diss = std::min(mlen0, mlen_diss);
+
+                    if constexpr (sw_mason)
+                        fac_diss = std::pow(TF(1.)/(TF(1.)/std::pow(fac_diss, n_mason_diss) + TF(1.)/
+                                    (std::pow(Constants::kappa<TF>*(z[k]+z0m[ij]), n_mason_diss))), TF(1.)/n_mason_diss);
+
+                    TF tend = at[ijk];
+                    tend -= evisch_ijk * N2_ijk;
+                    tend -= (ce1 + ce2 * fac_diss / mlen0 ) * std::pow(sgstke[ijk], TF(3./2.)) / fac_diss;
+                    tend += evisc_ijk * strain2[ijk];
+
+                    evisc[ijk] = evisc_ijk;
+                    evisch[ijk] = evisch_ijk;
+                    at[ijk] = tend;
+                }
+        }
+
+        boundary_cyclic.exec(evisc);
+        boundary_cyclic.exec(evisch);
+    }
+
     template <typename TF>
     void sgstke_shear_tend(
             TF* const restrict at,
@@ -342,6 +438,7 @@ namespace
             const int kstart, const int kend,
             const int jj, const int kk)
     {
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -380,6 +477,7 @@ namespace
                 at[ijk] -= evisch[ijk] * bgradbot[ij];
             }
 
+        #pragma omp parallel for
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -579,30 +677,14 @@ Diffusion_type Diff_tke2<TF>::get_switch() const
 template<typename TF>
 unsigned long Diff_tke2<TF>::get_time_limit(const unsigned long idt, const double dt)
 {
-    auto& gd = grid.get_grid_data();
-
-    const TF tPr_dummy = 1;
-
-    // When no buoyancy, use eddy viscosity for momentum.
-    TF* evisc = !sw_buoy
-        ? fields.sd.at("evisc")->fld.data()
-        : fields.sd.at("eviscs")->fld.data();
-
-    dnmul = dk::calc_dnmul<TF>(
-            evisc,
-            gd.dzi.data(),
-            1./(gd.dx*gd.dx),
-            1./(gd.dy*gd.dy),
-            tPr_dummy,
-            gd.istart, gd.iend,
-            gd.jstart, gd.jend,
-            gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
-
-    master.max(&dnmul, 1);
+    return get_time_limit_from_dn(idt, dt, get_dn(dt));
+}
 
+template<typename TF>
+unsigned long Diff_tke2<TF>::get_time_limit_from_dn(const unsigned long idt, const double dt, const double dn)
+{
     // Avoid zero division.
-    dnmul = std::max(Constants::dsmall, dnmul);
+    dnmul = std::max(Constants::dsmall, dn/dt);
 
     return idt * dnmax / (dt * dnmul);
 }
@@ -610,7 +692,7 @@ unsigned long Diff_tke2<TF>::get_time_limit(const unsigned long idt, const doubl
 
 #ifndef USECUDA
 template<typename TF>
-double Diff_tke2<TF>::get_dn(const double dt)
+double Diff_tke2<TF>::get_dn_local(const double dt)
 {
     auto& gd = grid.get_grid_data();
 
@@ -621,7 +703,7 @@ double Diff_tke2<TF>::get_dn(const double dt)
         ? fields.sd.at("evisc")->fld.data()
         : fields.sd.at("eviscs")->fld.data();
 
-    dnmul = dk::calc_dnmul<TF>(
+    const double dnmul_local = dk::calc_dnmul<TF>(
             evisc,
             gd.dzi.data(),
             1./(gd.dx*gd.dx),
@@ -632,9 +714,16 @@ double Diff_tke2<TF>::get_dn(const double dt)
             gd.kstart, gd.kend,
             gd.icells, gd.ijcells);
 
-    master.max(&dnmul, 1);
+    return dnmul_local*dt;
+}
 
-    return dnmul*dt;
+template<typename TF>
+double Diff_tke2<TF>::get_dn(const double dt)
+{
+    double dn = get_dn_local(dt);
+    master.max(&dn, 1);
+    dnmul = dn/dt;
+    return dn;
 }
 #endif
 
@@ -732,6 +821,9 @@ void Diff_tke2<TF>::exec(Stats<TF>& stats)
 
     for (auto it : fields.st)
     {
+        if (fields.is_slow_skipped(it.first))
+            continue;
+
         if( it.first == "sgstke" ) // sgstke diffuses with eddy viscosity for momentum
         {
             dk::diff_c<TF, Surface_model::Enabled>(
@@ -800,28 +892,32 @@ template<typename TF>
 void Diff_tke2<TF>::exec_viscosity(Stats<TF>& stats, Thermo<TF>& thermo)
 {
     auto& gd = grid.get_grid_data();
-    auto str2_tmp = fields.get_tmp();
+
+    // The strain rate is shared through the fields, and only calculated once per substep.
+    bool str2_is_current;
+    auto str2_tmp = fields.get_substep_diagnostic("strain2", str2_is_current);
 
     // Calculate strain rate using MO for velocity gradients lowest level.
     const std::vector<TF>& dudz = boundary.get_dudz();
     const std::vector<TF>& dvdz = boundary.get_dvdz();
     const std::vector<TF>& z0m = boundary.get_z0m();
 
-    dk::calc_strain2<TF, Surface_model::Enabled>(
-            str2_tmp->fld.data(),
-            fields.mp.at("u")->fld.data(),
-            fields.mp.at("v")->fld.data(),
-            fields.mp.at("w")->fld.data(),
-            dudz.data(),
-            dvdz.data(),
-            gd.z.data(),
-            gd.dzi.data(),
-            gd.dzhi.data(),
-            1./gd.dx, 1./gd.dy,
-            gd.istart, gd.iend,
-            gd.jstart, gd.jend,
-            gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    if (!str2_is_current)
+        dk::calc_strain2<TF, Surface_model::Enabled>(
+                str2_tmp->fld.data(),
+                fields.mp.at("u")->fld.data(),
+                fields.mp.at("v")->fld.data(),
+                fields.mp.at("w")->fld.data(),
+                dudz.data(),
+                dvdz.data(),
+                gd.z.data(),
+                gd.dzi.data(),
+                gd.dzhi.data(),
+                1./gd.dx, 1./gd.dy,
+                gd.istart, gd.iend,
+                gd.jstart, gd.jend,
+                gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
 
     // Start with retrieving the stability information
     if (!sw_buoy)
@@ -870,6 +966,45 @@ void Diff_tke2<TF>::exec_viscosity(Stats<TF>& stats, Thermo<TF>& thermo)
 
                 stats.calc_tend(*fields.st.at("sgstke"), tend_name_diss);
     }
+    else if (!stats.is_doing_tendency())
+    {
+        // Without the tendency statistics, the terms do not have to be sampled one by one,
+        // and the eddy viscosities and the SGS TKE tendency are computed in a single pass.
+        auto buoy_tmp = fields.get_tmp();
+        thermo.get_thermo_field(*buoy_tmp, "N2", false, false);
+        const std::vector<TF>& dbdz = boundary.get_dbdz();
+
+        auto fused_wrapper = [&]<Surface_model surface_model, bool sw_mason>()
+        {
+            calc_evisc_sgstke_tend<TF, surface_model, sw_mason>(
+                    fields.sd.at("evisc")->fld.data(),
+                    fields.sd.at("eviscs")->fld.data(),
+                    fields.st.at("sgstke")->fld.data(),
+                    fields.sp.at("sgstke")->fld.data(),
+                    str2_tmp->fld.data(),
+                    buoy_tmp->fld.data(),
+                    dbdz.data(),
+                    gd.z.data(), gd.dz.data(),
+                    z0m.data(),
+                    gd.dx, gd.dy,
+                    this->cn, this->cm,
+                    this->ch1, this->ch2,
+                    this->ce1, this->ce2,
+                    gd.istart, gd.iend,
+                    gd.jstart, gd.jend,
+                    gd.kstart, gd.kend,
+                    gd.icells, gd.jcells, gd.ijcells,
+                    boundary_cyclic);
+        };
+
+        if (sw_mason)
+            fused_wrapper.template operator()<Surface_model::Enabled, true>();
+        else
+            fused_wrapper.template operator()<Surface_model::Enabled, false>();
+
+        fields.release_tmp(buoy_tmp);
+        return;
+    }
     else
     {
         // Assume buoyancy calculation is needed
@@ -977,9 +1112,6 @@ void Diff_tke2<TF>::exec_viscosity(Stats<TF>& stats, Thermo<TF>& thermo)
             gd.icells, gd.ijcells);
 
     stats.calc_tend(*fields.st.at("sgstke"), tend_name_shear);
-
-    // Release temporary fields
-    fields.release_tmp(str2_tmp);
 }
 #endif
 
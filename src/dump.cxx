@@ -20,6 +20,7 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
@@ -28,24 +29,53 @@
 #include "fields.h"
 #include "dump.h"
 #include "timeloop.h"
+#include "netcdf_interface.h"
+#include "io_server.h"
 #include "constants.h"
 #include "defines.h"
 
 template<typename TF>
-Dump<TF>::Dump(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& inputin):
-    master(masterin), grid(gridin), fields(fieldsin),
+Dump<TF>::Dump(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Io_server& io_serverin, Input& inputin):
+    master(masterin), grid(gridin), fields(fieldsin), io_server(io_serverin),
     field3d_io(master, grid)
 {
     swdump = inputin.get_item<bool>("dump", "swdump", "", false);
+    swnetcdf = false;
+    swadios2 = false;
+    swsubset = false;
+    swfloat = false;
+    coarsen = 1;
+
+    #ifdef USEADIOS2
+    adios_iotime = -1;
+    #endif
 
     if (swdump)
     {
         // Get the time at which the dump sections are triggered.
         sampletime = inputin.get_item<double>("dump", "sampletime", "");
 
+        sampleoffset = inputin.get_item<double>("dump", "sampleoffset", "", 0.);
+
         // Get list of dump variables.
         dumplist = inputin.get_list<std::string>("dump", "dumplist", "", std::vector<std::string>());
-        
+
+        // Optionally spread the variables over nspread groups, which are written spreadtime apart,
+        // such that a long dump list does not have to be written at a single time step.
+        nspread = inputin.get_item<int>("dump", "nspread", "", 1);
+        if (nspread < 1)
+            throw std::runtime_error("The nspread in [dump] has to be at least one");
+        spreadtime = (nspread > 1) ? inputin.get_item<double>("dump", "spreadtime", "") : 0.;
+
+        for (size_t n=0; n<dumplist.size(); ++n)
+            spread_group.emplace(dumplist[n], n % nspread);
+
+        // Variables of which only the non-zero values are saved, such as cloud and rain fields.
+        sparselist = inputin.get_list<std::string>("dump", "sparselist", "", std::vector<std::string>());
+        for (auto& it : sparselist)
+            if (std::find(dumplist.begin(), dumplist.end(), it) == dumplist.end())
+                throw std::runtime_error("Sparse dump variable \"" + it + "\" is not in the dumplist");
+
         // Whether to do two consecutive dumps in time
         swdoubledump = inputin.get_item<bool>("dump", "swdoubledump", "", false);
         if (swdoubledump && sampletime != inputin.get_item<double>("time", "savetime", ""))
@@ -54,6 +84,72 @@ Dump<TF>::Dump(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input&
             throw std::runtime_error(msg);
         }
 
+        if (swdoubledump && nspread > 1)
+            throw std::runtime_error("Double dump cannot be spread over multiple times");
+
+        // Write the dumps directly to time-appended NetCDF files instead of binary files.
+        swnetcdf = inputin.get_item<bool>("dump", "swnetcdf", "", false);
+
+        // Write the dumps through ADIOS2, e.g. streamed to running analysis processes with SST.
+        swadios2 = inputin.get_item<bool>("dump", "swadios2", "", false);
+        if (swadios2)
+        {
+            #ifndef USEADIOS2
+            throw std::runtime_error("swadios2 requires a build with USEADIOS2");
+            #endif
+
+            adios2_engine = inputin.get_item<std::string>("dump", "adios2engine", "", "BP5");
+            adios2_name = inputin.get_item<std::string>("dump", "adios2name", "", "dump");
+            adios2_parameters = inputin.get_list<std::string>("dump", "adios2parameters", "", std::vector<std::string>());
+
+            if (swnetcdf)
+                throw std::runtime_error("swadios2 and swnetcdf cannot be combined");
+        }
+        else
+        {
+            inputin.flag_as_used("dump", "adios2engine", "");
+            inputin.flag_as_used("dump", "adios2name", "");
+            inputin.flag_as_used("dump", "adios2parameters", "");
+        }
+
+        if (!sparselist.empty() && (swnetcdf || swadios2))
+            throw std::runtime_error("Sparse dumps can only be saved as binary files");
+
+        // Optional compression of the dumps, which may be lossy within the given absolute error bound.
+        const int compresslevel = inputin.get_item<int>("dump", "compresslevel", "", 0);
+        const TF errorbound = inputin.get_item<TF>("dump", "errorbound", "", 0.);
+        field3d_io.set_compression(compresslevel, errorbound);
+
+        if (compresslevel > 0 && inputin.get_item<int>("master", "nioservers", "", 0) > 0)
+            throw std::runtime_error("Compressed dumps cannot be combined with I/O servers");
+
+        // Optionally save every block in a file of its own, next to a manifest with the name of the dump.
+        const bool swfileperrank = inputin.get_item<bool>("dump", "swfileperrank", "", false);
+        if (swfileperrank && (compresslevel > 0 || inputin.get_item<int>("master", "nioservers", "", 0) > 0))
+            throw std::runtime_error("File-per-rank dumps cannot be compressed or combined with I/O servers");
+        field3d_io.set_file_per_rank(swfileperrank);
+
+        // Optionally save only every stride-th point of a box of global interior indices, in single precision.
+        // Negative end indices are counted from the end of the domain.
+        subset.stride = inputin.get_item<int>("dump", "stride", "", 1);
+        subset.istart = inputin.get_item<int>("dump", "istart", "", 0);
+        subset.iend   = inputin.get_item<int>("dump", "iend"  , "", 0);
+        subset.jstart = inputin.get_item<int>("dump", "jstart", "", 0);
+        subset.jend   = inputin.get_item<int>("dump", "jend"  , "", 0);
+        subset.kstart = inputin.get_item<int>("dump", "kstart", "", 0);
+        subset.kend   = inputin.get_item<int>("dump", "kend"  , "", 0);
+        swfloat = inputin.get_item<bool>("dump", "swfloat", "", false);
+
+        // Optionally save the block averages over coarsen x coarsen columns instead of the full fields.
+        coarsen = inputin.get_item<int>("dump", "coarsen", "", 1);
+        if (coarsen < 1)
+            throw std::runtime_error("The coarsen factor in [dump] has to be at least one");
+
+        if (compresslevel > 0 && (swfloat || subset.stride > 1
+                    || subset.istart != 0 || subset.iend != 0 || subset.jstart != 0
+                    || subset.jend != 0 || subset.kstart != 0 || subset.kend != 0))
+            throw std::runtime_error("Compressed dumps cannot be strided, boxed or single precision");
+
         // Crash on empty list.
         if (dumplist.empty())
         {
@@ -65,6 +161,10 @@ Dump<TF>::Dump(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input&
     {
         inputin.flag_as_used("dump", "dumplist", "");
         inputin.flag_as_used("dump", "sampletime", "");
+        inputin.flag_as_used("dump", "sampleoffset", "");
+        inputin.flag_as_used("dump", "nspread", "");
+        inputin.flag_as_used("dump", "spreadtime", "");
+        inputin.flag_as_used("dump", "sparselist", "");
     }
 
 }
@@ -72,6 +172,13 @@ Dump<TF>::Dump(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input&
 template<typename TF>
 Dump<TF>::~Dump()
 {
+    #ifdef USEADIOS2
+    if (adios_engine)
+    {
+        flush();
+        adios_engine.Close();
+    }
+    #endif
 }
 
 template<typename TF>
@@ -81,6 +188,66 @@ void Dump<TF>::init()
         return;
 
     isampletime = convert_to_itime(sampletime);
+    isampleoffset = convert_to_itime(sampleoffset);
+    ispreadtime = convert_to_itime(spreadtime);
+    igroup = 0;
+
+    if (isampleoffset >= isampletime)
+        throw std::runtime_error("The sampleoffset in [dump] has to be smaller than the sampletime");
+
+    if (nspread > 1 && (ispreadtime == 0 || (nspread-1)*ispreadtime >= isampletime))
+        throw std::runtime_error("The nspread groups in [dump] have to be written within one sampletime");
+
+    // Resolve the end indices of the subset, which count from the end of the domain when not positive.
+    auto& gd = grid.get_grid_data();
+
+    if (subset.iend <= 0)
+        subset.iend += gd.itot;
+    if (subset.jend <= 0)
+        subset.jend += gd.jtot;
+    if (subset.kend <= 0)
+        subset.kend += gd.ktot;
+
+    if (subset.stride < 1
+            || subset.istart < 0 || subset.iend > gd.itot || subset.istart >= subset.iend
+            || subset.jstart < 0 || subset.jend > gd.jtot || subset.jstart >= subset.jend
+            || subset.kstart < 0 || subset.kend > gd.ktot || subset.kstart >= subset.kend)
+        throw std::runtime_error("Invalid stride or box in [dump]");
+
+    swsubset = swfloat || subset.stride > 1
+        || subset.istart > 0 || subset.iend < gd.itot
+        || subset.jstart > 0 || subset.jend < gd.jtot
+        || subset.kstart > 0 || subset.kend < gd.ktot;
+
+    if (swsubset && (swnetcdf || swadios2 || io_server.is_enabled()))
+        throw std::runtime_error("A strided, boxed or single precision dump can only be saved as binary file");
+
+    if (swadios2 && (coarsen > 1 || io_server.is_enabled() || field3d_io.has_compression()))
+        throw std::runtime_error("ADIOS2 dumps cannot be coarse-grained, compressed or combined with I/O servers");
+
+    if (!sparselist.empty() && (swsubset || coarsen > 1 || io_server.is_enabled()
+                || field3d_io.has_compression() || field3d_io.has_file_per_rank()))
+        throw std::runtime_error("Sparse dumps cannot be strided, boxed, coarse-grained, compressed, per rank or sent to I/O servers");
+
+    if (field3d_io.has_file_per_rank() && (swsubset || swnetcdf || swadios2 || coarsen > 1))
+        throw std::runtime_error("A file-per-rank dump can only be saved as binary file of the full domain");
+
+    if (coarsen > 1)
+    {
+        if (gd.imax % coarsen != 0 || gd.jmax % coarsen != 0)
+            throw std::runtime_error("The coarsen factor in [dump] has to divide imax and jmax");
+
+        if (swnetcdf || io_server.is_enabled() || field3d_io.has_compression()
+                || subset.stride > 1 || subset.istart > 0 || subset.iend < gd.itot
+                || subset.jstart > 0 || subset.jend < gd.jtot
+                || subset.kstart > 0 || subset.kend < gd.ktot)
+            throw std::runtime_error("A coarse-grained dump can only be saved as uncompressed binary file of the full domain");
+    }
+
+    #ifdef USEADIOS2
+    if (swadios2)
+        open_adios2();
+    #endif
 }
 
 template<typename TF>
@@ -101,7 +268,15 @@ unsigned long Dump<TF>::get_time_limit(unsigned long itime)
     if (!swdump)
         return Constants::ulhuge;
 
-    return isampletime - itime % isampletime;
+    if (nspread == 1)
+        return get_sample_time_limit(itime, isampletime, isampleoffset);
+
+    // Step to the next group within the sample, or to the first group of the next one.
+    const unsigned long iphase = isampletime - get_sample_time_limit(itime, isampletime, isampleoffset);
+    if (iphase < (nspread-1)*ispreadtime)
+        return ispreadtime - iphase % ispreadtime;
+    else
+        return isampletime - iphase;
 }
 
 template<typename TF>
@@ -110,10 +285,20 @@ bool Dump<TF>::do_dump(unsigned long itime, unsigned long idt)
     // Check if dump is enabled.
     if (!swdump)
         return false;
-    // Check if current time step is dump time.
-    if (itime % isampletime != 0)
+    // Check if current time step is dump time of one of the groups.
+    if (nspread > 1)
+    {
+        const unsigned long iphase = isampletime - get_sample_time_limit(itime, isampletime, isampleoffset);
+        if (iphase % ispreadtime != 0 || iphase / ispreadtime >= static_cast<unsigned long>(nspread))
+            return false;
+
+        igroup = iphase / ispreadtime;
+        return true;
+    }
+
+    if (!is_sample_time(itime, isampletime, isampleoffset))
     {
-        if (((itime + idt) % isampletime == 0) && swdoubledump)
+        if (is_sample_time(itime + idt, isampletime, isampleoffset) && swdoubledump)
             return true;
         else
             return false;
@@ -123,6 +308,12 @@ bool Dump<TF>::do_dump(unsigned long itime, unsigned long idt)
     return true;
 }
 
+template<typename TF>
+bool Dump<TF>::do_dump_var(const std::string& name) const
+{
+    return (nspread == 1) || (spread_group.at(name) == igroup);
+}
+
 template<typename TF>
 std::vector<std::string>& Dump<TF>::get_dumplist()
 {
@@ -132,17 +323,83 @@ std::vector<std::string>& Dump<TF>::get_dumplist()
 template<typename TF>
 void Dump<TF>::save_dump(TF* data, const std::string& varname, int iotime)
 {
+    if (swnetcdf)
+    {
+        save_dump_netcdf(data, varname, iotime);
+        return;
+    }
+
+    #ifdef USEADIOS2
+    if (swadios2)
+    {
+        save_dump_adios2(data, varname, iotime);
+        return;
+    }
+    #endif
+
     auto& gd = grid.get_grid_data();
     const double no_offset = 0.;
     char filename[256];
 
-    std::snprintf(filename, 256, "%s.%07d", varname.c_str(), iotime);
+    const bool sparse = std::find(sparselist.begin(), sparselist.end(), varname) != sparselist.end();
+    std::snprintf(filename, 256, sparse ? "%s.%07d.sparse" : "%s.%07d", varname.c_str(), iotime);
     std::ifstream infile(filename);
 
     if (infile.good())
     {
         master.print_message("%s already exists\n", filename);
     }
+    else if (sparse)
+    {
+        if (field3d_io.save_field3d_sparse(data, filename))
+        {
+            master.print_message("Saving \"%s\" ... FAILED\n", filename);
+            throw std::runtime_error("Writing error in dump");
+        }
+    }
+    else if (coarsen > 1)
+    {
+        if (field3d_io.save_field3d_coarse(data, filename, coarsen, swfloat))
+        {
+            master.print_message("Saving \"%s\" ... FAILED\n", filename);
+            throw std::runtime_error("Writing error in dump");
+        }
+    }
+    else if (swsubset)
+    {
+        if (field3d_io.save_field3d_subset(data, filename, subset, swfloat))
+        {
+            master.print_message("Saving \"%s\" ... FAILED\n", filename);
+            throw std::runtime_error("Writing error in dump");
+        }
+    }
+    else if (io_server.is_enabled())
+    {
+        // Pack the interior of the local block and ship it to an I/O server.
+        auto& md = master.get_MPI_data();
+        std::vector<TF> block_data(gd.imax*gd.jmax*gd.kmax);
+
+        for (int k=0; k<gd.kmax; ++k)
+            for (int j=0; j<gd.jmax; ++j)
+                #pragma ivdep
+                for (int i=0; i<gd.imax; ++i)
+                    block_data[i + j*gd.imax + k*gd.imax*gd.jmax] =
+                            data[i+gd.istart + (j+gd.jstart)*gd.icells + (k+gd.kstart)*gd.ijcells];
+
+        Io_block block;
+        block.ni_tot = gd.itot;
+        block.nj_tot = gd.jtot;
+        block.i0 = md.mpicoordx*gd.imax;
+        block.j0 = md.mpicoordy*gd.jmax;
+        block.k0 = 0;
+        block.ni = gd.imax;
+        block.nj = gd.jmax;
+        block.nk = gd.kmax;
+        block.itemsize = sizeof(TF);
+        block.nparts = md.npx*md.npy;
+
+        io_server.write_block(filename, block_data.data(), block);
+    }
     else
     {
 
@@ -164,6 +421,162 @@ void Dump<TF>::save_dump(TF* data, const std::string& varname, int iotime)
     }
 }
 
+template<typename TF>
+void Dump<TF>::flush()
+{
+    #ifdef USEADIOS2
+    // Only end a step that is open, the engine does not exist without swadios2.
+    if (swadios2 && adios_iotime >= 0)
+    {
+        adios_engine.EndStep();
+        adios_iotime = -1;
+    }
+    #endif
+}
+
+#ifdef USEADIOS2
+template<typename TF>
+void Dump<TF>::open_adios2()
+{
+    #ifdef USEMPI
+    adios = std::make_unique<adios2::ADIOS>(master.get_MPI_data().commxy);
+    #else
+    adios = std::make_unique<adios2::ADIOS>();
+    #endif
+
+    adios_io = adios->DeclareIO("dump");
+    adios_io.SetEngine(adios2_engine);
+
+    for (auto& parameter : adios2_parameters)
+    {
+        const size_t n = parameter.find('=');
+        if (n == std::string::npos || n == 0)
+            throw std::runtime_error("ADIOS2 parameter \"" + parameter + "\" in [dump] is not of the form key=value");
+
+        adios_io.SetParameter(parameter.substr(0, n), parameter.substr(n+1));
+    }
+
+    // Without a working stream, e.g. if the library lacks SST, the dumps go to a BP5 file.
+    const std::string name = adios2_name + ".bp";
+    try
+    {
+        adios_engine = adios_io.Open(name, adios2::Mode::Write);
+    }
+    catch (std::exception& e)
+    {
+        if (adios2_engine == "BP5")
+            throw;
+
+        master.print_warning("Cannot open ADIOS2 engine %s (%s), falling back to BP5\n", adios2_engine.c_str(), e.what());
+        adios_io.SetEngine("BP5");
+        adios_engine = adios_io.Open(name, adios2::Mode::Write);
+    }
+
+    adios_io.DefineVariable<int>("iotime");
+    adios_iotime = -1;
+}
+
+template<typename TF>
+void Dump<TF>::save_dump_adios2(TF* data, const std::string& varname, int iotime)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    if (iotime != adios_iotime)
+    {
+        flush();
+        adios_engine.BeginStep();
+        adios_iotime = iotime;
+
+        if (md.mpiid == 0)
+            adios_engine.Put(adios_io.InquireVariable<int>("iotime"), iotime, adios2::Mode::Sync);
+    }
+
+    // The global array is stored as (z, y, x), of which every process puts its interior block.
+    adios2::Variable<TF> var = adios_io.InquireVariable<TF>(varname);
+    if (!var)
+        var = adios_io.DefineVariable<TF>(
+                varname,
+                {size_t(gd.ktot), size_t(gd.jtot), size_t(gd.itot)},
+                {size_t(0), size_t(md.mpicoordy*gd.jmax), size_t(md.mpicoordx*gd.imax)},
+                {size_t(gd.kmax), size_t(gd.jmax), size_t(gd.imax)},
+                adios2::ConstantDims);
+
+    auto tmp = fields.get_tmp();
+
+    for (int k=0; k<gd.kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+                tmp->fld[i + j*gd.imax + k*gd.imax*gd.jmax] =
+                        data[i+gd.istart + (j+gd.jstart)*gd.icells + (k+gd.kstart)*gd.ijcells];
+
+    // Sync copies the block into ADIOS2, such that the tmp field can be released directly.
+    adios_engine.Put(var, tmp->fld.data(), adios2::Mode::Sync);
+
+    fields.release_tmp(tmp);
+}
+#endif
+
+template<typename TF>
+void Dump<TF>::save_dump_netcdf(TF* data, const std::string& varname, int iotime)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    // Create the file at the first dump of this run, named after the time of that dump.
+    auto it = nc_files.find(varname);
+    if (it == nc_files.end())
+    {
+        char filename[256];
+        std::snprintf(filename, 256, "%s.%07d.nc", varname.c_str(), iotime);
+        master.print_message("Creating \"%s\"\n", filename);
+
+        Dump_nc_file nc;
+        nc.file = std::make_unique<Netcdf_file>(master, filename, Netcdf_mode::Create, 0, true);
+
+        nc.file->add_dimension("time");
+        nc.file->add_dimension("z", gd.ktot);
+        nc.file->add_dimension("y", gd.jtot);
+        nc.file->add_dimension("x", gd.itot);
+
+        nc.iotime_var = std::make_unique<Netcdf_variable<int>>(
+                nc.file->template add_variable<int>("iotime", {"time"}));
+
+        // Chunk per process block, such that every process writes its own chunk.
+        nc.var = std::make_unique<Netcdf_variable<TF>>(
+                nc.file->template add_variable<TF>(varname, {"time", "z", "y", "x"}, {1, gd.ktot, gd.jmax, gd.imax}));
+
+        nc.nrecords = 0;
+
+        it = nc_files.emplace(varname, std::move(nc)).first;
+    }
+
+    Dump_nc_file& nc = it->second;
+
+    // Remove the ghost cells.
+    std::vector<TF> block(gd.imax*gd.jmax*gd.ktot);
+
+    for (int k=0; k<gd.ktot; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.istart + (j+gd.jstart)*gd.icells + (k+gd.kstart)*gd.ijcells;
+                const int ijkb = i + j*gd.imax + k*gd.imax*gd.jmax;
+                block[ijkb] = data[ijk];
+            }
+
+    nc.iotime_var->insert(iotime, {nc.nrecords});
+    nc.var->insert(
+            block,
+            {nc.nrecords, 0, md.mpicoordy*gd.jmax, md.mpicoordx*gd.imax},
+            {1, gd.ktot, gd.jmax, gd.imax});
+
+    nc.file->sync();
+    ++nc.nrecords;
+}
+
 
 #ifdef FLOAT_SINGLE
 template class Dump<float>;
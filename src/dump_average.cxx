@@ -0,0 +1,276 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "dump.h"
+#include "dump_average.h"
+#include "timeloop.h"
+#include "constants.h"
+#include "defines.h"
+
+namespace
+{
+    // Value of a field at the cell centre, averaged over the faces of its staggered location.
+    template<typename TF>
+    inline TF interp_to_centre(
+            const TF* const restrict fld, const std::array<int,3>& loc,
+            const int ijk, const int jj, const int kk)
+    {
+        TF sum = TF(0.);
+        for (int dk=0; dk<=loc[2]; ++dk)
+            for (int dj=0; dj<=loc[1]; ++dj)
+                for (int di=0; di<=loc[0]; ++di)
+                    sum += fld[ijk + di + dj*jj + dk*kk];
+
+        return sum / ((1+loc[0]) * (1+loc[1]) * (1+loc[2]));
+    }
+}
+
+template<typename TF>
+Dump_average<TF>::Dump_average(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& inputin) :
+    master(masterin), grid(gridin), fields(fieldsin)
+{
+    swdumpaverage = inputin.get_item<bool>("dumpaverage", "swdumpaverage", "", false);
+    nsamples = 0;
+
+    if (swdumpaverage)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("swdumpaverage is not implemented on the GPU");
+        #endif
+
+        sampletime = inputin.get_item<double>("dumpaverage", "sampletime", "");
+        avgtime = inputin.get_item<double>("dumpaverage", "avgtime", "");
+
+        names = inputin.get_list<std::string>("dumpaverage", "fields", "", std::vector<std::string>());
+
+        for (auto& pair : inputin.get_list<std::string>("dumpaverage", "covariances", "", std::vector<std::string>()))
+        {
+            const size_t n = pair.find('*');
+            if (n == std::string::npos || n == 0 || n == pair.size()-1)
+                throw std::runtime_error("Covariance \"" + pair + "\" in [dumpaverage] is not of the form name1*name2");
+
+            covariances.emplace_back(pair.substr(0, n), pair.substr(n+1));
+        }
+
+        if (names.empty() && covariances.empty())
+            throw std::runtime_error("Empty fields and covariances in [dumpaverage]");
+    }
+    else
+    {
+        inputin.flag_as_used("dumpaverage", "sampletime", "");
+        inputin.flag_as_used("dumpaverage", "avgtime", "");
+        inputin.flag_as_used("dumpaverage", "fields", "");
+        inputin.flag_as_used("dumpaverage", "covariances", "");
+    }
+}
+
+template<typename TF>
+Dump_average<TF>::~Dump_average()
+{
+}
+
+template<typename TF>
+void Dump_average<TF>::init()
+{
+    if (!swdumpaverage)
+        return;
+
+    isampletime = convert_to_itime(sampletime);
+    iavgtime = convert_to_itime(avgtime);
+
+    if (isampletime == 0 || iavgtime % isampletime != 0)
+        throw std::runtime_error("The avgtime in [dumpaverage] has to be a multiple of the sampletime");
+
+    auto& gd = grid.get_grid_data();
+
+    mean.assign(names.size(), std::vector<TF>(gd.ncells, TF(0.)));
+    m2  .assign(names.size(), std::vector<TF>(gd.ncells, TF(0.)));
+
+    cov_mean_a.assign(covariances.size(), std::vector<TF>(gd.ncells, TF(0.)));
+    cov_mean_b.assign(covariances.size(), std::vector<TF>(gd.ncells, TF(0.)));
+    cov_m2    .assign(covariances.size(), std::vector<TF>(gd.ncells, TF(0.)));
+}
+
+template<typename TF>
+void Dump_average<TF>::create(Timeloop<TF>& timeloop)
+{
+    if (!swdumpaverage)
+        return;
+
+    auto is_prognostic = [&](const std::string& name)
+    {
+        return fields.ap.find(name) != fields.ap.end();
+    };
+
+    for (auto& name : names)
+        if (!is_prognostic(name))
+            throw std::runtime_error("Field \"" + name + "\" in [dumpaverage] is not a prognostic field");
+
+    for (auto& pair : covariances)
+        if (!is_prognostic(pair.first) || !is_prognostic(pair.second))
+            throw std::runtime_error(
+                    "Covariance \"" + pair.first + "*" + pair.second + "\" in [dumpaverage] is not of prognostic fields");
+
+    // The running sums are not part of the restart files, such that an interval may not span a restart.
+    if (timeloop.get_isavetime() % iavgtime != 0)
+        throw std::runtime_error("The avgtime in [dumpaverage] has to divide the savetime");
+}
+
+template<typename TF>
+unsigned long Dump_average<TF>::get_time_limit(unsigned long itime)
+{
+    if (!swdumpaverage)
+        return Constants::ulhuge;
+
+    return isampletime - itime % isampletime;
+}
+
+template<typename TF>
+bool Dump_average<TF>::do_sample(unsigned long itime)
+{
+    if (!swdumpaverage)
+        return false;
+
+    return (itime % isampletime == 0);
+}
+
+template<typename TF>
+void Dump_average<TF>::exec(Dump<TF>& dump, unsigned long itime, int iotime)
+{
+    // A sample at the end of an interval opens the next one, such that every interval
+    // holds the samples in [start, end).
+    if (itime % iavgtime == 0 && nsamples > 0)
+    {
+        master.print_message("Saving field averages of %d samples\n", nsamples);
+        save(dump, iotime);
+        nsamples = 0;
+    }
+
+    add_sample();
+}
+
+template<typename TF>
+void Dump_average<TF>::add_sample()
+{
+    auto& gd = grid.get_grid_data();
+
+    const int jj = gd.icells;
+    const int kk = gd.ijcells;
+
+    ++nsamples;
+    const TF ni = TF(1.) / nsamples;
+
+    for (size_t n=0; n<names.size(); ++n)
+    {
+        const TF* const restrict fld = fields.ap.at(names[n])->fld.data();
+        TF* const restrict mean_n = mean[n].data();
+        TF* const restrict m2_n = m2[n].data();
+
+        #pragma omp parallel for
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                #pragma ivdep
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const TF delta = fld[ijk] - mean_n[ijk];
+                    mean_n[ijk] += delta * ni;
+                    m2_n[ijk] += delta * (fld[ijk] - mean_n[ijk]);
+                }
+    }
+
+    for (size_t n=0; n<covariances.size(); ++n)
+    {
+        const auto& fld_a = *fields.ap.at(covariances[n].first);
+        const auto& fld_b = *fields.ap.at(covariances[n].second);
+        TF* const restrict mean_a = cov_mean_a[n].data();
+        TF* const restrict mean_b = cov_mean_b[n].data();
+        TF* const restrict cov = cov_m2[n].data();
+
+        #pragma omp parallel for
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const TF a = interp_to_centre(fld_a.fld.data(), fld_a.loc, ijk, jj, kk);
+                    const TF b = interp_to_centre(fld_b.fld.data(), fld_b.loc, ijk, jj, kk);
+
+                    const TF delta_a = a - mean_a[ijk];
+                    mean_a[ijk] += delta_a * ni;
+                    mean_b[ijk] += (b - mean_b[ijk]) * ni;
+                    cov[ijk] += delta_a * (b - mean_b[ijk]);
+                }
+    }
+}
+
+template<typename TF>
+void Dump_average<TF>::save(Dump<TF>& dump, int iotime)
+{
+    auto& gd = grid.get_grid_data();
+    auto tmp = fields.get_tmp();
+
+    // The second moments are divided by the number of samples, which resets them for the next interval.
+    auto save_moment = [&](std::vector<TF>& m, const std::string& name)
+    {
+        const TF ni = TF(1.) / nsamples;
+        for (int n=0; n<gd.ncells; ++n)
+        {
+            tmp->fld[n] = m[n] * ni;
+            m[n] = TF(0.);
+        }
+
+        dump.save_dump(tmp->fld.data(), name, iotime);
+    };
+
+    for (size_t n=0; n<names.size(); ++n)
+    {
+        dump.save_dump(mean[n].data(), names[n] + "_mean", iotime);
+        save_moment(m2[n], names[n] + "_var");
+        std::fill(mean[n].begin(), mean[n].end(), TF(0.));
+    }
+
+    for (size_t n=0; n<covariances.size(); ++n)
+    {
+        save_moment(cov_m2[n], covariances[n].first + "_" + covariances[n].second + "_cov");
+        std::fill(cov_mean_a[n].begin(), cov_mean_a[n].end(), TF(0.));
+        std::fill(cov_mean_b[n].begin(), cov_mean_b[n].end(), TF(0.));
+    }
+
+    fields.release_tmp(tmp);
+
+    dump.flush();
+}
+
+
+#ifdef FLOAT_SINGLE
+template class Dump_average<float>;
+#else
+template class Dump_average<double>;
+#endif
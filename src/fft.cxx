@@ -20,20 +20,81 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "master.h"
 #include "grid.h"
 #include "fft.h"
+#include "input.h"
+
+namespace
+{
+    // Broadcasts the wisdom of the main process as a string, such that the other processes do not
+    // access the file system. Returns false on all processes if the main process has no wisdom.
+    bool broadcast_wisdom(Master& master, std::string& wisdom, const bool has_wisdom)
+    {
+        int nchars = has_wisdom ? static_cast<int>(wisdom.size()) : -1;
+        master.broadcast(&nchars, 1);
+
+        if (nchars < 0)
+            return false;
+
+        wisdom.resize(nchars);
+        master.broadcast(wisdom.data(), nchars);
+
+        return true;
+    }
+
+    bool read_wisdom(Master& master, const char* filename, std::string& wisdom)
+    {
+        bool has_wisdom = false;
+
+        if (master.get_mpiid() == 0)
+        {
+            std::ifstream file(filename, std::ios::binary);
+            if (file)
+            {
+                wisdom.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                has_wisdom = !file.bad();
+            }
+        }
+
+        return broadcast_wisdom(master, wisdom, has_wisdom);
+    }
+}
 
 
 template<typename TF>
-FFT<TF>::FFT(Master& masterin, Grid<TF>& gridin) :
+FFT<TF>::FFT(Master& masterin, Grid<TF>& gridin, Input& inputin) :
     master(masterin), grid(gridin),
     transpose(master, grid)
 {
     has_fftw_plan = false;
 
+    // Split the slabs in chunks to overlap the xy-transposes with the FFTs.
+    nfftchunks = inputin.get_item<int>("pres", "nfftchunks", "", 1);
+
+    // Time the possible numbers of chunks at the start of the run and keep the fastest.
+    swfftautotune = inputin.get_item<bool>("pres", "swfftautotune", "", false);
+
+    // The plans are measured when the FFTW plan is saved, and restored from the wisdom when loaded,
+    // such that the restarts remain bitwise identical.
+    const std::string planner = inputin.get_item<std::string>("pres", "fftplanner", "", "estimate");
+    if (planner == "estimate")
+        fftw_flags = FFTW_ESTIMATE;
+    else if (planner == "measure")
+        fftw_flags = FFTW_MEASURE;
+    else if (planner == "patient")
+        fftw_flags = FFTW_PATIENT;
+    else
+        throw std::runtime_error("Invalid option for \"fftplanner\"");
+
     // Initialize the pointers to zero.
     fftini  = nullptr;
     fftouti = nullptr;
@@ -53,7 +114,7 @@ void FFT<float>::init()
     fftinj  = fftwf_alloc_real(gd.jtot*gd.iblock);
     fftoutj = fftwf_alloc_real(gd.jtot*gd.iblock);
 
-    transpose.init();
+    transpose.init(nfftchunks);
 }
 #else
 template<>
@@ -66,7 +127,7 @@ void FFT<double>::init()
     fftinj  = fftw_alloc_real(gd.jtot*gd.iblock);
     fftoutj = fftw_alloc_real(gd.jtot*gd.iblock);
 
-    transpose.init();
+    transpose.init(nfftchunks);
 }
 #endif
 
@@ -124,7 +185,9 @@ void FFT<float>::load()
 
     master.print_message("Loading \"%s\" ... ", filename);
 
-    int n = fftwf_import_wisdom_from_filename(filename);
+    // Only the main process reads the file, the wisdom is broadcast to the others.
+    std::string wisdom;
+    int n = read_wisdom(master, filename, wisdom) ? fftwf_import_wisdom_from_string(wisdom.c_str()) : 0;
     if (n == 0)
     {
         master.print_message("FAILED\n");
@@ -145,18 +208,37 @@ void FFT<float>::load()
     fftwf_r2r_kind kindf[] = {FFTW_R2HC};
     fftwf_r2r_kind kindb[] = {FFTW_HC2R};
 
-    iplanff = fftwf_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
-            fftouti, ni, istride, idist, kindf, FFTW_ESTIMATE);
-    iplanbf = fftwf_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
-            fftouti, ni, istride, idist, kindb, FFTW_ESTIMATE);
-    jplanff = fftwf_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
-            fftoutj, nj, jstride, jdist, kindf, FFTW_ESTIMATE);
-    jplanbf = fftwf_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
-            fftoutj, nj, jstride, jdist, kindb, FFTW_ESTIMATE);
+    // Wisdom of a run with another decomposition does not cover the plans of this one. Rather
+    // than measuring them again, which can take minutes, the plans are estimated in that case.
+    unsigned int flags = (fftw_flags == FFTW_ESTIMATE) ? FFTW_ESTIMATE : (fftw_flags | FFTW_WISDOM_ONLY);
+    for (int attempt=0; attempt<2; ++attempt)
+    {
+        iplanff = fftwf_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
+                fftouti, ni, istride, idist, kindf, flags);
+        iplanbf = fftwf_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
+                fftouti, ni, istride, idist, kindb, flags);
+        jplanff = fftwf_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
+                fftoutj, nj, jstride, jdist, kindf, flags);
+        jplanbf = fftwf_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
+                fftoutj, nj, jstride, jdist, kindb, flags);
+
+        if (iplanff && iplanbf && jplanff && jplanbf)
+            break;
+
+        for (fftwf_plan* plan : {&iplanff, &iplanbf, &jplanff, &jplanbf})
+            if (*plan)
+                fftwf_destroy_plan(*plan);
+
+        master.print_warning("The FFTW plan does not match the decomposition, the plans are estimated\n");
+        flags = FFTW_ESTIMATE;
+    }
 
     has_fftw_plan = true;
 
     fftwf_forget_wisdom();
+
+    if (swfftautotune)
+        autotune();
 }
 #else
 template<>
@@ -170,7 +252,9 @@ void FFT<double>::load()
 
     master.print_message("Loading \"%s\" ... ", filename);
 
-    int n = fftw_import_wisdom_from_filename(filename);
+    // Only the main process reads the file, the wisdom is broadcast to the others.
+    std::string wisdom;
+    int n = read_wisdom(master, filename, wisdom) ? fftw_import_wisdom_from_string(wisdom.c_str()) : 0;
     if (n == 0)
     {
         master.print_message("FAILED\n");
@@ -191,18 +275,37 @@ void FFT<double>::load()
     fftw_r2r_kind kindf[] = {FFTW_R2HC};
     fftw_r2r_kind kindb[] = {FFTW_HC2R};
 
-    iplanf = fftw_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
-            fftouti, ni, istride, idist, kindf, FFTW_ESTIMATE);
-    iplanb = fftw_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
-            fftouti, ni, istride, idist, kindb, FFTW_ESTIMATE);
-    jplanf = fftw_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
-            fftoutj, nj, jstride, jdist, kindf, FFTW_ESTIMATE);
-    jplanb = fftw_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
-            fftoutj, nj, jstride, jdist, kindb, FFTW_ESTIMATE);
+    // Wisdom of a run with another decomposition does not cover the plans of this one. Rather
+    // than measuring them again, which can take minutes, the plans are estimated in that case.
+    unsigned int flags = (fftw_flags == FFTW_ESTIMATE) ? FFTW_ESTIMATE : (fftw_flags | FFTW_WISDOM_ONLY);
+    for (int attempt=0; attempt<2; ++attempt)
+    {
+        iplanf = fftw_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
+                fftouti, ni, istride, idist, kindf, flags);
+        iplanb = fftw_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
+                fftouti, ni, istride, idist, kindb, flags);
+        jplanf = fftw_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
+                fftoutj, nj, jstride, jdist, kindf, flags);
+        jplanb = fftw_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
+                fftoutj, nj, jstride, jdist, kindb, flags);
+
+        if (iplanf && iplanb && jplanf && jplanb)
+            break;
+
+        for (fftw_plan* plan : {&iplanf, &iplanb, &jplanf, &jplanb})
+            if (*plan)
+                fftw_destroy_plan(*plan);
+
+        master.print_warning("The FFTW plan does not match the decomposition, the plans are estimated\n");
+        flags = FFTW_ESTIMATE;
+    }
 
     has_fftw_plan = true;
 
     fftw_forget_wisdom();
+
+    if (swfftautotune)
+        autotune();
 }
 #endif
 
@@ -226,14 +329,52 @@ void FFT<float>::save()
     fftwf_r2r_kind kindf[] = {FFTW_R2HC};
     fftwf_r2r_kind kindb[] = {FFTW_HC2R};
 
-    iplanff = fftwf_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
-                                  fftouti, ni, istride, idist, kindf, FFTW_ESTIMATE);
-    iplanbf = fftwf_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
-                                  fftouti, ni, istride, idist, kindb, FFTW_ESTIMATE);
-    jplanff = fftwf_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
-                                  fftoutj, nj, jstride, jdist, kindf, FFTW_ESTIMATE);
-    jplanbf = fftwf_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
-                                  fftoutj, nj, jstride, jdist, kindb, FFTW_ESTIMATE);
+    auto make_plans = [&](const unsigned int flags)
+    {
+        iplanff = fftwf_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
+                fftouti, ni, istride, idist, kindf, flags);
+        iplanbf = fftwf_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
+                fftouti, ni, istride, idist, kindb, flags);
+        jplanff = fftwf_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
+                fftoutj, nj, jstride, jdist, kindf, flags);
+        jplanbf = fftwf_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
+                fftoutj, nj, jstride, jdist, kindb, flags);
+
+        return (iplanff && iplanbf && jplanff && jplanbf);
+    };
+
+    if (fftw_flags == FFTW_ESTIMATE)
+        make_plans(fftw_flags);
+    else
+    {
+        // All processes have the same transforms, so only the main process measures the plans
+        // and the others build theirs from its wisdom. This also makes the plans identical.
+        std::string wisdom;
+        if (master.get_mpiid() == 0)
+        {
+            make_plans(fftw_flags);
+
+            char* wisdom_c = fftwf_export_wisdom_to_string();
+            wisdom = wisdom_c;
+            fftwf_free(wisdom_c);
+        }
+
+        broadcast_wisdom(master, wisdom, true);
+
+        if (master.get_mpiid() != 0)
+        {
+            fftwf_import_wisdom_from_string(wisdom.c_str());
+
+            if (!make_plans(fftw_flags | FFTW_WISDOM_ONLY))
+            {
+                for (fftwf_plan* plan : {&iplanff, &iplanbf, &jplanff, &jplanbf})
+                    if (*plan)
+                        fftwf_destroy_plan(*plan);
+
+                make_plans(fftw_flags);
+            }
+        }
+    }
 
     has_fftw_plan = true;
 
@@ -279,14 +420,52 @@ void FFT<double>::save()
     fftw_r2r_kind kindf[] = {FFTW_R2HC};
     fftw_r2r_kind kindb[] = {FFTW_HC2R};
 
-    iplanf = fftw_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
-                                fftouti, ni, istride, idist, kindf, FFTW_ESTIMATE);
-    iplanb = fftw_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
-                                fftouti, ni, istride, idist, kindb, FFTW_ESTIMATE);
-    jplanf = fftw_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
-                                fftoutj, nj, jstride, jdist, kindf, FFTW_ESTIMATE);
-    jplanb = fftw_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
-                                fftoutj, nj, jstride, jdist, kindb, FFTW_ESTIMATE);
+    auto make_plans = [&](const unsigned int flags)
+    {
+        iplanf = fftw_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
+                fftouti, ni, istride, idist, kindf, flags);
+        iplanb = fftw_plan_many_r2r(rank, ni, gd.jmax, fftini, ni, istride, idist,
+                fftouti, ni, istride, idist, kindb, flags);
+        jplanf = fftw_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
+                fftoutj, nj, jstride, jdist, kindf, flags);
+        jplanb = fftw_plan_many_r2r(rank, nj, gd.iblock, fftinj, nj, jstride, jdist,
+                fftoutj, nj, jstride, jdist, kindb, flags);
+
+        return (iplanf && iplanb && jplanf && jplanb);
+    };
+
+    if (fftw_flags == FFTW_ESTIMATE)
+        make_plans(fftw_flags);
+    else
+    {
+        // All processes have the same transforms, so only the main process measures the plans
+        // and the others build theirs from its wisdom. This also makes the plans identical.
+        std::string wisdom;
+        if (master.get_mpiid() == 0)
+        {
+            make_plans(fftw_flags);
+
+            char* wisdom_c = fftw_export_wisdom_to_string();
+            wisdom = wisdom_c;
+            fftw_free(wisdom_c);
+        }
+
+        broadcast_wisdom(master, wisdom, true);
+
+        if (master.get_mpiid() != 0)
+        {
+            fftw_import_wisdom_from_string(wisdom.c_str());
+
+            if (!make_plans(fftw_flags | FFTW_WISDOM_ONLY))
+            {
+                for (fftw_plan* plan : {&iplanf, &iplanb, &jplanf, &jplanb})
+                    if (*plan)
+                        fftw_destroy_plan(*plan);
+
+                make_plans(fftw_flags);
+            }
+        }
+    }
 
     has_fftw_plan = true;
 
@@ -463,55 +642,73 @@ namespace
         // Transpose the pressure field.
         transpose.exec_zx(tmp1, data);
 
+        // With more than one chunk, the xy-transpose of a finished chunk is in flight
+        // while the FFTs of the next chunk are computed.
+        const int nchunks = transpose.get_nchunks();
+        const int kchunk = gd.kblock / nchunks;
+
         int kk = gd.itot*gd.jmax;
 
         // Process the fourier transforms slice by slice.
-        for (int k=0; k<gd.kblock; ++k)
+        for (int chunk=0; chunk<nchunks; ++chunk)
         {
-            #pragma ivdep
-            for (int n=0; n<gd.itot*gd.jmax; ++n)
+            for (int k=chunk*kchunk; k<(chunk+1)*kchunk; ++k)
             {
-                const int ij = n;
-                const int ijk = n + k*kk;
-                fftini[ij] = tmp1[ijk];
+                #pragma ivdep
+                for (int n=0; n<gd.itot*gd.jmax; ++n)
+                {
+                    const int ij = n;
+                    const int ijk = n + k*kk;
+                    fftini[ij] = tmp1[ijk];
+                }
+
+                fftw_execute_wrapper<TF>(iplanf, iplanff);
+
+                #pragma ivdep
+                for (int n=0; n<gd.itot*gd.jmax; ++n)
+                {
+                    const int ij = n;
+                    const int ijk = n + k*kk;
+                    tmp1[ijk] = fftouti[ij];
+                }
             }
 
-            fftw_execute_wrapper<TF>(iplanf, iplanff);
-
-            #pragma ivdep
-            for (int n=0; n<gd.itot*gd.jmax; ++n)
-            {
-                const int ij = n;
-                const int ijk = n + k*kk;
-                tmp1[ijk] = fftouti[ij];
-            }
+            if (nchunks > 1)
+                transpose.exec_xy_begin(data, tmp1, chunk);
         }
 
         // Transpose again.
-        transpose.exec_xy(data, tmp1);
+        if (nchunks == 1)
+            transpose.exec_xy(data, tmp1);
 
         kk = gd.iblock*gd.jtot;
 
         // Do the second fourier transform.
-        for (int k=0; k<gd.kblock; ++k)
+        for (int chunk=0; chunk<nchunks; ++chunk)
         {
-            #pragma ivdep
-            for (int n=0; n<gd.iblock*gd.jtot; ++n)
-            {
-                const int ij = n;
-                const int ijk = n + k*kk;
-                fftinj[ij] = data[ijk];
-            }
+            if (nchunks > 1)
+                transpose.exec_chunk_finish(chunk);
 
-            fftw_execute_wrapper<TF>(jplanf, jplanff);
-
-            #pragma ivdep
-            for (int n=0; n<gd.iblock*gd.jtot; ++n)
+            for (int k=chunk*kchunk; k<(chunk+1)*kchunk; ++k)
             {
-                const int ij = n;
-                const int ijk = n + k*kk;
-                // Shift to use p in pressure solver.
-                tmp1[ijk] = fftoutj[ij];
+                #pragma ivdep
+                for (int n=0; n<gd.iblock*gd.jtot; ++n)
+                {
+                    const int ij = n;
+                    const int ijk = n + k*kk;
+                    fftinj[ij] = data[ijk];
+                }
+
+                fftw_execute_wrapper<TF>(jplanf, jplanff);
+
+                #pragma ivdep
+                for (int n=0; n<gd.iblock*gd.jtot; ++n)
+                {
+                    const int ij = n;
+                    const int ijk = n + k*kk;
+                    // Shift to use p in pressure solver.
+                    tmp1[ijk] = fftoutj[ij];
+                }
             }
         }
 
@@ -530,55 +727,71 @@ namespace
         // Transpose back to y.
         transpose.exec_zy(tmp1, data);
 
+        const int nchunks = transpose.get_nchunks();
+        const int kchunk = gd.kblock / nchunks;
+
         int kk = gd.iblock*gd.jtot;
 
         // Transform the second transform back.
-        for (int k=0; k<gd.kblock; ++k)
+        for (int chunk=0; chunk<nchunks; ++chunk)
         {
-            #pragma ivdep
-            for (int n=0; n<gd.iblock*gd.jtot; ++n)
+            for (int k=chunk*kchunk; k<(chunk+1)*kchunk; ++k)
             {
-                const int ij = n;
-                const int ijk = n + k*kk;
-                fftinj[ij] = tmp1[ijk];
+                #pragma ivdep
+                for (int n=0; n<gd.iblock*gd.jtot; ++n)
+                {
+                    const int ij = n;
+                    const int ijk = n + k*kk;
+                    fftinj[ij] = tmp1[ijk];
+                }
+
+                fftw_execute_wrapper<TF>(jplanb, jplanbf);
+
+                #pragma ivdep
+                for (int n=0; n<gd.iblock*gd.jtot; ++n)
+                {
+                    const int ij = n;
+                    const int ijk = n + k*kk;
+                    data[ijk] = fftoutj[ij] / gd.jtot;
+                }
             }
 
-            fftw_execute_wrapper<TF>(jplanb, jplanbf);
-
-            #pragma ivdep
-            for (int n=0; n<gd.iblock*gd.jtot; ++n)
-            {
-                const int ij = n;
-                const int ijk = n + k*kk;
-                data[ijk] = fftoutj[ij] / gd.jtot;
-            }
+            if (nchunks > 1)
+                transpose.exec_yx_begin(tmp1, data, chunk);
         }
 
         // Transpose back to x.
-        transpose.exec_yx(tmp1, data);
+        if (nchunks == 1)
+            transpose.exec_yx(tmp1, data);
 
         kk = gd.itot*gd.jmax;
 
         // Transform the first transform back.
-        for (int k=0; k<gd.kblock; ++k)
+        for (int chunk=0; chunk<nchunks; ++chunk)
         {
-            #pragma ivdep
-            for (int n=0; n<gd.itot*gd.jmax; ++n)
-            {
-                const int ij = n;
-                const int ijk = n + k*kk;
-                fftini[ij] = tmp1[ijk];
-            }
-
-            fftw_execute_wrapper<TF>(iplanb, iplanbf);
+            if (nchunks > 1)
+                transpose.exec_chunk_finish(chunk);
 
-            #pragma ivdep
-            for (int n=0; n<gd.itot*gd.jmax; ++n)
+            for (int k=chunk*kchunk; k<(chunk+1)*kchunk; ++k)
             {
-                const int ij = n;
-                const int ijk = n + k*kk;
-                // swap array here to avoid unnecessary 3d loop
-                data[ijk] = fftouti[ij] / gd.itot;
+                #pragma ivdep
+                for (int n=0; n<gd.itot*gd.jmax; ++n)
+                {
+                    const int ij = n;
+                    const int ijk = n + k*kk;
+                    fftini[ij] = tmp1[ijk];
+                }
+
+                fftw_execute_wrapper<TF>(iplanb, iplanbf);
+
+                #pragma ivdep
+                for (int n=0; n<gd.itot*gd.jmax; ++n)
+                {
+                    const int ij = n;
+                    const int ijk = n + k*kk;
+                    // swap array here to avoid unnecessary 3d loop
+                    data[ijk] = fftouti[ij] / gd.itot;
+                }
             }
         }
 
@@ -588,6 +801,101 @@ namespace
     #endif
 }
 
+template<typename TF>
+void FFT<TF>::autotune()
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    // The chunks only pipeline the xy-transposes, which are absent without decomposition in y.
+    if (md.npy == 1)
+        return;
+
+    // The winner is cached per grid, decomposition and precision, to skip the tuning at restarts.
+    char filename[256];
+    std::snprintf(filename, 256, "fftautotune_%dx%dx%d_%dx%d_%s",
+            gd.itot, gd.jtot, gd.ktot, md.npx, md.npy, (sizeof(TF) == 4) ? "float" : "double");
+
+    int nchunks_best = 0;
+    if (master.get_mpiid() == 0)
+    {
+        std::FILE* pFile = std::fopen(filename, "r");
+        if (pFile != nullptr)
+        {
+            if (std::fscanf(pFile, "%d", &nchunks_best) != 1 || gd.kblock % std::max(nchunks_best, 1) != 0)
+                nchunks_best = 0;
+            std::fclose(pFile);
+        }
+    }
+    master.broadcast(&nchunks_best, 1);
+
+    if (nchunks_best > 0)
+    {
+        master.print_message("Using %d FFT chunks from \"%s\"\n", nchunks_best, filename);
+        nfftchunks = nchunks_best;
+        transpose.set_nchunks(nfftchunks);
+        return;
+    }
+
+    std::vector<TF> data(gd.ncells, TF(1.));
+    std::vector<TF> tmp(gd.ncells, TF(0.));
+
+    const int niter = 5;
+    const int max_chunks = 16;
+    double time_best = -1.;
+
+    for (int nchunks=1; nchunks<=std::min(gd.kblock, max_chunks); ++nchunks)
+    {
+        if (gd.kblock % nchunks != 0)
+            continue;
+
+        transpose.set_nchunks(nchunks);
+
+        // One warm up pass, after which the slowest process determines the time.
+        exec_forward(data.data(), tmp.data());
+        exec_backward(data.data(), tmp.data());
+
+        const double start = master.get_wall_clock_time();
+        for (int n=0; n<niter; ++n)
+        {
+            exec_forward(data.data(), tmp.data());
+            exec_backward(data.data(), tmp.data());
+        }
+        double time = (master.get_wall_clock_time() - start) / niter;
+        master.max(&time, 1);
+
+        master.print_message("FFT autotune: %2d chunks, %.4E s per forward and backward FFT\n", nchunks, time);
+
+        if (time_best < 0. || time < time_best)
+        {
+            time_best = time;
+            nchunks_best = nchunks;
+        }
+    }
+
+    nfftchunks = nchunks_best;
+    transpose.set_nchunks(nfftchunks);
+
+    master.print_message("Saving \"%s\" with %d FFT chunks ... ", filename, nfftchunks);
+
+    int nerror = 0;
+    if (master.get_mpiid() == 0)
+    {
+        std::FILE* pFile = std::fopen(filename, "w");
+        if (pFile == nullptr)
+            ++nerror;
+        else
+        {
+            std::fprintf(pFile, "%d\n", nfftchunks);
+            std::fclose(pFile);
+        }
+    }
+    master.sum(&nerror, 1);
+
+    // A failure to write the cache only costs a new tuning at the next start.
+    master.print_message(nerror ? "FAILED\n" : "OK\n");
+}
+
 template<typename TF>
 void FFT<TF>::exec_forward(TF* const restrict data, TF* const restrict tmp1)
 {
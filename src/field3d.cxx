@@ -23,11 +23,47 @@
 #include <cstdio>
 #include <iostream>
 #include <cmath>
+#include <cstdint>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include "master.h"
 #include "grid.h"
 #include "field3d.h"
 #include "defines.h"
 
+namespace
+{
+    // Ask the kernel to back the full pages of an allocation with transparent huge pages.
+    // This only has effect if the memory has not been touched yet.
+    void advise_huge_pages(void* const data, const std::size_t bytes)
+    {
+        #ifdef __linux__
+        const std::uintptr_t page = sysconf(_SC_PAGESIZE);
+        const std::uintptr_t begin = (reinterpret_cast<std::uintptr_t>(data) + page - 1) / page * page;
+        const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(data) + bytes) / page * page;
+
+        if (end > begin)
+            madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+        #endif
+    }
+
+    // Return the full pages of a zeroed allocation to the kernel. They read as zero afterwards,
+    // and are placed on the NUMA node of the thread that touches them first.
+    void release_pages(void* const data, const std::size_t bytes)
+    {
+        #ifdef __linux__
+        const std::uintptr_t page = sysconf(_SC_PAGESIZE);
+        const std::uintptr_t begin = (reinterpret_cast<std::uintptr_t>(data) + page - 1) / page * page;
+        const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(data) + bytes) / page * page;
+
+        if (end > begin)
+            madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+        #endif
+    }
+}
+
 template<typename TF>
 Field3d<TF>::Field3d(
         Master& masterin, Grid<TF>& gridin,
@@ -50,7 +86,7 @@ Field3d<TF>::~Field3d()
 }
 
 template<typename TF>
-int Field3d<TF>::init()
+int Field3d<TF>::init(const bool swhugepages)
 {
     const Grid_data<TF>& gd = grid.get_grid_data();
 
@@ -64,8 +100,14 @@ int Field3d<TF>::init()
     {
         total_memory_size += field_memory_size;
 
-        // Allocate all fields belonging to the 3d field
+        // Allocate all fields belonging to the 3d field. The 3d field is reserved first,
+        // such that huge pages can be requested before the zeroing touches the memory.
+        fld.reserve(gd.ncells);
+        if (swhugepages)
+            advise_huge_pages(fld.data(), fld.capacity()*sizeof(TF));
+
         fld     .resize(gd.ncells);
+        halo = {gd.ihalo, gd.jhalo};
         fld_bot .resize(gd.ijcells);
         fld_top .resize(gd.ijcells);
         fld_mean.resize(gd.kcells);
@@ -85,9 +127,16 @@ int Field3d<TF>::init()
     if (nerror)
         throw std::runtime_error("In Field3d::init");
 
-    // set all values to zero
-    for (int n=0; n<gd.ncells; ++n)
-        fld[n] = 0.;
+    // Set all values to zero. With multiple threads, the pages of the 3d field are touched
+    // per vertical level, which is how the threads of the kernels share out the work.
+    const int npthreads = master.get_npthreads();
+    if (npthreads > 1)
+        release_pages(fld.data(), fld.size()*sizeof(TF));
+
+    #pragma omp parallel for num_threads(npthreads)
+    for (int k=0; k<gd.kcells; ++k)
+        for (int n=k*gd.ijcells; n<(k+1)*gd.ijcells; ++n)
+            fld[n] = 0.;
 
     for (int n=0; n<gd.kcells; ++n)
         fld_mean[n] = 0.;
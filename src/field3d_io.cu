@@ -0,0 +1,144 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#if defined(USECUDA) && defined(USECUFILE)
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cufile.h>
+
+#include "master.h"
+#include "grid.h"
+#include "field3d_io.h"
+#include "tools.h"
+
+namespace
+{
+    // The cuFile driver is opened at the first save and stays open until the end of the run.
+    bool cufile_driver_open = false;
+
+    bool open_cufile_driver()
+    {
+        if (!cufile_driver_open)
+            cufile_driver_open = (cuFileDriverOpen().err == CU_FILE_SUCCESS);
+        return cufile_driver_open;
+    }
+
+    // Copy the interior of a field into a buffer in [k][j][i] order, as in the file-per-rank blocks.
+    template<typename TF> __global__
+    void pack_interior_g(
+            TF* const __restrict__ block, const TF* const __restrict__ data, const TF offset,
+            const int imax, const int jmax, const int kmax,
+            const int igc, const int jgc, const int kstart,
+            const int jj, const int kk)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y;
+        const int k = blockIdx.z;
+
+        if (i < imax && j < jmax && k < kmax)
+        {
+            const int ijk  = i+igc + (j+jgc)*jj + (k+kstart)*kk;
+            const int ijkb = i + j*imax + k*imax*jmax;
+            block[ijkb] = data[ijk] + offset;
+        }
+    }
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_device(
+        TF* const restrict data_g, TF* const restrict tmp_g,
+        const char* filename, const TF offset,
+        const int kstart, const int kend)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int kmax  = kend-kstart;
+    const int count = gd.imax*gd.jmax*kmax;
+    const size_t nbytes = count*sizeof(TF);
+
+    const int blocki = gd.ithread_block;
+    const int blockj = gd.jthread_block;
+    const int gridi  = gd.imax/blocki + (gd.imax%blocki > 0);
+    const int gridj  = gd.jmax/blockj + (gd.jmax%blockj > 0);
+
+    dim3 gridGPU (gridi, gridj, kmax);
+    dim3 blockGPU(blocki, blockj, 1);
+
+    pack_interior_g<TF><<<gridGPU, blockGPU>>>(
+            tmp_g, data_g, offset,
+            gd.imax, gd.jmax, kmax, gd.igc, gd.jgc, kstart,
+            gd.icells, gd.ijcells);
+    cuda_check_error();
+    cuda_safe_call(cudaDeviceSynchronize());
+
+    int nerror = 0;
+
+    char blockname[256];
+    std::snprintf(blockname, 256, "%s.%05d", filename, md.mpiid);
+
+    const double io_start = master.get_wall_clock_time();
+
+    // Without O_DIRECT, or on a file system without GPUDirect support, cuFile falls back
+    // to its compatibility mode, which bounces through host memory internally.
+    const int fd = open(blockname, O_CREAT | O_EXCL | O_WRONLY | O_DIRECT, 0644);
+
+    if (fd < 0 || !open_cufile_driver())
+        ++nerror;
+    else
+    {
+        CUfileDescr_t descr = {};
+        descr.handle.fd = fd;
+        descr.type = CU_FILE_HANDLE_TYPE_OPAQUE_FD;
+
+        CUfileHandle_t handle;
+        if (cuFileHandleRegister(&handle, &descr).err != CU_FILE_SUCCESS)
+            ++nerror;
+        else
+        {
+            if (cuFileWrite(handle, tmp_g, nbytes, 0, 0) != static_cast<ssize_t>(nbytes))
+                ++nerror;
+            cuFileHandleDeregister(handle);
+        }
+    }
+
+    if (fd >= 0)
+        close(fd);
+
+    master.add_comm(Comm_site::Io, nbytes, 1, master.get_wall_clock_time() - io_start);
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        return 1;
+
+    return save_per_rank_manifest(filename, kmax);
+}
+
+
+#ifdef FLOAT_SINGLE
+template class Field3d_io<float>;
+#else
+template class Field3d_io<double>;
+#endif
+#endif
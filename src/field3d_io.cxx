@@ -21,8 +21,14 @@
  */
 
 #include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <string>
+#include <algorithm>
 #include "master.h"
 #include "grid.h"
 #include "field3d.h"
@@ -30,11 +36,110 @@
 #include "defines.h"
 #include "field3d_io.h"
 
+#ifdef USEZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+    // The aggregated restart file starts with the number of fields, followed by the name and
+    // the byte offset of each field. The header is padded, such that the fields are aligned.
+    const int restart_name_size = 64;
+    const int restart_header_align = 4096;
+
+    struct Restart_entry
+    {
+        char name[restart_name_size];
+        std::int64_t offset;
+    };
+
+    std::int64_t restart_header_size(const int nfields)
+    {
+        const std::int64_t size = sizeof(std::int64_t) + nfields*sizeof(Restart_entry);
+        return ((size + restart_header_align - 1) / restart_header_align) * restart_header_align;
+    }
+
+    template<typename TF>
+    std::vector<char> make_restart_header(
+            const std::vector<std::pair<std::string, TF*>>& fields, const std::int64_t field_size)
+    {
+        const std::int64_t nfields = fields.size();
+        const std::int64_t header_size = restart_header_size(nfields);
+
+        std::vector<char> header(header_size, 0);
+        std::memcpy(header.data(), &nfields, sizeof(std::int64_t));
+
+        for (int n=0; n<nfields; ++n)
+        {
+            Restart_entry entry = {};
+            std::strncpy(entry.name, fields[n].first.c_str(), restart_name_size-1);
+            entry.offset = header_size + n*field_size;
+            std::memcpy(header.data() + sizeof(std::int64_t) + n*sizeof(Restart_entry), &entry, sizeof(Restart_entry));
+        }
+
+        return header;
+    }
+
+    // Returns the byte offset of the field with the given name, or -1 if it is not in the file.
+    std::int64_t find_restart_offset(const std::vector<Restart_entry>& entries, const std::string& name)
+    {
+        for (auto& entry : entries)
+            if (name == entry.name)
+                return entry.offset;
+        return -1;
+    }
+}
+
 template<typename TF>
 Field3d_io<TF>::Field3d_io(Master& masterin, Grid<TF>& gridin) :
     master(masterin), grid(gridin)
 {
+    striping_factor = 0;
+    cb_nodes = 0;
+
+    compress_level = 0;
+    compress_error = 0;
+
+    file_per_rank = false;
+}
+
+template<typename TF>
+void Field3d_io<TF>::set_compression(const int level, const TF error_bound)
+{
+    #ifndef USEZSTD
+    if (level > 0)
+        throw std::runtime_error("Compressed 3D fields require a build with USEZSTD");
+    #endif
+
+    compress_level = level;
+    compress_error = error_bound;
+}
+
+template<typename TF>
+void Field3d_io<TF>::set_io_hints(const int striping_factor_in, const int cb_nodes_in)
+{
+    striping_factor = striping_factor_in;
+    cb_nodes = cb_nodes_in;
+}
+
+#ifdef USEMPI
+template<typename TF>
+MPI_Info Field3d_io<TF>::create_restart_info() const
+{
+    MPI_Info info;
+    MPI_Info_create(&info);
+    if (striping_factor > 0)
+        MPI_Info_set(info, "striping_factor", std::to_string(striping_factor).c_str());
+    if (cb_nodes > 0)
+    {
+        MPI_Info_set(info, "cb_nodes", std::to_string(cb_nodes).c_str());
+        MPI_Info_set(info, "romio_cb_read", "enable");
+        MPI_Info_set(info, "romio_cb_write", "enable");
+    }
+
+    return info;
 }
+#endif
 
 template<typename TF>
 Field3d_io<TF>::~Field3d_io()
@@ -48,6 +153,59 @@ namespace
     template<typename TF> MPI_Datatype mpi_fp_type();
     template<> MPI_Datatype mpi_fp_type<double>() { return MPI_DOUBLE; }
     template<> MPI_Datatype mpi_fp_type<float>() { return MPI_FLOAT; }
+
+    // A nonblocking collective read or write is only posted if the file is opened and the view is set
+    // on all processes, and only kept if it is posted on all of them, such that the call that completes
+    // it is made by either all processes or none. On a failure, the request is freed directly.
+    template<typename TF, typename Post>
+    int begin_request(Master& master, Field3d_io_request& req, const bool opened, Post&& post)
+    {
+        int nerror = opened ? 0 : 1;
+        master.sum(&nerror, 1);
+
+        if (!nerror)
+        {
+            char name[] = "native";
+            nerror = MPI_File_set_view(req.fh, 0, mpi_fp_type<TF>(), req.subarray, name, MPI_INFO_NULL) ? 1 : 0;
+            master.sum(&nerror, 1);
+        }
+
+        bool posted = false;
+        if (!nerror)
+        {
+            posted = (post() == MPI_SUCCESS);
+            nerror = posted ? 0 : 1;
+            master.sum(&nerror, 1);
+        }
+
+        if (nerror)
+        {
+            if (posted)
+                MPI_Wait(&req.request, MPI_STATUS_IGNORE);
+            if (opened)
+                MPI_File_close(&req.fh);
+            MPI_Type_free(&req.subarray);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // Completes a request of begin_request, of which the file and the type are freed on every path.
+    int end_request(Field3d_io_request& req)
+    {
+        int nerror = 0;
+
+        if (MPI_Wait(&req.request, MPI_STATUS_IGNORE))
+            ++nerror;
+
+        if (MPI_File_close(&req.fh))
+            ++nerror;
+
+        MPI_Type_free(&req.subarray);
+
+        return nerror;
+    }
 }
 
 template<typename TF>
@@ -57,6 +215,12 @@ int Field3d_io<TF>::save_field3d(
         const char* filename, const TF offset,
         const int kstart, const int kend)
 {
+    if (file_per_rank)
+        return save_field3d_per_rank(data, tmp1, filename, offset, kstart, kend);
+
+    if (compress_level > 0)
+        return save_field3d_compressed(data, tmp1, tmp2, filename, offset, kstart, kend);
+
     // Save the data in transposed order to have large chunks of contiguous disk space.
     // MPI-IO is not stable on Juqueen and Supermuc otherwise
     auto& gd = grid.get_grid_data();
@@ -120,6 +284,8 @@ int Field3d_io<TF>::save_field3d(
     if (MPI_File_set_view(fh, fileoff, mpi_fp_type<TF>(), subarray, name, MPI_INFO_NULL))
         return 1;
 
+    const double io_start = master.get_wall_clock_time();
+
     if (sw_transpose)
     {
         if (MPI_File_write_all(fh, tmp2, count, mpi_fp_type<TF>(), MPI_STATUS_IGNORE))
@@ -131,6 +297,8 @@ int Field3d_io<TF>::save_field3d(
             return 1;
     }
 
+    master.add_comm(Comm_site::Io, count*sizeof(TF), 1, master.get_wall_clock_time() - io_start);
+
     if (MPI_File_close(&fh))
         return 1;
 
@@ -140,183 +308,529 @@ int Field3d_io<TF>::save_field3d(
 }
 
 template<typename TF>
-int Field3d_io<TF>::load_field3d(
+int Field3d_io<TF>::save_field3d_begin(
         TF* const restrict data,
-        TF* const restrict tmp1, TF* const restrict tmp2,
-        const char* filename, TF offset,
-        const int kstart, const int kend)
+        TF* const restrict tmp1, TF* const restrict buffer,
+        const char* filename, const TF offset,
+        const int kstart, const int kend,
+        Field3d_io_request& req)
 {
-    // Read the data (optionally) in transposed order to have large chunks of contiguous disk space.
-    // MPI-IO is not stable on Juqueen and supermuc otherwise.
+    // Identical to save_field3d, but the data is written from a buffer of imax*jmax*kmax
+    // elements with a nonblocking collective write, such that the caller can continue.
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
-    auto tp = Transpose<TF>(master, grid);
-    tp.init();
 
-    MPI_Datatype subarray;   // MPI datatype containing the dimensions of the total array that is contained in one process.
-
-    const int kmax = kend-kstart;
+    const int jj    = gd.icells;
+    const int kk    = gd.icells*gd.jcells;
+    const int jjb   = gd.imax;
+    const int kkb   = gd.imax*gd.jmax;
+    const int kmax  = kend-kstart;
+    const int count = gd.imax*gd.jmax*kmax;
 
-    // For full 3D fields, use the transposed read to increase IO performance
     bool sw_transpose = (kmax == gd.kmax) ? true : false;
 
+    TF* const restrict pack = sw_transpose ? tmp1 : buffer;
+
+    for (int k=0; k<kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                const int ijkb = i + j*jjb + k*kkb;
+                pack[ijkb] = data[ijk] + offset;
+            }
+
     if (sw_transpose)
     {
-        // Create MPI datatype for reading transposed field
-        int totsize [3] = {gd.kmax  , gd.jtot, gd.itot};
+        auto tp = Transpose<TF>(master, grid);
+        tp.init();
+        tp.exec_zx(buffer, tmp1);
+
+        int totsize [3] = {gd.kmax,   gd.jtot, gd.itot};
         int subsize [3] = {gd.kblock, gd.jmax, gd.itot};
         int substart[3] = {md.mpicoordx*gd.kblock, md.mpicoordy*gd.jmax, 0};
-        MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &subarray);
-        MPI_Type_commit(&subarray);
+        MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &req.subarray);
+        MPI_Type_commit(&req.subarray);
     }
     else
     {
-        // Create MPI datatype for reading non-transposed field
         int totsize [3] = {kmax, gd.jtot, gd.itot};
         int subsize [3] = {kmax, gd.jmax, gd.imax};
         int substart[3] = {0, md.mpicoordy*gd.jmax, md.mpicoordx*gd.imax};
-        MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &subarray);
-        MPI_Type_commit(&subarray);
+        MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &req.subarray);
+        MPI_Type_commit(&req.subarray);
     }
 
-    // Read the file
-    MPI_File fh;
-    if (MPI_File_open(md.commxy, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh))
+    const bool opened = !MPI_File_open(
+            md.commxy, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_EXCL, MPI_INFO_NULL, &req.fh);
+
+    return begin_request<TF>(master, req, opened, [&]()
+    {
+        return MPI_File_iwrite_all(req.fh, buffer, count, mpi_fp_type<TF>(), &req.request);
+    });
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_end(Field3d_io_request& req)
+{
+    return (end_request(req) > 0);
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_field3d_begin(
+        TF* const restrict buffer, const char* filename,
+        const int kstart, const int kend,
+        Field3d_io_request& req)
+{
+    // Posts a nonblocking collective read of a full 3d field in the transposed order of
+    // save_field3d into a buffer of imax*jmax*kmax elements.
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    if (kend-kstart != gd.kmax)
         return 1;
 
-    // select noncontiguous part of 3d array to store the selected data
-    MPI_Offset fileoff = 0; // the offset within the file (header size)
-    char name[] = "native";
-    MPI_File_set_view(fh, fileoff, mpi_fp_type<TF>(), subarray, name, MPI_INFO_NULL);
+    int totsize [3] = {gd.kmax  , gd.jtot, gd.itot};
+    int subsize [3] = {gd.kblock, gd.jmax, gd.itot};
+    int substart[3] = {md.mpicoordx*gd.kblock, md.mpicoordy*gd.jmax, 0};
+    MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &req.subarray);
+    MPI_Type_commit(&req.subarray);
 
-    // extract the data from the 3d field without the ghost cells
-    int count = gd.imax*gd.jmax*kmax;
+    const bool opened = !MPI_File_open(md.commxy, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &req.fh);
 
-    if (sw_transpose)
-    {
-        if (MPI_File_read_all(fh, tmp1, count, mpi_fp_type<TF>(), MPI_STATUS_IGNORE))
-            return 1;
-    }
-    else
+    const int count = gd.imax*gd.jmax*gd.kmax;
+    return begin_request<TF>(master, req, opened, [&]()
     {
-        if (MPI_File_read_all(fh, tmp2, count, mpi_fp_type<TF>(), MPI_STATUS_IGNORE))
-            return 1;
-    }
+        return MPI_File_iread_all(req.fh, buffer, count, mpi_fp_type<TF>(), &req.request);
+    });
+}
 
-    if (MPI_File_close(&fh))
-        return 1;
+template<typename TF>
+int Field3d_io<TF>::load_field3d_end(
+        TF* const restrict data, TF* const restrict buffer, TF* const restrict tmp,
+        const TF offset, const int kstart, const int kend,
+        Field3d_io_request& req)
+{
+    auto& gd = grid.get_grid_data();
 
-    // Transpose the 3D field
-    if (sw_transpose)
-        tp.exec_xz(tmp2, tmp1);
+    // The transpose is collective, so it is made on all processes, also if the read failed on this one.
+    const int nerror = end_request(req);
+
+    auto tp = Transpose<TF>(master, grid);
+    tp.init();
+    tp.exec_xz(tmp, buffer);
+
+    if (nerror)
+        return 1;
 
     const int jj  = gd.icells;
     const int kk  = gd.icells*gd.jcells;
     const int jjb = gd.imax;
     const int kkb = gd.imax*gd.jmax;
 
-    for (int k=0; k<kmax; ++k)
+    for (int k=0; k<kend-kstart; ++k)
         for (int j=0; j<gd.jmax; ++j)
             #pragma ivdep
             for (int i=0; i<gd.imax; ++i)
             {
                 const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
                 const int ijkb = i + j*jjb + k*kkb;
-                data[ijk] = tmp2[ijkb] - offset;
+                data[ijk] = tmp[ijkb] - offset;
             }
 
-    MPI_Type_free(&subarray);
-
     return 0;
 }
 
 template<typename TF>
-int Field3d_io<TF>::save_xz_slice(
-        TF* const restrict data, TF const restrict data0, TF* const restrict tmp,
-        const char* filename, const int jslice,
-        const int kstart, const int kend)
+int Field3d_io<TF>::save_restart_file(
+        const std::vector<std::pair<std::string, TF*>>& fields,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const int kstart, const int kend)
 {
+    // All fields are written in the transposed order of save_field3d, at the offsets listed in the header.
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
+    auto tp = Transpose<TF>(master, grid);
+    tp.init();
+
+    const int jj    = gd.icells;
+    const int kk    = gd.icells*gd.jcells;
+    const int jjb   = gd.imax;
+    const int kkb   = gd.imax*gd.jmax;
+    const int kmax  = kend-kstart;
+    const int count = gd.imax*gd.jmax*kmax;
+
+    const std::int64_t field_size = static_cast<std::int64_t>(gd.itot)*gd.jtot*kmax*sizeof(TF);
+    std::vector<char> header = make_restart_header(fields, field_size);
+
+    MPI_Datatype subarray;
+    int totsize [3] = {gd.kmax,   gd.jtot, gd.itot};
+    int subsize [3] = {gd.kblock, gd.jmax, gd.itot};
+    int substart[3] = {md.mpicoordx*gd.kblock, md.mpicoordy*gd.jmax, 0};
+    MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &subarray);
+    MPI_Type_commit(&subarray);
+
+    // Pass the striping and collective buffering hints to the file system.
+    MPI_Info info = create_restart_info();
+
+    MPI_File fh;
+    const int err = MPI_File_open(md.commxy, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_EXCL, info, &fh);
+    MPI_Info_free(&info);
+    if (err)
+    {
+        MPI_Type_free(&subarray);
+        return 1;
+    }
 
+    // The errors are counted instead of returned, such that all processes take part in every
+    // collective call below, and the file and the type are freed on every path.
     int nerror = 0;
 
-    const int jj   = gd.icells;
-    const int kk   = gd.icells*gd.jcells;
-    const int kkb  = gd.imax;
-    const int kmax = kend-kstart;
+    if (md.mpiid == 0)
+    {
+        if (MPI_File_write_at(fh, 0, header.data(), header.size(), MPI_CHAR, MPI_STATUS_IGNORE))
+            ++nerror;
+    }
 
-    int count = gd.imax*kmax;
+    char name[] = "native";
 
-    if (md.mpicoordy == jslice/gd.jmax)
+    for (size_t n=0; n<fields.size(); ++n)
     {
-        for (int k=kstart; k<kend; k++)
-            #pragma ivdep
-            for (int i=0; i<gd.imax; i++)
-            {
-                // take the modulus of jslice and gd.jmax to have the right offset within proc
-                const int ijk  = i+gd.igc + ((jslice%gd.jmax)+gd.jgc)*jj + k*kk;
-                const int ijkb = i + (k-kstart)*kkb;
-                tmp[ijkb] = data[ijk] + data0;
-            }
+        const TF* const restrict data = fields[n].second;
+
+        for (int k=0; k<kmax; ++k)
+            for (int j=0; j<gd.jmax; ++j)
+                #pragma ivdep
+                for (int i=0; i<gd.imax; ++i)
+                {
+                    const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                    const int ijkb = i + j*jjb + k*kkb;
+                    tmp1[ijkb] = data[ijk];
+                }
 
-#ifdef DISABLE_2D_MPIIO
-//
-// NOTE: on GPFS (IBM Spectrum Scale) file systems, saving small bits of data from
-// each MPI task into a single binary using MPI-IO is **extremely** slow. With `DISABLE_2D_MPIIO`,
-// the 2D slices are first gathered on MPI rank 0, and then written without MPI-IO.
-//
-        // MPI task which gathers/writes the slice:
-        // const int mpi_rank_recv = md.mpicoordy * md.npx; // CvH: This is incorrect, because the subcommunicator starts at 0
-        // in each separately.
-        const int mpi_rank_recv = 0;
+        tp.exec_zx(tmp2, tmp1);
 
-        // Create send/receive MPI types.
-        MPI_Datatype send_type;
-        MPI_Type_vector(kmax, gd.imax, gd.imax, mpi_fp_type<TF>(), &send_type);
-        MPI_Type_commit(&send_type);
+        const MPI_Offset fileoff = header.size() + n*field_size;
+        if (MPI_File_set_view(fh, fileoff, mpi_fp_type<TF>(), subarray, name, MPI_INFO_NULL))
+            ++nerror;
 
-        MPI_Datatype recv_type;
-        int totxzsize_recv [2] = {kmax, gd.itot};
-        int subxzsize_recv [2] = {kmax, gd.imax};
-        int subxzstart_recv[2] = {0, md.mpicoordx*gd.imax};
-        MPI_Type_create_subarray(2, totxzsize_recv, subxzsize_recv, subxzstart_recv, MPI_ORDER_C, mpi_fp_type<TF>(), &recv_type);
-        MPI_Type_commit(&recv_type);
+        const double io_start = master.get_wall_clock_time();
 
-        MPI_Datatype recv_type_r;
-        MPI_Type_create_resized(recv_type, 0, sizeof(TF), &recv_type_r);
-        MPI_Type_commit(&recv_type_r);
+        if (MPI_File_write_all(fh, tmp2, count, mpi_fp_type<TF>(), MPI_STATUS_IGNORE))
+            ++nerror;
 
-        // Create size/offset arrays for MPI_Gatherv().
-        std::vector<int> counts(md.npx);
-        std::fill(counts.begin(), counts.end(), 1);
+        master.add_comm(Comm_site::Io, count*sizeof(TF), 1, master.get_wall_clock_time() - io_start);
+    }
 
-        std::vector<int> offset(md.npx);
-        for (int i=0; i<md.npx; ++i)
-            offset[i] = i*gd.imax;
+    if (MPI_File_close(&fh))
+        ++nerror;
 
-        // Gather the data!
-        std::vector<TF> recv;
-        if (md.mpicoordx == mpi_rank_recv)
-            recv.resize(gd.itot*gd.ktot);
+    MPI_Type_free(&subarray);
 
-        MPI_Gatherv(tmp, 1, send_type, recv.data(), counts.data(), offset.data(), recv_type_r, mpi_rank_recv, md.commx);
+    master.sum(&nerror, 1);
 
-        // Only MPI rank 0 writes the data.
-        if (md.mpicoordx == mpi_rank_recv)
-        {
-            FILE *pFile;
-            pFile = fopen(filename, "wbx");
-            if (pFile == NULL)
-                return 1;
+    return (nerror > 0);
+}
 
-            fwrite(recv.data(), sizeof(TF), gd.itot*kmax, pFile);
-            fclose(pFile);
-        }
-#else
-//
-// Use MPI-IO to write the data from different MPI tasks into a single file
-//
+template<typename TF>
+int Field3d_io<TF>::load_restart_file(
+        const std::vector<std::pair<std::string, TF*>>& fields,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const int kstart, const int kend)
+{
+    // Only the requested fields are read, in any order, using the offsets in the header.
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+    auto tp = Transpose<TF>(master, grid);
+    tp.init();
+
+    const int jj    = gd.icells;
+    const int kk    = gd.icells*gd.jcells;
+    const int jjb   = gd.imax;
+    const int kkb   = gd.imax*gd.jmax;
+    const int kmax  = kend-kstart;
+    const int count = gd.imax*gd.jmax*kmax;
+
+    // The file holds global arrays, such that it can be read with any decomposition. The collective
+    // buffering hints make the aggregators read contiguous blocks and redistribute them to the new layout.
+    MPI_Info info = create_restart_info();
+
+    MPI_File fh;
+    const int err = MPI_File_open(md.commxy, filename, MPI_MODE_RDONLY, info, &fh);
+    MPI_Info_free(&info);
+    if (err)
+        return 1;
+
+    // The errors are counted, such that all processes take part in every collective call below,
+    // and the file and the type are freed on every path.
+    int nerror = 0;
+
+    // Without a valid header, the processes agree to stop before the fields are read.
+    auto close_on_error = [&]()
+    {
+        master.sum(&nerror, 1);
+        if (nerror)
+            MPI_File_close(&fh);
+        return nerror > 0;
+    };
+
+    std::int64_t nfields;
+    if (MPI_File_read_at_all(fh, 0, &nfields, sizeof(std::int64_t), MPI_CHAR, MPI_STATUS_IGNORE))
+        ++nerror;
+
+    if (close_on_error())
+        return 1;
+
+    std::vector<Restart_entry> entries(nfields);
+    if (MPI_File_read_at_all(fh, sizeof(std::int64_t), entries.data(), nfields*sizeof(Restart_entry), MPI_CHAR, MPI_STATUS_IGNORE))
+        ++nerror;
+
+    if (close_on_error())
+        return 1;
+
+    MPI_Datatype subarray;
+    int totsize [3] = {gd.kmax  , gd.jtot, gd.itot};
+    int subsize [3] = {gd.kblock, gd.jmax, gd.itot};
+    int substart[3] = {md.mpicoordx*gd.kblock, md.mpicoordy*gd.jmax, 0};
+    MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &subarray);
+    MPI_Type_commit(&subarray);
+
+    char name[] = "native";
+
+    for (auto& field : fields)
+    {
+        // The header is the same on all processes, such that a missing field is skipped by all of them.
+        const MPI_Offset fileoff = find_restart_offset(entries, field.first);
+        if (fileoff < 0)
+        {
+            ++nerror;
+            continue;
+        }
+
+        if (MPI_File_set_view(fh, fileoff, mpi_fp_type<TF>(), subarray, name, MPI_INFO_NULL))
+            ++nerror;
+
+        const double io_start = master.get_wall_clock_time();
+
+        if (MPI_File_read_all(fh, tmp1, count, mpi_fp_type<TF>(), MPI_STATUS_IGNORE))
+            ++nerror;
+
+        master.add_comm(Comm_site::Io, count*sizeof(TF), 1, master.get_wall_clock_time() - io_start);
+
+        tp.exec_xz(tmp2, tmp1);
+
+        TF* const restrict data = field.second;
+
+        for (int k=0; k<kmax; ++k)
+            for (int j=0; j<gd.jmax; ++j)
+                #pragma ivdep
+                for (int i=0; i<gd.imax; ++i)
+                {
+                    const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                    const int ijkb = i + j*jjb + k*kkb;
+                    data[ijk] = tmp2[ijkb];
+                }
+    }
+
+    if (MPI_File_close(&fh))
+        ++nerror;
+
+    MPI_Type_free(&subarray);
+
+    master.sum(&nerror, 1);
+
+    return (nerror > 0);
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_field3d(
+        TF* const restrict data,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, TF offset,
+        const int kstart, const int kend)
+{
+    if (file_per_rank)
+        return load_field3d_per_rank(data, tmp1, filename, offset, kstart, kend);
+
+    if (compress_level > 0)
+        return load_field3d_compressed(data, tmp1, tmp2, filename, offset, kstart, kend);
+
+    // Read the data (optionally) in transposed order to have large chunks of contiguous disk space.
+    // MPI-IO is not stable on Juqueen and supermuc otherwise.
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+    auto tp = Transpose<TF>(master, grid);
+    tp.init();
+
+    MPI_Datatype subarray;   // MPI datatype containing the dimensions of the total array that is contained in one process.
+
+    const int kmax = kend-kstart;
+
+    // For full 3D fields, use the transposed read to increase IO performance
+    bool sw_transpose = (kmax == gd.kmax) ? true : false;
+
+    if (sw_transpose)
+    {
+        // Create MPI datatype for reading transposed field
+        int totsize [3] = {gd.kmax  , gd.jtot, gd.itot};
+        int subsize [3] = {gd.kblock, gd.jmax, gd.itot};
+        int substart[3] = {md.mpicoordx*gd.kblock, md.mpicoordy*gd.jmax, 0};
+        MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &subarray);
+        MPI_Type_commit(&subarray);
+    }
+    else
+    {
+        // Create MPI datatype for reading non-transposed field
+        int totsize [3] = {kmax, gd.jtot, gd.itot};
+        int subsize [3] = {kmax, gd.jmax, gd.imax};
+        int substart[3] = {0, md.mpicoordy*gd.jmax, md.mpicoordx*gd.imax};
+        MPI_Type_create_subarray(3, totsize, subsize, substart, MPI_ORDER_C, mpi_fp_type<TF>(), &subarray);
+        MPI_Type_commit(&subarray);
+    }
+
+    // Read the file
+    MPI_File fh;
+    if (MPI_File_open(md.commxy, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh))
+        return 1;
+
+    // select noncontiguous part of 3d array to store the selected data
+    MPI_Offset fileoff = 0; // the offset within the file (header size)
+    char name[] = "native";
+    MPI_File_set_view(fh, fileoff, mpi_fp_type<TF>(), subarray, name, MPI_INFO_NULL);
+
+    // extract the data from the 3d field without the ghost cells
+    int count = gd.imax*gd.jmax*kmax;
+
+    const double io_start = master.get_wall_clock_time();
+
+    if (sw_transpose)
+    {
+        if (MPI_File_read_all(fh, tmp1, count, mpi_fp_type<TF>(), MPI_STATUS_IGNORE))
+            return 1;
+    }
+    else
+    {
+        if (MPI_File_read_all(fh, tmp2, count, mpi_fp_type<TF>(), MPI_STATUS_IGNORE))
+            return 1;
+    }
+
+    master.add_comm(Comm_site::Io, count*sizeof(TF), 1, master.get_wall_clock_time() - io_start);
+
+    if (MPI_File_close(&fh))
+        return 1;
+
+    // Transpose the 3D field
+    if (sw_transpose)
+        tp.exec_xz(tmp2, tmp1);
+
+    const int jj  = gd.icells;
+    const int kk  = gd.icells*gd.jcells;
+    const int jjb = gd.imax;
+    const int kkb = gd.imax*gd.jmax;
+
+    for (int k=0; k<kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                const int ijkb = i + j*jjb + k*kkb;
+                data[ijk] = tmp2[ijkb] - offset;
+            }
+
+    MPI_Type_free(&subarray);
+
+    return 0;
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_xz_slice(
+        TF* const restrict data, TF const restrict data0, TF* const restrict tmp,
+        const char* filename, const int jslice,
+        const int kstart, const int kend)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    int nerror = 0;
+
+    const int jj   = gd.icells;
+    const int kk   = gd.icells*gd.jcells;
+    const int kkb  = gd.imax;
+    const int kmax = kend-kstart;
+
+    int count = gd.imax*kmax;
+
+    if (md.mpicoordy == jslice/gd.jmax)
+    {
+        for (int k=kstart; k<kend; k++)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; i++)
+            {
+                // take the modulus of jslice and gd.jmax to have the right offset within proc
+                const int ijk  = i+gd.igc + ((jslice%gd.jmax)+gd.jgc)*jj + k*kk;
+                const int ijkb = i + (k-kstart)*kkb;
+                tmp[ijkb] = data[ijk] + data0;
+            }
+
+#ifdef DISABLE_2D_MPIIO
+//
+// NOTE: on GPFS (IBM Spectrum Scale) file systems, saving small bits of data from
+// each MPI task into a single binary using MPI-IO is **extremely** slow. With `DISABLE_2D_MPIIO`,
+// the 2D slices are first gathered on MPI rank 0, and then written without MPI-IO.
+//
+        // MPI task which gathers/writes the slice:
+        // const int mpi_rank_recv = md.mpicoordy * md.npx; // CvH: This is incorrect, because the subcommunicator starts at 0
+        // in each separately.
+        const int mpi_rank_recv = 0;
+
+        // Create send/receive MPI types.
+        MPI_Datatype send_type;
+        MPI_Type_vector(kmax, gd.imax, gd.imax, mpi_fp_type<TF>(), &send_type);
+        MPI_Type_commit(&send_type);
+
+        MPI_Datatype recv_type;
+        int totxzsize_recv [2] = {kmax, gd.itot};
+        int subxzsize_recv [2] = {kmax, gd.imax};
+        int subxzstart_recv[2] = {0, md.mpicoordx*gd.imax};
+        MPI_Type_create_subarray(2, totxzsize_recv, subxzsize_recv, subxzstart_recv, MPI_ORDER_C, mpi_fp_type<TF>(), &recv_type);
+        MPI_Type_commit(&recv_type);
+
+        MPI_Datatype recv_type_r;
+        MPI_Type_create_resized(recv_type, 0, sizeof(TF), &recv_type_r);
+        MPI_Type_commit(&recv_type_r);
+
+        // Create size/offset arrays for MPI_Gatherv().
+        std::vector<int> counts(md.npx);
+        std::fill(counts.begin(), counts.end(), 1);
+
+        std::vector<int> offset(md.npx);
+        for (int i=0; i<md.npx; ++i)
+            offset[i] = i*gd.imax;
+
+        // Gather the data!
+        std::vector<TF> recv;
+        if (md.mpicoordx == mpi_rank_recv)
+            recv.resize(gd.itot*gd.ktot);
+
+        MPI_Gatherv(tmp, 1, send_type, recv.data(), counts.data(), offset.data(), recv_type_r, mpi_rank_recv, md.commx);
+
+        // Only MPI rank 0 writes the data.
+        if (md.mpicoordx == mpi_rank_recv)
+        {
+            FILE *pFile;
+            pFile = fopen(filename, "wbx");
+            if (pFile == NULL)
+                return 1;
+
+            fwrite(recv.data(), sizeof(TF), gd.itot*kmax, pFile);
+            fclose(pFile);
+        }
+#else
+//
+// Use MPI-IO to write the data from different MPI tasks into a single file
+//
         // Create MPI datatype for XZ-slice
         MPI_Datatype subxzslice;
         int totxzsize [2] = {kmax, gd.itot};
@@ -666,25 +1180,108 @@ int Field3d_io<TF>::load_xy_slice(
     return 0;
 }
 
-#else
-
 template<typename TF>
-int Field3d_io<TF>::save_field3d(
-        TF* const restrict data,
-        TF* const restrict tmp1, TF* const restrict tmp2,
-        const char* filename, const TF offset,
-        const int kstart, const int kend)
+int Field3d_io<TF>::load_xy_slice_begin(
+        TF* const restrict buffer, const char* filename,
+        Field3d_io_request& req)
 {
+    // Posts a nonblocking collective read of a xy-slice into a buffer of imax*jmax elements.
     auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
 
-    FILE *pFile;
-    pFile = fopen(filename, "wbx");
+    int totxysize [2] = {gd.jtot, gd.itot};
+    int subxysize [2] = {gd.jmax, gd.imax};
+    int subxystart[2] = {md.mpicoordy*gd.jmax, md.mpicoordx*gd.imax};
+    MPI_Type_create_subarray(2, totxysize, subxysize, subxystart, MPI_ORDER_C, mpi_fp_type<TF>(), &req.subarray);
+    MPI_Type_commit(&req.subarray);
 
-    if (pFile == NULL)
+    if (MPI_File_open(md.commxy, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &req.fh))
+    {
+        MPI_Type_free(&req.subarray);
         return 1;
+    }
 
-    const int jj = gd.icells;
-    const int kk = gd.icells*gd.jcells;
+    MPI_Offset fileoff = 0;
+    char name[] = "native";
+
+    // Without a posted read, load_xy_slice_end() is not called, such that the file and the type are freed here.
+    const int count = gd.imax*gd.jmax;
+    if (MPI_File_set_view(req.fh, fileoff, mpi_fp_type<TF>(), req.subarray, name, MPI_INFO_NULL)
+            || MPI_File_iread_all(req.fh, buffer, count, mpi_fp_type<TF>(), &req.request))
+    {
+        MPI_File_close(&req.fh);
+        MPI_Type_free(&req.subarray);
+        return 1;
+    }
+
+    return 0;
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_xy_slice_end(
+        TF* const restrict data, TF* const restrict buffer,
+        Field3d_io_request& req, int kslice)
+{
+    auto& gd = grid.get_grid_data();
+
+    int nerror = 0;
+
+    if (MPI_Wait(&req.request, MPI_STATUS_IGNORE))
+        ++nerror;
+
+    if (MPI_File_close(&req.fh))
+        ++nerror;
+
+    MPI_Type_free(&req.subarray);
+
+    if (nerror)
+        return 1;
+
+    // Subtract the ghost cells in case of a pure 2d plane that does not have ghost cells.
+    if (kslice == -1)
+        kslice = -gd.kgc;
+
+    const int jj  = gd.icells;
+    const int kk  = gd.icells*gd.jcells;
+    const int jjb = gd.imax;
+
+    for (int j=0; j<gd.jmax; j++)
+        #pragma ivdep
+        for (int i=0; i<gd.imax; i++)
+        {
+            const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (kslice+gd.kgc)*kk;
+            const int ijkb = i + j*jjb;
+            data[ijk] = buffer[ijkb];
+        }
+
+    return 0;
+}
+
+#else
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d(
+        TF* const restrict data,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const TF offset,
+        const int kstart, const int kend)
+{
+    if (file_per_rank)
+        return save_field3d_per_rank(data, tmp1, filename, offset, kstart, kend);
+
+    if (compress_level > 0)
+        return save_field3d_compressed(data, tmp1, tmp2, filename, offset, kstart, kend);
+
+    auto& gd = grid.get_grid_data();
+
+    FILE *pFile;
+    pFile = fopen(filename, "wbx");
+
+    if (pFile == NULL)
+        return 1;
+
+    const int jj = gd.icells;
+    const int kk = gd.icells*gd.jcells;
 
     // First, add the offset to the data
     for (int k=kstart; k<kend; ++k)
@@ -709,6 +1306,161 @@ int Field3d_io<TF>::save_field3d(
     return 0;
 }
 
+template<typename TF>
+int Field3d_io<TF>::save_field3d_begin(
+        TF* const restrict data,
+        TF* const restrict tmp1, TF* const restrict buffer,
+        const char* filename, const TF offset,
+        const int kstart, const int kend,
+        Field3d_io_request& req)
+{
+    // Without MPI there is no nonblocking write, so the field is saved directly.
+    return save_field3d(data, tmp1, buffer, filename, offset, kstart, kend);
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_end(Field3d_io_request& req)
+{
+    return 0;
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_field3d_begin(
+        TF* const restrict buffer, const char* filename,
+        const int kstart, const int kend,
+        Field3d_io_request& req)
+{
+    // Without MPI there is no nonblocking read, so the interior is read directly into the buffer.
+    auto& gd = grid.get_grid_data();
+
+    FILE *pFile;
+    pFile = fopen(filename, "rb");
+
+    if (pFile == NULL)
+        return 1;
+
+    const size_t count = static_cast<size_t>(gd.imax)*gd.jmax*(kend-kstart);
+    const size_t nread = fread(buffer, sizeof(TF), count, pFile);
+    fclose(pFile);
+
+    return (nread != count);
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_field3d_end(
+        TF* const restrict data, TF* const restrict buffer, TF* const restrict tmp,
+        const TF offset, const int kstart, const int kend,
+        Field3d_io_request& req)
+{
+    auto& gd = grid.get_grid_data();
+
+    const int jj  = gd.icells;
+    const int kk  = gd.icells*gd.jcells;
+    const int jjb = gd.imax;
+    const int kkb = gd.imax*gd.jmax;
+
+    for (int k=0; k<kend-kstart; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                const int ijkb = i + j*jjb + k*kkb;
+                data[ijk] = buffer[ijkb] - offset;
+            }
+
+    return 0;
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_restart_file(
+        const std::vector<std::pair<std::string, TF*>>& fields,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const int kstart, const int kend)
+{
+    auto& gd = grid.get_grid_data();
+
+    FILE *pFile;
+    pFile = fopen(filename, "wbx");
+
+    if (pFile == NULL)
+        return 1;
+
+    const int jj = gd.icells;
+    const int kk = gd.icells*gd.jcells;
+
+    const std::int64_t field_size = static_cast<std::int64_t>(gd.itot)*gd.jtot*(kend-kstart)*sizeof(TF);
+    std::vector<char> header = make_restart_header(fields, field_size);
+
+    if (fwrite(header.data(), 1, header.size(), pFile) != header.size())
+    {
+        fclose(pFile);
+        return 1;
+    }
+
+    // The fields follow the header directly, in the order of the index.
+    for (auto& field : fields)
+        for (int k=kstart; k<kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+            {
+                const int ijk = gd.istart + j*jj + k*kk;
+                if( fwrite(&field.second[ijk], sizeof(TF), gd.imax, pFile) != (unsigned)gd.imax)
+                {
+                    fclose(pFile);
+                    return 1;
+                }
+            }
+
+    fclose(pFile);
+
+    return 0;
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_restart_file(
+        const std::vector<std::pair<std::string, TF*>>& fields,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const int kstart, const int kend)
+{
+    auto& gd = grid.get_grid_data();
+
+    FILE *pFile;
+    pFile = fopen(filename, "rb");
+
+    if (pFile == NULL)
+        return 1;
+
+    const int jj = gd.icells;
+    const int kk = gd.icells*gd.jcells;
+
+    std::int64_t nfields;
+    if (fread(&nfields, sizeof(std::int64_t), 1, pFile) != 1)
+        return 1;
+
+    std::vector<Restart_entry> entries(nfields);
+    if (fread(entries.data(), sizeof(Restart_entry), nfields, pFile) != (unsigned)nfields)
+        return 1;
+
+    for (auto& field : fields)
+    {
+        const std::int64_t fileoff = find_restart_offset(entries, field.first);
+        if (fileoff < 0 || fseek(pFile, fileoff, SEEK_SET))
+            return 1;
+
+        for (int k=kstart; k<kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+            {
+                const int ijk = gd.istart + j*jj + k*kk;
+                if( fread(&field.second[ijk], sizeof(TF), gd.imax, pFile) != (unsigned)gd.imax )
+                    return 1;
+            }
+    }
+
+    fclose(pFile);
+
+    return 0;
+}
+
 template<typename TF>
 int Field3d_io<TF>::load_field3d(
         TF* const restrict data,
@@ -716,6 +1468,12 @@ int Field3d_io<TF>::load_field3d(
         const char* filename, const TF offset,
         const int kstart, const int kend)
 {
+    if (file_per_rank)
+        return load_field3d_per_rank(data, tmp1, filename, offset, kstart, kend);
+
+    if (compress_level > 0)
+        return load_field3d_compressed(data, tmp1, tmp2, filename, offset, kstart, kend);
+
     auto& gd = grid.get_grid_data();
 
     FILE *pFile;
@@ -898,9 +1656,920 @@ int Field3d_io<TF>::load_xy_slice(
 
     return 0;
 }
+
+template<typename TF>
+int Field3d_io<TF>::load_xy_slice_begin(
+        TF* const restrict buffer, const char* filename,
+        Field3d_io_request& req)
+{
+    // Without MPI there is no nonblocking read, so the slice is read directly into the buffer.
+    auto& gd = grid.get_grid_data();
+
+    FILE *pFile;
+    pFile = fopen(filename, "rb");
+
+    if (pFile == NULL)
+        return 1;
+
+    const size_t count = static_cast<size_t>(gd.imax)*gd.jmax;
+    const size_t nread = fread(buffer, sizeof(TF), count, pFile);
+    fclose(pFile);
+
+    return (nread != count);
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_xy_slice_end(
+        TF* const restrict data, TF* const restrict buffer,
+        Field3d_io_request& req, int kslice)
+{
+    auto& gd = grid.get_grid_data();
+
+    // Subtract the ghost cells in case of a pure 2d plane that does not have ghost cells.
+    if (kslice == -1)
+        kslice = -gd.kgc;
+
+    const int jj  = gd.icells;
+    const int kk  = gd.icells*gd.jcells;
+    const int jjb = gd.imax;
+
+    for (int j=0; j<gd.jmax; j++)
+        #pragma ivdep
+        for (int i=0; i<gd.imax; i++)
+        {
+            const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (kslice+gd.kgc)*kk;
+            const int ijkb = i + j*jjb;
+            data[ijk] = buffer[ijkb];
+        }
+
+    return 0;
+}
 #endif
 
 
+#ifdef USEZSTD
+namespace
+{
+    // Compressed 3D files start with a magic string and the number of blocks, followed by the
+    // compressed size of the block of each process and the blocks themselves in order of mpiid.
+    const char compressed_magic[8] = {'M', 'H', 'H', 'Z', 'S', 'T', 'D', '1'};
+
+    // Group the bytes of equal significance, which makes smooth fields compress much better.
+    template<typename TF>
+    void shuffle_bytes(char* const restrict out, const TF* const restrict in, const int n)
+    {
+        const char* const bytes = reinterpret_cast<const char*>(in);
+        for (int b=0; b<static_cast<int>(sizeof(TF)); ++b)
+            for (int i=0; i<n; ++i)
+                out[b*n + i] = bytes[i*sizeof(TF) + b];
+    }
+
+    template<typename TF>
+    void unshuffle_bytes(TF* const restrict out, const char* const restrict in, const int n)
+    {
+        char* const bytes = reinterpret_cast<char*>(out);
+        for (int b=0; b<static_cast<int>(sizeof(TF)); ++b)
+            for (int i=0; i<n; ++i)
+                bytes[i*sizeof(TF) + b] = in[b*n + i];
+    }
+
+    // Round to the nearest multiple of twice the error bound, such that the error never exceeds the bound.
+    template<typename TF>
+    void quantize(TF* const restrict data, const int n, const TF error_bound)
+    {
+        const TF step = TF(2.)*error_bound;
+        for (int i=0; i<n; ++i)
+            data[i] = std::round(data[i]/step)*step;
+    }
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_compressed(
+        TF* const restrict data,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const TF offset,
+        const int kstart, const int kend)
+{
+    // Every process compresses its own block, so the file can only be read with the same decomposition.
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int jj    = gd.icells;
+    const int kk    = gd.icells*gd.jcells;
+    const int jjb   = gd.imax;
+    const int kkb   = gd.imax*gd.jmax;
+    const int kmax  = kend-kstart;
+    const int count = gd.imax*gd.jmax*kmax;
+
+    for (int k=0; k<kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                const int ijkb = i + j*jjb + k*kkb;
+                tmp1[ijkb] = data[ijk] + offset;
+            }
+
+    if (compress_error > 0)
+        quantize(tmp1, count, compress_error);
+
+    char* const shuffled = reinterpret_cast<char*>(tmp2);
+    shuffle_bytes(shuffled, tmp1, count);
+
+    const size_t nbytes = count*sizeof(TF);
+    std::vector<char> compressed(ZSTD_compressBound(nbytes));
+    const size_t csize = ZSTD_compress(compressed.data(), compressed.size(), shuffled, nbytes, compress_level);
+
+    // All processes have to agree on the failure before the collective calls below. The count
+    // of the MPI write is an int, such that larger blocks cannot be written.
+    int nerror = (ZSTD_isError(csize) || csize > static_cast<size_t>(INT_MAX)) ? 1 : 0;
+    master.sum(&nerror, 1);
+    if (nerror)
+        return 1;
+
+    std::int64_t block_size = csize;
+    std::vector<std::int64_t> block_sizes(md.nprocs);
+
+    #ifdef USEMPI
+    MPI_Gather(&block_size, 1, MPI_INT64_T, block_sizes.data(), 1, MPI_INT64_T, 0, md.commxy);
+
+    std::int64_t block_offset = 0;
+    MPI_Exscan(&block_size, &block_offset, 1, MPI_INT64_T, MPI_SUM, md.commxy);
+    if (md.mpiid == 0)
+        block_offset = 0;
+
+    const std::int64_t header_size = sizeof(compressed_magic) + (md.nprocs+1)*sizeof(std::int64_t);
+
+    MPI_File fh;
+    if (MPI_File_open(md.commxy, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_EXCL, MPI_INFO_NULL, &fh))
+        return 1;
+
+    if (md.mpiid == 0)
+    {
+        const std::int64_t nblocks = md.nprocs;
+        if (MPI_File_write_at(fh, 0, compressed_magic, sizeof(compressed_magic), MPI_CHAR, MPI_STATUS_IGNORE)
+                || MPI_File_write_at(fh, sizeof(compressed_magic), &nblocks, 1, MPI_INT64_T, MPI_STATUS_IGNORE)
+                || MPI_File_write_at(fh, sizeof(compressed_magic) + sizeof(std::int64_t), block_sizes.data(), md.nprocs, MPI_INT64_T, MPI_STATUS_IGNORE))
+            ++nerror;
+    }
+
+    if (MPI_File_write_at_all(fh, header_size + block_offset, compressed.data(), csize, MPI_BYTE, MPI_STATUS_IGNORE))
+        ++nerror;
+
+    if (MPI_File_close(&fh))
+        ++nerror;
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        return 1;
+    #else
+    const std::int64_t nblocks = 1;
+    block_sizes[0] = block_size;
+
+    FILE *pFile;
+    pFile = fopen(filename, "wbx");
+
+    if (pFile == NULL)
+        return 1;
+
+    if (fwrite(compressed_magic, 1, sizeof(compressed_magic), pFile) != sizeof(compressed_magic)
+            || fwrite(&nblocks, sizeof(std::int64_t), 1, pFile) != 1
+            || fwrite(block_sizes.data(), sizeof(std::int64_t), 1, pFile) != 1
+            || fwrite(compressed.data(), 1, csize, pFile) != csize)
+        ++nerror;
+
+    fclose(pFile);
+
+    if (nerror)
+        return 1;
+    #endif
+
+    return 0;
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_field3d_compressed(
+        TF* const restrict data,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const TF offset,
+        const int kstart, const int kend)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int jj    = gd.icells;
+    const int kk    = gd.icells*gd.jcells;
+    const int jjb   = gd.imax;
+    const int kkb   = gd.imax*gd.jmax;
+    const int kmax  = kend-kstart;
+    const int count = gd.imax*gd.jmax*kmax;
+
+    char magic[sizeof(compressed_magic)];
+    std::int64_t nblocks;
+    std::vector<std::int64_t> block_sizes(md.nprocs);
+    std::vector<char> compressed;
+
+    #ifdef USEMPI
+    MPI_File fh;
+    if (MPI_File_open(md.commxy, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh))
+        return 1;
+
+    MPI_File_read_at_all(fh, 0, magic, sizeof(magic), MPI_CHAR, MPI_STATUS_IGNORE);
+    MPI_File_read_at_all(fh, sizeof(magic), &nblocks, 1, MPI_INT64_T, MPI_STATUS_IGNORE);
+
+    if (std::memcmp(magic, compressed_magic, sizeof(magic)) || nblocks != md.nprocs)
+    {
+        MPI_File_close(&fh);
+        return 1;
+    }
+
+    int nerror = 0;
+
+    if (MPI_File_read_at_all(fh, sizeof(magic) + sizeof(std::int64_t), block_sizes.data(), md.nprocs, MPI_INT64_T, MPI_STATUS_IGNORE))
+        ++nerror;
+
+    const std::int64_t header_size = sizeof(compressed_magic) + (md.nprocs+1)*sizeof(std::int64_t);
+    std::int64_t block_offset = 0;
+    for (int n=0; n<md.mpiid; ++n)
+        block_offset += block_sizes[n];
+
+    // An invalid block size skips the read of this process, but not the collective call.
+    const std::int64_t block_size = block_sizes[md.mpiid];
+    const bool valid_size = (nerror == 0) && block_size >= 0 && block_size <= INT_MAX;
+    if (!valid_size)
+        ++nerror;
+
+    compressed.resize(valid_size ? block_size : 0);
+    if (MPI_File_read_at_all(fh, header_size + block_offset, compressed.data(), compressed.size(), MPI_BYTE, MPI_STATUS_IGNORE))
+        ++nerror;
+
+    if (MPI_File_close(&fh))
+        ++nerror;
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        return 1;
+    #else
+    FILE *pFile;
+    pFile = fopen(filename, "rb");
+
+    if (pFile == NULL)
+        return 1;
+
+    if (fread(magic, 1, sizeof(magic), pFile) != sizeof(magic)
+            || fread(&nblocks, sizeof(std::int64_t), 1, pFile) != 1
+            || std::memcmp(magic, compressed_magic, sizeof(magic)) || nblocks != 1
+            || fread(block_sizes.data(), sizeof(std::int64_t), 1, pFile) != 1)
+    {
+        fclose(pFile);
+        return 1;
+    }
+
+    compressed.resize(block_sizes[0]);
+    const bool read_failed = fread(compressed.data(), 1, compressed.size(), pFile) != compressed.size();
+
+    fclose(pFile);
+
+    if (read_failed)
+        return 1;
+    #endif
+
+    const size_t nbytes = count*sizeof(TF);
+    char* const shuffled = reinterpret_cast<char*>(tmp2);
+    const size_t dsize = ZSTD_decompress(shuffled, nbytes, compressed.data(), compressed.size());
+    if (ZSTD_isError(dsize) || dsize != nbytes)
+        return 1;
+
+    unshuffle_bytes(tmp1, shuffled, count);
+
+    for (int k=0; k<kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                const int ijkb = i + j*jjb + k*kkb;
+                data[ijk] = tmp1[ijkb] - offset;
+            }
+
+    return 0;
+}
+
+#else
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_compressed(
+        TF* const restrict data,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const TF offset,
+        const int kstart, const int kend)
+{
+    return 1;
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_field3d_compressed(
+        TF* const restrict data,
+        TF* const restrict tmp1, TF* const restrict tmp2,
+        const char* filename, const TF offset,
+        const int kstart, const int kend)
+{
+    return 1;
+}
+#endif
+
+namespace
+{
+    // A field that is saved in a file per rank has a text manifest at the path of the field itself,
+    // with the global size, the decomposition and the position of every block. The block of each
+    // rank is saved as (filename).(mpiid) in [k][j][i] order without ghost cells.
+    const std::string per_rank_tag = "microhh_file_per_rank";
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_per_rank(
+        TF* const restrict data, TF* const restrict tmp1,
+        const char* filename, const TF offset,
+        const int kstart, const int kend)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int jj    = gd.icells;
+    const int kk    = gd.icells*gd.jcells;
+    const int jjb   = gd.imax;
+    const int kkb   = gd.imax*gd.jmax;
+    const int kmax  = kend-kstart;
+    const int count = gd.imax*gd.jmax*kmax;
+
+    for (int k=0; k<kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                const int ijkb = i + j*jjb + k*kkb;
+                tmp1[ijkb] = data[ijk] + offset;
+            }
+
+    int nerror = 0;
+
+    char blockname[256];
+    std::snprintf(blockname, 256, "%s.%05d", filename, md.mpiid);
+
+    const double io_start = master.get_wall_clock_time();
+
+    FILE *pFile;
+    pFile = fopen(blockname, "wbx");
+
+    if (pFile == NULL)
+        ++nerror;
+    else
+    {
+        if (fwrite(tmp1, sizeof(TF), count, pFile) != static_cast<size_t>(count))
+            ++nerror;
+        fclose(pFile);
+    }
+
+    master.add_comm(Comm_site::Io, count*sizeof(TF), 1, master.get_wall_clock_time() - io_start);
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        return 1;
+
+    return save_per_rank_manifest(filename, kmax);
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_per_rank_manifest(const char* filename, const int kmax)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    int nerror = 0;
+
+    // The manifest is written last, such that an existing manifest implies that all blocks are complete.
+    const double coords[2] = {static_cast<double>(md.mpicoordx), static_cast<double>(md.mpicoordy)};
+    std::vector<double> coords_all((md.mpiid == 0) ? 2*md.nprocs : 0);
+    master.gather(coords, coords_all.data(), 2);
+
+    if (md.mpiid == 0)
+    {
+        FILE* pFile = fopen(filename, "wx");
+
+        if (pFile == NULL)
+            ++nerror;
+        else
+        {
+            std::fprintf(pFile, "%s 1\n", per_rank_tag.c_str());
+            std::fprintf(pFile, "%d %d %d %d\n", gd.itot, gd.jtot, kmax, static_cast<int>(sizeof(TF)));
+            std::fprintf(pFile, "%d %d %d %d\n", md.npx, md.npy, gd.imax, gd.jmax);
+            for (int n=0; n<md.nprocs; ++n)
+                std::fprintf(pFile, "%d %d %d\n", n,
+                        static_cast<int>(coords_all[2*n  ])*gd.imax,
+                        static_cast<int>(coords_all[2*n+1])*gd.jmax);
+
+            if (fclose(pFile))
+                ++nerror;
+        }
+    }
+
+    master.broadcast(&nerror, 1);
+
+    return (nerror > 0);
+}
+
+template<typename TF>
+int Field3d_io<TF>::load_field3d_per_rank(
+        TF* const restrict data, TF* const restrict tmp1,
+        const char* filename, const TF offset,
+        const int kstart, const int kend)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int jj    = gd.icells;
+    const int kk    = gd.icells*gd.jcells;
+    const int jjb   = gd.imax;
+    const int kkb   = gd.imax*gd.jmax;
+    const int kmax  = kend-kstart;
+    const int count = gd.imax*gd.jmax*kmax;
+
+    if (check_per_rank_manifest(filename, kmax))
+        return 1;
+
+    int nerror = 0;
+
+    char blockname[256];
+    std::snprintf(blockname, 256, "%s.%05d", filename, md.mpiid);
+
+    const double io_start = master.get_wall_clock_time();
+
+    FILE *pFile;
+    pFile = fopen(blockname, "rb");
+
+    if (pFile == NULL)
+        ++nerror;
+    else
+    {
+        if (fread(tmp1, sizeof(TF), count, pFile) != static_cast<size_t>(count))
+            ++nerror;
+        fclose(pFile);
+    }
+
+    master.add_comm(Comm_site::Io, count*sizeof(TF), 1, master.get_wall_clock_time() - io_start);
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        return 1;
+
+    for (int k=0; k<kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.igc + (j+gd.jgc)*jj + (k+kstart)*kk;
+                const int ijkb = i + j*jjb + k*kkb;
+                data[ijk] = tmp1[ijkb] - offset;
+            }
+
+    return 0;
+}
+
+template<typename TF>
+int Field3d_io<TF>::check_per_rank_manifest(const char* filename, const int kmax)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    // The main process reads the manifest, which has to match the current decomposition.
+    // Files of another decomposition have to be merged with microhh_merge first.
+    int header[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    if (md.mpiid == 0)
+    {
+        std::ifstream manifest(filename);
+        std::string tag;
+        int version = 0;
+        if (manifest >> tag >> version && tag == per_rank_tag && version == 1)
+            for (int n=0; n<8; ++n)
+                manifest >> header[n];
+    }
+
+    master.broadcast(header, 8);
+
+    const int expected[8] = {
+            gd.itot, gd.jtot, kmax, static_cast<int>(sizeof(TF)),
+            md.npx, md.npy, gd.imax, gd.jmax};
+
+    if (!std::equal(header, header+8, expected))
+    {
+        master.print_warning(
+                "\"%s\" is not a file-per-rank field of the current grid and decomposition, "
+                "merge it with microhh_merge\n", filename);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+namespace
+{
+    // Mix the global index and the bits of a value into a 64-bit hash (splitmix64 finalizer).
+    template<typename TF>
+    uint64_t hash_value(const uint64_t index, const TF value)
+    {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(TF));
+
+        uint64_t h = bits ^ (index * 0x9E3779B97F4A7C15ULL);
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        return h ^ (h >> 31);
+    }
+}
+
+template<typename TF>
+std::vector<uint64_t> Field3d_io<TF>::calc_checksums(
+        const TF* const restrict data, const int kstart, const int kend)
+{
+    // The checksum of each level is the sum of the hashes of its points, which makes
+    // it independent of the decomposition over the processes.
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    std::vector<uint64_t> checksums(kend-kstart, 0);
+
+    for (int k=kstart; k<kend; ++k)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*gd.icells + k*gd.ijcells;
+                const uint64_t index =
+                        (i-gd.istart + md.mpicoordx*gd.imax)
+                      + (j-gd.jstart + md.mpicoordy*gd.jmax)*static_cast<uint64_t>(gd.itot);
+                checksums[k-kstart] += hash_value(index, data[ijk]);
+            }
+
+    #ifdef USEMPI
+    MPI_Allreduce(MPI_IN_PLACE, checksums.data(), checksums.size(), MPI_UINT64_T, MPI_SUM, md.commxy);
+    #endif
+
+    return checksums;
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_checksums(
+        const TF* const restrict data, const char* filename, const int kstart, const int kend)
+{
+    const std::vector<uint64_t> checksums = calc_checksums(data, kstart, kend);
+
+    int nerror = 0;
+    if (master.get_mpiid() == 0)
+    {
+        FILE* pFile = fopen(filename, "wb");
+        if (pFile == NULL)
+            nerror = 1;
+        else
+        {
+            nerror = (fwrite(checksums.data(), sizeof(uint64_t), checksums.size(), pFile) != checksums.size());
+            fclose(pFile);
+        }
+    }
+    master.broadcast(&nerror, 1);
+
+    return nerror;
+}
+
+template<typename TF>
+int Field3d_io<TF>::check_checksums(
+        const TF* const restrict data, const char* filename, const int kstart, const int kend)
+{
+    // Returns -1 if there is no checksum file, 0 if all levels match, and otherwise
+    // the first level that does not match plus one.
+    const std::vector<uint64_t> checksums = calc_checksums(data, kstart, kend);
+
+    int result = 0;
+    if (master.get_mpiid() == 0)
+    {
+        std::vector<uint64_t> checksums_file(checksums.size());
+
+        FILE* pFile = fopen(filename, "rb");
+        if (pFile == NULL)
+            result = -1;
+        else
+        {
+            if (fread(checksums_file.data(), sizeof(uint64_t), checksums_file.size(), pFile) != checksums_file.size())
+                result = 1;
+            else
+            {
+                for (size_t k=0; k<checksums.size(); ++k)
+                    if (checksums[k] != checksums_file[k])
+                    {
+                        result = k+1;
+                        break;
+                    }
+            }
+            fclose(pFile);
+        }
+    }
+    master.broadcast(&result, 1);
+
+    return result;
+}
+
+namespace
+{
+    // Get the number of points of the subset along one dimension that lie before the
+    // process block that starts at global index n0, the number inside the block of
+    // size n and the local index of the first one.
+    void get_subset_range(
+            int& nbefore, int& nlocal, int& ifirst,
+            const int n0, const int n, const int start, const int end, const int stride)
+    {
+        const int ntot = (end - start + stride - 1) / stride;
+        auto count_below = [&](const int x)
+        {
+            return (x <= start) ? 0 : std::min((x - start + stride - 1) / stride, ntot);
+        };
+
+        nbefore = count_below(n0);
+        nlocal = count_below(n0+n) - nbefore;
+        ifirst = start + nbefore*stride - n0;
+    }
+
+    template<typename TO, typename TF>
+    void pack_subset(
+            std::vector<TO>& out, const TF* const restrict data,
+            const int ni, const int nj, const int nk,
+            const int i0, const int j0, const int k0, const int stride,
+            const int icells, const int ijcells)
+    {
+        out.resize(ni*nj*nk);
+        for (int k=0; k<nk; ++k)
+            for (int j=0; j<nj; ++j)
+                for (int i=0; i<ni; ++i)
+                {
+                    const int ijk = (i0 + i*stride) + (j0 + j*stride)*icells + (k0 + k*stride)*ijcells;
+                    out[i + j*ni + k*ni*nj] = static_cast<TO>(data[ijk]);
+                }
+    }
+
+    template<typename TO>
+    int write_subset(
+            const std::vector<TO>& buffer, const char* filename,
+            const int* totsize, const int* subsize, const int* substart, const MPI_data& md)
+    {
+        #ifdef USEMPI
+        MPI_Datatype fp_type = (sizeof(TO) == sizeof(float)) ? MPI_FLOAT : MPI_DOUBLE;
+
+        // Processes without points of the subset keep a valid view and write nothing.
+        int subsize_view[3] = {std::max(subsize[0], 1), std::max(subsize[1], 1), std::max(subsize[2], 1)};
+        int substart_view[3];
+        for (int n=0; n<3; ++n)
+            substart_view[n] = std::min(substart[n], totsize[n]-subsize_view[n]);
+
+        MPI_Datatype subarray;
+        MPI_Type_create_subarray(3, totsize, subsize_view, substart_view, MPI_ORDER_C, fp_type, &subarray);
+        MPI_Type_commit(&subarray);
+
+        MPI_File fh;
+        if (MPI_File_open(md.commxy, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_EXCL, MPI_INFO_NULL, &fh))
+        {
+            MPI_Type_free(&subarray);
+            return 1;
+        }
+
+        char name[] = "native";
+        int nerror = 0;
+
+        if (MPI_File_set_view(fh, 0, fp_type, subarray, name, MPI_INFO_NULL))
+            ++nerror;
+        else if (MPI_File_write_all(fh, buffer.data(), buffer.size(), fp_type, MPI_STATUS_IGNORE))
+            ++nerror;
+
+        if (MPI_File_close(&fh))
+            ++nerror;
+
+        MPI_Type_free(&subarray);
+
+        return nerror;
+        #else
+        FILE* pFile = fopen(filename, "wbx");
+        if (pFile == NULL)
+            return 1;
+
+        const int nerror = (fwrite(buffer.data(), sizeof(TO), buffer.size(), pFile) != buffer.size());
+        fclose(pFile);
+
+        return nerror;
+        #endif
+    }
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_subset(
+        TF* const restrict data, const char* filename,
+        const Field3d_subset& subset, const bool swfloat)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    // The file contains the subset of the global field in [k][j][i] order.
+    int ni0, nj0, nk0;
+    int ni, nj, nk;
+    int i0, j0, k0;
+
+    get_subset_range(ni0, ni, i0, md.mpicoordx*gd.imax, gd.imax, subset.istart, subset.iend, subset.stride);
+    get_subset_range(nj0, nj, j0, md.mpicoordy*gd.jmax, gd.jmax, subset.jstart, subset.jend, subset.stride);
+    get_subset_range(nk0, nk, k0, 0, gd.kmax, subset.kstart, subset.kend, subset.stride);
+
+    int nitot, njtot, nktot, dummy;
+    get_subset_range(dummy, nitot, dummy, 0, gd.itot, subset.istart, subset.iend, subset.stride);
+    get_subset_range(dummy, njtot, dummy, 0, gd.jtot, subset.jstart, subset.jend, subset.stride);
+    nktot = nk;
+
+    const int totsize [3] = {nktot, njtot, nitot};
+    const int subsize [3] = {nk, nj, ni};
+    const int substart[3] = {nk0, nj0, ni0};
+
+    if (swfloat)
+    {
+        std::vector<float> buffer;
+        pack_subset(buffer, data, ni, nj, nk, i0+gd.istart, j0+gd.jstart, k0+gd.kstart, subset.stride, gd.icells, gd.ijcells);
+        return write_subset(buffer, filename, totsize, subsize, substart, md);
+    }
+    else
+    {
+        std::vector<TF> buffer;
+        pack_subset(buffer, data, ni, nj, nk, i0+gd.istart, j0+gd.jstart, k0+gd.kstart, subset.stride, gd.icells, gd.ijcells);
+        return write_subset(buffer, filename, totsize, subsize, substart, md);
+    }
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_coarse(
+        TF* const restrict data, const char* filename, const int ncoarse, const bool swfloat)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    // The coarse blocks are aligned with the process blocks, such that every
+    // process averages its own columns without communication.
+    if (gd.imax % ncoarse != 0 || gd.jmax % ncoarse != 0)
+        return 1;
+
+    const int ni = gd.imax / ncoarse;
+    const int nj = gd.jmax / ncoarse;
+    const int nk = gd.kmax;
+
+    const int totsize [3] = {nk, gd.jtot / ncoarse, gd.itot / ncoarse};
+    const int subsize [3] = {nk, nj, ni};
+    const int substart[3] = {0, md.mpicoordy*nj, md.mpicoordx*ni};
+
+    std::vector<TF> coarse(ni*nj*nk, TF(0.));
+    const TF fac = TF(1.) / (ncoarse*ncoarse);
+
+    #pragma omp parallel for
+    for (int k=0; k<nk; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk = (i+gd.istart) + (j+gd.jstart)*gd.icells + (k+gd.kstart)*gd.ijcells;
+                coarse[i/ncoarse + (j/ncoarse)*ni + k*ni*nj] += fac*data[ijk];
+            }
+
+    if (swfloat)
+    {
+        const std::vector<float> buffer(coarse.begin(), coarse.end());
+        return write_subset(buffer, filename, totsize, subsize, substart, md);
+    }
+    else
+        return write_subset(coarse, filename, totsize, subsize, substart, md);
+}
+
+namespace
+{
+    // A sparse file holds the number of non-zero values as uint64, followed by their global indices
+    // i + j*ni_tot + k*ni_tot*nj_tot as uint64 in increasing order per process, and their values.
+    // The processes write their parts collectively at the offsets of an exclusive prefix sum.
+    template<typename TF>
+    int write_sparse(
+            const std::vector<uint64_t>& index, const std::vector<TF>& values,
+            const char* filename, const MPI_data& md)
+    {
+        #ifdef USEMPI
+        const uint64_t nlocal = index.size();
+        uint64_t noffset = 0;
+        uint64_t ntot = 0;
+
+        int rank;
+        MPI_Comm_rank(md.commxy, &rank);
+
+        // The result of the prefix sum is undefined on the first process.
+        MPI_Exscan(&nlocal, &noffset, 1, MPI_UINT64_T, MPI_SUM, md.commxy);
+        MPI_Allreduce(&nlocal, &ntot, 1, MPI_UINT64_T, MPI_SUM, md.commxy);
+        if (rank == 0)
+            noffset = 0;
+
+        MPI_Datatype fp_type = (sizeof(TF) == sizeof(float)) ? MPI_FLOAT : MPI_DOUBLE;
+
+        MPI_File fh;
+        if (MPI_File_open(md.commxy, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_EXCL, MPI_INFO_NULL, &fh))
+            return 1;
+
+        int nerror = 0;
+
+        if (rank == 0 && MPI_File_write_at(fh, 0, &ntot, 1, MPI_UINT64_T, MPI_STATUS_IGNORE))
+            ++nerror;
+
+        const MPI_Offset index_start = sizeof(uint64_t) * (1 + noffset);
+        const MPI_Offset value_start = sizeof(uint64_t) * (1 + ntot) + sizeof(TF) * noffset;
+
+        if (MPI_File_write_at_all(fh, index_start, index.data(), static_cast<int>(nlocal), MPI_UINT64_T, MPI_STATUS_IGNORE))
+            ++nerror;
+        if (MPI_File_write_at_all(fh, value_start, values.data(), static_cast<int>(nlocal), fp_type, MPI_STATUS_IGNORE))
+            ++nerror;
+
+        if (MPI_File_close(&fh))
+            ++nerror;
+
+        return nerror;
+        #else
+        FILE* pFile = fopen(filename, "wbx");
+        if (pFile == NULL)
+            return 1;
+
+        const uint64_t ntot = index.size();
+
+        int nerror = 0;
+        nerror += (fwrite(&ntot, sizeof(uint64_t), 1, pFile) != 1);
+        nerror += (fwrite(index.data(), sizeof(uint64_t), index.size(), pFile) != index.size());
+        nerror += (fwrite(values.data(), sizeof(TF), values.size(), pFile) != values.size());
+        fclose(pFile);
+
+        return nerror;
+        #endif
+    }
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_field3d_sparse(TF* const restrict data, const char* filename)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    std::vector<uint64_t> index;
+    std::vector<TF> values;
+
+    const uint64_t i0 = md.mpicoordx*gd.imax;
+    const uint64_t j0 = md.mpicoordy*gd.jmax;
+    const uint64_t itot = gd.itot;
+    const uint64_t ijtot = static_cast<uint64_t>(gd.itot)*gd.jtot;
+
+    for (int k=0; k<gd.kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const TF value = data[(i+gd.istart) + (j+gd.jstart)*gd.icells + (k+gd.kstart)*gd.ijcells];
+                if (value != TF(0.))
+                {
+                    index.push_back((i0+i) + (j0+j)*itot + k*ijtot);
+                    values.push_back(value);
+                }
+            }
+
+    return write_sparse(index, values, filename, md);
+}
+
+template<typename TF>
+int Field3d_io<TF>::save_block_sparse(
+        const std::vector<TF>& block, const int ni, const int nj, const int nk,
+        const int i0, const int j0, const int k0, const int ni_tot, const int nj_tot, const char* filename)
+{
+    auto& md = master.get_MPI_data();
+
+    std::vector<uint64_t> index;
+    std::vector<TF> values;
+
+    const uint64_t nij_tot = static_cast<uint64_t>(ni_tot)*nj_tot;
+
+    for (int k=0; k<nk; ++k)
+        for (int j=0; j<nj; ++j)
+            for (int i=0; i<ni; ++i)
+            {
+                const TF value = block[i + j*ni + k*ni*nj];
+                if (value != TF(0.))
+                {
+                    index.push_back(static_cast<uint64_t>(i0+i) + static_cast<uint64_t>(j0+j)*ni_tot + (k0+k)*nij_tot);
+                    values.push_back(value);
+                }
+            }
+
+    return write_sparse(index, values, filename, md);
+}
+
 #ifdef FLOAT_SINGLE
 template class Field3d_io<float>;
 #else
@@ -23,6 +23,8 @@
 #include <cstdio>
 #include <iostream>
 #include <cmath>
+#include <vector>
+#include <stdexcept>
 #include "master.h"
 #include "grid.h"
 #include "field3d.h"
@@ -113,14 +115,75 @@ void Field3d_operators<TF>::calc_mean_profile_g(TF* const restrict prof, const T
     auto tmp = fields.get_tmp_g();
 
     reduce_interior<TF>(
-        fld, tmp->fld_g, gd.itot, gd.istart, gd.iend, gd.jtot,
+        fld, tmp->fld_g, gd.imax, gd.istart, gd.iend, gd.jmax,
         gd.jstart, gd.jend, gd.kcells, 0, gd.icells, gd.ijcells, Sum_type);
 
-    // Reduce jtot*kcells to kcells values
+    // Reduce jmax*kcells to kcells values
     reduce_all<TF>(
-        tmp->fld_g, prof, gd.jtot*gd.kcells, gd.kcells, gd.jtot, Sum_type, scalefac);
+        tmp->fld_g, prof, gd.jmax*gd.kcells, gd.kcells, gd.jmax, Sum_type, scalefac);
 
     fields.release_tmp_g(tmp);
+
+    #ifdef USEMPI
+    // Sum the partial profiles of all subdomains.
+    std::vector<TF> prof_cpu(gd.kcells);
+    cuda_safe_call(cudaMemcpy(prof_cpu.data(), prof, gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost));
+    master.sum(prof_cpu.data(), gd.kcells);
+    cuda_safe_call(cudaMemcpy(prof, prof_cpu.data(), gd.kcells*sizeof(TF), cudaMemcpyHostToDevice));
+    #endif
+}
+
+template<typename TF>
+void Field3d_operators<TF>::calc_mean_profiles_g(
+        const std::vector<TF*>& profs, const std::vector<const TF*>& flds)
+{
+    using namespace Tools_g;
+
+    const auto& gd = grid.get_grid_data();
+    const TF scalefac = 1./(gd.itot*gd.jtot);
+    const int nfld = flds.size();
+
+    auto tmp = fields.get_tmp_g();
+
+    #ifdef USEMPI
+    // The profiles are collected in one device buffer, such that a single copy and
+    // a single sum over the subdomains serve all fields.
+    if (nfld*gd.kcells > gd.ncells)
+        throw std::runtime_error("Too many fields for calc_mean_profiles_g");
+
+    auto profs_all = fields.get_tmp_g();
+    #endif
+
+    for (int f=0; f<nfld; ++f)
+    {
+        reduce_interior<TF>(
+            flds[f], tmp->fld_g, gd.imax, gd.istart, gd.iend, gd.jmax,
+            gd.jstart, gd.jend, gd.kcells, 0, gd.icells, gd.ijcells, Sum_type);
+
+        #ifdef USEMPI
+        TF* const prof = profs_all->fld_g.data() + f*gd.kcells;
+        #else
+        TF* const prof = profs[f];
+        #endif
+
+        reduce_all<TF>(
+            tmp->fld_g, prof, gd.jmax*gd.kcells, gd.kcells, gd.jmax, Sum_type, scalefac);
+    }
+
+    fields.release_tmp_g(tmp);
+
+    #ifdef USEMPI
+    std::vector<TF> prof_cpu(nfld*gd.kcells);
+    cuda_safe_call(cudaMemcpy(prof_cpu.data(), profs_all->fld_g, nfld*gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost));
+    master.sum(prof_cpu.data(), nfld*gd.kcells);
+    cuda_safe_call(cudaMemcpy(profs_all->fld_g, prof_cpu.data(), nfld*gd.kcells*sizeof(TF), cudaMemcpyHostToDevice));
+
+    for (int f=0; f<nfld; ++f)
+        cuda_safe_call(cudaMemcpy(
+                profs[f], profs_all->fld_g.data() + f*gd.kcells, gd.kcells*sizeof(TF), cudaMemcpyDeviceToDevice));
+
+    fields.release_tmp_g(profs_all);
+    #endif
 }
 
 template<typename TF>
@@ -131,8 +194,8 @@ TF Field3d_operators<TF>::calc_mean_2d_g(const TF* const restrict fld)
 
     const int blocki = gd.ithread_block;
     const int blockj = gd.jthread_block;
-    const int gridi  = gd.itot/blocki + (gd.itot%blocki > 0);
-    const int gridj  = gd.jtot/blockj + (gd.jtot%blockj > 0);
+    const int gridi  = gd.imax/blocki + (gd.imax%blocki > 0);
+    const int gridj  = gd.jmax/blockj + (gd.jmax%blockj > 0);
 
     dim3 gridGPU(gridi, gridj);
     dim3 blockGPU(blocki, blockj);
@@ -154,6 +217,8 @@ TF Field3d_operators<TF>::calc_mean_2d_g(const TF* const restrict fld)
     cudaMemcpy(&mean_value, mean_value_g, sizeof(TF), cudaMemcpyDeviceToHost);
     cudaFree(mean_value_g);
 
+    master.sum(&mean_value, 1);
+
     return mean_value;
 }
 
@@ -168,20 +233,22 @@ TF Field3d_operators<TF>::calc_mean_g(const TF* const restrict fld)
 
     auto tmp = fields.get_tmp_g();
 
-    // Reduce 3D field excluding ghost cells and padding to jtot*ktot values
-    reduce_interior<TF>(fld, tmp->fld_g, gd.itot, gd.istart, gd.iend, gd.jtot, gd.jstart, gd.jend, gd.ktot, gd.kstart, gd.icells, gd.ijcells, Sum_type);
-    // Reduce jtot*ktot to ktot values
+    // Reduce 3D field excluding ghost cells and padding to jmax*ktot values
+    reduce_interior<TF>(fld, tmp->fld_g, gd.imax, gd.istart, gd.iend, gd.jmax, gd.jstart, gd.jend, gd.ktot, gd.kstart, gd.icells, gd.ijcells, Sum_type);
+    // Reduce jmax*ktot to ktot values
     for (int k=0; k<gd.ktot; ++k)
     {
-        reduce_all<TF> (&tmp->fld_g[gd.jtot*k], &tmp->fld_g[gd.jtot*gd.ktot+k], gd.jtot, 1., gd.jtot, Sum_type, gd.dz[k+gd.kstart]);
+        reduce_all<TF> (&tmp->fld_g[gd.jmax*k], &tmp->fld_g[gd.jmax*gd.ktot+k], gd.jmax, 1., gd.jmax, Sum_type, gd.dz[k+gd.kstart]);
     }
     // Reduce ktot values to a single value
-    reduce_all<TF>     (&tmp->fld_g[gd.jtot*gd.ktot], tmp->fld_g, gd.ktot, 1, gd.ktot, Sum_type, scalefac);
+    reduce_all<TF>     (&tmp->fld_g[gd.jmax*gd.ktot], tmp->fld_g, gd.ktot, 1, gd.ktot, Sum_type, scalefac);
     // Copy back result from GPU
     cuda_safe_call(cudaMemcpy(&mean_value, tmp->fld_g, sizeof(TF), cudaMemcpyDeviceToHost));
 
     fields.release_tmp_g(tmp);
 
+    master.sum(&mean_value, 1);
+
     return mean_value;
 }
 
@@ -196,17 +263,19 @@ TF Field3d_operators<TF>::calc_max_g(const TF* const restrict fld)
 
     auto tmp = fields.get_tmp_g();
 
-    // Reduce 3D field excluding ghost cells and padding to jtot*ktot values
-    reduce_interior<TF>(fld, tmp->fld_g, gd.itot, gd.istart, gd.iend, gd.jtot, gd.jstart, gd.jend, gd.ktot, gd.kstart, gd.icells, gd.ijcells, Max_type);
-    // Reduce jtot*ktot to ktot values
-    reduce_all<TF>     (tmp->fld_g, &tmp->fld_g[gd.jtot*gd.ktot], gd.jtot*gd.ktot, gd.ktot, gd.jtot, Max_type, scalefac);
+    // Reduce 3D field excluding ghost cells and padding to jmax*ktot values
+    reduce_interior<TF>(fld, tmp->fld_g, gd.imax, gd.istart, gd.iend, gd.jmax, gd.jstart, gd.jend, gd.ktot, gd.kstart, gd.icells, gd.ijcells, Max_type);
+    // Reduce jmax*ktot to ktot values
+    reduce_all<TF>     (tmp->fld_g, &tmp->fld_g[gd.jmax*gd.ktot], gd.jmax*gd.ktot, gd.ktot, gd.jmax, Max_type, scalefac);
     // Reduce ktot values to a single value
-    reduce_all<TF>     (&tmp->fld_g[gd.jtot*gd.ktot], tmp->fld_g, gd.ktot, 1, gd.ktot, Max_type, scalefac);
+    reduce_all<TF>     (&tmp->fld_g[gd.jmax*gd.ktot], tmp->fld_g, gd.ktot, 1, gd.ktot, Max_type, scalefac);
     // Copy back result from GPU
     cuda_safe_call(cudaMemcpy(&max_value, tmp->fld_g, sizeof(TF), cudaMemcpyDeviceToHost));
 
     fields.release_tmp_g(tmp);
 
+    master.max(&max_value, 1);
+
     return max_value;
 }
 #endif
@@ -23,6 +23,8 @@
 #include <cstdio>
 #include <iostream>
 #include <cmath>
+#include <vector>
+#include <algorithm>
 #include "master.h"
 #include "grid.h"
 #include "field3d.h"
@@ -65,6 +67,41 @@ void Field3d_operators<TF>::calc_mean_profile(TF* const restrict prof, const TF*
     master.sum(prof, gd.kcells);
 }
 
+template<typename TF>
+void Field3d_operators<TF>::calc_mean_profiles(
+        const std::vector<TF*>& profs, const std::vector<const TF*>& flds)
+{
+    const auto& gd = grid.get_grid_data();
+    const double n = gd.itot * gd.jtot;
+    const int nfld = flds.size();
+
+    // The profiles of all fields are computed in one parallel loop and collected in a single
+    // buffer, which is summed over the processes in one call.
+    std::vector<TF> profs_all(nfld*gd.kcells);
+
+    #pragma omp parallel for collapse(2)
+    for (int f=0; f<nfld; ++f)
+        for (int k=0; k<gd.kcells; ++k)
+        {
+            const TF* const restrict fld = flds[f];
+
+            double tmp = 0.;
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                #pragma ivdep
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk  = i + j*gd.icells + k*gd.ijcells;
+                    tmp += fld[ijk];
+                }
+            profs_all[f*gd.kcells + k] = tmp / n;
+        }
+
+    master.sum(profs_all.data(), nfld*gd.kcells);
+
+    for (int f=0; f<nfld; ++f)
+        std::copy(profs_all.begin() + f*gd.kcells, profs_all.begin() + (f+1)*gd.kcells, profs[f]);
+}
+
 template<typename TF>
 TF Field3d_operators<TF>::calc_mean_2d(const TF* const restrict fld)
 {
@@ -26,11 +26,13 @@
 #include <algorithm>
 #include <sstream>
 #include <iostream>
+#include <map>
 #include "fields.h"
 #include "grid.h"
 #include "soil_grid.h"
 #include "master.h"
 #include "column.h"
+#include "cross.h"
 #include "constants.h"
 #include "tools.h"
 #include "fast_math.h"
@@ -40,34 +42,57 @@ namespace
 {
     namespace fm = Fast_math;
 
-    // TODO use interp2 functions instead of manual interpolation
-    template<typename TF> __global__
-    void calc_mom_2nd_g(const TF* __restrict__ u, const TF* __restrict__ v, const TF* __restrict__ w,
-                        TF* __restrict__ mom, const TF* __restrict__ dz,
-                        int istart, int jstart, int kstart,
-                        int iend,   int jend,   int kend,
-                        int jj,     int kk)
+    // Stream on which the fields are copied back to the host.
+    cudaStream_t copy_stream = nullptr;
+
+    // Host arrays that are page-locked for the transfers from the device, with the
+    // page-locked buffer and its size per vector.
+    std::map<const void*, std::pair<void*, size_t>> registered_host_arrays;
+
+    template<typename TF>
+    void register_host_array(std::vector<TF>& array)
     {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-        const int ii = 1;
+        const size_t nbytes = array.size()*sizeof(TF);
 
-        if (i < iend && j < jend && k < kend)
+        auto it = registered_host_arrays.find(&array);
+        if (it != registered_host_arrays.end())
         {
-            const int ijk = i + j*jj + k*kk;
-            mom[ijk] = (TF(0.5)*(u[ijk]+u[ijk+ii])
-                      + TF(0.5)*(v[ijk]+v[ijk+jj])
-                      + TF(0.5)*(w[ijk]+w[ijk+kk]))*dz[k];
+            if (it->second.first == array.data() && it->second.second == nbytes)
+                return;
+
+            cudaHostUnregister(it->second.first);
+            cudaGetLastError();
+            registered_host_arrays.erase(it);
         }
+
+        if (array.empty())
+            return;
+
+        // Page-locking is only an optimization, the copies work from pageable memory as well.
+        if (cudaHostRegister(array.data(), nbytes, cudaHostRegisterDefault) == cudaSuccess)
+            registered_host_arrays.emplace(&array, std::make_pair(static_cast<void*>(array.data()), nbytes));
+        else
+            cudaGetLastError();
+    }
+
+    // A std::vector can move its buffer on a resize, such that the registration of a registered
+    // array is checked before each copy, and redone if the buffer of the vector has changed.
+    template<typename TF>
+    void update_host_array(std::vector<TF>& array)
+    {
+        if (registered_host_arrays.count(&array))
+            register_host_array(array);
     }
 
+    // TODO use interp2 functions instead of manual interpolation
+    // Cell values of the momentum and the kinetic energy, of which the means are taken in one reduction.
     template<typename TF> __global__
-    void calc_tke_2nd_g(const TF* __restrict__ u, const TF* __restrict__ v, const TF* __restrict__ w,
-                        TF* __restrict__ tke, const TF* __restrict__ dz,
-                        int istart, int jstart, int kstart,
-                        int iend,   int jend,   int kend,
-                        int jj,     int kk)
+    void calc_conservation_2nd_g(
+            const TF* __restrict__ u, const TF* __restrict__ v, const TF* __restrict__ w,
+            TF* __restrict__ mom, TF* __restrict__ tke,
+            int istart, int jstart, int kstart,
+            int iend,   int jend,   int kend,
+            int jj,     int kk)
     {
         const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
         const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
@@ -77,9 +102,12 @@ namespace
         if (i < iend && j < jend && k < kend)
         {
             const int ijk = i + j*jj + k*kk;
-            tke[ijk] = ( TF(0.5)*(fm::pow2(u[ijk])+fm::pow2(u[ijk+ii]))
-                       + TF(0.5)*(fm::pow2(v[ijk])+fm::pow2(v[ijk+jj]))
-                       + TF(0.5)*(fm::pow2(w[ijk])+fm::pow2(w[ijk+kk])))*dz[k];
+            mom[ijk] = TF(0.5)*(u[ijk]+u[ijk+ii])
+                     + TF(0.5)*(v[ijk]+v[ijk+jj])
+                     + TF(0.5)*(w[ijk]+w[ijk+kk]);
+            tke[ijk] = TF(0.5)*(fm::pow2(u[ijk])+fm::pow2(u[ijk+ii]))
+                     + TF(0.5)*(fm::pow2(v[ijk])+fm::pow2(v[ijk+jj]))
+                     + TF(0.5)*(fm::pow2(w[ijk])+fm::pow2(w[ijk+kk]));
         }
     }
 
@@ -169,7 +197,7 @@ namespace
 
 #ifdef USECUDA
 template<typename TF>
-TF Fields<TF>::check_momentum()
+void Fields<TF>::check_conservation(TF& mom, TF& tke, TF& mass)
 {
     auto& gd = grid.get_grid_data();
 
@@ -182,80 +210,45 @@ TF Fields<TF>::check_momentum()
     dim3 blockGPU(blocki, blockj, 1);
 
     auto tmp1 = get_tmp_g();
+    auto tmp2 = get_tmp_g();
+    auto profs = get_tmp_g();
 
-    calc_mom_2nd_g<TF><<<gridGPU, blockGPU>>>(
+    calc_conservation_2nd_g<TF><<<gridGPU, blockGPU>>>(
         mp.at("u")->fld_g, mp.at("v")->fld_g, mp.at("w")->fld_g,
-        tmp1->fld_g, gd.dz_g,
+        tmp1->fld_g, tmp2->fld_g,
         gd.istart, gd.jstart, gd.kstart,
         gd.iend,   gd.jend,   gd.kend,
         gd.icells, gd.ijcells);
     cuda_check_error();
 
-    TF mom = field3d_operators.calc_mean_g(tmp1->fld_g);
+    // The mass is that of the first scalar. The profiles of all three are reduced and summed
+    // over the processes at once, and integrated in height on the host.
+    std::vector<const TF*> flds = {tmp1->fld_g, tmp2->fld_g};
+    if (!sp.empty())
+        flds.push_back(sp.begin()->second->fld_g);
 
-    release_tmp_g(tmp1);
+    const int nfld = flds.size();
+    std::vector<TF*> prof_ptrs(nfld);
+    for (int f=0; f<nfld; ++f)
+        prof_ptrs[f] = profs->fld_g.data() + f*gd.kcells;
 
-    return mom;
-}
-#endif
+    field3d_operators.calc_mean_profiles_g(prof_ptrs, flds);
 
-#ifdef USECUDA
-template<typename TF>
-TF Fields<TF>::check_tke()
-{
-    auto& gd = grid.get_grid_data();
-
-    const int blocki = gd.ithread_block;
-    const int blockj = gd.jthread_block;
-    const int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
-    const int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
-
-    dim3 gridGPU (gridi, gridj, gd.kcells);
-    dim3 blockGPU(blocki, blockj, 1);
-
-    auto tmp1 = get_tmp_g();
-
-    calc_tke_2nd_g<TF><<<gridGPU, blockGPU>>>(
-        mp.at("u")->fld_g, mp.at("v")->fld_g, mp.at("w")->fld_g,
-        tmp1->fld_g, gd.dz_g,
-        gd.istart, gd.jstart, gd.kstart,
-        gd.iend,   gd.jend,   gd.kend,
-        gd.icells, gd.ijcells);
-    cuda_check_error();
-
-    TF tke = field3d_operators.calc_mean_g(tmp1->fld_g);
-    tke *= 0.5;
+    std::vector<TF> prof_cpu(nfld*gd.kcells);
+    cuda_safe_call(cudaMemcpy(prof_cpu.data(), profs->fld_g, nfld*gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost));
 
     release_tmp_g(tmp1);
+    release_tmp_g(tmp2);
+    release_tmp_g(profs);
 
-    return tke;
-}
-#endif
-
-#ifdef USECUDA
-template<typename TF>
-TF Fields<TF>::check_mass()
-{
-    auto& gd = grid.get_grid_data();
+    TF sums[3] = {0, 0, 0};
+    for (int f=0; f<nfld; ++f)
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            sums[f] += prof_cpu[k + f*gd.kcells]*gd.dz[k];
 
-    const int blocki = gd.ithread_block;
-    const int blockj = gd.jthread_block;
-    const int gridi  = gd.imax/blocki + (gd.imax%blocki > 0);
-    const int gridj  = gd.jmax/blockj + (gd.jmax%blockj > 0);
-
-    dim3 gridGPU (gridi, gridj, gd.kcells);
-    dim3 blockGPU(blocki, blockj, 1);
-
-    TF mass;
-
-    // CvH for now, do the mass check on the first scalar... Do we want to change this?
-    auto it = sp.begin();
-    if (sp.begin() != sp.end())
-        mass = field3d_operators.calc_mean_g(it->second->fld_g);
-    else
-        mass = 0;
-
-    return mass;
+    mom  = sums[0] / gd.zsize;
+    tke  = TF(0.5) * sums[1] / gd.zsize;
+    mass = sums[2] / gd.zsize;
 }
 
 template<typename TF>
@@ -264,8 +257,14 @@ void Fields<TF>::exec()
     // calculate the means for the prognostic scalars
     if (calc_mean_profs)
     {
+        std::vector<TF*> profs;
+        std::vector<const TF*> flds;
         for (auto& it : ap)
-            field3d_operators.calc_mean_profile_g(it.second->fld_mean_g, it.second->fld_g);
+        {
+            profs.push_back(it.second->fld_mean_g);
+            flds.push_back(it.second->fld_g);
+        }
+        field3d_operators.calc_mean_profiles_g(profs, flds);
     }
 }
 #endif
@@ -295,6 +294,10 @@ std::shared_ptr<Field3d<TF>> Fields<TF>::get_tmp_g()
             tmp = atmp_g.back();
 
         atmp_g.pop_back();
+
+        ++ntmp_in_use_g;
+        ntmp_peak_g = std::max(ntmp_peak_g, ntmp_in_use_g);
+        ntmp_peak_trim_g = std::max(ntmp_peak_trim_g, ntmp_in_use_g);
     }
 
     // Assign to a huge negative number in case of debug mode.
@@ -312,6 +315,26 @@ void Fields<TF>::release_tmp_g(std::shared_ptr<Field3d<TF>>& tmp)
     {
         cudaDeviceSynchronize();
         atmp_g.push_back(std::move(tmp));
+        --ntmp_in_use_g;
+    }
+}
+
+template<typename TF>
+void Fields<TF>::trim_tmp_g()
+{
+    #pragma omp critical
+    {
+        // The device fields are allocated on first use, but have the same floor as the host fields.
+        const int nkeep_g = std::max(ntmp_peak_trim_g, n_tmp_fields);
+        const int nfree_g = std::max(0, nkeep_g - ntmp_in_use_g);
+
+        if (static_cast<int>(atmp_g.size()) > nfree_g)
+        {
+            cudaDeviceSynchronize();
+            ntmp_allocated_g -= static_cast<int>(atmp_g.size()) - nfree_g;
+            atmp_g.resize(nfree_g);
+        }
+        ntmp_peak_trim_g = ntmp_in_use_g;
     }
 }
 #endif
@@ -360,6 +383,20 @@ void Fields<TF>::prepare_device()
     rhorefi_g.resize(gd.kcells);
     rhorefhi_g.resize(gd.kcells);
 
+    // Page-lock the host arrays that backward_device() copies into. The copy stream is
+    // a blocking stream, such that the copies start after the preceding kernels.
+    for (auto& it : a)
+    {
+        register_host_array(it.second->fld);
+        register_host_array(it.second->fld_bot);
+        register_host_array(it.second->fld_top);
+        register_host_array(it.second->grad_bot);
+        register_host_array(it.second->grad_top);
+        register_host_array(it.second->flux_bot);
+        register_host_array(it.second->flux_top);
+    }
+    cuda_safe_call(cudaStreamCreate(&copy_stream));
+
     // copy all the data to the GPU
     forward_device();
 }
@@ -402,6 +439,16 @@ void Fields<TF>::clear_device()
     // Free the tmp fields
     for (auto& it : atmp_g)
         it->clear_device();
+
+    for (auto& it : registered_host_arrays)
+        cudaHostUnregister(it.second.first);
+    registered_host_arrays.clear();
+
+    if (copy_stream != nullptr)
+    {
+        cudaStreamDestroy(copy_stream);
+        copy_stream = nullptr;
+    }
 }
 
 /**
@@ -457,13 +504,17 @@ void Fields<TF>::forward_device()
  * This function copies all fields required for statistics and output from device to host
  */
 template<typename TF>
-void Fields<TF>::backward_device()
+void Fields<TF>::backward_device(const bool copy_3d)
 {
     auto& gd = grid.get_grid_data();
 
     // Prognostic fields atmosphere
-    for (auto& it : a)
-        backward_field3d_device(it.second.get());
+    if (copy_3d)
+    {
+        for (auto& it : a)
+            backward_field3d_device(it.second.get());
+        cuda_safe_call(cudaStreamSynchronize(copy_stream));
+    }
 
     // Prognostic 2D fields
     for (auto& it : ap2d)
@@ -474,6 +525,155 @@ void Fields<TF>::backward_device()
         backward_soil_field3d_device(it.second.get());
 }
 
+#ifdef USECUFILE
+template<typename TF>
+void Fields<TF>::save_device(const int n)
+{
+    auto& gd = grid.get_grid_data();
+    const TF no_offset = 0.;
+
+    auto tmp = get_tmp_g();
+
+    int nerror = 0;
+
+    for (auto& f : ap)
+    {
+        char filename[256];
+        std::snprintf(filename, 256, "%s.%07d", f.second->name.c_str(), n);
+        master.print_message("Saving \"%s\" from device ... ", filename);
+
+        if (field3d_io.save_field3d_device(
+                    f.second->fld_g, tmp->fld_g, filename, no_offset, gd.kstart, gd.kend))
+        {
+            master.print_message("FAILED\n");
+            ++nerror;
+        }
+        else
+            master.print_message("OK\n");
+    }
+
+    release_tmp_g(tmp);
+
+    if (nerror)
+        throw std::runtime_error("Error saving 3D fields");
+}
+#endif
+
+/**
+ * This function copies only the fields that are written in the cross-sections and dumps
+ * of this class from device to host, for output steps without statistics.
+ */
+template<typename TF>
+void Fields<TF>::backward_device_output(Cross<TF>& cross, const int snapshot)
+{
+    auto& gd = grid.get_grid_data();
+
+    auto unique_names = [](std::vector<std::string> names)
+    {
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        return names;
+    };
+
+    // The host copy of a field is either the field itself, or its copy in the snapshot,
+    // which is allocated on the first use.
+    auto get_host_field = [&](const std::string& name) -> Field3d<TF>&
+    {
+        if (snapshot < 0)
+            return *a.at(name);
+
+        Field_map<TF>& snapshot_fields = output_snapshots[snapshot].a;
+        auto it = snapshot_fields.find(name);
+        if (it == snapshot_fields.end())
+        {
+            const Field3d<TF>& fld = *a.at(name);
+            auto copy = std::make_shared<Field3d<TF>>(master, grid, fld.name, fld.longname, fld.unit, fld.group, fld.loc);
+            if (copy->init())
+                throw std::runtime_error("Error allocating the output snapshot of " + name);
+            it = snapshot_fields.emplace(name, copy).first;
+        }
+
+        return *it->second;
+    };
+
+    auto copy = [&](TF* field, const TF* field_g, const int n)
+    {
+        cuda_safe_call(cudaMemcpyAsync(field, field_g, n*sizeof(TF), cudaMemcpyDeviceToHost, copy_stream));
+    };
+
+    // The dumps, the gradients and the paths need the full field.
+    std::vector<std::string> names_3d = dumplist;
+    for (auto* list : {&cross_lngrad, &cross_path})
+        names_3d.insert(names_3d.end(), list->begin(), list->end());
+    names_3d = unique_names(names_3d);
+
+    auto is_copied = [&](const std::string& name)
+    {
+        return std::binary_search(names_3d.begin(), names_3d.end(), name);
+    };
+
+    for (auto& name : names_3d)
+    {
+        const Field3d<TF>& fld = *a.at(name);
+        Field3d<TF>& host = get_host_field(name);
+
+        copy(host.fld.data(),      fld.fld_g,      gd.ncells );
+        copy(host.fld_bot.data(),  fld.fld_bot_g,  gd.ijcells);
+        copy(host.fld_top.data(),  fld.fld_top_g,  gd.ijcells);
+        copy(host.flux_bot.data(), fld.flux_bot_g, gd.ijcells);
+        copy(host.flux_top.data(), fld.flux_top_g, gd.ijcells);
+    }
+
+    // Of the other cross-sections, only the planes that are written are copied. The strided
+    // copies gather the xz and yz planes on the device, such that each is a single transfer.
+    std::vector<int> kplanes, jplanes, iplanes;
+    for (auto& name : unique_names(cross_simple))
+    {
+        if (is_copied(name))
+            continue;
+
+        const Field3d<TF>& fld = *a.at(name);
+        Field3d<TF>& host = get_host_field(name);
+        cross.get_local_planes(kplanes, jplanes, iplanes, fld.loc);
+
+        for (const int k : kplanes)
+            copy(host.fld.data() + k*gd.ijcells, fld.fld_g + k*gd.ijcells, gd.ijcells);
+
+        for (const int j : jplanes)
+            cuda_safe_call(cudaMemcpy2DAsync(
+                    host.fld.data() + j*gd.icells, gd.ijcells*sizeof(TF),
+                    fld.fld_g + j*gd.icells, gd.ijcells*sizeof(TF),
+                    gd.icells*sizeof(TF), gd.kcells,
+                    cudaMemcpyDeviceToHost, copy_stream));
+
+        for (const int i : iplanes)
+            cuda_safe_call(cudaMemcpy2DAsync(
+                    host.fld.data() + i, gd.icells*sizeof(TF),
+                    fld.fld_g + i, gd.icells*sizeof(TF),
+                    sizeof(TF), gd.jcells*gd.kcells,
+                    cudaMemcpyDeviceToHost, copy_stream));
+    }
+
+    // The surface cross-sections only need their 2D field.
+    for (auto& name : cross_bot)
+        if (!is_copied(name))
+            copy(get_host_field(name).fld_bot.data(), a.at(name)->fld_bot_g, gd.ijcells);
+
+    for (auto& name : cross_top)
+        if (!is_copied(name))
+            copy(get_host_field(name).fld_top.data(), a.at(name)->fld_top_g, gd.ijcells);
+
+    for (auto& name : cross_fluxbot)
+        if (!is_copied(name))
+            copy(get_host_field(name).flux_bot.data(), a.at(name)->flux_bot_g, gd.ijcells);
+
+    for (auto& name : cross_fluxtop)
+        if (!is_copied(name))
+            copy(get_host_field(name).flux_top.data(), a.at(name)->flux_top_g, gd.ijcells);
+
+    cuda_safe_call(cudaStreamSynchronize(copy_stream));
+}
+
 /**
  * This function copies a field3d instance from host to device
  * @param fld Pointer to field3d instance
@@ -520,14 +720,25 @@ template<typename TF>
 void Fields<TF>::backward_field3d_device(Field3d<TF>* fld)
 {
     auto& gd = grid.get_grid_data();
-    backward_field_device_3d(fld->fld.data(),      fld->fld_g     );
-    backward_field_device_2d(fld->fld_bot.data(),  fld->fld_bot_g );
-    backward_field_device_2d(fld->fld_top.data(),  fld->fld_top_g );
-    backward_field_device_2d(fld->grad_bot.data(), fld->grad_bot_g);
-    backward_field_device_2d(fld->grad_top.data(), fld->grad_top_g);
-    backward_field_device_2d(fld->flux_bot.data(), fld->flux_bot_g);
-    backward_field_device_2d(fld->flux_top.data(), fld->flux_top_g);
-    backward_field_device(fld->fld_mean.data(), fld->fld_mean_g, gd.kcells);
+
+    // The copies are queued on the copy stream, the caller synchronizes the stream.
+    auto copy = [&](TF* field, const TF* field_g, const int n)
+    {
+        cuda_safe_call(cudaMemcpyAsync(field, field_g, n*sizeof(TF), cudaMemcpyDeviceToHost, copy_stream));
+    };
+
+    for (auto* array : {&fld->fld, &fld->fld_bot, &fld->fld_top, &fld->grad_bot,
+                        &fld->grad_top, &fld->flux_bot, &fld->flux_top})
+        update_host_array(*array);
+
+    copy(fld->fld.data(),      fld->fld_g,      gd.ncells );
+    copy(fld->fld_bot.data(),  fld->fld_bot_g,  gd.ijcells);
+    copy(fld->fld_top.data(),  fld->fld_top_g,  gd.ijcells);
+    copy(fld->grad_bot.data(), fld->grad_bot_g, gd.ijcells);
+    copy(fld->grad_top.data(), fld->grad_top_g, gd.ijcells);
+    copy(fld->flux_bot.data(), fld->flux_bot_g, gd.ijcells);
+    copy(fld->flux_top.data(), fld->flux_top_g, gd.ijcells);
+    copy(fld->fld_mean.data(), fld->fld_mean_g, gd.kcells );
 }
 
 /**
@@ -23,6 +23,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
 #include <sstream>
 #include <iostream>
@@ -43,6 +44,7 @@
 #include "dump.h"
 #include "diff.h"
 #include "fast_math.h"
+#include "constants.h"
 
    
 namespace
@@ -248,9 +250,13 @@ namespace
             }
     }
 
+    // Volume means of the momentum, the kinetic energy and the first scalar in a single
+    // sweep, which are summed over the processes at once.
     template<typename TF>
-    TF calc_momentum_2nd(
+    void calc_conservation_2nd(
+            TF& momentum, TF& tke, TF& mass,
             const TF* restrict u, const TF* restrict v, const TF* restrict w,
+            const TF* restrict s,
             const TF* restrict dz, const TF itot_jtot_zsize,
             const int istart, const int iend,
             const int jstart, const int jend,
@@ -262,82 +268,37 @@ namespace
 
         const int ii = 1;
 
-        TF momentum = 0;
+        TF sums[3] = {0, 0, 0};
 
         for (int k=kstart; k<kend; ++k)
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    momentum += (interp2(u[ijk], u[ijk+ii]) + interp2(v[ijk], v[ijk+jj]) + interp2(w[ijk], w[ijk+kk]))*dz[k];
-                }
-
-        master.sum(&momentum, 1);
-        momentum /= itot_jtot_zsize;
-
-        return momentum;
-    }
-
-    template<typename TF>
-    TF calc_tke_2nd(
-            const TF* restrict u, const TF* restrict v, const TF* restrict w,
-            const TF* restrict dz, const TF itot_jtot_zsize,
-            const int istart, const int iend,
-            const int jstart, const int jend,
-            const int kstart, const int kend,
-            const int jj, const int kk,
-            Master& master)
-    {
-        using Finite_difference::O2::interp2;
-
-        const int ii = 1;
-
-        TF tke = 0;
+        {
+            TF mom_k = 0;
+            TF tke_k = 0;
+            TF mass_k = 0;
 
-        for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
                 for (int i=istart; i<iend; ++i)
                 {
                     const int ijk = i + j*jj + k*kk;
-                    tke += ( interp2(u[ijk]*u[ijk], u[ijk+ii]*u[ijk+ii])
+                    mom_k += interp2(u[ijk], u[ijk+ii]) + interp2(v[ijk], v[ijk+jj]) + interp2(w[ijk], w[ijk+kk]);
+                    tke_k += interp2(u[ijk]*u[ijk], u[ijk+ii]*u[ijk+ii])
                            + interp2(v[ijk]*v[ijk], v[ijk+jj]*v[ijk+jj])
-                           + interp2(w[ijk]*w[ijk], w[ijk+kk]*w[ijk+kk]))*dz[k];
+                           + interp2(w[ijk]*w[ijk], w[ijk+kk]*w[ijk+kk]);
+                    if (s != nullptr)
+                        mass_k += s[ijk];
                 }
 
-        master.sum(&tke, 1);
-        tke /= itot_jtot_zsize;
-        tke *= 0.5;
-
-        return tke;
-    }
-
-    template<typename TF>
-    TF calc_mass(
-            const TF* restrict s,
-            const TF* restrict dz, const TF itot_jtot_zsize,
-            const int istart, const int iend,
-            const int jstart, const int jend,
-            const int kstart, const int kend,
-            const int jj, const int kk,
-            Master& master)
-    {
-        TF mass = 0;
-
-        for (int k=kstart; k<kend; ++k)
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    mass += s[ijk]*dz[k];
-                }
+            sums[0] += mom_k*dz[k];
+            sums[1] += tke_k*dz[k];
+            sums[2] += mass_k*dz[k];
+        }
 
-        master.sum(&mass, 1);
-        mass /= itot_jtot_zsize;
+        master.sum(sums, 3);
 
-        return mass;
+        momentum = sums[0] / itot_jtot_zsize;
+        tke = TF(0.5) * sums[1] / itot_jtot_zsize;
+        mass = sums[2] / itot_jtot_zsize;
     }
 
     std::pair<std::string, int> split_unit(const std::string s, const int pow)
@@ -426,6 +387,18 @@ Fields<TF>::Fields(Master& masterin, Grid<TF>& gridin, Soil_grid<TF>& soilgridin
     // Set a default of 4 temporary fields. Other classes can increase this number
     // before the init phase, where they are initialized in Fields::init()
     n_tmp_fields = 4;
+    ntmp_allocated = 0;
+    ntmp_allocated_g = 0;
+    ntmp_in_use = 0;
+    ntmp_in_use_g = 0;
+    ntmp_peak = 0;
+    ntmp_peak_g = 0;
+    ntmp_peak_trim = 0;
+    ntmp_peak_trim_g = 0;
+
+    // No substep has been stamped yet, such that none of the shared diagnostics is current.
+    substep_itime = Constants::ulhuge;
+    substep = -1;
 
     // Specify the masks that fields can provide / calculate
     available_masks.insert(available_masks.end(), {"default", "wplus", "wmin"});
@@ -433,6 +406,106 @@ Fields<TF>::Fields(Master& masterin, Grid<TF>& gridin, Soil_grid<TF>& soilgridin
     // Add user specified XY masks as available masks
     xymasklist = input.get_list<std::string>("stats", "xymasklist", "", std::vector<std::string>());
     available_masks.insert(available_masks.end(), xymasklist.begin(), xymasklist.end());
+
+    // Restarts on GPU builds are already written in a separate task.
+    swasyncsave = false;
+    #ifndef USECUDA
+    swasyncsave = input.get_item<bool>("fields", "swasyncsave", "", false);
+    #endif
+
+    save_slot_next = 0;
+    for (auto& slot : save_slots)
+        slot.pending = false;
+
+    // Host snapshots of the standalone cross-sections and dumps, which let their output tasks overlap.
+    noutputsnapshots = 0;
+    #ifdef USECUDA
+    noutputsnapshots = input.get_item<int>("fields", "noutputsnapshots", "", 0);
+    #else
+    input.flag_as_used("fields", "noutputsnapshots", "");
+    #endif
+
+    if (noutputsnapshots < 0)
+        throw std::runtime_error("The number of output snapshots cannot be negative");
+
+    output_snapshot_active = -1;
+    output_snapshots.resize(noutputsnapshots);
+    for (auto& snapshot : output_snapshots)
+        snapshot.busy = 0;
+
+    // Optionally, write all prognostic fields of a restart time to a single file.
+    swrestartfile = input.get_item<bool>("fields", "swrestartfile", "", false);
+    if (swrestartfile)
+    {
+        const int striping_factor = input.get_item<int>("fields", "restartstriping", "", 0);
+        const int cb_nodes = input.get_item<int>("fields", "restartcbnodes", "", 0);
+        field3d_io.set_io_hints(striping_factor, cb_nodes);
+    }
+
+    if (swrestartfile && swasyncsave)
+        throw std::runtime_error("swrestartfile and swasyncsave cannot be combined");
+
+    // Restarts are compressed lossless only, in order to keep the restarts bitwise identical.
+    const int compresslevel = input.get_item<int>("fields", "compresslevel", "", 0);
+    if (compresslevel > 0 && (swrestartfile || swasyncsave))
+        throw std::runtime_error("compresslevel cannot be combined with swrestartfile or swasyncsave");
+    field3d_io.set_compression(compresslevel, TF(0.));
+
+    // Optionally, save and load every block of the restarts in a file of its own (N-N), which avoids the
+    // lock contention of the shared files on large process counts. Such files are merged with microhh_merge.
+    const bool swfileperrank = input.get_item<bool>("fields", "swfileperrank", "", false);
+    if (swfileperrank && (swrestartfile || swasyncsave || compresslevel > 0))
+        throw std::runtime_error("swfileperrank cannot be combined with swrestartfile, swasyncsave or compresslevel");
+    field3d_io.set_file_per_rank(swfileperrank);
+
+    // Write per-level checksums next to the restart files, which are verified when they are loaded.
+    swchecksum = input.get_item<bool>("fields", "swchecksum", "", false);
+
+    // Write the restart files of the 3D fields directly from device memory with GPUDirect Storage,
+    // in the file-per-rank format, such that they are loaded as any other file-per-rank restart.
+    swgds = input.get_item<bool>("fields", "swgds", "", false);
+    if (swgds)
+    {
+        #if !defined(USECUDA) || !defined(USECUFILE)
+        throw std::runtime_error("swgds requires a CUDA build with USECUFILE");
+        #endif
+
+        if (!swfileperrank || swchecksum)
+            throw std::runtime_error("swgds requires swfileperrank and cannot be combined with swchecksum");
+    }
+
+    // Back the prognostic, tendency, and tmp fields with transparent huge pages.
+    swhugepages = input.get_item<bool>("fields", "swhugepages", "", false);
+
+    // Free the tmp fields that were only needed in a burst of borrows, such as in the output steps.
+    swtrimtmp = input.get_item<bool>("fields", "swtrimtmp", "", false);
+
+    // Localised tracers are advected and diffused only in a box around the values above the
+    // threshold. The box is updated every substep, and the margin covers the stencils.
+    activebox_list = input.get_list<std::string>("fields", "activebox_list", "", std::vector<std::string>());
+    activebox_threshold = input.get_item<TF>("fields", "activebox_threshold", "", 0.);
+    activebox_margin = input.get_item<int>("fields", "activebox_margin", "", 4);
+
+    #ifdef USECUDA
+    if (!activebox_list.empty())
+        throw std::runtime_error("activebox_list is not supported on the GPU");
+    #endif
+
+    // Slowly varying scalars, such as long lived tracers, can be diffused with a longer time step.
+    // Their advection can be done over the same interval by Advec_split.
+    for (auto& name : input.get_list<std::string>("fields", "slowlist", "", std::vector<std::string>()))
+    {
+        const int nsteps = input.get_item<int>("fields", "slowsteps", name);
+        if (nsteps < 1)
+            throw std::runtime_error("The slowsteps of \"" + name + "\" in [fields] has to be at least 1");
+        slow_steps[name] = nsteps;
+    }
+    slow_iteration = 0;
+
+    #ifdef USECUDA
+    if (!slow_steps.empty())
+        throw std::runtime_error("slowlist is not supported on the GPU");
+    #endif
 }
 
 template<typename TF>
@@ -451,19 +524,19 @@ void Fields<TF>::init(Input& input, Dump<TF>& dump, Cross<TF>& cross, const Sim_
     // ALLOCATE ALL THE FIELDS
     // allocate the prognostic velocity fields
     for (auto& it : mp)
-        nerror += it.second->init();
+        nerror += it.second->init(swhugepages);
 
     // allocate the velocity tendency fields
     for (auto& it : mt)
-        nerror += it.second->init();
+        nerror += it.second->init(swhugepages);
 
     // allocate the prognostic scalar fields
     for (auto& it : sp)
-        nerror += it.second->init();
+        nerror += it.second->init(swhugepages);
 
     // allocate the scalar tendency fields
     for (auto& it : st)
-        nerror += it.second->init();
+        nerror += it.second->init(swhugepages);
 
     // allocate the diagnostic scalars
     for (auto& it : sd)
@@ -487,13 +560,19 @@ void Fields<TF>::init(Input& input, Dump<TF>& dump, Cross<TF>& cross, const Sim_
 
     // allocate the tmp fields
     for (auto& tmp : atmp)
-        nerror += tmp->init();
+        nerror += tmp->init(swhugepages);
 
     master.sum(&nerror, 1);
 
     if (nerror)
         throw std::runtime_error("Error allocating fields");
 
+    init_registry();
+
+    for (auto& it : slow_steps)
+        if (sp.find(it.first) == sp.end())
+            throw std::runtime_error("Field \"" + it.first + "\" in the slowlist of [fields] is not a prognostic scalar");
+
     rhoref .resize(gd.kcells);
     rhorefh.resize(gd.kcells);
 
@@ -531,6 +610,7 @@ void Fields<TF>::init(Input& input, Dump<TF>& dump, Cross<TF>& cross, const Sim_
         }
 
         input.flag_as_used("fields", "rndseed", "");
+        input.flag_as_used("fields", "swrndcounter", "");
 
         input.flag_as_used("fields", "vortexnpair", "");
         input.flag_as_used("fields", "vortexamp", "");
@@ -545,12 +625,166 @@ void Fields<TF>::exec()
     // calculate the means for the prognostic scalars
     if (calc_mean_profs)
     {
+        std::vector<TF*> profs;
+        std::vector<const TF*> flds;
         for (auto& it : ap)
-            field3d_operators.calc_mean_profile(it.second->fld_mean.data(), it.second->fld.data());
+        {
+            profs.push_back(it.second->fld_mean.data());
+            flds.push_back(it.second->fld.data());
+        }
+        field3d_operators.calc_mean_profiles(profs, flds);
     }
 }
 #endif
 
+template<typename TF>
+void Fields<TF>::update_active_boxes()
+{
+    auto& gd = grid.get_grid_data();
+
+    // The kernels treat the three levels below the top wall separately, which requires the
+    // lowered top to stay at least six levels above the bottom.
+    const int kend_min = std::min(gd.kstart+6, gd.kend);
+
+    for (auto& name : activebox_list)
+    {
+        const TF* const restrict s = sp.at(name)->fld.data();
+        const TF* const restrict flux_bot = sp.at(name)->flux_bot.data();
+        const TF* const restrict flux_top = sp.at(name)->flux_top.data();
+
+        // Include the ghost cells, such that a tracer that enters from a neighbour opens the box.
+        // The top ghost cell is included as well, such that a tracer at the top keeps the full column.
+        int imin = gd.icells;
+        int imax = -1;
+        int jmin = gd.jcells;
+        int jmax = -1;
+        int kmax = -1;
+
+        #pragma omp parallel for reduction(min:imin,jmin) reduction(max:imax,jmax,kmax)
+        for (int k=gd.kstart; k<gd.kend+1; ++k)
+            for (int j=0; j<gd.jcells; ++j)
+                for (int i=0; i<gd.icells; ++i)
+                {
+                    const int ijk = i + j*gd.icells + k*gd.ijcells;
+                    if (std::abs(s[ijk]) > activebox_threshold)
+                    {
+                        imin = std::min(imin, i);
+                        imax = std::max(imax, i);
+                        jmin = std::min(jmin, j);
+                        jmax = std::max(jmax, j);
+                        kmax = std::max(kmax, k);
+                    }
+                }
+
+        // The columns with a boundary flux are part of the box, as the flux is only applied inside it.
+        // A top flux keeps the full height, as the top level applies it.
+        bool has_flux_top = false;
+        for (int j=0; j<gd.jcells; ++j)
+            for (int i=0; i<gd.icells; ++i)
+            {
+                const int ij = i + j*gd.icells;
+                const bool top = (flux_top[ij] != TF(0.));
+                if (top || flux_bot[ij] != TF(0.))
+                {
+                    imin = std::min(imin, i);
+                    imax = std::max(imax, i);
+                    jmin = std::min(jmin, j);
+                    jmax = std::max(jmax, j);
+                    kmax = std::max(kmax, gd.kstart);
+                    has_flux_top = has_flux_top || top;
+                }
+            }
+
+        Active_box box = {gd.istart, gd.istart, gd.jstart, gd.jstart, gd.kend};
+        if (imax >= 0)
+        {
+            box.istart = std::max(imin - activebox_margin, gd.istart);
+            box.iend   = std::min(imax + activebox_margin + 1, gd.iend);
+            box.jstart = std::max(jmin - activebox_margin, gd.jstart);
+            box.jend   = std::min(jmax + activebox_margin + 1, gd.jend);
+
+            if (!has_flux_top)
+                box.kend = std::min(std::max(kmax + activebox_margin + 1, kend_min), gd.kend);
+
+            if (box.istart >= box.iend || box.jstart >= box.jend)
+                box = {gd.istart, gd.istart, gd.jstart, gd.jstart, gd.kend};
+        }
+
+        active_boxes[name] = box;
+    }
+}
+
+template<typename TF>
+typename Fields<TF>::Active_box Fields<TF>::get_active_box(const std::string& name) const
+{
+    auto it = active_boxes.find(name);
+    if (it != active_boxes.end())
+        return it->second;
+
+    auto& gd = grid.get_grid_data();
+    return {gd.istart, gd.iend, gd.jstart, gd.jend, gd.kend};
+}
+
+template<typename TF>
+bool Fields<TF>::is_slow_skipped(const std::string& name) const
+{
+    auto it = slow_steps.find(name);
+    return it != slow_steps.end() && slow_iteration % it->second != 0;
+}
+
+template<typename TF>
+int Fields<TF>::get_slow_steps_max() const
+{
+    int nsteps = 1;
+    for (auto& it : slow_steps)
+        nsteps = std::max(nsteps, it.second);
+    return nsteps;
+}
+
+template<typename TF>
+void Fields<TF>::begin_slow_tendencies(const int iteration)
+{
+    // All substeps of a time step diffuse the same slow scalars.
+    slow_iteration = iteration;
+
+    auto& gd = grid.get_grid_data();
+
+    for (auto& it : slow_steps)
+    {
+        if (it.second == 1 || is_slow_skipped(it.first))
+            continue;
+
+        std::vector<TF>& start = slow_tend_start[it.first];
+        const std::vector<TF>& st_fld = st.at(it.first)->fld;
+        start.resize(gd.ncells);
+
+        #pragma omp parallel for
+        for (int n=0; n<gd.ncells; ++n)
+            start[n] = st_fld[n];
+    }
+}
+
+template<typename TF>
+void Fields<TF>::end_slow_tendencies()
+{
+    auto& gd = grid.get_grid_data();
+
+    // The diffusion is flux conservative, such that the scaled tendency conserves the scalar as well.
+    for (auto& it : slow_steps)
+    {
+        if (it.second == 1 || is_slow_skipped(it.first))
+            continue;
+
+        const TF* const restrict start = slow_tend_start.at(it.first).data();
+        TF* const restrict st_fld = st.at(it.first)->fld.data();
+        const TF nsteps = it.second;
+
+        #pragma omp parallel for
+        for (int n=0; n<gd.ncells; ++n)
+            st_fld[n] = start[n] + nsteps * (st_fld[n] - start[n]);
+    }
+}
+
 
 template<typename TF>
 void Fields<TF>::create_dump(Dump<TF>& dump)
@@ -574,6 +808,9 @@ void Fields<TF>::create_dump(Dump<TF>& dump)
             else
                 ++dumpvar;
         }
+
+        // The remaining variables are dumped by other classes, which need the full state on the host.
+        dump_standalone = dumplist_global.empty();
     }
 }
 
@@ -604,6 +841,8 @@ void Fields<TF>::create_cross(Cross<TF>& cross)
             check_added_cross(it.first, "",        crosslist_global, cross_simple);
             check_added_cross(it.first, "_lngrad",  crosslist_global, cross_lngrad);
         }
+
+        cross_standalone = crosslist_global.empty();
     }
 }
 
@@ -640,12 +879,16 @@ std::shared_ptr<Field3d<TF>> Fields<TF>::get_tmp()
         {
             init_tmp_field();
             tmp = atmp.back();
-            tmp->init();
+            tmp->init(swhugepages);
         }
         else
             tmp = atmp.back();
 
         atmp.pop_back();
+
+        ++ntmp_in_use;
+        ntmp_peak = std::max(ntmp_peak, ntmp_in_use);
+        ntmp_peak_trim = std::max(ntmp_peak_trim, ntmp_in_use);
     }
     return tmp;
 }
@@ -659,7 +902,112 @@ void Fields<TF>::release_tmp(std::shared_ptr<Field3d<TF>>& tmp)
             throw std::runtime_error("Cannot release a tmp field with value nullptr");
 
         atmp.push_back(std::move(tmp));
+        --ntmp_in_use;
+    }
+}
+
+template<typename TF>
+void Fields<TF>::trim_tmp()
+{
+    if (!swtrimtmp)
+        return;
+
+    #pragma omp critical
+    {
+        // Keep at least the tmp fields that the modules asked for before the init phase.
+        const int nkeep = std::max(ntmp_peak_trim, n_tmp_fields);
+        const int nfree = std::max(0, nkeep - ntmp_in_use);
+
+        if (static_cast<int>(atmp.size()) > nfree)
+        {
+            ntmp_allocated -= static_cast<int>(atmp.size()) - nfree;
+            atmp.resize(nfree);
+        }
+        ntmp_peak_trim = ntmp_in_use;
     }
+
+    #ifdef USECUDA
+    trim_tmp_g();
+    #endif
+}
+
+template<typename TF>
+int Fields<TF>::get_free_output_snapshot()
+{
+    // The output tasks hand back their snapshot while the main thread looks for a free one.
+    for (int n=0; n<noutputsnapshots; ++n)
+    {
+        int busy;
+        #pragma omp atomic read
+        busy = output_snapshots[n].busy;
+
+        if (!busy)
+        {
+            #pragma omp atomic write
+            output_snapshots[n].busy = 1;
+            return n;
+        }
+    }
+
+    return -1;
+}
+
+template<typename TF>
+void Fields<TF>::set_output_snapshot(const int snapshot)
+{
+    output_snapshot_active = snapshot;
+}
+
+template<typename TF>
+void Fields<TF>::release_output_snapshot(const int snapshot)
+{
+    output_snapshot_active = -1;
+
+    if (snapshot >= 0)
+    {
+        #pragma omp atomic write
+        output_snapshots[snapshot].busy = 0;
+    }
+}
+
+template<typename TF>
+Field_map<TF>& Fields<TF>::get_output_fields()
+{
+    return (output_snapshot_active >= 0) ? output_snapshots[output_snapshot_active].a : a;
+}
+
+template<typename TF>
+void Fields<TF>::set_substep(const unsigned long itime, const int substep_in)
+{
+    substep_itime = itime;
+    substep = substep_in;
+}
+
+template<typename TF>
+std::shared_ptr<Field3d<TF>> Fields<TF>::get_substep_diagnostic(const std::string& name, bool& is_current)
+{
+    auto it = substep_diagnostics.find(name);
+
+    // The field is taken from the tmp fields on its first use and kept from then on.
+    if (it == substep_diagnostics.end())
+    {
+        #ifdef USECUDA
+        auto fld = get_tmp_g();
+        #else
+        auto fld = get_tmp();
+        #endif
+
+        it = substep_diagnostics.emplace(name, Substep_diagnostic{fld, Constants::ulhuge, -1}).first;
+    }
+
+    Substep_diagnostic& diag = it->second;
+
+    is_current = (diag.itime == substep_itime && diag.substep == substep && substep >= 0);
+
+    diag.itime = substep_itime;
+    diag.substep = substep;
+
+    return diag.fld;
 }
 
 template<typename TF>
@@ -762,12 +1110,23 @@ void Fields<TF>::exec_stats(Stats<TF>& stats)
     const TF no_offset = 0.;
     const TF no_threshold = 0.;
 
+    // The prognostic fields are up to date on the device, such that their mean
+    // and moments can be reduced on the GPU.
+    #ifdef USECUDA
+    stats.calc_stats_g("w", *mp.at("w"), no_offset, no_threshold);
+    stats.calc_stats_g("u", *mp.at("u"), gd.utrans, no_threshold);
+    stats.calc_stats_g("v", *mp.at("v"), gd.vtrans, no_threshold);
+
+    for (auto& it : sp)
+        stats.calc_stats_g(it.first, *it.second, no_offset, no_threshold);
+    #else
     stats.calc_stats("w", *mp.at("w"), no_offset, no_threshold);
     stats.calc_stats("u", *mp.at("u"), gd.utrans, no_threshold);
     stats.calc_stats("v", *mp.at("v"), gd.vtrans, no_threshold);
 
     for (auto& it : sp)
         stats.calc_stats(it.first, *it.second, no_offset, no_threshold);
+    #endif
 
     for (auto& it : sp)
         stats.calc_stats_2d(it.first + "_bot", it.second->fld_bot, no_offset);
@@ -779,12 +1138,23 @@ void Fields<TF>::exec_stats(Stats<TF>& stats)
     {
         for (auto& it2 : ap)
         {
+            #ifdef USECUDA
+            stats.calc_joint_hist_g(it1.first, *it1.second, it2.first, *it2.second);
+            #else
+            stats.calc_joint_hist(it1.first, *it1.second, it2.first, *it2.second);
+            #endif
+
             for (int pow1 = 1; pow1<5; ++pow1)
             {
                 for (int pow2 = 1; pow2<5; ++pow2)
                 {
+                    #ifdef USECUDA
+                    stats.calc_covariance_g(it1.first, *it1.second, no_offset, no_threshold, pow1,
+                                            it2.first, *it2.second, no_offset, no_threshold, pow2);
+                    #else
                     stats.calc_covariance(it1.first, *it1.second, no_offset, no_threshold, pow1,
                                           it2.first, *it2.second, no_offset, no_threshold, pow2);
+                    #endif
                 }
             }
         }
@@ -845,6 +1215,38 @@ void Fields<TF>::set_calc_mean_profs(bool sw)
     calc_mean_profs = sw;
 }
 
+template<typename TF>
+void Fields<TF>::init_registry()
+{
+    prog_names.clear();
+    prog_fields.clear();
+    prog_tends.clear();
+
+    auto add = [&](Field_map<TF>& fld_map, Field_map<TF>& tend_map)
+    {
+        for (auto& it : fld_map)
+        {
+            prog_names.push_back(it.first);
+            prog_fields.push_back(it.second.get());
+            prog_tends.push_back(tend_map.at(it.first).get());
+        }
+    };
+
+    add(mp, mt);
+    n_momentum_handles = prog_fields.size();
+    add(sp, st);
+}
+
+template<typename TF>
+int Fields<TF>::get_handle(const std::string& name) const
+{
+    auto it = std::find(prog_names.begin(), prog_names.end(), name);
+    if (it == prog_names.end())
+        throw std::runtime_error("\"" + name + "\" is not a prognostic field");
+
+    return it - prog_names.begin();
+}
+
 template<typename TF>
 void Fields<TF>::init_momentum_field(
         const std::string& fldname, const std::string& longname,
@@ -958,9 +1360,8 @@ void Fields<TF>::init_diagnostic_field(
 template<typename TF>
 void Fields<TF>::init_tmp_field()
 {
-    static int ntmp = 0;
-    ++ntmp;
-    std::string fldname = "tmp" + std::to_string(ntmp);
+    ++ntmp_allocated;
+    std::string fldname = "tmp" + std::to_string(ntmp_allocated);
     std::string longname = "";
     std::string unit = "";
     std::string group = "tmp_group";
@@ -975,9 +1376,8 @@ void Fields<TF>::init_tmp_field()
 template<typename TF>
 void Fields<TF>::init_tmp_field_g()
 {
-    static int ntmp = 0;
-    ++ntmp;
-    std::string fldname = "tmp_gpu" + std::to_string(ntmp);
+    ++ntmp_allocated_g;
+    std::string fldname = "tmp_gpu" + std::to_string(ntmp_allocated_g);
     std::string longname = "";
     std::string unit = "";
     std::string group = "tmp_group";
@@ -1031,6 +1431,37 @@ void Fields<TF>::create(Input& input, Netcdf_file& input_nc)
     }
 }
 
+namespace
+{
+    // SplitMix64 finalizer, which maps a counter to a well-mixed 64-bit value.
+    inline uint64_t mix_counter(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // FNV-1a hash of the field name, such that every field gets its own stream.
+    inline uint64_t hash_name(const std::string& name)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (const char c : name)
+        {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    // Uniform random number in [0, 1) that only depends on the seed, the field and the global
+    // grid point, and thus not on the decomposition or the order in which points are visited.
+    inline double counter_random(const uint64_t key, const uint64_t n)
+    {
+        return (mix_counter(key ^ mix_counter(n)) >> 11) * 0x1.0p-53;
+    }
+}
+
 template<typename TF>
 void Fields<TF>::randomize(Input& input, std::string fld, TF* const restrict data)
 {
@@ -1067,6 +1498,34 @@ void Fields<TF>::randomize(Input& input, std::string fld, TF* const restrict dat
     // Issue a warning if the randomization depth is larger than zero, but less than the first model level.
     if (kendrnd == gd.kstart && rndz > 0.)
         master.print_warning("randomization depth is less than the height of the first model level\n");
+
+    // The counter-based generator draws the value of every point from its global index, which
+    // gives the same perturbations for every decomposition and allows the loop to be threaded.
+    if (input.get_item<bool>("fields", "swrndcounter", "", false))
+    {
+        auto& md = master.get_MPI_data();
+
+        const uint64_t key = mix_counter(
+                hash_name(fld) ^ static_cast<uint64_t>(input.get_item<int>("fields", "rndseed", "", 0)));
+        const int ioffset = md.mpicoordx*gd.imax - gd.istart;
+        const int joffset = md.mpicoordy*gd.jmax - gd.jstart;
+
+        #pragma omp parallel for
+        for (int k=gd.kstart; k<kendrnd; ++k)
+        {
+            const TF rndfac = std::pow((rndz-gd.z[k])/rndz, rndexp);
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const uint64_t n =
+                            (static_cast<uint64_t>(k-gd.kstart)*gd.jtot + (j+joffset))*gd.itot + (i+ioffset);
+                    data[ijk] = rndfac * rndamp * (TF(counter_random(key, n)) - TF(0.5));
+                }
+        }
+        return;
+    }
+
     for (int k=gd.kstart; k<kendrnd; ++k)
     {
         const TF rndfac = std::pow((rndz-gd.z[k])/rndz, rndexp);
@@ -1239,13 +1698,53 @@ void Fields<TF>::create_column(Column<TF>& column)
 template<typename TF>
 void Fields<TF>::save(int n)
 {
+    #if defined(USECUDA) && defined(USECUFILE)
+    if (swgds)
+    {
+        save_device(n);
+        return;
+    }
+    #endif
+
     auto& gd = grid.get_grid_data();
     const TF no_offset = 0.;
 
-    auto tmp1 = get_tmp();
-    auto tmp2 = get_tmp();
+    // The buffers return to the pool on every way out of this function.
+    auto tmp1 = get_scoped_tmp();
+    auto tmp2 = get_scoped_tmp();
 
     int nerror = 0;
+
+    if (swrestartfile)
+    {
+        std::vector<std::pair<std::string, TF*>> restart_fields;
+        for (auto& f : ap)
+            restart_fields.emplace_back(f.second->name, f.second->fld.data());
+
+        char filename[256];
+        std::snprintf(filename, 256, "restart.%07d", n);
+        master.print_message("Saving \"%s\" ... ", filename);
+
+        if (field3d_io.save_restart_file(
+                    restart_fields, tmp1->fld.data(), tmp2->fld.data(),
+                    filename, gd.kstart, gd.kend))
+        {
+            master.print_message("FAILED\n");
+            ++nerror;
+        }
+        else
+        {
+            master.print_message("OK\n");
+        }
+
+        nerror += save_checksums(n);
+        master.sum(&nerror, 1);
+
+        if (nerror)
+            throw std::runtime_error("Error saving 3D fields");
+
+        return;
+    }
     for (auto& f : ap)
     {
         char filename[256];
@@ -1268,13 +1767,178 @@ void Fields<TF>::save(int n)
         }
     }
 
+    nerror += save_checksums(n);
+    master.sum(&nerror, 1);
+
+    if (nerror)
+        throw std::runtime_error("Error saving 3D fields");
+}
+
+template<typename TF>
+void Fields<TF>::save_begin(int n)
+{
+    auto& gd = grid.get_grid_data();
+    const TF no_offset = 0.;
+    const int count = gd.imax*gd.jmax*gd.kmax;
+
+    Save_slot& slot = save_slots[save_slot_next];
+    save_slot_next = 1 - save_slot_next;
+
+    if (slot.pending)
+        finish_save_slot(slot);
+
+    slot.buffer.resize(ap.size()*count);
+    slot.requests.resize(ap.size());
+
+    auto tmp1 = get_tmp();
+
+    int nerror = 0;
+    int nfld = 0;
+    std::vector<int> started(ap.size(), 0);
+    for (auto& f : ap)
+    {
+        char filename[256];
+        std::snprintf(filename, 256, "%s.%07d", f.second->name.c_str(), n);
+        master.print_message("Staging \"%s\" ... ", filename);
+
+        // The offset is kept at zero, because otherwise bitwise identical restarts are not possible.
+        if (field3d_io.save_field3d_begin(
+                    f.second->fld.data(),
+                    tmp1->fld.data(), &slot.buffer[nfld*count],
+                    filename, no_offset,
+                    gd.kstart, gd.kend, slot.requests[nfld]))
+        {
+            master.print_message("FAILED\n");
+            ++nerror;
+        }
+        else
+        {
+            master.print_message("OK\n");
+            started[nfld] = 1;
+        }
+
+        ++nfld;
+    }
+
     release_tmp(tmp1);
-    release_tmp(tmp2);
 
+    nerror += save_checksums(n);
     master.sum(&nerror, 1);
 
     if (nerror)
+    {
+        // Complete the writes that did start, such that their files and types are freed.
+        for (size_t i=0; i<started.size(); ++i)
+            if (started[i])
+                field3d_io.save_field3d_end(slot.requests[i]);
+
         throw std::runtime_error("Error saving 3D fields");
+    }
+
+    slot.iotime = n;
+    slot.pending = true;
+
+    // The previous restart set had a full save interval to drain, complete it now.
+    Save_slot& previous = save_slots[save_slot_next];
+    if (previous.pending)
+        finish_save_slot(previous);
+}
+
+template<typename TF>
+void Fields<TF>::save_finish()
+{
+    // Complete the oldest set first, such that the flag files appear in order.
+    if (save_slots[save_slot_next].pending)
+        finish_save_slot(save_slots[save_slot_next]);
+
+    if (save_slots[1-save_slot_next].pending)
+        finish_save_slot(save_slots[1-save_slot_next]);
+}
+
+template<typename TF>
+void Fields<TF>::finish_save_slot(Save_slot& slot)
+{
+    int nerror = 0;
+    for (auto& req : slot.requests)
+    {
+        if (field3d_io.save_field3d_end(req))
+            ++nerror;
+    }
+
+    master.sum(&nerror, 1);
+
+    if (nerror)
+        throw std::runtime_error("Error saving 3D fields");
+
+    slot.pending = false;
+
+    // Write a flag file to mark that the restart set of this time is complete on disk.
+    if (master.get_mpiid() == 0)
+    {
+        char filename[256];
+        std::snprintf(filename, 256, "restart_done.%07d", slot.iotime);
+
+        FILE* pFile = fopen(filename, "w");
+        if (pFile == NULL)
+            nerror = 1;
+        else
+            fclose(pFile);
+    }
+
+    master.broadcast(&nerror, 1);
+
+    if (nerror)
+        throw std::runtime_error("Error writing restart flag file");
+
+    master.print_message("Restart files of time %07d written\n", slot.iotime);
+}
+
+template<typename TF>
+int Fields<TF>::save_checksums(int n)
+{
+    if (!swchecksum)
+        return 0;
+
+    auto& gd = grid.get_grid_data();
+
+    int nerror = 0;
+    for (auto& f : ap)
+    {
+        char filename[256];
+        std::snprintf(filename, 256, "%s.%07d.chk", f.second->name.c_str(), n);
+
+        if (field3d_io.save_checksums(f.second->fld.data(), filename, gd.kstart, gd.kend))
+        {
+            master.print_message("Saving \"%s\" ... FAILED\n", filename);
+            ++nerror;
+        }
+    }
+
+    return nerror;
+}
+
+template<typename TF>
+void Fields<TF>::check_checksums(int n)
+{
+    // Verify the loaded fields against their checksums, if these have been written.
+    auto& gd = grid.get_grid_data();
+
+    for (auto& f : ap)
+    {
+        char filename[256];
+        std::snprintf(filename, 256, "%s.%07d.chk", f.second->name.c_str(), n);
+
+        const int result = field3d_io.check_checksums(f.second->fld.data(), filename, gd.kstart, gd.kend);
+
+        if (result > 0)
+        {
+            std::string msg = "Checksum of " + f.second->name + " at time " + std::to_string(n)
+                + " does not match at level k = " + std::to_string(result-1);
+            throw std::runtime_error(msg);
+        }
+        else if (result == 0)
+            master.print_message("Checksum of \"%s\" ... OK\n", f.second->name.c_str());
+    }
 }
 
 template<typename TF>
@@ -1288,18 +1952,19 @@ void Fields<TF>::load(int n)
 
     int nerror = 0;
 
-    for (auto& f : ap)
+    if (swrestartfile)
     {
-        // The offset is kept at zero, otherwise bitwise identical restarts is not possible.
+        std::vector<std::pair<std::string, TF*>> restart_fields;
+        for (auto& f : ap)
+            restart_fields.emplace_back(f.second->name, f.second->fld.data());
+
         char filename[256];
-        std::snprintf(filename, 256, "%s.%07d", f.second->name.c_str(), n);
+        std::snprintf(filename, 256, "restart.%07d", n);
         master.print_message("Loading \"%s\" ... ", filename);
 
-        if (field3d_io.load_field3d(
-                    f.second->fld.data(),
-                    tmp1->fld.data(), tmp2->fld.data(),
-                    filename, no_offset,
-                    gd.kstart, gd.kend))
+        if (field3d_io.load_restart_file(
+                    restart_fields, tmp1->fld.data(), tmp2->fld.data(),
+                    filename, gd.kstart, gd.kend))
         {
             master.print_message("FAILED\n");
             ++nerror;
@@ -1309,6 +1974,84 @@ void Fields<TF>::load(int n)
             master.print_message("OK\n");
         }
     }
+    else if (field3d_io.has_compression() || field3d_io.has_file_per_rank())
+    {
+        for (auto& f : ap)
+        {
+            // The offset is kept at zero, otherwise bitwise identical restarts is not possible.
+            char filename[256];
+            std::snprintf(filename, 256, "%s.%07d", f.second->name.c_str(), n);
+            master.print_message("Loading \"%s\" ... ", filename);
+
+            if (field3d_io.load_field3d(
+                        f.second->fld.data(),
+                        tmp1->fld.data(), tmp2->fld.data(),
+                        filename, no_offset,
+                        gd.kstart, gd.kend))
+            {
+                master.print_message("FAILED\n");
+                ++nerror;
+            }
+            else
+            {
+                master.print_message("OK\n");
+            }
+        }
+    }
+    else
+    {
+        // Read the next field while the current one is transposed and unpacked.
+        auto tmp3 = get_tmp();
+        TF* buffers[2] = {tmp1->fld.data(), tmp2->fld.data()};
+        Field3d_io_request requests[2];
+        int started[2] = {0, 0};
+
+        std::vector<Field3d<TF>*> load_fields;
+        for (auto& f : ap)
+            load_fields.push_back(f.second.get());
+
+        auto begin_load = [&](const int nfld)
+        {
+            char filename[256];
+            std::snprintf(filename, 256, "%s.%07d", load_fields[nfld]->name.c_str(), n);
+            started[nfld%2] = !field3d_io.load_field3d_begin(
+                    buffers[nfld%2], filename, gd.kstart, gd.kend, requests[nfld%2]);
+        };
+
+        if (!load_fields.empty())
+            begin_load(0);
+
+        for (int nfld=0; nfld<static_cast<int>(load_fields.size()); ++nfld)
+        {
+            if (nfld+1 < static_cast<int>(load_fields.size()))
+                begin_load(nfld+1);
+
+            // The offset is kept at zero, otherwise bitwise identical restarts is not possible.
+            char filename[256];
+            std::snprintf(filename, 256, "%s.%07d", load_fields[nfld]->name.c_str(), n);
+            master.print_message("Loading \"%s\" ... ", filename);
+
+            if (!started[nfld%2] || field3d_io.load_field3d_end(
+                        load_fields[nfld]->fld.data(), buffers[nfld%2], tmp3->fld.data(),
+                        no_offset, gd.kstart, gd.kend, requests[nfld%2]))
+            {
+                master.print_message("FAILED\n");
+                ++nerror;
+            }
+            else
+            {
+                master.print_message("OK\n");
+            }
+        }
+
+        release_tmp(tmp3);
+    }
+
+    // The checksums are verified collectively, so all processes need to agree on the errors first.
+    master.sum(&nerror, 1);
+
+    if (!nerror)
+        check_checksums(n);
 
     // Load surface (XY) masks
     for (auto& mask : xymasks)
@@ -1338,25 +2081,16 @@ void Fields<TF>::load(int n)
 
 #ifndef USECUDA
 template<typename TF>
-TF Fields<TF>::check_momentum()
+void Fields<TF>::check_conservation(TF& mom, TF& tke, TF& mass)
 {
     auto& gd = grid.get_grid_data();
-    return calc_momentum_2nd(
-            mp.at("u")->fld.data(), mp.at("v")->fld.data(), mp.at("w")->fld.data(),
-            gd.dz.data(), gd.itot*gd.jtot*gd.zsize,
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells,
-            master);
-}
-#endif
 
-#ifndef USECUDA
-template<typename TF>
-TF Fields<TF>::check_tke()
-{
-    auto& gd = grid.get_grid_data();
-    return calc_tke_2nd(
-            mp.at("u")->fld.data(), mp.at("v")->fld.data(), mp.at("w")->fld.data(),
+    // The mass is that of the first scalar.
+    const TF* s = sp.empty() ? nullptr : sp.begin()->second->fld.data();
+
+    calc_conservation_2nd(
+            mom, tke, mass,
+            mp.at("u")->fld.data(), mp.at("v")->fld.data(), mp.at("w")->fld.data(), s,
             gd.dz.data(), gd.itot*gd.jtot*gd.zsize,
             gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
             gd.icells, gd.ijcells,
@@ -1364,30 +2098,14 @@ TF Fields<TF>::check_tke()
 }
 #endif
 
-#ifndef USECUDA
-template<typename TF>
-TF Fields<TF>::check_mass()
-{
-    auto& gd = grid.get_grid_data();
-
-    auto it = sp.begin();
-    if (sp.begin() != sp.end())
-        return calc_mass(
-                it->second->fld.data(),
-                gd.dz.data(), gd.itot*gd.jtot*gd.zsize,
-                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells,
-                master);
-    else
-        return 0.;
-}
-#endif
-
 template<typename TF>
 void Fields<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
 {
     auto& gd = grid.get_grid_data();
 
+    // The fields, or their snapshot of this output step.
+    Field_map<TF>& flds = get_output_fields();
+
     TF no_offset = 0.;
     TF offset;
     for (auto& it : cross_simple)
@@ -1399,16 +2117,16 @@ void Fields<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
         else
             offset = no_offset;
         
-        cross.cross_simple(a.at(it)->fld.data(), offset, a.at(it)->name, iotime, a.at(it)->loc);
+        cross.cross_simple(flds.at(it)->fld.data(), offset, flds.at(it)->name, iotime, flds.at(it)->loc);
     }
     for (auto& it : cross_lngrad)
-        cross.cross_lngrad(a.at(it)->fld.data(), a.at(it)->name+"_lngrad", iotime);
+        cross.cross_lngrad(flds.at(it)->fld.data(), flds.at(it)->name+"_lngrad", iotime);
 
     for (auto& it : cross_fluxbot)
-        cross.cross_plane(a.at(it)->flux_bot.data(), offset, a.at(it)->name+"_fluxbot", iotime);
+        cross.cross_plane(flds.at(it)->flux_bot.data(), offset, flds.at(it)->name+"_fluxbot", iotime);
 
     for (auto& it : cross_fluxtop)
-        cross.cross_plane(a.at(it)->flux_top.data(), offset, a.at(it)->name+"_fluxtop", iotime);
+        cross.cross_plane(flds.at(it)->flux_top.data(), offset, flds.at(it)->name+"_fluxtop", iotime);
 
     for (auto& it : cross_bot)
     {
@@ -1418,7 +2136,7 @@ void Fields<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
             offset = gd.vtrans;
         else
             offset = no_offset;
-        cross.cross_plane(a.at(it)->fld_bot.data(), offset, a.at(it)->name+"_bot", iotime);
+        cross.cross_plane(flds.at(it)->fld_bot.data(), offset, flds.at(it)->name+"_bot", iotime);
     }
 
     for (auto& it : cross_top)
@@ -1429,18 +2147,21 @@ void Fields<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
             offset = gd.vtrans;
         else
             offset = no_offset;
-        cross.cross_plane(a.at(it)->fld_top.data(), offset, a.at(it)->name+"_top", iotime);
+        cross.cross_plane(flds.at(it)->fld_top.data(), offset, flds.at(it)->name+"_top", iotime);
     }
     
     for (auto& it : cross_path)
-        cross.cross_path(a.at(it)->fld.data(), a.at(it)->name+"_path", iotime);
+        cross.cross_path(flds.at(it)->fld.data(), flds.at(it)->name+"_path", iotime);
 }
 
 template<typename TF>
 void Fields<TF>::exec_dump(Dump<TF>& dump, unsigned long iotime)
 {
+    Field_map<TF>& flds = get_output_fields();
+
     for (auto& it : dumplist)
-        dump.save_dump(a.at(it)->fld.data(), a.at(it)->name, iotime);
+        if (dump.do_dump_var(it))
+            dump.save_dump(flds.at(it)->fld.data(), flds.at(it)->name, iotime);
 }
 
 #ifndef USECUDA
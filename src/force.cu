@@ -324,6 +324,86 @@ void Force<TF>::exec(double dt, Thermo<TF>& thermo, Stats<TF>& stats)
         stats.calc_tend(*fields.mt.at("v"), tend_name_cor);
     }
 
+    // Without the tendency statistics, the large-scale source, nudging
+    // and subsidence of each field are added in a single kernel.
+    if (!stats.is_doing_tendency())
+    {
+        for (auto& it : fields.at)
+        {
+            const std::string& name = it.first;
+
+            const bool has_ls = (swls == Large_scale_tendency_type::Enabled)
+                    && (std::find(lslist.begin(), lslist.end(), name) != lslist.end());
+            const bool has_nudge = (swnudge == Nudging_type::Enabled)
+                    && (std::find(nudgelist.begin(), nudgelist.end(), name) != nudgelist.end());
+            const bool has_wls = (swwls != Large_scale_subsidence_type::Disabled)
+                    && ((fields.st.find(name) != fields.st.end()) || (swwls_mom && (name == "u" || name == "v")));
+
+            if (!(has_ls || has_nudge || has_wls))
+                continue;
+
+            if (has_nudge)
+            {
+                if (std::find(scalednudgelist.begin(), scalednudgelist.end(), name) != scalednudgelist.end())
+                {
+                    cudaMemcpy(fields.ap.at(name)->fld_mean.data(), fields.ap.at(name)->fld_mean_g, gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
+                    const int kinv = thermo.get_bl_depth();
+                    rescale_nudgeprof(nudgeprofs.at(name).data(), kinv, gd.kstart, gd.kend);
+                    cudaMemcpy(nudgeprofs_g.at(name), nudgeprofs.at(name).data(), gd.kcells*sizeof(TF), cudaMemcpyHostToDevice);
+                }
+
+                const int blocki = 32;
+                const int gridi  = gd.kmax/blocki + (gd.kmax%blocki > 0);
+
+                nudging_tendency_g<TF><<<dim3(gridi), dim3(blocki)>>>(
+                        nudge_tend_g.view(),
+                        fields.ap.at(name)->fld_mean_g,
+                        nudgeprofs_g.at(name),
+                        nudge_factor_g,
+                        gd.kstart, gd.kend);
+            }
+
+            const TF* sls_g = has_ls ? lsprofs_g.at(name).data() : nullptr;
+            const TF* nudge_g = has_nudge ? nudge_tend_g.data() : nullptr;
+            const TF* wls_fld_g = has_wls ? wls_g.data() : nullptr;
+
+            if (swwls == Large_scale_subsidence_type::Local_field)
+                launch_grid_kernel<Force_kernels::large_scale_tendencies_g<TF, true>>(
+                        grid_layout,
+                        it.second->fld_g.view(),
+                        fields.ap.at(name)->fld_g,
+                        sls_g, nudge_g, wls_fld_g,
+                        gd.dzhi_g);
+            else
+                launch_grid_kernel<Force_kernels::large_scale_tendencies_g<TF, false>>(
+                        grid_layout,
+                        it.second->fld_g.view(),
+                        fields.ap.at(name)->fld_mean_g,
+                        sls_g, nudge_g, wls_fld_g,
+                        gd.dzhi_g);
+        }
+
+        // The local subsidence of w is at the half levels, and stays separate.
+        if (swwls == Large_scale_subsidence_type::Local_field && swwls_mom)
+        {
+            Grid_layout grid_layout_kp1 = {
+                    gd.istart,   gd.iend,
+                    gd.jstart,   gd.jend,
+                    gd.kstart+1, gd.kend,
+                    gd.istride,
+                    gd.jstride,
+                    gd.kstride};
+
+            launch_grid_kernel<Force_kernels::advec_wls_2nd_local_w_g<TF>>(
+                    grid_layout_kp1,
+                    fields.mt.at("w")->fld_g.view(),
+                    fields.mp.at("w")->fld_g,
+                    wls_g, gd.dzi_g);
+        }
+
+        return;
+    }
+
     if (swls == Large_scale_tendency_type::Enabled)
     {
         for (auto& it : lslist)
@@ -269,6 +269,62 @@ namespace
         }
     }
 
+    // Large-scale source, subsidence and nudging of a single field in one pass over its tendency. The
+    // terms that are not active have a nullptr as profile, and are added in the order of the separate
+    // kernels calc_large_scale_source, advec_wls_2nd_mean/local and calc_nudging_tendency.
+    template<typename TF, bool sw_wls_local>
+    void calc_large_scale_tendencies(
+            TF* const restrict st, const TF* const restrict s, const TF* const restrict smean,
+            const TF* const restrict sls, const TF* const restrict wls,
+            const TF* const restrict nudgeref, const TF* const restrict nudgefac,
+            const TF* const dzhi,
+            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        const int jj = icells;
+        const int kk = ijcells;
+
+        const bool has_ls = (sls != nullptr);
+        const bool has_wls = (wls != nullptr);
+        const bool has_nudge = (nudgeref != nullptr);
+
+        for (int k=kstart; k<kend; ++k)
+        {
+            const TF ls_k = has_ls ? sls[k] : TF(0.);
+            const TF nudge_k = has_nudge ? -nudgefac[k] * (smean[k] - nudgeref[k]) : TF(0.);
+
+            // Level of the upwind gradient of the subsidence.
+            const int kp = (has_wls && !(wls[k] > 0.)) ? k+1 : k;
+            const int dkp = (kp-k)*kk;
+            const TF wls_k = has_wls ? wls[k] : TF(0.);
+            const TF subs_k = (has_wls && !sw_wls_local) ? wls_k * (smean[kp]-smean[kp-1])*dzhi[kp] : TF(0.);
+
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    TF tend = st[ijk];
+
+                    if (has_ls)
+                        tend += ls_k;
+
+                    if (has_wls)
+                    {
+                        if constexpr (sw_wls_local)
+                            tend -= wls_k * (s[ijk+dkp]-s[ijk+dkp-kk])*dzhi[kp];
+                        else
+                            tend -= subs_k;
+                    }
+
+                    if (has_nudge)
+                        tend += nudge_k;
+
+                    st[ijk] = tend;
+                }
+        }
+    }
+
     template<typename TF>
     void advec_wls_2nd_local_w(
             TF* const restrict st,
@@ -659,6 +715,61 @@ void Force<TF>::exec(double dt, Thermo<TF>& thermo, Stats<TF>& stats)
 
     }
 
+    // Without the tendency statistics, the terms do not have to be sampled one by one, and the
+    // large-scale source, subsidence and nudging of each field are added in a single pass.
+    if (!stats.is_doing_tendency())
+    {
+        for (auto& it : fields.at)
+        {
+            const std::string& name = it.first;
+
+            const bool has_ls = (swls == Large_scale_tendency_type::Enabled)
+                    && (std::find(lslist.begin(), lslist.end(), name) != lslist.end());
+            const bool has_nudge = (swnudge == Nudging_type::Enabled)
+                    && (std::find(nudgelist.begin(), nudgelist.end(), name) != nudgelist.end());
+            const bool has_wls = (swwls != Large_scale_subsidence_type::Disabled)
+                    && ((fields.st.find(name) != fields.st.end()) || (swwls_mom && (name == "u" || name == "v")));
+
+            if (!(has_ls || has_nudge || has_wls))
+                continue;
+
+            if (has_nudge && std::find(scalednudgelist.begin(), scalednudgelist.end(), name) != scalednudgelist.end())
+            {
+                const int kinv = thermo.get_bl_depth();
+                rescale_nudgeprof(nudgeprofs.at(name).data(), kinv, gd.kstart, gd.kend);
+            }
+
+            auto large_scale_wrapper = [&]<bool sw_wls_local>()
+            {
+                calc_large_scale_tendencies<TF, sw_wls_local>(
+                        it.second->fld.data(),
+                        fields.ap.at(name)->fld.data(),
+                        fields.ap.at(name)->fld_mean.data(),
+                        has_ls ? lsprofs.at(name).data() : nullptr,
+                        has_wls ? wls.data() : nullptr,
+                        has_nudge ? nudgeprofs.at(name).data() : nullptr,
+                        nudge_factor.data(),
+                        gd.dzhi.data(),
+                        gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                        gd.icells, gd.ijcells);
+            };
+
+            if (swwls == Large_scale_subsidence_type::Local_field)
+                large_scale_wrapper.template operator()<true>();
+            else
+                large_scale_wrapper.template operator()<false>();
+        }
+
+        // The local subsidence of w is at the half levels, and stays separate.
+        if (swwls == Large_scale_subsidence_type::Local_field && swwls_mom)
+            advec_wls_2nd_local_w<TF>(
+                    fields.mt.at("w")->fld.data(), fields.mp.at("w")->fld.data(), wls.data(), gd.dzi.data(),
+                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                    gd.icells, gd.ijcells);
+
+        return;
+    }
+
     if (swls == Large_scale_tendency_type::Enabled)
     {
         for (auto& it : lslist)
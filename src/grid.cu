@@ -21,9 +21,49 @@
  */
 
 #include "grid.h"
+#include "grid_kernels.cuh"
 #include "tools.h"
 #include "math.h"
 
+namespace
+{
+    template<typename TF> __global__
+    void calc_interpolate_2nd_g(
+            TF* const __restrict__ out, const TF* const __restrict__ in,
+            const int iih, const int jjh, const int kkh,
+            const int istart, const int iend, const int jstart, const int jend,
+            const int kcells, const int icells, const int ijcells)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
+        const int k = blockIdx.z;
+
+        if (i < iend && j < jend && k < kcells)
+        {
+            const int ijk = i + j*icells + k*ijcells;
+            out[ijk] = Grid_kernels::interp_2nd(in, ijk, iih, jjh, kkh, k == 0, k == kcells-1);
+        }
+    }
+
+    template<typename TF> __global__
+    void calc_interpolate_4th_g(
+            TF* const __restrict__ out, const TF* const __restrict__ in,
+            const int iih1, const int jjh1,
+            const int istart, const int iend, const int jstart, const int jend,
+            const int kcells, const int icells, const int ijcells)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
+        const int k = blockIdx.z;
+
+        if (i < iend && j < jend && k < kcells)
+        {
+            const int ijk = i + j*icells + k*ijcells;
+            out[ijk] = Grid_kernels::interp_4th(in, ijk, iih1, jjh1);
+        }
+    }
+}
+
 template<typename TF>
 void Grid<TF>::prepare_device()
 {
@@ -73,6 +113,56 @@ void Grid<TF>::clear_device()
     gd.dzhi4_g.free();
 }
 
+/**
+ * Device equivalent of interpolate_2nd, which interpolates a field on the GPU
+ * to the selected location on the grid.
+ */
+template<typename TF>
+void Grid<TF>::interpolate_2nd_g(TF* const out, const TF* const in, const int locin[3], const int locout[3])
+{
+    const int blocki = gd.ithread_block;
+    const int blockj = gd.jthread_block;
+    const int gridi  = gd.imax/blocki + (gd.imax%blocki > 0);
+    const int gridj  = gd.jmax/blockj + (gd.jmax%blockj > 0);
+
+    dim3 gridGPU (gridi, gridj, gd.kcells);
+    dim3 blockGPU(blocki, blockj, 1);
+
+    const int iih = (locin[0]-locout[0]);
+    const int jjh = (locin[1]-locout[1])*gd.icells;
+    const int kkh = (locin[2]-locout[2])*gd.ijcells;
+
+    calc_interpolate_2nd_g<TF><<<gridGPU, blockGPU>>>(
+            out, in, iih, jjh, kkh,
+            gd.istart, gd.iend, gd.jstart, gd.jend,
+            gd.kcells, gd.icells, gd.ijcells);
+    cuda_check_error();
+}
+
+/**
+ * Device equivalent of interpolate_4th, the fourth order horizontal interpolation.
+ */
+template<typename TF>
+void Grid<TF>::interpolate_4th_g(TF* const out, const TF* const in, const int locin[3], const int locout[3])
+{
+    const int blocki = gd.ithread_block;
+    const int blockj = gd.jthread_block;
+    const int gridi  = gd.imax/blocki + (gd.imax%blocki > 0);
+    const int gridj  = gd.jmax/blockj + (gd.jmax%blockj > 0);
+
+    dim3 gridGPU (gridi, gridj, gd.kcells);
+    dim3 blockGPU(blocki, blockj, 1);
+
+    const int iih1 = (locin[0]-locout[0]);
+    const int jjh1 = (locin[1]-locout[1])*gd.icells;
+
+    calc_interpolate_4th_g<TF><<<gridGPU, blockGPU>>>(
+            out, in, iih1, jjh1,
+            gd.istart, gd.iend, gd.jstart, gd.jend,
+            gd.kcells, gd.icells, gd.ijcells);
+    cuda_check_error();
+}
+
 
 #ifdef FLOAT_SINGLE
 template class Grid<float>;
@@ -25,6 +25,7 @@
 #include <cmath>
 #include <iostream>
 #include <algorithm>
+#include <limits>
 
 #include "master.h"
 #include "grid.h"
@@ -90,6 +91,9 @@ Grid<TF>::Grid(Master& masterin, Input& input) :
         gd.jgc = 3;
         gd.kgc = 3;
     }
+
+    gd.ihalo = gd.igc;
+    gd.jhalo = gd.jgc;
 }
 
 template<typename TF>
@@ -301,6 +305,15 @@ void Grid<TF>::calculate()
         gd.dz [gd.kend]     = gd.dz [gd.kend-1];
         gd.dzi[gd.kend]     = gd.dzi[gd.kend-1];
 
+        // Detect the equidistant grid, for which the kernels can replace dzi and dzhi by a scalar.
+        // The tolerance allows for the round off in the heights read from the input.
+        const TF tolerance = TF(100.)*std::numeric_limits<TF>::epsilon();
+        gd.uniform_z = true;
+        for (int k=gd.kstart-1; k<gd.kend+1; ++k)
+            if (std::abs(gd.dzi [k] - gd.dzi[gd.kstart]) > tolerance*gd.dzi[gd.kstart] ||
+                std::abs(gd.dzhi[k] - gd.dzi[gd.kstart]) > tolerance*gd.dzi[gd.kstart])
+                gd.uniform_z = false;
+
         // do not calculate 4th order gradients for 2nd order
     }
 
@@ -308,6 +321,9 @@ void Grid<TF>::calculate()
     {
         using namespace Finite_difference::O4;
 
+        // Only the second order kernels have a specialisation for the equidistant grid.
+        gd.uniform_z = false;
+
         // calculate the height of the ghost cell
         gd.z[gd.kstart-1] = -2.*gd.z[gd.kstart] + (1./3.)*gd.z[gd.kstart+1];
         gd.z[gd.kstart-2] = -9.*gd.z[gd.kstart] +      2.*gd.z[gd.kstart+1];
@@ -446,11 +462,29 @@ void Grid<TF>::set_minimum_ghost_cells(const int igcin, const int jgcin, const i
     gd.jgc = std::max(gd.jgc, jgcin);
     gd.kgc = std::max(gd.kgc, kgcin);
 
+    gd.ihalo = std::max(gd.ihalo, igcin);
+    gd.jhalo = std::max(gd.jhalo, jgcin);
+
     // BvS: this doesn't work; imax is undefined if this routine is called from a class constructor
     // Removed it since this check is anyhow always performed from the init() of grid (after defining imax)
     //check_ghost_cells();
 }
 
+/**
+ * This function increases the number of ghost cells in case necessary, without
+ * increasing the width of the periodic exchange of the prognostic fields.
+ * @param igc Ghost cells in the x-direction.
+ * @param jgc Ghost cells in the y-direction.
+ * @param kgc Ghost cells in the z-direction.
+ */
+template<typename TF>
+void Grid<TF>::set_minimum_padding_cells(const int igcin, const int jgcin, const int kgcin)
+{
+    gd.igc = std::max(gd.igc, igcin);
+    gd.jgc = std::max(gd.jgc, jgcin);
+    gd.kgc = std::max(gd.kgc, kgcin);
+}
+
 /**
  * This function does a second order horizontal interpolation in the x-direction
  * to the selected location on the grid.
@@ -22,6 +22,8 @@
 
 #include <iostream>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <algorithm>
 
 #include <constants.h>
@@ -103,85 +105,53 @@ namespace
     }
 
 
+    /* DEM height of each column, and the lowest DEM height of the column and its eight neighbours.
+     * A grid point is a ghost cell if it is inside the IB, and one of its 3x3x3 neighbours is outside.
+     * As the levels increase with height, the latter holds if the level above is above the lowest
+     * surrounding DEM height, such that the DEM is only interpolated per column. */
     template<typename TF>
-    bool is_ghost_cell(
-            const std::vector<TF>& dem,
-            const std::vector<TF>& x, const std::vector<TF>& y, const std::vector<TF>& z,
+    void calc_dem_columns(
+            std::vector<TF>& zdem, std::vector<TF>& zdem_min,
+            const std::vector<TF>& dem, const std::vector<TF>& x, const std::vector<TF>& y,
             const TF dx, const TF dy,
-            const int i, const int j, const int k,
+            const int istart, const int jstart, const int iend, const int jend,
             const int icells, const int jcells,
             const int mpi_offset_x, const int mpi_offset_y)
     {
-        const TF zdem = interp2_dem(
-                x[i], y[j], x, y, dem, dx, dy,
-                icells, jcells, mpi_offset_x, mpi_offset_y);
+        int nerror = 0;
 
-        // Check if grid point is below IB. If so; check if
-        // one of the neighbouring grid points is outside.
-        if (z[k] <= zdem)
+        #pragma omp parallel for reduction(+:nerror)
+        for (int j=jstart; j<jend; ++j)
         {
-            // OLD METHOD:
-            //if (z[k+1] > zdem)
-            //    return true;
-
-            //for (int dj = -1; dj <= 1; ++dj)
-            //{
-            //    const TF zdem = interp2_dem(x[i], y[j+dj], x, y, dem, dx, dy,
-            //                                icells, mpi_offset_x, mpi_offset_y);
-            //    if (z[k] > zdem)
-            //        return true;
-            //}
-
-            //for (int di = -1; di <= 1; ++di)
-            //{
-            //    // Interpolate DEM to account for half-level locations x,y
-            //    const TF zdem = interp2_dem(x[i+di], y[j], x, y, dem, dx, dy,
-            //                                icells, mpi_offset_x, mpi_offset_y);
-            //    if (z[k] > zdem)
-            //        return true;
-            //}
-
-            //// NEW METHOD
-            //for (int dj = -1; dj <= 1; ++dj)
-            //{
-            //    // Interpolate DEM to account for half-level locations x,y
-            //    const TF zdem = interp2_dem(
-            //            x[i], y[j+dj], x, y, dem, dx, dy,
-            //            icells, jcells, mpi_offset_x, mpi_offset_y);
-
-            //    for (int dk = -1; dk <= 1; ++dk)
-            //        if (z[k + dk] > zdem)
-            //            return true;
-            //}
-
-            //for (int di = -1; di <= 1; ++di)
-            //{
-            //    // Interpolate DEM to account for half-level locations x,y
-            //    const TF zdem = interp2_dem(
-            //            x[i+di], y[j], x, y, dem, dx, dy,
-            //            icells, jcells, mpi_offset_x, mpi_offset_y);
-
-            //    for (int dk = -1; dk <= 1; ++dk)
-            //        if (z[k + dk] > zdem)
-            //            return true;
-            //}
-
-            // NEW METHOD
-            for (int dj = -1; dj <= 1; ++dj)
-                for (int di = -1; di <= 1; ++di)
+            try
+            {
+                for (int i=istart; i<iend; ++i)
                 {
-                    // Interpolate DEM to account for half-level locations x,y
-                    const TF zdem = interp2_dem(
-                            x[i+di], y[j+dj], x, y, dem, dx, dy,
+                    const int ij = i + j*icells;
+
+                    zdem[ij] = interp2_dem(
+                            x[i], y[j], x, y, dem, dx, dy,
                             icells, jcells, mpi_offset_x, mpi_offset_y);
 
-                    for (int dk = -1; dk <= 1; ++dk)
-                        if (z[k + dk] > zdem)
-                            return true;
+                    // Interpolate DEM to account for half-level locations x,y
+                    TF zmin = zdem[ij];
+                    for (int dj = -1; dj <= 1; ++dj)
+                        for (int di = -1; di <= 1; ++di)
+                            zmin = std::min(zmin, interp2_dem(
+                                    x[i+di], y[j+dj], x, y, dem, dx, dy,
+                                    icells, jcells, mpi_offset_x, mpi_offset_y));
+
+                    zdem_min[ij] = zmin;
                 }
+            }
+            catch (const std::exception&)
+            {
+                ++nerror;
+            }
         }
 
-        return false;
+        if (nerror)
+            throw std::runtime_error("IB dem interpolation out of bounds!");
     }
 
     template<typename TF>
@@ -220,7 +190,7 @@ namespace
     }
 
     template<typename TF>
-    void find_interpolation_points(
+    bool find_interpolation_points(
             std::vector<int>& ip_i, std::vector<int>& ip_j, std::vector<int>& ip_k,
             std::vector<TF>& ip_d, std::vector<TF>& c_idw, 
             const int index, const int n_idw,
@@ -269,8 +239,8 @@ namespace
         if (neighbours.size() < n_idw)
         {
            std::cout << "ERROR: only found " << neighbours.size() << " interpolation points @ ";
-           std::cout << "i=" << i << ", j=" << j << ", k=" << k << std::endl; 
-           throw 1;
+           std::cout << "i=" << i << ", j=" << j << ", k=" << k << std::endl;
+           return false;
         }
 
         // Save `n_idw` nearest neighbours
@@ -282,6 +252,8 @@ namespace
             ip_k[in] = neighbours[ii].k;
             ip_d[in] = neighbours[ii].distance;
         }
+
+        return true;
     }
 
     template<typename TF>
@@ -342,16 +314,26 @@ namespace
             const int mpi_offset_x, const int mpi_offset_y)
     {
         // 1. Find the IB ghost cells
+        std::vector<TF> zdem(icells*jcells);
+        std::vector<TF> zdem_min(icells*jcells);
+
+        calc_dem_columns(
+                zdem, zdem_min, dem, x, y, dx, dy,
+                istart, jstart, iend, jend,
+                icells, jcells, mpi_offset_x, mpi_offset_y);
+
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 for (int i=istart; i<iend; ++i)
-                    if (is_ghost_cell(dem, x, y, z, dx, dy, i, j, k,
-                                      icells, jcells, mpi_offset_x, mpi_offset_y))
+                {
+                    const int ij = i + j*icells;
+                    if (z[k] <= zdem[ij] && z[k+1] > zdem_min[ij])
                     {
                         ghost.i.push_back(i);
                         ghost.j.push_back(j);
                         ghost.k.push_back(k);
                     }
+                }
 
         const int nghost = ghost.i.size();
         ghost.nghost = nghost;
@@ -369,6 +351,10 @@ namespace
 
         ghost.di.resize(nghost);
 
+        // The ghost cells are independent, but exceptions cannot leave the parallel loops.
+        int nerror = 0;
+
+        #pragma omp parallel for reduction(+:nerror)
         for (int n=0; n<nghost; ++n)
         {
             // Indices ghost cell in 3D field
@@ -376,10 +362,17 @@ namespace
             const int j = ghost.j[n];
             const int k = ghost.k[n];
 
-            find_nearest_location_wall(
-                    ghost.xb[n], ghost.yb[n], ghost.zb[n],
-                    x, y, dem, x[i], y[j], z[k],
-                    dx, dy, icells, jcells, mpi_offset_x, mpi_offset_y);
+            try
+            {
+                find_nearest_location_wall(
+                        ghost.xb[n], ghost.yb[n], ghost.zb[n],
+                        x, y, dem, x[i], y[j], z[k],
+                        dx, dy, icells, jcells, mpi_offset_x, mpi_offset_y);
+            }
+            catch (const std::exception&)
+            {
+                ++nerror;
+            }
 
             // Image point
             ghost.xi[n] = 2*ghost.xb[n] - x[i];
@@ -397,23 +390,39 @@ namespace
         ghost.ip_d .resize(nghost*n_idw);
         ghost.c_idw.resize(nghost*n_idw);
 
+        if (nerror)
+            throw std::runtime_error("IB dem interpolation out of bounds!");
+
+        #pragma omp parallel for reduction(+:nerror)
         for (int n=0; n<nghost; ++n)
         {
             // Exclude interpolation points closer than `d_lim` to IB
             const TF dist_lim = 0.1 * std::min(std::min(dx, dy), dz[ghost.k[n]]);
 
-            find_interpolation_points(
-                    ghost.ip_i, ghost.ip_j, ghost.ip_k, ghost.ip_d, ghost.c_idw,
-                    n, n_idw, x, y, z, dem, dist_lim, dx, dy,
-                    ghost.i[n], ghost.j[n], ghost.k[n], kstart,
-                    icells, jcells, ijcells,
-                    mpi_offset_x, mpi_offset_y);
+            try
+            {
+                if (!find_interpolation_points(
+                        ghost.ip_i, ghost.ip_j, ghost.ip_k, ghost.ip_d, ghost.c_idw,
+                        n, n_idw, x, y, z, dem, dist_lim, dx, dy,
+                        ghost.i[n], ghost.j[n], ghost.k[n], kstart,
+                        icells, jcells, ijcells,
+                        mpi_offset_x, mpi_offset_y))
+                    ++nerror;
+            }
+            catch (const std::exception&)
+            {
+                ++nerror;
+            }
         }
 
+        if (nerror)
+            throw std::runtime_error("Not enough IB interpolation points found for " + std::to_string(nerror) + " ghost cell(s)");
+
         // 4. Calculate interpolation coefficients
         ghost.c_idw.resize(nghost*n_idw);
         ghost.c_idw_sum.resize(nghost);
 
+        #pragma omp parallel for
         for (int n=0; n<nghost; ++n)
         {
             precalculate_idw(
@@ -423,63 +432,163 @@ namespace
                     ghost.xb[n], ghost.yb[n], ghost.zb[n],
                     bc, n, n_idw);
         }
+
+        // 5. Flatten the indices. The ghost cells are found in k-j-i order,
+        // so they are already sorted on their position in memory.
+        ghost.ijk.resize(nghost);
+        ghost.ip_ijk.resize(nghost*n_idw);
+
+        for (int n=0; n<nghost; ++n)
+            ghost.ijk[n] = ghost.i[n] + ghost.j[n]*icells + ghost.k[n]*ijcells;
+
+        for (int n=0; n<nghost*n_idw; ++n)
+            ghost.ip_ijk[n] = ghost.ip_i[n] + ghost.ip_j[n]*icells + ghost.ip_k[n]*ijcells;
+    }
+
+    // FNV-1a hash of the input of the ghost cells, which identifies a valid cache.
+    template<typename T>
+    void hash_bytes(std::uint64_t& hash, const T* const data, const size_t n)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        for (size_t i=0; i<n*sizeof(T); ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    template<typename T>
+    bool write_vector(std::FILE* file, const std::vector<T>& v)
+    {
+        const std::uint64_t n = v.size();
+        return (std::fwrite(&n, sizeof(n), 1, file) == 1) && (std::fwrite(v.data(), sizeof(T), n, file) == n);
+    }
+
+    template<typename T>
+    bool read_vector(std::FILE* file, std::vector<T>& v)
+    {
+        std::uint64_t n;
+        if (std::fread(&n, sizeof(n), 1, file) != 1)
+            return false;
+
+        v.resize(n);
+        return (std::fread(v.data(), sizeof(T), n, file) == n);
+    }
+
+    template<typename TF, typename Func>
+    bool for_each_ghost_vector(Ghost_cells<TF>& g, Func&& func)
+    {
+        for (auto* v : {&g.i, &g.j, &g.k, &g.ip_i, &g.ip_j, &g.ip_k, &g.ijk, &g.ip_ijk})
+            if (!func(*v))
+                return false;
+
+        for (auto* v : {&g.xb, &g.yb, &g.zb, &g.xi, &g.yi, &g.zi, &g.di, &g.ip_d, &g.c_idw, &g.c_idw_sum})
+            if (!func(*v))
+                return false;
+
+        return true;
+    }
+
+    template<typename TF>
+    bool save_ghost_cells(Ghost_cells<TF>& g, const std::string& filename, const std::uint64_t key)
+    {
+        std::FILE* file = std::fopen(filename.c_str(), "wb");
+        if (file == nullptr)
+            return false;
+
+        bool success = (std::fwrite(&key, sizeof(key), 1, file) == 1);
+        if (success)
+            success = for_each_ghost_vector(g, [&](auto& v) { return write_vector(file, v); });
+
+        return (std::fclose(file) == 0) && success;
+    }
+
+    template<typename TF>
+    bool load_ghost_cells(Ghost_cells<TF>& g, const std::string& filename, const std::uint64_t key)
+    {
+        std::FILE* file = std::fopen(filename.c_str(), "rb");
+        if (file == nullptr)
+            return false;
+
+        std::uint64_t key_file;
+        bool success = (std::fread(&key_file, sizeof(key_file), 1, file) == 1) && (key_file == key);
+        if (success)
+            success = for_each_ghost_vector(g, [&](auto& v) { return read_vector(file, v); });
+
+        std::fclose(file);
+
+        g.nghost = g.i.size();
+        return success;
     }
 
     void print_statistics(std::vector<int>& ghost_i, std::string name, Master& master)
     {
         int nghost = ghost_i.size();
+        double nghost_max = nghost;
         master.sum(&nghost, 1);
+        master.max(&nghost_max, 1);
 
         if (master.get_mpiid() == 0)
         {
             std::string message = "Found: " + std::to_string(nghost) + " IB ghost cells at the " + name + " location";
             master.print_message(message);
+
+            // The subdomains have equal sizes, such that the process with the most ghost cells sets the pace
+            // of the IB. The imbalance helps to choose npx and npy, or to shift the domain over the buildings.
+            const double nghost_mean = double(nghost) / master.get_MPI_data().nprocs;
+            if (nghost_mean > 0.)
+                master.print_message(
+                        "IB ghost cells at the %s location per process: max/mean = %.2f\n",
+                        name.c_str(), nghost_max/nghost_mean);
         }
     }
 
+    // Set the ghost cells of `n_fld` fields that share the same ghost cells. All fields
+    // are processed in a single pass, such that the stencil and coefficients of a ghost
+    // cell are read once. The interpolation points are outside of the IB, so no ghost
+    // cell reads another ghost cell and the ghost cells can be set in parallel.
     template<typename TF>
     void set_ghost_cells(
-            TF* const restrict fld, const TF* const restrict boundary_value,
+            TF* const* const flds, const TF* const* const boundary_values, const TF* const visc, const int n_fld,
             const TF* const restrict c_idw, const TF* const restrict c_idw_sum,
             const TF* const restrict di,
-            const int* const restrict gi, const int* const restrict gj, const int* const restrict gk,
-            const int* const restrict ipi, const int* const restrict ipj, const int* const restrict ipk,
-            Boundary_type bc, const TF visc, const int n_ghostcells, const int n_idw,
-            const int icells, const int ijcells)
+            const int* const restrict ijkg, const int* const restrict ijki,
+            Boundary_type bc, const int n_ghostcells, const int n_idw)
     {
         const int n_idw_loc = (bc == Boundary_type::Dirichlet_type) ? n_idw-1 : n_idw;
 
+        #pragma omp parallel for
         for (int n=0; n<n_ghostcells; ++n)
         {
-            const int ijkg = gi[n] + gj[n]*icells + gk[n]*ijcells;
-
-            // Sum the IDW coefficient times the value at the neighbouring grid points
-            TF vI = TF(0);
-            for (int i=0; i<n_idw_loc; ++i)
-            {
-                const int ii = i + n*n_idw;
-                const int ijki = ipi[ii] + ipj[ii]*icells + ipk[ii]*ijcells;
-                vI += c_idw[ii] * fld[ijki];
-            }
+            const TF* const restrict c_idw_n = &c_idw[n*n_idw];
+            const int* const restrict ijki_n = &ijki[n*n_idw];
 
-            // For Dirichlet BCs, add the boundary value
-            if (bc == Boundary_type::Dirichlet_type)
+            for (int f=0; f<n_fld; ++f)
             {
-                const int ii = n_idw-1 + n*n_idw;
-                vI += c_idw[ii] * boundary_value[n];
-            }
-
-            vI /= c_idw_sum[n];
-
-            // Set the ghost cells, depending on the IB boundary conditions
-            if (bc == Boundary_type::Dirichlet_type)
-                fld[ijkg] = 2*boundary_value[n] - vI;       // Image value reflected across IB
-            else if (bc == Boundary_type::Neumann_type)
-                fld[ijkg] = vI - boundary_value[n] * di[n]; // Image value minus gradient times distance
-            else if (bc == Boundary_type::Flux_type)
-            {
-                const TF grad = -boundary_value[n] / visc;
-                fld[ijkg] = vI - grad * di[n];              // Image value minus gradient times distance
+                TF* const restrict fld = flds[f];
+                const TF boundary_value = boundary_values[f][n];
+
+                // Sum the IDW coefficient times the value at the neighbouring grid points
+                TF vI = TF(0);
+                for (int i=0; i<n_idw_loc; ++i)
+                    vI += c_idw_n[i] * fld[ijki_n[i]];
+
+                // For Dirichlet BCs, add the boundary value
+                if (bc == Boundary_type::Dirichlet_type)
+                    vI += c_idw_n[n_idw-1] * boundary_value;
+
+                vI /= c_idw_sum[n];
+
+                // Set the ghost cells, depending on the IB boundary conditions
+                if (bc == Boundary_type::Dirichlet_type)
+                    fld[ijkg[n]] = 2*boundary_value - vI;       // Image value reflected across IB
+                else if (bc == Boundary_type::Neumann_type)
+                    fld[ijkg[n]] = vI - boundary_value * di[n]; // Image value minus gradient times distance
+                else if (bc == Boundary_type::Flux_type)
+                {
+                    const TF grad = -boundary_value / visc[f];
+                    fld[ijkg[n]] = vI - grad * di[n];           // Image value minus gradient times distance
+                }
             }
         }
     }
@@ -624,6 +733,7 @@ Immersed_boundary<TF>::Immersed_boundary(Master& masterin, Grid<TF>& gridin, Fie
 
         // Read additional settings
         n_idw_points = inputin.get_item<int>("IB", "n_idw_points", "");
+        sw_ghost_cell_cache = inputin.get_item<bool>("IB", "swghostcellcache", "", false);
 
         // Set available masks
         available_masks.insert(available_masks.end(), {"ib"});
@@ -642,31 +752,19 @@ void Immersed_boundary<TF>::exec_momentum()
     if (sw_ib == IB_type::Disabled)
         return;
 
-    auto& gd = grid.get_grid_data();
-
-    set_ghost_cells(
-            fields.mp.at("u")->fld.data(), ghost.at("u").mbot.data(),
-            ghost.at("u").c_idw.data(), ghost.at("u").c_idw_sum.data(), ghost.at("u").di.data(),
-            ghost.at("u").i.data(), ghost.at("u").j.data(), ghost.at("u").k.data(),
-            ghost.at("u").ip_i.data(), ghost.at("u").ip_j.data(), ghost.at("u").ip_k.data(),
-            Boundary_type::Dirichlet_type, fields.visc, ghost.at("u").i.size(), n_idw_points,
-            gd.icells, gd.ijcells);
+    for (const auto& name : {"u", "v", "w"})
+    {
+        Ghost_cells<TF>& g = ghost.at(name);
 
-    set_ghost_cells(
-            fields.mp.at("v")->fld.data(), ghost.at("v").mbot.data(),
-            ghost.at("v").c_idw.data(), ghost.at("v").c_idw_sum.data(), ghost.at("v").di.data(),
-            ghost.at("v").i.data(), ghost.at("v").j.data(), ghost.at("v").k.data(),
-            ghost.at("v").ip_i.data(), ghost.at("v").ip_j.data(), ghost.at("v").ip_k.data(),
-            Boundary_type::Dirichlet_type, fields.visc, ghost.at("v").i.size(), n_idw_points,
-            gd.icells, gd.ijcells);
+        TF* fld = fields.mp.at(name)->fld.data();
+        const TF* mbot = g.mbot.data();
 
-    set_ghost_cells(
-            fields.mp.at("w")->fld.data(), ghost.at("w").mbot.data(),
-            ghost.at("w").c_idw.data(), ghost.at("w").c_idw_sum.data(), ghost.at("w").di.data(),
-            ghost.at("w").i.data(), ghost.at("w").j.data(), ghost.at("w").k.data(),
-            ghost.at("w").ip_i.data(), ghost.at("w").ip_j.data(), ghost.at("w").ip_k.data(),
-            Boundary_type::Dirichlet_type, fields.visc, ghost.at("w").i.size(), n_idw_points,
-            gd.icells, gd.ijcells);
+        set_ghost_cells(
+                &fld, &mbot, &fields.visc, 1,
+                g.c_idw.data(), g.c_idw_sum.data(), g.di.data(),
+                g.ijk.data(), g.ip_ijk.data(),
+                Boundary_type::Dirichlet_type, g.nghost, n_idw_points);
+    }
 
     boundary_cyclic.exec(fields.mp.at("u")->fld.data());
     boundary_cyclic.exec(fields.mp.at("v")->fld.data());
@@ -679,20 +777,31 @@ void Immersed_boundary<TF>::exec_scalars()
     if (sw_ib == IB_type::Disabled)
         return;
 
-    auto& gd = grid.get_grid_data();
+    if (fields.sp.size() == 0)
+        return;
+
+    // All scalars share the ghost cells at the cell centre, so they are set in one pass.
+    Ghost_cells<TF>& g = ghost.at("s");
+
+    std::vector<TF*> flds;
+    std::vector<const TF*> sbots;
+    std::vector<TF> viscs;
 
     for (auto& it : fields.sp)
     {
-        set_ghost_cells(
-                it.second->fld.data(), ghost.at("s").sbot.at(it.first).data(),
-                ghost.at("s").c_idw.data(), ghost.at("s").c_idw_sum.data(), ghost.at("s").di.data(),
-                ghost.at("s").i.data(), ghost.at("s").j.data(), ghost.at("s").k.data(),
-                ghost.at("s").ip_i.data(), ghost.at("s").ip_j.data(), ghost.at("s").ip_k.data(),
-                sbcbot, it.second->visc, ghost.at("s").i.size(), n_idw_points,
-                gd.icells, gd.ijcells);
+        flds.push_back(it.second->fld.data());
+        sbots.push_back(g.sbot.at(it.first).data());
+        viscs.push_back(it.second->visc);
+    }
 
+    set_ghost_cells(
+            flds.data(), sbots.data(), viscs.data(), flds.size(),
+            g.c_idw.data(), g.c_idw_sum.data(), g.di.data(),
+            g.ijk.data(), g.ip_ijk.data(),
+            sbcbot, g.nghost, n_idw_points);
+
+    for (auto& it : fields.sp)
         boundary_cyclic.exec(it.second->fld.data());
-    }
 }
 #endif
 
@@ -806,35 +915,52 @@ void Immersed_boundary<TF>::create()
         ghost.emplace("v", Ghost_cells<TF>());
         ghost.emplace("w", Ghost_cells<TF>());
 
-        master.print_message("Calculating ghost cells u\n");
-        calc_ghost_cells(
-                ghost.at("u"), dem, gd.xh, gd.y, gd.z,
-                Boundary_type::Dirichlet_type,
-                gd.dx, gd.dy, gd.dz, n_idw_points,
-                gd.istart, gd.jstart, gd.kstart,
-                gd.iend,   gd.jend,   gd.kend,
-                gd.icells, gd.jcells, gd.ijcells,
-                mpi_offset_x, mpi_offset_y);
-
-        master.print_message("Calculating ghost cells v\n");
-        calc_ghost_cells(
-                ghost.at("v"), dem, gd.x, gd.yh, gd.z,
-                Boundary_type::Dirichlet_type,
-                gd.dx, gd.dy, gd.dz, n_idw_points,
-                gd.istart, gd.jstart, gd.kstart,
-                gd.iend,   gd.jend,   gd.kend,
-                gd.icells, gd.jcells, gd.ijcells,
-                mpi_offset_x, mpi_offset_y);
-
-        master.print_message("Calculating ghost cells w\n");
-        calc_ghost_cells(
-                ghost.at("w"), dem, gd.x, gd.y, gd.zh,
-                Boundary_type::Dirichlet_type,
-                gd.dx, gd.dy, gd.dzh, n_idw_points,
-                gd.istart, gd.jstart, gd.kstart,
-                gd.iend,   gd.jend,   gd.kend,
-                gd.icells, gd.jcells, gd.ijcells,
-                mpi_offset_x, mpi_offset_y);
+        // The ghost cells of each process only depend on the DEM, the grid and the IB settings,
+        // such that they can be read back from a cache written by an earlier run.
+        auto get_ghost_cells = [&](
+                const std::string& name, const std::vector<TF>& x, const std::vector<TF>& y, const std::vector<TF>& z,
+                const Boundary_type bc, const std::vector<TF>& dz)
+        {
+            Ghost_cells<TF>& g = ghost.at(name);
+
+            std::uint64_t key = 14695981039346656037ULL;
+            const int settings[] = {
+                    static_cast<int>(bc), n_idw_points, gd.itot, gd.jtot, gd.ktot,
+                    gd.icells, gd.jcells, mpi_offset_x, mpi_offset_y};
+            hash_bytes(key, settings, sizeof(settings)/sizeof(int));
+            hash_bytes(key, dem.data(), dem.size());
+            hash_bytes(key, x.data(), x.size());
+            hash_bytes(key, y.data(), y.size());
+            hash_bytes(key, z.data(), z.size());
+
+            char filename[256];
+            std::snprintf(filename, 256, "ib_ghost_cells_%s.%05d", name.c_str(), mpi.mpiid);
+
+            if (sw_ghost_cell_cache && load_ghost_cells(g, filename, key))
+            {
+                master.print_message("Loaded ghost cells %s from cache\n", name.c_str());
+                return;
+            }
+
+            master.print_message("Calculating ghost cells %s\n", name.c_str());
+            g = Ghost_cells<TF>();
+            calc_ghost_cells(
+                    g, dem, x, y, z, bc,
+                    gd.dx, gd.dy, dz, n_idw_points,
+                    gd.istart, gd.jstart, gd.kstart,
+                    gd.iend,   gd.jend,   gd.kend,
+                    gd.icells, gd.jcells, gd.ijcells,
+                    mpi_offset_x, mpi_offset_y);
+
+            if (sw_ghost_cell_cache && !save_ghost_cells(g, filename, key))
+                throw std::runtime_error("Cannot write the IB ghost cell cache \"" + std::string(filename) + "\"");
+        };
+
+        get_ghost_cells("u", gd.xh, gd.y, gd.z, Boundary_type::Dirichlet_type, gd.dz);
+
+        get_ghost_cells("v", gd.x, gd.yh, gd.z, Boundary_type::Dirichlet_type, gd.dz);
+
+        get_ghost_cells("w", gd.x, gd.y, gd.zh, Boundary_type::Dirichlet_type, gd.dzh);
 
         // Print some statistics (number of ghost cells)
         print_statistics(ghost.at("u").i, std::string("u"), master);
@@ -854,14 +980,7 @@ void Immersed_boundary<TF>::create()
         {
             ghost.emplace("s", Ghost_cells<TF>());
 
-            master.print_message("Calculating ghost cells s\n");
-            calc_ghost_cells(
-                    ghost.at("s"), dem, gd.x, gd.y, gd.z, sbcbot,
-                    gd.dx, gd.dy, gd.dz, n_idw_points,
-                    gd.istart, gd.jstart, gd.kstart,
-                    gd.iend,   gd.jend,   gd.kend,
-                    gd.icells, gd.jcells, gd.ijcells,
-                    mpi_offset_x, mpi_offset_y);
+            get_ghost_cells("s", gd.x, gd.y, gd.z, sbcbot, gd.dz);
 
             print_statistics(ghost.at("s").i, std::string("s"), master);
 
@@ -79,22 +79,14 @@ Input::Input(Master& master, const std::string& file_name) : master(master)
     std::string blockname;
 
     // Read file and throw exception on error.
-    std::ifstream infile;
-
-    int open_error = false;
-    if (master.get_mpiid() == 0)
-    {
-        infile.open(file_name);
-        if (!infile)
-            open_error = true;
-    }
-    master.broadcast(&open_error, 1);
-    if (open_error)
+    std::string content;
+    if (!get_file_from_input(file_name, content, master))
         throw std::runtime_error("\"" + file_name + "\" cannot be opened ");
 
+    std::istringstream infile(content);
     std::string line;
 
-    while (get_line_from_input(infile, line, master))
+    while (std::getline(infile, line))
     {
         // Strip of the comments.
         std::vector<std::string> strings;
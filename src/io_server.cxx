@@ -0,0 +1,225 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <stdexcept>
+
+#include "master.h"
+#include "io_server.h"
+
+namespace
+{
+    const int tag_header = 801;
+    const int tag_data   = 802;
+}
+
+Io_server::Io_server(Master& masterin) :
+    master(masterin)
+{
+    #ifdef USEMPI
+    shutdown_sent = false;
+    #endif
+}
+
+Io_server::~Io_server()
+{
+    // A compute process that leaves on an exception still has to release the servers, which
+    // otherwise wait forever for its shutdown.
+    #ifdef USEMPI
+    if (is_enabled() && !master.is_io_server() && !shutdown_sent)
+        send_shutdown();
+    #endif
+}
+
+bool Io_server::is_enabled() const
+{
+    return master.get_MPI_data().nioservers > 0;
+}
+
+#ifdef USEMPI
+void Io_server::write_block(const std::string& filename, const void* data, const Io_block& block)
+{
+    auto& md = master.get_MPI_data();
+
+    if (filename.size() >= sizeof(Io_header::filename))
+        throw std::runtime_error("Filename " + filename + " is too long for the I/O server");
+
+    // Every file is written by a single server, the compute processes have the same ranks as in commworld.
+    const int server = md.nprocs + std::hash<std::string>{}(filename) % md.nioservers;
+    const size_t nbytes = static_cast<size_t>(block.ni)*block.nj*block.nk*block.itemsize;
+
+    #pragma omp critical (io_server_sends)
+    {
+        // Release the buffers of the sends that have completed.
+        clean_pending_sends(false);
+
+        pending_sends.emplace_back();
+        Pending_send& send = pending_sends.back();
+
+        std::strncpy(send.header.filename, filename.c_str(), sizeof(send.header.filename));
+        send.header.block = block;
+        send.data.assign(static_cast<const char*>(data), static_cast<const char*>(data) + nbytes);
+
+        // The header and the data are posted together, such that a server never receives
+        // the header of one block followed by the data of another.
+        MPI_Isend(&send.header, sizeof(Io_header), MPI_BYTE, server, tag_header, md.commworld, &send.requests[0]);
+        MPI_Isend(send.data.data(), nbytes, MPI_BYTE, server, tag_data, md.commworld, &send.requests[1]);
+    }
+}
+
+void Io_server::finish()
+{
+    if (!is_enabled())
+        return;
+
+    send_shutdown();
+}
+
+void Io_server::send_shutdown()
+{
+    auto& md = master.get_MPI_data();
+
+    #pragma omp critical (io_server_sends)
+    {
+        clean_pending_sends(true);
+
+        // A header without parts tells the servers that this process is done. Messages between
+        // two processes do not overtake each other, so it arrives after all blocks of this process.
+        Io_header header;
+        std::memset(&header, 0, sizeof(Io_header));
+
+        for (int n=0; n<md.nioservers; ++n)
+            MPI_Send(&header, sizeof(Io_header), MPI_BYTE, md.nprocs+n, tag_header, md.commworld);
+
+        shutdown_sent = true;
+    }
+}
+
+void Io_server::clean_pending_sends(const bool wait)
+{
+    for (auto it=pending_sends.begin(); it!=pending_sends.end(); )
+    {
+        int flag = 1;
+        if (wait)
+            MPI_Waitall(2, it->requests, MPI_STATUSES_IGNORE);
+        else
+            MPI_Testall(2, it->requests, &flag, MPI_STATUSES_IGNORE);
+
+        if (flag)
+            it = pending_sends.erase(it);
+        else
+            ++it;
+    }
+}
+
+void Io_server::exec()
+{
+    auto& md = master.get_MPI_data();
+
+    struct Open_file
+    {
+        FILE* file;
+        int nreceived;
+    };
+
+    std::map<std::string, Open_file> files;
+    std::vector<char> buffer;
+
+    int nfinished = 0;
+    while (nfinished < md.nprocs)
+    {
+        Io_header header;
+        MPI_Status status;
+        MPI_Recv(&header, sizeof(Io_header), MPI_BYTE, MPI_ANY_SOURCE, tag_header, md.commworld, &status);
+
+        const Io_block& block = header.block;
+
+        if (block.nparts == 0)
+        {
+            ++nfinished;
+            continue;
+        }
+
+        const size_t nbytes = static_cast<size_t>(block.ni)*block.nj*block.nk*block.itemsize;
+        buffer.resize(nbytes);
+        MPI_Recv(buffer.data(), nbytes, MPI_BYTE, status.MPI_SOURCE, tag_data, md.commworld, MPI_STATUS_IGNORE);
+
+        auto it = files.find(header.filename);
+        if (it == files.end())
+        {
+            FILE* file = std::fopen(header.filename, "wb");
+            if (file == NULL)
+            {
+                std::fprintf(stderr, "WARNING: I/O server cannot open %s\n", header.filename);
+                continue;
+            }
+            it = files.emplace(header.filename, Open_file{file, 0}).first;
+        }
+
+        // Write the block row by row at its position in the file.
+        const size_t rowsize = static_cast<size_t>(block.ni)*block.itemsize;
+        const char* row = buffer.data();
+        bool failed = false;
+
+        for (int k=0; k<block.nk; ++k)
+            for (int j=0; j<block.nj; ++j)
+            {
+                const long long offset =
+                        ( (static_cast<long long>(block.k0+k)*block.nj_tot + (block.j0+j))*block.ni_tot + block.i0 )
+                        * block.itemsize;
+
+                if (std::fseek(it->second.file, offset, SEEK_SET) != 0
+                        || std::fwrite(row, 1, rowsize, it->second.file) != rowsize)
+                    failed = true;
+
+                row += rowsize;
+            }
+
+        if (failed)
+            std::fprintf(stderr, "WARNING: I/O server cannot write to %s\n", header.filename);
+
+        if (++it->second.nreceived == block.nparts)
+        {
+            std::fclose(it->second.file);
+            files.erase(it);
+        }
+    }
+
+    for (auto& it : files)
+    {
+        std::fprintf(stderr, "WARNING: I/O server closes incomplete file %s\n", it.first.c_str());
+        std::fclose(it.second.file);
+    }
+}
+
+#else
+void Io_server::write_block(const std::string& filename, const void* data, const Io_block& block)
+{
+    throw std::runtime_error("I/O servers require MPI");
+}
+
+void Io_server::finish() {}
+void Io_server::exec() {}
+#endif
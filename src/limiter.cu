@@ -59,7 +59,7 @@ namespace
 
 #ifdef USECUDA
 template <typename TF>
-void Limiter<TF>::exec(double dt, Stats<TF>& stats)
+void Limiter<TF>::exec(double dt, Stats<TF>& stats, Timeloop<TF>& timeloop)
 {
     const Grid_data<TF>& gd = grid.get_grid_data();
     const int blocki = gd.ithread_block;
@@ -27,6 +27,7 @@
 #include "fields.h"
 #include "stats.h"
 #include "limiter.h"
+#include "timeloop.h"
 #include "constants.h"
 #include "diff.h"
 
@@ -91,7 +92,7 @@ void Limiter<TF>::create(Stats<TF>& stats)
 
 #ifndef USECUDA
 template <typename TF>
-void Limiter<TF>::exec(double dt, Stats<TF>& stats)
+void Limiter<TF>::exec(double dt, Stats<TF>& stats, Timeloop<TF>& timeloop)
 {
     auto& gd = grid.get_grid_data();
 
@@ -100,8 +101,18 @@ void Limiter<TF>::exec(double dt, Stats<TF>& stats)
     //       as a lower limit for e.g. hydrometeors or chemical species.
     constexpr TF min_value = std::numeric_limits<double>::epsilon();
 
+    // Without the tendency statistics, the limiter is applied in the time integration. It has to be the
+    // last tendency, such that nothing may be added between this call and the integration.
+    const bool in_timeloop = !stats.is_doing_tendency();
+
     for (auto& name : limit_list)
     {
+        if (in_timeloop)
+        {
+            timeloop.add_rk_limit(name, min_value);
+            continue;
+        }
+
         tendency_limiter<TF>(
                 fields.at.at(name)->fld.data(),
                 fields.ap.at(name)->fld.data(),
@@ -114,7 +125,9 @@ void Limiter<TF>::exec(double dt, Stats<TF>& stats)
         stats.calc_tend(*fields.at.at(name), tend_name);
     }
 
-    if (limit_sgstke)
+    if (limit_sgstke && in_timeloop)
+        timeloop.add_rk_limit("sgstke", Constants::sgstke_min<TF>);
+    else if (limit_sgstke)
     {
         tendency_limiter<TF>(
                fields.at.at("sgstke")->fld.data(),
@@ -20,10 +20,14 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <array>
 #include <cstdarg>
 #include <cstdio>
 #include <iostream>
 #include <sstream>
+#ifdef __linux__
+#include <sched.h>
+#endif
 #include "master.h"
 
 void Master::print_message(const char *format, ...)
@@ -77,13 +81,101 @@ void Master::print_warning(const std::string& s)
         std::cout << "WARNING: " << s << std::endl;
 }
 
-bool Master::at_wall_clock_limit()
+std::vector<int> Master::get_cpu_affinity() const
 {
-    const double wall_clock_time_left = wall_clock_end - get_wall_clock_time();
-    const double ten_minutes = 10.*60.;
+    std::vector<int> cpus;
 
-    if (wall_clock_time_left < ten_minutes)
-        return true;
-    else
-        return false;
+    #ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+    {
+        for (int n=0; n<CPU_SETSIZE; ++n)
+            if (CPU_ISSET(n, &mask))
+                cpus.push_back(n);
+    }
+    #endif
+
+    return cpus;
+}
+
+
+// Write a list of CPUs in ranges, as in "0-7,16-23".
+std::string Master::format_cpu_list(const std::vector<int>& cpus)
+{
+    std::ostringstream ss;
+
+    for (size_t n=0; n<cpus.size(); ++n)
+    {
+        size_t m = n;
+        while (m+1 < cpus.size() && cpus[m+1] == cpus[m]+1)
+            ++m;
+
+        if (n > 0)
+            ss << ",";
+        ss << cpus[n];
+        if (m > n)
+            ss << "-" << cpus[m];
+
+        n = m;
+    }
+
+    return ss.str();
+}
+
+void Master::add_comm(Comm_site site, double nbytes, int nmessages, double wait_time)
+{
+    if (!swcommstats)
+        return;
+
+    const int n = static_cast<int>(site);
+
+    // The statistics task communicates concurrently with the time loop.
+    #pragma omp atomic
+    comm_bytes[n] += nbytes;
+    #pragma omp atomic
+    comm_messages[n] += nmessages;
+    #pragma omp atomic
+    comm_time[n] += wait_time;
+}
+
+void Master::print_comm_stats()
+{
+    if (!swcommstats)
+        return;
+
+    const char* site_names[ncomm_sites] = {
+        "halo", "halo_2d", "halo_mask",
+        "transpose_zx", "transpose_xz", "transpose_xy", "transpose_yx", "transpose_yz", "transpose_zy",
+        "reduction", "io", "other"};
+
+    // Copy the counters first, as the reductions below are counted as well.
+    std::array<double, 3*ncomm_sites> comm_sum;
+    for (int n=0; n<ncomm_sites; ++n)
+    {
+        comm_sum[3*n  ] = comm_bytes[n];
+        comm_sum[3*n+1] = comm_messages[n];
+        comm_sum[3*n+2] = comm_time[n];
+    }
+
+    std::array<double, ncomm_sites> time_max(comm_time);
+
+    sum(comm_sum.data(), 3*ncomm_sites);
+    max(time_max.data(), ncomm_sites);
+
+    print_message("Communication per process (mean over %d processes):\n", md.nprocs);
+    print_message("%-14s %14s %14s %12s %12s\n", "site", "messages", "MB sent", "wait (s)", "max wait (s)");
+
+    for (int n=0; n<ncomm_sites; ++n)
+    {
+        if (comm_sum[3*n+1] == 0. && comm_sum[3*n+2] == 0.)
+            continue;
+
+        print_message("%-14s %14.0f %14.3f %12.3f %12.3f\n",
+                site_names[n],
+                comm_sum[3*n+1] / md.nprocs,
+                comm_sum[3*n  ] / md.nprocs * 1.e-6,
+                comm_sum[3*n+2] / md.nprocs,
+                time_max[n]);
+    }
 }
@@ -23,48 +23,141 @@
 #ifdef USEMPI
 
 #include <mpi.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
 #include <stdexcept>
+#include <vector>
+
+#ifdef USECUDA
+#include <cuda_runtime_api.h>
+#endif
 
 #include "grid.h"
 #include "defines.h"
 #include "master.h"
 
+namespace
+{
+    // Pick the npx*npy layout that fits the grid and that minimizes the number of grid points per process
+    // that cross a process boundary in one pressure solve (transposes) plus one halo exchange.
+    void pick_decomposition(
+            int& npx, int& npy, const int nprocs,
+            const int itot, const int jtot, const int ktot)
+    {
+        double cost_min = -1.;
+
+        for (int npx_try=1; npx_try<=nprocs; ++npx_try)
+        {
+            if (nprocs % npx_try != 0)
+                continue;
+
+            const int npy_try = nprocs / npx_try;
+
+            // Apply the same constraints as Grid::init.
+            if ( itot % npx_try != 0 || itot % npy_try != 0 || jtot % npy_try != 0 || ktot % npx_try != 0
+                    || (jtot % npx_try != 0 && npy_try > 1) )
+                continue;
+
+            const double imax = itot / npx_try;
+            const double jmax = jtot / npy_try;
+            const double nmax = imax*jmax*ktot;
+
+            // Each transpose keeps a fraction of 1/np of its data on the process.
+            const double cost_transpose = 2.*nmax*( (1. - 1./npx_try) + (1. - 1./npy_try) );
+            const double cost_halo = 2.*ktot*( (npx_try > 1 ? jmax : 0.) + (npy_try > 1 ? imax : 0.) );
+            const double cost = cost_transpose + cost_halo;
+
+            if (cost_min < 0. || cost < cost_min)
+            {
+                cost_min = cost;
+                npx = npx_try;
+                npy = npy_try;
+            }
+        }
+
+        if (cost_min < 0.)
+        {
+            std::string msg = "No npx*npy decomposition of nprocs = " + std::to_string(nprocs) + " fits the grid";
+            throw std::runtime_error(msg);
+        }
+    }
+}
+
 Master::Master()
 {
     initialized = false;
+    owns_mpi    = false;
+    thread_multiple = false;
+    progress_stop = false;
     allocated   = false;
+    npthreads   = 1;
+    swpackedtranspose = false;
+    mpi_wait_time = 0.;
+    mpiid_node = 0;
+
+    swcommstats = false;
+    comm_bytes.fill(0.);
+    comm_messages.fill(0.);
+    comm_time.fill(0.);
 
     // set the mpiid, to ensure that errors can be written if MPI init fails
     md.mpiid = 0;
+
+    md.nioservers = 0;
+    md.ioserver = false;
 }
 
 Master::~Master()
 {
+    stop_progress_thread();
+
     if (allocated)
     {
+        for (size_t n=0; n<node_windows.size(); ++n)
+            free_node_shared(n);
+
         delete[] reqs;
+        MPI_Comm_free(&md.commnode);
         MPI_Comm_free(&md.commxy);
         MPI_Comm_free(&md.commx);
         MPI_Comm_free(&md.commy);
     }
 
+    if (allocated || md.ioserver)
+        MPI_Comm_free(&md.commworld);
+
+    if (initialized && md.commmember != MPI_COMM_WORLD)
+        MPI_Comm_free(&md.commmember);
+
     print_message("Finished run on %d processes\n", md.nprocs);
 
-    if (initialized)
+    if (initialized && owns_mpi)
         MPI_Finalize();
 }
 
 void Master::start()
 {
-    // initialize the MPI
-    int n = MPI_Init(NULL, NULL);
+    // initialize the MPI, unless the program that embeds the model has done so. Communication
+    // from several threads, as in the output tasks and the progress thread, needs MPI_THREAD_MULTIPLE.
+    int mpi_started;
+    MPI_Initialized(&mpi_started);
+    owns_mpi = !mpi_started;
+
+    int thread_level;
+    int n = owns_mpi ? MPI_Init_thread(NULL, NULL, MPI_THREAD_MULTIPLE, &thread_level) : MPI_Query_thread(&thread_level);
     if (check_error(n))
         throw std::runtime_error("MPI init error");
 
+    thread_multiple = (thread_level >= MPI_THREAD_MULTIPLE);
+
     wall_clock_start = get_wall_clock_time();
 
     initialized = true;
 
+    md.commmember = MPI_COMM_WORLD;
+
     // get the rank of the current process
     n = MPI_Comm_rank(MPI_COMM_WORLD, &md.mpiid);
     if (check_error(n))
@@ -80,13 +173,122 @@ void Master::start()
     if (check_error(n))
         throw std::runtime_error("MPI init error");
 
+    #ifdef USECUDA
+    // Bind each process to one of the GPUs of its node, using the rank within the node.
+    MPI_Comm commnode;
+    n = MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, md.mpiid, MPI_INFO_NULL, &commnode);
+    if (check_error(n))
+        throw std::runtime_error("MPI init error");
+
+    int mpiid_node;
+    MPI_Comm_rank(commnode, &mpiid_node);
+    MPI_Comm_free(&commnode);
+
+    int ndevices = 0;
+    if (cudaGetDeviceCount(&ndevices) != cudaSuccess || ndevices == 0)
+        throw std::runtime_error("No CUDA devices found");
+
+    cudaSetDevice(mpiid_node % ndevices);
+    #endif
+
     print_message("Starting run on %d processes\n", md.nprocs);
+
+    const char* level_names[] = {"single", "funneled", "serialized", "multiple"};
+    const int level = (thread_level == MPI_THREAD_SINGLE) ? 0 : (thread_level == MPI_THREAD_FUNNELED) ? 1
+                    : (thread_level == MPI_THREAD_SERIALIZED) ? 2 : 3;
+    print_message("MPI thread support: %s\n", level_names[level]);
+}
+
+int Master::split_ensemble(const int nmembers)
+{
+    if (allocated)
+        throw std::runtime_error("The ensemble has to be split before the grid communicators are made");
+
+    if (nmembers < 1 || md.nprocs % nmembers != 0)
+        throw std::runtime_error(
+                "nprocs = " + std::to_string(md.nprocs) + " is not a multiple of the number of ensemble members");
+
+    // Consecutive ranks keep the processes of a member together on the nodes. The GPUs are bound
+    // by the rank on the node in start(), such that with more processes than GPUs per node,
+    // the members share the devices.
+    const int member = md.mpiid / (md.nprocs / nmembers);
+
+    int n = MPI_Comm_split(MPI_COMM_WORLD, member, md.mpiid, &md.commmember);
+    if (check_error(n))
+        throw std::runtime_error("MPI init error");
+
+    // Replace the temporary copy of COMM_WORLD, such that the input is read per member.
+    n = MPI_Comm_free(&md.commxy);
+    if (check_error(n))
+        throw std::runtime_error("MPI init error");
+
+    n = MPI_Comm_dup(md.commmember, &md.commxy);
+    if (check_error(n))
+        throw std::runtime_error("MPI init error");
+
+    MPI_Comm_rank(md.commmember, &md.mpiid);
+    MPI_Comm_size(md.commmember, &md.nprocs);
+
+    return member;
 }
 
 void Master::init(Input& input)
 {
-    md.npx = input.get_item<int>("master", "npx", "", 1);
-    md.npy = input.get_item<int>("master", "npy", "", 1);
+    // The last nioservers processes do not compute, but write the output that the others send to them.
+    md.nioservers = input.get_item<int>("master", "nioservers", "", 0);
+    if (md.nioservers < 0 || md.nioservers >= md.nprocs)
+        throw std::runtime_error("nioservers has to be at least 0 and smaller than the number of processes");
+
+    const int mpiid_world = md.mpiid;
+    md.nprocs -= md.nioservers;
+    md.ioserver = (mpiid_world >= md.nprocs);
+
+    int n = MPI_Comm_dup(md.commmember, &md.commworld);
+    if (check_error(n))
+        throw std::runtime_error("MPI init error");
+
+    // The grid communicators are built on the compute processes only, ordered as in COMM_WORLD.
+    MPI_Comm commcompute;
+    n = MPI_Comm_split(md.commmember, md.ioserver, mpiid_world, &commcompute);
+    if (check_error(n))
+        throw std::runtime_error("MPI init error");
+
+    if (md.ioserver)
+    {
+        MPI_Comm_free(&commcompute);
+        MPI_Comm_free(&md.commxy);
+
+        md.mpicoordx = -1;
+        md.mpicoordy = -1;
+        return;
+    }
+
+    // With swautodecomp, npx and npy are derived from the number of processes and the grid.
+    if (input.get_item<bool>("master", "swautodecomp", "", false))
+    {
+        const int itot = input.get_item<int>("grid", "itot", "");
+        const int jtot = input.get_item<int>("grid", "jtot", "");
+        const int ktot = input.get_item<int>("grid", "ktot", "");
+
+        pick_decomposition(md.npx, md.npy, md.nprocs, itot, jtot, ktot);
+        print_message("Automatic decomposition: npx = %d, npy = %d\n", md.npx, md.npy);
+    }
+    else
+    {
+        md.npx = input.get_item<int>("master", "npx", "", 1);
+        md.npy = input.get_item<int>("master", "npy", "", 1);
+    }
+
+    // Get the number of OpenMP threads per process for the CPU kernels.
+    npthreads = input.get_item<int>("master", "npthreads", "", 1);
+    if (npthreads < 1)
+        throw std::runtime_error("npthreads has to be at least 1");
+
+    // Use packed buffers with persistent requests in the transposes of the FFT.
+    swpackedtranspose = input.get_item<bool>("master", "swpackedtranspose", "", false);
+
+    // Count the bytes, messages and wait time per communication site.
+    swcommstats = input.get_item<bool>("master", "swcommstats", "", false);
 
     // Get the wall clock limit with a default value of 1E8 hours, which will be never hit.
     double wall_clock_limit = input.get_item<double>("master", "wallclocklimit", "", 1E8);
@@ -99,7 +301,35 @@ void Master::init(Input& input)
         throw std::runtime_error(msg);
     }
 
-    int n;
+    // The Cartesian layout is filled in rank order with x fastest. With cartreorder=node, the processes
+    // are first renumbered such that those of a node are consecutive, which places them next to each
+    // other in x, where the zx transposes communicate. With cartreorder=mpi, the library may reorder.
+    const std::string cartreorder = input.get_item<std::string>("master", "cartreorder", "", "none");
+    if (cartreorder != "none" && cartreorder != "mpi" && cartreorder != "node")
+        throw std::runtime_error("Illegal value for cartreorder, options are none, mpi and node");
+
+    if (cartreorder == "node")
+    {
+        MPI_Comm commshared;
+        n = MPI_Comm_split_type(commcompute, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &commshared);
+        if (check_error(n))
+            throw std::runtime_error("MPI init error");
+
+        // A node is identified by its lowest rank, the ties in the split keep the order within a node.
+        int node_id;
+        MPI_Comm_rank(commcompute, &node_id);
+        MPI_Allreduce(MPI_IN_PLACE, &node_id, 1, MPI_INT, MPI_MIN, commshared);
+        MPI_Comm_free(&commshared);
+
+        MPI_Comm commsorted;
+        n = MPI_Comm_split(commcompute, 0, node_id, &commsorted);
+        if (check_error(n))
+            throw std::runtime_error("MPI init error");
+
+        MPI_Comm_free(&commcompute);
+        commcompute = commsorted;
+    }
+
     int dims    [2] = {md.npy, md.npx};
     int periodic[2] = {true, true};
 
@@ -114,11 +344,13 @@ void Master::init(Input& input)
     if (check_error(n))
         throw std::runtime_error("MPI init error");
 
-    // for now, do not reorder processes, blizzard gives large performance loss
-    n = MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periodic, false, &md.commxy);
+    // By default, do not reorder processes, blizzard gives large performance loss
+    n = MPI_Cart_create(commcompute, 2, dims, periodic, cartreorder == "mpi", &md.commxy);
     if (check_error(n))
         throw std::runtime_error("MPI init error");
 
+    MPI_Comm_free(&commcompute);
+
     n = MPI_Comm_rank(md.commxy, &md.mpiid);
     if (check_error(n))
         throw std::runtime_error("MPI init error");
@@ -152,6 +384,15 @@ void Master::init(Input& input)
     if (check_error(n))
         throw std::runtime_error("MPI init error");
 
+    // Group the processes that share the memory of a node, for the tables in node shared memory.
+    n = MPI_Comm_split_type(md.commxy, MPI_COMM_TYPE_SHARED, md.mpiid, MPI_INFO_NULL, &md.commnode);
+    if (check_error(n))
+        throw std::runtime_error("MPI init error");
+
+    MPI_Comm_rank(md.commnode, &mpiid_node);
+
+    report_locality();
+
     // create the requests arrays for the nonblocking sends
     int npmax;
     npmax = std::max(md.npx, md.npy);
@@ -161,9 +402,136 @@ void Master::init(Input& input)
     reqs  = new MPI_Request[npmax*2];
     reqsn = 0;
 
+    // Optionally, run a thread that keeps the non-blocking communication progressing.
+    if (input.get_item<bool>("master", "swprogressthread", "", false))
+    {
+        if (!thread_multiple)
+            throw std::runtime_error("swprogressthread requires an MPI library with MPI_THREAD_MULTIPLE");
+
+        start_progress_thread(input.get_item<int>("master", "progressinterval", "", 100));
+    }
+
+    // Report the CPU and GPU placement of all processes, and stop on oversubscribed CPUs.
+    if (input.get_item<bool>("master", "swaffinity", "", false))
+        check_affinity();
+
     allocated = true;
 }
 
+void Master::start_progress_thread(const int interval)
+{
+    if (interval < 1)
+        throw std::runtime_error("progressinterval has to be at least 1 microsecond");
+
+    // The probes run on a communicator of their own, such that they never match a message of the model.
+    int n = MPI_Comm_dup(md.commxy, &commprogress);
+    if (check_error(n))
+        throw std::runtime_error("MPI init error");
+
+    progress_stop = false;
+    progress_thread = std::thread([this, interval]()
+    {
+        while (!progress_stop)
+        {
+            int flag;
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, commprogress, &flag, MPI_STATUS_IGNORE);
+            std::this_thread::sleep_for(std::chrono::microseconds(interval));
+        }
+    });
+}
+
+void Master::stop_progress_thread()
+{
+    if (!progress_thread.joinable())
+        return;
+
+    progress_stop = true;
+    progress_thread.join();
+    MPI_Comm_free(&commprogress);
+}
+
+void Master::report_locality()
+{
+    // The node of a process is identified by the lowest rank on it.
+    int node_id = md.mpiid;
+    MPI_Allreduce(MPI_IN_PLACE, &node_id, 1, MPI_INT, MPI_MIN, md.commnode);
+    const int nnodes_local = (mpiid_node == 0);
+
+    // Fraction of the other processes in a transpose communicator that are on the same node.
+    auto calc_fraction = [&](MPI_Comm comm, const int size)
+    {
+        if (size == 1)
+            return 1.;
+
+        std::vector<int> node_ids(size);
+        MPI_Allgather(&node_id, 1, MPI_INT, node_ids.data(), 1, MPI_INT, comm);
+        const int nsame = std::count(node_ids.begin(), node_ids.end(), node_id) - 1;
+        return static_cast<double>(nsame) / (size-1);
+    };
+
+    double fractions[2] = {calc_fraction(md.commx, md.npx), calc_fraction(md.commy, md.npy)};
+    MPI_Allreduce(MPI_IN_PLACE, fractions, 2, MPI_DOUBLE, MPI_SUM, md.commxy);
+
+    int nnodes = nnodes_local;
+    MPI_Allreduce(MPI_IN_PLACE, &nnodes, 1, MPI_INT, MPI_SUM, md.commxy);
+
+    print_message("Communication locality: %d nodes, %.1f%% of the x and %.1f%% of the y transpose partners on the same node\n",
+            nnodes, 100.*fractions[0]/md.nprocs, 100.*fractions[1]/md.nprocs);
+}
+
+void Master::check_affinity()
+{
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host)-1);
+
+    int device = -1;
+    #ifdef USECUDA
+    cudaGetDevice(&device);
+    #endif
+
+    const std::vector<int> cpus = get_cpu_affinity();
+
+    // Gather one line per process, and print them in order of rank.
+    constexpr int nline = 512;
+    std::vector<char> line(nline);
+    std::snprintf(line.data(), nline, "Affinity: process %d on %s, GPU %d, %d threads on CPUs %s\n",
+            md.mpiid, host, device, npthreads, format_cpu_list(cpus).c_str());
+
+    std::vector<char> lines(md.mpiid == 0 ? nline*md.nprocs : 0);
+    MPI_Gather(line.data(), nline, MPI_CHAR, lines.data(), nline, MPI_CHAR, 0, md.commxy);
+
+    if (md.mpiid == 0)
+        for (int n=0; n<md.nprocs; ++n)
+            print_message("%s", &lines[n*nline]);
+
+    // Count the processes on this node that claim each CPU.
+    MPI_Comm commnode;
+    MPI_Comm_split_type(md.commxy, MPI_COMM_TYPE_SHARED, md.mpiid, MPI_INFO_NULL, &commnode);
+
+    constexpr int ncpus_max = 1024;
+    std::vector<int> claims(ncpus_max, 0);
+    for (const int cpu : cpus)
+        if (cpu < ncpus_max)
+            claims[cpu] = 1;
+    MPI_Allreduce(MPI_IN_PLACE, claims.data(), ncpus_max, MPI_INT, MPI_SUM, commnode);
+    MPI_Comm_free(&commnode);
+
+    int nerror = 0;
+    if (!cpus.empty() && static_cast<int>(cpus.size()) < npthreads)
+        ++nerror;
+    for (const int cpu : cpus)
+        if (cpu < ncpus_max && claims[cpu] > 1)
+        {
+            ++nerror;
+            break;
+        }
+
+    sum(&nerror, 1);
+
+    if (nerror)
+        throw std::runtime_error("Processes share CPUs or have fewer CPUs than npthreads, check the pinning of the job");
+}
+
 double Master::get_wall_clock_time()
 {
     return MPI_Wtime();
@@ -192,11 +560,41 @@ MPI_Request* Master::get_request_ptr()
     return req;
 }
 
-void Master::wait_all()
+void Master::wait_all(Comm_site site)
 {
     // Wait for MPI processes and reset the number of pending requests.
+    const double start = MPI_Wtime();
     MPI_Waitall(reqsn, reqs, MPI_STATUSES_IGNORE);
     reqsn = 0;
+
+    // The halo exchanges of the statistics task may wait concurrently with the time loop.
+    const double wait_time = MPI_Wtime() - start;
+    #pragma omp atomic
+    mpi_wait_time += wait_time;
+
+    add_comm(site, 0., 0, wait_time);
+}
+
+void Master::wait_all(int nreqs, MPI_Request* reqs_in, Comm_site site)
+{
+    const double start = MPI_Wtime();
+    MPI_Waitall(nreqs, reqs_in, MPI_STATUSES_IGNORE);
+
+    const double wait_time = MPI_Wtime() - start;
+    #pragma omp atomic
+    mpi_wait_time += wait_time;
+
+    add_comm(site, 0., 0, wait_time);
+}
+
+void Master::add_comm(Comm_site site, MPI_Datatype type, int nmessages)
+{
+    if (!swcommstats)
+        return;
+
+    int type_size;
+    MPI_Type_size(type, &type_size);
+    add_comm(site, static_cast<double>(type_size)*nmessages, nmessages);
 }
 
 // CvH obsolete: do all broadcasts over the MPI_COMM_WORLD, to avoid complications in the input file reading
@@ -232,36 +630,111 @@ void Master::broadcast(float* data, int datasize, int mpiid_to_send)
 
 void Master::sum(int* var, int datasize)
 {
+    const double start = MPI_Wtime();
     MPI_Allreduce(MPI_IN_PLACE, var, datasize, MPI_INT, MPI_SUM, md.commxy);
+    add_comm(Comm_site::Reduction, datasize*sizeof(int), 1, MPI_Wtime() - start);
 }
 
 void Master::sum(double* var, int datasize)
 {
+    const double start = MPI_Wtime();
     MPI_Allreduce(MPI_IN_PLACE, var, datasize, MPI_DOUBLE, MPI_SUM, md.commxy);
+    add_comm(Comm_site::Reduction, datasize*sizeof(double), 1, MPI_Wtime() - start);
 }
 
 void Master::sum(float* var, int datasize)
 {
+    const double start = MPI_Wtime();
     MPI_Allreduce(MPI_IN_PLACE, var, datasize, MPI_FLOAT, MPI_SUM, md.commxy);
+    add_comm(Comm_site::Reduction, datasize*sizeof(float), 1, MPI_Wtime() - start);
+}
+
+void Master::sum_begin(double* var, int datasize, MPI_Request* request)
+{
+    MPI_Iallreduce(MPI_IN_PLACE, var, datasize, MPI_DOUBLE, MPI_SUM, md.commxy, request);
+}
+
+void Master::sum_begin(float* var, int datasize, MPI_Request* request)
+{
+    MPI_Iallreduce(MPI_IN_PLACE, var, datasize, MPI_FLOAT, MPI_SUM, md.commxy, request);
 }
 
 void Master::max(double* var, int datasize)
 {
+    const double start = MPI_Wtime();
     MPI_Allreduce(MPI_IN_PLACE, var, datasize, MPI_DOUBLE, MPI_MAX, md.commxy);
+    add_comm(Comm_site::Reduction, datasize*sizeof(double), 1, MPI_Wtime() - start);
 }
 
 void Master::max(float* var, int datasize)
 {
+    const double start = MPI_Wtime();
     MPI_Allreduce(MPI_IN_PLACE, var, datasize, MPI_FLOAT, MPI_MAX, md.commxy);
+    add_comm(Comm_site::Reduction, datasize*sizeof(float), 1, MPI_Wtime() - start);
 }
 
 void Master::min(double* var, int datasize)
 {
+    const double start = MPI_Wtime();
     MPI_Allreduce(MPI_IN_PLACE, var, datasize, MPI_DOUBLE, MPI_MIN, md.commxy);
+    add_comm(Comm_site::Reduction, datasize*sizeof(double), 1, MPI_Wtime() - start);
 }
 
 void Master::min(float* var, int datasize)
 {
+    const double start = MPI_Wtime();
     MPI_Allreduce(MPI_IN_PLACE, var, datasize, MPI_FLOAT, MPI_MIN, md.commxy);
+    add_comm(Comm_site::Reduction, datasize*sizeof(float), 1, MPI_Wtime() - start);
+}
+
+void* Master::allocate_node_shared(const std::size_t nbytes, int& id)
+{
+    if (!allocated)
+        throw std::runtime_error("Node shared memory cannot be allocated before Master::init");
+
+    // Only the first process of the node contributes memory to the window.
+    const MPI_Aint size = (mpiid_node == 0) ? nbytes : 0;
+
+    void* ptr;
+    MPI_Win win;
+    int n = MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, md.commnode, &ptr, &win);
+    if (check_error(n))
+        throw std::runtime_error("MPI shared memory error");
+
+    MPI_Aint size_root;
+    int disp_unit;
+    n = MPI_Win_shared_query(win, 0, &size_root, &disp_unit, &ptr);
+    if (check_error(n))
+        throw std::runtime_error("MPI shared memory error");
+
+    // The window stays in a passive target epoch until it is freed, which allows for MPI_Win_sync.
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+    node_windows.push_back(win);
+    id = node_windows.size()-1;
+
+    return ptr;
+}
+
+void Master::sync_node_shared(const int id)
+{
+    MPI_Win_sync(node_windows.at(id));
+    MPI_Barrier(md.commnode);
+    MPI_Win_sync(node_windows.at(id));
+}
+
+void Master::free_node_shared(const int id)
+{
+    MPI_Win& win = node_windows.at(id);
+    if (win == MPI_WIN_NULL)
+        return;
+
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win);
+}
+
+void Master::gather(const double* data_send, double* data_recv, int datasize, int mpiid_to_recv)
+{
+    MPI_Gather(data_send, datasize, MPI_DOUBLE, data_recv, datasize, MPI_DOUBLE, mpiid_to_recv, md.commxy);
 }
 #endif
@@ -23,7 +23,13 @@
 #ifndef USEMPI
 
 #include <sys/time.h>
+#include <unistd.h>
 #include <stdexcept>
+#include <algorithm>
+
+#ifdef USECUDA
+#include <cuda_runtime_api.h>
+#endif
 
 #include "grid.h"
 #include "defines.h"
@@ -32,7 +38,21 @@
 Master::Master()
 {
     initialized = false;
+    owns_mpi    = false;
+    thread_multiple = true;
     allocated   = false;
+    npthreads   = 1;
+    swpackedtranspose = false;
+    mpi_wait_time = 0.;
+    mpiid_node = 0;
+
+    swcommstats = false;
+    comm_bytes.fill(0.);
+    comm_messages.fill(0.);
+    comm_time.fill(0.);
+
+    md.nioservers = 0;
+    md.ioserver = false;
 }
 
 Master::~Master()
@@ -56,10 +76,42 @@ void Master::start()
 
 }
 
+int Master::split_ensemble(const int nmembers)
+{
+    if (nmembers != 1)
+        throw std::runtime_error("Ensembles require MPI");
+
+    return 0;
+}
+
 void Master::init(Input& input)
 {
-    md.npx = input.get_item<int>("master", "npx", "", 1);
-    md.npy = input.get_item<int>("master", "npy", "", 1);
+    // In serial mode the automatic decomposition is always 1*1.
+    if (input.get_item<bool>("master", "swautodecomp", "", false))
+    {
+        md.npx = 1;
+        md.npy = 1;
+    }
+    else
+    {
+        md.npx = input.get_item<int>("master", "npx", "", 1);
+        md.npy = input.get_item<int>("master", "npy", "", 1);
+    }
+
+    // Get the number of OpenMP threads per process for the CPU kernels.
+    npthreads = input.get_item<int>("master", "npthreads", "", 1);
+    if (npthreads < 1)
+        throw std::runtime_error("npthreads has to be at least 1");
+
+    // Use packed buffers with persistent requests in the transposes of the FFT.
+    swpackedtranspose = input.get_item<bool>("master", "swpackedtranspose", "", false);
+
+    // Count the bytes, messages and wait time per communication site.
+    swcommstats = input.get_item<bool>("master", "swcommstats", "", false);
+
+    // Report the CPU and GPU placement, and stop if the threads are oversubscribed.
+    if (input.get_item<bool>("master", "swaffinity", "", false))
+        check_affinity();
 
     // Get the wall clock limit with a default value of 1E8 hours, which will be never hit
     double wall_clock_limit = input.get_item<double>("master", "wallclocklimit", "", 1E8);
@@ -72,6 +124,9 @@ void Master::init(Input& input)
         throw std::runtime_error(msg);
     }
 
+    if (input.get_item<int>("master", "nioservers", "", 0) != 0)
+        throw std::runtime_error("I/O servers require MPI");
+
     // set the coordinates to 0
     md.mpicoordx = 0;
     md.mpicoordy = 0;
@@ -79,6 +134,29 @@ void Master::init(Input& input)
     allocated = true;
 }
 
+void Master::check_affinity()
+{
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host)-1);
+
+    int device = -1;
+    #ifdef USECUDA
+    cudaGetDevice(&device);
+    #endif
+
+    const std::vector<int> cpus = get_cpu_affinity();
+
+    print_message("Affinity: process 0 on %s, GPU %d, %d threads on CPUs %s\n",
+            host, device, npthreads, format_cpu_list(cpus).c_str());
+
+    if (!cpus.empty() && static_cast<int>(cpus.size()) < npthreads)
+    {
+        std::string msg = "npthreads = " + std::to_string(npthreads) + " exceeds the "
+            + std::to_string(cpus.size()) + " CPUs in the affinity mask";
+        throw std::runtime_error(msg);
+    }
+}
+
 double Master::get_wall_clock_time()
 {
     timeval timestruct;
@@ -102,4 +180,24 @@ void Master::max(double* var, int datasize) {}
 void Master::max(float* var, int datasize) {}
 void Master::min(double* var, int datasize) {}
 void Master::min(float* var, int datasize) {}
+
+void* Master::allocate_node_shared(const std::size_t nbytes, int& id)
+{
+    node_buffers.emplace_back(nbytes);
+    id = node_buffers.size()-1;
+
+    return node_buffers.back().data();
+}
+
+void Master::sync_node_shared(const int id) {}
+
+void Master::free_node_shared(const int id)
+{
+    std::vector<char>().swap(node_buffers.at(id));
+}
+
+void Master::gather(const double* data_send, double* data_recv, int datasize, int mpiid_to_recv)
+{
+    std::copy(data_send, data_send + datasize, data_recv);
+}
 #endif
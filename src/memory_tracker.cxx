@@ -0,0 +1,123 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "master.h"
+#include "cuda_buffer.h"
+#include "memory_tracker.h"
+
+namespace
+{
+    double get_host_bytes()
+    {
+        #if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        // Small allocations come from the arenas and large ones are mapped directly.
+        const struct mallinfo2 info = mallinfo2();
+        return static_cast<double>(info.uordblks) + static_cast<double>(info.hblkhd);
+        #else
+        return 0.;
+        #endif
+    }
+
+    double get_host_peak_bytes()
+    {
+        // The maximum resident set size is given in kilobytes on Linux.
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return 1024.*static_cast<double>(usage.ru_maxrss);
+    }
+}
+
+Memory_tracker::Memory_tracker(Master& masterin) :
+    master(masterin)
+{
+}
+
+void Memory_tracker::track(const std::string& name, const std::function<void()>& function)
+{
+    const double host_start = get_host_bytes();
+    const double device_start = cuda_get_memory_usage().current;
+
+    function();
+
+    auto it = modules.find(name);
+    if (it == modules.end())
+    {
+        it = modules.emplace(name, Module{0., 0.}).first;
+        names.push_back(name);
+    }
+
+    it->second.host_bytes += get_host_bytes() - host_start;
+    it->second.device_bytes += static_cast<double>(cuda_get_memory_usage().current) - device_start;
+}
+
+void Memory_tracker::print()
+{
+    const int nmodules = names.size();
+    const int nprocs = master.get_MPI_data().nprocs;
+
+    std::vector<double> bytes_sum(2*nmodules+2);
+    for (int n=0; n<nmodules; ++n)
+    {
+        bytes_sum[2*n  ] = modules.at(names[n]).host_bytes;
+        bytes_sum[2*n+1] = modules.at(names[n]).device_bytes;
+    }
+    bytes_sum[2*nmodules  ] = get_host_bytes();
+    bytes_sum[2*nmodules+1] = cuda_get_memory_usage().current;
+
+    std::vector<double> bytes_max(bytes_sum);
+
+    master.sum(bytes_sum.data(), 2*nmodules+2);
+    master.max(bytes_max.data(), 2*nmodules+2);
+
+    const double mb = 1.e-6;
+
+    master.print_message("Memory per process after initialization (MB):\n");
+    master.print_message("%-16s %12s %12s %12s %12s\n", "module", "host mean", "host max", "device mean", "device max");
+
+    for (int n=0; n<nmodules; ++n)
+        master.print_message("%-16s %12.1f %12.1f %12.1f %12.1f\n",
+                names[n].c_str(),
+                mb*bytes_sum[2*n]/nprocs, mb*bytes_max[2*n],
+                mb*bytes_sum[2*n+1]/nprocs, mb*bytes_max[2*n+1]);
+
+    master.print_message("%-16s %12.1f %12.1f %12.1f %12.1f\n",
+            "total",
+            mb*bytes_sum[2*nmodules]/nprocs, mb*bytes_max[2*nmodules],
+            mb*bytes_sum[2*nmodules+1]/nprocs, mb*bytes_max[2*nmodules+1]);
+}
+
+void Memory_tracker::print_peak(const int ntmp, const int ntmp_g, const int ntmp_peak, const int ntmp_peak_g)
+{
+    double peak[2] = {get_host_peak_bytes(), static_cast<double>(cuda_get_memory_usage().high_water_mark)};
+    master.max(peak, 2);
+
+    master.print_message("Peak memory per process: host (resident) = %.1f MB, device = %.1f MB\n",
+            1.e-6*peak[0], 1.e-6*peak[1]);
+    master.print_message("Temporary fields allocated: host = %d, device = %d\n", ntmp, ntmp_g);
+    master.print_message("Temporary fields in use at once: host = %d, device = %d\n", ntmp_peak, ntmp_peak_g);
+}
@@ -0,0 +1,151 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <stdexcept>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "timeloop.h"
+#include "model.h"
+#include "microhh_api.h"
+
+#ifdef FLOAT_SINGLE
+using TF_api = float;
+#else
+using TF_api = double;
+#endif
+
+struct Microhh_model
+{
+    // The master is declared first, such that it outlives the model.
+    Master master;
+    std::unique_ptr<Model<TF_api>> model;
+};
+
+namespace
+{
+    // Exceptions may not pass the C interface.
+    template<typename F>
+    int call_safe(Microhh_model* m, F&& f)
+    {
+        try
+        {
+            return f();
+        }
+        catch (const std::exception& e)
+        {
+            m->master.print_message("EXCEPTION: %s\n", e.what());
+            return -1;
+        }
+    }
+}
+
+extern "C" Microhh_model* microhh_create(int argc, char** argv)
+{
+    auto m = std::make_unique<Microhh_model>();
+
+    const int err = call_safe(m.get(), [&]()
+    {
+        m->master.start();
+        m->model = std::make_unique<Model<TF_api>>(m->master, argc, argv);
+        m->model->init();
+        m->model->load_or_save();
+        m->model->start_exec();
+        return 0;
+    });
+
+    return (err == 0) ? m.release() : nullptr;
+}
+
+extern "C" int microhh_advance(Microhh_model* m, int nsteps)
+{
+    return call_safe(m, [&]() { return m->model->advance(nsteps) ? 1 : 0; });
+}
+
+extern "C" int microhh_get_field(Microhh_model* m, const char* name, Microhh_field_view* view)
+{
+    auto& fields = m->model->get_fields();
+    auto& gd = m->model->get_grid().get_grid_data();
+    auto& md = m->master.get_MPI_data();
+
+    auto it = fields.a.find(name);
+    if (it == fields.a.end())
+        return -1;
+
+    auto& fld = *it->second;
+    auto itend = fields.at.find(name);
+
+    #ifdef USECUDA
+    view->data = fld.fld_g.data();
+    view->tend = (itend != fields.at.end()) ? itend->second->fld_g.data() : nullptr;
+    view->on_device = 1;
+    #else
+    view->data = fld.fld.data();
+    view->tend = (itend != fields.at.end()) ? itend->second->fld.data() : nullptr;
+    view->on_device = 0;
+    #endif
+
+    view->itemsize = sizeof(TF_api);
+    view->icells = gd.icells;
+    view->jcells = gd.jcells;
+    view->kcells = gd.kcells;
+    view->istart = gd.istart;
+    view->iend   = gd.iend;
+    view->jstart = gd.jstart;
+    view->jend   = gd.jend;
+    view->kstart = gd.kstart;
+    view->kend   = gd.kend;
+    view->i0 = md.mpicoordx*gd.imax;
+    view->j0 = md.mpicoordy*gd.jmax;
+
+    for (int n=0; n<3; ++n)
+        view->loc[n] = fld.loc[n];
+
+    return 0;
+}
+
+extern "C" double microhh_get_time(Microhh_model* m)
+{
+    return m->model->get_timeloop().get_time();
+}
+
+extern "C" void microhh_set_tendency_callback(Microhh_model* m, void (*callback)(void*), void* user_data)
+{
+    if (callback == nullptr)
+        m->model->set_external_tendency(nullptr);
+    else
+        m->model->set_external_tendency([callback, user_data]() { callback(user_data); });
+}
+
+extern "C" void microhh_destroy(Microhh_model* m)
+{
+    if (m == nullptr)
+        return;
+
+    call_safe(m, [&]() { m->model->finish_exec(); return 0; });
+
+    // The model is freed before the master finalizes MPI.
+    m->model.reset();
+    delete m;
+}
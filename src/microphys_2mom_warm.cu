@@ -62,166 +62,166 @@ namespace micro
         }
     }
 
+    // The warm rain processes below are evaluated per grid point from the same state,
+    // and are therefore all fused in process_rates_g, which loads the state once and
+    // writes each tendency once. The functions return their contributions in place.
+
     // Autoconversion: formation of rain drop by coagulating cloud droplets
-    template<typename TF> __global__
-    void autoconversion_g(TF* const __restrict__ qrt, TF* const __restrict__ nrt,
-                          TF* const __restrict__ qtt, TF* const __restrict__ thlt,
-                          const TF* const __restrict__ qr,  const TF* const __restrict__ ql,
-                          const TF* const __restrict__ rho, const TF* const __restrict__ exner, const TF nc,
-                          const int istart, const int jstart, const int kstart,
-                          const int iend,   const int jend,   const int kend,
-                          const int jj, const int kk)
+    template<typename TF> __device__
+    void autoconversion(TF& qrt, TF& nrt, TF& qtt, TF& thlt,
+                        const TF qr, const TF ql, const TF rho, const TF exner, const TF nc)
     {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
         // BvS with the cpu and cuda implementation, these should really go to the header
         const TF x_star = 2.6e-10;       // SB06, list of symbols, same as UCLA-LES
         const TF k_cc   = 9.44e9;        // UCLA-LES (Long, 1974), 4.44e9 in SB06, p48
         const TF nu_c   = 1;             // SB06, Table 1., same as UCLA-LES
         const TF kccxs  = k_cc / (TF(20.) * x_star) * (nu_c+2)*(nu_c+4) / pow(nu_c+1, TF(2));
 
-        if (i < iend && j < jend && k < kend)
+        if (ql > ql_min<TF>)
         {
-            const int ijk = i + j*jj + k*kk;
-            if (ql[ijk] > ql_min<TF>)
-            {
-                const TF xc      = rho[k] * ql[ijk] / nc;    // Mean mass of cloud drops [kg]
-                const TF tau     = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk] + dsmall);    // SB06, Eq 5
-                const TF phi_au  = TF(600.) * pow(tau, TF(0.68)) * pow(TF(1.) - pow(tau, TF(0.68)), TF(3));    // UCLA-LES
-                //const TF phi_au  = 400. * pow(tau, 0.7) * pow(1. - pow(tau, 0.7), 3);    // SB06, Eq 6
-                const TF au_tend = rho_0<TF> * kccxs * pow(ql[ijk], TF(2)) * pow(xc, TF(2)) *
-                                       (TF(1.) + phi_au / pow(TF(1.)-tau, TF(2))); // SB06, eq 4
-
-                qrt[ijk]  += au_tend;
-                nrt[ijk]  += au_tend * rho[k] / x_star;
-                qtt[ijk]  -= au_tend;
-                thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * au_tend;
-            }
+            const TF xc      = rho * ql / nc;    // Mean mass of cloud drops [kg]
+            const TF tau     = TF(1.) - ql / (ql + qr + dsmall);    // SB06, Eq 5
+            const TF phi_au  = TF(600.) * pow(tau, TF(0.68)) * pow(TF(1.) - pow(tau, TF(0.68)), TF(3));    // UCLA-LES
+            //const TF phi_au  = 400. * pow(tau, 0.7) * pow(1. - pow(tau, 0.7), 3);    // SB06, Eq 6
+            const TF au_tend = rho_0<TF> * kccxs * pow(ql, TF(2)) * pow(xc, TF(2)) *
+                                   (TF(1.) + phi_au / pow(TF(1.)-tau, TF(2))); // SB06, eq 4
+
+            qrt  += au_tend;
+            nrt  += au_tend * rho / x_star;
+            qtt  -= au_tend;
+            thlt += Lv<TF> / (cp<TF> * exner) * au_tend;
         }
     }
 
     // Accreation: growth of raindrops collecting cloud droplets
-    template<typename TF> __global__
-    void accretion_g(TF* const __restrict__ qrt, TF* const __restrict__ qtt, TF* const __restrict__ thlt,
-                     const TF* const __restrict__ qr,  const TF* const __restrict__ ql,
-                     const TF* const __restrict__ rho, const TF* const __restrict__ exner,
-                     const int istart, const int jstart, const int kstart,
-                     const int iend,   const int jend,   const int kend,
-                     const int jj, const int kk)
+    template<typename TF> __device__
+    void accretion(TF& qrt, TF& qtt, TF& thlt,
+                   const TF qr, const TF ql, const TF rho, const TF exner)
     {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
         const TF k_cr  = 5.25; // SB06, p49
 
-        if (i < iend && j < jend && k < kend)
+        if (ql > ql_min<TF> && qr > qr_min<TF>)
         {
-            const int ijk = i + j*jj + k*kk;
-            if (ql[ijk] > ql_min<TF> && qr[ijk] > qr_min<TF>)
-            {
-                const TF tau     = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk]); // SB06, Eq 5
-                const TF phi_ac  = pow(tau / (tau + TF(5e-5)), TF(4)); // SB06, Eq 8
-                const TF ac_tend = k_cr * ql[ijk] *  qr[ijk] * phi_ac * pow(rho_0<TF> / rho[k], TF(0.5)); // SB06, Eq 7
+            const TF tau     = TF(1.) - ql / (ql + qr); // SB06, Eq 5
+            const TF phi_ac  = pow(tau / (tau + TF(5e-5)), TF(4)); // SB06, Eq 8
+            const TF ac_tend = k_cr * ql *  qr * phi_ac * pow(rho_0<TF> / rho, TF(0.5)); // SB06, Eq 7
 
-                qrt[ijk]  += ac_tend;
-                qtt[ijk]  -= ac_tend;
-                thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * ac_tend;
-            }
+            qrt  += ac_tend;
+            qtt  -= ac_tend;
+            thlt += Lv<TF> / (cp<TF> * exner) * ac_tend;
         }
     }
 
     // Evaporation: evaporation of rain drops in unsaturated environment
-    template<typename TF> __global__
-    void evaporation_g(TF* const restrict qrt, TF* const restrict nrt,
-                       TF* const restrict qtt, TF* const restrict thlt,
-                       const TF* const restrict qr, const TF* const restrict nr,
-                       const TF* const restrict ql, const TF* const restrict qt, const TF* const restrict thl,
-                       const TF* const restrict rho, const TF* const restrict exner, const TF* const restrict p,
-                       const int istart, const int jstart, const int kstart,
-                       const int iend,   const int jend,   const int kend,
-                       const int jj, const int kk)
+    template<typename TF> __device__
+    void evaporation(TF& qrt, TF& nrt, TF& qtt, TF& thlt,
+                     const TF nr, const TF ql, const TF qt, const TF thl,
+                     const TF rho, const TF exner, const TF p, const TF mr, const TF dr)
     {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
         const TF lambda_evap = 1.; // 1.0 in UCLA, 0.7 in DALES
 
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj + k*kk;
-            if (qr[ijk] > qr_min<TF>)
-            {
-                const TF mr = calc_rain_mass(qr[ijk], nr[ijk], rho[k]);
-                const TF dr = calc_rain_diameter(mr);
-
-                const TF T   = thl[ijk] * exner[k] + (Lv<TF> * ql[ijk]) / (cp<TF> * exner[k]); // Absolute temperature [K]
-                const TF Glv = pow(Rv<TF> * T / (esat_liq(T) * D_v<TF>) +
-                                   (Lv<TF> / (K_t<TF> * T)) * (Lv<TF> / (Rv<TF> * T) - TF(1)), TF(-1)); // Cond/evap rate (kg m-1 s-1)?
+        const TF T   = thl * exner + (Lv<TF> * ql) / (cp<TF> * exner); // Absolute temperature [K]
+        const TF Glv = pow(Rv<TF> * T / (esat_liq(T) * D_v<TF>) +
+                           (Lv<TF> / (K_t<TF> * T)) * (Lv<TF> / (Rv<TF> * T) - TF(1)), TF(-1)); // Cond/evap rate (kg m-1 s-1)?
 
-                const TF S   = (qt[ijk] - ql[ijk]) / qsat_liq(p[k], T) - TF(1); // Saturation
-                const TF F   = TF(1.); // Evaporation excludes ventilation term from SB06 (like UCLA, unimportant term? TODO: test)
+        const TF S   = (qt - ql) / qsat_liq(p, T) - TF(1); // Saturation
+        const TF F   = TF(1.); // Evaporation excludes ventilation term from SB06 (like UCLA, unimportant term? TODO: test)
 
-                const TF ev_tend = TF(2.) * pi<TF> * dr * Glv * S * F * nr[ijk] / rho[k];
+        const TF ev_tend = TF(2.) * pi<TF> * dr * Glv * S * F * nr / rho;
 
-                qrt[ijk]  += ev_tend;
-                nrt[ijk]  += lambda_evap * ev_tend * rho[k] / mr;
-                qtt[ijk]  -= ev_tend;
-                thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * ev_tend;
-            }
-        }
+        qrt  += ev_tend;
+        nrt  += lambda_evap * ev_tend * rho / mr;
+        qtt  -= ev_tend;
+        thlt += Lv<TF> / (cp<TF> * exner) * ev_tend;
     }
 
     // Selfcollection & breakup: growth of raindrops by mutual (rain-rain) coagulation, and breakup by collisions
-    template<typename TF> __global__
-    void selfcollection_breakup_g(TF* const __restrict__ nrt, const TF* const __restrict__ qr, const TF* const __restrict__ nr, const TF* const __restrict__ rho,
-                                  const int istart, const int jstart, const int kstart,
-                                  const int iend,   const int jend,   const int kend,
-                                  const int jj, const int kk)
+    template<typename TF> __device__
+    void selfcollection_breakup(TF& nrt, const TF qr, const TF nr, const TF rho, const TF dr)
     {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
         const TF k_rr     = 7.12;   // SB06, p49
         const TF kappa_rr = 60.7;   // SB06, p49
         const TF D_eq     = 0.9e-3; // SB06, list of symbols
         const TF k_br1    = 1.0e3;  // SB06, p50, for 0.35e-3 <= Dr <= D_eq
         const TF k_br2    = 2.3e3;  // SB06, p50, for Dr > D_eq
 
+        const TF mu_r    = calc_mu_r(dr);
+        const TF lambdar = calc_lambda_r(mu_r, dr);
+
+        // Selfcollection
+        const TF sc_tend = -k_rr * nr * qr*rho * pow(TF(1.) + kappa_rr /
+                           lambdar * pow(pirhow<TF>, TF(1.)/TF(3.)), TF(-9)) * pow(rho_0<TF> / rho, TF(0.5));
+        nrt += sc_tend;
+
+        // Breakup
+        const TF dDr = dr - D_eq;
+        if(dr > 0.35e-3)
+        {
+            TF phi_br;
+            if(dr <= D_eq)
+                phi_br = k_br1 * dDr;
+            else
+                phi_br = TF(2.) * exp(k_br2 * dDr) - TF(1.);
+
+            const TF br_tend = -(phi_br + TF(1.)) * sc_tend;
+            nrt += br_tend;
+        }
+    }
+
+    // Autoconversion, accretion, evaporation and selfcollection & breakup in one pass.
+    // The mean rain drop mass and diameter are shared by evaporation and selfcollection.
+    template<typename TF> __global__
+    void process_rates_g(TF* const __restrict__ qrt, TF* const __restrict__ nrt,
+                         TF* const __restrict__ qtt, TF* const __restrict__ thlt,
+                         const TF* const __restrict__ qr, const TF* const __restrict__ nr,
+                         const TF* const __restrict__ ql, const TF* const __restrict__ qt, const TF* const __restrict__ thl,
+                         const TF* const __restrict__ rho, const TF* const __restrict__ exner, const TF* const __restrict__ p,
+                         const TF nc,
+                         const int istart, const int jstart, const int kstart,
+                         const int iend,   const int jend,   const int kend,
+                         const int jj, const int kk)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
+        const int k = blockIdx.z + kstart;
+
         if (i < iend && j < jend && k < kend)
         {
             const int ijk = i + j*jj + k*kk;
-            if (qr[ijk] > qr_min<TF>)
+
+            const TF qr_l = qr[ijk];
+            const TF ql_l = ql[ijk];
+
+            // Skip the tendency loads and stores in cloud and rain free air.
+            if (ql_l <= ql_min<TF> && qr_l <= qr_min<TF>)
+                return;
+
+            const TF rho_l   = rho[k];
+            const TF exner_l = exner[k];
+
+            TF qrt_l  = TF(0.);
+            TF nrt_l  = TF(0.);
+            TF qtt_l  = TF(0.);
+            TF thlt_l = TF(0.);
+
+            autoconversion(qrt_l, nrt_l, qtt_l, thlt_l, qr_l, ql_l, rho_l, exner_l, nc);
+            accretion(qrt_l, qtt_l, thlt_l, qr_l, ql_l, rho_l, exner_l);
+
+            if (qr_l > qr_min<TF>)
             {
-                // Calculate mean rain drop mass and diameter
-                const TF mr      = calc_rain_mass(qr[ijk], nr[ijk], rho[k]);
-                const TF dr      = calc_rain_diameter(mr);
-                const TF mu_r    = calc_mu_r(dr);
-                const TF lambdar = calc_lambda_r(mu_r, dr);
+                const TF nr_l = nr[ijk];
+                const TF mr   = calc_rain_mass(qr_l, nr_l, rho_l);
+                const TF dr   = calc_rain_diameter(mr);
 
-                // Selfcollection
-                const TF sc_tend = -k_rr * nr[ijk] * qr[ijk]*rho[k] * pow(TF(1.) + kappa_rr /
-                                   lambdar * pow(pirhow<TF>, TF(1.)/TF(3.)), TF(-9)) * pow(rho_0<TF> / rho[k], TF(0.5));
-                nrt[ijk] += sc_tend;
-
-                // Breakup
-                const TF dDr = dr - D_eq;
-                if(dr > 0.35e-3)
-                {
-                    TF phi_br;
-                    if(dr <= D_eq)
-                        phi_br = k_br1 * dDr;
-                    else
-                        phi_br = TF(2.) * exp(k_br2 * dDr) - TF(1.);
-
-                    const TF br_tend = -(phi_br + TF(1.)) * sc_tend;
-                    nrt[ijk] += br_tend;
-                }
+                evaporation(qrt_l, nrt_l, qtt_l, thlt_l,
+                            nr_l, ql_l, qt[ijk], thl[ijk], rho_l, exner_l, p[k], mr, dr);
+                selfcollection_breakup(nrt_l, qr_l, nr_l, rho_l, dr);
             }
+
+            qrt [ijk] += qrt_l;
+            nrt [ijk] += nrt_l;
+            qtt [ijk] += qtt_l;
+            thlt[ijk] += thlt_l;
         }
     }
 }
@@ -371,30 +371,11 @@ void Microphys_2mom_warm<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF
     // Calculate microphysics tendencies
     // ---------------------------------
 
-    // Autoconversion; formation of rain drop by coagulating cloud droplets
-    micro::autoconversion_g<TF><<<gridGPU, blockGPU>>>(
-        fields.st.at("qr")->fld_g, fields.st.at("nr")->fld_g,
-        fields.st.at("qt")->fld_g, fields.st.at("thl")->fld_g,
-        fields.sp.at("qr")->fld_g, ql->fld_g, fields.rhoref_g, exner, Nc0,
-        gd.istart, gd.jstart, gd.kstart,
-        gd.iend,   gd.jend,   gd.kend,
-        gd.icells, gd.ijcells);
-    cuda_check_error();
-
-    // Accretion; growth of raindrops collecting cloud droplets
-    micro::accretion_g<TF><<<gridGPU, blockGPU>>>(
-        fields.st.at("qr")->fld_g, fields.st.at("qt")->fld_g, fields.st.at("thl")->fld_g,
-        fields.sp.at("qr")->fld_g, ql->fld_g, fields.rhoref_g, exner,
-        gd.istart, gd.jstart, gd.kstart,
-        gd.iend,   gd.jend,   gd.kend,
-        gd.icells, gd.ijcells);
-    cuda_check_error();
-
-    // Evaporation; evaporation of rain drops in unsaturated environment
-    micro::evaporation_g<TF><<<gridGPU, blockGPU>>>(
+    // Autoconversion, accretion, evaporation, and selfcollection and breakup in a single pass
+    micro::process_rates_g<TF><<<gridGPU, blockGPU>>>(
         fields.st.at("qr")->fld_g, fields.st.at("nr")->fld_g,  fields.st.at("qt")->fld_g, fields.st.at("thl")->fld_g,
         fields.sp.at("qr")->fld_g, fields.sp.at("nr")->fld_g,  ql->fld_g,
-        fields.sp.at("qt")->fld_g, fields.sp.at("thl")->fld_g, fields.rhoref_g, exner, p,
+        fields.sp.at("qt")->fld_g, fields.sp.at("thl")->fld_g, fields.rhoref_g, exner, p, Nc0,
         gd.istart, gd.jstart, gd.kstart,
         gd.iend,   gd.jend,   gd.kend,
         gd.icells, gd.ijcells);
@@ -402,14 +383,6 @@ void Microphys_2mom_warm<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF
 
     fields.release_tmp_g(ql);
 
-    // Self collection and breakup; growth of raindrops by mutual (rain-rain) coagulation, and breakup by collisions
-    micro::selfcollection_breakup_g<TF><<<gridGPU, blockGPU>>>(
-        fields.st.at("nr")->fld_g, fields.sp.at("qr")->fld_g, fields.sp.at("nr")->fld_g, fields.rhoref_g,
-        gd.istart, gd.jstart, gd.kstart,
-        gd.iend,   gd.jend,   gd.kend,
-        gd.icells, gd.ijcells);
-    cuda_check_error();
-
     // Sedimentation; sub-grid sedimentation of rain
     // ---------------------------------------------
     // 1. Calculate sedimentation velocity of qr and nr
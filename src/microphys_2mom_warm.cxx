@@ -24,6 +24,7 @@
 #include <cstdio>
 #include <cmath>
 #include <algorithm>
+#include <utility>
 
 #include "master.h"
 #include "grid.h"
@@ -83,6 +84,35 @@ namespace
         return &(tmp_fields[tmp_index]->fld[slice_start]);
     }
 
+    // Per XZ slice, the range of levels [first, second) in which q exceeds q_min.
+    // The range is empty (first == second) if the slice does not contain q.
+    template<typename TF>
+    void calc_active_levels(std::vector<std::pair<int, int>>& levels,
+                            const TF* const restrict q, const TF q_min,
+                            const int istart, const int jstart, const int kstart,
+                            const int iend,   const int jend,   const int kend,
+                            const int jj,     const int kk)
+    {
+        for (int j=jstart; j<jend; j++)
+        {
+            int kbot = kend;
+            int ktop = kstart;
+
+            for (int k=kstart; k<kend; k++)
+                for (int i=istart; i<iend; i++)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    if (q[ijk] > q_min)
+                    {
+                        kbot = std::min(kbot, k);
+                        ktop = k+1;
+                        break;
+                    }
+                }
+
+            levels[j] = std::make_pair(kbot, std::max(kbot, ktop));
+        }
+    }
 }
 
 // Microphysics calculated over entire 3D field
@@ -115,7 +145,7 @@ namespace mp3d
                     {
                         const TF xc      = rho[k] * ql[ijk] / nc;    // Mean mass of cloud drops [kg]
                         const TF tau     = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk] + dsmall);    // SB06, Eq 5
-                        const TF phi_au  = TF(600.) * pow(tau, TF(0.68)) * fm::pow3(TF(1.) - pow(tau, TF(0.68)));    // UCLA-LES
+                        const TF phi_au  = TF(600.) * fm::pow<fm::sw_microphys>(tau, TF(0.68)) * fm::pow3(TF(1.) - fm::pow<fm::sw_microphys>(tau, TF(0.68)));    // UCLA-LES
                         const TF au_tend = rho_0<TF> * kccxs * fm::pow2(ql[ijk]) * fm::pow2(xc) *
                                                (TF(1.) + phi_au / fm::pow2(TF(1.)-tau)); // SB06, eq 4
 
@@ -190,7 +220,7 @@ namespace mp3d
                         const TF mur     = calc_mu_r(dr);
                         const TF lambdar = calc_lambda_r(mur, dr);
 
-                        w_qr[ijk] = std::min(w_max, std::max(TF(0.1), a_R - b_R * TF(pow(TF(1.) + c_R/lambdar, TF(-1.)*(mur+TF(4.))))));
+                        w_qr[ijk] = std::min(w_max, std::max(TF(0.1), a_R - b_R * TF(fm::pow<fm::sw_microphys>(TF(1.) + c_R/lambdar, TF(-1.)*(mur+TF(4.))))));
                     }
                     else
                     {
@@ -360,7 +390,7 @@ namespace mp2d
                         if (dr <= D_eq)
                             phi_br = k_br1 * dDr;
                         else
-                            phi_br = TF(2.) * exp(k_br2 * dDr) - TF(1.);
+                            phi_br = TF(2.) * fm::exp<fm::sw_microphys>(k_br2 * dDr) - TF(1.);
 
                         const TF br_tend = -(phi_br + TF(1.)) * sc_tend;
                         nrt[ijk] += br_tend;
@@ -407,8 +437,8 @@ namespace mp2d
                 if (qr[ijk] > qr_min<TF>)
                 {
                     // SS08:
-                    w_qr[ik] = std::min(w_max, std::max(TF(0.1), rho_n * a_R - b_R * TF(pow(TF(1.) + c_R/lambda_r[ik], TF(-1.)*(mu_r[ik]+TF(4.))))));
-                    w_nr[ik] = std::min(w_max, std::max(TF(0.1), rho_n * a_R - b_R * TF(pow(TF(1.) + c_R/lambda_r[ik], TF(-1.)*(mu_r[ik]+TF(1.))))));
+                    w_qr[ik] = std::min(w_max, std::max(TF(0.1), rho_n * a_R - b_R * TF(fm::pow<fm::sw_microphys>(TF(1.) + c_R/lambda_r[ik], TF(-1.)*(mu_r[ik]+TF(4.))))));
+                    w_nr[ik] = std::min(w_max, std::max(TF(0.1), rho_n * a_R - b_R * TF(fm::pow<fm::sw_microphys>(TF(1.) + c_R/lambda_r[ik], TF(-1.)*(mu_r[ik]+TF(1.))))));
                 }
                 else
                 {
@@ -549,6 +579,14 @@ Microphys_2mom_warm<TF>::Microphys_2mom_warm(Master& masterin, Grid<TF>& gridin,
     // Read microphysics switches and settings
     swmicrobudget = inputin.get_item<bool>("micro", "swmicrobudget", "", false);
     cflmax = inputin.get_item<TF>("micro", "cflmax", "", 2.);
+
+    // Sub-cycle the sedimentation, such that it does not limit the time step of the model.
+    swsedimentsubcycle = inputin.get_item<bool>("micro", "swsedimentsubcycle", "", false);
+
+    #ifdef USECUDA
+    if (swsedimentsubcycle)
+        throw std::runtime_error("swsedimentsubcycle is not implemented on the GPU");
+    #endif
     Nc0 = inputin.get_item<TF>("micro", "Nc0", "");
 
     // Initialize the qr (rain water specific humidity) and nr (droplot number concentration) fields
@@ -635,6 +673,90 @@ void Microphys_2mom_warm<TF>::create(
 }
 
 #ifndef USECUDA
+template<typename TF>
+void Microphys_2mom_warm<TF>::sedimentation_subcycled(
+        std::vector<std::shared_ptr<Field3d<TF>>>& sub_fields, std::vector<TF>& rr_bot_sub,
+        TF* const w_qr, TF* const w_nr, TF* const c_qr, TF* const c_nr,
+        TF* const slope_qr, TF* const slope_nr, TF* const flux_qr, TF* const flux_nr,
+        TF* const rain_mass, TF* const rain_diam, TF* const mu_r, TF* const lambda_r,
+        const double dt, const int nsubstep, const int j)
+{
+    auto& gd = grid.get_grid_data();
+
+    const TF* const qr = fields.sp.at("qr")->fld.data();
+    const TF* const nr = fields.sp.at("nr")->fld.data();
+    TF* const qrt = fields.st.at("qr")->fld.data();
+    TF* const nrt = fields.st.at("nr")->fld.data();
+
+    TF* const qr_sub  = sub_fields[0]->fld.data();
+    TF* const nr_sub  = sub_fields[1]->fld.data();
+    TF* const qrt_sub = sub_fields[2]->fld.data();
+    TF* const nrt_sub = sub_fields[3]->fld.data();
+
+    const TF dt_sub = dt / nsubstep;
+
+    // Copy the slice including the ghost cells that the slopes need.
+    for (int k=gd.kstart-1; k<gd.kend+1; ++k)
+        for (int i=gd.istart; i<gd.iend; ++i)
+        {
+            const int ijk = i + j*gd.icells + k*gd.ijcells;
+            qr_sub[ijk] = qr[ijk];
+            nr_sub[ijk] = nr[ijk];
+        }
+
+    for (int i=gd.istart; i<gd.iend; ++i)
+        rr_bot[i + j*gd.icells] = TF(0.);
+
+    for (int n=0; n<nsubstep; ++n)
+    {
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*gd.icells + k*gd.ijcells;
+                qrt_sub[ijk] = TF(0.);
+                nrt_sub[ijk] = TF(0.);
+            }
+
+        mp2d::prepare_microphysics_slice(rain_mass, rain_diam, mu_r, lambda_r,
+                                         qr_sub, nr_sub, fields.rhoref.data(),
+                                         gd.istart, gd.iend, gd.kstart, gd.kend, gd.icells, gd.ijcells, j);
+
+        mp2d::sedimentation_ss08(qrt_sub, nrt_sub, rr_bot_sub.data(),
+                                 w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
+                                 qr_sub, nr_sub,
+                                 fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt_sub,
+                                 gd.istart, gd.jstart, gd.kstart,
+                                 gd.iend,   gd.jend,   gd.kend,
+                                 gd.icells, gd.kcells, gd.ijcells, j);
+
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            #pragma ivdep
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*gd.icells + k*gd.ijcells;
+                qr_sub[ijk] += dt_sub*qrt_sub[ijk];
+                nr_sub[ijk] += dt_sub*nrt_sub[ijk];
+            }
+
+        // The surface rain rate is the mean over the sub-cycles.
+        for (int i=gd.istart; i<gd.iend; ++i)
+        {
+            const int ij = i + j*gd.icells;
+            rr_bot[ij] += rr_bot_sub[ij] / nsubstep;
+        }
+    }
+
+    // Add the mean tendency over the full time step.
+    for (int k=gd.kstart; k<gd.kend; ++k)
+        #pragma ivdep
+        for (int i=gd.istart; i<gd.iend; ++i)
+        {
+            const int ijk = i + j*gd.icells + k*gd.ijcells;
+            qrt[ijk] += (qr_sub[ijk] - qr[ijk]) / dt;
+            nrt[ijk] += (nr_sub[ijk] - nr[ijk]) / dt;
+        }
+}
+
 template<typename TF>
 void Microphys_2mom_warm<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& stats)
 {
@@ -687,6 +809,51 @@ void Microphys_2mom_warm<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF
     TF* lambda_r = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
     TF* mu_r     = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
 
+    // With sub-cycling, the sedimentation advances a copy of qr and nr in steps that keep the
+    // sedimentation CFL number of this process below cflmax.
+    int nsubstep = 1;
+    std::vector<std::shared_ptr<Field3d<TF>>> sub_fields;
+    std::vector<TF> rr_bot_sub;
+
+    if (swsedimentsubcycle)
+    {
+        for (int n=0; n<4; ++n)
+            sub_fields.push_back(fields.get_tmp());
+
+        const TF cfl = mp3d::calc_max_sedimentation_cfl(
+                sub_fields[0]->fld.data(), fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),
+                fields.rhoref.data(), gd.dzi.data(), dt,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend,   gd.jend,   gd.kend,
+                gd.icells, gd.ijcells);
+
+        nsubstep = std::max(1, static_cast<int>(std::ceil(cfl / cflmax)));
+        rr_bot_sub.resize(gd.ijcells);
+    }
+
+    // The process rates are zero outside the cloud and rain, which in shallow cumulus cover only
+    // a small fraction of the domain. The levels that contain them are listed once per time step.
+    std::vector<std::pair<int, int>> cloud_levels(gd.jcells);
+    std::vector<std::pair<int, int>> rain_levels(gd.jcells);
+
+    calc_active_levels(cloud_levels, ql->fld.data(), ql_min<TF>,
+                       gd.istart, gd.jstart, gd.kstart,
+                       gd.iend,   gd.jend,   gd.kend,
+                       gd.icells, gd.ijcells);
+    calc_active_levels(rain_levels, fields.sp.at("qr")->fld.data(), qr_min<TF>,
+                       gd.istart, gd.jstart, gd.kstart,
+                       gd.iend,   gd.jend,   gd.kend,
+                       gd.icells, gd.ijcells);
+
+    int kstart_cloud = gd.kend;
+    int kend_cloud   = gd.kstart;
+    for (int j=gd.jstart; j<gd.jend; ++j)
+        if (cloud_levels[j].first < cloud_levels[j].second)
+        {
+            kstart_cloud = std::min(kstart_cloud, cloud_levels[j].first);
+            kend_cloud   = std::max(kend_cloud,   cloud_levels[j].second);
+        }
+
     // ---------------------------------
     // Calculate microphysics tendencies
     // ---------------------------------
@@ -694,51 +861,73 @@ void Microphys_2mom_warm<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF
     // Autoconversion; formation of rain drop by coagulating cloud droplets
     mp3d::autoconversion(fields.st.at("qr")->fld.data(), fields.st.at("nr")->fld.data(), fields.st.at("qt")->fld.data(), fields.st.at("thl")->fld.data(),
                          fields.sp.at("qr")->fld.data(), ql->fld.data(), fields.rhoref.data(), exner.data(), Nc0,
-                         gd.istart, gd.jstart, gd.kstart,
-                         gd.iend,   gd.jend,   gd.kend,
+                         gd.istart, gd.jstart, kstart_cloud,
+                         gd.iend,   gd.jend,   kend_cloud,
                          gd.icells, gd.ijcells);
 
     // Accretion; growth of raindrops collecting cloud droplets
     mp3d::accretion(fields.st.at("qr")->fld.data(), fields.st.at("qt")->fld.data(), fields.st.at("thl")->fld.data(),
                     fields.sp.at("qr")->fld.data(), ql->fld.data(), fields.rhoref.data(), exner.data(),
-                    gd.istart, gd.jstart, gd.kstart,
-                    gd.iend,   gd.jend,   gd.kend,
+                    gd.istart, gd.jstart, kstart_cloud,
+                    gd.iend,   gd.jend,   kend_cloud,
                     gd.icells, gd.ijcells);
 
     // Rest of the microphysics is handled per XZ slice
     for (int j=gd.jstart; j<gd.jend; ++j)
     {
+        const int kstart_rain = rain_levels[j].first;
+        const int kend_rain   = rain_levels[j].second;
+
+        // Without rain, the fall velocity and thus the sedimentation flux are zero as well.
+        if (kstart_rain == kend_rain)
+        {
+            for (int i=gd.istart; i<gd.iend; ++i)
+                rr_bot[i + j*gd.icells] = TF(0.);
+            continue;
+        }
+
         // Prepare the XZ slices which are used in all routines
         mp2d::prepare_microphysics_slice(rain_mass, rain_diam, mu_r, lambda_r,
                                          fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(), fields.rhoref.data(),
-                                         gd.istart, gd.iend, gd.kstart, gd.kend, gd.icells, gd.ijcells, j);
+                                         gd.istart, gd.iend, kstart_rain, kend_rain, gd.icells, gd.ijcells, j);
 
         // Evaporation; evaporation of rain drops in unsaturated environment
         mp2d::evaporation(fields.st.at("qr")->fld.data(), fields.st.at("nr")->fld.data(),  fields.st.at("qt")->fld.data(), fields.st.at("thl")->fld.data(),
                           fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),  ql->fld.data(),
                           fields.sp.at("qt")->fld.data(), fields.sp.at("thl")->fld.data(), fields.rhoref.data(), exner.data(), p.data(),
                           rain_mass, rain_diam,
-                          gd.istart, gd.jstart, gd.kstart,
-                          gd.iend,   gd.jend,   gd.kend,
+                          gd.istart, gd.jstart, kstart_rain,
+                          gd.iend,   gd.jend,   kend_rain,
                           gd.icells, gd.ijcells, j);
 
         // Self collection and breakup; growth of raindrops by mutual (rain-rain) coagulation, and breakup by collisions
         mp2d::selfcollection_breakup(fields.st.at("nr")->fld.data(), fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(), fields.rhoref.data(),
                                      rain_mass, rain_diam, lambda_r,
-                                     gd.istart, gd.jstart, gd.kstart,
-                                     gd.iend,   gd.jend,   gd.kend,
+                                     gd.istart, gd.jstart, kstart_rain,
+                                     gd.iend,   gd.jend,   kend_rain,
                                      gd.icells, gd.ijcells, j);
 
-        // Sedimentation; sub-grid sedimentation of rain
-        mp2d::sedimentation_ss08(fields.st.at("qr")->fld.data(), fields.st.at("nr")->fld.data(), rr_bot.data(),
-                                 w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
-                                 fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),
-                                 fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt,
-                                 gd.istart, gd.jstart, gd.kstart,
-                                 gd.iend,   gd.jend,   gd.kend,
-                                 gd.icells, gd.kcells, gd.ijcells, j);
+        // Sedimentation; sub-grid sedimentation of rain. The rain falls out of its levels during
+        // the time step, such that the sedimentation covers the full column. It only reads the
+        // prepared slices where qr exceeds qr_min, which all lie within the rain levels.
+        if (!swsedimentsubcycle)
+            mp2d::sedimentation_ss08(fields.st.at("qr")->fld.data(), fields.st.at("nr")->fld.data(), rr_bot.data(),
+                                     w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
+                                     fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),
+                                     fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt,
+                                     gd.istart, gd.jstart, gd.kstart,
+                                     gd.iend,   gd.jend,   gd.kend,
+                                     gd.icells, gd.kcells, gd.ijcells, j);
+        else
+            sedimentation_subcycled(
+                    sub_fields, rr_bot_sub,
+                    w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr,
+                    rain_mass, rain_diam, mu_r, lambda_r, dt, nsubstep, j);
     }
 
+    for (auto& it: sub_fields)
+        fields.release_tmp(it);
+
     // Release all local tmp fields in use
     for (auto& it: tmp_fields)
         fields.release_tmp(it);
@@ -962,8 +1151,11 @@ void Microphys_2mom_warm<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
 
 #ifndef USECUDA
 template<typename TF>
-unsigned long Microphys_2mom_warm<TF>::get_time_limit(unsigned long idt, const double dt)
+double Microphys_2mom_warm<TF>::get_sedimentation_cfl_local(const double dt)
 {
+    if (swsedimentsubcycle)
+        return 0.;
+
     auto& gd = grid.get_grid_data();
 
     // Calculate the maximum sedimentation CFL number
@@ -975,9 +1167,28 @@ unsigned long Microphys_2mom_warm<TF>::get_time_limit(unsigned long idt, const d
                                               gd.icells, gd.ijcells);
     fields.release_tmp(w_qr);
 
+    return cfl;
+}
+
+template<typename TF>
+unsigned long Microphys_2mom_warm<TF>::get_time_limit(unsigned long idt, const double dt)
+{
+    if (swsedimentsubcycle)
+        return Constants::ulhuge;
+
     // Get maximum CFL across all MPI tasks
+    double cfl = get_sedimentation_cfl_local(dt);
     master.max(&cfl, 1);
 
+    return get_time_limit_from_cfl(idt, dt, cfl);
+}
+
+template<typename TF>
+unsigned long Microphys_2mom_warm<TF>::get_time_limit_from_cfl(unsigned long idt, const double dt, const double cfl)
+{
+    if (swsedimentsubcycle)
+        return Constants::ulhuge;
+
     return idt * cflmax / cfl;
 }
 #endif
@@ -155,7 +155,8 @@ namespace
             const TF Nc0, const TF dt,
             const int istart, const int jstart, const int kstart,
             const int iend, const int jend, const int kend,
-            const int jj, const int kk, TF* const __restrict__ temp_array)
+            const int jj, const int kk, TF* const __restrict__ temp_array,
+            int* const __restrict__ species_present)
     {
         // Tomita Eq. 51. Nc0 is converted from SI units (m-3 instead of cm-3).
         const TF D_d = TF(0.146) - TF(5.964e-2)* log((Nc0*TF(1.e-6)) / TF(2.e3));
@@ -163,55 +164,11 @@ namespace
         const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
         //const int k = blockIdx.z + kstart;
 
+        // Bit 0, 1 and 2 flag rain, snow and graupel anywhere in the column.
+        int column_species = 0;
+
         for (int k=kstart; k<kend; ++k)
         {
-            const TF rho0_rho_sqrt = pow(rho[kstart]/rho[k], TF(0.5));
-            // Setup the relevant variables for each z slice
-
-            // Part of Tomita Eq. 29
-            const TF fac_iacr =
-            pi_2<TF> * E_ri<TF> * N_0r<TF> * c_r<TF> * rho_w<TF> * tgamma(TF(6.) + d_r<TF>)
-            / (TF(24.) * M_i<TF>)
-            * rho0_rho_sqrt;
-
-            // Part of Tomita Eq. 32
-            const TF fac_raci =
-            pi<TF> * E_ri<TF> * N_0r<TF> * c_r<TF> * tgamma(TF(3.) + d_r<TF>)
-            / TF(4.)
-            * rho0_rho_sqrt;
-
-            // Part of Tomita Eq. 34
-            const TF fac_racw =
-            pi<TF> * E_rw<TF> * N_0r<TF> * c_r<TF> * tgamma(TF(3.) + d_r<TF>)
-            / TF(4.)
-            * rho0_rho_sqrt;
-
-            // Part of Tomita Eq. 35
-            const TF fac_sacw =
-            pi<TF> * E_sw<TF> * N_0s<TF> * c_s<TF> * tgamma(TF(3.) + d_s<TF>)
-            / TF(4.)
-            * rho0_rho_sqrt;
-
-            // Part of Tomita Eq. 36 (E_si is temperature dependent and missing therefore here).
-            const TF fac_saci =
-            pi<TF> * N_0s<TF> * c_s<TF> * tgamma(TF(3.) + d_s<TF>)
-            / TF(4.)
-            * rho0_rho_sqrt;
-
-            // Part of Tomita Eq. 37
-            const TF fac_gacw =
-            pi<TF> * E_gw<TF> * N_0g<TF> * c_g<TF> * tgamma(TF(3.) + d_g<TF>)
-            / TF(4.)
-            * rho0_rho_sqrt;
-
-            // Part of Tomita Eq. 38
-            const TF fac_gaci =
-            pi<TF> * E_gi<TF> * N_0g<TF> * c_g<TF> * tgamma(TF(3.) + d_g<TF>)
-            / TF(4.)
-            * rho0_rho_sqrt;
-
-            // end z slice var setup
-
             if (i < iend && j < jend)
             {
                 const int ijk = i + j*jj + k*kk;
@@ -232,9 +189,57 @@ namespace
                 const bool has_snow    = (qs[ijk] > qs_min<TF>);
                 const bool has_graupel = (qg[ijk] > qg_min<TF>);
 
+                // Flag the precipitating species of the column before the cloud-free cells are skipped.
+                column_species |= int(has_rain) | (int(has_snow) << 1) | (int(has_graupel) << 2);
+
                 if (! (has_liq || has_ice || has_rain || has_snow || has_graupel) )
                     continue;
 
+                // The collection factors are only needed in cells with condensate.
+                const TF rho0_rho_sqrt = pow(rho[kstart]/rho[k], TF(0.5));
+
+                // Part of Tomita Eq. 29
+                const TF fac_iacr =
+                pi_2<TF> * E_ri<TF> * N_0r<TF> * c_r<TF> * rho_w<TF> * tgamma(TF(6.) + d_r<TF>)
+                / (TF(24.) * M_i<TF>)
+                * rho0_rho_sqrt;
+
+                // Part of Tomita Eq. 32
+                const TF fac_raci =
+                pi<TF> * E_ri<TF> * N_0r<TF> * c_r<TF> * tgamma(TF(3.) + d_r<TF>)
+                / TF(4.)
+                * rho0_rho_sqrt;
+
+                // Part of Tomita Eq. 34
+                const TF fac_racw =
+                pi<TF> * E_rw<TF> * N_0r<TF> * c_r<TF> * tgamma(TF(3.) + d_r<TF>)
+                / TF(4.)
+                * rho0_rho_sqrt;
+
+                // Part of Tomita Eq. 35
+                const TF fac_sacw =
+                pi<TF> * E_sw<TF> * N_0s<TF> * c_s<TF> * tgamma(TF(3.) + d_s<TF>)
+                / TF(4.)
+                * rho0_rho_sqrt;
+
+                // Part of Tomita Eq. 36 (E_si is temperature dependent and missing therefore here).
+                const TF fac_saci =
+                pi<TF> * N_0s<TF> * c_s<TF> * tgamma(TF(3.) + d_s<TF>)
+                / TF(4.)
+                * rho0_rho_sqrt;
+
+                // Part of Tomita Eq. 37
+                const TF fac_gacw =
+                pi<TF> * E_gw<TF> * N_0g<TF> * c_g<TF> * tgamma(TF(3.) + d_g<TF>)
+                / TF(4.)
+                * rho0_rho_sqrt;
+
+                // Part of Tomita Eq. 38
+                const TF fac_gaci =
+                pi<TF> * E_gi<TF> * N_0g<TF> * c_g<TF> * tgamma(TF(3.) + d_g<TF>)
+                / TF(4.)
+                * rho0_rho_sqrt;
+
                 // Tomita Eq. 27
                 const TF lambda_r = pow(
                         a_r<TF> * N_0r<TF> * tgamma(b_r<TF> + TF(1.))
@@ -652,6 +657,9 @@ namespace
                 thlt[ijk] -= Ls<TF> / (cp<TF> * exner[k]) * graupel_to_vapor;
             }
         } // end for loop over k
+
+        if (column_species != 0)
+            atomicOr(species_present, column_species);
     } // end conversion function
 }
 
@@ -749,6 +757,8 @@ void Microphys_nsw6<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& st
 
     auto temp_g = fields.get_tmp_g();
 
+    cuda_safe_call(cudaMemset(species_present_g, 0, sizeof(int)));
+
     conversion_g<TF><<<grid2dGPU, block2dGPU>>>(
            fields.st.at("qr")->fld_g, fields.st.at("qs")->fld_g, fields.st.at("qg")->fld_g,
            fields.st.at("qt")->fld_g, fields.st.at("thl")->fld_g,
@@ -760,9 +770,15 @@ void Microphys_nsw6<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& st
            this->Nc0, TF(dt),
            gd.istart, gd.jstart, gd.kstart,
            gd.iend, gd.jend, gd.kend,
-           gd.icells, gd.ijcells, temp_g->fld_g);
+           gd.icells, gd.ijcells, temp_g->fld_g,
+           species_present_g);
     cuda_check_error();
 
+    // Species that are absent from the whole domain have no fall velocity and thus no flux,
+    // such that their sedimentation is skipped and only their surface rate is reset.
+    int species_present;
+    cuda_safe_call(cudaMemcpy(&species_present, species_present_g, sizeof(int), cudaMemcpyDeviceToHost));
+
     fields.release_tmp_g(ql);
     fields.release_tmp_g(qi);
     fields.release_tmp_g(temp_g);
@@ -771,9 +787,15 @@ void Microphys_nsw6<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& st
     // Sedimentation
     //
     auto calc_sedimentation = [&](
-            TF* const tend, TF* const rr_bot, const TF* const fld,
+            TF* const tend, TF* const rr_bot, const TF* const fld, const int species_bit,
             const TF q_min, const TF a, const TF b, const TF c, const TF d, const TF N_0)
     {
+        if (!(species_present & species_bit))
+        {
+            cuda_safe_call(cudaMemset(rr_bot, 0, gd.ijcells*sizeof(TF)));
+            return;
+        }
+
         auto w_q = fields.get_tmp_g();
 
         sedimentation_nsw6::calc_velocity_g<TF><<<gridGPU, blockGPU>>>(
@@ -859,15 +881,15 @@ void Microphys_nsw6<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& st
     };
 
     calc_sedimentation(
-            fields.st.at("qr")->fld_g, rr_bot_g, fields.sp.at("qr")->fld_g,
+            fields.st.at("qr")->fld_g, rr_bot_g, fields.sp.at("qr")->fld_g, 1,
             qr_min<TF>, a_r<TF>, b_r<TF>, c_r<TF>, d_r<TF>, N_0r<TF>);
 
     calc_sedimentation(
-            fields.st.at("qs")->fld_g, rs_bot_g, fields.sp.at("qs")->fld_g,
+            fields.st.at("qs")->fld_g, rs_bot_g, fields.sp.at("qs")->fld_g, 2,
             qs_min<TF>, a_s<TF>, b_s<TF>, c_s<TF>, d_s<TF>, N_0s<TF>);
 
     calc_sedimentation(
-            fields.st.at("qg")->fld_g, rg_bot_g, fields.sp.at("qg")->fld_g,
+            fields.st.at("qg")->fld_g, rg_bot_g, fields.sp.at("qg")->fld_g, 4,
             qg_min<TF>, a_g<TF>, b_g<TF>, c_g<TF>, d_g<TF>, N_0g<TF>);
 
     cudaDeviceSynchronize();
@@ -993,6 +1015,8 @@ void Microphys_nsw6<TF>::prepare_device()
     cuda_safe_call(cudaMalloc(&rr_bot_g,  memsize2d));
     cuda_safe_call(cudaMalloc(&rs_bot_g,  memsize2d));
     cuda_safe_call(cudaMalloc(&rg_bot_g,  memsize2d));
+
+    cuda_safe_call(cudaMalloc(&species_present_g, sizeof(int)));
 }
 
 template<typename TF>
@@ -1012,6 +1036,7 @@ void Microphys_nsw6<TF>::clear_device()
     cuda_safe_call(cudaFree(rr_bot_g));
     cuda_safe_call(cudaFree(rs_bot_g));
     cuda_safe_call(cudaFree(rg_bot_g));
+    cuda_safe_call(cudaFree(species_present_g));
 }
 #endif
 
@@ -20,6 +20,7 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <vector>
@@ -38,6 +39,7 @@
 #include "microphys.h"
 #include "microphys_nsw6.h"
 #include "microphys_2mom_warm.h"
+#include "cpu_tiling.h"
 
 // Constants, move out later.
 namespace
@@ -899,6 +901,145 @@ namespace
 
         return cfl_max;
     }
+
+    // Sedimentation based on Stevens and Seifert (2008), sub-cycled in steps that keep the
+    // CFL number of this process below cflmax. The mean tendency over dt is added to qct.
+    template<typename TF>
+    void sedimentation_ss08_subcycled(
+            TF* const restrict qct, TF* const restrict rc_bot,
+            TF* const restrict w_qc, TF* const restrict c_qc,
+            TF* const restrict slope_qc, TF* const restrict flux_qc,
+            TF* const restrict qc_sub, TF* const restrict qct_sub, TF* const restrict rc_bot_sub,
+            const TF* const restrict qc,
+            const TF* const restrict rho,
+            const TF* const restrict dzi, const TF* const restrict dz,
+            const double dt, const double cflmax,
+            const TF a_c, const TF b_c, const TF c_c, const TF d_c, const TF N_0c,
+            const TF qc_min,
+            const int istart, const int jstart, const int kstart,
+            const int iend, const int jend, const int kend,
+            const int jj, const int kk, const int ncells)
+    {
+        const TF cfl = calc_cfl_ss08(
+                w_qc, qc, rho, dzi, dz, dt,
+                a_c, b_c, c_c, d_c, N_0c, qc_min,
+                istart, jstart, kstart, iend, jend, kend, jj, kk);
+
+        const int nsubstep = std::max(1, static_cast<int>(std::ceil(cfl / cflmax)));
+        const double dt_sub = dt / nsubstep;
+
+        // The copy includes the ghost cells that the slopes need.
+        std::copy(qc, qc + ncells, qc_sub);
+
+        for (int j=jstart; j<jend; ++j)
+            for (int i=istart; i<iend; ++i)
+                rc_bot[i + j*jj] = TF(0.);
+
+        for (int n=0; n<nsubstep; ++n)
+        {
+            std::fill(qct_sub, qct_sub + ncells, TF(0.));
+
+            sedimentation_ss08(
+                    qct_sub, rc_bot_sub,
+                    w_qc, c_qc, slope_qc, flux_qc,
+                    qc_sub, rho, dzi, dz, dt_sub,
+                    a_c, b_c, c_c, d_c, N_0c, qc_min,
+                    istart, jstart, kstart, iend, jend, kend, jj, kk);
+
+            for (int k=kstart; k<kend; ++k)
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        qc_sub[ijk] += TF(dt_sub)*qct_sub[ijk];
+                    }
+
+            // The surface rate is the mean over the sub-cycles.
+            for (int j=jstart; j<jend; ++j)
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ij = i + j*jj;
+                    rc_bot[ij] += rc_bot_sub[ij] / nsubstep;
+                }
+        }
+
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    qct[ijk] += (qc_sub[ijk] - qc[ijk]) / TF(dt);
+                }
+    }
+
+    // Sedimentation of one species on column-contiguous tiles, in which the search for the
+    // departure level of the flux walks through a cache-resident tile instead of full planes.
+    // The sub-cycling takes the number of sub-steps from the CFL number of each tile.
+    template<typename TF>
+    void sedimentation_ss08_tiled(
+            TF* const restrict qct, TF* const restrict rc_bot,
+            const TF* const restrict qc,
+            const TF* const restrict rho,
+            const TF* const restrict dzi, const TF* const restrict dz,
+            const double dt, const bool sw_subcycle, const double cflmax,
+            const TF a_c, const TF b_c, const TF c_c, const TF d_c, const TF N_0c,
+            const TF qc_min,
+            const int istart, const int jstart, const int kstart,
+            const int iend, const int jend, const int kend,
+            const int icells, const int ijcells, const int kcells)
+    {
+        const Cpu_tiling::Column_tiles<TF> tiles(istart, iend, jstart, jend, icells, ijcells);
+
+        const int ncol = tiles.ncol();
+        const int ntile = ncol*kcells;
+
+        #pragma omp parallel
+        {
+            std::vector<TF> buffer((sw_subcycle ? 8 : 6)*ntile + (sw_subcycle ? 2 : 1)*ncol);
+
+            TF* const qc_t     = buffer.data();
+            TF* const qct_t    = qc_t     + ntile;
+            TF* const w_t      = qct_t    + ntile;
+            TF* const c_t      = w_t      + ntile;
+            TF* const slope_t  = c_t      + ntile;
+            TF* const flux_t   = slope_t  + ntile;
+            TF* const rc_bot_t = flux_t   + ntile;
+
+            #pragma omp for
+            for (int b=0; b<tiles.n_tiles(); ++b)
+            {
+                const int iend_t = tiles.size(b);
+
+                tiles.gather(qc_t, qc, b, kstart-1, kend+1);
+                std::fill(qct_t, qct_t + ntile, TF(0.));
+
+                if (!sw_subcycle)
+                    sedimentation_ss08(
+                            qct_t, rc_bot_t, w_t, c_t, slope_t, flux_t,
+                            qc_t, rho, dzi, dz, dt,
+                            a_c, b_c, c_c, d_c, N_0c, qc_min,
+                            0, 0, kstart, iend_t, 1, kend, ncol, ncol);
+                else
+                {
+                    TF* const qc_sub_t     = rc_bot_t + ncol;
+                    TF* const qct_sub_t    = qc_sub_t + ntile;
+                    TF* const rc_bot_sub_t = qct_sub_t + ntile;
+
+                    sedimentation_ss08_subcycled(
+                            qct_t, rc_bot_t, w_t, c_t, slope_t, flux_t,
+                            qc_sub_t, qct_sub_t, rc_bot_sub_t,
+                            qc_t, rho, dzi, dz, dt, cflmax,
+                            a_c, b_c, c_c, d_c, N_0c, qc_min,
+                            0, 0, kstart, iend_t, 1, kend, ncol, ncol, ntile);
+                }
+
+                tiles.scatter_add(qct, qct_t, b, kstart, kend);
+                tiles.scatter_2d(rc_bot, rc_bot_t, b);
+            }
+        }
+    }
 }
 
 template<typename TF>
@@ -911,6 +1052,14 @@ Microphys_nsw6<TF>::Microphys_nsw6(Master& masterin, Grid<TF>& gridin, Fields<TF
     // Read microphysics switches and settings
     // swmicrobudget = inputin.get_item<bool>("micro", "swmicrobudget", "", false);
     cflmax = inputin.get_item<TF>("micro", "cflmax", "", 1.2);
+
+    // Sub-cycle the sedimentation, such that it does not limit the time step of the model.
+    swsedimentsubcycle = inputin.get_item<bool>("micro", "swsedimentsubcycle", "", false);
+
+    #ifdef USECUDA
+    if (swsedimentsubcycle)
+        throw std::runtime_error("swsedimentsubcycle is not implemented on the GPU");
+    #endif
     Nc0 = inputin.get_item<TF>("micro", "Nc0", "");
 
     // Initialize the qr (rain water specific humidity) and nr (droplot number concentration) fields
@@ -1010,60 +1159,44 @@ void Microphys_nsw6<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& st
     fields.release_tmp(ql);
     fields.release_tmp(qi);
 
-    auto tmp1 = fields.get_tmp();
-    auto tmp2 = fields.get_tmp();
-    auto tmp3 = fields.get_tmp();
-    auto tmp4 = fields.get_tmp();
-
     // Falling rain.
-    sedimentation_ss08(
+    sedimentation_ss08_tiled(
             fields.st.at("qr")->fld.data(), rr_bot.data(),
-            tmp1->fld.data(), tmp2->fld.data(),
-            tmp3->fld.data(), tmp4->fld.data(),
             fields.sp.at("qr")->fld.data(),
             fields.rhoref.data(),
             gd.dzi.data(), gd.dz.data(),
-            dt,
+            dt, swsedimentsubcycle, cflmax,
             a_r<TF>, b_r<TF>, c_r<TF>, d_r<TF>, N_0r<TF>,
             qr_min<TF>,
             gd.istart, gd.jstart, gd.kstart,
             gd.iend, gd.jend, gd.kend,
-            gd.icells, gd.ijcells);
+            gd.icells, gd.ijcells, gd.kcells);
 
     // Falling snow.
-    sedimentation_ss08(
+    sedimentation_ss08_tiled(
             fields.st.at("qs")->fld.data(), rs_bot.data(),
-            tmp1->fld.data(), tmp2->fld.data(),
-            tmp3->fld.data(), tmp4->fld.data(),
             fields.sp.at("qs")->fld.data(),
             fields.rhoref.data(),
             gd.dzi.data(), gd.dz.data(),
-            dt,
+            dt, swsedimentsubcycle, cflmax,
             a_s<TF>, b_s<TF>, c_s<TF>, d_s<TF>, N_0s<TF>,
             qs_min<TF>,
             gd.istart, gd.jstart, gd.kstart,
             gd.iend, gd.jend, gd.kend,
-            gd.icells, gd.ijcells);
+            gd.icells, gd.ijcells, gd.kcells);
 
     // Falling graupel.
-    sedimentation_ss08(
+    sedimentation_ss08_tiled(
             fields.st.at("qg")->fld.data(), rg_bot.data(),
-            tmp1->fld.data(), tmp2->fld.data(),
-            tmp3->fld.data(), tmp4->fld.data(),
             fields.sp.at("qg")->fld.data(),
             fields.rhoref.data(),
             gd.dzi.data(), gd.dz.data(),
-            dt,
+            dt, swsedimentsubcycle, cflmax,
             a_g<TF>, b_g<TF>, c_g<TF>, d_g<TF>, N_0g<TF>,
             qg_min<TF>,
             gd.istart, gd.jstart, gd.kstart,
             gd.iend, gd.jend, gd.kend,
-            gd.icells, gd.ijcells);
-
-    fields.release_tmp(tmp1);
-    fields.release_tmp(tmp2);
-    fields.release_tmp(tmp3);
-    fields.release_tmp(tmp4);
+            gd.icells, gd.ijcells, gd.kcells);
 
     stats.calc_tend(*fields.st.at("thl"), tend_name);
     stats.calc_tend(*fields.st.at("qt" ), tend_name);
@@ -1116,8 +1249,11 @@ void Microphys_nsw6<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
 
 #ifndef USECUDA
 template<typename TF>
-unsigned long Microphys_nsw6<TF>::get_time_limit(unsigned long idt, const double dt)
+double Microphys_nsw6<TF>::get_sedimentation_cfl_local(const double dt)
 {
+    if (swsedimentsubcycle)
+        return 0.;
+
     auto& gd = grid.get_grid_data();
 
     auto tmp = fields.get_tmp();
@@ -1166,14 +1302,32 @@ unsigned long Microphys_nsw6<TF>::get_time_limit(unsigned long idt, const double
             gd.icells, gd.ijcells);
     cfl = std::max(cfl, cfl_g);
 
+    fields.release_tmp(tmp);
+
+    return cfl;
+}
+
+template<typename TF>
+unsigned long Microphys_nsw6<TF>::get_time_limit(unsigned long idt, const double dt)
+{
+    if (swsedimentsubcycle)
+        return Constants::ulhuge;
+
     // Get maximum CFL across all MPI tasks
+    double cfl = get_sedimentation_cfl_local(dt);
     master.max(&cfl, 1);
-    fields.release_tmp(tmp);
 
-    // Prevent zero division.
-    cfl = std::max(cfl, 1.e-5);
+    return get_time_limit_from_cfl(idt, dt, cfl);
+}
 
-    return idt * this->cflmax / cfl;
+template<typename TF>
+unsigned long Microphys_nsw6<TF>::get_time_limit_from_cfl(unsigned long idt, const double dt, const double cfl)
+{
+    if (swsedimentsubcycle)
+        return Constants::ulhuge;
+
+    // Prevent zero division.
+    return idt * this->cflmax / std::max(cfl, 1.e-5);
 }
 #endif
 
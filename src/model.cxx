@@ -19,11 +19,13 @@
  * You should have received a copy of the GNU General Public License
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <array>
 #include <iostream>
 #include <string>
 #include <cstdio>
 #include <algorithm>
 #include <cmath>
+#include <unistd.h>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -39,10 +41,12 @@
 #include "boundary.h"
 #include "immersed_boundary.h"
 #include "advec.h"
+#include "advec_split.h"
 #include "diff.h"
 #include "pres.h"
 #include "force.h"
 #include "particle_bin.h"
+#include "particles.h"
 #include "thermo.h"
 #include "radiation.h"
 #include "microphys.h"
@@ -53,18 +57,59 @@
 #include "column.h"
 #include "cross.h"
 #include "dump.h"
+#include "dump_average.h"
+#include "quicklook.h"
+#include "checkpoint.h"
+#include "objects.h"
+#include "spectra.h"
+#include "spectral_nudge.h"
+#include "io_server.h"
 #include "model.h"
 #include "source.h"
 #include "aerosol.h"
 #include "background_profs.h"
 #include "windfarm.h"
+#include "timer.h"
+#include "memory_tracker.h"
+#include "nvtx_range.h"
 
 #ifdef USECUDA
 #include <cuda_runtime_api.h>
+#include "cuda_graph.h"
+#include "cuda_streams.h"
 #endif
 
 namespace
 {
+    // On the GPU, the host loops of an output task (statistics of the snapshot, NetCDF and
+    // binary output) run on the npthreads cores set in [master], which are otherwise idle.
+    // The setting applies to the calling task only and is a no-op on the CPU.
+    inline void use_output_threads(const Master& master)
+    {
+        #if defined(USECUDA) && defined(_OPENMP)
+        omp_set_num_threads(master.get_npthreads());
+        #endif
+    }
+
+    // Every member runs in its own directory (sim_name)_(member), e.g. drycblles_007, with its own
+    // (sim_name).ini and input files, such that the output of the members does not collide.
+    // The messages of a member go to (sim_name).log in its directory.
+    void enter_ensemble_member(const std::string& sim_name, const int nmembers, Master& master)
+    {
+        const int member = master.split_ensemble(nmembers);
+
+        char member_dir[256];
+        std::snprintf(member_dir, 256, "%s_%03d", sim_name.c_str(), member);
+
+        if (chdir(member_dir) != 0)
+            throw std::runtime_error("Cannot enter the directory \"" + std::string(member_dir) + "\" of the ensemble member");
+
+        if (master.get_mpiid() == 0 && std::freopen((sim_name + ".log").c_str(), "a", stdout) == nullptr)
+            throw std::runtime_error("Cannot open \"" + sim_name + ".log\" in \"" + std::string(member_dir) + "\"");
+
+        master.print_message("Ensemble member %d of %d on %d processes\n", member, nmembers, master.get_MPI_data().nprocs);
+    }
+
     void process_command_line_options(Sim_mode& sim_mode, std::string& sim_name,
                                       int argc, char *argv[],
                                       Master& master)
@@ -101,6 +146,23 @@ namespace
 
             master.print_message("Simulation name: %s\n", sim_name.c_str());
             master.print_message("Simulation mode: %s\n", sim_mode_str.c_str());
+
+            // An optional number of ensemble members splits the processes over the members.
+            if (argc > 3)
+            {
+                int nmembers;
+                try
+                {
+                    nmembers = std::stoi(argv[3]);
+                }
+                catch (std::exception&)
+                {
+                    throw std::runtime_error("Illegal number of ensemble members \"" + std::string(argv[3]) + "\"");
+                }
+
+                if (nmembers > 1)
+                    enter_ensemble_member(sim_name, nmembers, master);
+            }
         }
     }
 }
@@ -126,11 +188,12 @@ Model<TF>::Model(Master& masterin, int argc, char *argv[]) :
         soil_grid = std::make_shared<Soil_grid<TF>>(master, *grid, *input);
         fields    = std::make_shared<Fields<TF>>   (master, *grid, *soil_grid, *input);
         timeloop  = std::make_shared<Timeloop<TF>> (master, *grid, *soil_grid, *fields, *input, sim_mode);
-        fft       = std::make_shared<FFT<TF>>      (master, *grid);
+        fft       = std::make_shared<FFT<TF>>      (master, *grid, *input);
 
         boundary  = Boundary<TF> ::factory(master, *grid, *soil_grid, *fields, *input);
 
         advec     = Advec<TF>    ::factory(master, *grid, *fields, *input);
+        advec_split = std::make_shared<Advec_split<TF>>(master, *grid, *fields, *advec, *input);
         diff      = Diff<TF>     ::factory(master, *grid, *fields, *boundary, *input);
         pres      = Pres<TF>     ::factory(master, *grid, *fields, *fft, *input);
         thermo    = Thermo<TF>   ::factory(master, *grid, *fields, *input, sim_mode);
@@ -146,18 +209,42 @@ Model<TF>::Model(Master& masterin, int argc, char *argv[]) :
         background= std::make_shared<Background<TF>>(master, *grid, *fields, *input);
 
         particle_bin = std::make_shared<Particle_bin<TF>>(master, *grid, *fields, *input);
+        particles = std::make_shared<Particles<TF>>(master, *grid, *fields, *input);
 
         windfarm  = std::make_shared<Windfarm<TF>>(master, *grid, *fields, *input);
+        spectral_nudge = std::make_shared<Spectral_nudge<TF>>(master, *grid, *fields, *fft, *input);
+
+        timer     = std::make_shared<Timer>(master, *input, sim_name);
+        memory    = std::make_shared<Memory_tracker>(master);
 
         ib        = std::make_shared<Immersed_boundary<TF>>(master, *grid, *fields, *input);
 
         stats     = std::make_shared<Stats <TF>>(master, *grid, *soil_grid, *background, *fields, *advec, *diff, *input);
         column    = std::make_shared<Column<TF>>(master, *grid, *fields, *input);
-        dump      = std::make_shared<Dump  <TF>>(master, *grid, *fields, *input);
-        cross     = std::make_shared<Cross <TF>>(master, *grid, *soil_grid, *fields, *input);
+        io_server = std::make_shared<Io_server>(master);
+        dump      = std::make_shared<Dump  <TF>>(master, *grid, *fields, *io_server, *input);
+        dump_average = std::make_shared<Dump_average<TF>>(master, *grid, *fields, *input);
+        quicklook = std::make_shared<Quicklook<TF>>(master, *grid, *fields, *input);
+        checkpoint = std::make_shared<Checkpoint<TF>>(master, *fields, *input, sim_name);
+        cross     = std::make_shared<Cross <TF>>(master, *grid, *soil_grid, *fields, *io_server, *input);
+        objects   = std::make_shared<Objects<TF>>(master, *grid, *fields, *input);
+        spectra   = std::make_shared<Spectra<TF>>(master, *grid, *fields, *fft, *input);
 
         budget    = Budget<TF>::factory(master, *grid, *fields, *thermo, *diff, *advec, *force, *stats, *input);
 
+        if (thermo->get_switch_fuse_buoyancy() && !advec->set_fused_buoyancy(*thermo))
+            throw std::runtime_error("swfusebuoyancy=true requires swadvec=2");
+
+        #ifdef USECUDA
+        cuda_graph = std::make_shared<Cuda_graph>(master, input->get_item<bool>("time", "swcudagraph", "", false));
+        Cuda_streams::set_pool_size(input->get_item<int>("time", "ncudastreams", "", 1));
+        swcudamempool = input->get_item<bool>("master", "swcudamempool", "", false);
+        swcudamanaged = input->get_item<bool>("master", "swcudamanaged", "", false);
+
+        if (swcudamempool && swcudamanaged)
+            throw std::runtime_error("swcudamempool and swcudamanaged cannot be combined");
+        #endif
+
         // Parse the statistics masks
         add_statistics_masks();
     }
@@ -189,36 +276,50 @@ void Model<TF>::init()
 {
     master.init(*input);
 
-    grid->init();
-    soil_grid->init();
-    fields->init(*input, *dump, *cross, sim_mode);
-
-    fft->init();
-
-    boundary->init(*input, *thermo, sim_mode);
-    ib->init(*input, *cross);
-    buffer->init();
-    diff->init();
-    pres->init();
-    force->init();
-    thermo->init();
-    microphys->init();
-    radiation->init(*timeloop);
-    decay->init(*input);
-    budget->init();
-    source->init();
-    aerosol->init();
-    background->init(*input_nc);
-
-    stats->init();
-    column->init();
-    cross->init();
-    dump->init();
+    // The I/O servers only run the write loop in exec().
+    if (master.is_io_server())
+        return;
+
+    memory->track("grid", [&]{ grid->init(); });
+    memory->track("soil_grid", [&]{ soil_grid->init(); });
+    memory->track("fields", [&]{ fields->init(*input, *dump, *cross, sim_mode); });
+
+    memory->track("fft", [&]{ fft->init(); });
+
+    memory->track("boundary", [&]{ boundary->init(*input, *thermo, sim_mode); });
+    memory->track("ib", [&]{ ib->init(*input, *cross); });
+    memory->track("buffer", [&]{ buffer->init(); });
+    memory->track("diff", [&]{ diff->init(); });
+    memory->track("advec_split", [&]{ advec_split->init(); });
+    memory->track("pres", [&]{ pres->init(); });
+    memory->track("force", [&]{ force->init(); });
+    memory->track("thermo", [&]{ thermo->init(); });
+    memory->track("microphys", [&]{ microphys->init(); });
+    memory->track("radiation", [&]{ radiation->init(*timeloop); });
+    memory->track("decay", [&]{ decay->init(*input); });
+    memory->track("budget", [&]{ budget->init(); });
+    memory->track("source", [&]{ source->init(); });
+    memory->track("aerosol", [&]{ aerosol->init(); });
+    memory->track("background", [&]{ background->init(*input_nc); });
+
+    memory->track("stats", [&]{ stats->init(); });
+    memory->track("column", [&]{ column->init(); });
+    memory->track("cross", [&]{ cross->init(); });
+    memory->track("dump", [&]{ dump->init(); });
+    memory->track("dump_average", [&]{ dump_average->init(); });
+    memory->track("quicklook", [&]{ quicklook->init(); });
+    memory->track("objects", [&]{ objects->init(); });
 }
 
 template<typename TF>
 void Model<TF>::load_or_save()
 {
+    if (master.is_io_server())
+    {
+        input.reset();
+        return;
+    }
+
     if (sim_mode == Sim_mode::Init)
     {
         // Initialize the allocated fields and save the data.
@@ -247,56 +348,73 @@ void Model<TF>::load()
     fft->load();
     timeloop->load(timeloop->get_iotime());
 
-    soil_grid->create(*input_nc);
+    // A newer checkpoint of the state in memory replaces the time of the restart files,
+    // which are still read at their own time.
+    const int iotime_restart = timeloop->get_iotime();
+    if (sim_mode == Sim_mode::Run)
+        checkpoint->load(*timeloop);
+
+    memory->track("soil_grid", [&]{ soil_grid->create(*input_nc); });
 
     // Initialize the statistics file to open the possiblity to add profiles in other routines
-    stats->create(*timeloop, sim_name);
-    column->create(*input, *timeloop, sim_name);
+    memory->track("stats", [&]{ stats->create(*timeloop, sim_name); });
+    memory->track("column", [&]{ column->create(*input, *timeloop, sim_name); });
+    memory->track("objects", [&]{ objects->create(*timeloop, *stats, sim_name); });
 
     // Load the fields, and create the field statistics
-    fields->load(timeloop->get_iotime());
-    fields->create_stats(*stats);
-    fields->create_column(*column);
+    memory->track("fields", [&]{ fields->load(iotime_restart); });
+    memory->track("fields", [&]{ fields->create_stats(*stats); });
+    memory->track("spectra", [&]{ spectra->create(*stats); });
+    memory->track("fields", [&]{ fields->create_column(*column); });
 
     grid->create_stats(*stats);
 
-    thermo->create(*input, *input_nc, *stats, *column, *cross, *dump, *timeloop);
-    thermo->load(timeloop->get_iotime());
+    memory->track("thermo", [&]{ thermo->create(*input, *input_nc, *stats, *column, *cross, *dump, *timeloop); });
+    memory->track("thermo", [&]{ thermo->load(iotime_restart); });
 
-    boundary->load(timeloop->get_iotime(), *thermo);
-    boundary->create(*input, *input_nc, *stats, *column, *cross, *timeloop);
+    memory->track("boundary", [&]{ boundary->load(iotime_restart, *thermo); });
+    memory->track("boundary", [&]{ boundary->create(*input, *input_nc, *stats, *column, *cross, *timeloop); });
     boundary->set_values();
 
-    ib->create();
-    buffer->create(*input, *input_nc, *stats);
-    force->create(*input, *input_nc, *stats);
-    source->create(*input, *input_nc);
-    particle_bin->create(*timeloop);
-    aerosol->create(*input, *input_nc, *stats);
-    background->create(*input, *input_nc, *stats);
+    memory->track("ib", [&]{ ib->create(); });
+    memory->track("buffer", [&]{ buffer->create(*input, *input_nc, *stats); });
+    memory->track("force", [&]{ force->create(*input, *input_nc, *stats); });
+    memory->track("source", [&]{ source->create(*input, *input_nc); });
+    memory->track("particle_bin", [&]{ particle_bin->create(*timeloop, *advec); });
+    memory->track("particles", [&]{ particles->create(*timeloop); });
+    memory->track("particles", [&]{ particles->load(iotime_restart); });
+    memory->track("aerosol", [&]{ aerosol->create(*input, *input_nc, *stats); });
+    memory->track("background", [&]{ background->create(*input, *input_nc, *stats); });
 
-    windfarm->create();
+    memory->track("windfarm", [&]{ windfarm->create(); });
+    memory->track("spectral_nudge", [&]{ spectral_nudge->create(); });
 
-    microphys->create(*input, *input_nc, *stats, *cross, *dump, *column);
+    memory->track("microphys", [&]{ microphys->create(*input, *input_nc, *stats, *cross, *dump, *column); });
 
     // Radiation needs to be created after thermo as it needs base profiles.
-    radiation->create(*input, *input_nc, *thermo, *stats, *column, *cross, *dump);
-    decay->create(*input, *stats);
-    limiter->create(*stats);
+    memory->track("radiation", [&]{ radiation->create(*input, *input_nc, *thermo, *stats, *column, *cross, *dump); });
+    memory->track("decay", [&]{ decay->create(*input, *stats); });
+    memory->track("limiter", [&]{ limiter->create(*stats); });
 
     // Cross and dump both need to be called at/near the
     // end of the create phase, as other classes register which
     // variables are legal as a cross/dump.
-    cross->create();
-    dump->create();
+    memory->track("cross", [&]{ cross->create(); });
+    memory->track("dump", [&]{ dump->create(); });
+    memory->track("dump_average", [&]{ dump_average->create(*timeloop); });
+    memory->track("quicklook", [&]{ quicklook->create(*thermo, sim_name); });
 
     pres->set_values();
-    pres->create(*stats);
-    advec->create(*stats);
-    diff->create(*stats, false);
+    memory->track("pres", [&]{ pres->create(*stats); });
+    memory->track("advec", [&]{ advec->create(*stats); });
+    memory->track("advec_split", [&]{ advec_split->create(*timeloop); });
+    memory->track("diff", [&]{ diff->create(*stats, false); });
+
+    memory->track("thermo", [&]{ thermo->create_stats(*stats); });
+    memory->track("budget", [&]{ budget->create(*stats); });
 
-    thermo->create_stats(*stats);
-    budget->create(*stats);
+    // Overwrite the loaded state with the checkpoint, if load() found one.
+    checkpoint->create(*thermo, *boundary);
 }
 
 // In these functions data necessary to start the model is saved to disk.
@@ -323,41 +441,95 @@ void Model<TF>::save()
 
     boundary->create_cold_start(*input_nc);
     boundary->save(timeloop->get_iotime(), *thermo);
+
+    particles->create_cold_start();
+    particles->save(timeloop->get_iotime());
 }
 
 template<typename TF>
 void Model<TF>::exec()
+{
+    start_exec();
+    advance(0);
+    finish_exec();
+}
+
+template<typename TF>
+void Model<TF>::start_exec()
 {
     if (sim_mode == Sim_mode::Init)
         return;
 
+    if (master.is_io_server())
+    {
+        io_server->exec();
+        return;
+    }
+
+    exec_started = true;
+
     #ifdef USECUDA
     prepare_gpu();
     #endif
 
+    memory->print();
+
     master.print_message("Starting time integration\n");
 
     #ifdef USECUDA
         #ifdef _OPENMP
         omp_set_nested(1);
-        const int nthreads_out=2;
-        master.print_message("Running with %i OpenMP threads\n", omp_get_max_threads());
+        omp_set_max_active_levels(2);
+        nthreads_out = 2;
+
+        // The time integration only launches kernels, such that it runs serial, and the host cores
+        // of the process are left to the output tasks, which open their own parallel regions.
+        omp_set_num_threads(1);
+
+        // The output tasks communicate next to the time integration, which needs MPI_THREAD_MULTIPLE.
+        defer_output_tasks = master.has_thread_multiple();
+        if (!defer_output_tasks)
+            master.print_warning("The MPI library does not provide MPI_THREAD_MULTIPLE, the output runs in the time loop\n");
+        master.print_message("Running with %i OpenMP threads in the output tasks\n", master.get_npthreads());
         #endif
     #else
         #ifdef _OPENMP
-        omp_set_num_threads(1);
-        const int nthreads_out=1;
+        // The outer region runs on a single thread, the kernels open their own
+        // parallel regions with the npthreads threads set in [master].
+        omp_set_num_threads(master.get_npthreads());
+
+        // Asynchronous radiation runs as a task on a second thread of the outer region. The
+        // statistics and save tasks then run undeferred, as they would otherwise race with
+        // the time integration on that thread.
+        nthreads_out = radiation->get_switch_async() ? 2 : 1;
+        defer_output_tasks = (nthreads_out == 1);
+        if (nthreads_out > 1)
+            omp_set_max_active_levels(2);
+
+        master.print_message("Running with %i OpenMP threads\n", master.get_npthreads());
         #endif
     #endif
+}
+
+template<typename TF>
+bool Model<TF>::advance(const int nsteps)
+{
+    if (!exec_started || exec_finished)
+        return false;
 
     #pragma omp parallel num_threads(nthreads_out)
     {
         #pragma omp master
         {
+            // Dependency of the output tasks on each other.
+            int output_dependency = 0;
+            int nsteps_done = 0;
+
             // start the time loop
             while (true)
             {
                 // Update the time dependent parameters.
+                timer->start("timedep");
                 grid      ->update_time_dependent(*timeloop);
                 boundary  ->update_time_dependent(*timeloop);
                 thermo    ->update_time_dependent(*timeloop);
@@ -365,84 +537,186 @@ void Model<TF>::exec()
                 radiation ->update_time_dependent(*timeloop);
                 aerosol   ->update_time_dependent(*timeloop);
                 background->update_time_dependent(*timeloop);
+                timer->stop("timedep");
+
+                // Set the cyclic BCs of the prognostic 3D fields. The field means only read the
+                // interior, such that they are calculated while the ghost cells are in flight.
+                timer->start("cyclic");
+                boundary->begin_prognostic_cyclic_bcs();
+                timer->stop("cyclic");
+
+                // Calculate the field means, in case needed, and start a new substep
+                // for the diagnostics that are shared between the modules.
+                timer->start("fields");
+                fields->set_substep(timeloop->get_itime(), timeloop->get_substep());
+                fields->exec();
+                timer->stop("fields");
 
-                // Set the cyclic BCs of the prognostic 3D fields.
-                boundary->set_prognostic_cyclic_bcs();
+                timer->start("cyclic");
+                boundary->finish_prognostic_cyclic_bcs();
                 boundary->set_prognostic_outflow_bcs();
                 boundary->set_ghost_cells();
+                timer->stop("cyclic");
 
-                // Calculate the field means, in case needed.
-                fields->exec();
+                fields->update_active_boxes();
 
                 // Get the viscosity to be used in diffusion.
+                timer->start("viscosity");
                 diff->exec_viscosity(*stats, *thermo);
+                timer->stop("viscosity");
 
                 // Determine the time step.
                 set_time_step();
 
+                // Add the velocities at the start of the time step to the split advection.
+                advec_split->begin_step(*timeloop);
+
                 // Write status information to disk.
+                timer->start("status");
                 print_status();
+                timer->stop("status");
 
                 // Calculate stat masks and begin tendency calculation, if necessary
+                timer->start("stats_masks");
                 setup_stats();
+                timer->stop("stats_masks");
 
                 // Calculate the thermodynamics and the buoyancy tendency.
+                timer->start("thermo");
                 thermo->exec(timeloop->get_sub_time_step(), *stats);
+                timer->stop("thermo");
 
                 // Calculate the microphysics.
+                timer->start("microphys");
                 microphys->exec(*thermo, timeloop->get_dt(), *stats);
+                timer->stop("microphys");
 
                 // Calculate the radiation fluxes and the related heating rate.
+                timer->start("radiation");
                 radiation->exec(*thermo, timeloop->get_time(), *timeloop, *stats, *aerosol, *background, *microphys);
+                timer->stop("radiation");
 
                 // Calculate Monin-Obukhov parameters (L, u*), and calculate
                 // surface fluxes, gradients, ...
+                timer->start("boundary");
                 boundary->exec(*thermo, *radiation, *microphys, *timeloop);
                 boundary->set_ghost_cells();
+                timer->stop("boundary");
 
                 // Set the immersed boundary conditions for scalars.
+                timer->start("ib");
                 ib->exec_scalars();
+                timer->stop("ib");
 
                 // Update the outflow boundary conditions in case IB is used.
                 if (ib->get_switch() != IB_type::Disabled)
                     boundary->set_prognostic_outflow_bcs();
 
-                // Calculate the advection tendency.
-                boundary->set_ghost_cells_w(Boundary_w_type::Conservation_type);
-                advec->exec(*stats);
-                boundary->set_ghost_cells_w(Boundary_w_type::Normal_type);
-
-                // Calculate the diffusion tendency.
-                diff->exec(*stats);
-
-                // Calculate the tendency due to damping in the buffer layer.
-                buffer->exec(*stats);
+                auto calc_dynamics_tendencies = [&]()
+                {
+                    // Calculate the advection tendency.
+                    timer->start("advec");
+                    boundary->set_ghost_cells_w(Boundary_w_type::Conservation_type);
+                    advec->exec(*stats);
+                    boundary->set_ghost_cells_w(Boundary_w_type::Normal_type);
+                    timer->stop("advec");
+
+                    // Calculate the diffusion tendency.
+                    timer->start("diff");
+                    fields->begin_slow_tendencies(timeloop->get_iteration());
+                    diff->exec(*stats);
+                    fields->end_slow_tendencies();
+                    timer->stop("diff");
+
+                    // Calculate the tendency due to damping in the buffer layer.
+                    timer->start("buffer");
+                    buffer->exec(*stats);
+                    timer->stop("buffer");
+                };
+
+                #ifdef USECUDA
+                // Replay the kernels of the dynamics tendencies as a CUDA graph, except
+                // in case of tendency statistics, which need host work in between.
+                if (cuda_graph->is_enabled() && !stats->is_doing_tendency())
+                {
+                    // The recording may not overlap with the kernels of the statistics task.
+                    if (!cuda_graph->is_captured())
+                    {
+                        #pragma omp taskwait
+                    }
+                    // The events of the timers would invalidate the recording of the graph.
+                    timer->start("cuda_graph");
+                    timer->suspend();
+                    cuda_graph->exec(calc_dynamics_tendencies);
+                    timer->resume();
+                    timer->stop("cuda_graph");
+                }
+                else
+                    calc_dynamics_tendencies();
+                #else
+                calc_dynamics_tendencies();
+                #endif
 
                 // Apply the scalar decay.
-                decay->exec(timeloop->get_sub_time_step(), *stats);
+                timer->start("decay");
+                decay->exec(timeloop->get_sub_time_step(), *stats, *timeloop);
+                timer->stop("decay");
 
                 // Add point and line sources of scalars.
+                timer->start("source");
                 source->exec(*timeloop);
+                timer->stop("source");
 
                 // Gravitational settling of binned dust types.
+                timer->start("particle_bin");
                 particle_bin->exec(*stats);
+                timer->stop("particle_bin");
+
+                // Advect the Lagrangian particles.
+                timer->start("particles");
+                particles->exec(*timeloop);
+                timer->stop("particles");
 
                 // Apply turbine forcing from wind farm
+                timer->start("windfarm");
                 windfarm->exec(*stats, timeloop->get_time());
+                timer->stop("windfarm");
+
+                // Nudge the large horizontal scales towards the target fields.
+                timer->start("spectral_nudge");
+                spectral_nudge->exec(*timeloop);
+                timer->stop("spectral_nudge");
+
+                // Add the tendencies of a coupled component in library mode.
+                if (external_tendency)
+                    external_tendency();
+
+                // Solve the implicit part of the vertical diffusion, which needs all other tendencies.
+                timer->start("diff");
+                diff->exec_implicit(timeloop->get_sub_time_step(), *stats);
+                timer->stop("diff");
 
                 // Apply the large scale forcings. Keep this one always right before the pressure.
+                timer->start("force");
                 force->exec(timeloop->get_sub_time_step(), *thermo, *stats);
+                timer->stop("force");
 
                 // Set the immersed boundary conditions
+                timer->start("ib");
                 ib->exec_momentum();
+                timer->stop("ib");
 
                 // Solve the poisson equation for pressure.
+                timer->start("pres");
                 boundary->set_ghost_cells_w(Boundary_w_type::Conservation_type);
                 pres->exec(timeloop->get_sub_time_step(), *stats);
                 boundary->set_ghost_cells_w(Boundary_w_type::Normal_type);
+                timer->stop("pres");
 
                 // Apply the limiter as the last tendency.
-                limiter->exec(timeloop->get_sub_time_step(), *stats);
+                timer->start("limiter");
+                limiter->exec(timeloop->get_sub_time_step(), *stats, *timeloop);
+                timer->stop("limiter");
 
                 // Calculate the total tendency statistics, if necessary
                 for (auto& it: fields->at)
@@ -466,13 +740,41 @@ void Model<TF>::exec()
 
                     if (stats->do_statistics(itime) || cross->do_cross(itime) || dump->do_dump(itime, idt))
                     {
+                        int snapshot = -1;
+
                         #ifdef USECUDA
-                        #pragma omp taskwait
-                        cpu_up_to_date = true;
-                        fields   ->backward_device();
-                        boundary ->backward_device(*thermo);
-                        thermo   ->backward_device();
-                        microphys->backward_device();
+                        // Without statistics, and with only fields in the cross-sections and dumps,
+                        // the other fields do not have to be copied. With free host snapshots, these
+                        // are copied into a snapshot, such that the running output task can continue.
+                        if (!stats->do_statistics(itime) && fields->has_standalone_output())
+                        {
+                            if (fields->get_output_snapshots() > 0)
+                            {
+                                snapshot = fields->get_free_output_snapshot();
+                                if (snapshot < 0)
+                                {
+                                    #pragma omp taskwait
+                                    snapshot = fields->get_free_output_snapshot();
+                                }
+                            }
+                            else
+                            {
+                                #pragma omp taskwait
+                            }
+
+                            Nvtx_range range("backward_device_output");
+                            fields->backward_device_output(*cross, snapshot);
+                        }
+                        else
+                        {
+                            #pragma omp taskwait
+                            Nvtx_range range("backward_device");
+                            cpu_up_to_date = true;
+                            fields   ->backward_device();
+                            boundary ->backward_device(*thermo);
+                            thermo   ->backward_device();
+                            microphys->backward_device();
+                        }
                         #endif
 
                         radiation->exec_all_stats(
@@ -480,8 +782,26 @@ void Model<TF>::exec()
                                 *thermo, *timeloop,
                                 itime, iotime);
 
-                        #pragma omp task default(shared)
-                        calculate_statistics(iter, time, itime, idt, iotime, dt);
+                        // The output tasks write to the same files, such that they run in order.
+                        #pragma omp task default(shared) firstprivate(iter, time, itime, idt, iotime, dt, snapshot) \
+                                depend(inout: output_dependency) if(defer_output_tasks)
+                        {
+                            use_output_threads(master);
+                            fields->set_output_snapshot(snapshot);
+                            calculate_statistics(iter, time, itime, idt, iotime, dt);
+                            fields->release_output_snapshot(snapshot);
+                        }
+                    }
+
+                    // Write the timings of the modules, excluding the statistics task.
+                    timer->exec(iter, time);
+
+                    if (particles->do_output(itime))
+                    {
+                        #ifdef USECUDA
+                        particles->backward_device();
+                        #endif
+                        particles->save(iotime);
                     }
 
                     if (column->do_column(itime))
@@ -496,20 +816,47 @@ void Model<TF>::exec()
                         column   ->exec(iter, time, itime);
                     }
 
+                    if (dump_average->do_sample(itime))
+                    {
+                        // The averages are saved through the dump, which must not overlap with the output task.
+                        #pragma omp taskwait
+                        dump_average->exec(*dump, itime, iotime);
+                    }
+
+                    if (quicklook->do_quicklook(itime))
+                    {
+                        // The snapshots use the temporary fields and collective calls, like the output task.
+                        #pragma omp taskwait
+                        quicklook->exec(*thermo, *microphys, time, iotime);
+                    }
+
                 }
 
                 // Exit the simulation when the runtime has been hit.
                 if (timeloop->is_finished())
+                {
+                    exec_finished = true;
                     break;
+                }
 
                 // RUN MODE: In case of run mode do the time stepping.
                 if (sim_mode == Sim_mode::Run)
                 {
                     // Integrate in time.
+                    timer->start("timeloop");
                     timeloop->exec();
+                    timer->stop("timeloop");
+
+                    // Write the statistics of which the reduction overlapped with the time step.
+                    stats->finish_exec();
 
                     // Increase the time with the time step.
                     timeloop->step_time();
+
+                    // Advect the split scalars at the end of their interval.
+                    timer->start("advec_split");
+                    advec_split->exec(*timeloop);
+                    timer->stop("advec_split");
                     #ifdef USECUDA
                     cpu_up_to_date = false;
                     #endif
@@ -526,8 +873,12 @@ void Model<TF>::exec()
                         if (!cpu_up_to_date)
                         {
                             #pragma omp taskwait
-                            cpu_up_to_date = true;
-                            fields   ->backward_device();
+                            Nvtx_range range("backward_device");
+
+                            // With GPUDirect Storage, the 3D fields are saved from device memory.
+                            const bool copy_3d = !fields->has_device_save();
+                            cpu_up_to_date = copy_3d;
+                            fields   ->backward_device(copy_3d);
                             boundary ->backward_device(*thermo);
                             thermo   ->backward_device();
                             microphys->backward_device();
@@ -540,12 +891,53 @@ void Model<TF>::exec()
                         // leading to restart failures.
                         thermo->save(iotime);
 
-                        #pragma omp task default(shared)
+                        #ifdef USECUDA
+                        particles->backward_device();
+                        #endif
+                        particles->save(iotime);
+
+                        if (fields->get_async_save())
                         {
+                            // Only the 3D fields are large enough to be worth writing in the background.
                             timeloop->save(iotime, itime, idt, iteration);
-                            fields  ->save(iotime);
                             boundary->save(iotime, *thermo);
+                            fields  ->save_begin(iotime);
+                        }
+                        else
+                        {
+                            // The save from device memory reads the fields that the next step
+                            // overwrites, such that it cannot run in the background.
+                            const bool defer_save = defer_output_tasks && !fields->has_device_save();
+
+                            #pragma omp task default(shared) if(defer_save)
+                            {
+                                use_output_threads(master);
+                                timeloop->save(iotime, itime, idt, iteration);
+                                fields  ->save(iotime);
+                                boundary->save(iotime, *thermo);
+                            }
+                        }
+                    }
+
+                    // Save the partner checkpoint of the state.
+                    if (checkpoint->do_checkpoint(timeloop->get_iteration()))
+                    {
+                        #ifdef USECUDA
+                        if (!cpu_up_to_date)
+                        {
+                            #pragma omp taskwait
+                            Nvtx_range range("backward_device");
+                            cpu_up_to_date = true;
+                            fields   ->backward_device();
+                            boundary ->backward_device(*thermo);
+                            thermo   ->backward_device();
+                            microphys->backward_device();
                         }
+                        #endif
+
+                        timer->start("checkpoint");
+                        checkpoint->exec(*timeloop);
+                        timer->stop("checkpoint");
                     }
                 }
 
@@ -557,7 +949,10 @@ void Model<TF>::exec()
 
                     // In case the simulation is done, step out of the loop.
                     if (timeloop->is_finished())
+                    {
+                        exec_finished = true;
                         break;
+                    }
 
                     // Load the data from disk.
                     const int iotime = timeloop->get_iotime();
@@ -571,10 +966,35 @@ void Model<TF>::exec()
                     fields->reset_tendencies();
                 }
 
+                // Free the tmp fields that only a burst of borrows in this step needed.
+                if (!timeloop->in_substep())
+                    fields->trim_tmp();
+
+                // In library mode, return to the caller after the requested number of time steps.
+                if (nsteps > 0 && !timeloop->in_substep() && ++nsteps_done == nsteps)
+                    break;
+
             } // End time loop.
+
+            // The caller may access the fields, such that the output tasks have to be done.
+            #pragma omp taskwait
         } // End OpenMP master region.
     } // End OpenMP parallel region.
 
+    return !exec_finished;
+}
+
+template<typename TF>
+void Model<TF>::finish_exec()
+{
+    if (!exec_started)
+        return;
+
+    // Write the last statistics in case they are still pending.
+    stats->finish_exec();
+    fields->save_finish();
+    io_server->finish();
+
     #ifdef USECUDA
     // At the end of the run, copy the data back from the GPU.
     fields  ->backward_device();
@@ -583,6 +1003,17 @@ void Model<TF>::exec()
 
     clear_gpu();
     #endif
+
+    // The totals of the hardware counters over the run.
+    timer->finish();
+
+    // The tmp fields that were added during the run count in the peak memory.
+    memory->print_peak(
+            fields->get_ntmp(), fields->get_ntmp_g(),
+            fields->get_ntmp_peak(), fields->get_ntmp_peak_g());
+
+    // Summarize the communication of the run, if enabled with swcommstats.
+    master.print_comm_stats();
 }
 
 #ifdef USECUDA
@@ -590,23 +1021,32 @@ template<typename TF>
 void Model<TF>::prepare_gpu()
 {
     // Load all the necessary data to the GPU.
+    Nvtx_range range("prepare_gpu");
     master.print_message("Preparing the GPU\n");
-    grid     ->prepare_device();
-    soil_grid->prepare_device();
-    fields   ->prepare_device();
-    buffer   ->prepare_device();
-    thermo   ->prepare_device();
-    boundary ->prepare_device(*thermo);
-    diff     ->prepare_device(*boundary);
-    force    ->prepare_device();
-    ib       ->prepare_device();
-    microphys->prepare_device();
-    radiation->prepare_device();
-    windfarm ->prepare_device();
-    column   ->prepare_device();
-    aerosol  ->prepare_device();
+    cuda_enable_memory_pool(swcudamempool);
+    cuda_enable_managed_memory(swcudamanaged);
+
+    memory->track("grid", [&]{ grid->prepare_device(); });
+    memory->track("soil_grid", [&]{ soil_grid->prepare_device(); });
+    memory->track("fields", [&]{ fields->prepare_device(); });
+    memory->track("buffer", [&]{ buffer->prepare_device(); });
+    memory->track("thermo", [&]{ thermo->prepare_device(); });
+    memory->track("boundary", [&]{ boundary->prepare_device(*thermo); });
+    memory->track("diff", [&]{ diff->prepare_device(*boundary); });
+    memory->track("force", [&]{ force->prepare_device(); });
+    memory->track("ib", [&]{ ib->prepare_device(); });
+    memory->track("microphys", [&]{ microphys->prepare_device(); });
+    memory->track("radiation", [&]{ radiation->prepare_device(); });
+    memory->track("windfarm", [&]{ windfarm->prepare_device(); });
+    memory->track("particles", [&]{ particles->prepare_device(); });
+    memory->track("column", [&]{ column->prepare_device(); });
+    memory->track("aerosol", [&]{ aerosol->prepare_device(); });
+    memory->track("stats", [&]{ stats->prepare_device(); });
     // Prepare pressure last, for memory check
-    pres     ->prepare_device();
+    memory->track("pres", [&]{ pres->prepare_device(); });
+
+    const cuda_memory_usage usage = cuda_get_memory_usage();
+    master.print_message("Device memory allocated = %zu bytes\n", usage.current);
 }
 
 template<typename TF>
@@ -624,8 +1064,12 @@ void Model<TF>::clear_gpu()
     microphys->clear_device();
     radiation->clear_device();
     windfarm ->clear_device();
+    particles->clear_device();
     column   ->clear_device();
     aerosol  ->clear_device();
+    stats    ->clear_device();
+    cuda_graph->clear();
+    Cuda_streams::clear_pool();
 
     // Clear pressure last, for memory check
     pres     ->clear_device();
@@ -639,42 +1083,53 @@ void Model<TF>::calculate_statistics(int iteration, double time, unsigned long i
     // Do the statistics.
     if (stats->do_statistics(itime))
     {
+        Nvtx_range range("statistics");
         master.print_message("Saving statistics for time %f\n", time);
 
         // Calculate statistics
         if (!stats->do_tendency())
             calc_masks();
 
-        grid     ->exec_stats(*stats);
-        fields   ->exec_stats(*stats);
-        thermo   ->exec_stats(*stats);
-        background ->exec_stats(*stats);
-        microphys->exec_stats(*stats, *thermo, dt);
-        diff     ->exec_stats(*stats, *thermo);
-        budget   ->exec_stats(*stats);
-        boundary ->exec_stats(*stats);
+        { Nvtx_range range("grid::exec_stats"); grid     ->exec_stats(*stats); }
+        { Nvtx_range range("fields::exec_stats"); fields   ->exec_stats(*stats); }
+        { Nvtx_range range("thermo::exec_stats"); thermo   ->exec_stats(*stats); }
+        { Nvtx_range range("background::exec_stats"); background ->exec_stats(*stats); }
+        { Nvtx_range range("microphys::exec_stats"); microphys->exec_stats(*stats, *thermo, dt); }
+        { Nvtx_range range("diff::exec_stats"); diff     ->exec_stats(*stats, *thermo); }
+        { Nvtx_range range("budget::exec_stats"); budget   ->exec_stats(*stats); }
+        { Nvtx_range range("boundary::exec_stats"); boundary ->exec_stats(*stats); }
+        { Nvtx_range range("spectra::exec_stats"); spectra  ->exec_stats(*stats); }
+
+        if (objects->do_objects(itime))
+            objects->exec(*stats, time);
     }
 
     // Save the selected cross sections to disk, cross sections are handled on CPU.
     if (cross->do_cross(itime))
     {
+        Nvtx_range range("cross");
         master.print_message("Saving cross-sections for time %f\n", time);
 
-        fields   ->exec_cross(*cross, iotime);
-        thermo   ->exec_cross(*cross, iotime);
-        microphys->exec_cross(*cross, iotime);
-        ib       ->exec_cross(*cross, iotime);
-        boundary ->exec_cross(*cross, iotime);
+        { Nvtx_range range("fields::exec_cross"); fields   ->exec_cross(*cross, iotime); }
+        { Nvtx_range range("thermo::exec_cross"); thermo   ->exec_cross(*cross, iotime); }
+        { Nvtx_range range("microphys::exec_cross"); microphys->exec_cross(*cross, iotime); }
+        { Nvtx_range range("ib::exec_cross"); ib       ->exec_cross(*cross, iotime); }
+        { Nvtx_range range("boundary::exec_cross"); boundary ->exec_cross(*cross, iotime); }
+
+        cross    ->flush();
     }
 
     // Save the 3d dumps to disk.
     if (dump->do_dump(itime, idt))
     {
+        Nvtx_range range("dump");
         master.print_message("Saving field dumps for time %f\n", time);
 
         fields   ->exec_dump(*dump, iotime);
         thermo   ->exec_dump(*dump, iotime);
         microphys->exec_dump(*dump, iotime);
+
+        dump     ->flush();
     }
 
     if (stats->do_statistics(itime))
@@ -692,10 +1147,14 @@ void Model<TF>::setup_stats()
 
     if (stats->do_statistics(timeloop->get_itime()) && timeloop->is_stats_step())
     {
+        // The masks are about to change, so pending statistics have to be written first.
+        stats->finish_exec();
+
         #ifdef USECUDA
         if (!cpu_up_to_date)
         {
             #pragma omp taskwait
+            Nvtx_range range("backward_device");
             cpu_up_to_date = true;
             fields   ->backward_device();
             boundary ->backward_device(*thermo);
@@ -775,18 +1234,40 @@ void Model<TF>::set_time_step()
     if (timeloop->in_substep())
         return;
 
+    const unsigned long idt = timeloop->get_idt();
+    const double dt = timeloop->get_dt();
+
+    // Evaluate the CFL, diffusion and sedimentation CFL numbers of this process,
+    // and reduce them over all processes in a single call.
+    std::array<double, 3> stability = {
+            advec    ->get_cfl_local(dt),
+            diff     ->get_dn_local(dt),
+            microphys->get_sedimentation_cfl_local(dt)};
+    master.max(stability.data(), stability.size());
+
+    // The numbers scale with the time step, which allows print_status() to reuse them.
+    has_stability = true;
+    stability_itime = timeloop->get_itime();
+    cfl_per_dt = stability[0] / dt;
+    dn_per_dt = stability[1] / dt;
+
     // Retrieve the maximum allowed time step per class.
     timeloop->set_time_step_limit();
-    timeloop->set_time_step_limit(advec        ->get_time_limit(timeloop->get_idt(), timeloop->get_dt()));
-    timeloop->set_time_step_limit(diff         ->get_time_limit(timeloop->get_idt(), timeloop->get_dt()));
-    timeloop->set_time_step_limit(thermo       ->get_time_limit(timeloop->get_idt(), timeloop->get_dt()));
-    timeloop->set_time_step_limit(microphys    ->get_time_limit(timeloop->get_idt(), timeloop->get_dt()));
+    timeloop->set_time_step_limit(advec        ->get_time_limit_from_cfl(idt, stability[0]));
+    // The slow scalars are diffused with a time step of slowsteps time steps.
+    timeloop->set_time_step_limit(diff         ->get_time_limit_from_dn(idt, dt, stability[1] * fields->get_slow_steps_max()));
+    timeloop->set_time_step_limit(thermo       ->get_time_limit(idt, dt));
+    timeloop->set_time_step_limit(microphys    ->get_time_limit_from_cfl(idt, dt, stability[2]));
     timeloop->set_time_step_limit(radiation    ->get_time_limit(timeloop->get_itime()));
     timeloop->set_time_step_limit(stats        ->get_time_limit(timeloop->get_itime()));
     timeloop->set_time_step_limit(cross        ->get_time_limit(timeloop->get_itime()));
     timeloop->set_time_step_limit(dump         ->get_time_limit(timeloop->get_itime()));
+    timeloop->set_time_step_limit(dump_average ->get_time_limit(timeloop->get_itime()));
+    timeloop->set_time_step_limit(quicklook    ->get_time_limit(timeloop->get_itime()));
     timeloop->set_time_step_limit(column       ->get_time_limit(timeloop->get_itime()));
+    timeloop->set_time_step_limit(objects      ->get_time_limit(timeloop->get_itime()));
     timeloop->set_time_step_limit(particle_bin->get_time_limit());
+    timeloop->set_time_step_limit(particles    ->get_time_limit(timeloop->get_itime()));
 
     // Set the time step.
     timeloop->set_time_step();
@@ -840,8 +1321,8 @@ void Model<TF>::print_status()
             dnsout = std::fopen(outputname.c_str(), "a");
             std::setvbuf(dnsout, NULL, _IOLBF, 1024);
             std::fprintf(
-                    dnsout, "%8s %13s %10s %11s %8s %8s %11s %16s %16s %16s\n",
-                    "ITER", "TIME", "CPUDT", "DT", "CFL", "DNUM", "DIV", "MOM", "TKE", "MASS");
+                    dnsout, "%8s %13s %10s %11s %8s %8s %11s %16s %16s %16s %11s\n",
+                    "ITER", "TIME", "CPUDT", "DT", "CFL", "DNUM", "DIV", "MOM", "TKE", "MASS", "ETA");
         }
         first = false;
     }
@@ -858,16 +1339,28 @@ void Model<TF>::print_status()
         boundary->set_ghost_cells_w(Boundary_w_type::Conservation_type);
         const TF div = pres->check_divergence();
         boundary->set_ghost_cells_w(Boundary_w_type::Normal_type);
-        TF mom  = fields->check_momentum();
-        TF tke  = fields->check_tke();
-        TF mass = fields->check_mass();
-        TF cfl  = advec->get_cfl(timeloop->get_dt());
-        TF dn   = diff->get_dn(timeloop->get_dt());
+        TF mom, tke, mass;
+        fields->check_conservation(mom, tke, mass);
+
+        // Reuse the numbers of set_time_step() if the fields have not changed since.
+        TF cfl, dn;
+        if (has_stability && stability_itime == timeloop->get_itime() && timeloop->get_substep() == 0)
+        {
+            cfl = cfl_per_dt*dt;
+            dn  = dn_per_dt*dt;
+        }
+        else
+        {
+            cfl = advec->get_cfl(dt);
+            dn  = diff->get_dn(dt);
+        }
 
         if (master.get_mpiid() == 0)
         {
-            std::fprintf(dnsout, "%8d %13.6G %10.4f %11.3E %8.4f %8.4f %11.3E %16.8E %16.8E %16.8E\n",
-                    iter, time, cputime, dt, cfl, dn, div, mom, tke, mass);
+            // The projected wall clock time (s) to the end time, from the measured time per step.
+            const double eta = timeloop->get_wall_time_remaining();
+            std::fprintf(dnsout, "%8d %13.6G %10.4f %11.3E %8.4f %8.4f %11.3E %16.8E %16.8E %16.8E %11.3E\n",
+                    iter, time, cputime, dt, cfl, dn, div, mom, tke, mass, eta);
             std::fflush(dnsout);
         }
 
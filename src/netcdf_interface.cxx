@@ -27,6 +27,10 @@
 #include <tuple>
 #include <netcdf.h>
 
+#ifdef USEMPI
+#include <netcdf_par.h>
+#endif
+
 #include "netcdf_interface.h"
 #include "master.h"
 
@@ -144,14 +148,34 @@ namespace
     }
 }
 
-Netcdf_file::Netcdf_file(Master& master, const std::string& name, Netcdf_mode mode, const int mpiid_to_write_in) :
+Netcdf_file::Netcdf_file(
+        Master& master, const std::string& name, Netcdf_mode mode,
+        const int mpiid_to_write_in, const bool parallel_in) :
     Netcdf_handle(master)
 {
     parent = nullptr;
     mpiid_to_write = mpiid_to_write_in;
     int nc_check_code = 0;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    // In parallel mode all processes open the file and take part in every call.
+    #ifdef USEMPI
+    parallel = parallel_in;
+    #endif
+
+    if (parallel)
+    {
+        #ifdef USEMPI
+        auto& md = master.get_MPI_data();
+
+        if (mode == Netcdf_mode::Create)
+            nc_check_code = nc_create_par(name.c_str(), NC_NOCLOBBER | NC_NETCDF4, md.commxy, MPI_INFO_NULL, &ncid);
+        else if (mode == Netcdf_mode::Write)
+            nc_check_code = nc_open_par(name.c_str(), NC_WRITE | NC_NETCDF4, md.commxy, MPI_INFO_NULL, &ncid);
+        else if (mode == Netcdf_mode::Read)
+            nc_check_code = nc_open_par(name.c_str(), NC_NOWRITE, md.commxy, MPI_INFO_NULL, &ncid);
+        #endif
+    }
+    else if (is_writer())
     {
         if (mode == Netcdf_mode::Create)
             nc_check_code = nc_create(name.c_str(), NC_NOCLOBBER | NC_NETCDF4, &ncid);
@@ -173,7 +197,7 @@ Netcdf_file::Netcdf_file(Master& master, const std::string& name, Netcdf_mode mo
 
     root_ncid = ncid;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
     {
         if (mode == Netcdf_mode::Create)
             nc_check_code =  nc_enddef(root_ncid);
@@ -186,18 +210,18 @@ Netcdf_file::~Netcdf_file()
 {
     int nc_check_code = 0;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_close(ncid);
-    nc_check(master, nc_check_code, mpiid_to_write);
+    check_deferred_error(nc_check_code);
 }
 
 void Netcdf_file::sync()
 {
     int nc_check_code = 0;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_sync(ncid);
-    nc_check(master, nc_check_code, mpiid_to_write);
+    check_deferred_error(nc_check_code);
 }
 
 int Netcdf_file::get_dim_id(const std::string& name)
@@ -209,14 +233,14 @@ void Netcdf_handle::add_dimension(const std::string& dim_name, const int dim_siz
 {
     int nc_check_code = 0;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_redef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
     int dim_id;
     int def_out;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         def_out = nc_def_dim(ncid, dim_name.c_str(), dim_size, &dim_id);
 
     master.broadcast(&def_out, 1, mpiid_to_write);
@@ -230,7 +254,7 @@ void Netcdf_handle::add_dimension(const std::string& dim_name, const int dim_siz
     else
         nc_throw(def_out);
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_enddef(root_ncid);
 
     nc_check(master, nc_check_code, mpiid_to_write);
@@ -239,14 +263,15 @@ void Netcdf_handle::add_dimension(const std::string& dim_name, const int dim_siz
 template<typename T>
 Netcdf_variable<T> Netcdf_handle::add_variable(
         const std::string& var_name,
-        const std::vector<std::string>& dim_names)
+        const std::vector<std::string>& dim_names,
+        const std::vector<int>& chunk_sizes)
 {
     int nc_check_code = 0;
 
     int var_id = -1;
     std::vector<int> dim_sizes;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_redef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
@@ -260,11 +285,24 @@ Netcdf_variable<T> Netcdf_handle::add_variable(
         dim_ids.push_back(dim_id);
     }
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_def_var(ncid, var_name.c_str(), netcdf_dtype<T>(), ndims, dim_ids.data(), &var_id);
     nc_check(master, nc_check_code, mpiid_to_write);
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer() && !chunk_sizes.empty())
+    {
+        const std::vector<size_t> chunk_sizes_size_t(chunk_sizes.begin(), chunk_sizes.end());
+        nc_check_code = nc_def_var_chunking(ncid, var_id, NC_CHUNKED, chunk_sizes_size_t.data());
+    }
+    nc_check(master, nc_check_code, mpiid_to_write);
+
+    #ifdef USEMPI
+    if (parallel)
+        nc_check_code = nc_var_par_access(ncid, var_id, NC_COLLECTIVE);
+    nc_check(master, nc_check_code, mpiid_to_write);
+    #endif
+
+    if (is_writer())
         nc_check_code = nc_enddef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
@@ -278,7 +316,7 @@ Netcdf_variable<T> Netcdf_handle::add_variable(
 
         size_t dim_len = 0;
 
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_dimlen(ncid, dim_id, &dim_len);
         nc_check(master, nc_check_code, mpiid_to_write);
 
@@ -300,9 +338,36 @@ Netcdf_variable<T> Netcdf_handle::add_variable(
 }
 
 Netcdf_handle::Netcdf_handle(Master& master) :
-    master(master), record_counter(0)
+    master(master), parallel(false), record_counter(0), deferred_error(NC_NOERR)
 {}
 
+bool Netcdf_handle::is_writer() const
+{
+    return parallel || master.get_mpiid() == mpiid_to_write;
+}
+
+// The puts of a record do not broadcast their return value one by one. The writer keeps the
+// first error in the file, and sync() or the closing of the file shares it with all processes.
+void Netcdf_handle::defer_error(const int return_value)
+{
+    Netcdf_handle* root = this;
+    while (root->parent != nullptr)
+        root = root->parent;
+
+    if (root->deferred_error == NC_NOERR)
+        root->deferred_error = return_value;
+}
+
+// Check the return value of a call on the file together with the deferred errors.
+void Netcdf_handle::check_deferred_error(int return_value)
+{
+    if (deferred_error != NC_NOERR)
+        return_value = deferred_error;
+    deferred_error = NC_NOERR;
+
+    nc_check(master, return_value, mpiid_to_write);
+}
+
 template<typename T>
 void Netcdf_handle::insert(
         const std::vector<T>& values,
@@ -316,9 +381,9 @@ void Netcdf_handle::insert(
     int nc_check_code = 0;
 
     // CvH: Add proper size checking.
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_put_vara_wrapper<T>(ncid, var_id, i_start_size_t, i_count_size_t, values);
-    nc_check(master, nc_check_code, mpiid_to_write);
+    defer_error(nc_check_code);
 }
 
 template<typename T>
@@ -334,9 +399,9 @@ void Netcdf_handle::insert(
     int nc_check_code = 0;
 
     // CvH: Add proper size checking.
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_put_vara_wrapper<T>(ncid, var_id, i_start_size_t, i_count_size_t, value);
-    nc_check(master, nc_check_code, mpiid_to_write);
+    defer_error(nc_check_code);
 }
 
 void Netcdf_handle::add_attribute(
@@ -346,16 +411,16 @@ void Netcdf_handle::add_attribute(
 {
     int nc_check_code = 0;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_redef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
     // CvH what if string is too long?
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_put_att_text(ncid, var_id, name.c_str(), value.size(), value.c_str());
     nc_check(master, nc_check_code, mpiid_to_write);
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_enddef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 }
@@ -367,16 +432,16 @@ void Netcdf_handle::add_attribute(
 {
     int nc_check_code = 0;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_redef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
     // CvH what if string is too long?
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_put_att_double(ncid, var_id, name.c_str(), NC_DOUBLE, 1, &value);
     nc_check(master, nc_check_code, mpiid_to_write);
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_enddef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 }
@@ -388,16 +453,16 @@ void Netcdf_handle::add_attribute(
 {
     int nc_check_code = 0;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_redef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
     // CvH what if string is too long?
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_put_att_float(ncid, var_id, name.c_str(), NC_FLOAT, 1, &value);
     nc_check(master, nc_check_code, mpiid_to_write);
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_enddef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 }
@@ -407,15 +472,15 @@ Netcdf_group& Netcdf_handle::add_group(const std::string& name)
     int group_ncid = -1;
     int nc_check_code = 0;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_redef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_def_grp(ncid, name.c_str(), &group_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_enddef(root_ncid);
     nc_check(master, nc_check_code, mpiid_to_write);
 
@@ -435,7 +500,7 @@ Netcdf_group& Netcdf_handle::get_group(const std::string& name)
         int group_ncid = -1;
         int nc_check_code = 0;
 
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_ncid(ncid, name.c_str(), &group_ncid);
         nc_check(master, nc_check_code, mpiid_to_write);
 
@@ -453,12 +518,12 @@ int Netcdf_handle::get_dimension_size(const std::string& name)
     int nc_check_code = 0;
     int dim_id;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_inq_dimid(ncid, name.c_str(), &dim_id);
     nc_check(master, nc_check_code, mpiid_to_write);
 
     size_t dim_len_size_t = 0;
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_inq_dimlen(ncid, dim_id, &dim_len_size_t);
     nc_check(master, nc_check_code, mpiid_to_write);
 
@@ -473,7 +538,7 @@ std::map<std::string, int> Netcdf_handle::get_variable_dimensions(const std::str
     int nc_check_code = 0;
     int var_id;
 
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_inq_varid(ncid, name.c_str(), &var_id);
     nc_check(master, nc_check_code, mpiid_to_write);
 
@@ -482,7 +547,7 @@ std::map<std::string, int> Netcdf_handle::get_variable_dimensions(const std::str
 
     try
     {
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_var(ncid, var_id, NULL, NULL, &ndims, dimids, NULL);
         nc_check(master, nc_check_code, mpiid_to_write);
     }
@@ -495,24 +560,30 @@ std::map<std::string, int> Netcdf_handle::get_variable_dimensions(const std::str
     // Broadcast ndims
     master.broadcast(&ndims, 1, mpiid_to_write);
 
-    std::map<std::string, int> dims;
+    // The lengths and the names of all dimensions are gathered first, such that
+    // they can be sent in two broadcasts, rather than two per dimension.
+    std::vector<int> dim_lengths(ndims);
+    std::vector<char> dim_names(ndims*(NC_MAX_NAME+1), '\0');
 
-    for (int n=0; n<ndims; ++n)
+    if (is_writer())
     {
-        char dim_name[NC_MAX_NAME+1];
-        size_t dim_length_size_t;
-
-        nc_check_code = nc_inq_dim(ncid, dimids[n], dim_name, &dim_length_size_t);
-        nc_check(master, nc_check_code, mpiid_to_write);
-
-        int dim_length = dim_length_size_t;
-        master.broadcast(&dim_length, 1, mpiid_to_write);
+        for (int n=0; n<ndims; ++n)
+        {
+            size_t dim_length_size_t;
+            nc_check_code = nc_inq_dim(ncid, dimids[n], &dim_names[n*(NC_MAX_NAME+1)], &dim_length_size_t);
+            if (nc_check_code != NC_NOERR)
+                break;
+            dim_lengths[n] = dim_length_size_t;
+        }
+    }
+    nc_check(master, nc_check_code, mpiid_to_write);
 
-        // Broadcast the entire buffer to avoid broadcasting of length.
-        master.broadcast(dim_name, NC_MAX_NAME+1, mpiid_to_write);
+    master.broadcast(dim_lengths.data(), ndims, mpiid_to_write);
+    master.broadcast(dim_names.data(), ndims*(NC_MAX_NAME+1), mpiid_to_write);
 
-        dims.emplace(std::string(dim_name), dim_length);
-    }
+    std::map<std::string, int> dims;
+    for (int n=0; n<ndims; ++n)
+        dims.emplace(std::string(&dim_names[n*(NC_MAX_NAME+1)]), dim_lengths[n]);
 
     return dims;
 }
@@ -524,7 +595,7 @@ bool Netcdf_handle::dimension_exists(const std::string& name)
 
     try
     {
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_dimid(ncid, name.c_str(), &dim_id);
         nc_check(master, nc_check_code, mpiid_to_write);
     }
@@ -543,7 +614,7 @@ bool Netcdf_handle::variable_exists(const std::string& name)
 
     try
     {
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_varid(ncid, name.c_str(), &var_id);
         nc_check(master, nc_check_code, mpiid_to_write);
     }
@@ -563,7 +634,7 @@ bool Netcdf_handle::group_exists(const std::string& name)
 
     try
     {
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_grp_ncid(ncid, name.c_str(), &grp_id);
         nc_check(master, nc_check_code, mpiid_to_write);
     }
@@ -584,7 +655,7 @@ TF Netcdf_handle::get_variable(
 
     try
     {
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_varid(ncid, name.c_str(), &var_id);
         nc_check(master, nc_check_code, mpiid_to_write);
     }
@@ -620,7 +691,7 @@ std::vector<TF> Netcdf_handle::get_variable(
 
     try
     {
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_varid(ncid, name.c_str(), &var_id);
         nc_check(master, nc_check_code, mpiid_to_write);
     }
@@ -635,7 +706,7 @@ std::vector<TF> Netcdf_handle::get_variable(
     // CvH check needs to be added if total count matches multiplication of all dimensions.
 
     std::vector<TF> values(total_count);
-    if (master.get_mpiid() == mpiid_to_write)
+    if (is_writer())
         nc_check_code = nc_get_vara_wrapper(ncid, var_id, i_start_size_t, i_count_size_t, values);
     nc_check(master, nc_check_code, mpiid_to_write);
     master.broadcast(values.data(), total_count, mpiid_to_write);
@@ -659,7 +730,7 @@ void Netcdf_handle::get_variable(
     bool zero_fill = false;
     try
     {
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_inq_varid(ncid, name.c_str(), &var_id);
         nc_check(master, nc_check_code, mpiid_to_write);
     }
@@ -684,7 +755,7 @@ void Netcdf_handle::get_variable(
     }
     else
     {
-        if (master.get_mpiid() == mpiid_to_write)
+        if (is_writer())
             nc_check_code = nc_get_vara_wrapper(ncid, var_id, i_start_size_t, i_count_size_t, values);
         nc_check(master, nc_check_code, mpiid_to_write);
         master.broadcast(values.data(), total_count, mpiid_to_write);
@@ -697,6 +768,7 @@ Netcdf_group::Netcdf_group(
     Netcdf_handle(master)
 {
     parent = parent_in;
+    parallel = parent_in->is_parallel();
     mpiid_to_write = mpiid_to_write_in;
     ncid = ncid_in;
     root_ncid = root_ncid_in;
@@ -784,6 +856,6 @@ template void Netcdf_handle::insert<double>(const double, const int, const std::
 template void Netcdf_handle::insert<float> (const float,  const int, const std::vector<int>&, const std::vector<int>&);
 template void Netcdf_handle::insert<int>   (const int,    const int, const std::vector<int>&, const std::vector<int>&);
 
-template Netcdf_variable<double> Netcdf_handle::add_variable<double> (const std::string&, const std::vector<std::string>&);
-template Netcdf_variable<float>  Netcdf_handle::add_variable<float>  (const std::string&, const std::vector<std::string>&);
-template Netcdf_variable<int>    Netcdf_handle::add_variable<int>    (const std::string&, const std::vector<std::string>&);
+template Netcdf_variable<double> Netcdf_handle::add_variable<double> (const std::string&, const std::vector<std::string>&, const std::vector<int>&);
+template Netcdf_variable<float>  Netcdf_handle::add_variable<float>  (const std::string&, const std::vector<std::string>&, const std::vector<int>&);
+template Netcdf_variable<int>    Netcdf_handle::add_variable<int>    (const std::string&, const std::vector<std::string>&, const std::vector<int>&);
@@ -0,0 +1,546 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "stats.h"
+#include "objects.h"
+#include "timeloop.h"
+#include "netcdf_interface.h"
+#include "constants.h"
+
+namespace
+{
+    int find_root(std::vector<int>& parent, int n)
+    {
+        while (parent[n] != n)
+        {
+            parent[n] = parent[parent[n]];
+            n = parent[n];
+        }
+        return n;
+    }
+
+    void join(std::vector<int>& parent, const int n1, const int n2)
+    {
+        const int r1 = find_root(parent, n1);
+        const int r2 = find_root(parent, n2);
+        if (r1 != r2)
+            parent[std::max(r1, r2)] = std::min(r1, r2);
+    }
+
+    // Collect the values of all processes on the process that writes.
+    void gather_to_root(std::vector<double>& all, const std::vector<double>& local, const Master& master)
+    {
+        #ifdef USEMPI
+        auto& md = master.get_MPI_data();
+
+        int nlocal = local.size();
+        std::vector<int> counts(md.nprocs);
+        MPI_Gather(&nlocal, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, md.commxy);
+
+        std::vector<int> displs(md.nprocs, 0);
+        for (int n=1; n<md.nprocs; ++n)
+            displs[n] = displs[n-1] + counts[n-1];
+
+        all.resize(md.mpiid == 0 ? displs[md.nprocs-1] + counts[md.nprocs-1] : 0);
+        MPI_Gatherv(
+                local.data(), nlocal, MPI_DOUBLE,
+                all.data(), counts.data(), displs.data(), MPI_DOUBLE, 0, md.commxy);
+        #else
+        all = local;
+        #endif
+    }
+}
+
+template<typename TF>
+Objects<TF>::Objects(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& inputin) :
+    master(masterin), grid(gridin), fields(fieldsin),
+    boundary_cyclic(master, grid)
+{
+    swobjects = inputin.get_item<bool>("objects", "swobjects", "", false);
+
+    if (swobjects)
+    {
+        sampletime = inputin.get_item<double>("objects", "sampletime", "");
+        masklist = inputin.get_list<std::string>("objects", "masklist", "", std::vector<std::string>());
+        nmin = inputin.get_item<int>("objects", "nmin", "", 1);
+
+        if (masklist.empty())
+            throw std::runtime_error("Empty [objects][masklist]");
+    }
+    else
+    {
+        inputin.flag_as_used("objects", "sampletime", "");
+        inputin.flag_as_used("objects", "masklist", "");
+    }
+}
+
+template<typename TF>
+Objects<TF>::~Objects()
+{
+}
+
+template<typename TF>
+void Objects<TF>::init()
+{
+    if (!swobjects)
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    isampletime = convert_to_itime(sampletime);
+    isampleoffset = 0;
+
+    // The global index of each grid point, starting at 1, is used as label.
+    if (static_cast<double>(gd.itot)*gd.jtot*gd.ktot >= static_cast<double>(UINT_MAX))
+        throw std::runtime_error("The grid is too large for the object labels");
+
+    boundary_cyclic.init();
+
+    for (auto& name : masklist)
+    {
+        Object_mask& om = object_masks[name];
+        om.labels.resize(gd.ncells);
+        om.labels_prev.resize(gd.ncells);
+        om.ntracks = 0;
+        om.has_prev = false;
+        om.nrecords = 0;
+    }
+}
+
+template<typename TF>
+void Objects<TF>::create(const Timeloop<TF>& timeloop, Stats<TF>& stats, const std::string& sim_name)
+{
+    if (!swobjects)
+        return;
+
+    // The objects are labelled from the masks of the statistics, sampled at the same times.
+    if (!stats.get_switch() || isampletime % convert_to_itime(stats.get_sampletime()) != 0)
+        throw std::runtime_error("The objects sampletime has to be a multiple of the statistics sampletime");
+    isampleoffset = stats.get_isampleoffset();
+
+    for (auto& name : masklist)
+    {
+        if (stats.get_masks().find(name) == stats.get_masks().end())
+            throw std::runtime_error("Objects mask \"" + name + "\" is not in [stats][masklist]");
+
+        Object_mask& om = object_masks.at(name);
+
+        std::stringstream filename;
+        filename << sim_name << "." << "objects" << "." << name << "."
+                 << std::setfill('0') << std::setw(7) << timeloop.get_iotime() << ".nc";
+
+        om.data_file = std::make_unique<Netcdf_file>(master, filename.str(), Netcdf_mode::Create);
+
+        // All objects of all times are appended along a single dimension.
+        om.data_file->add_dimension("object");
+
+        auto add_var = [&](const std::string& var_name, const std::string& units, const std::string& long_name)
+        {
+            om.vars[var_name] = std::make_unique<Netcdf_variable<TF>>(
+                    om.data_file->template add_variable<TF>(var_name, {"object"}));
+            om.vars[var_name]->add_attribute("units", units);
+            om.vars[var_name]->add_attribute("long_name", long_name);
+        };
+
+        add_var("time", timeloop.has_utc_time() ? "seconds since " + timeloop.get_datetime_utc_start_string() : "seconds since start", "Time");
+        add_var("lifetime", "s", "Time since the start of the track");
+        add_var("npoints", "-", "Number of grid points");
+        add_var("volume", "m3", "Volume");
+        add_var("base", "m", "Height of the base");
+        add_var("top", "m", "Height of the top");
+        add_var("mass_flux", "kg s-1", "Vertically averaged mass flux");
+
+        om.track_var = std::make_unique<Netcdf_variable<int>>(
+                om.data_file->template add_variable<int>("track", {"object"}));
+        om.track_var->add_attribute("units", "-");
+        om.track_var->add_attribute("long_name", "Track number");
+
+        om.data_file->sync();
+    }
+}
+
+template<typename TF>
+unsigned long Objects<TF>::get_time_limit(unsigned long itime)
+{
+    if (!swobjects)
+        return Constants::ulhuge;
+
+    return get_sample_time_limit(itime, isampletime, isampleoffset);
+}
+
+template<typename TF>
+bool Objects<TF>::do_objects(unsigned long itime)
+{
+    if (!swobjects)
+        return false;
+
+    return is_sample_time(itime, isampletime, isampleoffset);
+}
+
+template<typename TF>
+void Objects<TF>::label_objects(
+        std::vector<unsigned int>& labels, const std::vector<unsigned int>& mfield, const unsigned int flag)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int ii = 1;
+    const int jj = gd.icells;
+    const int kk = gd.ijcells;
+
+    std::fill(labels.begin(), labels.end(), 0u);
+    std::vector<int> parent(gd.ncells, -1);
+
+    for (int k=gd.kstart; k<gd.kend; ++k)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*jj + k*kk;
+                if (mfield[ijk] & flag)
+                {
+                    const unsigned int i_g = i-gd.istart + md.mpicoordx*gd.imax;
+                    const unsigned int j_g = j-gd.jstart + md.mpicoordy*gd.jmax;
+                    const unsigned int k_g = k-gd.kstart;
+                    labels[ijk] = 1 + i_g + j_g*gd.itot + k_g*gd.itot*gd.jtot;
+                    parent[ijk] = ijk;
+                }
+            }
+
+    // Connect the face neighbours within the process with a union-find.
+    for (int k=gd.kstart; k<gd.kend; ++k)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*jj + k*kk;
+                if (parent[ijk] < 0)
+                    continue;
+
+                if (i > gd.istart && parent[ijk-ii] >= 0)
+                    join(parent, ijk, ijk-ii);
+                if (j > gd.jstart && parent[ijk-jj] >= 0)
+                    join(parent, ijk, ijk-jj);
+                if (k > gd.kstart && parent[ijk-kk] >= 0)
+                    join(parent, ijk, ijk-kk);
+            }
+
+    // Propagate the smallest label of each local component over the process boundaries,
+    // until the objects that span several processes have a single label.
+    std::vector<unsigned int> comp_min(gd.ncells);
+
+    while (true)
+    {
+        boundary_cyclic.exec(labels.data());
+
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    if (parent[ijk] == ijk)
+                        comp_min[ijk] = UINT_MAX;
+                }
+
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    if (parent[ijk] < 0)
+                        continue;
+
+                    const int r = find_root(parent, ijk);
+                    unsigned int label_min = labels[ijk];
+
+                    auto check_ghost = [&](const int ijk_ghost)
+                    {
+                        if (labels[ijk_ghost] > 0)
+                            label_min = std::min(label_min, labels[ijk_ghost]);
+                    };
+
+                    if (i == gd.istart)
+                        check_ghost(ijk-ii);
+                    if (i == gd.iend-1)
+                        check_ghost(ijk+ii);
+                    if (j == gd.jstart)
+                        check_ghost(ijk-jj);
+                    if (j == gd.jend-1)
+                        check_ghost(ijk+jj);
+
+                    comp_min[r] = std::min(comp_min[r], label_min);
+                }
+
+        int nchanged = 0;
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    if (parent[ijk] < 0)
+                        continue;
+
+                    const unsigned int label_new = comp_min[find_root(parent, ijk)];
+                    if (label_new < labels[ijk])
+                    {
+                        labels[ijk] = label_new;
+                        ++nchanged;
+                    }
+                }
+
+        master.sum(&nchanged, 1);
+        if (nchanged == 0)
+            break;
+    }
+}
+
+template<typename TF>
+void Objects<TF>::calc_objects(std::map<unsigned int, Object>& objects, const std::vector<unsigned int>& labels)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const TF* const restrict w = fields.mp.at("w")->fld.data();
+    const int kk = gd.ijcells;
+
+    std::map<unsigned int, Object> objects_local;
+
+    for (int k=gd.kstart; k<gd.kend; ++k)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*gd.icells + k*kk;
+                if (labels[ijk] == 0)
+                    continue;
+
+                auto it = objects_local.find(labels[ijk]);
+                if (it == objects_local.end())
+                    it = objects_local.emplace(labels[ijk], Object{0., 0., Constants::dhuge, -Constants::dhuge, 0.}).first;
+
+                const double dv = gd.dx*gd.dy*gd.dz[k];
+                Object& obj = it->second;
+                obj.npoints += 1.;
+                obj.volume += dv;
+                obj.base = std::min(obj.base, static_cast<double>(gd.zh[k]));
+                obj.top = std::max(obj.top, static_cast<double>(gd.zh[k+1]));
+                obj.rhow += fields.rhoref[k]*TF(0.5)*(w[ijk] + w[ijk+kk])*dv;
+            }
+
+    // Merge the parts of the objects of all processes.
+    std::vector<double> local;
+    local.reserve(6*objects_local.size());
+    for (auto& it : objects_local)
+    {
+        local.push_back(it.first);
+        local.push_back(it.second.npoints);
+        local.push_back(it.second.volume);
+        local.push_back(it.second.base);
+        local.push_back(it.second.top);
+        local.push_back(it.second.rhow);
+    }
+
+    std::vector<double> all;
+    gather_to_root(all, local, master);
+
+    objects.clear();
+    if (md.mpiid != 0)
+        return;
+
+    for (size_t n=0; n<all.size(); n+=6)
+    {
+        const unsigned int label = static_cast<unsigned int>(all[n]);
+        auto it = objects.find(label);
+        if (it == objects.end())
+            objects.emplace(label, Object{all[n+1], all[n+2], all[n+3], all[n+4], all[n+5]});
+        else
+        {
+            it->second.npoints += all[n+1];
+            it->second.volume += all[n+2];
+            it->second.base = std::min(it->second.base, all[n+3]);
+            it->second.top = std::max(it->second.top, all[n+4]);
+            it->second.rhow += all[n+5];
+        }
+    }
+}
+
+template<typename TF>
+void Objects<TF>::calc_overlap(std::map<std::pair<unsigned int, unsigned int>, int>& overlap, const Object_mask& om)
+{
+    auto& gd = grid.get_grid_data();
+
+    std::map<std::pair<unsigned int, unsigned int>, int> overlap_local;
+
+    for (int k=gd.kstart; k<gd.kend; ++k)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*gd.icells + k*gd.ijcells;
+                if (om.labels[ijk] > 0 && om.labels_prev[ijk] > 0)
+                    ++overlap_local[std::make_pair(om.labels_prev[ijk], om.labels[ijk])];
+            }
+
+    std::vector<double> local;
+    local.reserve(3*overlap_local.size());
+    for (auto& it : overlap_local)
+    {
+        local.push_back(it.first.first);
+        local.push_back(it.first.second);
+        local.push_back(it.second);
+    }
+
+    std::vector<double> all;
+    gather_to_root(all, local, master);
+
+    overlap.clear();
+    for (size_t n=0; n<all.size(); n+=3)
+        overlap[std::make_pair(static_cast<unsigned int>(all[n]), static_cast<unsigned int>(all[n+1]))]
+            += static_cast<int>(all[n+2]);
+}
+
+template<typename TF>
+void Objects<TF>::track_objects(
+        Object_mask& om, const std::map<unsigned int, Object>& objects,
+        const std::map<std::pair<unsigned int, unsigned int>, int>& overlap, const double time)
+{
+    // Each object continues the track of the previous object with which it overlaps most,
+    // unless that track is already continued by an object with a larger overlap.
+    std::vector<std::tuple<int, unsigned int, unsigned int>> candidates;
+    for (auto& it : overlap)
+        candidates.emplace_back(it.second, it.first.first, it.first.second);
+
+    std::sort(candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) { return std::get<0>(a) > std::get<0>(b); });
+
+    std::map<unsigned int, int> tracks;
+    std::set<int> continued;
+
+    for (auto& c : candidates)
+    {
+        const unsigned int label = std::get<2>(c);
+        if (tracks.find(label) != tracks.end())
+            continue;
+
+        auto it = om.tracks_prev.find(std::get<1>(c));
+        if (it == om.tracks_prev.end() || continued.find(it->second) != continued.end())
+            continue;
+
+        tracks[label] = it->second;
+        continued.insert(it->second);
+    }
+
+    std::map<int, double> track_start;
+    for (auto& it : objects)
+    {
+        if (tracks.find(it.first) == tracks.end())
+        {
+            tracks[it.first] = om.ntracks;
+            om.track_start[om.ntracks] = time;
+            ++om.ntracks;
+        }
+        track_start[tracks[it.first]] = om.track_start.at(tracks[it.first]);
+    }
+
+    // Tracks that have not been continued have ended.
+    om.tracks_prev = tracks;
+    om.track_start = track_start;
+}
+
+template<typename TF>
+void Objects<TF>::exec(Stats<TF>& stats, const double time)
+{
+    if (!swobjects)
+        return;
+
+    auto& md = master.get_MPI_data();
+    const std::vector<unsigned int>& mfield = stats.get_mask_field();
+
+    for (auto& name : masklist)
+    {
+        Object_mask& om = object_masks.at(name);
+
+        label_objects(om.labels, mfield, stats.get_masks().at(name).flag);
+
+        std::map<unsigned int, Object> objects;
+        calc_objects(objects, om.labels);
+
+        std::map<std::pair<unsigned int, unsigned int>, int> overlap;
+        if (om.has_prev)
+            calc_overlap(overlap, om);
+
+        std::map<std::string, std::vector<TF>> values;
+        std::vector<int> track_values;
+
+        if (md.mpiid == 0)
+        {
+            track_objects(om, objects, overlap, time);
+
+            for (auto& it : objects)
+            {
+                const Object& obj = it.second;
+                if (obj.npoints < nmin)
+                    continue;
+
+                const int track = om.tracks_prev.at(it.first);
+                track_values.push_back(track);
+                values["time"].push_back(time);
+                values["lifetime"].push_back(time - om.track_start.at(track));
+                values["npoints"].push_back(obj.npoints);
+                values["volume"].push_back(obj.volume);
+                values["base"].push_back(obj.base);
+                values["top"].push_back(obj.top);
+                values["mass_flux"].push_back(obj.rhow / (obj.top - obj.base));
+            }
+        }
+
+        int nobjects = track_values.size();
+        master.broadcast(&nobjects, 1);
+
+        if (nobjects > 0)
+        {
+            for (auto& it : om.vars)
+                it.second->insert(values[it.first], {om.nrecords}, {nobjects});
+            om.track_var->insert(track_values, {om.nrecords}, {nobjects});
+
+            om.nrecords += nobjects;
+            om.data_file->sync();
+        }
+
+        om.labels_prev.swap(om.labels);
+        om.has_prev = true;
+    }
+}
+
+#ifdef FLOAT_SINGLE
+template class Objects<float>;
+#else
+template class Objects<double>;
+#endif
@@ -29,6 +29,7 @@
 #include "fields.h"
 #include "constants.h"
 #include "timeloop.h"
+#include "advec.h"
 #include "constants.h"
 
 #include "particle_bin.h"
@@ -80,6 +81,8 @@ Particle_bin<TF>::Particle_bin(Master& masterin, Grid<TF>& gridin, Fields<TF>& f
 
         // Constraint on time stepping.
         cfl_max = inputin.get_item<TF>("particle_bin", "cfl_max", "", 1.2);
+
+        sw_advec = inputin.get_item<bool>("particle_bin", "sw_advec", "", false);
     }
 }
 
@@ -89,11 +92,23 @@ Particle_bin<TF>::~Particle_bin()
 }
 
 template<typename TF>
-void Particle_bin<TF>::create(Timeloop<TF>& timeloop)
+void Particle_bin<TF>::create(Timeloop<TF>& timeloop, Advec<TF>& advec)
 {
     if (!sw_particle)
         return;
 
+    // Settling that is part of the vertical advective flux needs no separate pass over the scalar.
+    if (sw_advec)
+    {
+        for (auto& w : w_particle)
+        {
+            if (advec.set_settling_velocity(w.first, w.second))
+                in_advec.insert(w.first);
+            else
+                master.print_warning("Settling of \"%s\" is not supported by the advection, applied separately\n", w.first.c_str());
+        }
+    }
+
     auto& gd = grid.get_grid_data();
 
     // Find minimum vertical grid spacing.
@@ -131,6 +146,10 @@ void Particle_bin<TF>::exec(Stats<TF>& stats)
     auto& gd = grid.get_grid_data();
 
     for (auto& w : w_particle)
+    {
+        if (in_advec.count(w.first))
+            continue;
+
         settle_particles<TF>(
                 fields.st.at(w.first)->fld.data(),
                 fields.sp.at(w.first)->fld.data(),
@@ -140,6 +159,7 @@ void Particle_bin<TF>::exec(Stats<TF>& stats)
                 gd.jstart, gd.jend,
                 gd.kstart, gd.kend,
                 gd.icells, gd.ijcells);
+    }
 }
 #endif
 
@@ -0,0 +1,219 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "timeloop.h"
+#include "constants.h"
+#include "tools.h"
+
+#include "particles.h"
+#include "particles_kernels.h"
+
+namespace
+{
+    namespace pk = Particles_kernels;
+
+    template<typename TF> __global__
+    void advance_particles_g(
+            TF* const __restrict__ var, const int stride,
+            const TF* const __restrict__ u, const TF* const __restrict__ v, const TF* const __restrict__ w,
+            const TF* const __restrict__ zc, const TF* const __restrict__ zh,
+            const TF xstart, const TF ystart, const TF dxi, const TF dyi,
+            const TF xsize, const TF ysize, const TF zsize,
+            const TF tau, const TF grav, const TF cA, const TF cBdt,
+            const int istart, const int iend, const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk, const int np)
+    {
+        const int n = blockIdx.x*blockDim.x + threadIdx.x;
+
+        if (n < np)
+        {
+            // The variables are stored in the order of Particle_var.
+            TF* const x  = &var[ 0*stride];
+            TF* const y  = &var[ 1*stride];
+            TF* const z  = &var[ 2*stride];
+            TF* const up = &var[ 3*stride];
+            TF* const vp = &var[ 4*stride];
+            TF* const wp = &var[ 5*stride];
+            TF* const xt = &var[ 6*stride];
+            TF* const yt = &var[ 7*stride];
+            TF* const zt = &var[ 8*stride];
+            TF* const ut = &var[ 9*stride];
+            TF* const vt = &var[10*stride];
+            TF* const wt = &var[11*stride];
+
+            const TF uf = pk::interpolate(u, zc, x[n], y[n], z[n], xstart, ystart, TF(0.), TF(0.5),
+                    dxi, dyi, istart, iend, jstart, jend, kstart, kend, jj, kk);
+            const TF vf = pk::interpolate(v, zc, x[n], y[n], z[n], xstart, ystart, TF(0.5), TF(0.),
+                    dxi, dyi, istart, iend, jstart, jend, kstart, kend, jj, kk);
+            const TF wf = pk::interpolate(w, zh, x[n], y[n], z[n], xstart, ystart, TF(0.5), TF(0.5),
+                    dxi, dyi, istart, iend, jstart, jend, kstart, kend, jj, kk);
+
+            pk::advance_particle(
+                    x[n], y[n], z[n], up[n], vp[n], wp[n],
+                    xt[n], yt[n], zt[n], ut[n], vt[n], wt[n],
+                    uf, vf, wf, tau, grav, cA, cBdt,
+                    xsize, ysize, zsize);
+        }
+    }
+
+    template<typename TF> __global__
+    void count_misplaced_g(
+            int* const __restrict__ nmisplaced,
+            const TF* const __restrict__ x, const TF* const __restrict__ y,
+            const TF xsize, const TF ysize, const int npx, const int npy,
+            const int mpicoordx, const int mpicoordy, const int np)
+    {
+        const int n = blockIdx.x*blockDim.x + threadIdx.x;
+
+        // Same ownership as on the host, such that both agree on the particles that need to move.
+        if (n < np)
+        {
+            const int ox = min(static_cast<int>(x[n] / (xsize/npx)), npx-1);
+            const int oy = min(static_cast<int>(y[n] / (ysize/npy)), npy-1);
+
+            if (ox != mpicoordx || oy != mpicoordy)
+                atomicAdd(nmisplaced, 1);
+        }
+    }
+}
+
+#ifdef USECUDA
+template<typename TF>
+void Particles<TF>::prepare_device()
+{
+    if (!swparticles)
+        return;
+
+    np_capacity = 0;
+    nmisplaced_g.allocate(1);
+
+    forward_device();
+}
+
+template<typename TF>
+void Particles<TF>::clear_device()
+{
+    if (!swparticles)
+        return;
+
+    var_g.free();
+    nmisplaced_g.free();
+}
+
+template<typename TF>
+void Particles<TF>::forward_device()
+{
+    if (!swparticles)
+        return;
+
+    // Grow the buffers with some headroom, as the number of particles per process changes by migration.
+    if (np > np_capacity)
+    {
+        np_capacity = std::max(np + np/4, 1024);
+        var_g.free();
+        var_g.allocate(n_vars*np_capacity);
+    }
+
+    for (int v=0; v<n_vars; ++v)
+        cuda_copy<TF>(var[v].data(), var_g.data() + v*np_capacity, np);
+}
+
+template<typename TF>
+void Particles<TF>::backward_device()
+{
+    if (!swparticles)
+        return;
+
+    for (int v=0; v<n_vars; ++v)
+        cuda_copy<TF>(var_g.data() + v*np_capacity, var[v].data(), np);
+}
+
+template<typename TF>
+void Particles<TF>::exec(Timeloop<TF>& timeloop)
+{
+    if (!swparticles)
+        return;
+
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int blocki = 256;
+    const int gridi = np/blocki + (np%blocki > 0);
+
+    if (np > 0)
+    {
+        advance_particles_g<TF><<<gridi, blocki>>>(
+                var_g, np_capacity,
+                fields.mp.at("u")->fld_g,
+                fields.mp.at("v")->fld_g,
+                fields.mp.at("w")->fld_g,
+                gd.z_g, gd.zh_g,
+                gd.xh[gd.istart], gd.yh[gd.jstart], gd.dxi, gd.dyi,
+                gd.xsize, gd.ysize, gd.zsize,
+                tau, Constants::grav<TF>,
+                TF(timeloop.get_sub_time_step_tendency_factor()),
+                TF(timeloop.get_sub_time_step()),
+                gd.istart, gd.iend, gd.jstart, gd.jend,
+                gd.kstart, gd.kend,
+                gd.icells, gd.ijcells, np);
+        cuda_check_error();
+    }
+
+    // The particles stay on the device, unless any process has particles that left its subdomain.
+    if (md.npx*md.npy == 1)
+        return;
+
+    int nmisplaced = 0;
+    cuda_copy<int>(&nmisplaced, nmisplaced_g, 1);
+
+    if (np > 0)
+    {
+        count_misplaced_g<TF><<<gridi, blocki>>>(
+                nmisplaced_g, var_g.data() + X*np_capacity, var_g.data() + Y*np_capacity,
+                gd.xsize, gd.ysize, md.npx, md.npy, md.mpicoordx, md.mpicoordy, np);
+        cuda_check_error();
+
+        cuda_copy<int>(nmisplaced_g, &nmisplaced, 1);
+    }
+
+    master.sum(&nmisplaced, 1);
+
+    if (nmisplaced > 0)
+    {
+        backward_device();
+        migrate();
+        forward_device();
+    }
+}
+#endif
+
+#ifdef FLOAT_SINGLE
+template class Particles<float>;
+#else
+template class Particles<double>;
+#endif
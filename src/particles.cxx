@@ -0,0 +1,491 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+#include "master.h"
+#include "input.h"
+#include "grid.h"
+#include "fields.h"
+#include "timeloop.h"
+#include "constants.h"
+#include "defines.h"
+
+#include "particles.h"
+#include "particles_kernels.h"
+
+namespace
+{
+    namespace pk = Particles_kernels;
+
+    #ifdef USEMPI
+    template<typename TF> MPI_Datatype mpi_fp_type();
+    template<> MPI_Datatype mpi_fp_type<double>() { return MPI_DOUBLE; }
+    template<> MPI_Datatype mpi_fp_type<float>() { return MPI_FLOAT; }
+    #endif
+
+    // Process coordinate that owns position `pos` in a direction of length `size` split over `n` processes.
+    template<typename TF>
+    inline int owner(const TF pos, const TF size, const int n)
+    {
+        return std::min(static_cast<int>(pos / (size/n)), n-1);
+    }
+
+    template<typename TF>
+    void advance_particles(
+            TF* const restrict x, TF* const restrict y, TF* const restrict z,
+            TF* const restrict up, TF* const restrict vp, TF* const restrict wp,
+            TF* const restrict xt, TF* const restrict yt, TF* const restrict zt,
+            TF* const restrict ut, TF* const restrict vt, TF* const restrict wt,
+            const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
+            const TF* const restrict zc, const TF* const restrict zh,
+            const TF xstart, const TF ystart, const TF dxi, const TF dyi,
+            const TF xsize, const TF ysize, const TF zsize,
+            const TF tau, const TF cA, const TF cBdt,
+            const int istart, const int iend, const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk, const int np)
+    {
+        #pragma omp parallel for
+        for (int n=0; n<np; ++n)
+        {
+            const TF uf = pk::interpolate(u, zc, x[n], y[n], z[n], xstart, ystart, TF(0.), TF(0.5),
+                    dxi, dyi, istart, iend, jstart, jend, kstart, kend, jj, kk);
+            const TF vf = pk::interpolate(v, zc, x[n], y[n], z[n], xstart, ystart, TF(0.5), TF(0.),
+                    dxi, dyi, istart, iend, jstart, jend, kstart, kend, jj, kk);
+            const TF wf = pk::interpolate(w, zh, x[n], y[n], z[n], xstart, ystart, TF(0.5), TF(0.5),
+                    dxi, dyi, istart, iend, jstart, jend, kstart, kend, jj, kk);
+
+            pk::advance_particle(
+                    x[n], y[n], z[n], up[n], vp[n], wp[n],
+                    xt[n], yt[n], zt[n], ut[n], vt[n], wt[n],
+                    uf, vf, wf, tau, Constants::grav<TF>, cA, cBdt,
+                    xsize, ysize, zsize);
+        }
+    }
+}
+
+template<typename TF>
+Particles<TF>::Particles(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& inputin) :
+    master(masterin), grid(gridin), fields(fieldsin)
+{
+    swparticles = inputin.get_item<bool>("particles", "swparticles", "", false);
+    np = 0;
+
+    if (swparticles)
+    {
+        auto& gd = grid.get_grid_data();
+
+        nparticles = inputin.get_item<int>("particles", "nparticles", "");
+        seed = inputin.get_item<int>("particles", "seed", "", 1);
+
+        x0 = inputin.get_item<TF>("particles", "x0", "", 0.);
+        x1 = inputin.get_item<TF>("particles", "x1", "", gd.xsize);
+        y0 = inputin.get_item<TF>("particles", "y0", "", 0.);
+        y1 = inputin.get_item<TF>("particles", "y1", "", gd.ysize);
+        z0 = inputin.get_item<TF>("particles", "z0", "", 0.);
+        z1 = inputin.get_item<TF>("particles", "z1", "", gd.zsize);
+
+        tau = inputin.get_item<TF>("particles", "tau", "", 0.);
+        sampletime = inputin.get_item<double>("particles", "sampletime", "");
+
+        if (nparticles < 0)
+            throw std::runtime_error("The number of particles cannot be negative");
+        if (tau < 0)
+            throw std::runtime_error("The particle response time cannot be negative");
+        if (x0 < 0 || x1 > gd.xsize || y0 < 0 || y1 > gd.ysize || z0 < 0 || z1 > gd.zsize
+                || x0 > x1 || y0 > y1 || z0 > z1)
+            throw std::runtime_error("The particle release box is outside of the domain");
+    }
+}
+
+template<typename TF>
+Particles<TF>::~Particles()
+{
+}
+
+template<typename TF>
+void Particles<TF>::create(Timeloop<TF>& timeloop)
+{
+    if (!swparticles)
+        return;
+
+    isampletime = convert_to_itime(sampletime);
+}
+
+template<typename TF>
+void Particles<TF>::create_cold_start()
+{
+    if (!swparticles)
+        return;
+
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    // All processes draw the same sequence, and keep the particles in their own subdomain.
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<TF> dist_x(x0, x1);
+    std::uniform_real_distribution<TF> dist_y(y0, y1);
+    std::uniform_real_distribution<TF> dist_z(z0, z1);
+
+    id.clear();
+    for (auto& v : var)
+        v.clear();
+
+    for (int n=0; n<nparticles; ++n)
+    {
+        const TF x = std::min(dist_x(generator), std::nextafter(gd.xsize, TF(0)));
+        const TF y = std::min(dist_y(generator), std::nextafter(gd.ysize, TF(0)));
+        const TF z = dist_z(generator);
+
+        if (owner(x, gd.xsize, md.npx) != md.mpicoordx || owner(y, gd.ysize, md.npy) != md.mpicoordy)
+            continue;
+
+        id.push_back(n);
+        var[X].push_back(x);
+        var[Y].push_back(y);
+        var[Z].push_back(z);
+    }
+
+    np = id.size();
+    for (int v=U; v<n_vars; ++v)
+        var[v].assign(np, TF(0.));
+}
+
+template<typename TF>
+bool Particles<TF>::do_output(unsigned long itime)
+{
+    if (!swparticles)
+        return false;
+
+    return (itime % isampletime == 0);
+}
+
+template<typename TF>
+unsigned long Particles<TF>::get_time_limit(unsigned long itime)
+{
+    if (!swparticles)
+        return Constants::ulhuge;
+
+    unsigned long idtlim = isampletime - itime % isampletime;
+
+    // The explicit relaxation of inertial particles is stable for time steps up to their response time.
+    if (tau > 0)
+        idtlim = std::min(idtlim, convert_to_itime(tau));
+
+    return idtlim;
+}
+
+template<typename TF>
+int Particles<TF>::count_misplaced(const bool in_x) const
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const TF size = in_x ? gd.xsize : gd.ysize;
+    const int nproc = in_x ? md.npx : md.npy;
+    const int coord = in_x ? md.mpicoordx : md.mpicoordy;
+    const std::vector<TF>& pos = in_x ? var[X] : var[Y];
+
+    int nmisplaced = 0;
+    for (int n=0; n<np; ++n)
+        if (owner(pos[n], size, nproc) != coord)
+            ++nmisplaced;
+
+    return nmisplaced;
+}
+
+template<typename TF>
+void Particles<TF>::exchange(const bool in_x)
+{
+    #ifdef USEMPI
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const TF size = in_x ? gd.xsize : gd.ysize;
+    const int nproc = in_x ? md.npx : md.npy;
+    const int coord = in_x ? md.mpicoordx : md.mpicoordy;
+    const int neighbour_fwd = in_x ? md.neast : md.nnorth;
+    const int neighbour_bwd = in_x ? md.nwest : md.nsouth;
+    const std::vector<TF>& pos = in_x ? var[X] : var[Y];
+
+    // Pack the leaving particles per neighbour, and compact the remaining ones in place.
+    // Particles that are more than one process away travel via the shortest direction.
+    std::array<std::vector<TF>, 2> send_var;
+    std::array<std::vector<int>, 2> send_id;
+
+    int nkeep = 0;
+    for (int n=0; n<np; ++n)
+    {
+        const int dest = owner(pos[n], size, nproc);
+        if (dest == coord)
+        {
+            id[nkeep] = id[n];
+            for (int v=0; v<n_vars; ++v)
+                var[v][nkeep] = var[v][n];
+            ++nkeep;
+        }
+        else
+        {
+            const int dir = ((dest-coord+nproc) % nproc <= nproc/2) ? 0 : 1;
+            send_id[dir].push_back(id[n]);
+            for (int v=0; v<n_vars; ++v)
+                send_var[dir].push_back(var[v][n]);
+        }
+    }
+
+    // Exchange the number of particles first, then all variables in one message per neighbour.
+    int nsend[2] = {static_cast<int>(send_id[0].size()), static_cast<int>(send_id[1].size())};
+    int nrecv[2];
+
+    MPI_Sendrecv(&nsend[0], 1, MPI_INT, neighbour_fwd, 1,
+                 &nrecv[0], 1, MPI_INT, neighbour_bwd, 1, md.commxy, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(&nsend[1], 1, MPI_INT, neighbour_bwd, 2,
+                 &nrecv[1], 1, MPI_INT, neighbour_fwd, 2, md.commxy, MPI_STATUS_IGNORE);
+
+    std::array<std::vector<TF>, 2> recv_var;
+    std::array<std::vector<int>, 2> recv_id;
+    for (int d=0; d<2; ++d)
+    {
+        recv_var[d].resize(n_vars*nrecv[d]);
+        recv_id[d].resize(nrecv[d]);
+    }
+
+    MPI_Request reqs[8];
+    MPI_Isend(send_var[0].data(), n_vars*nsend[0], mpi_fp_type<TF>(), neighbour_fwd, 3, md.commxy, &reqs[0]);
+    MPI_Irecv(recv_var[0].data(), n_vars*nrecv[0], mpi_fp_type<TF>(), neighbour_bwd, 3, md.commxy, &reqs[1]);
+    MPI_Isend(send_var[1].data(), n_vars*nsend[1], mpi_fp_type<TF>(), neighbour_bwd, 4, md.commxy, &reqs[2]);
+    MPI_Irecv(recv_var[1].data(), n_vars*nrecv[1], mpi_fp_type<TF>(), neighbour_fwd, 4, md.commxy, &reqs[3]);
+    MPI_Isend(send_id[0].data(), nsend[0], MPI_INT, neighbour_fwd, 5, md.commxy, &reqs[4]);
+    MPI_Irecv(recv_id[0].data(), nrecv[0], MPI_INT, neighbour_bwd, 5, md.commxy, &reqs[5]);
+    MPI_Isend(send_id[1].data(), nsend[1], MPI_INT, neighbour_bwd, 6, md.commxy, &reqs[6]);
+    MPI_Irecv(recv_id[1].data(), nrecv[1], MPI_INT, neighbour_fwd, 6, md.commxy, &reqs[7]);
+    MPI_Waitall(8, reqs, MPI_STATUSES_IGNORE);
+
+    // Append the arrived particles.
+    np = nkeep + nrecv[0] + nrecv[1];
+    id.resize(np);
+    for (auto& v : var)
+        v.resize(np);
+
+    int n = nkeep;
+    for (int d=0; d<2; ++d)
+        for (int m=0; m<nrecv[d]; ++m, ++n)
+        {
+            id[n] = recv_id[d][m];
+            for (int v=0; v<n_vars; ++v)
+                var[v][n] = recv_var[d][n_vars*m + v];
+        }
+    #endif
+}
+
+template<typename TF>
+void Particles<TF>::migrate()
+{
+    #ifdef USEMPI
+    auto& md = master.get_MPI_data();
+
+    // First move the particles in x, then in y, such that the diagonal neighbours are reached in two
+    // steps. Repeat until no process has particles outside of its subdomain, to allow for multiple hops.
+    for (const bool in_x : {true, false})
+    {
+        if ((in_x ? md.npx : md.npy) == 1)
+            continue;
+
+        while (true)
+        {
+            int nmisplaced = count_misplaced(in_x);
+            master.sum(&nmisplaced, 1);
+
+            if (nmisplaced == 0)
+                break;
+
+            exchange(in_x);
+        }
+    }
+    #endif
+}
+
+#ifndef USECUDA
+template<typename TF>
+void Particles<TF>::exec(Timeloop<TF>& timeloop)
+{
+    if (!swparticles)
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    advance_particles<TF>(
+            var[X].data(), var[Y].data(), var[Z].data(),
+            var[U].data(), var[V].data(), var[W].data(),
+            var[Xt].data(), var[Yt].data(), var[Zt].data(),
+            var[Ut].data(), var[Vt].data(), var[Wt].data(),
+            fields.mp.at("u")->fld.data(),
+            fields.mp.at("v")->fld.data(),
+            fields.mp.at("w")->fld.data(),
+            gd.z.data(), gd.zh.data(),
+            gd.xh[gd.istart], gd.yh[gd.jstart], gd.dxi, gd.dyi,
+            gd.xsize, gd.ysize, gd.zsize,
+            tau,
+            timeloop.get_sub_time_step_tendency_factor(),
+            timeloop.get_sub_time_step(),
+            gd.istart, gd.iend, gd.jstart, gd.jend,
+            gd.kstart, gd.kend,
+            gd.icells, gd.ijcells, np);
+
+    migrate();
+}
+#endif
+
+template<typename TF>
+void Particles<TF>::save(const int iotime)
+{
+    if (!swparticles)
+        return;
+
+    // Gather the positions and velocities on the main process, which writes them ordered by id.
+    std::vector<int> id_all;
+    std::vector<TF> var_all;
+
+    #ifdef USEMPI
+    auto& md = master.get_MPI_data();
+
+    std::vector<int> counts(md.nprocs);
+    std::vector<int> displs(md.nprocs, 0);
+    MPI_Gather(&np, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, md.commxy);
+
+    int ntot = 0;
+    if (md.mpiid == 0)
+        for (int p=0; p<md.nprocs; ++p)
+        {
+            displs[p] = ntot;
+            ntot += counts[p];
+        }
+
+    id_all.resize(ntot);
+    var_all.resize(n_out_vars*ntot);
+
+    MPI_Gatherv(id.data(), np, MPI_INT, id_all.data(), counts.data(), displs.data(), MPI_INT, 0, md.commxy);
+    for (int v=0; v<n_out_vars; ++v)
+        MPI_Gatherv(var[v].data(), np, mpi_fp_type<TF>(),
+                    &var_all[v*ntot], counts.data(), displs.data(), mpi_fp_type<TF>(), 0, md.commxy);
+    #else
+    const int ntot = np;
+    id_all = id;
+    for (int v=0; v<n_out_vars; ++v)
+        var_all.insert(var_all.end(), var[v].begin(), var[v].end());
+    #endif
+
+    int nerror = 0;
+    if (master.get_mpiid() == 0)
+    {
+        std::vector<TF> out(n_out_vars*nparticles, TF(0.));
+        for (int v=0; v<n_out_vars; ++v)
+            for (int n=0; n<ntot; ++n)
+                out[v*nparticles + id_all[n]] = var_all[v*ntot + n];
+
+        char filename[256];
+        std::snprintf(filename, 256, "%s.%07d", "particles", iotime);
+        master.print_message("Saving \"%s\" ... ", filename);
+
+        FILE* pFile = fopen(filename, "wb");
+        if (pFile == NULL)
+            ++nerror;
+        else
+        {
+            if (fwrite(out.data(), sizeof(TF), out.size(), pFile) != out.size())
+                ++nerror;
+            fclose(pFile);
+        }
+
+        master.print_message(nerror ? "FAILED\n" : "OK\n");
+    }
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        throw std::runtime_error("Error in writing particles");
+}
+
+template<typename TF>
+void Particles<TF>::load(const int iotime)
+{
+    if (!swparticles)
+        return;
+
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    char filename[256];
+    std::snprintf(filename, 256, "%s.%07d", "particles", iotime);
+    master.print_message("Loading \"%s\" ... ", filename);
+
+    // Every process reads the file and keeps the particles in its own subdomain.
+    std::vector<TF> in(n_out_vars*nparticles);
+
+    int nerror = 0;
+    FILE* pFile = fopen(filename, "rb");
+    if (pFile == NULL)
+        ++nerror;
+    else
+    {
+        if (fread(in.data(), sizeof(TF), in.size(), pFile) != in.size())
+            ++nerror;
+        fclose(pFile);
+    }
+
+    master.sum(&nerror, 1);
+    if (nerror)
+    {
+        master.print_message("FAILED\n");
+        throw std::runtime_error("Error in reading particles");
+    }
+    master.print_message("OK\n");
+
+    id.clear();
+    for (auto& v : var)
+        v.clear();
+
+    for (int n=0; n<nparticles; ++n)
+    {
+        if (owner(in[X*nparticles + n], gd.xsize, md.npx) != md.mpicoordx
+                || owner(in[Y*nparticles + n], gd.ysize, md.npy) != md.mpicoordy)
+            continue;
+
+        id.push_back(n);
+        for (int v=0; v<n_out_vars; ++v)
+            var[v].push_back(in[v*nparticles + n]);
+    }
+
+    // The tendencies are reset in the first substep.
+    np = id.size();
+    for (int v=n_out_vars; v<n_vars; ++v)
+        var[v].assign(np, TF(0.));
+}
+
+#ifdef FLOAT_SINGLE
+template class Particles<float>;
+#else
+template class Particles<double>;
+#endif
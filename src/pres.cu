@@ -21,6 +21,7 @@
  */
 
 #include <cstdio>
+#include <algorithm>
 #include <cufft.h>
 #include <type_traits>
 #include <iostream>
@@ -33,8 +34,6 @@
 
 namespace
 {
-    const int TILE_DIM = 16; // Size of shared memory array used for transpose
-
     inline int check_cufft(cufftResult err)
     {
         if (err == CUFFT_SUCCESS)
@@ -66,107 +65,83 @@ namespace
         }
     }
 
-    template<typename TF> __global__
-    void transpose_g(TF* fieldOut, const TF* fieldIn, const int itot, const int jtot, const int ktot)
-    {
-        __shared__ TF tile[TILE_DIM][TILE_DIM+1];
-
-        // Index in fieldIn
-        int i = blockIdx.x * TILE_DIM + threadIdx.x;
-        int j = blockIdx.y * TILE_DIM + threadIdx.y;
-        int k = blockIdx.z;
-        int ijk = i + j*itot + k*itot*jtot;
-
-        // Read to shared memory
-        if (i < itot && j < jtot)
-            tile[threadIdx.y][threadIdx.x] = fieldIn[ijk];
-
-        __syncthreads();
-
-        // Transposed index
-        i = blockIdx.y * TILE_DIM + threadIdx.x;
-        j = blockIdx.x * TILE_DIM + threadIdx.y;
-        ijk = i + j*jtot + k*itot*jtot;
-
-        // Write transposed field back from shared to global memory
-        if (i < jtot && j < itot)
-            fieldOut[ijk] = tile[threadIdx.x][threadIdx.y];
-    }
-
-    template<typename TF, typename cTF> __global__
-    void complex_TF_x_g(cTF* __restrict__ cdata, TF* __restrict__ ddata,
-                        const unsigned int itot, const unsigned int jtot, unsigned int kk, unsigned int kki, bool forward)
+    // Conversion between the complex output of a two-dimensional real-to-complex FFT of a slice and the
+    // real layout of the solver. This layout is that of a real-to-complex FFT in the x-direction followed
+    // by one in the y-direction, with the imaginary parts of wave number n stored at index itot-n (jtot-n).
+    // The y-transforms of the real and imaginary parts of the x-transform follow from the symmetry of the
+    // two-dimensional transform Z as R = (Z(kx,ky) + conj(Z(kx,-ky)))/2 and I = (Z(kx,ky) - conj(Z(kx,-ky)))/2i.
+    // Real and imaginary part at wave number j of the y-transform that is stored in column col.
+    template<typename TF> __device__
+    void get_column_y_g(TF& re, TF& im, const TF* __restrict__ col, const int itot, const int jtot, const int j)
     {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y;
-        const int k = blockIdx.z;
-
-        const int ij   = i + j*itot + k*kk;         // index real part in ddata
-        const int ij2  = (itot-i) + j*itot + k*kk;  // index complex part in ddata
-        const int imax = itot/2+1;
-        const int ijc  = i + j*imax + k*kki;        // index in cdata
+        const int jmax = jtot/2+1;
 
-        if (j < jtot && i < imax)
+        if (j < jmax)
         {
-            if (forward) // complex -> double
-            {
-                ddata[ij]  = cdata[ijc].x;
-                if (i > 0 && i < imax-1)
-                    ddata[ij2] = cdata[ijc].y;
-            }
-            else // double -> complex
-            {
-                cdata[ijc].x = ddata[ij];
-                if (i > 0 && i < imax-1)
-                    cdata[ijc].y = ddata[ij2];
-                else
-                    cdata[ijc].y = TF(0.);
-            }
+            re = col[j*itot];
+            im = (j > 0 && j < jmax-1) ? col[(jtot-j)*itot] : TF(0.);
+        }
+        else
+        {
+            re =  col[(jtot-j)*itot];
+            im = -col[j*itot];
         }
     }
 
     template<typename TF, typename cTF> __global__
-    void complex_TF_y_g(cTF* __restrict__ cdata, TF* __restrict__ ddata,
-                        const unsigned int itot, const unsigned int jtot, unsigned int kk, unsigned int kkj, bool forward)
+    void complex_TF_xy_g(cTF* __restrict__ cdata, TF* __restrict__ ddata,
+                         const int itot, const int jtot, const int kk, const int kkc, bool forward)
     {
         const int i = blockIdx.x*blockDim.x + threadIdx.x;
         const int j = blockIdx.y*blockDim.y + threadIdx.y;
         const int k = blockIdx.z;
 
-        const int ij   = i + j*itot + k*kk;           // index real part in ddata
-        const int ij2  = i + (jtot-j)*itot + k*kk;    // index complex part in ddata
+        const int imax = itot/2+1;
         const int jmax = jtot/2+1;
-        const int ijc  = i + j*itot + k*kkj;
 
-        if(i < itot && j < jmax)
+        if (i >= itot || j >= jtot)
+            return;
+
+        if (forward) // complex -> double
         {
-            if (forward) // complex -> double
+            const bool is_imag_x = (i >= imax);
+            const bool is_imag_y = (j >= jmax);
+            const int kx  = is_imag_x ? itot-i : i;
+            const int ky  = is_imag_y ? jtot-j : j;
+            const int kym = (jtot-ky) % jtot;
+
+            const cTF z  = cdata[kx + ky *imax + k*kkc];
+            const cTF zm = cdata[kx + kym*imax + k*kkc];
+
+            TF re, im;
+            if (is_imag_x)
             {
-                ddata[ij] = cdata[ijc].x;
-                if (j > 0 && j < jmax-1)
-                    ddata[ij2] = cdata[ijc].y;
+                re = TF(0.5)*(z.y + zm.y);
+                im = TF(0.5)*(zm.x - z.x);
             }
-            else // double -> complex
+            else
             {
-                cdata[ijc].x = ddata[ij];
-                if (j > 0 && j < jmax-1)
-                    cdata[ijc].y = ddata[ij2];
-                else
-                    cdata[ijc].y = TF(0.);
+                re = TF(0.5)*(z.x + zm.x);
+                im = TF(0.5)*(z.y - zm.y);
             }
-        }
-    }
-
-    template<typename TF> __global__
-    __global__ void normalize_g(TF* const __restrict__ data, const int itot, const int jtot, const int ktot, const TF in)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y;
-        const int k = blockIdx.z;
-        const int ijk = i + j*itot + k*itot*jtot;
 
-        if (i < itot && j < jtot && k < ktot)
-            data[ijk] = data[ijk] * in;
+            ddata[i + j*itot + k*kk] = is_imag_y ? im : re;
+        }
+        else if (i < imax) // double -> complex
+        {
+            TF r_re, r_im;
+            get_column_y_g(r_re, r_im, &ddata[i + k*kk], itot, jtot, j);
+
+            TF i_re = TF(0.);
+            TF i_im = TF(0.);
+            if (i > 0 && i < imax-1)
+                get_column_y_g(i_re, i_im, &ddata[itot-i + k*kk], itot, jtot, j);
+
+            cTF z;
+            z.x = r_re - i_im;
+            z.y = r_im + i_re;
+            cdata[i + j*imax + k*kkc] = z;
+        }
     }
 
     // Help functions to witch between real/double -> complex and vice versa
@@ -206,40 +181,49 @@ namespace
 }
 
 #ifdef USECUDA
+template<typename TF>
+void Pres<TF>::set_fft_backend()
+{
+    // cuFFT transforms a field on a single device, such that distributed runs need the host.
+    const int nprocs = master.get_MPI_data().nprocs;
+
+    if (fft_backend_name == "host")
+        fft_backend = Fft_backend::Host;
+    else if (fft_backend_name == "cufft")
+    {
+        if (nprocs > 1)
+            throw std::runtime_error("fftbackend=cufft requires a single process, use fftbackend=host");
+        fft_backend = Fft_backend::Cufft;
+    }
+    else
+        fft_backend = (nprocs > 1) ? Fft_backend::Host : Fft_backend::Cufft;
+
+    if (fft_backend == Fft_backend::Host)
+        master.print_message("FFT backend: FFTW on the host\n");
+    else
+        master.print_message("FFT backend: cuFFT on the device\n");
+}
+
 template<typename TF>
 void Pres<TF>::make_cufft_plan()
 {
     const auto& gd = grid.get_grid_data();
 
-    const int rank = 1;
-
-    // Float/double input
-    int i_ni[]    = {gd.itot};
-    int i_nj[]    = {gd.jtot};
-    int i_istride = 1;
-    int i_jstride = gd.itot;
-    int i_idist   = gd.itot;
-    int i_jdist   = 1;
+    // Two-dimensional transforms of the horizontal slices, or one-dimensional ones without a y-direction.
+    int rank = (gd.jtot > 1) ? 2 : 1;
+    int n[] = {gd.jtot, gd.itot};
+    int* dims = (gd.jtot > 1) ? n : &n[1];
 
-    // Float/double-complex output
-    int o_ni[]    = {gd.itot/2+1};
-    int o_nj[]    = {gd.jtot/2+1};
-    int o_istride = 1;
-    int o_jstride = gd.itot;
-    int o_idist   = gd.itot/2+1;
-    int o_jdist   = 1;
+    const int idist = gd.itot*gd.jtot;
+    const int odist = (gd.itot/2+1)*gd.jtot;
 
     // Get memory estimate of batched FFT over entire field.
     size_t work_size, total_work_size=0;
 
-    check_cufft(cufftEstimateMany(rank, i_ni, i_ni, i_istride, i_idist,     o_ni, o_istride, o_idist,     cufft_to_complex<TF>(),   gd.jtot*gd.ktot, &work_size));
-    total_work_size += work_size;
-    check_cufft(cufftEstimateMany(rank, i_ni, o_ni, o_istride, o_idist,     i_ni, i_istride, i_idist,     cufft_from_complex<TF>(), gd.jtot*gd.ktot, &work_size));
-    total_work_size += work_size;
-    check_cufft(cufftEstimateMany(rank, i_nj, i_nj, i_istride, gd.jtot,     o_nj, o_istride, gd.jtot/2+1, cufft_to_complex<TF>(),   gd.itot*gd.ktot, &work_size));
-    total_work_size += work_size;
-    check_cufft(cufftEstimateMany(rank, i_nj, o_nj, o_istride, gd.jtot/2+1, i_nj, i_istride, gd.jtot,     cufft_from_complex<TF>(), gd.itot*gd.ktot, &work_size));
-    total_work_size += work_size;
+    check_cufft(cufftEstimateMany(rank, dims, nullptr, 1, idist, nullptr, 1, odist, cufft_to_complex<TF>(),   gd.ktot, &work_size));
+    total_work_size = std::max(total_work_size, work_size);
+    check_cufft(cufftEstimateMany(rank, dims, nullptr, 1, odist, nullptr, 1, idist, cufft_from_complex<TF>(), gd.ktot, &work_size));
+    total_work_size = std::max(total_work_size, work_size);
 
     // Get available memory GPU
     size_t free_mem, total_mem;
@@ -253,34 +237,51 @@ void Pres<TF>::make_cufft_plan()
     master.print_message("Available memory pre-FFT = " + std::to_string(free_mem));
     master.print_message("Memory margin = " + std::to_string(margin));
 
+    FFT_per_slice = (force_FFT_per_slice || free_mem - margin < total_work_size);
+    const int nbatch = FFT_per_slice ? 1 : gd.ktot;
+
+    // The plans do not allocate their own work areas, the forward and backward
+    // transform never run at the same time and share one area.
     int nerror = 0;
-    if (force_FFT_per_slice || free_mem - margin < total_work_size)
+    size_t work_size_f, work_size_b;
+
+    nerror += check_cufft(cufftCreate(&planf));
+    nerror += check_cufft(cufftCreate(&planb));
+    nerror += check_cufft(cufftSetAutoAllocation(planf, 0));
+    nerror += check_cufft(cufftSetAutoAllocation(planb, 0));
+    nerror += check_cufft(cufftMakePlanMany(planf, rank, dims, nullptr, 1, idist, nullptr, 1, odist, cufft_to_complex<TF>(),   nbatch, &work_size_f));
+    nerror += check_cufft(cufftMakePlanMany(planb, rank, dims, nullptr, 1, odist, nullptr, 1, idist, cufft_from_complex<TF>(), nbatch, &work_size_b));
+
+    if (nerror > 0)
+        throw std::runtime_error("FFT error");
+
+    // The work area is taken from the temporary fields when it fits, otherwise it is allocated once.
+    cufft_work_size = std::max(work_size_f, work_size_b);
+    if (cufft_work_size > gd.ncells*sizeof(TF))
     {
-        FFT_per_slice = true;
-        nerror += check_cufft(cufftPlanMany(&iplanf, rank, i_ni, i_ni, i_istride, i_idist,     o_ni, o_istride, o_idist,     cufft_to_complex<TF>(),   gd.jtot));
-        nerror += check_cufft(cufftPlanMany(&iplanb, rank, i_ni, o_ni, o_istride, o_idist,     i_ni, i_istride, i_idist,     cufft_from_complex<TF>(), gd.jtot));
-        nerror += check_cufft(cufftPlanMany(&jplanf, rank, i_nj, i_nj, i_jstride, i_jdist,     o_nj, o_jstride, o_jdist,     cufft_to_complex<TF>(),   gd.itot));
-        nerror += check_cufft(cufftPlanMany(&jplanb, rank, i_nj, o_nj, o_jstride, o_jdist,     i_nj, i_jstride, i_jdist,     cufft_from_complex<TF>(), gd.itot));
-
-        if (force_FFT_per_slice)
-            master.print_message("cuFFT strategy: batched per 2D slice (manually forced)\n");
-        else
-            master.print_message("cuFFT strategy: batched per 2D slice (memory limited)\n");
+        cufft_work_g.allocate(cufft_work_size/sizeof(TF) + 1);
+        master.print_message("cuFFT work area: " + std::to_string(cufft_work_size) + " bytes, allocated separately\n");
     }
     else
-    {
-        FFT_per_slice = false;
-        nerror += check_cufft(cufftPlanMany(&iplanf, rank, i_ni, i_ni, i_istride, i_idist,     o_ni, o_istride, o_idist,     cufft_to_complex<TF>(),   gd.jtot*gd.ktot));
-        nerror += check_cufft(cufftPlanMany(&iplanb, rank, i_ni, o_ni, o_istride, o_idist,     i_ni, i_istride, i_idist,     cufft_from_complex<TF>(), gd.jtot*gd.ktot));
-        nerror += check_cufft(cufftPlanMany(&jplanf, rank, i_nj, i_nj, i_istride, gd.jtot,     o_nj, o_istride, gd.jtot/2+1, cufft_to_complex<TF>(),   gd.itot*gd.ktot));
-        nerror += check_cufft(cufftPlanMany(&jplanb, rank, i_nj, o_nj, o_istride, gd.jtot/2+1, i_nj, i_istride, gd.jtot,     cufft_from_complex<TF>(), gd.itot*gd.ktot));
+        master.print_message("cuFFT work area: " + std::to_string(cufft_work_size) + " bytes, in a temporary field\n");
+
+    if (!FFT_per_slice)
         master.print_message("cuFFT strategy: batched over entire 3D field\n");
-    }
+    else if (force_FFT_per_slice)
+        master.print_message("cuFFT strategy: batched per 2D slice (manually forced)\n");
+    else
+        master.print_message("cuFFT strategy: batched per 2D slice (memory limited)\n");
 
     cudaMemGetInfo(&free_mem, &total_mem);
     master.print_message("Available memory post-FFT=" + std::to_string(free_mem));
+}
 
-    if (nerror > 0)
+template<typename TF>
+void Pres<TF>::set_cufft_work_area(TF* work)
+{
+    TF* area = (cufft_work_g.size() > 0) ? cufft_work_g.data() : work;
+
+    if (check_cufft(cufftSetWorkArea(planf, area)) || check_cufft(cufftSetWorkArea(planb, area)))
         throw std::runtime_error("FFT error");
 }
 
@@ -291,101 +292,42 @@ void Pres<TF>::fft_forward(TF* __restrict__ p, TF* __restrict__ tmp1, TF* __rest
 
     const int blocki = gd.ithread_block;
     const int blockj = gd.jthread_block;
-    int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
-    int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
+    const int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
+    const int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
 
     // 3D grid
     dim3 gridGPU (gridi,  gridj,  gd.kmax);
     dim3 blockGPU(blocki, blockj, 1);
 
-    // Square grid for transposes
-    const int gridiT = gd.imax/TILE_DIM + (gd.imax%TILE_DIM > 0);
-    const int gridjT = gd.jmax/TILE_DIM + (gd.jmax%TILE_DIM > 0);
-    dim3 gridGPUTf(gridiT, gridjT, gd.ktot);
-    dim3 gridGPUTb(gridjT, gridiT, gd.ktot);
-    dim3 blockGPUT(TILE_DIM, TILE_DIM, 1);
-
-    // Transposed grid
-    gridi = gd.jmax/blocki + (gd.jmax%blocki > 0);
-    gridj = gd.imax/blockj + (gd.imax%blockj > 0);
-    dim3 gridGPUji (gridi,  gridj,  gd.kmax);
-
     const int kk  = gd.itot*gd.jtot;
-    const int kki = (gd.itot/2+1)*gd.jtot;
-    const int kkj = (gd.jtot/2+1)*gd.itot;
+    const int kkc = (gd.itot/2+1)*gd.jtot;
 
     // Not sure how else to do this in parts of this routine
     bool TF_is_double = std::is_same<TF, double>::value;
 
-    // Forward FFT in the x-direction.
+    // The tmp2 field is free during the forward transform and holds the work area.
+    set_cufft_work_area(tmp2);
+
     if (FFT_per_slice) // Batched FFT per horizontal slice
     {
         for (int k=0; k<gd.ktot; ++k)
-        {
-            const int ijk  = k*kk;
-            const int ijk2 = 2*k*kki;
-
-            cufft_forward_wrapper<TF>(iplanf, &p[ijk], &tmp1[ijk2]);
-        }
+            cufft_forward_wrapper<TF>(planf, &p[k*kk], &tmp1[2*k*kkc]);
     }
     else // Single batched FFT over entire 3D field
-    {
-        cufft_forward_wrapper<TF>(iplanf, p, tmp1);
-        cudaDeviceSynchronize();
-    }
+        cufft_forward_wrapper<TF>(planf, p, tmp1);
+
+    cudaDeviceSynchronize();
+    cuda_check_error();
 
-    // Transform complex to double output. Allows for creating parallel cuda version at a later stage
     if (TF_is_double)
-        complex_TF_x_g<TF, cufftDoubleComplex><<<gridGPU,blockGPU>>>((cufftDoubleComplex*)tmp1, p, gd.itot, gd.jtot, kk, kki,  true);
+        complex_TF_xy_g<TF, cufftDoubleComplex><<<gridGPU,blockGPU>>>((cufftDoubleComplex*)tmp1, p, gd.itot, gd.jtot, kk, kkc, true);
     else
-        complex_TF_x_g<TF, cufftComplex      ><<<gridGPU,blockGPU>>>((cufftComplex*)tmp1,       p, gd.itot, gd.jtot, kk, kki,  true);
+        complex_TF_xy_g<TF, cufftComplex      ><<<gridGPU,blockGPU>>>((cufftComplex*)tmp1,       p, gd.itot, gd.jtot, kk, kkc, true);
     cuda_check_error();
-
-    // Forward FFT in the y-direction.
-    if (gd.jtot > 1)
-    {
-        if (FFT_per_slice) // Batched FFT per horizontal slice
-        {
-            for (int k=0; k<gd.ktot; ++k)
-            {
-                const int ijk  = k*kk;
-                const int ijk2 = 2*k*kkj;
-
-                cufft_forward_wrapper<TF>(jplanf, &p[ijk], &tmp1[ijk2]);
-            }
-
-            cudaDeviceSynchronize();
-            cuda_check_error();
-
-            if (TF_is_double)
-                complex_TF_y_g<TF, cufftDoubleComplex><<<gridGPU,blockGPU>>>((cufftDoubleComplex*)tmp1, p, gd.itot, gd.jtot, kk, kkj,  true);
-            else
-                complex_TF_y_g<TF, cufftComplex      ><<<gridGPU,blockGPU>>>((cufftComplex*)tmp1,       p, gd.itot, gd.jtot, kk, kkj,  true);
-
-            cuda_check_error();
-        }
-        else // Single batched FFT over entire 3D field. Y-direction FFT requires transpose of field
-        {
-            transpose_g<TF><<<gridGPUTf, blockGPUT>>>(tmp2, p, gd.itot, gd.jtot, gd.ktot);
-            cuda_check_error();
-
-            cufft_forward_wrapper<TF>(jplanf, tmp2, tmp1);
-            cudaDeviceSynchronize();
-
-            if (TF_is_double)
-                complex_TF_x_g<TF, cufftDoubleComplex><<<gridGPUji,blockGPU>>>((cufftDoubleComplex*)tmp1, p, gd.jtot, gd.itot, kk, kkj,  true);
-            else
-                complex_TF_x_g<TF, cufftComplex      ><<<gridGPUji,blockGPU>>>((cufftComplex*)tmp1,       p, gd.jtot, gd.itot, kk, kkj,  true);
-            cuda_check_error();
-
-            transpose_g<TF><<<gridGPUTb, blockGPUT>>>(tmp1, p, gd.jtot, gd.itot, gd.ktot);
-
-            cuda_safe_call(cudaMemcpy(p, tmp1, gd.itot*gd.jtot*gd.ktot*sizeof(TF), cudaMemcpyDeviceToDevice));
-            cuda_check_error();
-        }
-    }
 }
 
+// The transform writes to tmp2 instead of p, such that solve_out reads it without an extra copy,
+// and the normalization by 1/(itot*jtot) is left to solve_out as well.
 template<typename TF>
 void Pres<TF>::fft_backward(TF* __restrict__ p, TF* __restrict__ tmp1, TF* __restrict__ tmp2)
 {
@@ -393,127 +335,41 @@ void Pres<TF>::fft_backward(TF* __restrict__ p, TF* __restrict__ tmp1, TF* __res
 
     const int blocki = gd.ithread_block;
     const int blockj = gd.jthread_block;
-    int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
-    int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
+    const int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
+    const int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
 
     // 3D grid
     dim3 gridGPU (gridi,  gridj,  gd.kmax);
     dim3 blockGPU(blocki, blockj, 1);
 
-    // Square grid for transposes
-    const int gridiT = gd.imax/TILE_DIM + (gd.imax%TILE_DIM > 0);
-    const int gridjT = gd.jmax/TILE_DIM + (gd.jmax%TILE_DIM > 0);
-    dim3 gridGPUTf(gridiT, gridjT, gd.ktot);
-    dim3 gridGPUTb(gridjT, gridiT, gd.ktot);
-    dim3 blockGPUT(TILE_DIM, TILE_DIM, 1);
-
-    // Transposed grid
-    gridi = gd.jmax/blocki + (gd.jmax%blocki > 0);
-    gridj = gd.imax/blockj + (gd.imax%blockj > 0);
-    dim3 gridGPUji (gridi,  gridj,  gd.kmax);
-
-    const int kk = gd.itot*gd.jtot;
-    const int kki = (gd.itot/2+1)*gd.jtot;
-    const int kkj = (gd.jtot/2+1)*gd.itot;
+    const int kk  = gd.itot*gd.jtot;
+    const int kkc = (gd.itot/2+1)*gd.jtot;
 
     // Not sure how else to do this in parts of this routine
     bool TF_is_double = std::is_same<TF, double>::value;
 
-    // Backward FFT in the y-direction.
-    if (gd.jtot > 1)
-    {
-        if (FFT_per_slice) // Batched FFT per horizontal slice
-        {
-            if (TF_is_double)
-                complex_TF_y_g<TF, cufftDoubleComplex><<<gridGPU,blockGPU>>>((cufftDoubleComplex*)tmp1, p, gd.itot, gd.jtot, kk, kkj,  false);
-            else
-                complex_TF_y_g<TF, cufftComplex      ><<<gridGPU,blockGPU>>>((cufftComplex*)tmp1,       p, gd.itot, gd.jtot, kk, kkj,  false);
-            cuda_check_error();
-
-            for (int k=0; k<gd.ktot; ++k)
-            {
-                const int ijk = k*kk;
-                const int ijk2 = 2*k*kkj;
-
-                cufft_backward_wrapper<TF>(jplanb, &tmp1[ijk2], &p[ijk]);
-            }
-            cudaDeviceSynchronize();
-            cuda_check_error();
-        }
-        else // Single batched FFT over entire 3D field. Y-direction FFT requires transpose of field
-        {
-            transpose_g<TF><<<gridGPUTf, blockGPUT>>>(tmp2, p, gd.itot, gd.jtot, gd.ktot);
-            cuda_check_error();
-
-            if (TF_is_double)
-                complex_TF_x_g<TF, cufftDoubleComplex><<<gridGPUji,blockGPU>>>((cufftDoubleComplex*)tmp1, tmp2, gd.jtot, gd.itot, kk, kkj,  false);
-            else
-                complex_TF_x_g<TF, cufftComplex      ><<<gridGPUji,blockGPU>>>((cufftComplex*)tmp1,       tmp2, gd.jtot, gd.itot, kk, kkj,  false);
-            cuda_check_error();
-
-            cufft_backward_wrapper<TF>(jplanb, tmp1, p);
-            cudaDeviceSynchronize();
-            cuda_check_error();
-
-            transpose_g<TF><<<gridGPUTb, blockGPUT>>>(tmp1, p, gd.jtot, gd.itot, gd.ktot);
-
-            cuda_safe_call(cudaMemcpy(p, tmp1, gd.itot*gd.jtot*gd.ktot*sizeof(TF), cudaMemcpyDeviceToDevice));
-            cuda_check_error();
-        }
-    }
-
-    // Backward FFT in the x-direction
     if (TF_is_double)
-        complex_TF_x_g<TF, cufftDoubleComplex><<<gridGPU,blockGPU>>>((cufftDoubleComplex*)tmp1, p, gd.itot, gd.jtot, kk, kki,  false);
+        complex_TF_xy_g<TF, cufftDoubleComplex><<<gridGPU,blockGPU>>>((cufftDoubleComplex*)tmp1, p, gd.itot, gd.jtot, kk, kkc, false);
     else
-        complex_TF_x_g<TF, cufftComplex      ><<<gridGPU,blockGPU>>>((cufftComplex*)tmp1,       p, gd.itot, gd.jtot, kk, kki,  false);
+        complex_TF_xy_g<TF, cufftComplex      ><<<gridGPU,blockGPU>>>((cufftComplex*)tmp1,       p, gd.itot, gd.jtot, kk, kkc, false);
     cuda_check_error();
 
+    // Both tmp fields are in use, such that the work area is in a temporary field of its own.
+    auto work = fields.get_tmp_g();
+    set_cufft_work_area(work->fld_g);
+
     if (FFT_per_slice) // Batched FFT per horizontal slice
     {
         for (int k=0; k<gd.ktot; ++k)
-        {
-            const int ijk = k*kk;
-            const int ijk2 = 2*k*kki;
-
-            cufft_backward_wrapper<TF>(iplanb, &tmp1[ijk2], &p[ijk]);
-        }
-        cudaDeviceSynchronize();
-        cuda_check_error();
+            cufft_backward_wrapper<TF>(planb, &tmp1[2*k*kkc], &tmp2[k*kk]);
     }
     else // Batch FFT over entire domain
-    {
-        cufft_backward_wrapper<TF>(iplanb, tmp1, p);
-        cudaDeviceSynchronize();
-        cuda_check_error();
-    }
+        cufft_backward_wrapper<TF>(planb, tmp1, tmp2);
 
-    // Normalize output
-    TF norm_factor = 1./(gd.itot*gd.jtot);
-    normalize_g<TF><<<gridGPU,blockGPU>>>(p, gd.itot, gd.jtot, gd.ktot, norm_factor);
+    cudaDeviceSynchronize();
     cuda_check_error();
-}
 
-// For debugging: FFTs need memory during execution. Check is enough memory is available..
-template<typename TF>
-void Pres<TF>::check_cufft_memory()
-{
-//    size_t workSize, totalWorkSize=0;
-//    size_t freeMem, totalMem;
-//
-//    cufftGetSize(iplanf, &workSize);
-//    totalWorkSize += workSize;
-//    cufftGetSize(jplanf, &workSize);
-//    totalWorkSize += workSize;
-//    cufftGetSize(iplanb, &workSize);
-//    totalWorkSize += workSize;
-//    cufftGetSize(jplanb, &workSize);
-//    totalWorkSize += workSize;
-//
-//    // Get available memory GPU
-//    cudaMemGetInfo(&freeMem, &totalMem);
-//
-//    printf("Free GPU=%lu, required FFTs=%lu\n", freeMem, totalWorkSize);
+    fields.release_tmp_g(work);
 }
 #endif
 
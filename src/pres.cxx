@@ -45,10 +45,17 @@ Pres<TF>::Pres(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, FFT<TF>
     #ifdef USECUDA
     force_FFT_per_slice = inputin.get_item<bool>("pres", "sw_fft_per_slice", "", false);
 
-    iplanf = 0;
-    jplanf = 0;
-    iplanb = 0;
-    jplanb = 0;
+    // The backend is resolved in `set_fft_backend()`, once the number of processes is known.
+    fft_backend_name = inputin.get_item<std::string>("pres", "fftbackend", "", "auto");
+    if (fft_backend_name != "auto" && fft_backend_name != "host" && fft_backend_name != "cufft")
+        throw std::runtime_error("Invalid option for \"fftbackend\", options are: auto, host, cufft");
+    fft_backend = Fft_backend::Cufft;
+
+    planf = 0;
+    planb = 0;
+    cufft_work_size = 0;
+    #else
+    inputin.flag_as_used("pres", "fftbackend", "");
     #endif
 }
 
@@ -56,10 +63,8 @@ template<typename TF>
 Pres<TF>::~Pres()
 {
     #ifdef USECUDA
-    cufftDestroy(iplanf);
-    cufftDestroy(jplanf);
-    cufftDestroy(iplanb);
-    cufftDestroy(jplanb);
+    cufftDestroy(planf);
+    cufftDestroy(planb);
     #endif
 }
 
@@ -227,21 +227,20 @@ void Pres_2<TF>::prepare_device()
     const int imemsize = gd.itot*sizeof(TF);
     const int jmemsize = gd.jtot*sizeof(TF);
 
-    const int ijmemsize = gd.imax*gd.jmax*sizeof(TF);
-
     bmati_g.allocate(gd.itot);
     bmatj_g.allocate(gd.jtot);
     a_g.allocate(gd.kmax);
     c_g.allocate(gd.kmax);
-    work2d_g.allocate(gd.imax*gd.jmax);
 
     cuda_safe_call(cudaMemcpy(bmati_g,  bmati.data(),  imemsize,  cudaMemcpyHostToDevice));
     cuda_safe_call(cudaMemcpy(bmatj_g,  bmatj.data(),  jmemsize,  cudaMemcpyHostToDevice));
     cuda_safe_call(cudaMemcpy(a_g,      a.data(),      kmemsize,  cudaMemcpyHostToDevice));
     cuda_safe_call(cudaMemcpy(c_g,      c.data(),      kmemsize,  cudaMemcpyHostToDevice));
-    cuda_safe_call(cudaMemcpy(work2d_g, work2d.data(), ijmemsize, cudaMemcpyHostToDevice));
 
-    make_cufft_plan();
+    // With the host backend, the (distributed) FFT runs on the host, see `exec()`.
+    set_fft_backend();
+    if (fft_backend == Fft_backend::Cufft)
+        make_cufft_plan();
 }
 
 template<typename TF>
@@ -321,40 +320,62 @@ void Pres_2<TF>::exec(double dt, Stats<TF>& stats)
             gd.icells, gd.ijcells,
             gd.istart, gd.jstart, gd.kstart);
 
-    fft_forward(fields.sd.at("p")->fld_g, tmp1->fld_g, tmp2->fld_g);
+    if (fft_backend == Fft_backend::Host)
+    {
+        // The (distributed) FFT and tridiagonal solve are done on the host, using the MPI
+        // transposes of the CPU solver. Only the packed pressure field is staged.
+        auto& p = *fields.sd.at("p");
 
-    launch_grid_kernel<Pres_2_kernels::solve_in_g<TF>>(
-            grid_layout_nogc,
-            fields.sd.at("p")->fld_g.view(),
-            tmp1->fld_g,
-            tmp2->fld_g.view(),
-            a_g, c_g, gd.dz_g,
-            fields.rhoref_g,
-            bmati_g, bmatj_g,
-            gd.kstart, gd.kmax);
-
-    // DOES NOT WORK (YET):
-    launch_grid_kernel<Pres_2_kernels::tdma_g<TF>>(
-            grid_layout_2d_nogc,
-            a_g,
-            tmp2->fld_g,
-            c_g,
-            fields.sd.at("p")->fld_g.view(),
-            tmp1->fld_g.view(),
-            gd.kmax);
+        cuda_safe_call(cudaMemcpy(p.fld.data(), p.fld_g, gd.imax*gd.jmax*gd.kmax*sizeof(TF), cudaMemcpyDeviceToHost));
 
-    fft_backward(fields.sd.at("p")->fld_g, tmp1->fld_g, tmp2->fld_g);
+        auto tmp1_cpu = fields.get_tmp();
+        auto tmp2_cpu = fields.get_tmp();
 
-    cuda_safe_call(cudaMemcpy(tmp1->fld_g, fields.sd.at("p")->fld_g, gd.ncells*sizeof(TF), cudaMemcpyDeviceToDevice));
+        solve(p.fld.data(), tmp1_cpu->fld.data(), tmp2_cpu->fld.data(),
+              gd.dz.data(), fields.rhoref.data());
 
-    launch_grid_kernel<Pres_2_kernels::solve_out_g<TF>>(
-            grid_layout_nogc,
-            fields.sd.at("p")->fld_g.view(),
-            tmp1->fld_g,
-            gd.istart, gd.jstart, gd.kstart,
-            gd.icells, gd.ijcells);
+        fields.release_tmp(tmp1_cpu);
+        fields.release_tmp(tmp2_cpu);
 
-    boundary_cyclic.exec_g(fields.sd.at("p")->fld_g);
+        // Copy back the full field, `solve()` has set the bottom and cyclic ghost cells.
+        cuda_safe_call(cudaMemcpy(p.fld_g, p.fld.data(), gd.ncells*sizeof(TF), cudaMemcpyHostToDevice));
+    }
+    else
+    {
+        fft_forward(fields.sd.at("p")->fld_g, tmp1->fld_g, tmp2->fld_g);
+
+        launch_grid_kernel<Pres_2_kernels::solve_in_g<TF>>(
+                grid_layout_nogc,
+                fields.sd.at("p")->fld_g.view(),
+                tmp1->fld_g,
+                tmp2->fld_g.view(),
+                a_g, c_g, gd.dz_g,
+                fields.rhoref_g,
+                bmati_g, bmatj_g,
+                gd.kstart, gd.kmax);
+
+        // DOES NOT WORK (YET):
+        launch_grid_kernel<Pres_2_kernels::tdma_g<TF>>(
+                grid_layout_2d_nogc,
+                a_g,
+                tmp2->fld_g,
+                c_g,
+                fields.sd.at("p")->fld_g.view(),
+                tmp1->fld_g.view(),
+                gd.kmax);
+
+        fft_backward(fields.sd.at("p")->fld_g, tmp1->fld_g, tmp2->fld_g);
+
+        launch_grid_kernel<Pres_2_kernels::solve_out_g<TF>>(
+                grid_layout_nogc,
+                fields.sd.at("p")->fld_g.view(),
+                tmp2->fld_g,
+                TF(1.)/(gd.itot*gd.jtot),
+                gd.istart, gd.jstart, gd.kstart,
+                gd.icells, gd.ijcells);
+
+        boundary_cyclic.exec_g(fields.sd.at("p")->fld_g);
+    }
 
     launch_grid_kernel<Pres_2_kernels::pres_out_g<TF>>(
             grid_layout_int,
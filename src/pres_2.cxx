@@ -23,6 +23,8 @@
 #include <cstdio>
 #include <cmath>
 #include <algorithm>
+#include <vector>
+#include <stdexcept>
 #include "master.h"
 #include "grid.h"
 #include "fields.h"
@@ -36,10 +38,14 @@ Pres_2<TF>::Pres_2(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, FFT
     Pres<TF>(masterin, gridin, fieldsin, fftin, inputin),
     boundary_cyclic(master, grid)
 {
+    swcachelu = inputin.get_item<bool>("pres", "swcachelu", "", false);
+
     #ifdef USECUDA
+    if (swcachelu)
+        throw std::runtime_error("swcachelu is not supported in the CUDA version");
+
     a_g = 0;
     c_g = 0;
-    work2d_g = 0;
     bmati_g  = 0;
     bmatj_g  = 0;
     #endif
@@ -104,6 +110,85 @@ TF Pres_2<TF>::check_divergence()
 }
 #endif
 
+namespace
+{
+    // Forward elimination of tdma without a right hand side, of which the inverse pivots
+    // and the upper diagonal are stored such that each solve only needs the substitutions.
+    template<typename TF>
+    void tdma_factorize(const TF* const restrict a, const TF* const restrict b, const TF* const restrict c,
+                        double* const restrict pivot_inv, double* const restrict gamma,
+                        const int iblock, const int jblock, const int kmax)
+    {
+        const int jj = iblock;
+        const int kk = iblock*jblock;
+
+        #pragma omp parallel for
+        for (int j=0; j<jblock; j++)
+        {
+            #pragma ivdep
+            for (int i=0; i<iblock; i++)
+            {
+                const int ij = i + j*jj;
+                pivot_inv[ij] = 1./double(b[ij]);
+                gamma[ij] = 0.;
+            }
+
+            for (int k=1; k<kmax; k++)
+                #pragma ivdep
+                for (int i=0; i<iblock; i++)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    gamma[ijk] = c[k-1] * pivot_inv[ijk-kk];
+                    pivot_inv[ijk] = 1./(b[ijk] - a[k]*gamma[ijk]);
+                }
+        }
+    }
+
+    template<typename TF>
+    void tdma_substitute(const TF* const restrict a,
+                         const double* const restrict pivot_inv, const double* const restrict gamma,
+                         TF* const restrict p,
+                         const int iblock, const int jblock, const int kmax)
+    {
+        const int jj = iblock;
+        const int kk = iblock*jblock;
+
+        #pragma omp parallel
+        {
+            std::vector<double> p_prev(iblock);
+
+            #pragma omp for
+            for (int j=0; j<jblock; j++)
+            {
+                #pragma ivdep
+                for (int i=0; i<iblock; i++)
+                {
+                    const int ij = i + j*jj;
+                    p_prev[i] = p[ij] * pivot_inv[ij];
+                    p[ij] = p_prev[i];
+                }
+
+                for (int k=1; k<kmax; k++)
+                    #pragma ivdep
+                    for (int i=0; i<iblock; i++)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        p_prev[i] = (p[ijk] - a[k]*p_prev[i]) * pivot_inv[ijk];
+                        p[ijk] = p_prev[i];
+                    }
+
+                for (int k=kmax-2; k>=0; k--)
+                    #pragma ivdep
+                    for (int i=0; i<iblock; i++)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        p[ijk] -= gamma[ijk+kk]*p[ijk+kk];
+                    }
+            }
+        }
+    }
+}
+
 template<typename TF>
 void Pres_2<TF>::init()
 {
@@ -115,8 +200,6 @@ void Pres_2<TF>::init()
     a.resize(gd.kmax);
     c.resize(gd.kmax);
 
-    work2d.resize(gd.imax*gd.jmax);
-
     boundary_cyclic.init();
     fft.init();
 }
@@ -127,19 +210,20 @@ void Pres_2<TF>::set_values()
     const Grid_data<TF>& gd = grid.get_grid_data();
 
     // Compute the modified wave numbers of the 2nd order scheme.
-    const TF dxidxi = 1./(gd.dx*gd.dx);
-    const TF dyidyi = 1./(gd.dy*gd.dy);
+    // The wave numbers are evaluated in double and only rounded on storage.
+    const double dxidxi = 1./(double(gd.dx)*gd.dx);
+    const double dyidyi = 1./(double(gd.dy)*gd.dy);
 
-    const TF pi = std::acos(-1.);
+    const double pi = std::acos(-1.);
 
     for (int j=0; j<gd.jtot/2+1; ++j)
-        bmatj[j] = 2. * (std::cos(2.*pi*(TF)j/(TF)gd.jtot)-1.) * dyidyi;
+        bmatj[j] = 2. * (std::cos(2.*pi*double(j)/double(gd.jtot))-1.) * dyidyi;
 
     for (int j=gd.jtot/2+1; j<gd.jtot; ++j)
         bmatj[j] = bmatj[gd.jtot-j];
 
     for (int i=0; i<gd.itot/2+1; ++i)
-        bmati[i] = 2. * (std::cos(2.*pi*(TF)i/(TF)gd.itot)-1.) * dxidxi;
+        bmati[i] = 2. * (std::cos(2.*pi*double(i)/double(gd.itot))-1.) * dxidxi;
 
     for (int i=gd.itot/2+1; i<gd.itot; ++i)
         bmati[i] = bmati[gd.itot-i];
@@ -150,6 +234,22 @@ void Pres_2<TF>::set_values()
         a[k] = gd.dz[k+gd.kgc] * fields.rhorefh[k+gd.kgc  ]*gd.dzhi[k+gd.kgc  ];
         c[k] = gd.dz[k+gd.kgc] * fields.rhorefh[k+gd.kgc+1]*gd.dzhi[k+gd.kgc+1];
     }
+
+    // The matrices only depend on the wave numbers and the reference profiles,
+    // so the forward elimination can be done once here.
+    if (swcachelu)
+    {
+        const int ncells = gd.iblock*gd.jblock*gd.kmax;
+
+        std::vector<TF> b(ncells);
+        set_diagonal(b.data(), gd.dz.data(), fields.rhoref.data());
+
+        pivot_inv.resize(ncells);
+        gamma.resize(ncells);
+
+        tdma_factorize(a.data(), b.data(), c.data(), pivot_inv.data(), gamma.data(),
+                       gd.iblock, gd.jblock, gd.kmax);
+    }
 }
 
 template<typename TF>
@@ -181,6 +281,7 @@ void Pres_2<TF>::input(TF* const restrict p,
     boundary_cyclic.exec(vt, Edge::North_south_edge);
 
     // write pressure as a 3d array without ghost cells
+    #pragma omp parallel for
     for (int k=0; k<gd.kmax; ++k)
         for (int j=0; j<gd.jmax; ++j)
             #pragma ivdep
@@ -198,153 +299,178 @@ void Pres_2<TF>::input(TF* const restrict p,
 namespace
 {
     // tridiagonal matrix solver, taken from Numerical Recipes, Press
+    // The columns are independent, so the solver is parallelized over j with
+    // each thread doing the forward and backward sweep of its own slab.
+    // The pivots and the forward recurrence are carried in double precision,
+    // such that a single precision build does not lose the small differences
+    // of the low wave numbers that set the mass conservation of the solution.
     template<typename TF>
-    void tdma(TF* const restrict a, TF* const restrict b, TF* const restrict c,
-              TF* const restrict p, TF* const restrict work2d, TF* const restrict work3d,
+    void tdma(const TF* const restrict a, const TF* const restrict b, const TF* const restrict c,
+              TF* const restrict p, TF* const restrict work3d,
               const int iblock, const int jblock, const int kmax)
 
     {
         const int jj = iblock;
         const int kk = iblock*jblock;
 
-        for (int j=0; j<jblock; j++)
-            #pragma ivdep
-            for (int i=0; i<iblock; i++)
-            {
-                const int ij = i + j*jj;
-                work2d[ij] = b[ij];
-            }
-
-        for (int j=0; j<jblock; j++)
-            #pragma ivdep
-            for (int i=0; i<iblock; i++)
-            {
-                const int ij = i + j*jj;
-                p[ij] /= work2d[ij];
-            }
-
-        for (int k=1; k<kmax; k++)
+        #pragma omp parallel
         {
+            std::vector<double> pivot(iblock);
+            std::vector<double> p_prev(iblock);
+
+            #pragma omp for
             for (int j=0; j<jblock; j++)
+            {
                 #pragma ivdep
                 for (int i=0; i<iblock; i++)
                 {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + k*kk;
-                    work3d[ijk] = c[k-1] / work2d[ij];
-                }
-            for (int j=0; j<jblock; j++)
-                #pragma ivdep
-                for (int i=0; i<iblock; i++)
-                {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + k*kk;
-                    work2d[ij] = b[ijk] - a[k]*work3d[ijk];
-                }
-            for (int j=0; j<jblock; j++)
-                #pragma ivdep
-                for (int i=0; i<iblock; i++)
-                {
-                    const int ij  = i + j*jj;
-                    const int ijk = i + j*jj + k*kk;
-                    p[ijk] -= a[k]*p[ijk-kk];
-                    p[ijk] /= work2d[ij];
+                    const int ij = i + j*jj;
+                    pivot[i] = b[ij];
+                    p_prev[i] = p[ij] / pivot[i];
+                    p[ij] = p_prev[i];
                 }
-        }
 
-        for (int k=kmax-2; k>=0; k--)
-            for (int j=0; j<jblock; j++)
-                #pragma ivdep
-                for (int i=0; i<iblock; i++)
+                for (int k=1; k<kmax; k++)
                 {
-                    const int ijk = i + j*jj + k*kk;
-                    p[ijk] -= work3d[ijk+kk]*p[ijk+kk];
+                    #pragma ivdep
+                    for (int i=0; i<iblock; i++)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        const double gamma = c[k-1] / pivot[i];
+                        work3d[ijk] = gamma;
+                        pivot[i] = b[ijk] - a[k]*gamma;
+                        p_prev[i] = (p[ijk] - a[k]*p_prev[i]) / pivot[i];
+                        p[ijk] = p_prev[i];
+                    }
                 }
+
+                for (int k=kmax-2; k>=0; k--)
+                    #pragma ivdep
+                    for (int i=0; i<iblock; i++)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        p[ijk] -= work3d[ijk+kk]*p[ijk+kk];
+                    }
+            }
+        }
     }
 }
 
 template<typename TF>
-void Pres_2<TF>::solve(TF* const restrict p, TF* const restrict work3d, TF* const restrict b,
-                       const TF* const restrict dz, const TF* const restrict rhoref)
+void Pres_2<TF>::set_diagonal(TF* const restrict b, const TF* const restrict dz, const TF* const restrict rhoref)
 {
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
 
-    const int imax   = gd.imax;
-    const int jmax   = gd.jmax;
     const int kmax   = gd.kmax;
     const int iblock = gd.iblock;
     const int jblock = gd.jblock;
-    const int igc    = gd.igc;
-    const int jgc    = gd.jgc;
     const int kgc    = gd.kgc;
 
-    int i,j,k,jj,kk,ijk;
-    int iindex,jindex;
-
-    fft.exec_forward(p, work3d);
-
-    jj = iblock;
-    kk = iblock*jblock;
+    const int jj = iblock;
+    const int kk = iblock*jblock;
 
-    // solve the tridiagonal system
     // create vectors that go into the tridiagonal matrix solver
-    for (k=0; k<kmax; k++)
-        for (j=0; j<jblock; j++)
+    #pragma omp parallel for
+    for (int k=0; k<kmax; k++)
+        for (int j=0; j<jblock; j++)
             #pragma ivdep
-            for (i=0; i<iblock; i++)
+            for (int i=0; i<iblock; i++)
             {
                 // swap the mpicoords, because domain is turned 90 degrees to avoid two mpi transposes
-                iindex = md.mpicoordy * iblock + i;
-                jindex = md.mpicoordx * jblock + j;
+                const int iindex = md.mpicoordy * iblock + i;
+                const int jindex = md.mpicoordx * jblock + j;
 
-                ijk  = i + j*jj + k*kk;
-                b[ijk] = dz[k+kgc]*dz[k+kgc] * rhoref[k+kgc]*(bmati[iindex]+bmatj[jindex]) - (a[k]+c[k]);
-                p[ijk] = dz[k+kgc]*dz[k+kgc] * p[ijk];
+                const int ijk = i + j*jj + k*kk;
+                // Form the diagonal in double, the sum of the wave numbers nearly
+                // cancels the vertical terms for the lowest horizontal modes.
+                b[ijk] = double(dz[k+kgc])*dz[k+kgc] * rhoref[k+kgc]*(double(bmati[iindex])+bmatj[jindex])
+                       - (double(a[k])+c[k]);
             }
 
-    for (j=0; j<jblock; j++)
+    for (int j=0; j<jblock; j++)
         #pragma ivdep
-        for (i=0; i<iblock; i++)
+        for (int i=0; i<iblock; i++)
         {
-            iindex = md.mpicoordy * iblock + i;
-            jindex = md.mpicoordx * jblock + j;
+            const int iindex = md.mpicoordy * iblock + i;
+            const int jindex = md.mpicoordx * jblock + j;
 
             // substitute BC's
-            ijk = i + j*jj;
-            b[ijk] += a[0];
+            const int ij = i + j*jj;
+            b[ij] += a[0];
 
             // for wave number 0, which contains average, set pressure at top to zero
-            ijk  = i + j*jj + (kmax-1)*kk;
+            const int ijk = i + j*jj + (kmax-1)*kk;
             if (iindex == 0 && jindex == 0)
                 b[ijk] -= c[kmax-1];
             // set dp/dz at top to zero
             else
                 b[ijk] += c[kmax-1];
         }
+}
 
-    // call tdma solver
-    tdma(a.data(), b, c.data(), p, work2d.data(), work3d,
-         gd.iblock, gd.jblock, gd.kmax);
+template<typename TF>
+void Pres_2<TF>::solve(TF* const restrict p, TF* const restrict work3d, TF* const restrict b,
+                       const TF* const restrict dz, const TF* const restrict rhoref)
+{
+    auto& gd = grid.get_grid_data();
+
+    const int imax   = gd.imax;
+    const int jmax   = gd.jmax;
+    const int kmax   = gd.kmax;
+    const int iblock = gd.iblock;
+    const int jblock = gd.jblock;
+    const int igc    = gd.igc;
+    const int jgc    = gd.jgc;
+    const int kgc    = gd.kgc;
+
+    fft.exec_forward(p, work3d);
+
+    const int jj = iblock;
+    const int kk = iblock*jblock;
+
+    // solve the tridiagonal system
+    #pragma omp parallel for
+    for (int k=0; k<kmax; k++)
+        for (int j=0; j<jblock; j++)
+            #pragma ivdep
+            for (int i=0; i<iblock; i++)
+            {
+                const int ijk = i + j*jj + k*kk;
+                p[ijk] = dz[k+kgc]*dz[k+kgc] * p[ijk];
+            }
+
+    // With a cached factorization only the substitutions remain.
+    if (swcachelu)
+        tdma_substitute(a.data(), pivot_inv.data(), gamma.data(), p,
+                        gd.iblock, gd.jblock, gd.kmax);
+    else
+    {
+        set_diagonal(b, dz, rhoref);
+
+        // call tdma solver
+        tdma(a.data(), b, c.data(), p, work3d,
+             gd.iblock, gd.jblock, gd.kmax);
+    }
 
     fft.exec_backward(p, work3d);
 
-    jj = imax;
-    kk = imax*jmax;
+    const int jjp = imax;
+    const int kkp = imax*jmax;
 
-    int ijkp,jjp,kkp;
-    jjp = gd.icells;
-    kkp = gd.ijcells;
+    const int jjc = gd.icells;
+    const int kkc = gd.ijcells;
 
     // put the pressure back onto the original grid including ghost cells
+    #pragma omp parallel for
     for (int k=0; k<gd.kmax; ++k)
         for (int j=0; j<gd.jmax; ++j)
             #pragma ivdep
             for (int i=0; i<gd.imax; ++i)
             {
-                ijkp = i+igc + (j+jgc)*jjp + (k+kgc)*kkp;
-                ijk  = i + j*jj + k*kk;
-                p[ijkp] = work3d[ijk];
+                const int ijkc = i+igc + (j+jgc)*jjc + (k+kgc)*kkc;
+                const int ijkp = i + j*jjp + k*kkp;
+                p[ijkc] = work3d[ijkp];
             }
 
     // set the boundary conditions
@@ -353,8 +479,8 @@ void Pres_2<TF>::solve(TF* const restrict p, TF* const restrict work3d, TF* cons
         #pragma ivdep
         for (int i=gd.istart; i<gd.iend; ++i)
         {
-            ijk = i + j*jjp + gd.kstart*kkp;
-            p[ijk-kkp] = p[ijk];
+            const int ijk = i + j*jjc + gd.kstart*kkc;
+            p[ijk-kkc] = p[ijk];
         }
 
     // set the cyclic boundary conditions
@@ -374,6 +500,7 @@ void Pres_2<TF>::output(TF* const restrict ut, TF* const restrict vt, TF* const
     const TF dxi = TF(1.)/gd.dx;
     const TF dyi = TF(1.)/gd.dy;
 
+    #pragma omp parallel for
     for (int k=gd.kstart; k<gd.kend; ++k)
         for (int j=gd.jstart; j<gd.jend; ++j)
             #pragma ivdep
@@ -152,7 +152,7 @@ namespace
                 m1temp[ik+kki2] = m1[k];
                 m2temp[ik+kki2] = m2[k];
                 m3temp[ik+kki2] = m3[k];
-                m4temp[ik+kki2] = m4[k] + bmati[iindex] + bmatj[jindex];
+                m4temp[ik+kki2] = double(m4[k]) + double(bmati[iindex]) + double(bmatj[jindex]);
                 m5temp[ik+kki2] = m5[k];
                 m6temp[ik+kki2] = m6[k];
                 m7temp[ik+kki2] = m7[k];
@@ -340,7 +340,7 @@ namespace
     }
 
     template<typename TF> __global__
-    void solve_out_g(TF* __restrict__ p, TF* __restrict__ work3d,
+    void solve_out_g(TF* __restrict__ p, TF* __restrict__ work3d, const TF norm,
                      const int jj, const int kk,
                      const int jjp, const int kkp,
                      const int istart, const int jstart, const int kstart,
@@ -358,7 +358,7 @@ namespace
             const int ijk  = i + j*jj + k*kk;
             const int ijkp = i+istart + (j+jstart)*jjp + (k+kstart)*kkp;
 
-            p[ijkp] = work3d[ijk];
+            p[ijkp] = norm*work3d[ijk];
 
             // set the BC
             if (k == 0)
@@ -446,6 +446,10 @@ void Pres_4<TF>::prepare_device()
 {
     auto& gd = grid.get_grid_data();
 
+    set_fft_backend();
+    if (fft_backend != Fft_backend::Cufft)
+        throw std::runtime_error("Pres_4 on the GPU requires fftbackend=cufft on a single process, use swspatialorder=2");
+
     const int kmemsize = gd.kmax*sizeof(TF);
     const int imemsize = gd.itot*sizeof(TF);
     const int jmemsize = gd.jtot*sizeof(TF);
@@ -592,10 +596,8 @@ void Pres_4<TF>::exec(double dt, Stats<TF>& stats)
 
     fft_backward(fields.sd.at("p")->fld_g, tmp1->fld_g, tmp2->fld_g);
 
-    cuda_safe_call(cudaMemcpy(tmp1->fld_g, fields.sd.at("p")->fld_g, gd.ncells*sizeof(TF), cudaMemcpyDeviceToDevice));
-
     solve_out_g<TF><<<gridGPU, blockGPU>>>(
-        fields.sd.at("p")->fld_g, tmp1->fld_g,
+        fields.sd.at("p")->fld_g, tmp2->fld_g, TF(1.)/(gd.itot*gd.jtot),
         gd.imax, gd.imax*gd.jmax,
         gd.icells, gd.ijcells,
         gd.istart, gd.jstart, gd.kstart,
@@ -26,6 +26,7 @@
 #include <cstdio>
 #include <cmath>
 #include <algorithm>
+#include <stdexcept>
 #include <fftw3.h>
 #include "master.h"
 #include "grid.h"
@@ -43,7 +44,12 @@ Pres_4<TF>::Pres_4(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, FFT
     Pres<TF>(masterin, gridin, fieldsin, fftin, inputin),
     boundary_cyclic(master, grid)
 {
+    swcachelu = inputin.get_item<bool>("pres", "swcachelu", "", false);
+
     #ifdef USECUDA
+    if (swcachelu)
+        throw std::runtime_error("swcachelu is not supported in the CUDA version");
+
     bmati_g = 0;
     bmatj_g = 0;
     m1_g = 0;
@@ -186,10 +192,11 @@ void Pres_4<TF>::set_values()
     const int kstart = gd.kstart;
 
     // compute the modified wave numbers of the 4th order scheme
-    const TF dxidxi = 1./(gd.dx*gd.dx);
-    const TF dyidyi = 1./(gd.dy*gd.dy);
+    // The wave numbers are evaluated in double and only rounded on storage.
+    const double dxidxi = 1./(double(gd.dx)*gd.dx);
+    const double dyidyi = 1./(double(gd.dy)*gd.dy);
 
-    const TF pi = std::acos(-1.);
+    const double pi = std::acos(-1.);
 
     // Convert the coefficients to float after calculation.
     for (int j=0; j<jtot/2+1; j++)
@@ -249,6 +256,36 @@ void Pres_4<TF>::set_values()
     m5[k] = (1./576.) * (                  +  27.*dzhi4[kc] + 729.*dzhi4[kc+1] -  1.*dzhi4[kc] ) * dzi4[kc];
     m6[k] = (1./576.) * (                                   -  27.*dzhi4[kc+1]                 ) * dzi4[kc];
     m7[k] = 0.;
+
+    // The matrices only depend on the wave numbers and the vertical grid, so their
+    // factorization can be done once here for all slices of the transposed block.
+    if (swcachelu)
+    {
+        const int jslice = 1;
+        const int nj = gd.jblock/jslice;
+        const int ns = gd.iblock*jslice*(gd.kmax+4);
+
+        lu1.resize(nj*ns);
+        lu2.resize(nj*ns);
+        lu3.resize(nj*ns);
+        lu4.resize(nj*ns);
+        lu5.resize(nj*ns);
+        lu6.resize(nj*ns);
+        lu7.resize(nj*ns);
+
+        #pragma omp parallel for
+        for (int n=0; n<nj; ++n)
+        {
+            set_matrix(&lu1[n*ns], &lu2[n*ns], &lu3[n*ns], &lu4[n*ns],
+                       &lu5[n*ns], &lu6[n*ns], &lu7[n*ns],
+                       m1.data(), m2.data(), m3.data(), m4.data(),
+                       m5.data(), m6.data(), m7.data(),
+                       bmati.data(), bmatj.data(), n, jslice);
+
+            hdma_factorize(&lu1[n*ns], &lu2[n*ns], &lu3[n*ns], &lu4[n*ns],
+                           &lu5[n*ns], &lu6[n*ns], &lu7[n*ns], jslice);
+        }
+    }
 }
 
 template<typename TF>
@@ -340,16 +377,10 @@ void Pres_4<TF>::solve(
     fft.exec_forward(p, work3d);
 
     int jj,kk,ik,ijk;
-    int iindex,jindex;
 
     jj = iblock;
     kk = iblock*jblock;
 
-    auto& md = master.get_MPI_data();
-
-    const int mpicoordx = md.mpicoordx;
-    const int mpicoordy = md.mpicoordy;
-
     // Calculate the step size.
     const int nj = jblock/jslice;
 
@@ -357,130 +388,109 @@ void Pres_4<TF>::solve(
     const int kki2 = 2*iblock*jslice;
     const int kki3 = 3*iblock*jslice;
 
-    for (int n=0; n<nj; ++n)
+    if (swcachelu)
     {
-        for (int j=0; j<jslice; ++j)
-            #pragma ivdep
-            for (int i=0; i<iblock; ++i)
-            {
-                // Set a zero gradient bc at the bottom.
-                ik = i + j*jj;
-                m1temp[ik] = TF( 0.);
-                m2temp[ik] = TF( 0.);
-                m3temp[ik] = TF( 0.);
-                m4temp[ik] = TF( 1.);
-                m5temp[ik] = TF( 0.);
-                m6temp[ik] = TF( 0.);
-                m7temp[ik] = TF(-1.);
-                ptemp [ik] = TF( 0.);
-            }
+        // The matrices are factorized in advance, thus only the substitution remains. The slices
+        // are independent, and each one stores its right hand side in its own part of work3d,
+        // which is not in use in between the forward and the backward transform.
+        const int ns = iblock*jslice*(kmax+4);
 
-        for (int j=0; j<jslice; ++j)
-            #pragma ivdep
-            for (int i=0; i<iblock; ++i)
-            {
-                ik = i + j*jj;
-                m1temp[ik+kki1] = TF( 0.);
-                m2temp[ik+kki1] = TF( 0.);
-                m3temp[ik+kki1] = TF( 0.);
-                m4temp[ik+kki1] = TF( 1.);
-                m5temp[ik+kki1] = TF(-1.);
-                m6temp[ik+kki1] = TF( 0.);
-                m7temp[ik+kki1] = TF( 0.);
-                ptemp [ik+kki1] = TF( 0.);
-            }
+        #pragma omp parallel for
+        for (int n=0; n<nj; ++n)
+        {
+            TF* restrict ptemp_n = &work3d[n*ns];
 
-        for (int k=0; k<kmax; ++k)
             for (int j=0; j<jslice; ++j)
-            {
-                jindex = mpicoordx*jblock + n*jslice + j;
                 #pragma ivdep
                 for (int i=0; i<iblock; ++i)
                 {
-                    // Swap the mpicoords, because domain is turned 90 degrees to avoid two mpi transposes.
-                    iindex = mpicoordy*iblock + i;
-
-                    ijk = i + (j + n*jslice)*jj + k*kk;
-                    ik  = i + j*jj + k*kki1;
-                    m1temp[ik+kki2] = m1[k];
-                    m2temp[ik+kki2] = m2[k];
-                    m3temp[ik+kki2] = m3[k];
-                    m4temp[ik+kki2] = m4[k] + bmati[iindex] + bmatj[jindex];
-                    m5temp[ik+kki2] = m5[k];
-                    m6temp[ik+kki2] = m6[k];
-                    m7temp[ik+kki2] = m7[k];
-                    ptemp [ik+kki2] = p[ijk];
+                    const int ik = i + j*jj;
+                    ptemp_n[ik     ] = TF(0.);
+                    ptemp_n[ik+kki1] = TF(0.);
                 }
-            }
 
-        for (int j=0; j<jslice; ++j)
-        {
-            jindex = mpicoordx*jblock + n*jslice + j;
-            #pragma ivdep
-            for (int i=0; i<iblock; ++i)
-            {
-                // Swap the mpicoords, because domain is turned 90 degrees to avoid two mpi transposes.
-                iindex = mpicoordy*iblock + i;
+            for (int k=0; k<kmax; ++k)
+                for (int j=0; j<jslice; ++j)
+                    #pragma ivdep
+                    for (int i=0; i<iblock; ++i)
+                    {
+                        const int ik  = i + j*jj + k*kki1;
+                        const int ijk = i + (j + n*jslice)*jj + k*kk;
+                        ptemp_n[ik+kki2] = p[ijk];
+                    }
 
-                // Set the top boundary.
-                ik = i + j*jj + kmax*kki1;
-                if (iindex == 0 && jindex == 0)
-                {
-                    m1temp[ik+kki2] = TF(   0.);
-                    m2temp[ik+kki2] = TF(-1/3.);
-                    m3temp[ik+kki2] = TF(   2.);
-                    m4temp[ik+kki2] = TF(   1.);
-
-                    m1temp[ik+kki3] = TF(  -2.);
-                    m2temp[ik+kki3] = TF(   9.);
-                    m3temp[ik+kki3] = TF(   0.);
-                    m4temp[ik+kki3] = TF(   1.);
-                }
-                // Set dp/dz at top to zero.
-                else
+            for (int j=0; j<jslice; ++j)
+                #pragma ivdep
+                for (int i=0; i<iblock; ++i)
                 {
-                    m1temp[ik+kki2] = TF( 0.);
-                    m2temp[ik+kki2] = TF( 0.);
-                    m3temp[ik+kki2] = TF(-1.);
-                    m4temp[ik+kki2] = TF( 1.);
-
-                    m1temp[ik+kki3] = TF(-1.);
-                    m2temp[ik+kki3] = TF( 0.);
-                    m3temp[ik+kki3] = TF( 0.);
-                    m4temp[ik+kki3] = TF( 1.);
+                    const int ik = i + j*jj + kmax*kki1;
+                    ptemp_n[ik+kki2] = TF(0.);
+                    ptemp_n[ik+kki3] = TF(0.);
                 }
-            }
+
+            hdma_substitute(&lu1[n*ns], &lu2[n*ns], &lu3[n*ns], &lu4[n*ns],
+                            &lu5[n*ns], &lu6[n*ns], &lu7[n*ns], ptemp_n, jslice);
+
+            // Put back the solution.
+            for (int k=0; k<kmax; ++k)
+                for (int j=0; j<jslice; ++j)
+                    #pragma ivdep
+                    for (int i=0; i<iblock; ++i)
+                    {
+                        const int ik  = i + j*jj + k*kki1;
+                        const int ijk = i + (j + n*jslice)*jj + k*kk;
+                        p[ijk] = ptemp_n[ik+kki2];
+                    }
         }
+    }
+    else
+    {
+        for (int n=0; n<nj; ++n)
+        {
+            set_matrix(m1temp, m2temp, m3temp, m4temp, m5temp, m6temp, m7temp,
+                       m1, m2, m3, m4, m5, m6, m7, bmati, bmatj, n, jslice);
 
-        for (int j=0; j<jslice; ++j)
-            #pragma ivdep
-            for (int i=0; i<iblock; ++i)
-            {
-                // Set the top boundary.
-                ik = i + j*jj + kmax*kki1;
-                m5temp[ik+kki2] = TF(0.);
-                m6temp[ik+kki2] = TF(0.);
-                m7temp[ik+kki2] = TF(0.);
-                ptemp [ik+kki2] = TF(0.);
-
-                m5temp[ik+kki3] = TF(0.);
-                m6temp[ik+kki3] = TF(0.);
-                m7temp[ik+kki3] = TF(0.);
-                ptemp [ik+kki3] = TF(0.);
-            }
+            for (int j=0; j<jslice; ++j)
+                #pragma ivdep
+                for (int i=0; i<iblock; ++i)
+                {
+                    ik = i + j*jj;
+                    ptemp[ik     ] = TF(0.);
+                    ptemp[ik+kki1] = TF(0.);
+                }
 
-        hdma(m1temp, m2temp, m3temp, m4temp, m5temp, m6temp, m7temp, ptemp, jslice);
+            for (int k=0; k<kmax; ++k)
+                for (int j=0; j<jslice; ++j)
+                    #pragma ivdep
+                    for (int i=0; i<iblock; ++i)
+                    {
+                        ik  = i + j*jj + k*kki1;
+                        ijk = i + (j + n*jslice)*jj + k*kk;
+                        ptemp[ik+kki2] = p[ijk];
+                    }
 
-        // Put back the solution.
-        for (int k=0; k<kmax; ++k)
             for (int j=0; j<jslice; ++j)
                 #pragma ivdep
                 for (int i=0; i<iblock; ++i)
                 {
-                    const int ik  = i + j*jj + k*kki1;
-                    const int ijk = i + (j + n*jslice)*jj + k*kk;
-                    p[ijk] = ptemp[ik+kki2];
+                    ik = i + j*jj + kmax*kki1;
+                    ptemp[ik+kki2] = TF(0.);
+                    ptemp[ik+kki3] = TF(0.);
                 }
+
+            hdma(m1temp, m2temp, m3temp, m4temp, m5temp, m6temp, m7temp, ptemp, jslice);
+
+            // Put back the solution.
+            for (int k=0; k<kmax; ++k)
+                for (int j=0; j<jslice; ++j)
+                    #pragma ivdep
+                    for (int i=0; i<iblock; ++i)
+                    {
+                        const int ik  = i + j*jj + k*kki1;
+                        const int ijk = i + (j + n*jslice)*jj + k*kk;
+                        p[ijk] = ptemp[ik+kki2];
+                    }
+        }
     }
 
     fft.exec_backward(p, work3d);
@@ -570,11 +580,157 @@ void Pres_4<TF>::output(TF* restrict ut, TF* restrict vt, TF* restrict wt,
             }
 }
 
+template<typename TF>
+void Pres_4<TF>::set_matrix(
+        TF* restrict m1temp, TF* restrict m2temp, TF* restrict m3temp, TF* restrict m4temp,
+        TF* restrict m5temp, TF* restrict m6temp, TF* restrict m7temp,
+        const TF* restrict m1, const TF* restrict m2, const TF* restrict m3, const TF* restrict m4,
+        const TF* restrict m5, const TF* restrict m6, const TF* restrict m7,
+        const TF* restrict bmati, const TF* restrict bmatj,
+        const int n, const int jslice)
+{
+    auto& gd = grid.get_grid_data();
+
+    const int kmax   = gd.kmax;
+    const int iblock = gd.iblock;
+    const int jblock = gd.jblock;
+
+    const int jj = iblock;
+
+    auto& md = master.get_MPI_data();
+
+    const int mpicoordx = md.mpicoordx;
+    const int mpicoordy = md.mpicoordy;
+
+    const int kki1 = 1*iblock*jslice;
+    const int kki2 = 2*iblock*jslice;
+    const int kki3 = 3*iblock*jslice;
+
+    int ik;
+    int iindex,jindex;
+
+    for (int j=0; j<jslice; ++j)
+        #pragma ivdep
+        for (int i=0; i<iblock; ++i)
+        {
+            // Set a zero gradient bc at the bottom.
+            ik = i + j*jj;
+            m1temp[ik] = TF( 0.);
+            m2temp[ik] = TF( 0.);
+            m3temp[ik] = TF( 0.);
+            m4temp[ik] = TF( 1.);
+            m5temp[ik] = TF( 0.);
+            m6temp[ik] = TF( 0.);
+            m7temp[ik] = TF(-1.);
+        }
+
+    for (int j=0; j<jslice; ++j)
+        #pragma ivdep
+        for (int i=0; i<iblock; ++i)
+        {
+            ik = i + j*jj;
+            m1temp[ik+kki1] = TF( 0.);
+            m2temp[ik+kki1] = TF( 0.);
+            m3temp[ik+kki1] = TF( 0.);
+            m4temp[ik+kki1] = TF( 1.);
+            m5temp[ik+kki1] = TF(-1.);
+            m6temp[ik+kki1] = TF( 0.);
+            m7temp[ik+kki1] = TF( 0.);
+        }
+
+    for (int k=0; k<kmax; ++k)
+        for (int j=0; j<jslice; ++j)
+        {
+            jindex = mpicoordx*jblock + n*jslice + j;
+            #pragma ivdep
+            for (int i=0; i<iblock; ++i)
+            {
+                // Swap the mpicoords, because domain is turned 90 degrees to avoid two mpi transposes.
+                iindex = mpicoordy*iblock + i;
+
+                ik = i + j*jj + k*kki1;
+                m1temp[ik+kki2] = m1[k];
+                m2temp[ik+kki2] = m2[k];
+                m3temp[ik+kki2] = m3[k];
+                // The diagonal is formed in double, as for the low wave numbers the
+                // horizontal terms are small compared to the vertical ones.
+                m4temp[ik+kki2] = double(m4[k]) + double(bmati[iindex]) + double(bmatj[jindex]);
+                m5temp[ik+kki2] = m5[k];
+                m6temp[ik+kki2] = m6[k];
+                m7temp[ik+kki2] = m7[k];
+            }
+        }
+
+    for (int j=0; j<jslice; ++j)
+    {
+        jindex = mpicoordx*jblock + n*jslice + j;
+        #pragma ivdep
+        for (int i=0; i<iblock; ++i)
+        {
+            // Swap the mpicoords, because domain is turned 90 degrees to avoid two mpi transposes.
+            iindex = mpicoordy*iblock + i;
+
+            // Set the top boundary.
+            ik = i + j*jj + kmax*kki1;
+            if (iindex == 0 && jindex == 0)
+            {
+                m1temp[ik+kki2] = TF(   0.);
+                m2temp[ik+kki2] = TF(-1/3.);
+                m3temp[ik+kki2] = TF(   2.);
+                m4temp[ik+kki2] = TF(   1.);
+
+                m1temp[ik+kki3] = TF(  -2.);
+                m2temp[ik+kki3] = TF(   9.);
+                m3temp[ik+kki3] = TF(   0.);
+                m4temp[ik+kki3] = TF(   1.);
+            }
+            // Set dp/dz at top to zero.
+            else
+            {
+                m1temp[ik+kki2] = TF( 0.);
+                m2temp[ik+kki2] = TF( 0.);
+                m3temp[ik+kki2] = TF(-1.);
+                m4temp[ik+kki2] = TF( 1.);
+
+                m1temp[ik+kki3] = TF(-1.);
+                m2temp[ik+kki3] = TF( 0.);
+                m3temp[ik+kki3] = TF( 0.);
+                m4temp[ik+kki3] = TF( 1.);
+            }
+        }
+    }
+
+    for (int j=0; j<jslice; ++j)
+        #pragma ivdep
+        for (int i=0; i<iblock; ++i)
+        {
+            // Set the top boundary.
+            ik = i + j*jj + kmax*kki1;
+            m5temp[ik+kki2] = TF(0.);
+            m6temp[ik+kki2] = TF(0.);
+            m7temp[ik+kki2] = TF(0.);
+
+            m5temp[ik+kki3] = TF(0.);
+            m6temp[ik+kki3] = TF(0.);
+            m7temp[ik+kki3] = TF(0.);
+        }
+}
+
 template<typename TF>
 void Pres_4<TF>::hdma(
         TF* restrict m1, TF* restrict m2, TF* restrict m3, TF* restrict m4,
         TF* restrict m5, TF* restrict m6, TF* restrict m7, TF* restrict p,
         const int jslice)
+{
+    hdma_factorize(m1, m2, m3, m4, m5, m6, m7, jslice);
+    hdma_substitute(m1, m2, m3, m4, m5, m6, m7, p, jslice);
+}
+
+template<typename TF>
+void Pres_4<TF>::hdma_factorize(
+        TF* restrict m1, TF* restrict m2, TF* restrict m3, TF* restrict m4,
+        TF* restrict m5, TF* restrict m6, TF* restrict m7,
+        const int jslice)
 {
     auto& gd = grid.get_grid_data();
 
@@ -685,6 +841,26 @@ void Pres_4<TF>::hdma(
             m6[ik] = (1.);
             m7[ik] = (1.);
         }
+}
+
+template<typename TF>
+void Pres_4<TF>::hdma_substitute(
+        const TF* restrict m1, const TF* restrict m2, const TF* restrict m3, const TF* restrict m4,
+        const TF* restrict m5, const TF* restrict m6, const TF* restrict m7, TF* restrict p,
+        const int jslice)
+{
+    auto& gd = grid.get_grid_data();
+
+    const int kmax   = gd.kmax;
+    const int iblock = gd.iblock;
+
+    const int jj = gd.iblock;
+
+    const int kk1 = 1*gd.iblock*jslice;
+    const int kk2 = 2*gd.iblock*jslice;
+    const int kk3 = 3*gd.iblock*jslice;
+
+    int k,ik;
 
     // Do the backward substitution.
     // First, solve Ly = p, forward.
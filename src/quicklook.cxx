@@ -0,0 +1,287 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "thermo.h"
+#include "microphys.h"
+#include "quicklook.h"
+#include "timeloop.h"
+#include "netcdf_interface.h"
+#include "constants.h"
+#include "defines.h"
+
+namespace
+{
+    template<typename TF>
+    void calc_path(
+            TF* const restrict path, const TF* const restrict fld,
+            const TF* const restrict rhoref, const TF* const restrict dz,
+            const int istart, const int iend, const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        for (int j=jstart; j<jend; ++j)
+            #pragma ivdep
+            for (int i=istart; i<iend; ++i)
+                path[i + j*icells] = TF(0.);
+
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ij = i + j*icells;
+                    const int ijk = ij + k*ijcells;
+                    path[ij] += rhoref[k] * fld[ijk] * dz[k];
+                }
+    }
+}
+
+template<typename TF>
+Quicklook<TF>::Quicklook(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& inputin) :
+    master(masterin), grid(gridin), fields(fieldsin)
+{
+    swquicklook = inputin.get_item<bool>("quicklook", "swquicklook", "", false);
+
+    if (swquicklook)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("swquicklook is not implemented on the GPU");
+        #endif
+
+        sampletime = inputin.get_item<double>("quicklook", "sampletime", "");
+        blocksize = inputin.get_item<int>("quicklook", "blocksize", "", 16);
+
+        for (auto& name : inputin.get_list<std::string>("quicklook", "fields", "", std::vector<std::string>()))
+        {
+            TF height = TF(0.);
+            if (name != "lwp" && name != "rr_bot")
+                height = inputin.get_item<TF>("quicklook", "height", name);
+
+            vars.push_back({name, height, 0});
+        }
+
+        if (vars.empty())
+            throw std::runtime_error("Empty fields in [quicklook]");
+    }
+    else
+    {
+        inputin.flag_as_used("quicklook", "sampletime", "");
+        inputin.flag_as_used("quicklook", "blocksize", "");
+        inputin.flag_as_used("quicklook", "fields", "");
+        inputin.flag_as_used("quicklook", "height", "");
+    }
+}
+
+template<typename TF>
+Quicklook<TF>::~Quicklook()
+{
+}
+
+template<typename TF>
+void Quicklook<TF>::init()
+{
+    if (!swquicklook)
+        return;
+
+    isampletime = convert_to_itime(sampletime);
+    if (isampletime == 0)
+        throw std::runtime_error("The sampletime in [quicklook] has to be positive");
+
+    auto& gd = grid.get_grid_data();
+
+    if (blocksize < 1 || gd.imax % blocksize != 0 || gd.jmax % blocksize != 0)
+        throw std::runtime_error("The blocksize in [quicklook] has to divide imax and jmax");
+
+    blocks.resize((gd.itot/blocksize) * (gd.jtot/blocksize));
+}
+
+template<typename TF>
+void Quicklook<TF>::create(Thermo<TF>& thermo, const std::string& sim_name_in)
+{
+    if (!swquicklook)
+        return;
+
+    sim_name = sim_name_in;
+
+    auto& gd = grid.get_grid_data();
+
+    for (auto& var : vars)
+    {
+        if (var.name == "lwp")
+        {
+            if (!thermo.check_field_exists("ql"))
+                throw std::runtime_error("Field \"lwp\" in [quicklook] requires a thermodynamics with ql");
+        }
+        else if (var.name != "rr_bot")
+        {
+            auto it = fields.ap.find(var.name);
+            if (it == fields.ap.end())
+                throw std::runtime_error("Field \"" + var.name + "\" in [quicklook] is not a prognostic field");
+
+            // Take the level nearest to the requested height.
+            const std::vector<TF>& z = (it->second->loc[2] == 0) ? gd.z : gd.zh;
+            const int kend = (it->second->loc[2] == 0) ? gd.kend : gd.kend+1;
+
+            if (var.height < TF(0.) || var.height > gd.zsize)
+                throw std::runtime_error("The height of \"" + var.name + "\" in [quicklook] is outside the domain");
+
+            var.k = gd.kstart;
+            for (int k=gd.kstart+1; k<kend; ++k)
+                if (std::abs(z[k] - var.height) < std::abs(z[var.k] - var.height))
+                    var.k = k;
+
+            var.height = z[var.k];
+        }
+    }
+}
+
+template<typename TF>
+unsigned long Quicklook<TF>::get_time_limit(unsigned long itime)
+{
+    if (!swquicklook)
+        return Constants::ulhuge;
+
+    return isampletime - itime % isampletime;
+}
+
+template<typename TF>
+bool Quicklook<TF>::do_quicklook(unsigned long itime)
+{
+    if (!swquicklook)
+        return false;
+
+    return (itime % isampletime == 0);
+}
+
+template<typename TF>
+void Quicklook<TF>::calc_blocks(const TF* const restrict fld, const int offset)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int nbx = gd.itot/blocksize;
+    const int ib0 = md.mpicoordx * (gd.imax/blocksize);
+    const int jb0 = md.mpicoordy * (gd.jmax/blocksize);
+
+    // Every process fills its own blocks, such that the sum over the processes completes the domain.
+    std::fill(blocks.begin(), blocks.end(), TF(0.));
+
+    for (int j=0; j<gd.jmax; ++j)
+        for (int i=0; i<gd.imax; ++i)
+        {
+            const int ijk = (i+gd.istart) + (j+gd.jstart)*gd.icells + offset;
+            blocks[(ib0 + i/blocksize) + (jb0 + j/blocksize)*nbx] += fld[ijk];
+        }
+
+    const TF nblocki = TF(1.) / (blocksize*blocksize);
+    for (int jb=jb0; jb<jb0+gd.jmax/blocksize; ++jb)
+        for (int ib=ib0; ib<ib0+gd.imax/blocksize; ++ib)
+            blocks[ib + jb*nbx] *= nblocki;
+
+    master.sum(blocks.data(), blocks.size());
+}
+
+template<typename TF>
+void Quicklook<TF>::exec(Thermo<TF>& thermo, Microphys<TF>& microphys, double time, int iotime)
+{
+    auto& gd = grid.get_grid_data();
+
+    const int nbx = gd.itot/blocksize;
+    const int nby = gd.jtot/blocksize;
+
+    std::stringstream filename;
+    filename << sim_name << ".quicklook." << std::setfill('0') << std::setw(7) << iotime << ".nc";
+
+    // Only the first process writes, the others take part in the calls without effect.
+    Netcdf_file data_file(master, filename.str(), Netcdf_mode::Create);
+    data_file.add_dimension("x", nbx);
+    data_file.add_dimension("y", nby);
+    data_file.add_dimension("time", 1);
+
+    std::vector<TF> x(nbx);
+    std::vector<TF> y(nby);
+    for (int i=0; i<nbx; ++i)
+        x[i] = (i + TF(0.5)) * blocksize * gd.dx;
+    for (int j=0; j<nby; ++j)
+        y[j] = (j + TF(0.5)) * blocksize * gd.dy;
+
+    Netcdf_variable<TF> x_var = data_file.template add_variable<TF>("x", {"x"});
+    x_var.add_attribute("units", "m");
+    x_var.add_attribute("long_name", "Block centre in the x-direction");
+    x_var.insert(x, {0});
+
+    Netcdf_variable<TF> y_var = data_file.template add_variable<TF>("y", {"y"});
+    y_var.add_attribute("units", "m");
+    y_var.add_attribute("long_name", "Block centre in the y-direction");
+    y_var.insert(y, {0});
+
+    Netcdf_variable<TF> time_var = data_file.template add_variable<TF>("time", {"time"});
+    time_var.add_attribute("units", "seconds since start");
+    time_var.add_attribute("long_name", "Time");
+    time_var.insert(static_cast<TF>(time), {0});
+
+    std::vector<TF> plane(gd.ijcells);
+
+    for (auto& var : vars)
+    {
+        if (var.name == "lwp")
+        {
+            auto ql = fields.get_tmp();
+            thermo.get_thermo_field(*ql, "ql", false, false);
+            calc_path(
+                    plane.data(), ql->fld.data(), fields.rhoref.data(), gd.dz.data(),
+                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                    gd.icells, gd.ijcells);
+            fields.release_tmp(ql);
+
+            calc_blocks(plane.data(), 0);
+        }
+        else if (var.name == "rr_bot")
+        {
+            microphys.get_surface_rain_rate(plane);
+            calc_blocks(plane.data(), 0);
+        }
+        else
+            calc_blocks(fields.ap.at(var.name)->fld.data(), var.k*gd.ijcells);
+
+        Netcdf_variable<TF> var_nc = data_file.template add_variable<TF>(var.name, {"y", "x"});
+        if (var.name != "lwp" && var.name != "rr_bot")
+            var_nc.add_attribute("height", var.height);
+        var_nc.insert(blocks, {0, 0});
+    }
+}
+
+
+#ifdef FLOAT_SINGLE
+template class Quicklook<float>;
+#else
+template class Quicklook<double>;
+#endif
@@ -577,6 +577,9 @@ void Radiation_gcss<TF>::exec_all_stats(
 
         for (auto& it : dumplist)
         {
+            if (!dump.do_dump_var(it))
+                continue;
+
             get_radiation_field(*output, it, thermo, timeloop);
             dump.save_dump(output->fld.data(), it, iotime);
         }
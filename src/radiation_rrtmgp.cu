@@ -39,6 +39,7 @@
 #include "Array.h"
 #include "Fluxes.h"
 #include "subset_kernels_cuda.h"
+#include "nvtx_range.h"
 
 using namespace Radiation_rrtmgp_functions;
 
@@ -683,6 +684,8 @@ void Radiation_rrtmgp<TF>::exec_longwave(
         const Array_gpu<Float,2>& h2o, const Array_gpu<Float,2>& clwp, const Array_gpu<Float,2>& ciwp,
         const bool compute_clouds, const int n_col)
 {
+    Nvtx_range range("radiation_longwave");
+
     constexpr int n_col_block = 1024;
 
     auto& gd = grid.get_grid_data();
@@ -753,31 +756,37 @@ void Radiation_rrtmgp<TF>::exec_longwave(
             const Array_gpu<Float,2>& emis_sfc_subset_in,
             const Array_gpu<Float,2>& lw_flux_dn_inc_subset_in,
             Fluxes_broadband_gpu& fluxes,
-            Fluxes_broadband_gpu& bnd_fluxes)
+            Fluxes_broadband_gpu& bnd_fluxes,
+            Array_gpu<Float,3>& gpt_flux_up,
+            Array_gpu<Float,3>& gpt_flux_dn,
+            Array_gpu<Float,2>& rel,
+            Array_gpu<Float,2>& rei)
     {
         const int n_col_in = col_e_in - col_s_in + 1;
         Gas_concs_gpu gas_concs_subset(*gas_concs_gpu, col_s_in, n_col_in);
 
         auto p_lev_subset = p_lev.subset({{ {col_s_in, col_e_in}, {1, n_lev} }});
 
-        kdist_lw_gpu->gas_optics(
-                p_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                p_lev_subset,
-                t_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                t_sfc.subset({{ {col_s_in, col_e_in} }}),
-                gas_concs_subset,
-                optical_props_subset_in,
-                sources_subset_in,
-                col_dry.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                t_lev.subset({{ {col_s_in, col_e_in}, {1, n_lev} }}) );
+        {
+            Nvtx_range range("lw_gas_optics");
+            kdist_lw_gpu->gas_optics(
+                    p_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
+                    p_lev_subset,
+                    t_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
+                    t_sfc.subset({{ {col_s_in, col_e_in} }}),
+                    gas_concs_subset,
+                    optical_props_subset_in,
+                    sources_subset_in,
+                    col_dry.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
+                    t_lev.subset({{ {col_s_in, col_e_in}, {1, n_lev} }}) );
+        }
 
 
         if (compute_clouds)
         {
+            Nvtx_range range("lw_cloud_optics");
             auto clwp_subset = clwp.subset({{ {col_s_in, col_e_in}, {1, n_lay} }});
             auto ciwp_subset = ciwp.subset({{ {col_s_in, col_e_in}, {1, n_lay} }});
-            Array_gpu<Float,2> rel({n_col_in, n_lay});
-            Array_gpu<Float,2> rei({n_col_in, n_lay});
 
             effective_radius_and_ciwp_to_gm2<<<gridGPU_re, blockGPU_re>>>(
                     rel.ptr(), rei.ptr(),
@@ -799,22 +808,22 @@ void Radiation_rrtmgp<TF>::exec_longwave(
                     dynamic_cast<Optical_props_1scl_gpu&>(*cloud_optical_props_subset_in));
         }
 
-        Array_gpu<Float,3> gpt_flux_up({n_col_in, n_lev, n_gpt});
-        Array_gpu<Float,3> gpt_flux_dn({n_col_in, n_lev, n_gpt});
-
         constexpr int n_ang = 1;
 
-        rte_lw_gpu.rte_lw(
-                optical_props_subset_in,
-                top_at_1,
-                sources_subset_in,
-                emis_sfc_subset_in,
-                lw_flux_dn_inc_subset_in,
-                gpt_flux_up,
-                gpt_flux_dn,
-                n_ang);
-
-        fluxes.reduce(gpt_flux_up, gpt_flux_dn, optical_props_subset_in, top_at_1);
+        {
+            Nvtx_range range("lw_solver");
+            rte_lw_gpu.rte_lw(
+                    optical_props_subset_in,
+                    top_at_1,
+                    sources_subset_in,
+                    emis_sfc_subset_in,
+                    lw_flux_dn_inc_subset_in,
+                    gpt_flux_up,
+                    gpt_flux_dn,
+                    n_ang);
+
+            fluxes.reduce(gpt_flux_up, gpt_flux_dn, optical_props_subset_in, top_at_1);
+        }
 
         // Copy the data to the output.
         Subset_kernels_cuda::get_from_subset(
@@ -822,28 +831,39 @@ void Radiation_rrtmgp<TF>::exec_longwave(
                 fluxes.get_flux_up().ptr(), fluxes.get_flux_dn().ptr(), fluxes.get_flux_net().ptr());
     };
 
-    for (int b=1; b<=n_blocks; ++b)
+    if (n_blocks > 0)
     {
-        const int col_s = (b-1) * n_col_block + 1;
-        const int col_e =  b    * n_col_block;
-
-        Array_gpu<Float,2> emis_sfc_subset = emis_sfc_g.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array_gpu<Float,2> lw_flux_dn_inc_subset = lw_flux_dn_inc_local.subset({{ {col_s, col_e}, {1, n_gpt} }});
-
+        // The work arrays are allocated once and reused by all blocks.
         std::unique_ptr<Fluxes_broadband_gpu> fluxes_subset =
                 std::make_unique<Fluxes_broadband_gpu>(n_col_block, n_lev);
         std::unique_ptr<Fluxes_broadband_gpu> bnd_fluxes_subset =
                 std::make_unique<Fluxes_byband_gpu>(n_col_block, n_lev, n_bnd);
 
-        call_kernels(
-                col_s, col_e,
-                optical_props_subset,
-                cloud_optical_props_subset,
-                *sources_subset,
-                emis_sfc_subset,
-                lw_flux_dn_inc_subset,
-                *fluxes_subset,
-                *bnd_fluxes_subset);
+        Array_gpu<Float,3> gpt_flux_up_subset({n_col_block, n_lev, n_gpt});
+        Array_gpu<Float,3> gpt_flux_dn_subset({n_col_block, n_lev, n_gpt});
+        Array_gpu<Float,2> rel_subset({n_col_block, n_lay});
+        Array_gpu<Float,2> rei_subset({n_col_block, n_lay});
+
+        for (int b=1; b<=n_blocks; ++b)
+        {
+            const int col_s = (b-1) * n_col_block + 1;
+            const int col_e =  b    * n_col_block;
+
+            Array_gpu<Float,2> emis_sfc_subset = emis_sfc_g.subset({{ {1, n_bnd}, {col_s, col_e} }});
+            Array_gpu<Float,2> lw_flux_dn_inc_subset = lw_flux_dn_inc_local.subset({{ {col_s, col_e}, {1, n_gpt} }});
+
+            call_kernels(
+                    col_s, col_e,
+                    optical_props_subset,
+                    cloud_optical_props_subset,
+                    *sources_subset,
+                    emis_sfc_subset,
+                    lw_flux_dn_inc_subset,
+                    *fluxes_subset,
+                    *bnd_fluxes_subset,
+                    gpt_flux_up_subset, gpt_flux_dn_subset,
+                    rel_subset, rei_subset);
+        }
     }
 
     if (n_col_block_residual > 0)
@@ -859,6 +879,11 @@ void Radiation_rrtmgp<TF>::exec_longwave(
         std::unique_ptr<Fluxes_broadband_gpu> bnd_fluxes_residual =
                 std::make_unique<Fluxes_byband_gpu>(n_col_block_residual, n_lev, n_bnd);
 
+        Array_gpu<Float,3> gpt_flux_up_residual({n_col_block_residual, n_lev, n_gpt});
+        Array_gpu<Float,3> gpt_flux_dn_residual({n_col_block_residual, n_lev, n_gpt});
+        Array_gpu<Float,2> rel_residual({n_col_block_residual, n_lay});
+        Array_gpu<Float,2> rei_residual({n_col_block_residual, n_lay});
+
         call_kernels(
                 col_s, col_e,
                 optical_props_residual,
@@ -867,7 +892,9 @@ void Radiation_rrtmgp<TF>::exec_longwave(
                 emis_sfc_residual,
                 lw_flux_dn_inc_residual,
                 *fluxes_residual,
-                *bnd_fluxes_residual);
+                *bnd_fluxes_residual,
+                gpt_flux_up_residual, gpt_flux_dn_residual,
+                rel_residual, rei_residual);
     }
 }
 #endif
@@ -883,6 +910,8 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
         const Array_gpu<Float,2>& clwp, const Array_gpu<Float,2>& ciwp,
         const bool compute_clouds, const int n_col)
 {
+    Nvtx_range range("radiation_shortwave");
+
     constexpr int n_col_block = 1024;
 
     auto& gd = grid.get_grid_data();
@@ -964,29 +993,36 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
             const Array_gpu<Float,2>& sfc_alb_dif_subset_in,
             const Array_gpu<Float,2>& sw_flux_dn_dif_inc_subset_in,
             Fluxes_broadband_gpu& fluxes,
-            Fluxes_broadband_gpu& bnd_fluxes)
+            Fluxes_broadband_gpu& bnd_fluxes,
+            Array_gpu<Float,2>& toa_src_dummy,
+            Array_gpu<Float,3>& gpt_flux_up,
+            Array_gpu<Float,3>& gpt_flux_dn,
+            Array_gpu<Float,3>& gpt_flux_dn_dir,
+            Array_gpu<Float,2>& rel,
+            Array_gpu<Float,2>& rei)
     {
         const int n_col_in = col_e_in - col_s_in + 1;
         Gas_concs_gpu gas_concs_subset(*gas_concs_gpu, col_s_in, n_col_in);
-        Array_gpu<Float,2> toa_src_dummy({n_col_in, n_gpt});
 
         auto p_lev_subset = p_lev.subset({{ {col_s_in, col_e_in}, {1, n_lev} }});
-        kdist_sw_gpu->gas_optics(
-                p_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                p_lev_subset,
-                t_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                gas_concs_subset,
-                optical_props_subset_in,
-                toa_src_dummy,
-                col_dry.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}) );
+        {
+            Nvtx_range range("sw_gas_optics");
+            kdist_sw_gpu->gas_optics(
+                    p_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
+                    p_lev_subset,
+                    t_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
+                    gas_concs_subset,
+                    optical_props_subset_in,
+                    toa_src_dummy,
+                    col_dry.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}) );
+        }
 
 
         if (compute_clouds)
         {
+            Nvtx_range range("sw_cloud_optics");
             auto clwp_subset = clwp.subset({{ {col_s_in, col_e_in}, {1, n_lay} }});
             auto ciwp_subset = ciwp.subset({{ {col_s_in, col_e_in}, {1, n_lay} }});
-            Array_gpu<Float,2> rel({n_col_in, n_lay});
-            Array_gpu<Float,2> rei({n_col_in, n_lay});
 
             effective_radius_and_ciwp_to_gm2<<<gridGPU_re, blockGPU_re>>>(
                     rel.ptr(), rei.ptr(),
@@ -1013,6 +1049,7 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
 
         if (sw_aerosol)
         {
+            Nvtx_range range("sw_aerosol_optics");
             Aerosol_concs_gpu aerosol_concs_subset(*aerosol_concs_gpu, col_s_in, n_col_in);
             aerosol_sw_gpu->aerosol_optics(
                     aerosol_concs_subset,
@@ -1034,23 +1071,22 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
 
         }
 
-        Array_gpu<Float,3> gpt_flux_up({n_col_in, n_lev, n_gpt});
-        Array_gpu<Float,3> gpt_flux_dn({n_col_in, n_lev, n_gpt});
-        Array_gpu<Float,3> gpt_flux_dn_dir({n_col_in, n_lev, n_gpt});
-
-        rte_sw_gpu.rte_sw(
-                optical_props_subset_in,
-                top_at_1,
-                mu0_subset_in,
-                sw_flux_dn_dir_inc_subset_in,
-                sfc_alb_dir_subset_in,
-                sfc_alb_dif_subset_in,
-                sw_flux_dn_dif_inc_subset_in,
-                gpt_flux_up,
-                gpt_flux_dn,
-                gpt_flux_dn_dir);
-
-        fluxes.reduce(gpt_flux_up, gpt_flux_dn, gpt_flux_dn_dir, optical_props_subset_in, top_at_1);
+        {
+            Nvtx_range range("sw_solver");
+            rte_sw_gpu.rte_sw(
+                    optical_props_subset_in,
+                    top_at_1,
+                    mu0_subset_in,
+                    sw_flux_dn_dir_inc_subset_in,
+                    sfc_alb_dir_subset_in,
+                    sfc_alb_dif_subset_in,
+                    sw_flux_dn_dif_inc_subset_in,
+                    gpt_flux_up,
+                    gpt_flux_dn,
+                    gpt_flux_dn_dir);
+
+            fluxes.reduce(gpt_flux_up, gpt_flux_dn, gpt_flux_dn_dir, optical_props_subset_in, top_at_1);
+        }
 
         // Copy the data to the output.
         Subset_kernels_cuda::get_from_subset(
@@ -1065,33 +1101,48 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
         cuda_safe_call(cudaMemcpy(aod550.ptr(), aod550_g, nmemsize, cudaMemcpyDeviceToHost));
     }
 
-    for (int b=1; b<=n_blocks; ++b)
+    if (n_blocks > 0)
     {
-        const int col_s = (b-1) * n_col_block + 1;
-        const int col_e =  b    * n_col_block;
-
-        Array_gpu<Float,1> mu0_subset = mu0.subset({{ {col_s, col_e} }});
-        Array_gpu<Float,2> sw_flux_dn_dir_inc_subset = sw_flux_dn_dir_inc_local.subset({{ {col_s, col_e}, {1, n_gpt} }});
-        Array_gpu<Float,2> sfc_alb_dir_subset = sfc_alb_dir_g.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array_gpu<Float,2> sfc_alb_dif_subset = sfc_alb_dif_g.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array_gpu<Float,2> sw_flux_dn_dif_inc_subset = sw_flux_dn_dif_inc_local.subset({{ {col_s, col_e}, {1, n_gpt} }});
-
+        // The work arrays are allocated once and reused by all blocks.
         std::unique_ptr<Fluxes_broadband_gpu> fluxes_subset =
                 std::make_unique<Fluxes_broadband_gpu>(n_col_block, n_lev);
         std::unique_ptr<Fluxes_broadband_gpu> bnd_fluxes_subset =
                 std::make_unique<Fluxes_byband_gpu>(n_col_block, n_lev, n_bnd);
-        call_kernels(
-                col_s, col_e,
-                optical_props_subset,
-                cloud_optical_props_subset,
-                aerosol_optical_props_subset,
-                mu0_subset,
-                sw_flux_dn_dir_inc_subset,
-                sfc_alb_dir_subset,
-                sfc_alb_dif_subset,
-                sw_flux_dn_dif_inc_subset,
-                *fluxes_subset,
-                *bnd_fluxes_subset);
+
+        Array_gpu<Float,2> toa_src_dummy_subset({n_col_block, n_gpt});
+        Array_gpu<Float,3> gpt_flux_up_subset({n_col_block, n_lev, n_gpt});
+        Array_gpu<Float,3> gpt_flux_dn_subset({n_col_block, n_lev, n_gpt});
+        Array_gpu<Float,3> gpt_flux_dn_dir_subset({n_col_block, n_lev, n_gpt});
+        Array_gpu<Float,2> rel_subset({n_col_block, n_lay});
+        Array_gpu<Float,2> rei_subset({n_col_block, n_lay});
+
+        for (int b=1; b<=n_blocks; ++b)
+        {
+            const int col_s = (b-1) * n_col_block + 1;
+            const int col_e =  b    * n_col_block;
+
+            Array_gpu<Float,1> mu0_subset = mu0.subset({{ {col_s, col_e} }});
+            Array_gpu<Float,2> sw_flux_dn_dir_inc_subset = sw_flux_dn_dir_inc_local.subset({{ {col_s, col_e}, {1, n_gpt} }});
+            Array_gpu<Float,2> sfc_alb_dir_subset = sfc_alb_dir_g.subset({{ {1, n_bnd}, {col_s, col_e} }});
+            Array_gpu<Float,2> sfc_alb_dif_subset = sfc_alb_dif_g.subset({{ {1, n_bnd}, {col_s, col_e} }});
+            Array_gpu<Float,2> sw_flux_dn_dif_inc_subset = sw_flux_dn_dif_inc_local.subset({{ {col_s, col_e}, {1, n_gpt} }});
+
+            call_kernels(
+                    col_s, col_e,
+                    optical_props_subset,
+                    cloud_optical_props_subset,
+                    aerosol_optical_props_subset,
+                    mu0_subset,
+                    sw_flux_dn_dir_inc_subset,
+                    sfc_alb_dir_subset,
+                    sfc_alb_dif_subset,
+                    sw_flux_dn_dif_inc_subset,
+                    *fluxes_subset,
+                    *bnd_fluxes_subset,
+                    toa_src_dummy_subset,
+                    gpt_flux_up_subset, gpt_flux_dn_subset, gpt_flux_dn_dir_subset,
+                    rel_subset, rei_subset);
+        }
     }
 
     if (n_col_block_residual > 0)
@@ -1110,6 +1161,13 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
         std::unique_ptr<Fluxes_broadband_gpu> bnd_fluxes_residual =
                 std::make_unique<Fluxes_byband_gpu>(n_col_block_residual, n_lev, n_bnd);
 
+        Array_gpu<Float,2> toa_src_dummy_residual({n_col_block_residual, n_gpt});
+        Array_gpu<Float,3> gpt_flux_up_residual({n_col_block_residual, n_lev, n_gpt});
+        Array_gpu<Float,3> gpt_flux_dn_residual({n_col_block_residual, n_lev, n_gpt});
+        Array_gpu<Float,3> gpt_flux_dn_dir_residual({n_col_block_residual, n_lev, n_gpt});
+        Array_gpu<Float,2> rel_residual({n_col_block_residual, n_lay});
+        Array_gpu<Float,2> rei_residual({n_col_block_residual, n_lay});
+
         call_kernels(
                 col_s, col_e,
                 optical_props_residual,
@@ -1121,7 +1179,10 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
                 sfc_alb_dif_residual,
                 sw_flux_dn_dif_inc_residual,
                 *fluxes_residual,
-                *bnd_fluxes_residual);
+                *bnd_fluxes_residual,
+                toa_src_dummy_residual,
+                gpt_flux_up_residual, gpt_flux_dn_residual, gpt_flux_dn_dir_residual,
+                rel_residual, rei_residual);
     }
 }
 #endif
@@ -1334,32 +1395,38 @@ void Radiation_rrtmgp<TF>::exec(
                 Array_gpu<Float,2> flux_dn_dir({gd.imax*gd.jmax, gd.ktot+1});
 
                 // Single column solve of background profile for TOA conditions
-                if (!sw_fixed_sza)
-                {
-                    // Update the solar zenith angle and sun-earth distance.
-                    set_sun_location(timeloop);
-                }
-
                 if (!sw_fixed_sza || swtimedep_background)
                 {
+                    Float* ph_g = thermo.get_basestate_fld_g("prefh");
+                    Float p_top;
+                    cudaMemcpy(&p_top, &ph_g[gd.kend], sizeof(TF), cudaMemcpyDeviceToHost);
+
+                    // The prefetch of the last radiation step holds the sun location and the background column.
+                    const bool prefetched = apply_background_prefetch(timeloop.get_itime(), p_top, !sw_is_tuned);
+
+                    if (!sw_fixed_sza && !prefetched)
+                    {
+                        // Update the solar zenith angle and sun-earth distance.
+                        set_sun_location(timeloop);
+                    }
 
                     if (is_day(this->mu0) || !sw_is_tuned)
                     {
-                        const int n_bnd = kdist_sw->get_nband();
                         const int n_gpt = kdist_sw->get_ngpt();
 
                         // Calculate new background column (on the CPU).
-                        Float* ph_g = thermo.get_basestate_fld_g("prefh");
-                        Float p_top;
-                        cudaMemcpy(&p_top, &ph_g[gd.kend], sizeof(TF), cudaMemcpyDeviceToHost);
-
-                        set_background_column_shortwave(p_top);
+                        if (!prefetched)
+                            set_background_column_shortwave(p_top);
 
                         // Copy TOD fluxes to GPU
                         const int ncolgptsize = n_col * n_gpt * sizeof(Float);
                         cuda_safe_call(cudaMemcpy(sw_flux_dn_dir_inc_g, sw_flux_dn_dir_inc.ptr(), ncolgptsize, cudaMemcpyHostToDevice));
                         cuda_safe_call(cudaMemcpy(sw_flux_dn_dif_inc_g, sw_flux_dn_dif_inc.ptr(), ncolgptsize, cudaMemcpyHostToDevice));
                     }
+
+                    // Solve the background column of the next radiation step on a host thread, next to the device.
+                    if (sw_prefetch_background)
+                        start_background_prefetch(timeloop, p_top);
                 }
 
                 if (is_day(this->mu0) || !sw_is_tuned)
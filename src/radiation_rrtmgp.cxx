@@ -21,10 +21,12 @@
  */
 
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <numeric>
 #include <string>
 #include <cmath>
 #include <stdexcept>
+#include <unistd.h>
 
 #include "radiation_rrtmgp.h"
 #include "radiation_rrtmgp_functions.h"
@@ -646,10 +648,314 @@ namespace
                 }
     }
 
+    // Average the columns (without ghost cells) over blocks of n_coarse x n_coarse columns.
+    void coarsen_columns(
+            Float* restrict out, const Float* restrict in,
+            const int imax, const int jmax, const int nlev, const int n_coarse)
+    {
+        const int n_col = imax*jmax;
+        const int imax_c = imax/n_coarse;
+        const int n_col_c = n_col/(n_coarse*n_coarse);
+        const Float fac = Float(1.)/(n_coarse*n_coarse);
+
+        #pragma omp parallel for
+        for (int k=0; k<nlev; ++k)
+        {
+            for (int n=0; n<n_col_c; ++n)
+                out[n + k*n_col_c] = Float(0.);
+
+            for (int j=0; j<jmax; ++j)
+                for (int i=0; i<imax; ++i)
+                {
+                    const int ic = i/n_coarse + (j/n_coarse)*imax_c;
+                    out[ic + k*n_col_c] += fac*in[i + j*imax + k*n_col];
+                }
+        }
+    }
+
+    // Copy the value of each coarse column to all columns of its block.
+    void refine_columns(
+            Float* restrict out, const Float* restrict in,
+            const int imax, const int jmax, const int nlev, const int n_coarse)
+    {
+        const int n_col = imax*jmax;
+        const int imax_c = imax/n_coarse;
+        const int n_col_c = n_col/(n_coarse*n_coarse);
+
+        #pragma omp parallel for
+        for (int k=0; k<nlev; ++k)
+            for (int j=0; j<jmax; ++j)
+                for (int i=0; i<imax; ++i)
+                {
+                    const int ic = i/n_coarse + (j/n_coarse)*imax_c;
+                    out[i + j*imax + k*n_col] = in[ic + k*n_col_c];
+                }
+    }
+
+    // Copy the columns `cols` of `in` into the dense array `out` of cols.size() columns.
+    void gather_columns(
+            Float* restrict out, const Float* restrict in,
+            const std::vector<int>& cols, const int n_col, const int nlev)
+    {
+        const int n_col_p = cols.size();
+
+        #pragma omp parallel for
+        for (int k=0; k<nlev; ++k)
+            for (int n=0; n<n_col_p; ++n)
+                out[n + k*n_col_p] = in[cols[n] + k*n_col];
+    }
+
+    // Copy the dense array `in` of cols.size() columns back into the columns `cols` of `out`.
+    void scatter_columns(
+            Float* restrict out, const Float* restrict in,
+            const std::vector<int>& cols, const int n_col, const int nlev)
+    {
+        const int n_col_p = cols.size();
+
+        #pragma omp parallel for
+        for (int k=0; k<nlev; ++k)
+            for (int n=0; n<n_col_p; ++n)
+                out[cols[n] + k*n_col] = in[n + k*n_col_p];
+    }
+
     Float deg_to_rad(const Float deg)
     {
         return Float(2.*M_PI/360. * deg);
     }
+
+    // Number of columns in the blocks of the CPU solvers. A positive `n_col_block_in` is
+    // used as is; otherwise, the block is sized such that `n_arrays` g-point x level
+    // arrays of the block fit in the L2 cache.
+    int get_column_block_size(const int n_col_block_in, const int n_gpt, const int n_lev, const int n_arrays)
+    {
+        if (n_col_block_in > 0)
+            return n_col_block_in;
+
+        long cache_size = 0;
+        #ifdef _SC_LEVEL2_CACHE_SIZE
+        cache_size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        #endif
+        if (cache_size <= 0)
+            cache_size = 1024*1024;
+
+        const long column_size = long(n_arrays) * n_gpt * n_lev * sizeof(Float);
+        return std::max(int(cache_size / column_size), 1);
+    }
+
+    // Columns of a radiation solve that a process solves itself, and that it sends to and receives from
+    // the other processes of commxy. The received columns follow the kept ones in the solved arrays.
+    struct Column_balance
+    {
+        bool active = false; // False if no process sends columns.
+        std::vector<int> cols_keep;
+        std::vector<int> cols_send; // Ordered by destination.
+        std::vector<int> send_counts;
+        std::vector<int> recv_counts;
+        int n_col_solve = 0;
+    };
+
+    // Assign the cloudy columns, which cost `cloud_cost` clear columns, of the processes above the mean cost
+    // to the processes below it. Every process computes the same greedy matching in rank order from the
+    // gathered column counts. A process receives at most up to `n_col_max` columns.
+    Column_balance plan_column_balance(
+            const Float* const restrict clwp, const Float* const restrict ciwp,
+            const int n_col, const int n_col_max, const int n_lay,
+            const Float cloud_cost, const Master& master)
+    {
+        auto& md = master.get_MPI_data();
+
+        std::vector<int> cols_clear;
+        std::vector<int> cols_cloudy;
+        for (int n=0; n<n_col; ++n)
+        {
+            bool cloudy = false;
+            for (int k=0; k<n_lay && !cloudy; ++k)
+                cloudy = (clwp[n + k*n_col] > Float(0.)) || (ciwp[n + k*n_col] > Float(0.));
+
+            if (cloudy)
+                cols_cloudy.push_back(n);
+            else
+                cols_clear.push_back(n);
+        }
+
+        Column_balance balance;
+        balance.send_counts.assign(md.nprocs, 0);
+        balance.recv_counts.assign(md.nprocs, 0);
+
+        #ifdef USEMPI
+        int counts_local[2] = {n_col, static_cast<int>(cols_cloudy.size())};
+        std::vector<int> counts(2*md.nprocs);
+        MPI_Allgather(counts_local, 2, MPI_INT, counts.data(), 2, MPI_INT, md.commxy);
+
+        auto get_cost = [&](const int p) { return (counts[2*p] - counts[2*p+1]) + double(cloud_cost)*counts[2*p+1]; };
+
+        double cost_mean = 0.;
+        for (int p=0; p<md.nprocs; ++p)
+            cost_mean += get_cost(p) / md.nprocs;
+
+        std::vector<int> n_export(md.nprocs, 0);
+        std::vector<int> n_import(md.nprocs, 0);
+        for (int p=0; p<md.nprocs; ++p)
+        {
+            const double excess = (get_cost(p) - cost_mean) / cloud_cost;
+            if (excess > 0.)
+                n_export[p] = std::min(static_cast<int>(std::lround(excess)), counts[2*p+1]);
+            else
+                n_import[p] = std::min(static_cast<int>(std::lround(-excess)), n_col_max - counts[2*p]);
+        }
+
+        int ps = 0;
+        int pr = 0;
+        while (true)
+        {
+            while (ps < md.nprocs && n_export[ps] == 0)
+                ++ps;
+            while (pr < md.nprocs && n_import[pr] == 0)
+                ++pr;
+            if (ps == md.nprocs || pr == md.nprocs)
+                break;
+
+            const int n = std::min(n_export[ps], n_import[pr]);
+            if (ps == md.mpiid)
+                balance.send_counts[pr] += n;
+            if (pr == md.mpiid)
+                balance.recv_counts[ps] += n;
+
+            n_export[ps] -= n;
+            n_import[pr] -= n;
+            balance.active = true;
+        }
+        #endif
+
+        // The last cloudy columns are sent.
+        const int n_send = std::accumulate(balance.send_counts.begin(), balance.send_counts.end(), 0);
+        const int n_recv = std::accumulate(balance.recv_counts.begin(), balance.recv_counts.end(), 0);
+
+        balance.cols_send.assign(cols_cloudy.end() - n_send, cols_cloudy.end());
+        balance.cols_keep = cols_clear;
+        balance.cols_keep.insert(balance.cols_keep.end(), cols_cloudy.begin(), cols_cloudy.end() - n_send);
+        std::sort(balance.cols_keep.begin(), balance.cols_keep.end());
+
+        balance.n_col_solve = balance.cols_keep.size() + n_recv;
+
+        return balance;
+    }
+
+    // Copy the columns `cols` of the arrays `in` of `n_col` columns and `nlevs` levels
+    // into `buffer`, with all levels of all arrays of a column contiguous.
+    void pack_columns(
+            std::vector<Float>& buffer, const std::vector<const Float*>& in, const std::vector<int>& nlevs,
+            const int n_col, const std::vector<int>& cols)
+    {
+        const int n_per_col = std::accumulate(nlevs.begin(), nlevs.end(), 0);
+        buffer.resize(cols.size() * n_per_col);
+
+        #pragma omp parallel for
+        for (int n=0; n<static_cast<int>(cols.size()); ++n)
+        {
+            int m = n*n_per_col;
+            for (size_t a=0; a<in.size(); ++a)
+                for (int k=0; k<nlevs[a]; ++k)
+                    buffer[m++] = in[a][cols[n] + k*n_col];
+        }
+    }
+
+    void unpack_columns(
+            const std::vector<Float*>& out, const std::vector<int>& nlevs, const int n_col,
+            const std::vector<int>& cols, const std::vector<Float>& buffer)
+    {
+        const int n_per_col = std::accumulate(nlevs.begin(), nlevs.end(), 0);
+
+        #pragma omp parallel for
+        for (int n=0; n<static_cast<int>(cols.size()); ++n)
+        {
+            int m = n*n_per_col;
+            for (size_t a=0; a<out.size(); ++a)
+                for (int k=0; k<nlevs[a]; ++k)
+                    out[a][cols[n] + k*n_col] = buffer[m++];
+        }
+    }
+
+    // Send the packed columns of `send` to the processes in `send_counts`, and receive those in `recv_counts`.
+    std::vector<Float> exchange_columns(
+            const std::vector<Float>& send, const std::vector<int>& send_counts, const std::vector<int>& recv_counts,
+            const int n_per_col, const Master& master)
+    {
+        auto& md = master.get_MPI_data();
+
+        std::vector<int> send_sizes(md.nprocs);
+        std::vector<int> recv_sizes(md.nprocs);
+        std::vector<int> send_displs(md.nprocs, 0);
+        std::vector<int> recv_displs(md.nprocs, 0);
+        for (int p=0; p<md.nprocs; ++p)
+        {
+            send_sizes[p] = send_counts[p] * n_per_col;
+            recv_sizes[p] = recv_counts[p] * n_per_col;
+            if (p > 0)
+            {
+                send_displs[p] = send_displs[p-1] + send_sizes[p-1];
+                recv_displs[p] = recv_displs[p-1] + recv_sizes[p-1];
+            }
+        }
+
+        std::vector<Float> recv(recv_displs[md.nprocs-1] + recv_sizes[md.nprocs-1]);
+
+        #ifdef USEMPI
+        const MPI_Datatype type = (sizeof(Float) == sizeof(double)) ? MPI_DOUBLE : MPI_FLOAT;
+        MPI_Alltoallv(
+                send.data(), send_sizes.data(), send_displs.data(), type,
+                recv.data(), recv_sizes.data(), recv_displs.data(), type, md.commxy);
+        #endif
+
+        return recv;
+    }
+
+    // Copy the kept columns of the arrays `in` of `n_col` columns to the first columns of the arrays `out`
+    // of balance.n_col_solve columns, and the columns received from the other processes after them.
+    void distribute_columns(
+            const std::vector<Float*>& out, const std::vector<const Float*>& in, const std::vector<int>& nlevs,
+            const int n_col, const Column_balance& balance, const Master& master)
+    {
+        const int n_per_col = std::accumulate(nlevs.begin(), nlevs.end(), 0);
+        const int n_keep = balance.cols_keep.size();
+
+        std::vector<Float> buffer;
+        pack_columns(buffer, in, nlevs, n_col, balance.cols_keep);
+
+        std::vector<int> cols_out(n_keep);
+        std::iota(cols_out.begin(), cols_out.end(), 0);
+        unpack_columns(out, nlevs, balance.n_col_solve, cols_out, buffer);
+
+        pack_columns(buffer, in, nlevs, n_col, balance.cols_send);
+        buffer = exchange_columns(buffer, balance.send_counts, balance.recv_counts, n_per_col, master);
+
+        cols_out.resize(balance.n_col_solve - n_keep);
+        std::iota(cols_out.begin(), cols_out.end(), n_keep);
+        unpack_columns(out, nlevs, balance.n_col_solve, cols_out, buffer);
+    }
+
+    // Reverse of distribute_columns(): return the solved columns to the arrays `out` of `n_col` columns.
+    void collect_columns(
+            const std::vector<Float*>& out, const std::vector<const Float*>& in, const std::vector<int>& nlevs,
+            const int n_col, const Column_balance& balance, const Master& master)
+    {
+        const int n_per_col = std::accumulate(nlevs.begin(), nlevs.end(), 0);
+        const int n_keep = balance.cols_keep.size();
+
+        std::vector<int> cols_in(n_keep);
+        std::iota(cols_in.begin(), cols_in.end(), 0);
+
+        std::vector<Float> buffer;
+        pack_columns(buffer, in, nlevs, balance.n_col_solve, cols_in);
+        unpack_columns(out, nlevs, n_col, balance.cols_keep, buffer);
+
+        cols_in.resize(balance.n_col_solve - n_keep);
+        std::iota(cols_in.begin(), cols_in.end(), n_keep);
+        pack_columns(buffer, in, nlevs, balance.n_col_solve, cols_in);
+        buffer = exchange_columns(buffer, balance.recv_counts, balance.send_counts, n_per_col, master);
+
+        unpack_columns(out, nlevs, n_col, balance.cols_send, buffer);
+    }
 }
 
 
@@ -696,6 +1002,21 @@ Radiation_rrtmgp<TF>::Radiation_rrtmgp(
         throw std::runtime_error("Radiation homogenization is not (yet) implemented on the CPU.");
     #endif
 
+    // Solve the radiation on the mean profiles of blocks of ncoarse x ncoarse columns.
+    n_coarse = inputin.get_item<int>("radiation", "ncoarse", "", 1);
+    if (n_coarse < 1)
+        throw std::runtime_error("ncoarse has to be at least 1");
+
+    #ifdef USECUDA
+    if (n_coarse > 1)
+        throw std::runtime_error("Coarse-column radiation is not (yet) implemented on the GPU.");
+    #endif
+
+    // Number of columns per block of the CPU solvers, 0 sizes the blocks to the L2 cache.
+    n_col_block_cpu = inputin.get_item<int>("radiation", "ncolblock", "", 4);
+    if (n_col_block_cpu < 0)
+        throw std::runtime_error("ncolblock cannot be negative");
+
     if (sw_fixed_sza)
     {
         const Float sza = inputin.get_item<Float>("radiation", "sza", "");
@@ -721,10 +1042,11 @@ Radiation_rrtmgp<TF>::Radiation_rrtmgp(
 
         sigma_filter = inputin.get_item<Float>("radiation", "sigma_filter", "");
 
+        // The filter only reads the ghost cells of the 2D surface fields.
         const int igc = 3;  // for now..
         const int jgc = 3;  // for now..
         const int kgc = 0;
-        grid.set_minimum_ghost_cells(igc, jgc, kgc);
+        grid.set_minimum_padding_cells(igc, jgc, kgc);
     }
 
     gaslist = inputin.get_list<std::string>("radiation", "timedeplist_gas", "", std::vector<std::string>());
@@ -747,6 +1069,78 @@ Radiation_rrtmgp<TF>::Radiation_rrtmgp(
         }
     }
 
+    // Solve the radiation as a task next to the time integration, using the tendency
+    // and surface fluxes of the previous radiation step until the solve has finished.
+    sw_async = inputin.get_item<bool>("radiation", "swasync", "", false);
+    if (sw_async)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("Asynchronous radiation is not (yet) implemented on the GPU.");
+        #endif
+
+        if (swtimedep_basestate)
+            throw std::runtime_error("swasync=true requires swupdatebasestate=false");
+        if (!gaslist.empty())
+            throw std::runtime_error("swasync=true is not supported with time dependent gases");
+        if (sw_diffuse_filter)
+            throw std::runtime_error("swasync=true is not supported with swfilterdiffuse=true");
+    }
+
+    // Skip the radiation steps as long as the liquid water path and the surface temperature change
+    // less than their thresholds since the last solve, up to at most dt_rad_max.
+    sw_adaptive = inputin.get_item<bool>("radiation", "swadaptive", "", false);
+    if (sw_adaptive)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("Adaptive radiation intervals are not (yet) implemented on the GPU.");
+        #endif
+
+        dt_rad_max = inputin.get_item<double>("radiation", "dt_rad_max", "");
+        adaptive_lwp_threshold = inputin.get_item<Float>("radiation", "lwp_threshold", "", 0.01);
+        adaptive_tsfc_threshold = inputin.get_item<Float>("radiation", "tsfc_threshold", "", 0.5);
+    }
+
+    // The background column of the next radiation step is solved next to the time loop if it only depends on the time.
+    sw_prefetch_background = sw_shortwave && !sw_fixed_sza && !swtimedep_background;
+    itime_prefetch = Constants::ulhuge;
+
+    // Solve only the columns of which the state has changed beyond the thresholds since their last solve.
+    sw_incremental = inputin.get_item<bool>("radiation", "swincremental", "", false);
+    if (sw_incremental)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("Incremental radiation is not (yet) implemented on the GPU.");
+        #endif
+
+        if (n_coarse > 1)
+            throw std::runtime_error("swincremental=true is not supported with ncoarse > 1");
+        if (swtimedep_background)
+            throw std::runtime_error("swincremental=true is not supported with swtimedep_background=true");
+
+        incremental_lwp_threshold = inputin.get_item<Float>("radiation", "col_lwp_threshold", "", 1.e-3);
+        incremental_iwp_threshold = inputin.get_item<Float>("radiation", "col_iwp_threshold", "", 1.e-3);
+        incremental_t_threshold = inputin.get_item<Float>("radiation", "col_t_threshold", "", 0.2);
+        incremental_h2o_threshold = inputin.get_item<Float>("radiation", "col_h2o_threshold", "", 0.01);
+    }
+
+    // Redistribute the cloudy columns of the solve over the processes, such that all solve about the same cost.
+    sw_load_balance = inputin.get_item<bool>("radiation", "swloadbalance", "", false);
+    if (sw_load_balance)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("Radiation load balancing is not (yet) implemented on the GPU.");
+        #endif
+
+        if (sw_async)
+            throw std::runtime_error("swloadbalance=true is not supported with swasync=true");
+
+        load_balance_cloud_cost = inputin.get_item<Float>("radiation", "cloudcost", "", 3.);
+        if (load_balance_cloud_cost < Float(1.))
+            throw std::runtime_error("cloudcost has to be at least 1");
+    }
+    else
+        inputin.flag_as_used("radiation", "cloudcost", "");
+
     auto& gd = grid.get_grid_data();
     fields.init_diagnostic_field("thlt_rad", "Tendency by radiation", "K s-1", "radiation", gd.sloc);
 
@@ -783,6 +1177,13 @@ void Radiation_rrtmgp<TF>::init(Timeloop<TF>& timeloop)
     if (timeloop.get_isavetime() % idt_rad != 0)
         throw std::runtime_error("Restart \"savetime\" is not an (integer) multiple of \"dt_rad\"");
 
+    if (sw_adaptive)
+    {
+        idt_rad_max = convert_to_itime(dt_rad_max);
+        if (idt_rad_max < idt_rad || idt_rad_max % idt_rad != 0)
+            throw std::runtime_error("\"dt_rad_max\" is not an (integer) multiple of \"dt_rad\"");
+    }
+
     // Resize surface radiation fields
     lw_flux_dn_sfc.resize(gd.ijcells);
     lw_flux_up_sfc.resize(gd.ijcells);
@@ -790,6 +1191,17 @@ void Radiation_rrtmgp<TF>::init(Timeloop<TF>& timeloop)
     sw_flux_dn_sfc.resize(gd.ijcells);
     sw_flux_up_sfc.resize(gd.ijcells);
 
+    if (sw_async)
+    {
+        thlt_rad_async.resize(gd.ncells);
+
+        lw_flux_dn_sfc_async.resize(gd.ijcells);
+        lw_flux_up_sfc_async.resize(gd.ijcells);
+
+        sw_flux_dn_sfc_async.resize(gd.ijcells);
+        sw_flux_up_sfc_async.resize(gd.ijcells);
+    }
+
     // Surface diffuse radiation filtering
     if (sw_diffuse_filter)
     {
@@ -806,6 +1218,206 @@ void Radiation_rrtmgp<TF>::init(Timeloop<TF>& timeloop)
 
     // initialize aod
     aod550.set_dims({gd.imax*gd.jmax});
+
+    if (gd.imax % n_coarse != 0 || gd.jmax % n_coarse != 0)
+        throw std::runtime_error("imax and jmax have to be multiples of ncoarse");
+}
+
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::wait_async_radiation()
+{
+    if (!async_pending)
+        return;
+
+    #pragma omp taskwait
+    async_pending = false;
+
+    if (async_exception)
+    {
+        std::exception_ptr e = async_exception;
+        async_exception = nullptr;
+        std::rethrow_exception(e);
+    }
+
+    async_result_ready = true;
+}
+
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::apply_async_radiation()
+{
+    wait_async_radiation();
+
+    if (!async_result_ready)
+        return;
+
+    std::copy(thlt_rad_async.begin(), thlt_rad_async.end(), fields.sd.at("thlt_rad")->fld.begin());
+
+    if (sw_longwave)
+    {
+        std::copy(lw_flux_dn_sfc_async.begin(), lw_flux_dn_sfc_async.end(), lw_flux_dn_sfc.begin());
+        std::copy(lw_flux_up_sfc_async.begin(), lw_flux_up_sfc_async.end(), lw_flux_up_sfc.begin());
+    }
+
+    if (sw_shortwave)
+    {
+        std::copy(sw_flux_dn_sfc_async.begin(), sw_flux_dn_sfc_async.end(), sw_flux_dn_sfc.begin());
+        std::copy(sw_flux_up_sfc_async.begin(), sw_flux_up_sfc_async.end(), sw_flux_up_sfc.begin());
+    }
+
+    async_result_ready = false;
+}
+
+
+template<typename TF>
+bool Radiation_rrtmgp<TF>::check_adaptive_update(Thermo<TF>& thermo, Timeloop<TF>& timeloop)
+{
+    auto& gd = grid.get_grid_data();
+    const int ijmax = gd.imax*gd.jmax;
+
+    auto t_lay = fields.get_tmp();
+    auto t_lev = fields.get_tmp();
+    auto h2o   = fields.get_tmp();
+    auto rh    = fields.get_tmp();
+    auto clwp  = fields.get_tmp();
+    auto ciwp  = fields.get_tmp();
+
+    thermo.get_radiation_fields(*t_lay, *t_lev, *h2o, *rh, *clwp, *ciwp);
+
+    std::vector<Float> lwp(ijmax, Float(0.));
+    for (int k=0; k<gd.ktot; ++k)
+        #pragma ivdep
+        for (int n=0; n<ijmax; ++n)
+            lwp[n] += clwp->fld[n + k*ijmax];
+
+    const unsigned long itime = timeloop.get_itime();
+
+    // The radiation is always solved at the restart times, such that restarts stay bitwise identical,
+    // and at the statistics times, such that the radiation statistics are of the current state.
+    bool do_update = lwp_last.empty()
+        || itime % timeloop.get_isavetime() == 0
+        || timeloop.is_stats_step()
+        || itime - itime_last_rad >= idt_rad_max;
+
+    if (!do_update)
+    {
+        // Root mean square change of the liquid water path and maximum change of the surface temperature.
+        Float dlwp2 = Float(0.);
+        Float dtsfc = Float(0.);
+        for (int n=0; n<ijmax; ++n)
+        {
+            dlwp2 += (lwp[n] - lwp_last[n])*(lwp[n] - lwp_last[n]);
+            dtsfc = std::max(dtsfc, std::abs(t_lev->fld_bot[n] - t_sfc_last[n]));
+        }
+
+        master.sum(&dlwp2, 1);
+        master.max(&dtsfc, 1);
+
+        do_update = std::sqrt(dlwp2 / (gd.itot*gd.jtot)) > adaptive_lwp_threshold
+            || dtsfc > adaptive_tsfc_threshold;
+    }
+
+    if (do_update)
+    {
+        lwp_last = lwp;
+        t_sfc_last.assign(t_lev->fld_bot.begin(), t_lev->fld_bot.begin() + ijmax);
+        itime_last_rad = itime;
+    }
+
+    fields.release_tmp(t_lay);
+    fields.release_tmp(t_lev);
+    fields.release_tmp(h2o);
+    fields.release_tmp(rh);
+    fields.release_tmp(clwp);
+    fields.release_tmp(ciwp);
+
+    return do_update;
+}
+
+
+template<typename TF>
+bool Radiation_rrtmgp<TF>::select_incremental_columns(
+        std::vector<int>& cols,
+        const Field3d<Float>& t_lay, const Field3d<Float>& t_lev, const Field3d<Float>& h2o,
+        const Field3d<Float>& clwp, const Field3d<Float>& ciwp, Timeloop<TF>& timeloop)
+{
+    auto& gd = grid.get_grid_data();
+    const int ijmax = gd.imax*gd.jmax;
+
+    // Liquid and ice water path, and the rms temperature and water vapor mixing ratio of each column.
+    std::vector<Float> lwp(ijmax, Float(0.));
+    std::vector<Float> iwp(ijmax, Float(0.));
+    std::vector<Float> t_rms(ijmax, Float(0.));
+    std::vector<Float> h2o_rms(ijmax, Float(0.));
+
+    for (int k=0; k<gd.ktot; ++k)
+        #pragma ivdep
+        for (int n=0; n<ijmax; ++n)
+        {
+            const int nk = n + k*ijmax;
+            lwp[n] += clwp.fld[nk];
+            iwp[n] += ciwp.fld[nk];
+            t_rms[n] += t_lay.fld[nk]*t_lay.fld[nk];
+            h2o_rms[n] += h2o.fld[nk]*h2o.fld[nk];
+        }
+
+    for (int n=0; n<ijmax; ++n)
+    {
+        t_rms[n] = std::sqrt(t_rms[n] / gd.ktot);
+        h2o_rms[n] = std::sqrt(h2o_rms[n] / gd.ktot);
+    }
+
+    // All columns are solved at the first call, at the restart and statistics times, as in the adaptive
+    // interval, and during the day if the solar zenith angle changes the shortwave fluxes of all columns.
+    const unsigned long itime = timeloop.get_itime();
+    bool do_full = col_lwp_last.empty()
+        || itime % timeloop.get_isavetime() == 0
+        || timeloop.is_stats_step()
+        || (sw_shortwave && !sw_fixed_sza && is_day(this->mu0));
+
+    cols.clear();
+    if (!do_full)
+    {
+        for (int n=0; n<ijmax; ++n)
+        {
+            const bool changed =
+                   std::abs(lwp[n] - col_lwp_last[n]) > incremental_lwp_threshold
+                || std::abs(iwp[n] - col_iwp_last[n]) > incremental_iwp_threshold
+                || std::abs(t_rms[n] - col_t_last[n]) > incremental_t_threshold
+                || std::abs(t_lev.fld_bot[n] - col_t_sfc_last[n]) > incremental_t_threshold
+                || std::abs(h2o_rms[n] - col_h2o_last[n]) > incremental_h2o_threshold*col_h2o_last[n];
+
+            if (changed)
+                cols.push_back(n);
+        }
+
+        do_full = (static_cast<int>(cols.size()) == ijmax);
+    }
+
+    if (do_full)
+    {
+        cols.clear();
+
+        col_lwp_last = lwp;
+        col_iwp_last = iwp;
+        col_t_last = t_rms;
+        col_h2o_last = h2o_rms;
+        col_t_sfc_last.assign(t_lev.fld_bot.begin(), t_lev.fld_bot.begin() + ijmax);
+    }
+    else
+    {
+        for (const int n : cols)
+        {
+            col_lwp_last[n] = lwp[n];
+            col_iwp_last[n] = iwp[n];
+            col_t_last[n] = t_rms[n];
+            col_h2o_last[n] = h2o_rms[n];
+            col_t_sfc_last[n] = t_lev.fld_bot[n];
+        }
+    }
+
+    return !do_full;
 }
 
 
@@ -1364,6 +1976,21 @@ void Radiation_rrtmgp<TF>::create_column_shortwave(
     sw_flux_dn_dir_inc.set_dims({n_col, n_gpt});
     sw_flux_dn_dif_inc.set_dims({n_col, n_gpt});
 
+    if (sw_prefetch_background)
+    {
+        optical_props_sw_prefetch = std::make_unique<Optical_props_2str>(n_col, n_lay_col, *kdist_sw);
+        if (sw_aerosol)
+            aerosol_props_sw_prefetch = std::make_unique<Optical_props_2str>(n_col, n_lay_col, *aerosol_sw);
+
+        sw_flux_up_col_prefetch    .set_dims({n_col, n_lev_col});
+        sw_flux_dn_col_prefetch    .set_dims({n_col, n_lev_col});
+        sw_flux_dn_dir_col_prefetch.set_dims({n_col, n_lev_col});
+        sw_flux_net_col_prefetch   .set_dims({n_col, n_lev_col});
+
+        sw_flux_dn_dir_inc_prefetch.set_dims({n_col, n_gpt});
+        sw_flux_dn_dif_inc_prefetch.set_dims({n_col, n_gpt});
+    }
+
     if (sw_fixed_sza)
     {
         // Set the solar zenith angle and albedo.
@@ -1552,21 +2179,122 @@ void Radiation_rrtmgp<TF>::create_solver_shortwave(
 }
 
 template<typename TF>
-void Radiation_rrtmgp<TF>::set_sun_location(Timeloop<TF>& timeloop)
+std::pair<Float, Float> Radiation_rrtmgp<TF>::calc_sun_location(Timeloop<TF>& timeloop, const double time)
 {
-    // Update the solar zenith angle.
-    const int day_of_year = int(timeloop.calc_day_of_year());
-    const int year = timeloop.get_year();
-    const TF seconds_after_midnight = TF(timeloop.calc_hour_of_day()*3600);
+    // Calculate the cosine of the solar zenith angle.
+    const int day_of_year = int(timeloop.calc_day_of_year(time));
+    const int year = timeloop.get_year(time);
+    const TF seconds_after_midnight = TF(timeloop.calc_hour_of_day(time)*3600);
+    Float mu0;
     Float azimuth_dummy;
 
     auto& gd = grid.get_grid_data();
 
-    std::tie(this->mu0, azimuth_dummy) = calc_cos_zenith_angle(gd.lat, gd.lon, day_of_year, seconds_after_midnight, year);
+    std::tie(mu0, azimuth_dummy) = calc_cos_zenith_angle(gd.lat, gd.lon, day_of_year, seconds_after_midnight, year);
 
     // Calculate correction factor for impact Sun's distance on the solar "constant"
     const TF frac_day_of_year = TF(day_of_year) + seconds_after_midnight / TF(86400);
-    this->tsi_scaling = calc_sun_distance_factor(frac_day_of_year);
+
+    return std::make_pair(mu0, calc_sun_distance_factor(frac_day_of_year));
+}
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::set_sun_location(Timeloop<TF>& timeloop)
+{
+    // Update the solar zenith angle and the sun-earth distance.
+    std::tie(this->mu0, this->tsi_scaling) = calc_sun_location(timeloop, timeloop.get_time());
+}
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::start_background_prefetch(Timeloop<TF>& timeloop, const Float p_top)
+{
+    if (background_prefetch.valid())
+        background_prefetch.get();
+
+    // The sun location of the next radiation step, which is cheap, is computed here.
+    const unsigned long itime = timeloop.get_itime();
+    itime_prefetch = itime + idt_rad - itime % idt_rad;
+    p_top_prefetch = p_top;
+
+    std::tie(mu0_prefetch, tsi_scaling_prefetch) = calc_sun_location(
+            timeloop, timeloop.get_time() + (itime_prefetch - itime) / ifactor);
+    is_day_prefetch = is_day(mu0_prefetch);
+
+    if (!is_day_prefetch)
+        return;
+
+    // The background column is constant and the thread only writes its own buffers,
+    // such that it can run next to the time loop and an asynchronous radiation solve.
+    background_prefetch = std::async(
+            std::launch::async,
+            [this]()
+            {
+                const int n_bnd = kdist_sw->get_nband();
+
+                Array<Float,2> sfc_alb_dir({n_bnd, n_col});
+                Array<Float,2> sfc_alb_dif({n_bnd, n_col});
+
+                for (int ibnd=1; ibnd<=n_bnd; ++ibnd)
+                {
+                    sfc_alb_dir({ibnd, 1}) = this->sfc_alb_dir_hom;
+                    sfc_alb_dif({ibnd, 1}) = this->sfc_alb_dif_hom;
+                }
+
+                Array<Float,1> mu0({n_col});
+                mu0({1}) = mu0_prefetch;
+
+                solve_shortwave_column(
+                        optical_props_sw_prefetch, aerosol_props_sw_prefetch,
+                        sw_flux_up_col_prefetch, sw_flux_dn_col_prefetch,
+                        sw_flux_dn_dir_col_prefetch, sw_flux_net_col_prefetch,
+                        sw_flux_dn_dir_inc_prefetch, sw_flux_dn_dif_inc_prefetch, p_top_prefetch,
+                        gas_concs_col,
+                        *kdist_sw,
+                        col_dry,
+                        p_lay_col, p_lev_col,
+                        t_lay_col, t_lev_col,
+                        aerosol_concs_col,
+                        mu0,
+                        sfc_alb_dir, sfc_alb_dif,
+                        tsi_scaling_prefetch,
+                        n_lay_col);
+            });
+}
+
+template<typename TF>
+bool Radiation_rrtmgp<TF>::apply_background_prefetch(
+        const unsigned long itime, const Float p_top, const bool solve_at_night)
+{
+    if (!sw_prefetch_background)
+        return false;
+
+    if (background_prefetch.valid())
+        background_prefetch.get();
+
+    // The prefetch is of another step if a radiation step has been skipped, and of another
+    // top pressure if the base state has been updated, in which case it is solved again.
+    if (itime != itime_prefetch || p_top != p_top_prefetch || (solve_at_night && !is_day_prefetch))
+        return false;
+
+    this->mu0 = mu0_prefetch;
+    this->tsi_scaling = tsi_scaling_prefetch;
+
+    if (is_day_prefetch)
+    {
+        auto copy = [](Array<Float,2>& out, const Array<Float,2>& in)
+        {
+            std::copy(in.ptr(), in.ptr() + in.size(), out.ptr());
+        };
+
+        copy(sw_flux_up_col, sw_flux_up_col_prefetch);
+        copy(sw_flux_dn_col, sw_flux_dn_col_prefetch);
+        copy(sw_flux_dn_dir_col, sw_flux_dn_dir_col_prefetch);
+        copy(sw_flux_net_col, sw_flux_net_col_prefetch);
+        copy(sw_flux_dn_dir_inc, sw_flux_dn_dir_inc_prefetch);
+        copy(sw_flux_dn_dif_inc, sw_flux_dn_dif_inc_prefetch);
+    }
+
+    return true;
 }
 
 template<typename TF>
@@ -1664,13 +2392,27 @@ void Radiation_rrtmgp<TF>::exec(
 {
     auto& gd = grid.get_grid_data();
 
-    const bool do_radiation = ((timeloop.get_itime() % idt_rad == 0) && !timeloop.in_substep()) ;
+    bool do_radiation = ((timeloop.get_itime() % idt_rad == 0) && !timeloop.in_substep()) ;
     const bool do_radiation_stats = timeloop.is_stats_step();
 
+    if (do_radiation && sw_adaptive)
+    {
+        do_radiation = check_adaptive_update(thermo, timeloop);
+
+        // A finished asynchronous solve is applied at the skipped steps as well.
+        if (!do_radiation && sw_async)
+            apply_async_radiation();
+    }
+
     if (do_radiation)
     {
-        // Set the tendency to zero.
-        std::fill(fields.sd.at("thlt_rad")->fld.begin(), fields.sd.at("thlt_rad")->fld.end(), Float(0.));
+        // The result of the previous asynchronous solve replaces the current tendency and surface fluxes.
+        if (sw_async)
+            apply_async_radiation();
+
+        // The first call and the statistics steps are always solved synchronously.
+        const bool run_async = sw_async && async_initialized && !do_radiation_stats;
+        async_initialized = true;
 
         auto t_lay = fields.get_tmp();
         auto t_lev = fields.get_tmp();
@@ -1681,27 +2423,13 @@ void Radiation_rrtmgp<TF>::exec(
 
         // Set the input to the radiation on a 3D grid without ghost cells.
         thermo.get_radiation_fields(*t_lay, *t_lev, *h2o, *rh, *clwp, *ciwp);
-        const int nmaxh = gd.imax*gd.jmax*(gd.ktot+1);
-        const int ijmax = gd.imax*gd.jmax;
-
-        Array<Float,2> t_lay_a(t_lay->fld, {gd.imax*gd.jmax, gd.ktot});
-        Array<Float,2> t_lev_a(t_lev->fld, {gd.imax*gd.jmax, gd.ktot+1});
-        Array<Float,1> t_sfc_a(t_lev->fld_bot, {gd.imax*gd.jmax});
-        Array<Float,2> h2o_a(h2o->fld, {gd.imax*gd.jmax, gd.ktot});
-        Array<Float,2> rh_a(rh->fld, {gd.imax*gd.jmax, gd.ktot});
-        Array<Float,2> clwp_a(clwp->fld, {gd.imax*gd.jmax, gd.ktot});
-        Array<Float,2> ciwp_a(ciwp->fld, {gd.imax*gd.jmax, gd.ktot});
-
-        Array<Float,2> flux_up ({gd.imax*gd.jmax, gd.ktot+1});
-        Array<Float,2> flux_dn ({gd.imax*gd.jmax, gd.ktot+1});
-        Array<Float,2> flux_net({gd.imax*gd.jmax, gd.ktot+1});
-
-        const bool compute_clouds = true;
 
         // get aerosol mixing ratios
         if (sw_aerosol && swtimedep_aerosol)
             aerosol.get_radiation_fields(aerosol_concs);
 
+        // Everything that depends on the state of other components or on the time is updated here,
+        // before the solve, which can run asynchronously.
         try
         {
             if (swtimedep_background)
@@ -1718,101 +2446,252 @@ void Radiation_rrtmgp<TF>::exec(
                 }
             }
 
-            if (sw_longwave)
+            if (sw_longwave && (swtimedep_background || swtimedep_basestate))
             {
-                if (swtimedep_background || swtimedep_basestate)
-                {
-                    // Calculate new background column for the longwave.
-                    const TF p_top = thermo.get_basestate_vector("ph")[gd.kend];
-                    set_background_column_longwave(p_top);
-                }
+                // Calculate new background column for the longwave.
+                const TF p_top = thermo.get_basestate_vector("ph")[gd.kend];
+                set_background_column_longwave(p_top);
+            }
 
-                exec_longwave(
-                        thermo, microphys, timeloop, stats,
-                        flux_up, flux_dn, flux_net,
-                        t_lay_a, t_lev_a, t_sfc_a, h2o_a, clwp_a, ciwp_a,
-                        compute_clouds, gd.imax*gd.jmax);
-
-                calc_tendency(
-                        fields.sd.at("thlt_rad")->fld.data(),
-                        flux_up.ptr(), flux_dn.ptr(),
-                        fields.rhoref.data(), thermo.get_basestate_vector("exner").data(),
-                        gd.dz.data(),
-                        gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                        gd.igc, gd.jgc, gd.kgc,
-                        gd.icells, gd.ijcells,
-                        gd.imax, gd.imax*gd.jmax);
-
-                store_surface_fluxes(
-                        lw_flux_up_sfc.data(), lw_flux_dn_sfc.data(),
-                        flux_up.ptr(), flux_dn.ptr(),
-                        gd.istart, gd.iend,
-                        gd.jstart, gd.jend,
-                        gd.igc, gd.jgc,
-                        gd.icells, gd.ijcells,
-                        gd.imax);
-
-                if (do_radiation_stats)
+            if (sw_shortwave)
+            {
+                const TF p_top = thermo.get_basestate_vector("ph")[gd.kend];
+
+                if (!apply_background_prefetch(timeloop.get_itime(), p_top, false))
                 {
-                    // Make sure that the top boundary is taken into account in case of fluxes.
-                    auto do_gcs = [&](Field3d<Float>& out, const Array<Float,2>& in)
+                    if (!sw_fixed_sza)
                     {
-                        add_ghost_cells(
-                                out.fld.data(), in.ptr(),
-                                gd.istart, gd.iend,
-                                gd.jstart, gd.jend,
-                                gd.kstart, gd.kend+1,
-                                gd.icells, gd.ijcells,
-                                gd.imax, gd.imax*gd.jmax);
-                    };
-
-                    do_gcs(*fields.sd.at("lw_flux_up"), flux_up);
-                    do_gcs(*fields.sd.at("lw_flux_dn"), flux_dn);
+                        // Update the solar zenith angle and sun-earth distance.
+                        set_sun_location(timeloop);
+                    }
 
-                    if (sw_clear_sky_stats)
+                    if (!sw_fixed_sza || swtimedep_background)
                     {
-                        exec_longwave(
-                                thermo, microphys, timeloop, stats,
-                                flux_up, flux_dn, flux_net,
-                                t_lay_a, t_lev_a, t_sfc_a, h2o_a, clwp_a, ciwp_a,
-                                !compute_clouds, gd.imax*gd.jmax);
-
-                        do_gcs(*fields.sd.at("lw_flux_up_clear"), flux_up);
-                        do_gcs(*fields.sd.at("lw_flux_dn_clear"), flux_dn);
+                        // Calculate new background column for the shortwave.
+                        if (is_day(this->mu0))
+                            set_background_column_shortwave(p_top);
                     }
                 }
             }
+        }
+        catch (std::exception& e)
+        {
+            #ifdef USEMPI
+            std::cout << "SINGLE PROCESS EXCEPTION: " << e.what() << std::endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+            #else
+            throw;
+            #endif
+        }
 
-            if (sw_shortwave)
+        // With swincremental, only the columns in `cols_rad` are solved, after the sun location is updated.
+        std::vector<int> cols_rad;
+        const bool incremental_solve = sw_incremental
+            && select_incremental_columns(cols_rad, *t_lay, *t_lev, *h2o, *clwp, *ciwp, timeloop);
+
+        // An asynchronous solve writes into its own buffers, which are applied at the next radiation step.
+        Float* const thlt_rad_out = run_async ? thlt_rad_async.data() : fields.sd.at("thlt_rad")->fld.data();
+        Float* const lw_flux_up_sfc_out = run_async ? lw_flux_up_sfc_async.data() : lw_flux_up_sfc.data();
+        Float* const lw_flux_dn_sfc_out = run_async ? lw_flux_dn_sfc_async.data() : lw_flux_dn_sfc.data();
+        Float* const sw_flux_up_sfc_out = run_async ? sw_flux_up_sfc_async.data() : sw_flux_up_sfc.data();
+        Float* const sw_flux_dn_sfc_out = run_async ? sw_flux_dn_sfc_async.data() : sw_flux_dn_sfc.data();
+
+        Thermo<TF>* const thermo_ptr = &thermo;
+        Microphys<TF>* const microphys_ptr = &microphys;
+        Timeloop<TF>* const timeloop_ptr = &timeloop;
+        Stats<TF>* const stats_ptr = &stats;
+
+        // The solve owns the input fields, such that it can outlive this call.
+        auto solve = [
+                this, thermo_ptr, microphys_ptr, timeloop_ptr, stats_ptr, do_radiation_stats,
+                incremental_solve, cols_rad = std::move(cols_rad),
+                thlt_rad_out, lw_flux_up_sfc_out, lw_flux_dn_sfc_out, sw_flux_up_sfc_out, sw_flux_dn_sfc_out,
+                t_lay = std::move(t_lay), t_lev = std::move(t_lev), h2o = std::move(h2o),
+                rh = std::move(rh), clwp = std::move(clwp), ciwp = std::move(ciwp)]() mutable
+        {
+            Thermo<TF>& thermo = *thermo_ptr;
+            Microphys<TF>& microphys = *microphys_ptr;
+            Timeloop<TF>& timeloop = *timeloop_ptr;
+            Stats<TF>& stats = *stats_ptr;
+
+            auto& gd = grid.get_grid_data();
+
+            // Set the tendency to zero.
+            std::fill(thlt_rad_out, thlt_rad_out + gd.ncells, Float(0.));
+
+            const int nmaxh = gd.imax*gd.jmax*(gd.ktot+1);
+            const int ijmax = gd.imax*gd.jmax;
+
+            Array<Float,2> t_lay_a(t_lay->fld, {gd.imax*gd.jmax, gd.ktot});
+            Array<Float,2> t_lev_a(t_lev->fld, {gd.imax*gd.jmax, gd.ktot+1});
+            Array<Float,1> t_sfc_a(t_lev->fld_bot, {gd.imax*gd.jmax});
+            Array<Float,2> h2o_a(h2o->fld, {gd.imax*gd.jmax, gd.ktot});
+            Array<Float,2> rh_a(rh->fld, {gd.imax*gd.jmax, gd.ktot});
+            Array<Float,2> clwp_a(clwp->fld, {gd.imax*gd.jmax, gd.ktot});
+            Array<Float,2> ciwp_a(ciwp->fld, {gd.imax*gd.jmax, gd.ktot});
+
+            Array<Float,2> flux_up ({gd.imax*gd.jmax, gd.ktot+1});
+            Array<Float,2> flux_dn ({gd.imax*gd.jmax, gd.ktot+1});
+            Array<Float,2> flux_net({gd.imax*gd.jmax, gd.ktot+1});
+
+            // With ncoarse > 1, the solvers run on the mean profiles of the blocks of columns,
+            // and the fluxes of each block are copied back to all of its columns. An incremental
+            // solve packs the columns in `cols_rad` and copies their fluxes back to these columns.
+            const bool coarse = (n_coarse > 1);
+            const bool packed = coarse || incremental_solve;
+            const int n_col_rad = incremental_solve
+                ? static_cast<int>(cols_rad.size()) : (gd.imax*gd.jmax) / (n_coarse*n_coarse);
+
+            Array<Float,2> t_lay_c, t_lev_c, h2o_c, rh_c, clwp_c, ciwp_c;
+            Array<Float,1> t_sfc_c;
+            Array<Float,2> flux_up_c, flux_dn_c, flux_net_c;
+
+            if (packed)
             {
-                if (!sw_fixed_sza)
+                auto coarsen = [&](Array<Float,2>& out, const Array<Float,2>& in, const int nlev)
                 {
-                    // Update the solar zenith angle and sun-earth distance.
-                    set_sun_location(timeloop);
-                }
+                    out.set_dims({n_col_rad, nlev});
+                    if (coarse)
+                        coarsen_columns(out.ptr(), in.ptr(), gd.imax, gd.jmax, nlev, n_coarse);
+                    else
+                        gather_columns(out.ptr(), in.ptr(), cols_rad, gd.imax*gd.jmax, nlev);
+                };
+
+                coarsen(t_lay_c, t_lay_a, gd.ktot);
+                coarsen(t_lev_c, t_lev_a, gd.ktot+1);
+                coarsen(h2o_c, h2o_a, gd.ktot);
+                coarsen(rh_c, rh_a, gd.ktot);
+                coarsen(clwp_c, clwp_a, gd.ktot);
+                coarsen(ciwp_c, ciwp_a, gd.ktot);
+
+                t_sfc_c.set_dims({n_col_rad});
+                if (coarse)
+                    coarsen_columns(t_sfc_c.ptr(), t_sfc_a.ptr(), gd.imax, gd.jmax, 1, n_coarse);
+                else
+                    gather_columns(t_sfc_c.ptr(), t_sfc_a.ptr(), cols_rad, gd.imax*gd.jmax, 1);
 
-                if (!sw_fixed_sza || swtimedep_background)
-                {
-                // Calculate new background column for the shortwave.
-                    if (is_day(this->mu0))
-                    {
-                        const TF p_top = thermo.get_basestate_vector("ph")[gd.kend];
-                        set_background_column_shortwave(p_top);
-                    }
-                }
+                flux_up_c .set_dims({n_col_rad, gd.ktot+1});
+                flux_dn_c .set_dims({n_col_rad, gd.ktot+1});
+                flux_net_c.set_dims({n_col_rad, gd.ktot+1});
+            }
 
-                Array<Float,2> flux_dn_dir({gd.imax*gd.jmax, gd.ktot+1});
-                if (is_day(this->mu0))
+            const Array<Float,2>& t_lay_r = packed ? t_lay_c : t_lay_a;
+            const Array<Float,2>& t_lev_r = packed ? t_lev_c : t_lev_a;
+            const Array<Float,1>& t_sfc_r = packed ? t_sfc_c : t_sfc_a;
+            const Array<Float,2>& h2o_r   = packed ? h2o_c   : h2o_a;
+            const Array<Float,2>& rh_r    = packed ? rh_c    : rh_a;
+            const Array<Float,2>& clwp_r  = packed ? clwp_c  : clwp_a;
+            const Array<Float,2>& ciwp_r  = packed ? ciwp_c  : ciwp_a;
+
+            Array<Float,2>& flux_up_r  = packed ? flux_up_c  : flux_up;
+            Array<Float,2>& flux_dn_r  = packed ? flux_dn_c  : flux_dn;
+            Array<Float,2>& flux_net_r = packed ? flux_net_c : flux_net;
+
+            // With swloadbalance, the processes above the mean cost send cloudy columns to the processes
+            // below it, which solve them next to their own columns and return their fluxes after each solve.
+            Column_balance balance;
+            if (sw_load_balance)
+                balance = plan_column_balance(
+                        clwp_r.ptr(), ciwp_r.ptr(), n_col_rad, gd.imax*gd.jmax, gd.ktot,
+                        load_balance_cloud_cost, master);
+
+            const bool balanced = balance.active;
+            const int n_col_s = balanced ? balance.n_col_solve : n_col_rad;
+
+            Array<Float,2> t_lay_b, t_lev_b, h2o_b, rh_b, clwp_b, ciwp_b;
+            Array<Float,1> t_sfc_b;
+            Array<Float,2> flux_up_b, flux_dn_b, flux_net_b;
+
+            if (balanced)
+            {
+                t_lay_b.set_dims({n_col_s, gd.ktot});
+                t_lev_b.set_dims({n_col_s, gd.ktot+1});
+                t_sfc_b.set_dims({n_col_s});
+                h2o_b.set_dims({n_col_s, gd.ktot});
+                rh_b.set_dims({n_col_s, gd.ktot});
+                clwp_b.set_dims({n_col_s, gd.ktot});
+                ciwp_b.set_dims({n_col_s, gd.ktot});
+
+                distribute_columns(
+                        {t_lay_b.ptr(), t_lev_b.ptr(), t_sfc_b.ptr(), h2o_b.ptr(), rh_b.ptr(), clwp_b.ptr(), ciwp_b.ptr()},
+                        {t_lay_r.ptr(), t_lev_r.ptr(), t_sfc_r.ptr(), h2o_r.ptr(), rh_r.ptr(), clwp_r.ptr(), ciwp_r.ptr()},
+                        {gd.ktot, gd.ktot+1, 1, gd.ktot, gd.ktot, gd.ktot, gd.ktot},
+                        n_col_rad, balance, master);
+
+                flux_up_b .set_dims({n_col_s, gd.ktot+1});
+                flux_dn_b .set_dims({n_col_s, gd.ktot+1});
+                flux_net_b.set_dims({n_col_s, gd.ktot+1});
+            }
+
+            const Array<Float,2>& t_lay_s = balanced ? t_lay_b : t_lay_r;
+            const Array<Float,2>& t_lev_s = balanced ? t_lev_b : t_lev_r;
+            const Array<Float,1>& t_sfc_s = balanced ? t_sfc_b : t_sfc_r;
+            const Array<Float,2>& h2o_s   = balanced ? h2o_b   : h2o_r;
+            const Array<Float,2>& rh_s    = balanced ? rh_b    : rh_r;
+            const Array<Float,2>& clwp_s  = balanced ? clwp_b  : clwp_r;
+            const Array<Float,2>& ciwp_s  = balanced ? ciwp_b  : ciwp_r;
+
+            Array<Float,2>& flux_up_s  = balanced ? flux_up_b  : flux_up_r;
+            Array<Float,2>& flux_dn_s  = balanced ? flux_dn_b  : flux_dn_r;
+            Array<Float,2>& flux_net_s = balanced ? flux_net_b : flux_net_r;
+
+            // Return the fluxes of the balanced solve to the processes that own the columns.
+            auto collect = [&](const std::vector<Float*>& out, const std::vector<const Float*>& in)
+            {
+                if (balanced)
+                    collect_columns(out, in, std::vector<int>(out.size(), gd.ktot+1), n_col_rad, balance, master);
+            };
+
+            auto refine = [&](Array<Float,2>& out, const Array<Float,2>& in)
+            {
+                if (coarse)
+                    refine_columns(out.ptr(), in.ptr(), gd.imax, gd.jmax, gd.ktot+1, n_coarse);
+                else if (incremental_solve)
+                    scatter_columns(out.ptr(), in.ptr(), cols_rad, gd.imax*gd.jmax, gd.ktot+1);
+            };
+
+            // The columns that an incremental solve skips keep the fluxes of their last solve.
+            auto load_last = [&](Array<Float,2>& out, const std::vector<Float>& last)
+            {
+                if (incremental_solve)
+                    std::copy(last.begin(), last.end(), out.ptr());
+            };
+
+            auto save_last = [&](std::vector<Float>& last, const Array<Float,2>& in)
+            {
+                if (sw_incremental)
+                    last.assign(in.ptr(), in.ptr() + in.size());
+            };
+
+            const bool compute_clouds = true;
+
+            try
+            {
+                if (sw_longwave)
                 {
-                    exec_shortwave(
-                            thermo, microphys, timeloop, stats,
-                            flux_up, flux_dn, flux_dn_dir, flux_net,
-                            aod550,
-                            t_lay_a, t_lev_a, h2o_a, rh_a, clwp_a, ciwp_a,
-                            compute_clouds, gd.imax * gd.jmax);
+                    load_last(flux_up, lw_flux_up_last);
+                    load_last(flux_dn, lw_flux_dn_last);
+
+                    if (n_col_s > 0)
+                        exec_longwave(
+                                thermo, microphys, timeloop, stats,
+                                flux_up_s, flux_dn_s, flux_net_s,
+                                t_lay_s, t_lev_s, t_sfc_s, h2o_s, clwp_s, ciwp_s,
+                                compute_clouds, n_col_s);
+
+                    collect(
+                            {flux_up_r.ptr(), flux_dn_r.ptr(), flux_net_r.ptr()},
+                            {flux_up_s.ptr(), flux_dn_s.ptr(), flux_net_s.ptr()});
+
+                    refine(flux_up, flux_up_r);
+                    refine(flux_dn, flux_dn_r);
+                    refine(flux_net, flux_net_r);
+
+                    save_last(lw_flux_up_last, flux_up);
+                    save_last(lw_flux_dn_last, flux_dn);
 
                     calc_tendency(
-                            fields.sd.at("thlt_rad")->fld.data(),
+                            thlt_rad_out,
                             flux_up.ptr(), flux_dn.ptr(),
                             fields.rhoref.data(), thermo.get_basestate_vector("exner").data(),
                             gd.dz.data(),
@@ -1822,7 +2701,7 @@ void Radiation_rrtmgp<TF>::exec(
                             gd.imax, gd.imax*gd.jmax);
 
                     store_surface_fluxes(
-                            sw_flux_up_sfc.data(), sw_flux_dn_sfc.data(),
+                            lw_flux_up_sfc_out, lw_flux_dn_sfc_out,
                             flux_up.ptr(), flux_dn.ptr(),
                             gd.istart, gd.iend,
                             gd.jstart, gd.jend,
@@ -1830,95 +2709,256 @@ void Radiation_rrtmgp<TF>::exec(
                             gd.icells, gd.ijcells,
                             gd.imax);
 
-                    if (sw_diffuse_filter)
+                    if (do_radiation_stats)
                     {
-                        // Misuse `t_lay`'s surface fields as tmp fields..
-                        filter_diffuse_radiation<TF>(
-                                sw_flux_dn_dif_f.data(),
-                                sw_flux_dn_sfc.data(),
-                                sw_flux_up_sfc.data(),
-                                t_lay->fld_bot.data(), t_lay->flux_bot.data(),
-                                flux_dn.ptr(), flux_dn_dir.ptr(),
-                                filter_kernel_x.data(), filter_kernel_y.data(),
-                                n_filter_iterations,
-                                sfc_alb_dir.ptr(), sfc_alb_dif.ptr(),
-                                gd.istart, gd.iend,
-                                gd.jstart, gd.jend,
-                                gd.igc, gd.jgc,
-                                gd.icells, gd.jcells,
-                                gd.ijcells, gd.imax,
-                                boundary_cyclic);
-                    }
-                }
-                else
-                {
-                    // Set the surface fluxes to zero, for (e.g.) the land-surface model.
-                    std::fill(sw_flux_up_sfc.begin(), sw_flux_up_sfc.end(), Float(0));
-                    std::fill(sw_flux_dn_sfc.begin(), sw_flux_dn_sfc.end(), Float(0));
+                        // Make sure that the top boundary is taken into account in case of fluxes.
+                        auto do_gcs = [&](Field3d<Float>& out, const Array<Float,2>& in)
+                        {
+                            add_ghost_cells(
+                                    out.fld.data(), in.ptr(),
+                                    gd.istart, gd.iend,
+                                    gd.jstart, gd.jend,
+                                    gd.kstart, gd.kend+1,
+                                    gd.icells, gd.ijcells,
+                                    gd.imax, gd.imax*gd.jmax);
+                        };
+
+                        do_gcs(*fields.sd.at("lw_flux_up"), flux_up);
+                        do_gcs(*fields.sd.at("lw_flux_dn"), flux_dn);
+
+                        if (sw_clear_sky_stats)
+                        {
+                            exec_longwave(
+                                    thermo, microphys, timeloop, stats,
+                                    flux_up_s, flux_dn_s, flux_net_s,
+                                    t_lay_s, t_lev_s, t_sfc_s, h2o_s, clwp_s, ciwp_s,
+                                    !compute_clouds, n_col_s);
+
+                            collect(
+                                    {flux_up_r.ptr(), flux_dn_r.ptr()},
+                                    {flux_up_s.ptr(), flux_dn_s.ptr()});
+
+                            refine(flux_up, flux_up_r);
+                            refine(flux_dn, flux_dn_r);
 
-                    if (sw_diffuse_filter)
-                        std::fill(sw_flux_dn_dif_f.begin(), sw_flux_dn_dif_f.end(), TF(0));
+                            do_gcs(*fields.sd.at("lw_flux_up_clear"), flux_up);
+                            do_gcs(*fields.sd.at("lw_flux_dn_clear"), flux_dn);
+                        }
+                    }
                 }
 
-                if (do_radiation_stats)
+                if (sw_shortwave)
                 {
-                    // Make sure that the top boundary is taken into account in case of fluxes.
-                    auto do_gcs = [&](Field3d<Float>& out, const Array<Float,2>& in)
+                    Array<Float,2> flux_dn_dir({gd.imax*gd.jmax, gd.ktot+1});
+                    Array<Float,2> flux_dn_dir_c;
+                    if (packed)
+                        flux_dn_dir_c.set_dims({n_col_rad, gd.ktot+1});
+                    Array<Float,2>& flux_dn_dir_r = packed ? flux_dn_dir_c : flux_dn_dir;
+
+                    Array<Float,2> flux_dn_dir_b;
+                    if (balanced)
+                        flux_dn_dir_b.set_dims({n_col_s, gd.ktot+1});
+                    Array<Float,2>& flux_dn_dir_s = balanced ? flux_dn_dir_b : flux_dn_dir_r;
+
+                    // The aerosol optical depth of the balanced solve is stored in the first n_col_s elements.
+                    auto collect_aod = [&]()
+                    {
+                        if (balanced && sw_aerosol)
+                        {
+                            const std::vector<Float> aod550_s(aod550.v().begin(), aod550.v().begin() + n_col_s);
+                            collect_columns({aod550.ptr()}, {aod550_s.data()}, {1}, n_col_rad, balance, master);
+                        }
+                    };
+
+                    // The aerosol optical depth of the coarse columns is stored in the first n_col_rad elements.
+                    auto refine_aod = [&]()
+                    {
+                        if (coarse && sw_aerosol)
+                        {
+                            const std::vector<Float> aod550_c(aod550.v().begin(), aod550.v().begin() + n_col_rad);
+                            refine_columns(aod550.ptr(), aod550_c.data(), gd.imax, gd.jmax, 1, n_coarse);
+                        }
+                        else if (incremental_solve && sw_aerosol)
+                        {
+                            const std::vector<Float> aod550_c(aod550.v().begin(), aod550.v().begin() + n_col_rad);
+                            std::copy(aod550_last.begin(), aod550_last.end(), aod550.ptr());
+                            scatter_columns(aod550.ptr(), aod550_c.data(), cols_rad, gd.imax*gd.jmax, 1);
+                        }
+                    };
+                    if (is_day(this->mu0))
                     {
-                        add_ghost_cells(
-                                out.fld.data(), in.ptr(),
+                        load_last(flux_up, sw_flux_up_last);
+                        load_last(flux_dn, sw_flux_dn_last);
+                        load_last(flux_dn_dir, sw_flux_dn_dir_last);
+
+                        if (n_col_s > 0)
+                            exec_shortwave(
+                                    thermo, microphys, timeloop, stats,
+                                    flux_up_s, flux_dn_s, flux_dn_dir_s, flux_net_s,
+                                    aod550,
+                                    t_lay_s, t_lev_s, h2o_s, rh_s, clwp_s, ciwp_s,
+                                    compute_clouds, n_col_s);
+
+                        collect(
+                                {flux_up_r.ptr(), flux_dn_r.ptr(), flux_dn_dir_r.ptr(), flux_net_r.ptr()},
+                                {flux_up_s.ptr(), flux_dn_s.ptr(), flux_dn_dir_s.ptr(), flux_net_s.ptr()});
+                        collect_aod();
+
+                        refine(flux_up, flux_up_r);
+                        refine(flux_dn, flux_dn_r);
+                        refine(flux_dn_dir, flux_dn_dir_r);
+                        refine(flux_net, flux_net_r);
+                        refine_aod();
+
+                        save_last(sw_flux_up_last, flux_up);
+                        save_last(sw_flux_dn_last, flux_dn);
+                        save_last(sw_flux_dn_dir_last, flux_dn_dir);
+                        if (sw_incremental && sw_aerosol)
+                            aod550_last.assign(aod550.v().begin(), aod550.v().end());
+
+                        calc_tendency(
+                                thlt_rad_out,
+                                flux_up.ptr(), flux_dn.ptr(),
+                                fields.rhoref.data(), thermo.get_basestate_vector("exner").data(),
+                                gd.dz.data(),
+                                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                                gd.igc, gd.jgc, gd.kgc,
+                                gd.icells, gd.ijcells,
+                                gd.imax, gd.imax*gd.jmax);
+
+                        store_surface_fluxes(
+                                sw_flux_up_sfc_out, sw_flux_dn_sfc_out,
+                                flux_up.ptr(), flux_dn.ptr(),
                                 gd.istart, gd.iend,
                                 gd.jstart, gd.jend,
-                                gd.kstart, gd.kend+1,
+                                gd.igc, gd.jgc,
                                 gd.icells, gd.ijcells,
-                                gd.imax, gd.imax*gd.jmax);
-                    };
+                                gd.imax);
 
-                    if (!is_day(this->mu0))
-                    {
-                        flux_up.fill(Float(0.));
-                        flux_dn.fill(Float(0.));
-                        flux_dn_dir.fill(Float(0.));
+                        if (sw_diffuse_filter)
+                        {
+                            // Misuse `t_lay`'s surface fields as tmp fields..
+                            filter_diffuse_radiation<TF>(
+                                    sw_flux_dn_dif_f.data(),
+                                    sw_flux_dn_sfc.data(),
+                                    sw_flux_up_sfc.data(),
+                                    t_lay->fld_bot.data(), t_lay->flux_bot.data(),
+                                    flux_dn.ptr(), flux_dn_dir.ptr(),
+                                    filter_kernel_x.data(), filter_kernel_y.data(),
+                                    n_filter_iterations,
+                                    sfc_alb_dir.ptr(), sfc_alb_dif.ptr(),
+                                    gd.istart, gd.iend,
+                                    gd.jstart, gd.jend,
+                                    gd.igc, gd.jgc,
+                                    gd.icells, gd.jcells,
+                                    gd.ijcells, gd.imax,
+                                    boundary_cyclic);
+                        }
                     }
+                    else
+                    {
+                        // Set the surface fluxes to zero, for (e.g.) the land-surface model.
+                        std::fill(sw_flux_up_sfc_out, sw_flux_up_sfc_out + gd.ijcells, Float(0));
+                        std::fill(sw_flux_dn_sfc_out, sw_flux_dn_sfc_out + gd.ijcells, Float(0));
 
-                    do_gcs(*fields.sd.at("sw_flux_up"), flux_up);
-                    do_gcs(*fields.sd.at("sw_flux_dn"), flux_dn);
-                    do_gcs(*fields.sd.at("sw_flux_dn_dir"), flux_dn_dir);
+                        if (sw_diffuse_filter)
+                            std::fill(sw_flux_dn_dif_f.begin(), sw_flux_dn_dif_f.end(), TF(0));
+                    }
 
-                    if (sw_clear_sky_stats)
+                    if (do_radiation_stats)
                     {
-                        if (is_day(this->mu0))
+                        // Make sure that the top boundary is taken into account in case of fluxes.
+                        auto do_gcs = [&](Field3d<Float>& out, const Array<Float,2>& in)
                         {
-                            exec_shortwave(
-                                    thermo, microphys, timeloop, stats,
-                                    flux_up, flux_dn, flux_dn_dir, flux_net,
-                                    aod550,
-                                    t_lay_a, t_lev_a, h2o_a, rh_a, clwp_a, ciwp_a,
-                                    !compute_clouds, gd.imax * gd.jmax);
+                            add_ghost_cells(
+                                    out.fld.data(), in.ptr(),
+                                    gd.istart, gd.iend,
+                                    gd.jstart, gd.jend,
+                                    gd.kstart, gd.kend+1,
+                                    gd.icells, gd.ijcells,
+                                    gd.imax, gd.imax*gd.jmax);
+                        };
+
+                        if (!is_day(this->mu0))
+                        {
+                            flux_up.fill(Float(0.));
+                            flux_dn.fill(Float(0.));
+                            flux_dn_dir.fill(Float(0.));
+                        }
+
+                        do_gcs(*fields.sd.at("sw_flux_up"), flux_up);
+                        do_gcs(*fields.sd.at("sw_flux_dn"), flux_dn);
+                        do_gcs(*fields.sd.at("sw_flux_dn_dir"), flux_dn_dir);
+
+                        if (sw_clear_sky_stats)
+                        {
+                            if (is_day(this->mu0))
+                            {
+                                exec_shortwave(
+                                        thermo, microphys, timeloop, stats,
+                                        flux_up_s, flux_dn_s, flux_dn_dir_s, flux_net_s,
+                                        aod550,
+                                        t_lay_s, t_lev_s, h2o_s, rh_s, clwp_s, ciwp_s,
+                                        !compute_clouds, n_col_s);
+
+                                collect(
+                                        {flux_up_r.ptr(), flux_dn_r.ptr(), flux_dn_dir_r.ptr()},
+                                        {flux_up_s.ptr(), flux_dn_s.ptr(), flux_dn_dir_s.ptr()});
+                                collect_aod();
+
+                                refine(flux_up, flux_up_r);
+                                refine(flux_dn, flux_dn_r);
+                                refine(flux_dn_dir, flux_dn_dir_r);
+                                refine_aod();
+                            }
+                            do_gcs(*fields.sd.at("sw_flux_up_clear"), flux_up);
+                            do_gcs(*fields.sd.at("sw_flux_dn_clear"), flux_dn);
+                            do_gcs(*fields.sd.at("sw_flux_dn_dir_clear"), flux_dn_dir);
                         }
-                        do_gcs(*fields.sd.at("sw_flux_up_clear"), flux_up);
-                        do_gcs(*fields.sd.at("sw_flux_dn_clear"), flux_dn);
-                        do_gcs(*fields.sd.at("sw_flux_dn_dir_clear"), flux_dn_dir);
                     }
                 }
+            } // End try block.
+            catch (std::exception& e)
+            {
+                #ifdef USEMPI
+                std::cout << "SINGLE PROCESS EXCEPTION: " << e.what() << std::endl;
+                MPI_Abort(MPI_COMM_WORLD, 1);
+                #else
+                throw;
+                #endif
             }
-        } // End try block.
-        catch (std::exception& e)
+
+            fields.release_tmp(t_lay);
+            fields.release_tmp(t_lev);
+            fields.release_tmp(h2o);
+            fields.release_tmp(rh);
+            fields.release_tmp(clwp);
+            fields.release_tmp(ciwp);
+        };
+
+        if (run_async)
         {
-            #ifdef USEMPI
-            std::cout << "SINGLE PROCESS EXCEPTION: " << e.what() << std::endl;
-            MPI_Abort(MPI_COMM_WORLD, 1);
-            #else
-            throw;
-            #endif
+            async_pending = true;
+
+            // Errors are rethrown on the thread that waits for the solve.
+            #pragma omp task default(shared) firstprivate(solve)
+            {
+                try
+                {
+                    solve();
+                }
+                catch (...)
+                {
+                    async_exception = std::current_exception();
+                }
+            }
         }
+        else
+            solve();
 
-        fields.release_tmp(t_lay);
-        fields.release_tmp(t_lev);
-        fields.release_tmp(h2o);
-        fields.release_tmp(rh);
-        fields.release_tmp(clwp);
-        fields.release_tmp(ciwp);
+        // Solve the background column of the next radiation step next to the time integration.
+        if (sw_prefetch_background)
+            start_background_prefetch(timeloop, thermo.get_basestate_vector("ph")[gd.kend]);
     }
 
     // Always add the tendency.
@@ -1973,6 +3013,9 @@ void Radiation_rrtmgp<TF>::exec_all_stats(
     if ( !(do_stats || do_cross || do_column) )
         return;
 
+    // The statistics use the members that an asynchronous solve writes to.
+    wait_async_radiation();
+
     const Float no_offset = 0.;
     const Float no_threshold = 0.;
 
@@ -2089,6 +3132,9 @@ void Radiation_rrtmgp<TF>::exec_individual_column_stats(
 {
     auto& gd = grid.get_grid_data();
 
+    // The column solves share the gas concentrations and optics with an asynchronous solve.
+    wait_async_radiation();
+
     // Get column indices.
     std::vector<int> col_i;
     std::vector<int> col_j;
@@ -2309,21 +3355,22 @@ void Radiation_rrtmgp<TF>::exec_longwave(
         const Array<Float,2>& h2o, const Array<Float,2>& clwp, const Array<Float,2>& ciwp,
         const bool compute_clouds, const int n_col)
 {
-    // How many profiles are solved simultaneously?
-    constexpr int n_col_block = 4;
-
     auto& gd = grid.get_grid_data();
 
     const int n_lay = gd.ktot;
     const int n_lev = gd.ktot+1;
 
-    const int n_blocks = n_col / n_col_block;
-    const int n_col_block_left = n_col % n_col_block;
-
     // Store the number of bands and gpt in a variable.
     const int n_bnd = kdist_lw->get_nband();
     const int n_gpt = kdist_lw->get_ngpt();
 
+    // How many profiles are solved simultaneously? The optical depth, three sources
+    // and two g-point fluxes are the large arrays of a block.
+    const int n_col_block = get_column_block_size(n_col_block_cpu, n_gpt, n_lev, 6);
+
+    const int n_blocks = n_col / n_col_block;
+    const int n_col_block_left = n_col % n_col_block;
+
     // Set the number of angles to 1.
     const int n_ang = 1;
 
@@ -2331,13 +3378,6 @@ void Radiation_rrtmgp<TF>::exec_longwave(
     const int top_at_1 = 0;
 
     // Define the pointers for the subsetting.
-    std::unique_ptr<Optical_props_arry> optical_props_subset =
-            std::make_unique<Optical_props_1scl>(n_col_block, n_lay, *kdist_lw);
-    std::unique_ptr<Source_func_lw> sources_subset =
-            std::make_unique<Source_func_lw>(n_col_block, n_lay, *kdist_lw);
-    std::unique_ptr<Optical_props_1scl> cloud_optical_props_subset =
-            std::make_unique<Optical_props_1scl>(n_col_block, n_lay, *cloud_lw);
-
     std::unique_ptr<Optical_props_arry> optical_props_left =
             std::make_unique<Optical_props_1scl>(n_col_block_left, n_lay, *kdist_lw);
     std::unique_ptr<Source_func_lw> sources_left =
@@ -2464,24 +3504,36 @@ void Radiation_rrtmgp<TF>::exec_longwave(
             }
     };
 
-    for (int b=1; b<=n_blocks; ++b)
+    // The blocks are independent, each thread solves its blocks with its own optical properties.
+    #pragma omp parallel if(n_blocks > 1)
     {
-        const int col_s = (b-1) * n_col_block + 1;
-        const int col_e =  b    * n_col_block;
-
-        Array<Float,2> emis_sfc_subset = emis_sfc.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<Float,2> lw_flux_dn_inc_subset = lw_flux_dn_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
+        std::unique_ptr<Optical_props_arry> optical_props_subset =
+                std::make_unique<Optical_props_1scl>(n_col_block, n_lay, *kdist_lw);
+        std::unique_ptr<Source_func_lw> sources_subset =
+                std::make_unique<Source_func_lw>(n_col_block, n_lay, *kdist_lw);
+        std::unique_ptr<Optical_props_1scl> cloud_optical_props_subset =
+                std::make_unique<Optical_props_1scl>(n_col_block, n_lay, *cloud_lw);
         std::unique_ptr<Fluxes_broadband> fluxes_subset =
                 std::make_unique<Fluxes_broadband>(n_col_block, n_lev);
 
-        call_kernels(
-                col_s, col_e,
-                optical_props_subset,
-                cloud_optical_props_subset,
-                *sources_subset,
-                emis_sfc_subset,
-                lw_flux_dn_inc_subset,
-                fluxes_subset);
+        #pragma omp for schedule(dynamic)
+        for (int b=1; b<=n_blocks; ++b)
+        {
+            const int col_s = (b-1) * n_col_block + 1;
+            const int col_e =  b    * n_col_block;
+
+            Array<Float,2> emis_sfc_subset = emis_sfc.subset({{ {1, n_bnd}, {col_s, col_e} }});
+            Array<Float,2> lw_flux_dn_inc_subset = lw_flux_dn_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
+
+            call_kernels(
+                    col_s, col_e,
+                    optical_props_subset,
+                    cloud_optical_props_subset,
+                    *sources_subset,
+                    emis_sfc_subset,
+                    lw_flux_dn_inc_subset,
+                    fluxes_subset);
+        }
     }
 
     if (n_col_block_left > 0)
@@ -2517,36 +3569,26 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
         const Array<Float,2>& clwp, const Array<Float,2>& ciwp,
         const bool compute_clouds, const int n_col)
 {
-    // How many profiles are solved simultaneously?
-    constexpr int n_col_block = 4;
-
     auto& gd = grid.get_grid_data();
 
     const int n_lay = gd.ktot;
     const int n_lev = gd.ktot+1;
 
-    const int n_blocks = n_col / n_col_block;
-    const int n_col_block_left = n_col % n_col_block;
-
     // Store the number of bands and gpt in a variable.
     const int n_bnd = kdist_sw->get_nband();
     const int n_gpt = kdist_sw->get_ngpt();
 
+    // How many profiles are solved simultaneously? The three gas optical properties
+    // and three g-point fluxes are the large arrays of a block.
+    const int n_col_block = get_column_block_size(n_col_block_cpu, n_gpt, n_lev, 6);
+
+    const int n_blocks = n_col / n_col_block;
+    const int n_col_block_left = n_col % n_col_block;
+
     // Check the dimension ordering. The top is not at 1 in MicroHH, but the surface is.
     const int top_at_1 = 0;
 
     // Define the pointers for the subsetting.
-    std::unique_ptr<Optical_props_arry> optical_props_subset =
-            std::make_unique<Optical_props_2str>(n_col_block, n_lay, *kdist_sw);
-    std::unique_ptr<Optical_props_2str> cloud_optical_props_subset =
-            std::make_unique<Optical_props_2str>(n_col_block, n_lay, *cloud_sw);
-    std::unique_ptr<Optical_props_2str> aerosol_optical_props_subset;
-    if (sw_aerosol)
-    {
-        aerosol_optical_props_subset = std::make_unique<Optical_props_2str>(n_col_block, n_lay, *aerosol_sw);
-    }
-
-
     std::unique_ptr<Optical_props_arry> optical_props_left =
             std::make_unique<Optical_props_2str>(n_col_block_left, n_lay, *kdist_sw);
     std::unique_ptr<Optical_props_2str> cloud_optical_props_left =
@@ -2735,31 +3777,45 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
             }
     };
 
-    for (int b=1; b<=n_blocks; ++b)
+    // The blocks are independent, each thread solves its blocks with its own optical properties.
+    #pragma omp parallel if(n_blocks > 1)
     {
-        const int col_s = (b-1) * n_col_block + 1;
-        const int col_e =  b    * n_col_block;
-
-        Array<Float,1> mu0_subset = mu0.subset({{ {col_s, col_e} }});
-        Array<Float,2> toa_src_subset = sw_flux_dn_dir_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
-        Array<Float,2> sfc_alb_dir_subset = sfc_alb_dir.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<Float,2> sfc_alb_dif_subset = sfc_alb_dif.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<Float,2> sw_flux_dn_dif_inc_subset = sw_flux_dn_dif_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
-
+        std::unique_ptr<Optical_props_arry> optical_props_subset =
+                std::make_unique<Optical_props_2str>(n_col_block, n_lay, *kdist_sw);
+        std::unique_ptr<Optical_props_2str> cloud_optical_props_subset =
+                std::make_unique<Optical_props_2str>(n_col_block, n_lay, *cloud_sw);
+        std::unique_ptr<Optical_props_2str> aerosol_optical_props_subset;
+        if (sw_aerosol)
+        {
+            aerosol_optical_props_subset = std::make_unique<Optical_props_2str>(n_col_block, n_lay, *aerosol_sw);
+        }
         std::unique_ptr<Fluxes_broadband> fluxes_subset =
                 std::make_unique<Fluxes_broadband>(n_col_block, n_lev);
 
-        call_kernels(
-                col_s, col_e,
-                optical_props_subset,
-                cloud_optical_props_subset,
-                aerosol_optical_props_subset,
-                mu0_subset,
-                toa_src_subset,
-                sfc_alb_dir_subset,
-                sfc_alb_dif_subset,
-                sw_flux_dn_dif_inc_subset,
-                fluxes_subset);
+        #pragma omp for schedule(dynamic)
+        for (int b=1; b<=n_blocks; ++b)
+        {
+            const int col_s = (b-1) * n_col_block + 1;
+            const int col_e =  b    * n_col_block;
+
+            Array<Float,1> mu0_subset = mu0.subset({{ {col_s, col_e} }});
+            Array<Float,2> toa_src_subset = sw_flux_dn_dir_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
+            Array<Float,2> sfc_alb_dir_subset = sfc_alb_dir.subset({{ {1, n_bnd}, {col_s, col_e} }});
+            Array<Float,2> sfc_alb_dif_subset = sfc_alb_dif.subset({{ {1, n_bnd}, {col_s, col_e} }});
+            Array<Float,2> sw_flux_dn_dif_inc_subset = sw_flux_dn_dif_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
+
+            call_kernels(
+                    col_s, col_e,
+                    optical_props_subset,
+                    cloud_optical_props_subset,
+                    aerosol_optical_props_subset,
+                    mu0_subset,
+                    toa_src_subset,
+                    sfc_alb_dir_subset,
+                    sfc_alb_dif_subset,
+                    sw_flux_dn_dif_inc_subset,
+                    fluxes_subset);
+        }
     }
 
     if (n_col_block_left > 0)
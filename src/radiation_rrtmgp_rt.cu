@@ -964,6 +964,40 @@ namespace
         Memory_pool_gpu::init_instance(pool_queues);
         #endif
     }
+
+    // Distribute the ray budget of all g-points proportional to their incoming flux at the top of the domain.
+    // The noise of the ray tracer scales with the incoming flux over the square root of the number of rays,
+    // so this minimizes the total variance of the summed fluxes for the same number of rays. The counts are
+    // rounded down to a power of two and bounded below by `rays_min`.
+    std::vector<Int> distribute_rays_over_gpoints(
+            const Array<Float,2>& flux_dn_dir_inc, const Array<Float,2>& flux_dn_dif_inc,
+            const Float mu0, const Int rays_per_pixel, const Int rays_min, const int n_gpt)
+    {
+        std::vector<Float> flux_inc(n_gpt);
+        Float flux_inc_sum = Float(0.);
+        for (int igpt=1; igpt<=n_gpt; ++igpt)
+        {
+            flux_inc[igpt-1] = flux_dn_dir_inc({1, igpt})*mu0 + flux_dn_dif_inc({1, igpt});
+            flux_inc_sum += flux_inc[igpt-1];
+        }
+
+        std::vector<Int> rays(n_gpt, rays_per_pixel);
+        if (flux_inc_sum <= Float(0.))
+            return rays;
+
+        for (int n=0; n<n_gpt; ++n)
+        {
+            const Float rays_target = Float(rays_per_pixel) * Float(n_gpt) * flux_inc[n] / flux_inc_sum;
+
+            Int rays_pow2 = 1;
+            while (Float(2*rays_pow2) <= rays_target)
+                rays_pow2 *= 2;
+
+            rays[n] = std::max(rays_pow2, rays_min);
+        }
+
+        return rays;
+    }
 }
 
 #ifdef USECUDA
@@ -1665,6 +1699,13 @@ void Radiation_rrtmgp_rt<TF>::exec_shortwave_rt(
                 four_third_pi_N0_rho_w, four_third_pi_N0_rho_i, fac);
     }
 
+    // Number of rays per pixel for each g-point.
+    const std::vector<Int> rays_per_pixel_gpt = sw_adaptive_rays ?
+            distribute_rays_over_gpoints(
+                    sw_flux_dn_dir_inc, sw_flux_dn_dif_inc, this->mu0,
+                    this->rays_per_pixel, this->rays_per_pixel_min, n_gpt) :
+            std::vector<Int>(n_gpt, this->rays_per_pixel);
+
     // main g-point loop
     const Array<int, 2>& band_limits_gpt(this->kdist_sw_rt->get_band_lims_gpoint());
     for (int igpt=1; igpt<=n_gpt; ++igpt)
@@ -1820,7 +1861,7 @@ void Radiation_rrtmgp_rt<TF>::exec_shortwave_rt(
             const Int qrng_offset = Int(igpt - 1) + this->time_idx * Int(n_gpt);
             raytracer.trace_rays(
                     igpt,
-                    this->rays_per_pixel,
+                    rays_per_pixel_gpt[igpt-1],
                     grid_cells, grid_d, kn_grid,
                     mie_cdfs_sub,
                     mie_angs_sub,
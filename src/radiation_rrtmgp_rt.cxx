@@ -519,6 +519,11 @@ Radiation_rrtmgp_rt<TF>::Radiation_rrtmgp_rt(
     sfc_alb_dif_hom = inputin.get_item<Float>("radiation", "sfc_alb_dif", "");
 
     rays_per_pixel = inputin.get_item<Float>("radiation", "rays_per_pixel", "");
+
+    // Distribute the rays over the g-points according to their incoming flux, with rays_per_pixel as mean.
+    sw_adaptive_rays = inputin.get_item<bool>("radiation", "swadaptiverays", "", false);
+    if (sw_adaptive_rays)
+        rays_per_pixel_min = inputin.get_item<Float>("radiation", "rays_per_pixel_min", "", std::max(rays_per_pixel/4, Int(1)));
     kngrid_i = inputin.get_item<Float>("radiation", "kngrid_i", "");
     kngrid_j = inputin.get_item<Float>("radiation", "kngrid_j", "");
     kngrid_k = inputin.get_item<Float>("radiation", "kngrid_k", "");
@@ -645,6 +650,11 @@ void Radiation_rrtmgp_rt<TF>::create(
             throw std::runtime_error("Radiation_rrtmgp_rt requires an equidistant vertical grid.");
     }
 
+    // The ray tracer treats the domain of each process as cyclic, photons that leave a subdomain
+    // are not passed to the neighbouring process. Only a single process gives the right fluxes.
+    if (master.get_MPI_data().nprocs > 1)
+        throw std::runtime_error("Radiation_rrtmgp_rt does not (yet) support more than one MPI process.");
+
     // Setup timedependent gasses
     const TF offset = 0;
     std::string timedep_dim = "time_rad";
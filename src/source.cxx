@@ -65,9 +65,11 @@ namespace
         return range;
     }
 
+    // Precompute the normalized spatial weights of a source, stored only on the cells within
+    // its range. The shape only changes with the location, so exec() only has to scale these.
     template<typename TF, bool use_profile>
-    void calc_source(
-            TF* const __restrict__ st,
+    void calc_source_weights(
+            std::vector<int>& ijk_source, std::vector<TF>& weight,
             const TF* const restrict x,
             const TF* const restrict y,
             const TF* const restrict z,
@@ -75,12 +77,15 @@ namespace
             const TF x0, const TF sigma_x, const TF line_x,
             const TF y0, const TF sigma_y, const TF line_y,
             const TF z0, const TF sigma_z, const TF line_z,
-            const TF strength, const TF norm,
+            const TF norm,
             const int istart, const int iend,
             const int jstart, const int jend,
             const int kstart, const int kend,
             const int icells, const int ijcells)
     {
+        ijk_source.clear();
+        weight.clear();
+
         if (iend == istart || jend == jstart || kend == kstart)
             return;
 
@@ -89,75 +94,91 @@ namespace
                 for(int i = istart; i<iend; ++i)
                 {
                     const int ijk = i + j*icells + k*ijcells;
+                    TF blob;
 
                     if (line_x != 0)
                     {
                         if (x[i] >= x0+line_x)
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y)
                                     - fm::pow2(z[k]-z0-line_z)/fm::pow2(sigma_z));
                         else if (x[i] <= x0)
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0)       /fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y)
                                     - fm::pow2(z[k]-z0-line_z)/fm::pow2(sigma_z));
                         else
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y)
                                     - fm::pow2(z[k]-z0-line_z)/fm::pow2(sigma_z));
                     }
                     else if (line_y != 0)
                     {
                         if (y[j] >= y0+line_y)
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y)
                                     - fm::pow2(z[k]-z0-line_z)/fm::pow2(sigma_z));
                         else if (y[j] <= y0)
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0)       /fm::pow2(sigma_y)
                                     - fm::pow2(z[k]-z0-line_z)/fm::pow2(sigma_z));
                         else
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(z[k]-z0-line_z)/fm::pow2(sigma_z));
                     }
                     else if (line_z != 0)
                     {
                         if (z[k] >= z0+line_z)
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y)
                                     - fm::pow2(z[k]-z0-line_z)/fm::pow2(sigma_z));
                         else if (z[k] <= z0)
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y)
                                     - fm::pow2(z[k]-z0)       /fm::pow2(sigma_z));
                         else
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y));
                     }
                     else
                     {
                         if (use_profile)
-                            st[ijk] += strength/norm*(exp(
+                            blob = (exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y))
                                     * emission_profile[k]);
                         else
-                            st[ijk] += strength/norm*exp(
+                            blob = exp(
                                     - fm::pow2(x[i]-x0-line_x)/fm::pow2(sigma_x)
                                     - fm::pow2(y[j]-y0-line_y)/fm::pow2(sigma_y)
                                     - fm::pow2(z[k]-z0-line_z)/fm::pow2(sigma_z));
                     }
+
+                    ijk_source.push_back(ijk);
+                    weight.push_back(blob/norm);
                 }
-        }
+    }
+
+    template<typename TF>
+    void add_source(
+            TF* const restrict st,
+            const int* const restrict ijk_source, const TF* const restrict weight,
+            const TF strength, const int n_cells)
+    {
+        #pragma ivdep
+        for (int n=0; n<n_cells; ++n)
+            st[ijk_source[n]] += strength*weight[n];
+    }
 }
 
+
 // Constructor: read values from ini file that do not need info from other classes
 template<typename TF>
 Source<TF>::Source(Master& master, Grid<TF>& grid, Fields<TF>& fields, Input& input) :
@@ -297,6 +318,8 @@ void Source<TF>::create(Input& input, Netcdf_handle& input_nc)
                     nullptr,
                     shape[n].range_x, shape[n].range_y, shape[n].range_z,
                     fields.rhoref.data(), sw_vmr[n], false);
+
+        calc_weights(n);
     }
 
     // Create timedep
@@ -371,6 +394,8 @@ void Source<TF>::exec(Timeloop<TF>& timeloop)
                         nullptr,
                         shape[n].range_x, shape[n].range_y, shape[n].range_z,
                         fields.rhoref.data(), sw_vmr[n], false);
+
+            calc_weights(n);
         }
     }
 
@@ -385,37 +410,46 @@ void Source<TF>::exec(Timeloop<TF>& timeloop)
     }
 
     for (int n=0; n<sourcelist.size(); ++n)
-    {
-        if (sw_emission_profile)
-            calc_source<TF, true>(
-                    fields.st[sourcelist[n]]->fld.data(),
-                    gd.x.data(), gd.y.data(), gd.z.data(),
-                    profile_z.at(profile_index[n]).data(),
-                    source_x0[n], sigma_x[n], line_x[n],
-                    source_y0[n], sigma_y[n], line_y[n],
-                    source_z0[n], sigma_z[n], line_z[n],
-                    strength[n], norm[n],
-                    shape[n].range_x[0], shape[n].range_x[1],
-                    shape[n].range_y[0], shape[n].range_y[1],
-                    shape[n].range_z[0], shape[n].range_z[1],
-                    gd.icells, gd.ijcells);
-        else
-            calc_source<TF, false>(
-                    fields.st[sourcelist[n]]->fld.data(),
-                    gd.x.data(), gd.y.data(), gd.z.data(),
-                    nullptr,
-                    source_x0[n], sigma_x[n], line_x[n],
-                    source_y0[n], sigma_y[n], line_y[n],
-                    source_z0[n], sigma_z[n], line_z[n],
-                    strength[n], norm[n],
-                    shape[n].range_x[0], shape[n].range_x[1],
-                    shape[n].range_y[0], shape[n].range_y[1],
-                    shape[n].range_z[0], shape[n].range_z[1],
-                    gd.icells, gd.ijcells);
-    }
+        add_source(
+                fields.st[sourcelist[n]]->fld.data(),
+                shape[n].ijk.data(), shape[n].weight.data(),
+                strength[n], shape[n].ijk.size());
 }
 #endif
 
+template<typename TF>
+void Source<TF>::calc_weights(const int n)
+{
+    auto& gd = grid.get_grid_data();
+
+    if (sw_emission_profile)
+        calc_source_weights<TF, true>(
+                shape[n].ijk, shape[n].weight,
+                gd.x.data(), gd.y.data(), gd.z.data(),
+                profile_z.at(profile_index[n]).data(),
+                source_x0[n], sigma_x[n], line_x[n],
+                source_y0[n], sigma_y[n], line_y[n],
+                source_z0[n], sigma_z[n], line_z[n],
+                norm[n],
+                shape[n].range_x[0], shape[n].range_x[1],
+                shape[n].range_y[0], shape[n].range_y[1],
+                shape[n].range_z[0], shape[n].range_z[1],
+                gd.icells, gd.ijcells);
+    else
+        calc_source_weights<TF, false>(
+                shape[n].ijk, shape[n].weight,
+                gd.x.data(), gd.y.data(), gd.z.data(),
+                nullptr,
+                source_x0[n], sigma_x[n], line_x[n],
+                source_y0[n], sigma_y[n], line_y[n],
+                source_z0[n], sigma_z[n], line_z[n],
+                norm[n],
+                shape[n].range_x[0], shape[n].range_x[1],
+                shape[n].range_y[0], shape[n].range_y[1],
+                shape[n].range_z[0], shape[n].range_z[1],
+                gd.icells, gd.ijcells);
+}
+
 template<typename TF>
 TF Source<TF>::calc_norm(
         const TF* const restrict x, const TF x0, const TF sigma_x, const TF line_x,
@@ -0,0 +1,212 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "fft.h"
+#include "stats.h"
+#include "spectra.h"
+#include "netcdf_interface.h"
+
+namespace
+{
+    // The FFTs are real-to-halfcomplex, index n holds the real part of wave number n for n <= N/2
+    // and the imaginary part of wave number N-n otherwise. Except for the mean and the Nyquist
+    // frequency, each coefficient represents a pair of wave numbers and counts twice.
+    inline int get_wave_number(const int n, const int ntot)
+    {
+        return (n <= ntot/2) ? n : ntot-n;
+    }
+
+    inline int get_weight(const int n, const int ntot)
+    {
+        return (n == 0 || 2*n == ntot) ? 1 : 2;
+    }
+}
+
+template<typename TF>
+Spectra<TF>::Spectra(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, FFT<TF>& fftin, Input& inputin) :
+    master(masterin), grid(gridin), fields(fieldsin), fft(fftin)
+{
+    swspectra = inputin.get_item<bool>("spectra", "swspectra", "", false);
+
+    if (swspectra)
+    {
+        spectralist = inputin.get_list<std::string>("spectra", "spectralist", "", std::vector<std::string>());
+        heights = inputin.get_list<TF>("spectra", "heights", "", std::vector<TF>());
+
+        if (spectralist.empty() || heights.empty())
+            throw std::runtime_error("Spectra need a non-empty [spectra][spectralist] and [spectra][heights]");
+    }
+}
+
+template<typename TF>
+Spectra<TF>::~Spectra()
+{
+}
+
+template<typename TF>
+void Spectra<TF>::create(Stats<TF>& stats)
+{
+    if (!swspectra || !stats.get_switch())
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    for (auto& name : spectralist)
+        if (!fields.ap.count(name))
+            throw std::runtime_error("Spectrum of \"" + name + "\" is not possible, only prognostic fields are supported");
+
+    // Take the full level closest to each height.
+    std::vector<TF> zspec;
+    for (const TF height : heights)
+    {
+        int k_min = 0;
+        for (int k=0; k<gd.kmax; ++k)
+            if (std::abs(gd.z[k+gd.kstart] - height) < std::abs(gd.z[k_min+gd.kstart] - height))
+                k_min = k;
+
+        kspec.push_back(k_min);
+        zspec.push_back(gd.z[k_min+gd.kstart]);
+    }
+
+    const int nkx = gd.itot/2+1;
+    const int nky = gd.jtot/2+1;
+
+    stats.add_dimension("zspec", kspec.size());
+    stats.add_dimension("kx", nkx);
+    stats.add_dimension("ky", nky);
+
+    std::vector<TF> kx(nkx), ky(nky);
+    for (int i=0; i<nkx; ++i)
+        kx[i] = TF(2.*M_PI) * i / gd.xsize;
+    for (int j=0; j<nky; ++j)
+        ky[j] = TF(2.*M_PI) * j / gd.ysize;
+
+    stats.add_fixed_prof_raw("zspec", "Height of the spectra", "m", "zspec", "spectra", zspec);
+    stats.add_fixed_prof_raw("kx", "Wave number in x-direction", "rad m-1", "kx", "spectra", kx);
+    stats.add_fixed_prof_raw("ky", "Wave number in y-direction", "rad m-1", "ky", "spectra", ky);
+
+    for (auto& name : spectralist)
+    {
+        const std::string unit = "(" + fields.ap.at(name)->unit + ")2";
+        stats.add_spectrum(name + "_spec_x", "Spectrum of " + fields.ap.at(name)->longname + " in x-direction",
+                unit, "zspec", "kx", "spectra");
+        stats.add_spectrum(name + "_spec_y", "Spectrum of " + fields.ap.at(name)->longname + " in y-direction",
+                unit, "zspec", "ky", "spectra");
+    }
+}
+
+template<typename TF>
+void Spectra<TF>::calc_spectra(std::vector<TF>& spec_x, std::vector<TF>& spec_y, const std::string& name)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    auto tmp1 = fields.get_tmp();
+    auto tmp2 = fields.get_tmp();
+
+    TF* const restrict data = tmp1->fld.data();
+    const TF* const restrict fld = fields.ap.at(name)->fld.data();
+
+    // Pack the interior in the layout of the pressure solver and transform all levels at once.
+    const int jjb = gd.imax;
+    const int kkb = gd.imax*gd.jmax;
+
+    for (int k=0; k<gd.kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.istart + (j+gd.jstart)*gd.icells + (k+gd.kstart)*gd.ijcells;
+                const int ijkb = i + j*jjb + k*kkb;
+                data[ijkb] = fld[ijk];
+            }
+
+    fft.exec_forward(data, tmp2->fld.data());
+
+    // Sum the power of the coefficients of this process per wave number, normalized such that
+    // the sum over all wave numbers is the mean square of the level.
+    const int nkx = gd.itot/2+1;
+    const int nky = gd.jtot/2+1;
+    const int nz = kspec.size();
+
+    spec_x.assign(nz*nkx, TF(0.));
+    spec_y.assign(nz*nky, TF(0.));
+
+    const TF norm = TF(1.) / (TF(gd.itot)*gd.jtot*TF(gd.itot)*gd.jtot);
+    const int jj = gd.iblock;
+    const int kk = gd.iblock*gd.jblock;
+
+    for (int n=0; n<nz; ++n)
+    {
+        const int k = kspec[n];
+        for (int j=0; j<gd.jblock; ++j)
+            for (int i=0; i<gd.iblock; ++i)
+            {
+                // The transposes of the FFT swap the process coordinates.
+                const int iindex = md.mpicoordy*gd.iblock + i;
+                const int jindex = md.mpicoordx*gd.jblock + j;
+
+                const TF a = data[i + j*jj + k*kk];
+                const TF power = norm * a*a
+                    * get_weight(get_wave_number(iindex, gd.itot), gd.itot)
+                    * get_weight(get_wave_number(jindex, gd.jtot), gd.jtot);
+
+                spec_x[n*nkx + get_wave_number(iindex, gd.itot)] += power;
+                spec_y[n*nky + get_wave_number(jindex, gd.jtot)] += power;
+            }
+    }
+
+    master.sum(spec_x.data(), spec_x.size());
+    master.sum(spec_y.data(), spec_y.size());
+
+    fields.release_tmp(tmp1);
+    fields.release_tmp(tmp2);
+}
+
+template<typename TF>
+void Spectra<TF>::exec_stats(Stats<TF>& stats)
+{
+    if (!swspectra || !stats.get_switch())
+        return;
+
+    std::vector<TF> spec_x, spec_y;
+
+    for (auto& name : spectralist)
+    {
+        calc_spectra(spec_x, spec_y, name);
+        stats.set_spectrum(name + "_spec_x", spec_x);
+        stats.set_spectrum(name + "_spec_y", spec_y);
+    }
+}
+
+#ifdef FLOAT_SINGLE
+template class Spectra<float>;
+#else
+template class Spectra<double>;
+#endif
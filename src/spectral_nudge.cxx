@@ -0,0 +1,233 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "field3d.h"
+#include "fft.h"
+#include "input.h"
+#include "timeloop.h"
+#include "spectral_nudge.h"
+
+namespace
+{
+    // The FFTs are real-to-halfcomplex, index n holds the real part of wave number n for n <= N/2
+    // and the imaginary part of wave number N-n otherwise.
+    inline int get_wave_number(const int n, const int ntot)
+    {
+        return (n <= ntot/2) ? n : ntot-n;
+    }
+}
+
+template<typename TF>
+Spectral_nudge<TF>::Spectral_nudge(
+        Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, FFT<TF>& fftin, Input& inputin) :
+    master(masterin), grid(gridin), fields(fieldsin), fft(fftin), field3d_io(masterin, gridin)
+{
+    swspectralnudge = inputin.get_item<bool>("spectralnudge", "swspectralnudge", "", false);
+    has_tendency = false;
+
+    if (swspectralnudge)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("swspectralnudge is not implemented on the GPU");
+        #endif
+
+        nudgelist = inputin.get_list<std::string>("spectralnudge", "nudgelist", "", std::vector<std::string>());
+        nwavex = inputin.get_item<int>("spectralnudge", "nwavex", "");
+        nwavey = inputin.get_item<int>("spectralnudge", "nwavey", "");
+        tau = inputin.get_item<TF>("spectralnudge", "tau", "");
+        zmin = inputin.get_item<TF>("spectralnudge", "zmin", "", 0.);
+        interval = inputin.get_item<int>("spectralnudge", "interval", "", 10);
+
+        if (nudgelist.empty())
+            throw std::runtime_error("Empty nudgelist in [spectralnudge]");
+
+        if (nwavex < 0 || nwavey < 0 || tau <= 0 || interval < 1)
+            throw std::runtime_error("Spectral nudging needs nwavex, nwavey >= 0, tau > 0 and interval >= 1");
+    }
+}
+
+template<typename TF>
+Spectral_nudge<TF>::~Spectral_nudge()
+{
+}
+
+template<typename TF>
+void Spectral_nudge<TF>::create()
+{
+    if (!swspectralnudge)
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    auto tmp1 = fields.get_tmp();
+    auto tmp2 = fields.get_tmp();
+
+    int nerror = 0;
+    for (auto& name : nudgelist)
+    {
+        if (!fields.ap.count(name))
+            throw std::runtime_error("Spectral nudging of \"" + name + "\" is not possible, only prognostic fields are supported");
+
+        targets[name].assign(gd.ncells, TF(0.));
+        tendencies[name].assign(gd.ncells, TF(0.));
+
+        char filename[256];
+        std::snprintf(filename, 256, "%s_nudge.%07d", name.c_str(), 0);
+        master.print_message("Loading \"%s\" ... ", filename);
+
+        if (field3d_io.load_field3d(
+                    targets[name].data(),
+                    tmp1->fld.data(), tmp2->fld.data(),
+                    filename, TF(0.),
+                    gd.kstart, gd.kend))
+        {
+            master.print_message("FAILED\n");
+            ++nerror;
+        }
+        else
+            master.print_message("OK\n");
+    }
+
+    fields.release_tmp(tmp1);
+    fields.release_tmp(tmp2);
+
+    master.sum(&nerror, 1);
+    if (nerror)
+        throw std::runtime_error("Error loading the targets of the spectral nudging");
+}
+
+template<typename TF>
+void Spectral_nudge<TF>::calc_tendency(std::vector<TF>& tend, const std::string& name)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    auto tmp1 = fields.get_tmp();
+    auto tmp2 = fields.get_tmp();
+
+    TF* const restrict data = tmp1->fld.data();
+    const TF* const restrict fld = fields.ap.at(name)->fld.data();
+    const TF* const restrict target = targets.at(name).data();
+
+    // Pack the deviation from the target in the layout of the pressure solver.
+    const int jjb = gd.imax;
+    const int kkb = gd.imax*gd.jmax;
+
+    #pragma omp parallel for
+    for (int k=0; k<gd.kmax; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.istart + (j+gd.jstart)*gd.icells + (k+gd.kstart)*gd.ijcells;
+                const int ijkb = i + j*jjb + k*kkb;
+                data[ijkb] = fld[ijk] - target[ijk];
+            }
+
+    fft.exec_forward(data, tmp2->fld.data());
+
+    // Remove the small scales. The transposes of the FFT swap the process coordinates.
+    const int jj = gd.iblock;
+    const int kk = gd.iblock*gd.jblock;
+
+    #pragma omp parallel for
+    for (int k=0; k<gd.kmax; ++k)
+        for (int j=0; j<gd.jblock; ++j)
+            for (int i=0; i<gd.iblock; ++i)
+            {
+                const int iindex = md.mpicoordy*gd.iblock + i;
+                const int jindex = md.mpicoordx*gd.jblock + j;
+
+                if (get_wave_number(iindex, gd.itot) > nwavex || get_wave_number(jindex, gd.jtot) > nwavey)
+                    data[i + j*jj + k*kk] = TF(0.);
+            }
+
+    fft.exec_backward(data, tmp2->fld.data());
+
+    // The FFTs are unnormalized, which is included in the relaxation factor.
+    const TF factor = TF(-1.) / (tau * gd.itot * gd.jtot);
+    const std::vector<TF>& z = (fields.ap.at(name)->loc[2] == 1) ? gd.zh : gd.z;
+
+    #pragma omp parallel for
+    for (int k=0; k<gd.kmax; ++k)
+    {
+        const TF fac = (z[k+gd.kstart] < zmin) ? TF(0.) : factor;
+        for (int j=0; j<gd.jmax; ++j)
+            #pragma ivdep
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int ijk  = i+gd.istart + (j+gd.jstart)*gd.icells + (k+gd.kstart)*gd.ijcells;
+                const int ijkb = i + j*jjb + k*kkb;
+                tend[ijk] = fac * data[ijkb];
+            }
+    }
+
+    fields.release_tmp(tmp1);
+    fields.release_tmp(tmp2);
+}
+
+template<typename TF>
+void Spectral_nudge<TF>::exec(Timeloop<TF>& timeloop)
+{
+    if (!swspectralnudge)
+        return;
+
+    // Update the tendencies at the start of every interval-th iteration only.
+    if (!has_tendency || (timeloop.get_substep() == 0 && timeloop.get_iteration() % interval == 0))
+    {
+        for (auto& name : nudgelist)
+            calc_tendency(tendencies.at(name), name);
+        has_tendency = true;
+    }
+
+    auto& gd = grid.get_grid_data();
+
+    for (auto& name : nudgelist)
+    {
+        TF* const restrict tend = fields.at.at(name)->fld.data();
+        const TF* const restrict nudge = tendencies.at(name).data();
+
+        #pragma omp parallel for
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                #pragma ivdep
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*gd.icells + k*gd.ijcells;
+                    tend[ijk] += nudge[ijk];
+                }
+    }
+}
+
+#ifdef FLOAT_SINGLE
+template class Spectral_nudge<float>;
+#else
+template class Spectral_nudge<double>;
+#endif
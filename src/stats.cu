@@ -0,0 +1,400 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include <map>
+#include <memory>
+
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "stats.h"
+#include "grid_kernels.cuh"
+#include "tools.h"
+#include "netcdf_interface.h"
+
+namespace
+{
+    template<typename TF> __global__
+    void calc_masked_field_g(
+            TF* const __restrict__ tmp, const TF* const __restrict__ fld,
+            const unsigned int* const __restrict__ mask, const unsigned int flag,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
+        const int k = blockIdx.z + kstart;
+
+        if (i < iend && j < jend && k < kend)
+        {
+            const int ijk = i + j*icells + k*ijcells;
+            tmp[ijk] = ((mask[ijk] & flag) != 0) ? fld[ijk] : TF(0.);
+        }
+    }
+
+    template<typename TF> __global__
+    void calc_masked_moment_g(
+            TF* const __restrict__ tmp, const TF* const __restrict__ fld,
+            const TF* const __restrict__ fld_mean, const TF offset,
+            const unsigned int* const __restrict__ mask, const unsigned int flag, const int power,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
+        const int k = blockIdx.z + kstart;
+
+        if (i < iend && j < jend && k < kend)
+        {
+            const int ijk = i + j*icells + k*ijcells;
+            const TF fld_prime = fld[ijk] - fld_mean[k] + offset;
+
+            TF value = fld_prime;
+            for (int n=1; n<power; ++n)
+                value *= fld_prime;
+
+            tmp[ijk] = ((mask[ijk] & flag) != 0) ? value : TF(0.);
+        }
+    }
+
+    // Masked sums over the rows in x of the covariance of fld1 and fld2, of which fld1 is interpolated
+    // to the location of fld2 on the fly, with one block per row. The rows are stored as [k][j].
+    template<typename TF> __global__
+    void calc_masked_cov_rows_g(
+            TF* const __restrict__ rows,
+            const TF* const __restrict__ fld1, const TF* const __restrict__ mean1, const TF offset1, const int pow1,
+            const TF* const __restrict__ fld2, const TF* const __restrict__ mean2, const TF offset2, const int pow2,
+            const unsigned int* const __restrict__ mask, const unsigned int flag,
+            const int interp_order, const int iih, const int jjh, const int kkh,
+            const int istart, const int iend, const int jstart, const int kstart,
+            const int kcells, const int icells, const int ijcells)
+    {
+        extern __shared__ unsigned char as_tmp[];
+        TF* as = reinterpret_cast<TF*>(as_tmp);
+
+        const int tid = threadIdx.x;
+        const int j = blockIdx.y + jstart;
+        const int k = blockIdx.z + kstart;
+
+        TF sum = TF(0.);
+
+        for (int i=istart+tid; i<iend; i+=blockDim.x)
+        {
+            const int ijk = i + j*icells + k*ijcells;
+
+            if ((mask[ijk] & flag) == 0)
+                continue;
+
+            TF a;
+            if (interp_order == 2)
+                a = Grid_kernels::interp_2nd(fld1, ijk, iih, jjh, kkh, k == 0, k == kcells-1);
+            else if (interp_order == 4)
+                a = Grid_kernels::interp_4th(fld1, ijk, iih, jjh);
+            else
+                a = fld1[ijk];
+
+            const TF a_prime = a - mean1[k] + offset1;
+            const TF b_prime = fld2[ijk] - mean2[k] + offset2;
+
+            TF value_a = a_prime;
+            for (int n=1; n<pow1; ++n)
+                value_a *= a_prime;
+
+            TF value_b = b_prime;
+            for (int n=1; n<pow2; ++n)
+                value_b *= b_prime;
+
+            sum += value_a * value_b;
+        }
+
+        as[tid] = sum;
+        __syncthreads();
+
+        for (int s=blockDim.x/2; s>0; s>>=1)
+        {
+            if (tid < s)
+                as[tid] += as[tid+s];
+            __syncthreads();
+        }
+
+        if (tid == 0)
+            rows[blockIdx.y + blockIdx.z*gridDim.y] = as[0];
+    }
+
+    template<typename TF> __device__
+    int get_bin_g(const TF value, const TF min, const TF fac, const int nbins)
+    {
+        const TF x = (value - min) * fac;
+        if (x < TF(0.))
+            return 0;
+        else if (x >= nbins)
+            return nbins-1;
+        else
+            return static_cast<int>(x);
+    }
+
+    template<typename TF> __device__
+    TF interp_to_centre_g(
+            const TF* const __restrict__ fld, const int ijk,
+            const int di, const int dj, const int dk, const int icells, const int ijcells)
+    {
+        TF sum = TF(0.);
+        for (int k=0; k<=dk; ++k)
+            for (int j=0; j<=dj; ++j)
+                for (int i=0; i<=di; ++i)
+                    sum += fld[ijk + i + j*icells + k*ijcells];
+
+        return sum / ((1+di) * (1+dj) * (1+dk));
+    }
+
+    // Counts of the masked points per level and bin. Without fld_b the counts are of fld_a at its own
+    // location, with fld_b they are joint counts of both fields, interpolated to the cell centre.
+    template<typename TF> __global__
+    void calc_hist_g(
+            TF* const __restrict__ hist,
+            const TF* const __restrict__ fld_a, const TF offset_a, const TF min_a, const TF fac_a,
+            const int di_a, const int dj_a, const int dk_a,
+            const TF* const __restrict__ fld_b, const TF min_b, const TF fac_b,
+            const int di_b, const int dj_b, const int dk_b,
+            const int nbins,
+            const unsigned int* const __restrict__ mask, const unsigned int flag,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
+        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
+        const int k = blockIdx.z + kstart;
+
+        if (i < iend && j < jend && k < kend)
+        {
+            const int ijk = i + j*icells + k*ijcells;
+
+            if ((mask[ijk] & flag) == 0)
+                return;
+
+            const TF a = interp_to_centre_g(fld_a, ijk, di_a, dj_a, dk_a, icells, ijcells) + offset_a;
+            const int n_a = get_bin_g(a, min_a, fac_a, nbins);
+
+            if (fld_b == nullptr)
+                atomicAdd(&hist[(k-kstart)*nbins + n_a], TF(1.));
+            else
+            {
+                const TF b = interp_to_centre_g(fld_b, ijk, di_b, dj_b, dk_b, icells, ijcells);
+                const int n_b = get_bin_g(b, min_b, fac_b, nbins);
+                atomicAdd(&hist[((k-kstart)*nbins + n_a)*nbins + n_b], TF(1.));
+            }
+        }
+    }
+}
+
+#ifdef USECUDA
+template<typename TF>
+void Stats<TF>::prepare_device()
+{
+    if (!swstats)
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    mfield_g.allocate(gd.ncells);
+    prof_g.allocate(gd.kcells);
+    mean_g.allocate(gd.kcells);
+    mean2_g.allocate(gd.kcells);
+    prof_tmp.resize(gd.kcells);
+
+    if (!hist_bins.empty())
+        hist_g.allocate(gd.kcells*nhistbins*(joint_histlist.empty() ? 1 : nhistbins));
+}
+
+template<typename TF>
+void Stats<TF>::clear_device()
+{
+    mfield_g.free();
+    prof_g.free();
+    mean_g.free();
+    mean2_g.free();
+    hist_g.free();
+}
+
+template<typename TF>
+void Stats<TF>::upload_masks_g()
+{
+    cuda_copy(mfield, mfield_g);
+}
+
+template<typename TF>
+void Stats<TF>::calc_masked_sum_g(
+        TF* const prof, const Field3d<TF>& fld, const TF* const fld_mean, const TF offset,
+        const unsigned int flag, const int power, const int kstart, const int kend)
+{
+    using namespace Tools_g;
+
+    auto& gd = grid.get_grid_data();
+    const int nk = kend - kstart;
+
+    const int blocki = gd.ithread_block;
+    const int blockj = gd.jthread_block;
+    const int gridi  = gd.imax/blocki + (gd.imax%blocki > 0);
+    const int gridj  = gd.jmax/blockj + (gd.jmax%blockj > 0);
+
+    dim3 gridGPU (gridi, gridj, nk);
+    dim3 blockGPU(blocki, blockj, 1);
+
+    auto tmp  = fields.get_tmp_g();
+    auto tmp2 = fields.get_tmp_g();
+
+    // Store the masked (and raised to the power) values in a temporary field.
+    if (fld_mean == nullptr)
+        calc_masked_field_g<<<gridGPU, blockGPU>>>(
+                tmp->fld_g, fld.fld_g, mfield_g, flag,
+                gd.istart, gd.iend, gd.jstart, gd.jend, kstart, kend,
+                gd.icells, gd.ijcells);
+    else
+    {
+        cuda_safe_call(cudaMemcpy(mean_g, fld_mean, gd.kcells*sizeof(TF), cudaMemcpyHostToDevice));
+
+        calc_masked_moment_g<<<gridGPU, blockGPU>>>(
+                tmp->fld_g, fld.fld_g, mean_g, offset, mfield_g, flag, power,
+                gd.istart, gd.iend, gd.jstart, gd.jend, kstart, kend,
+                gd.icells, gd.ijcells);
+    }
+    cuda_check_error();
+
+    // Reduce the interior to jmax*nk values, and those to the nk values of the profile.
+    reduce_interior<TF>(
+            tmp->fld_g, tmp2->fld_g, gd.imax, gd.istart, gd.iend, gd.jmax,
+            gd.jstart, gd.jend, nk, kstart, gd.icells, gd.ijcells, Sum_type);
+
+    reduce_all<TF>(
+            tmp2->fld_g, prof_g, gd.jmax*nk, nk, gd.jmax, Sum_type, TF(1.));
+
+    fields.release_tmp_g(tmp);
+    fields.release_tmp_g(tmp2);
+
+    // Only the local sums of the profile return to the host.
+    cuda_safe_call(cudaMemcpy(&prof[kstart], prof_g, nk*sizeof(TF), cudaMemcpyDeviceToHost));
+}
+
+template<typename TF>
+void Stats<TF>::calc_masked_cov_sum_g(
+        TF* const prof, const Field3d<TF>& fld1, const TF* const fld1_mean, const TF offset1, const int pow1,
+        const Field3d<TF>& fld2, const TF* const fld2_mean, const TF offset2, const int pow2,
+        const unsigned int flag, const int kstart, const int kend)
+{
+    using namespace Tools_g;
+
+    auto& gd = grid.get_grid_data();
+    const int nk = kend - kstart;
+
+    // The interpolation follows Grid::interpolate_2nd/4th, without storing the interpolated field.
+    int interp_order = 0;
+    if (fld1.loc != fld2.loc)
+        interp_order = (grid.get_spatial_order() == Grid_order::Second) ? 2 : 4;
+
+    const int iih = (fld1.loc[0]-fld2.loc[0]);
+    const int jjh = (fld1.loc[1]-fld2.loc[1])*gd.icells;
+    const int kkh = (fld1.loc[2]-fld2.loc[2])*gd.ijcells;
+
+    cuda_safe_call(cudaMemcpy(mean_g, fld1_mean, gd.kcells*sizeof(TF), cudaMemcpyHostToDevice));
+    cuda_safe_call(cudaMemcpy(mean2_g, fld2_mean, gd.kcells*sizeof(TF), cudaMemcpyHostToDevice));
+
+    // A power of two number of threads for the reduction in the block.
+    int nthreads = 32;
+    while (nthreads < gd.imax && nthreads < 256)
+        nthreads *= 2;
+
+    dim3 gridGPU (1, gd.jmax, nk);
+    dim3 blockGPU(nthreads, 1, 1);
+
+    auto rows = fields.get_tmp_g();
+
+    calc_masked_cov_rows_g<TF><<<gridGPU, blockGPU, nthreads*sizeof(TF)>>>(
+            rows->fld_g,
+            fld1.fld_g, mean_g, offset1, pow1,
+            fld2.fld_g, mean2_g, offset2, pow2,
+            mfield_g, flag,
+            interp_order, iih, jjh, kkh,
+            gd.istart, gd.iend, gd.jstart, kstart,
+            gd.kcells, gd.icells, gd.ijcells);
+    cuda_check_error();
+
+    reduce_all<TF>(
+            rows->fld_g, prof_g, gd.jmax*nk, nk, gd.jmax, Sum_type, TF(1.));
+
+    fields.release_tmp_g(rows);
+
+    cuda_safe_call(cudaMemcpy(&prof[kstart], prof_g, nk*sizeof(TF), cudaMemcpyDeviceToHost));
+}
+
+template<typename TF>
+void Stats<TF>::calc_hist_sum_g(
+        TF* const hist, const Field3d<TF>& fld_a, const TF offset_a, const Hist_bins& bins_a,
+        const Field3d<TF>* const fld_b, const Hist_bins* const bins_b,
+        const unsigned int flag, const int kstart, const int kend)
+{
+    auto& gd = grid.get_grid_data();
+    const int nk = kend - kstart;
+    const int size = nk*nhistbins*(fld_b == nullptr ? 1 : nhistbins);
+
+    const int blocki = gd.ithread_block;
+    const int blockj = gd.jthread_block;
+    const int gridi  = gd.imax/blocki + (gd.imax%blocki > 0);
+    const int gridj  = gd.jmax/blockj + (gd.jmax%blockj > 0);
+
+    dim3 gridGPU (gridi, gridj, nk);
+    dim3 blockGPU(blocki, blockj, 1);
+
+    // A single histogram is at the location of the field, a joint one at the cell centre.
+    const bool joint = (fld_b != nullptr);
+
+    cuda_safe_call(cudaMemset(hist_g, 0, size*sizeof(TF)));
+
+    calc_hist_g<<<gridGPU, blockGPU>>>(
+            hist_g.data(),
+            fld_a.fld_g, offset_a, bins_a.min, nhistbins / (bins_a.max - bins_a.min),
+            joint ? fld_a.loc[0] : 0, joint ? fld_a.loc[1] : 0, joint ? fld_a.loc[2] : 0,
+            joint ? fld_b->fld_g.data() : nullptr,
+            joint ? bins_b->min : TF(0.), joint ? nhistbins / (bins_b->max - bins_b->min) : TF(0.),
+            joint ? fld_b->loc[0] : 0, joint ? fld_b->loc[1] : 0, joint ? fld_b->loc[2] : 0,
+            nhistbins, mfield_g, flag,
+            gd.istart, gd.iend, gd.jstart, gd.jend, kstart, kend,
+            gd.icells, gd.ijcells);
+    cuda_check_error();
+
+    // Only the local counts return to the host.
+    cuda_safe_call(cudaMemcpy(hist, hist_g, size*sizeof(TF), cudaMemcpyDeviceToHost));
+}
+#endif
+
+
+#ifdef FLOAT_SINGLE
+template class Stats<float>;
+#else
+template class Stats<double>;
+#endif
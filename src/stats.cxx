@@ -24,6 +24,7 @@
 #include <cmath>
 #include <sstream>
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <iomanip>
 #include <vector>
@@ -83,6 +84,12 @@ namespace
         }
     }
 
+    template<typename TF>
+    const int* get_nmask_sub(const Mask<TF>& m, const int loc)
+    {
+        return (loc == 0) ? m.nmask_sub.data() : m.nmaskh_sub.data();
+    }
+
     template<typename TF>
     void set_fillvalue_prof(TF* const restrict data, const int* const restrict nmask, const int kstart, const int kcells)
     {
@@ -221,50 +228,50 @@ namespace
         }
     }
 
-    // Calculate the number of points contained in the mask.
-    template<typename TF>
+    // Calculate the number of points per level of all mask bits in a single pass over the mask field,
+    // stored as nmask[k*nbits + bit]. The union of the flags per level is stored in mfield_k.
     void calc_nmask(
-            int* restrict nmask_full, int* restrict nmask_half, int& nmask_bottom,
-            const unsigned int* const mfield, const unsigned int* const mfield_bot,
-            const unsigned int flag, const unsigned int flagh,
+            int* const restrict nmask, unsigned int* const restrict mfield_k,
+            const unsigned int* const restrict mfield, const int nbits,
             const int istart, const int iend, const int jstart, const int jend,
-            const int kstart, const int kend,
-            const int icells, const int ijcells, const int kcells)
+            const int kstart, const int kend, const int stride,
+            const int icells, const int ijcells)
     {
         #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
         {
-            nmask_full[k] = 0;
-            nmask_half[k] = 0;
+            int* const nmask_k = &nmask[k*nbits];
+            for (int n=0; n<nbits; ++n)
+                nmask_k[n] = 0;
 
-            // #pragma omp parallel for reduction (+:nmask_full[k], nmask_half[k]) collapse(2)
-            for (int j=jstart; j<jend; ++j)
-                for (int i=istart; i<iend; ++i)
+            unsigned int flags = 0;
+            for (int j=jstart; j<jend; j+=stride)
+                for (int i=istart; i<iend; i+=stride)
                 {
                     const int ijk = i + j*icells + k*ijcells;
-                    nmask_full[k] += in_mask<int>(mfield[ijk], flag );
-                    nmask_half[k] += in_mask<int>(mfield[ijk], flagh);
+                    const unsigned int m = mfield[ijk];
+                    flags |= m;
+
+                    for (int n=0; n<nbits; ++n)
+                        nmask_k[n] += (m >> n) & 1u;
                 }
+
+            mfield_k[k] = flags;
         }
+    }
 
-        nmask_bottom     = 0;
-        // nmask_half[kend] = 0;
-        // #pragma omp parallel for reduction (+:nmask_bottom) collapse(2)
-        // #pragma omp parallel for reduction (+:nmask_bottom, nmask_half[kend]) collapse(2)
-        for (int j=jstart; j<jend; ++j)
-            for (int i=istart; i<iend; ++i)
-            {
-                const int ij  = i + j*icells;
-                const int ijk = i + j*icells + kend*ijcells;
-                nmask_bottom += in_mask<int>(mfield_bot[ij], flag);
-                // nmask_half[kend] += in_mask<int>(mfield[ijk], flagh);
-            }
+    int get_bit(const unsigned int flag)
+    {
+        int n = 0;
+        while ((flag >> n) != 1u)
+            ++n;
+        return n;
     }
 
     template<typename TF>
     void calc_mean(
             TF* const restrict prof, const TF* const restrict fld,
-            const unsigned int* const mask, const unsigned int flag, const int* const nmask,
+            const unsigned int* const mask, const unsigned int* const mask_k, const unsigned int flag, const int* const nmask,
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int icells, const int ijcells)
     {
@@ -274,13 +281,16 @@ namespace
             if (nmask[k])
             {
                 double tmp = 0.;
-                for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk  = i + j*icells + k*ijcells;
-                        tmp += in_mask<double>(mask[ijk], flag) * fld[ijk];
-                    }
+                if (mask_k[k] & flag)
+                {
+                    for (int j=jstart; j<jend; ++j)
+                        #pragma ivdep
+                        for (int i=istart; i<iend; ++i)
+                        {
+                            const int ijk  = i + j*icells + k*ijcells;
+                            tmp += in_mask<double>(mask[ijk], flag) * fld[ijk];
+                        }
+                }
 
                 prof[k] = tmp / nmask[k];
             }
@@ -288,6 +298,105 @@ namespace
     }
 
 
+    // Bin of a value, of which the values outside of the range end up in the outermost bins.
+    template<typename TF>
+    inline int get_bin(const TF value, const TF min, const TF fac, const int nbins)
+    {
+        const TF x = (value - min) * fac;
+        if (x < TF(0.))
+            return 0;
+        else if (x >= nbins)
+            return nbins-1;
+        else
+            return static_cast<int>(x);
+    }
+
+    // Value of a field at the cell centre, averaged over the faces of its staggered location.
+    template<typename TF>
+    inline TF interp_to_centre(
+            const TF* const restrict fld, const std::array<int,3>& loc,
+            const int ijk, const int jj, const int kk)
+    {
+        TF sum = TF(0.);
+        for (int dk=0; dk<=loc[2]; ++dk)
+            for (int dj=0; dj<=loc[1]; ++dj)
+                for (int di=0; di<=loc[0]; ++di)
+                    sum += fld[ijk + di + dj*jj + dk*kk];
+
+        return sum / ((1+loc[0]) * (1+loc[1]) * (1+loc[2]));
+    }
+
+    template<typename TF>
+    void calc_hist(
+            TF* const restrict hist, const TF* const restrict fld, const TF offset,
+            const TF min, const TF fac, const int nbins,
+            const unsigned int* const mask, const unsigned int* const mask_k, const unsigned int flag, const int* const nmask,
+            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+        {
+            TF* const restrict hist_k = hist + (k-kstart)*nbins;
+            std::fill(hist_k, hist_k + nbins, TF(0.));
+
+            if (nmask[k] == 0 || !(mask_k[k] & flag))
+                continue;
+
+            for (int j=jstart; j<jend; ++j)
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*icells + k*ijcells;
+                    if (mask[ijk] & flag)
+                        hist_k[get_bin(fld[ijk] + offset, min, fac, nbins)] += TF(1.);
+                }
+
+            // Scale with the number of points of all processes, such that the sum over them is the fraction.
+            const TF norm = TF(1.) / nmask[k];
+            for (int n=0; n<nbins; ++n)
+                hist_k[n] *= norm;
+        }
+    }
+
+    template<typename TF>
+    void calc_hist_joint(
+            TF* const restrict hist,
+            const TF* const restrict fld_a, const std::array<int,3>& loc_a, const TF min_a, const TF fac_a,
+            const TF* const restrict fld_b, const std::array<int,3>& loc_b, const TF min_b, const TF fac_b,
+            const int nbins,
+            const unsigned int* const mask, const unsigned int* const mask_k, const unsigned int flag, const int* const nmask,
+            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+            const int icells, const int ijcells)
+    {
+        const int nbins2 = nbins*nbins;
+
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+        {
+            TF* const restrict hist_k = hist + (k-kstart)*nbins2;
+            std::fill(hist_k, hist_k + nbins2, TF(0.));
+
+            if (nmask[k] == 0 || !(mask_k[k] & flag))
+                continue;
+
+            for (int j=jstart; j<jend; ++j)
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*icells + k*ijcells;
+                    if (mask[ijk] & flag)
+                    {
+                        const int n_a = get_bin(interp_to_centre(fld_a, loc_a, ijk, icells, ijcells), min_a, fac_a, nbins);
+                        const int n_b = get_bin(interp_to_centre(fld_b, loc_b, ijk, icells, ijcells), min_b, fac_b, nbins);
+                        hist_k[n_a*nbins + n_b] += TF(1.);
+                    }
+                }
+
+            const TF norm = TF(1.) / nmask[k];
+            for (int n=0; n<nbins2; ++n)
+                hist_k[n] *= norm;
+        }
+    }
+
     template<typename TF>
     void calc_mean_2d(
             TF& out,
@@ -351,23 +460,28 @@ namespace
     template<typename TF>
     void calc_moment(
             TF* const restrict prof, const TF* const restrict fld, const TF* const restrict fld_mean, const TF offset,
-            const unsigned int* const mask, const unsigned int flag, const int* const nmask, const int power,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+            const unsigned int* const mask, const unsigned int* const mask_k, const unsigned int flag, const int* const nmask, const int power,
+            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend, const int stride,
             const int icells, const int ijcells)
     {
         #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
         {
+            // A level without subsampled points in the mask contributes nothing to the sum over the processes.
+            prof[k] = TF(0.);
             if (nmask[k])
             {
                 double tmp = 0.;
-                for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk  = i + j*icells + k*ijcells;
-                        tmp += in_mask<double>(mask[ijk], flag)*std::pow(fld[ijk] - fld_mean[k] + offset, power);
-                    }
+                if (mask_k[k] & flag)
+                {
+                    for (int j=jstart; j<jend; j+=stride)
+                        #pragma ivdep
+                        for (int i=istart; i<iend; i+=stride)
+                        {
+                            const int ijk  = i + j*icells + k*ijcells;
+                            tmp += in_mask<double>(mask[ijk], flag)*std::pow(fld[ijk] - fld_mean[k] + offset, power);
+                        }
+                }
 
                 prof[k] = tmp / nmask[k];
             }
@@ -379,27 +493,31 @@ namespace
             TF* const restrict prof, const TF* const restrict fld1, const TF* const restrict fld1_mean,
             const TF offset1, const int pow1,
             const TF* const restrict fld2, const TF* const restrict fld2_mean, const TF offset2, const int pow2,
-            const unsigned int* const mask, const unsigned int flag, const int* const nmask,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+            const unsigned int* const mask, const unsigned int* const mask_k, const unsigned int flag, const int* const nmask,
+            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend, const int stride,
             const int icells, const int ijcells)
     {
         #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
         {
+            prof[k] = TF(0.);
             if (nmask[k])
             {
                 double tmp = 0.;
                 if ((fld1_mean[k] != netcdf_fp_fillvalue<TF>()) && (fld2_mean[k] != netcdf_fp_fillvalue<TF>()))
                 {
-                    for (int j=jstart; j<jend; ++j)
-                        #pragma ivdep
-                        for (int i=istart; i<iend; ++i)
-                        {
-                            const int ijk  = i + j*icells + k*ijcells;
-                            tmp += in_mask<double>(mask[ijk], flag)
-                                * std::pow(fld1[ijk] - fld1_mean[k] + offset1, pow1)
-                                * std::pow(fld2[ijk] - fld2_mean[k] + offset2, pow2);
-                        }
+                    if (mask_k[k] & flag)
+                    {
+                        for (int j=jstart; j<jend; j+=stride)
+                            #pragma ivdep
+                            for (int i=istart; i<iend; i+=stride)
+                            {
+                                const int ijk  = i + j*icells + k*ijcells;
+                                tmp += in_mask<double>(mask[ijk], flag)
+                                    * std::pow(fld1[ijk] - fld1_mean[k] + offset1, pow1)
+                                    * std::pow(fld2[ijk] - fld2_mean[k] + offset2, pow2);
+                            }
+                    }
 
                     prof[k] = tmp / nmask[k];
                 }
@@ -420,7 +538,7 @@ namespace
     template<typename TF>
     void calc_frac(
             TF* const restrict prof, const TF* const restrict fld, const TF offset, const TF threshold,
-            const unsigned int* const mask, const unsigned int flag, const int* const nmask,
+            const unsigned int* const mask, const unsigned int* const mask_k, const unsigned int flag, const int* const nmask,
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
             const int icells, const int ijcells)
     {
@@ -430,13 +548,16 @@ namespace
             if (nmask[k])
             {
                 double tmp = 0.;
-                for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk  = i + j*icells + k*ijcells;
-                        tmp += in_mask<double>(mask[ijk], flag)*((fld[ijk] + offset) > threshold);
-                    }
+                if (mask_k[k] & flag)
+                {
+                    for (int j=jstart; j<jend; ++j)
+                        #pragma ivdep
+                        for (int i=istart; i<iend; ++i)
+                        {
+                            const int ijk  = i + j*icells + k*ijcells;
+                            tmp += in_mask<double>(mask[ijk], flag)*((fld[ijk] + offset) > threshold);
+                        }
+                }
                 prof[k] = tmp / nmask[k];
             }
         }
@@ -554,9 +675,22 @@ Stats<TF>::Stats(
 {
     swstats = inputin.get_item<bool>("stats", "swstats", "", false);
 
+    swasyncwrite = false;
+    write_pending = false;
+    nhistbins = 0;
+    nbuffer = 1;
+    substride = 1;
+    nbuffered = 0;
+
     if (swstats)
     {
         sampletime = inputin.get_item<double>("stats", "sampletime", "");
+        sampleoffset = inputin.get_item<double>("stats", "sampleoffset", "", 0.);
+
+        nbuffer = inputin.get_item<int>("stats", "nbuffer", "", 1);
+        if (nbuffer < 1)
+            throw std::runtime_error("Stats nbuffer has to be at least one sample");
+
         masklist   = inputin.get_list<std::string>("stats", "masklist", "", std::vector<std::string>());
         masklist.push_back("default"); // Add the default mask, which calculates the domain mean without sampling.
 
@@ -565,6 +699,11 @@ Stats<TF>::Stats(
         masklist.insert(masklist.end(), xymasklist.begin(), xymasklist.end());
 
         swtendency = inputin.get_item<bool>("stats", "swtendency", "", false);
+
+        // GPU runs already write the statistics in a separate task.
+        #ifndef USECUDA
+        swasyncwrite = inputin.get_item<bool>("stats", "swasyncwrite", "", false);
+        #endif
         std::vector<std::string> whitelistin = inputin.get_list<std::string>("stats", "whitelist", "", std::vector<std::string>());
 
         // Anything without an underscore is mean value, so should be on the whitelist
@@ -577,6 +716,53 @@ Stats<TF>::Stats(
             whitelist.push_back(re);
         }
 
+        histlist = inputin.get_list<std::string>("stats", "histlist", "", std::vector<std::string>());
+
+        for (auto& pair : inputin.get_list<std::string>("stats", "histjoint", "", std::vector<std::string>()))
+        {
+            const size_t n = pair.find('*');
+            if (n == std::string::npos || n == 0 || n == pair.size()-1)
+                throw std::runtime_error("Joint histogram \"" + pair + "\" in [stats] is not of the form name1*name2");
+
+            joint_histlist.emplace_back(pair.substr(0, n), pair.substr(n+1));
+        }
+
+        nhistbins = inputin.get_item<int>("stats", "histbins", "", 40);
+        if (nhistbins < 1)
+            throw std::runtime_error("The histbins in [stats] has to be at least one");
+
+        substride = inputin.get_item<int>("stats", "substride", "", 1);
+        if (substride < 1)
+            throw std::runtime_error("The substride in [stats] has to be at least one");
+
+        #ifdef USECUDA
+        if (substride > 1)
+            throw std::runtime_error("The substride in [stats] is not implemented on the GPU");
+        #endif
+
+        auto add_hist_bins = [&](const std::string& name)
+        {
+            if (hist_bins.find(name) != hist_bins.end())
+                return;
+
+            const std::vector<TF> range = inputin.get_list<TF>("stats", "histrange", name, std::vector<TF>());
+            if (range.empty())
+                hist_bins.emplace(name, Hist_bins{TF(0.), TF(0.), false});
+            else if (range.size() == 2 && range[0] < range[1])
+                hist_bins.emplace(name, Hist_bins{range[0], range[1], true});
+            else
+                throw std::runtime_error("The histrange of \"" + name + "\" in [stats] has to be a pair min,max");
+        };
+
+        for (auto& name : histlist)
+            add_hist_bins(name);
+
+        for (auto& pair : joint_histlist)
+        {
+            add_hist_bins(pair.first);
+            add_hist_bins(pair.second);
+        }
+
         std::vector<std::string> blacklistin = inputin.get_list<std::string>("stats", "blacklist", "", std::vector<std::string>());
 
         for (auto& it : blacklistin)
@@ -590,6 +776,9 @@ Stats<TF>::Stats(
 template<typename TF>
 Stats<TF>::~Stats()
 {
+    // Write the samples of the last incomplete block.
+    if (nbuffered > 0)
+        flush();
 }
 
 template<typename TF>
@@ -603,11 +792,16 @@ void Stats<TF>::init()
     boundary_cyclic.init();
 
     isampletime = convert_to_itime(sampletime);
+    isampleoffset = convert_to_itime(sampleoffset);
+    if (isampleoffset >= isampletime)
+        throw std::runtime_error("The sampleoffset in [stats] has to be smaller than the sampletime");
+
     statistics_counter = 0;
 
     // Vectors which hold the amount of grid points sampled on each model level.
     mfield.resize(gd.ncells);
     mfield_bot.resize(gd.ijcells);
+    mfield_k.resize(gd.kcells);
 }
 
 template<typename TF>
@@ -618,6 +812,7 @@ void Stats<TF>::create(const Timeloop<TF>& timeloop, std::string sim_name)
         return;
 
     int iotime = timeloop.get_iotime();
+    isavetime = timeloop.get_isavetime();
 
     auto& gd = grid.get_grid_data();
     auto& sgd = soil_grid.get_grid_data();
@@ -697,11 +892,79 @@ void Stats<TF>::create(const Timeloop<TF>& timeloop, std::string sim_name)
 
         m.nmask. resize(gd.kcells);
         m.nmaskh.resize(gd.kcells);
+        m.nmask_sub. resize(gd.kcells);
+        m.nmaskh_sub.resize(gd.kcells);
     }
 
     // For each mask, add the area as a variable.
     add_prof("area" , "Fractional area contained in mask", "-", "z" , "default");
     add_prof("areah", "Fractional area contained in mask", "-", "zh", "default");
+
+    // Add the histograms, of which the bins are written once their range is known.
+    auto get_field = [&](const std::string& name) -> const Field3d<TF>&
+    {
+        auto it = fields.ap.find(name);
+        if (it == fields.ap.end())
+            throw std::runtime_error("Histogram of \"" + name + "\" in [stats] is not of a prognostic field");
+        return *it->second;
+    };
+
+    for (auto& bins : hist_bins)
+    {
+        const std::string& name = bins.first;
+        get_field(name);
+
+        for (auto& mask : masks)
+        {
+            Mask<TF>& m = mask.second;
+
+            m.data_file->add_dimension(name + "_bin", nhistbins);
+            auto it = m.hist_bin_vars.emplace(
+                    name + "_bin", m.data_file->template add_variable<TF>(name + "_bin", {name + "_bin"})).first;
+            it->second.add_attribute("units", fields.ap.at(name)->unit);
+            it->second.add_attribute("long_name", "Bin centres of " + fields.ap.at(name)->longname);
+        }
+    }
+
+    auto add_hist = [&](const std::string& name, const std::string& longname, const std::vector<std::string>& dims)
+    {
+        for (auto& mask : masks)
+        {
+            Mask<TF>& m = mask.second;
+
+            Netcdf_handle& handle =
+                m.data_file->group_exists("hist") ? m.data_file->get_group("hist") : m.data_file->add_group("hist");
+
+            int size = 1;
+            for (size_t n=1; n<dims.size(); ++n)
+                size *= m.data_file->get_dimension_size(dims[n]);
+
+            Prof_var<TF> tmp{handle.add_variable<TF>(name, dims), std::vector<TF>(size), Level_type::Full, std::vector<TF>()};
+            m.hists.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(std::move(tmp)));
+
+            m.hists.at(name).ncvar.add_attribute("units", "-");
+            m.hists.at(name).ncvar.add_attribute("long_name", longname);
+
+            m.data_file->sync();
+        }
+
+        varlist.push_back(name);
+    };
+
+    for (auto& name : histlist)
+    {
+        const Field3d<TF>& fld = get_field(name);
+        add_hist(name + "_hist", "Histogram of " + fld.longname,
+                {"time", fld.loc[2] == 0 ? "z" : "zh", name + "_bin"});
+    }
+
+    for (auto& pair : joint_histlist)
+    {
+        get_field(pair.first);
+        get_field(pair.second);
+        add_hist(pair.first + "_" + pair.second + "_hist", "Joint histogram of " + pair.first + " and " + pair.second,
+                {"time", "z", pair.first + "_bin", pair.second + "_bin"});
+    }
 }
 
 template<typename TF>
@@ -711,7 +974,7 @@ unsigned long Stats<TF>::get_time_limit(unsigned long itime)
     if (!swstats)
         return Constants::ulhuge;
 
-    unsigned long idtlim = isampletime - itime % isampletime;
+    unsigned long idtlim = get_sample_time_limit(itime, isampletime, isampleoffset);
     return idtlim;
 }
 
@@ -723,7 +986,7 @@ bool Stats<TF>::do_statistics(unsigned long itime)
         return false;
 
     // Check if time for execution.
-    if (itime % isampletime != 0)
+    if (!is_sample_time(itime, isampletime, isampleoffset))
         return false;
 
     // Return true such that stats are computed.
@@ -742,6 +1005,42 @@ void Stats<TF>::exec(const int iteration, const double time, const unsigned long
     if (!swstats)
         return;
 
+    if (swasyncwrite)
+    {
+        // Complete a previous statistics step that has not been written yet.
+        finish_exec();
+
+        // Start the reduction, and write once the model has advanced.
+        reduce_deferred_begin();
+
+        pending_iteration = iteration;
+        pending_time = time;
+        pending_itime = itime;
+        write_pending = true;
+    }
+    else
+    {
+        // Complete the profiles of which the reduction was deferred.
+        reduce_deferred();
+        write(iteration, time, itime);
+    }
+}
+
+template<typename TF>
+void Stats<TF>::finish_exec()
+{
+    if (!write_pending)
+        return;
+
+    reduce_deferred_end();
+    write(pending_iteration, pending_time, pending_itime);
+
+    write_pending = false;
+}
+
+template<typename TF>
+void Stats<TF>::write(const int iteration, const double time, const unsigned long itime)
+{
     auto& agd = grid.get_grid_data();
     auto& sgd = soil_grid.get_grid_data();
 
@@ -780,58 +1079,126 @@ void Stats<TF>::exec(const int iteration, const double time, const unsigned long
     {
         Mask<TF>& m = mask.second;
 
-        // Put the data into the NetCDF file.
-        const std::vector<int> time_index{statistics_counter};
-
-        // Write the time and iteration number.
-        m.time_var->insert(time     , time_index);
-        m.iter_var->insert(iteration, time_index);
-
-        const std::vector<int> time_height_index = {statistics_counter, 0};
+        // Add the sample to the buffers, which are written in flush().
+        m.time_buffer.push_back(time);
+        m.iter_buffer.push_back(iteration);
 
         for (auto& p : m.profs)
         {
             const int ksize = p.second.ncvar.get_dim_sizes()[1];
-            std::vector<int> time_height_size  = {1, ksize};
-
-            std::vector<TF> prof_nogc(
+            p.second.buffer.insert(
+                    p.second.buffer.end(),
                     p.second.data.begin() + agd.kstart,
                     p.second.data.begin() + agd.kstart + ksize);
-
-            m.profs.at(p.first).ncvar.insert(prof_nogc, time_height_index, time_height_size);
         }
 
         for (auto& p : m.soil_profs)
         {
             const int ksize = p.second.ncvar.get_dim_sizes()[1];
-            std::vector<int> time_height_size  = {1, ksize};
-
-            std::vector<TF> prof_nogc(
+            p.second.buffer.insert(
+                    p.second.buffer.end(),
                     p.second.data.begin() + sgd.kstart,
                     p.second.data.begin() + sgd.kstart + ksize);
-
-            m.soil_profs.at(p.first).ncvar.insert(prof_nogc, time_height_index, time_height_size);
         }
 
         for (auto& p : m.background_profs)
         {
             const int ksize = p.second.ncvar.get_dim_sizes()[1];
-            std::vector<int> time_height_size  = {1, ksize};
-
-            m.background_profs.at(p.first).ncvar.insert(p.second.data, time_height_index, time_height_size);
+            p.second.buffer.insert(
+                    p.second.buffer.end(),
+                    p.second.data.begin(),
+                    p.second.data.begin() + ksize);
         }
 
-        for (auto& ts : m.tseries)
-            m.tseries.at(ts.first).ncvar.insert(m.tseries.at(ts.first).data, time_index);
+        for (auto& p : m.spectra)
+            p.second.buffer.insert(p.second.buffer.end(), p.second.data.begin(), p.second.data.end());
 
-        // Synchronize the NetCDF file.
-        m.data_file->sync();
+        for (auto& p : m.hists)
+            p.second.buffer.insert(p.second.buffer.end(), p.second.data.begin(), p.second.data.end());
+
+        for (auto& ts : m.tseries)
+            ts.second.buffer.push_back(ts.second.data);
     }
 
     wmean_set = false;
 
     // Increment the statistics index.
     ++statistics_counter;
+    ++nbuffered;
+
+    // Write the block if it is full, or if the next sample is beyond a restart save.
+    const bool save_ahead = (itime % isavetime == 0) || (itime % isavetime + isampletime > isavetime);
+    if (nbuffered == nbuffer || save_ahead)
+        flush();
+}
+
+template<typename TF>
+void Stats<TF>::flush()
+{
+    // Put the buffered samples into the NetCDF files as one block per variable.
+    const int time_start = statistics_counter - nbuffered;
+
+    for (auto& mask : masks)
+    {
+        Mask<TF>& m = mask.second;
+
+        const std::vector<int> time_index{time_start};
+        const std::vector<int> time_size{nbuffered};
+
+        // Write the time and iteration number.
+        m.time_var->insert(m.time_buffer, time_index, time_size);
+        m.iter_var->insert(m.iter_buffer, time_index, time_size);
+
+        m.time_buffer.clear();
+        m.iter_buffer.clear();
+
+        const std::vector<int> time_height_index = {time_start, 0};
+
+        auto insert_profs = [&](Prof_map<TF>& profs)
+        {
+            for (auto& p : profs)
+            {
+                const int ksize = p.second.ncvar.get_dim_sizes()[1];
+                const std::vector<int> time_height_size = {nbuffered, ksize};
+
+                p.second.ncvar.insert(p.second.buffer, time_height_index, time_height_size);
+                p.second.buffer.clear();
+            }
+        };
+
+        insert_profs(m.profs);
+        insert_profs(m.soil_profs);
+        insert_profs(m.background_profs);
+
+        for (auto& p : m.spectra)
+        {
+            const std::vector<int> dim_sizes = p.second.ncvar.get_dim_sizes();
+            p.second.ncvar.insert(p.second.buffer, {time_start, 0, 0}, {nbuffered, dim_sizes[1], dim_sizes[2]});
+            p.second.buffer.clear();
+        }
+
+        for (auto& p : m.hists)
+        {
+            std::vector<int> hist_index(p.second.ncvar.get_dim_sizes().size(), 0);
+            std::vector<int> hist_size = p.second.ncvar.get_dim_sizes();
+            hist_index[0] = time_start;
+            hist_size[0] = nbuffered;
+
+            p.second.ncvar.insert(p.second.buffer, hist_index, hist_size);
+            p.second.buffer.clear();
+        }
+
+        for (auto& ts : m.tseries)
+        {
+            ts.second.ncvar.insert(ts.second.buffer, time_index, time_size);
+            ts.second.buffer.clear();
+        }
+
+        // Synchronize the NetCDF file.
+        m.data_file->sync();
+    }
+
+    nbuffered = 0;
 }
 
 // Retrieve the user input list of requested masks.
@@ -1094,7 +1461,7 @@ void Stats<TF>::add_prof(
 
         if ((zloc == "z") || (zloc == "zh"))
         {
-            Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zloc}), std::vector<TF>(agd.kcells), level};
+            Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zloc}), std::vector<TF>(agd.kcells), level, std::vector<TF>()};
 
             m.profs.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(std::move(tmp)));
 
@@ -1103,7 +1470,7 @@ void Stats<TF>::add_prof(
         }
         else if (zloc == "zs")
         {
-            Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zloc}), std::vector<TF>(sgd.kcells), level};
+            Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zloc}), std::vector<TF>(sgd.kcells), level, std::vector<TF>()};
 
             m.soil_profs.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(std::move(tmp)));
 
@@ -1113,7 +1480,7 @@ void Stats<TF>::add_prof(
         else if (zloc == "lev")
         {
             const TF n_lev = background.get_n_lev();
-            Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zloc}), std::vector<TF>(n_lev), level};
+            Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zloc}), std::vector<TF>(n_lev), level, std::vector<TF>()};
 
             m.background_profs.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(std::move(tmp)));
             m.background_profs.at(name).ncvar.add_attribute("units", unit);
@@ -1122,7 +1489,7 @@ void Stats<TF>::add_prof(
         else if (zloc == "lay")
         {
             const TF n_lay = background.get_n_lay();
-            Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zloc}), std::vector<TF>(n_lay), level};
+            Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zloc}), std::vector<TF>(n_lay), level, std::vector<TF>()};
 
             m.background_profs.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(std::move(tmp)));
             m.background_profs.at(name).ncvar.add_attribute("units", unit);
@@ -1242,7 +1609,7 @@ void Stats<TF>::add_time_series(
             (m.data_file->group_exists(group_name) ? m.data_file->get_group(group_name) : m.data_file->add_group(group_name));
 
         // Create the NetCDF variable
-        Time_series_var<TF> tmp{handle.add_variable<TF>(name, {"time"}), 0.};
+        Time_series_var<TF> tmp{handle.add_variable<TF>(name, {"time"}), 0., std::vector<TF>()};
 
         m.tseries.emplace(
                 std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(std::move(tmp)));
@@ -1280,32 +1647,77 @@ void Stats<TF>::finalize_masks()
     boundary_cyclic.exec(mfield.data());
     boundary_cyclic.exec_2d(mfield_bot.data());
 
-    for (auto& it : masks)
-    {
-        // CvH: compute the nmask over the entire depth. Masks need to provide the proper count for
-        // the ghost cells in order to be able to calculate mean profile in ghost cells (needed for budgets).
-        calc_nmask<TF>(
-                it.second.nmask.data(), it.second.nmaskh.data(), it.second.nmask_bot,
-                mfield.data(), mfield_bot.data(), it.second.flag, it.second.flagh,
-                gd.istart, gd.iend, gd.jstart, gd.jend, 0, gd.kcells,
-                gd.icells, gd.ijcells, gd.kcells);
+    #ifdef USECUDA
+    upload_masks_g();
+    #endif
 
-        master.sum(it.second.nmask.data() , gd.kcells);
-        master.sum(it.second.nmaskh.data(), gd.kcells);
+    // Each mask has a bit for the full and for the half levels.
+    const int nbits = 2*masks.size();
+    std::vector<int> nmask_bits(nbits*gd.kcells);
 
-        it.second.nmask_bot = it.second.nmaskh[gd.kstart];
+    // CvH: compute the nmask over the entire depth. Masks need to provide the proper count for
+    // the ghost cells in order to be able to calculate mean profile in ghost cells (needed for budgets).
+    calc_nmask(
+            nmask_bits.data(), mfield_k.data(), mfield.data(), nbits,
+            gd.istart, gd.iend, gd.jstart, gd.jend, 0, gd.kcells, 1,
+            gd.icells, gd.ijcells);
 
-        auto it1 = std::find(varlist.begin(), varlist.end(), "area");
-        if (it1 != varlist.end())
-            calc_area(it.second.profs.at("area").data.data(), gd.sloc.data(), it.second.nmask.data(),
-                    gd.kstart, gd.kend, gd.itot*gd.jtot);
+    master.sum(nmask_bits.data(), nbits*gd.kcells);
 
-        it1 = std::find(varlist.begin(), varlist.end(), "areah");
-        if (it1 != varlist.end())
-            calc_area(it.second.profs.at("areah").data.data(), gd.wloc.data(), it.second.nmaskh.data(),
-                    gd.kstart, gd.kend, gd.itot*gd.jtot);
+    // The subsampled points are counted separately, because the subsampled moments are normalized
+    // by the number of points that entered them. The flags per level of all points are kept.
+    std::vector<int> nmask_sub_bits;
+    if (substride > 1)
+    {
+        std::vector<unsigned int> mfield_k_sub(gd.kcells);
+        nmask_sub_bits.resize(nbits*gd.kcells);
+
+        calc_nmask(
+                nmask_sub_bits.data(), mfield_k_sub.data(), mfield.data(), nbits,
+                gd.istart, gd.iend, gd.jstart, gd.jend, 0, gd.kcells, substride,
+                gd.icells, gd.ijcells);
+
+        master.sum(nmask_sub_bits.data(), nbits*gd.kcells);
     }
-}
+
+    for (auto& it : masks)
+    {
+        const int bit  = get_bit(it.second.flag);
+        const int bith = get_bit(it.second.flagh);
+
+        for (int k=0; k<gd.kcells; ++k)
+        {
+            it.second.nmask [k] = nmask_bits[k*nbits + bit ];
+            it.second.nmaskh[k] = nmask_bits[k*nbits + bith];
+        }
+
+        if (substride > 1)
+        {
+            for (int k=0; k<gd.kcells; ++k)
+            {
+                it.second.nmask_sub [k] = nmask_sub_bits[k*nbits + bit ];
+                it.second.nmaskh_sub[k] = nmask_sub_bits[k*nbits + bith];
+            }
+        }
+        else
+        {
+            it.second.nmask_sub  = it.second.nmask;
+            it.second.nmaskh_sub = it.second.nmaskh;
+        }
+
+        it.second.nmask_bot = it.second.nmaskh[gd.kstart];
+
+        auto it1 = std::find(varlist.begin(), varlist.end(), "area");
+        if (it1 != varlist.end())
+            calc_area(it.second.profs.at("area").data.data(), gd.sloc.data(), it.second.nmask.data(),
+                    gd.kstart, gd.kend, gd.itot*gd.jtot);
+
+        it1 = std::find(varlist.begin(), varlist.end(), "areah");
+        if (it1 != varlist.end())
+            calc_area(it.second.profs.at("areah").data.data(), gd.wloc.data(), it.second.nmaskh.data(),
+                    gd.kstart, gd.kend, gd.itot*gd.jtot);
+    }
+}
 
 template<typename TF>
 void Stats<TF>::set_mask_thres(
@@ -1359,6 +1771,50 @@ void Stats<TF>::set_mask_thres(
         throw std::runtime_error("Invalid mask type in set_mask_thres()");
 }
 
+template<typename TF>
+void Stats<TF>::add_spectrum(
+        const std::string& name, const std::string& longname,
+        const std::string& unit, const std::string& zdim, const std::string& kdim,
+        const std::string& group_name)
+{
+    if (is_blacklisted(name))
+        return;
+
+    if (std::find(varlist.begin(), varlist.end(), name) != varlist.end())
+        throw std::runtime_error("Variable " + name + " is added twice in add_spectrum()");
+
+    for (auto& mask : masks)
+    {
+        Mask<TF>& m = mask.second;
+
+        Netcdf_handle& handle = (group_name == "") ? dynamic_cast<Netcdf_handle&>(*m.data_file) : dynamic_cast<Netcdf_handle&>
+            (m.data_file->group_exists(group_name) ? m.data_file->get_group(group_name) : m.data_file->add_group(group_name));
+
+        const int size = m.data_file->get_dimension_size(zdim) * m.data_file->get_dimension_size(kdim);
+        Prof_var<TF> tmp{handle.add_variable<TF>(name, {"time", zdim, kdim}), std::vector<TF>(size), Level_type::Full, std::vector<TF>()};
+
+        m.spectra.emplace(std::piecewise_construct, std::forward_as_tuple(name), std::forward_as_tuple(std::move(tmp)));
+
+        m.spectra.at(name).ncvar.add_attribute("units", unit);
+        m.spectra.at(name).ncvar.add_attribute("long_name", longname);
+
+        m.data_file->sync();
+    }
+
+    varlist.push_back(name);
+}
+
+template<typename TF>
+void Stats<TF>::set_spectrum(const std::string& varname, const std::vector<TF>& spectrum)
+{
+    for (auto& it : masks)
+    {
+        auto spec = it.second.spectra.find(varname);
+        if (spec != it.second.spectra.end())
+            spec->second.data = spectrum;
+    }
+}
+
 template<typename TF>
 void Stats<TF>::set_prof(const std::string& varname, const std::vector<TF>& prof)
 {
@@ -1396,6 +1852,84 @@ void Stats<TF>::set_time_series(const std::string& varname, const TF val)
     }
 }
 
+template<typename TF>
+void Stats<TF>::sum_deferred(TF* const data, const int* const nmask)
+{
+    auto& gd = grid.get_grid_data();
+    deferred_sums.push_back({data, nmask, gd.kcells});
+}
+
+template<typename TF>
+void Stats<TF>::sum_deferred_block(TF* const data, const int size)
+{
+    deferred_sums.push_back({data, nullptr, size});
+}
+
+template<typename TF>
+void Stats<TF>::pack_deferred()
+{
+    int size = 0;
+    for (auto& ds : deferred_sums)
+        size += ds.size;
+
+    deferred_buffer.resize(size);
+
+    auto it = deferred_buffer.begin();
+    for (auto& ds : deferred_sums)
+        it = std::copy(ds.data, ds.data + ds.size, it);
+}
+
+template<typename TF>
+void Stats<TF>::reduce_deferred()
+{
+    if (deferred_sums.empty())
+        return;
+
+    pack_deferred();
+    master.sum(deferred_buffer.data(), deferred_buffer.size());
+
+    reduce_deferred_end();
+}
+
+template<typename TF>
+void Stats<TF>::reduce_deferred_begin()
+{
+    if (deferred_sums.empty())
+        return;
+
+    pack_deferred();
+
+    #ifdef USEMPI
+    master.sum_begin(deferred_buffer.data(), deferred_buffer.size(), &deferred_request);
+    #endif
+}
+
+template<typename TF>
+void Stats<TF>::reduce_deferred_end()
+{
+    if (deferred_sums.empty())
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    #ifdef USEMPI
+    if (swasyncwrite)
+        MPI_Wait(&deferred_request, MPI_STATUS_IGNORE);
+    #endif
+
+    auto it = deferred_buffer.begin();
+    for (auto& ds : deferred_sums)
+    {
+        std::copy(it, it + ds.size, ds.data);
+        it += ds.size;
+
+        if (ds.nmask != nullptr)
+            set_fillvalue_prof(ds.data, ds.nmask, gd.kstart, gd.kcells);
+    }
+
+    deferred_sums.clear();
+}
+
 template<typename TF>
 void Stats<TF>::calc_mask_mean_profile(
         std::vector<TF>& prof,
@@ -1412,7 +1946,7 @@ void Stats<TF>::calc_mask_mean_profile(
     // CvH. Do the mean over the entire depth. The calc_mean function always add 1 to the specified
     // kend, so I send kcells-1 as the limit. This is not elegant, yet it works.
     calc_mean(
-            prof.data(), fld.fld.data(), mfield.data(), flag, nmask,
+            prof.data(), fld.fld.data(), mfield.data(), mfield_k.data(), flag, nmask,
             gd.istart, gd.iend, gd.jstart, gd.jend, 1, gd.kcells, gd.icells, gd.ijcells);
 
     master.sum(prof.data(), gd.kcells);
@@ -1437,7 +1971,7 @@ void Stats<TF>::calc_mask_stats(
         calc_mean(
                 m.second.profs.at(varname).data.data(),
                 fld.fld.data(),
-                mfield.data(), flag, nmask,
+                mfield.data(), mfield_k.data(), flag, nmask,
                 gd.istart, gd.iend,
                 gd.jstart, gd.jend,
                 gd.kstart, gd.kend + fld.loc[2],
@@ -1466,7 +2000,167 @@ void Stats<TF>::calc_stats(
     calc_stats_path(varname, fld);
     calc_stats_cover(varname, fld, offset, threshold);
     calc_stats_frac(varname, fld, offset, threshold);        
+    calc_stats_hist(varname, fld, offset);
+}
+
+#ifdef USECUDA
+template<typename TF>
+void Stats<TF>::calc_stats_g(
+        const std::string& varname, const Field3d<TF>& fld, const TF offset, const TF threshold)
+{
+    auto& gd = grid.get_grid_data();
+
+    // The mean and moments are reduced on the device, the other statistics still use the host field.
+    // The statistics run in a task next to the time integration, which keeps changing fld_g, so
+    // the reductions work on a device copy of the host field.
+    auto snapshot = fields.get_tmp_g();
+    snapshot->loc = fld.loc;
+    cuda_copy(fld.fld.data(), snapshot->fld_g.data(), gd.ncells);
+
+    calc_stats_mean_g(varname, *snapshot, offset);
+    calc_stats_moments_g(varname, *snapshot, offset);
+    calc_stats_hist_g(varname, *snapshot, offset);
+
+    fields.release_tmp_g(snapshot);
+
+    calc_stats_w(varname, fld, offset);
+    calc_stats_diff(varname, fld, offset);
+    calc_stats_flux(varname, fld, offset);
+    calc_stats_grad(varname, fld);
+    calc_stats_path(varname, fld);
+    calc_stats_cover(varname, fld, offset, threshold);
+    calc_stats_frac(varname, fld, offset, threshold);
+}
+
+template<typename TF>
+void Stats<TF>::calc_stats_mean_g(
+        const std::string& varname, const Field3d<TF>& fld, const TF offset)
+{
+    auto& gd = grid.get_grid_data();
+
+    unsigned int flag;
+    const int* nmask;
+
+    if (std::find(varlist.begin(), varlist.end(), varname) != varlist.end())
+    {
+        for (auto& m : masks)
+        {
+            set_flag(flag, nmask, m.second, fld.loc[2]);
+
+            TF* const prof = m.second.profs.at(varname).data.data();
+            const int kend = gd.kend + fld.loc[2];
+
+            calc_masked_sum_g(prof_tmp.data(), fld, nullptr, TF(0.), flag, 1, gd.kstart, kend);
+
+            for (int k=gd.kstart; k<kend; ++k)
+                if (nmask[k])
+                    prof[k] = prof_tmp[k] / nmask[k];
+
+            master.sum(prof, gd.kcells);
+
+            // Add the offset.
+            for (auto& value : m.second.profs.at(varname).data)
+                value += offset;
+
+            set_fillvalue_prof(prof, nmask, gd.kstart, gd.kcells);
+        }
+    }
+}
+
+template<typename TF>
+void Stats<TF>::calc_stats_moments_g(
+        const std::string& varname, const Field3d<TF>& fld, const TF offset)
+{
+    auto& gd = grid.get_grid_data();
+
+    unsigned int flag;
+    const int* nmask;
+    std::string name;
+
+    for (int power=2; power<=4; power++)
+    {
+        name = varname + "_" + std::to_string(power);
+        if (std::find(varlist.begin(), varlist.end(), name) != varlist.end())
+        {
+            for (auto& m : masks)
+            {
+                set_flag(flag, nmask, m.second, fld.loc[2]);
+
+                TF* const prof = m.second.profs.at(name).data.data();
+
+                calc_masked_sum_g(
+                        prof_tmp.data(), fld, m.second.profs.at(varname).data.data(),
+                        offset, flag, power, gd.kstart, gd.kend+1);
+
+                for (int k=gd.kstart; k<gd.kend+1; ++k)
+                    if (nmask[k])
+                        prof[k] = prof_tmp[k] / nmask[k];
+
+                sum_deferred(prof, nmask);
+            }
+        }
+    }
+}
+
+template<typename TF>
+void Stats<TF>::calc_covariance_g(
+        const std::string& varname1, const Field3d<TF>& fld1, const TF offset1, const TF threshold1, const int power1,
+        const std::string& varname2, const Field3d<TF>& fld2, const TF offset2, const TF threshold2, const int power2)
+{
+    auto& gd = grid.get_grid_data();
+
+    std::string name = varname1 + "_" + std::to_string(power1) + "_" + varname2 + "_" + std::to_string(power2);
+
+    if (std::find(varlist.begin(), varlist.end(), name) == varlist.end())
+        return;
+
+    // Fields at different locations are interpolated inside of the reduction on the device.
+    const bool interpolate = (fld1.loc != fld2.loc);
+    std::vector<TF> fld1_mean_h(gd.kcells, netcdf_fp_fillvalue<TF>());
+
+    for (auto& m : masks)
+    {
+        unsigned int flag;
+        int* nmask;
+
+        const std::vector<TF>& prof1 = m.second.profs.at(varname1).data;
+        const TF* fld1_mean = prof1.data();
+        const TF* fld2_mean = m.second.profs.at(varname2).data.data();
+
+        if (fld2.loc[2] == 0)
+        {
+            flag = m.second.flag;
+            nmask = m.second.nmask.data();
+        }
+        else
+        {
+            flag = m.second.flagh;
+            nmask = m.second.nmaskh.data();
+
+            // As on the host, the mean of a field at the same half level location is interpolated.
+            if (!interpolate)
+            {
+                for (int k=gd.kstart; k<gd.kend+1; ++k)
+                    fld1_mean_h[k] = (prof1[k-1] != netcdf_fp_fillvalue<TF>() && prof1[k] != netcdf_fp_fillvalue<TF>())
+                            ? TF(0.5)*(prof1[k]+prof1[k-1]) : netcdf_fp_fillvalue<TF>();
+                fld1_mean = fld1_mean_h.data();
+            }
+        }
+
+        calc_masked_cov_sum_g(
+                prof_tmp.data(), fld1, fld1_mean, offset1, power1,
+                fld2, fld2_mean, offset2, power2, flag, gd.kstart, gd.kend+1);
+
+        TF* const prof = m.second.profs.at(name).data.data();
+
+        for (int k=gd.kstart; k<gd.kend+1; ++k)
+            if (nmask[k] && fld1_mean[k] != netcdf_fp_fillvalue<TF>() && fld2_mean[k] != netcdf_fp_fillvalue<TF>())
+                prof[k] = prof_tmp[k] / nmask[k];
+
+        sum_deferred(prof, interpolate ? nullptr : nmask);
+    }
 }
+#endif
 
 
 template<typename TF>
@@ -1489,7 +2183,7 @@ void Stats<TF>::calc_stats_mean(
             calc_mean(
                     m.second.profs.at(varname).data.data(),
                     fld.fld.data(),
-                    mfield.data(), flag, nmask,
+                    mfield.data(), mfield_k.data(), flag, nmask,
                     gd.istart, gd.iend,
                     gd.jstart, gd.jend,
                     gd.kstart, gd.kend + fld.loc[2],
@@ -1526,18 +2220,21 @@ void Stats<TF>::calc_stats_moments(
             {
                 set_flag(flag, nmask, m.second, fld.loc[2]);
 
+                // The levels without points on the stride are set to the fill value by the counts of the subsample.
+                const int* const nmask_sub = get_nmask_sub(m.second, fld.loc[2]);
+
                 calc_moment(
                         m.second.profs.at(name).data.data(),
                         fld.fld.data(),
                         m.second.profs.at(varname).data.data(),
-                        offset, mfield.data(), flag, nmask, power,
+                        offset, mfield.data(), mfield_k.data(), flag,
+                        nmask_sub, power,
                         gd.istart, gd.iend,
                         gd.jstart, gd.jend,
-                        gd.kstart, gd.kend,
+                        gd.kstart, gd.kend, substride,
                         gd.icells, gd.ijcells);
 
-                master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-                set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+                sum_deferred(m.second.profs.at(name).data.data(), nmask_sub);
             }
         }
     }
@@ -1567,14 +2264,13 @@ void Stats<TF>::calc_stats_w(
             calc_mean(
                     m.second.profs.at(name).data.data(),
                     advec_flux->fld.data(),
-                    mfield.data(), flag, nmask,
+                    mfield.data(), mfield_k.data(), flag, nmask,
                     gd.istart, gd.iend,
                     gd.jstart, gd.jend,
                     0, gd.kcells,
                     gd.icells, gd.ijcells);
 
-            master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-            set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+            sum_deferred(m.second.profs.at(name).data.data(), nmask);
         }
 
         fields.release_tmp(advec_flux);
@@ -1606,14 +2302,13 @@ void Stats<TF>::calc_stats_diff(
             calc_mean(
                     m.second.profs.at(name).data.data(),
                     diff_flux->fld.data(),
-                    mfield.data(), flag, nmask,
+                    mfield.data(), mfield_k.data(), flag, nmask,
                     gd.istart, gd.iend,
                     gd.jstart, gd.jend,
                     gd.kstart, gd.kend+(1-fld.loc[2]),
                     gd.icells, gd.ijcells);
 
-            master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-            set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+            sum_deferred(m.second.profs.at(name).data.data(), nmask);
         }
 
         fields.release_tmp(diff_flux);
@@ -1637,7 +2332,8 @@ void Stats<TF>::calc_stats_flux(
     {
         for (auto& m : masks)
         {
-            // No sum is required in this routine as values all.
+            // The turbulent and diffusive fluxes still hold the partial sums of this process,
+            // so the total flux is reduced together with them.
             set_flag(flag, nmask, m.second, !fld.loc[2]);
 
             add_fluxes(
@@ -1646,7 +2342,7 @@ void Stats<TF>::calc_stats_flux(
                     m.second.profs.at(varname+"_diff").data.data(),
                     gd.kstart, gd.kend);
 
-            set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+            sum_deferred(m.second.profs.at(name).data.data(), nmask);
         }
     }
 }
@@ -1674,7 +2370,7 @@ void Stats<TF>::calc_stats_grad(
                 calc_grad_2nd(
                         m.second.profs.at(name).data.data(),
                         fld.fld.data(), gd.dzhi.data(),
-                        mfield.data(), flag, nmask,
+                        mfield.data(), mfield_k.data(), flag, nmask,
                         gd.istart, gd.iend,
                         gd.jstart, gd.jend,
                         gd.kstart, gd.kend,
@@ -1685,15 +2381,14 @@ void Stats<TF>::calc_stats_grad(
                 calc_grad_4th(
                         m.second.profs.at(name).data.data(),
                         fld.fld.data(), gd.dzhi4.data(),
-                        mfield.data(), flag, nmask,
+                        mfield.data(), mfield_k.data(), flag, nmask,
                         gd.istart, gd.iend,
                         gd.jstart, gd.jend,
                         gd.kstart, gd.kend,
                         gd.icells, gd.ijcells);
             }
 
-            master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-            set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+            sum_deferred(m.second.profs.at(name).data.data(), nmask);
         }
     }
 }
@@ -1794,14 +2489,13 @@ void Stats<TF>::calc_stats_frac(
                     m.second.profs.at(name).data.data(),
                     fld.fld.data(),
                     offset, threshold,
-                    mfield.data(), flag, nmask,
+                    mfield.data(), mfield_k.data(), flag, nmask,
                     gd.istart, gd.iend,
                     gd.jstart, gd.jend,
                     gd.kstart, gd.kend,
                     gd.icells, gd.ijcells);
 
-            master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-            set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+            sum_deferred(m.second.profs.at(name).data.data(), nmask);
         }
     }
 }
@@ -1826,15 +2520,198 @@ void Stats<TF>::calc_tend(Field3d<TF>& fld, const std::string& tend_name)
         for (auto& m : masks)
         {
             set_flag(flag, nmask, m.second, fld.loc[2]);
-            calc_mean(m.second.profs.at(name).data.data(), fld.fld.data(), mfield.data(), flag, nmask,
+            calc_mean(m.second.profs.at(name).data.data(), fld.fld.data(), mfield.data(), mfield_k.data(), flag, nmask,
                     gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend+fld.loc[2], gd.icells, gd.ijcells);
-            master.sum(m.second.profs.at(name).data.data(), gd.kcells);
+            sum_deferred(m.second.profs.at(name).data.data(), nmask);
+        }
+    }
+}
+
+template<typename TF>
+const typename Stats<TF>::Hist_bins& Stats<TF>::get_hist_bins(
+        const std::string& varname, const Field3d<TF>& fld, const TF offset)
+{
+    auto& gd = grid.get_grid_data();
+    Hist_bins& bins = hist_bins.at(varname);
+
+    if (bins.is_set)
+        return bins;
+
+    // Take the range of the first sample, widened by half of it.
+    TF fld_min = Constants::dhuge;
+    TF fld_max = -Constants::dhuge;
+
+    for (int k=gd.kstart; k<gd.kend+fld.loc[2]; ++k)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+            for (int i=gd.istart; i<gd.iend; ++i)
+            {
+                const int ijk = i + j*gd.icells + k*gd.ijcells;
+                fld_min = std::min(fld_min, fld.fld[ijk] + offset);
+                fld_max = std::max(fld_max, fld.fld[ijk] + offset);
+            }
+
+    master.min(&fld_min, 1);
+    master.max(&fld_max, 1);
+
+    const TF centre = TF(0.5)*(fld_min + fld_max);
+    TF half_width = TF(0.75)*(fld_max - fld_min);
+    if (half_width == TF(0.))
+        half_width = std::max(std::abs(centre), TF(1.));
+
+    bins.min = centre - half_width;
+    bins.max = centre + half_width;
+    bins.is_set = true;
+
+    std::vector<TF> centres(nhistbins);
+    for (int n=0; n<nhistbins; ++n)
+        centres[n] = bins.min + (n + TF(0.5))*(bins.max - bins.min)/nhistbins;
+
+    for (auto& m : masks)
+        m.second.hist_bin_vars.at(varname + "_bin").insert(centres, {0});
+
+    return bins;
+}
+
+template<typename TF>
+void Stats<TF>::calc_stats_hist(
+        const std::string& varname, const Field3d<TF>& fld, const TF offset)
+{
+    if (std::find(histlist.begin(), histlist.end(), varname) == histlist.end())
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    unsigned int flag;
+    const int* nmask;
+
+    const Hist_bins& bins = get_hist_bins(varname, fld, offset);
+    const TF fac = nhistbins / (bins.max - bins.min);
+
+    for (auto& m : masks)
+    {
+        set_flag(flag, nmask, m.second, fld.loc[2]);
+        Prof_var<TF>& hist = m.second.hists.at(varname + "_hist");
+
+        calc_hist(
+                hist.data.data(), fld.fld.data(), offset, bins.min, fac, nhistbins,
+                mfield.data(), mfield_k.data(), flag, nmask,
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend+fld.loc[2], gd.icells, gd.ijcells);
 
-            set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+        sum_deferred_block(hist.data.data(), hist.data.size());
+    }
+}
+
+template<typename TF>
+void Stats<TF>::calc_joint_hist(
+        const std::string& varname_a, const Field3d<TF>& fld_a,
+        const std::string& varname_b, const Field3d<TF>& fld_b)
+{
+    const std::string name = varname_a + "_" + varname_b + "_hist";
+    if (std::find(varlist.begin(), varlist.end(), name) == varlist.end())
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    const Hist_bins& bins_a = get_hist_bins(varname_a, fld_a, TF(0.));
+    const Hist_bins& bins_b = get_hist_bins(varname_b, fld_b, TF(0.));
+
+    for (auto& m : masks)
+    {
+        Prof_var<TF>& hist = m.second.hists.at(name);
+
+        calc_hist_joint(
+                hist.data.data(),
+                fld_a.fld.data(), fld_a.loc, bins_a.min, nhistbins / (bins_a.max - bins_a.min),
+                fld_b.fld.data(), fld_b.loc, bins_b.min, nhistbins / (bins_b.max - bins_b.min),
+                nhistbins, mfield.data(), mfield_k.data(), m.second.flag, m.second.nmask.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
+
+        sum_deferred_block(hist.data.data(), hist.data.size());
+    }
+}
+
+#ifdef USECUDA
+template<typename TF>
+void Stats<TF>::calc_stats_hist_g(
+        const std::string& varname, const Field3d<TF>& fld, const TF offset)
+{
+    if (std::find(histlist.begin(), histlist.end(), varname) == histlist.end())
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    unsigned int flag;
+    const int* nmask;
+
+    // The range of adaptive bins follows from the host field, of which fld is a device copy.
+    const Hist_bins& bins = get_hist_bins(varname, *fields.ap.at(varname), offset);
+
+    for (auto& m : masks)
+    {
+        set_flag(flag, nmask, m.second, fld.loc[2]);
+        Prof_var<TF>& hist = m.second.hists.at(varname + "_hist");
+        const int kend = gd.kend + fld.loc[2];
+
+        calc_hist_sum_g(hist.data.data(), fld, offset, bins, nullptr, nullptr, flag, gd.kstart, kend);
+
+        for (int k=gd.kstart; k<kend; ++k)
+        {
+            const TF norm = nmask[k] ? TF(1.) / nmask[k] : TF(0.);
+            for (int n=0; n<nhistbins; ++n)
+                hist.data[(k-gd.kstart)*nhistbins + n] *= norm;
         }
+
+        sum_deferred_block(hist.data.data(), hist.data.size());
     }
 }
 
+template<typename TF>
+void Stats<TF>::calc_joint_hist_g(
+        const std::string& varname_a, const Field3d<TF>& fld_a,
+        const std::string& varname_b, const Field3d<TF>& fld_b)
+{
+    const std::string name = varname_a + "_" + varname_b + "_hist";
+    if (std::find(varlist.begin(), varlist.end(), name) == varlist.end())
+        return;
+
+    auto& gd = grid.get_grid_data();
+    const int nbins2 = nhistbins*nhistbins;
+
+    const Hist_bins& bins_a = get_hist_bins(varname_a, fld_a, TF(0.));
+    const Hist_bins& bins_b = get_hist_bins(varname_b, fld_b, TF(0.));
+
+    // As in calc_stats_g, the histograms are taken from device copies of the host fields.
+    auto snapshot_a = fields.get_tmp_g();
+    auto snapshot_b = fields.get_tmp_g();
+    snapshot_a->loc = fld_a.loc;
+    snapshot_b->loc = fld_b.loc;
+    cuda_copy(fld_a.fld.data(), snapshot_a->fld_g.data(), gd.ncells);
+    cuda_copy(fld_b.fld.data(), snapshot_b->fld_g.data(), gd.ncells);
+
+    for (auto& m : masks)
+    {
+        Prof_var<TF>& hist = m.second.hists.at(name);
+        const int* nmask = m.second.nmask.data();
+
+        calc_hist_sum_g(
+                hist.data.data(), *snapshot_a, TF(0.), bins_a, snapshot_b.get(), &bins_b,
+                m.second.flag, gd.kstart, gd.kend);
+
+        for (int k=gd.kstart; k<gd.kend; ++k)
+        {
+            const TF norm = nmask[k] ? TF(1.) / nmask[k] : TF(0.);
+            for (int n=0; n<nbins2; ++n)
+                hist.data[(k-gd.kstart)*nbins2 + n] *= norm;
+        }
+
+        sum_deferred_block(hist.data.data(), hist.data.size());
+    }
+
+    fields.release_tmp_g(snapshot_a);
+    fields.release_tmp_g(snapshot_b);
+}
+#endif
+
 template<typename TF>
 void Stats<TF>::calc_stats_2d(
         const std::string& varname,
@@ -1923,7 +2800,7 @@ void Stats<TF>::calc_covariance(
     std::string name = varname1 + "_" + std::to_string(power1) + "_" + varname2 + "_" + std::to_string(power2);
     unsigned int flag;
 
-    int* nmask;
+    const int* nmask;
 
     if (std::find(varlist.begin(), varlist.end(), name) != varlist.end())
     {
@@ -1939,7 +2816,7 @@ void Stats<TF>::calc_covariance(
                     {
                         fld1_mean[k] = m.second.profs.at(varname1).data[k];
                     }
-                    nmask = m.second.nmask.data();
+                    nmask = m.second.nmask_sub.data();
                 }
                 else
                 {
@@ -1952,18 +2829,17 @@ void Stats<TF>::calc_covariance(
                             fld1_mean[k] = netcdf_fp_fillvalue<TF>();
 
                     }
-                    nmask = m.second.nmaskh.data();
+                    nmask = m.second.nmaskh_sub.data();
                 }
 
                 calc_cov(
                         m.second.profs.at(name).data.data(), fld1.fld.data(), fld1_mean, offset1, power1,
                         fld2.fld.data(), m.second.profs.at(varname2).data.data(), offset2, power2,
-                        mfield.data(), flag, nmask,
-                        gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                        mfield.data(), mfield_k.data(), flag, nmask,
+                        gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, substride,
                         gd.icells, gd.ijcells);
 
-                master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-                set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+                sum_deferred(m.second.profs.at(name).data.data(), nmask);
             }
         }
         else
@@ -1979,23 +2855,23 @@ void Stats<TF>::calc_covariance(
                 if (fld2.loc[2] == 0)
                 {
                     flag = m.second.flag;
-                    nmask = m.second.nmask.data();
+                    nmask = m.second.nmask_sub.data();
                 }
                 else
                 {
                     flag = m.second.flagh;
-                    nmask = m.second.nmaskh.data();
+                    nmask = m.second.nmaskh_sub.data();
                 }
 
                 calc_cov(
                         m.second.profs.at(name).data.data(), tmp->fld.data(),
                         m.second.profs.at(varname1).data.data(), offset1, power1,
                         fld2.fld.data(), m.second.profs.at(varname2).data.data(), offset2, power2,
-                        mfield.data(), flag, nmask,
-                        gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                        mfield.data(), mfield_k.data(), flag, nmask,
+                        gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, substride,
                         gd.icells, gd.ijcells);
 
-                master.sum(m.second.profs.at(name).data.data(), gd.kcells);
+                sum_deferred(m.second.profs.at(name).data.data(), nullptr);
             }
 
             fields.release_tmp(tmp);
@@ -2107,7 +2983,7 @@ void Stats<TF>::calc_flux_4th(
 template<typename TF>
 void Stats<TF>::calc_grad_2nd(
         TF* const restrict prof, const TF* const restrict data, const TF* const restrict dzhi,
-        const unsigned int* const mask, const unsigned int flag, const int* const nmask,
+        const unsigned int* const mask, const unsigned int* const mask_k, const unsigned int flag, const int* const nmask,
         const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
         const int icells, const int ijcells)
 {
@@ -2117,13 +2993,16 @@ void Stats<TF>::calc_grad_2nd(
         if (nmask[k])
         {
             double tmp = 0.;
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*icells + k*ijcells;
-                    tmp += in_mask<double>(mask[ijk], flag)*(data[ijk]-data[ijk-ijcells])*dzhi[k];
-                }
+            if (mask_k[k] & flag)
+            {
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*icells + k*ijcells;
+                        tmp += in_mask<double>(mask[ijk], flag)*(data[ijk]-data[ijk-ijcells])*dzhi[k];
+                    }
+            }
 
             prof[k] = tmp / nmask[k];
         }
@@ -2133,7 +3012,7 @@ void Stats<TF>::calc_grad_2nd(
 template<typename TF>
 void Stats<TF>::calc_grad_4th(
         TF* const restrict prof, const TF* const restrict data, const TF* const restrict dzhi4,
-        const unsigned int* const mask, const unsigned int flag, const int* const nmask,
+        const unsigned int* const mask, const unsigned int* const mask_k, const unsigned int flag, const int* const nmask,
         const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
         const int icells, const int ijcells)
 {
@@ -2149,13 +3028,16 @@ void Stats<TF>::calc_grad_4th(
         if (nmask[k])
         {
             double tmp = 0.;
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk1;
-                    tmp += in_mask<double>(mask[ijk], flag)*(cg0<double>*data[ijk-kk2] + cg1<double>*data[ijk-kk1] + cg2<double>*data[ijk] + cg3<double>*data[ijk+kk1])*dzhi4[k];
-                }
+            if (mask_k[k] & flag)
+            {
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk1;
+                        tmp += in_mask<double>(mask[ijk], flag)*(cg0<double>*data[ijk-kk2] + cg1<double>*data[ijk-kk1] + cg2<double>*data[ijk] + cg3<double>*data[ijk+kk1])*dzhi4[k];
+                    }
+            }
 
             prof[k] = tmp / nmask[k];
         }
@@ -22,6 +22,7 @@
 
 #include <cstdio>
 #include <cmath>
+#include <stdexcept>
 #include "master.h"
 #include "grid.h"
 #include "fields.h"
@@ -38,6 +39,16 @@ template<typename TF>
 Thermo<TF>::Thermo(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin, Input& input) :
     master(masterin), grid(gridin), fields(fieldsin)
 {
+    sw_fuse_buoyancy = input.get_item<bool>("thermo", "swfusebuoyancy", "", false);
+    if (sw_fuse_buoyancy)
+    {
+        #ifdef USECUDA
+        throw std::runtime_error("swfusebuoyancy=true is not (yet) implemented on the GPU");
+        #endif
+
+        if (grid.get_spatial_order() != Grid_order::Second)
+            throw std::runtime_error("swfusebuoyancy=true requires swspatialorder=2");
+    }
 }
 
 template<typename TF>
@@ -355,7 +355,7 @@ void Thermo_buoy<TF>::exec(const double dt, Stats<TF>& stats)
             calc_buoyancy_tend_w_2nd(fields.mt.at("w")->fld.data(), fields.sp.at("b")->fld.data(), bs.alpha, gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
             calc_buoyancy_tend_b_2nd(fields.st.at("b")->fld.data(), fields.mp.at("u")->fld.data(), fields.mp.at("w")->fld.data(), bs.alpha, bs.n2, gd.utrans, gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
         }
-        else
+        else if (!do_fused_buoyancy(stats))
         {
             calc_buoyancy_tend_2nd(fields.mt.at("w")->fld.data(), fields.sp.at("b")->fld.data(), gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
         }
@@ -392,6 +392,29 @@ void Thermo_buoy<TF>::exec(const double dt, Stats<TF>& stats)
 }
 #endif
 
+template<typename TF>
+bool Thermo_buoy<TF>::do_fused_buoyancy(const Stats<TF>& stats) const
+{
+    // A sloped domain or a background stratification adds buoyancy to u and b as well.
+    return sw_fuse_buoyancy && !(bs.has_slope || bs.has_N2) && !stats.is_doing_tendency();
+}
+
+template<typename TF>
+void Thermo_buoy<TF>::calc_buoyancy_plane_w(TF* const restrict bh, TF* const restrict work, const int k) const
+{
+    auto& gd = grid.get_grid_data();
+    const TF* const restrict b = fields.sp.at("b")->fld.data();
+
+    for (int j=gd.jstart; j<gd.jend; ++j)
+        #pragma ivdep
+        for (int i=gd.istart; i<gd.iend; ++i)
+        {
+            const int ij  = i + j*gd.icells;
+            const int ijk = ij + k*gd.ijcells;
+            bh[ij] = interp2(b[ijk-gd.ijcells], b[ijk]);
+        }
+}
+
 template<typename TF>
 unsigned long Thermo_buoy<TF>::get_time_limit(unsigned long idt, const double dt)
 {
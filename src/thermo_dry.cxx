@@ -462,9 +462,11 @@ void Thermo_dry<TF>::exec( const double dt, Stats<TF>& stats)
 
     if (grid.get_spatial_order() == Grid_order::Second)
     {
-        calc_buoyancy_tend_2nd(fields.mt.at("w")->fld.data(), fields.sp.at("th")->fld.data(), bs.threfh.data(),
-                               gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                               gd.icells, gd.ijcells);
+        // The fused buoyancy is added by the advection of w.
+        if (!do_fused_buoyancy(stats))
+            calc_buoyancy_tend_2nd(fields.mt.at("w")->fld.data(), fields.sp.at("th")->fld.data(), bs.threfh.data(),
+                                   gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                                   gd.icells, gd.ijcells);
 
         if (swbaroclinic)
             calc_baroclinic_2nd(
@@ -491,6 +493,31 @@ void Thermo_dry<TF>::exec( const double dt, Stats<TF>& stats)
 }
 #endif
 
+template<typename TF>
+bool Thermo_dry<TF>::do_fused_buoyancy(const Stats<TF>& stats) const
+{
+    return sw_fuse_buoyancy && !stats.is_doing_tendency();
+}
+
+template<typename TF>
+void Thermo_dry<TF>::calc_buoyancy_plane_w(TF* const restrict b, TF* const restrict work, const int k) const
+{
+    using Finite_difference::O2::interp2;
+
+    auto& gd = grid.get_grid_data();
+    const TF* const restrict th = fields.sp.at("th")->fld.data();
+    const TF* const restrict threfh = bs.threfh.data();
+
+    for (int j=gd.jstart; j<gd.jend; ++j)
+        #pragma ivdep
+        for (int i=gd.istart; i<gd.iend; ++i)
+        {
+            const int ij  = i + j*gd.icells;
+            const int ijk = ij + k*gd.ijcells;
+            b[ij] = grav<TF>/threfh[k] * (interp2(th[ijk-gd.ijcells], th[ijk]) - threfh[k]);
+        }
+}
+
 template<typename TF>
 void Thermo_dry<TF>::update_time_dependent(Timeloop<TF>& timeloop)
 {
@@ -787,6 +814,9 @@ void Thermo_dry<TF>::exec_dump(Dump<TF>& dump, unsigned long iotime)
 
     for (auto& it : dumplist)
     {
+        if (!dump.do_dump_var(it))
+            continue;
+
         if (it == "b")
             get_thermo_field(*output, "b", false, true);
         else if (it == "T")
@@ -32,6 +32,8 @@
 #include "column.h"
 #include "stats.h"
 #include "thermo_moist_functions.h"
+#include "thermo_moist_kernels.cuh"
+#include "cuda_launcher.h"
 #include <iostream>
 
 namespace
@@ -39,140 +41,7 @@ namespace
     using namespace Constants;
     using namespace Finite_difference::O2;
     using namespace Thermo_moist_functions;
-
-    template<typename TF>
-    inline __device__ Struct_sat_adjust<TF> sat_adjust_g(
-            const TF thl, const TF qt, const TF p, const TF exn)
-    {
-        using Fast_math::pow2;
-
-        int niter = 0;
-        const int nitermax = 10;
-
-        TF tnr_old = TF(1.e9);
-
-        const TF tl = thl * exn;
-        TF qs = qsat_liq(p, tl);
-
-        Struct_sat_adjust<TF> ans =
-        {
-            TF(0.), // ql
-            TF(0.), // qi
-            tl, // t
-            qs, // qs
-        };
-
-        // Calculate if q-qs(Tl) <= 0. If so, return 0. Else continue with saturation adjustment.
-        if (qt-ans.qs <= TF(0.))
-            return ans;
-
-        /* Saturation adjustment solver.
-         * Root finding function is f(T) = T - tnr - Lv/cp*qt + alpha_w * Lv/cp*qs(T) + alpha_i*Ls/cp*qs(T)
-         * dq_sat/dT derivatives can be rewritten using Claussius-Clapeyron (desat/dT = L{v,s}*esat / (Rv*T^2)).
-         */
-
-        TF tnr = tl;
-
-        // Warm adjustment.
-        if (tl >= T0<TF>)
-        {
-            while (fabs(tnr-tnr_old)/tnr_old > TF(1.e-5) && niter < nitermax)
-            {
-                tnr_old = tnr;
-                qs = qsat_liq(p, tnr);
-                const TF f =
-                    tnr - tl - Lv<TF>/cp<TF>*(qt - qs);
-
-                const TF f_prime = TF(1.) + Lv<TF>/cp<TF>*dqsatdT_liq(p, tnr);
-
-                tnr -= f / f_prime;
-
-                niter += 1;
-            }
-
-            qs = qsat_liq(p, tnr);
-            ans.ql = fmax(TF(0.), qt - qs);
-            ans.t  = tnr;
-            ans.qs = qs;
-        }
-        // Cold adjustment.
-        else
-        {
-            while (fabs(tnr-tnr_old)/tnr_old > TF(1.e-5) && niter < nitermax)
-            {
-                tnr_old = tnr;
-                qs = qsat(p, tnr);
-                const TF alpha_w = water_fraction(tnr);
-                const TF alpha_i = TF(1.) - alpha_w;
-                const TF dalphadT = (alpha_w > TF(0.) && alpha_w < TF(1.)) ? TF(0.025) : TF(0.);
-                const TF dqsatdT_w = dqsatdT_liq(p, tnr);
-                const TF dqsatdT_i = dqsatdT_ice(p, tnr);
-
-                const TF f =
-                    tnr - tl - alpha_w*Lv<TF>/cp<TF>*qt - alpha_i*Ls<TF>/cp<TF>*qt
-                             + alpha_w*Lv<TF>/cp<TF>*qs + alpha_i*Ls<TF>/cp<TF>*qs;
-
-                const TF f_prime = TF(1.)
-                    - dalphadT*Lv<TF>/cp<TF>*qt + dalphadT*Ls<TF>/cp<TF>*qt
-                    + dalphadT*Lv<TF>/cp<TF>*qs - dalphadT*Ls<TF>/cp<TF>*qs
-                    + alpha_w*Lv<TF>/cp<TF>*dqsatdT_w
-                    + alpha_i*Ls<TF>/cp<TF>*dqsatdT_i;
-
-                tnr -= f / f_prime;
-
-                niter += 1;
-            }
-
-            const TF alpha_w = water_fraction(tnr);
-            const TF alpha_i = TF(1.) - alpha_w;
-
-            qs = qsat(p, tnr);
-            const TF qlqi = fmax(TF(0.), qt - qs);
-
-            ans.ql = alpha_w*qlqi;
-            ans.qi = alpha_i*qlqi;
-            ans.t  = tnr;
-            ans.qs = qs;
-        }
-
-        // Raise exception if nitermax is reached.
-        if (niter == nitermax)
-        {
-            printf("ERROR: saturation adjustment did not converge: thl=%f, qt=%f, p=%f\n", thl, qt, p);
-            asm("trap;");
-        }
-
-        return ans;
-    }
-
-    template<typename TF> __global__
-    void calc_buoyancy_tend_2nd_g(TF* __restrict__ wt, TF* __restrict__ th, TF* __restrict__ qt,
-                                  TF* __restrict__ thvrefh, TF* __restrict__ exnh, TF* __restrict__ ph,
-                                  int istart, int jstart, int kstart,
-                                  int iend,   int jend,   int kend,
-                                  int jj, int kk)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj + k*kk;
-
-            // Half level temperature and moisture content
-            const TF thh = static_cast<TF>(0.5) * (th[ijk-kk] + th[ijk]); // Half level liq. water pot. temp.
-            const TF qth = static_cast<TF>(0.5) * (qt[ijk-kk] + qt[ijk]); // Half level specific hum.
-
-            Struct_sat_adjust<TF> ssa = sat_adjust_g(thh, qth, ph[k], exnh[k]);
-
-            // Calculate tendency.
-            if (ssa.ql + ssa.qi > 0)
-                wt[ijk] += buoyancy(exnh[k], thh, qth, ssa.ql, ssa.qi, thvrefh[k]);
-            else
-                wt[ijk] += buoyancy_no_ql(thh, qth, thvrefh[k]);
-        }
-    }
+    using namespace Thermo_moist_kernels;
 
     template<typename TF> __global__
     void calc_buoyancy_g(TF* __restrict__ b,  TF* __restrict__ th,
@@ -313,24 +182,6 @@ namespace
         }
     }
 
-    template<typename TF> __global__
-    void calc_liquid_water_g(TF* __restrict__ ql, TF* __restrict__ th, TF* __restrict__ qt,
-                             TF* __restrict__ exn, TF* __restrict__ p,
-                             int istart, int jstart, int kstart,
-                             int iend,   int jend,   int kend,
-                             int jj, int kk)
-    {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj + k*kk;
-            ql[ijk] = sat_adjust_g(th[ijk], qt[ijk], p[k], exn[k]).ql;
-        }
-    }
-
     template<typename TF> __global__
     void calc_liquid_and_ice_g(
             TF* __restrict__ qlqi,
@@ -912,18 +763,22 @@ void Thermo_moist<TF>::exec(const double dt, Stats<TF>& stats)
     dim3 blockGPU(blocki, blockj, 1);
 
     // Re-calculate hydrostatic pressure and exner
-    if (bs.swupdatebasestate)
+    // BvS: Calculating hydrostatic pressure on GPU is extremely slow. As temporary solution, copy back mean profiles to host,
+    //      calculate pressure there and copy back the required profiles. This synchronization is limited to the iterations
+    //      of basestateinterval.
+    if (bs.swupdatebasestate && basestate_iteration % basestate_interval == 0)
+    {
+        cudaMemcpy(fields.sp.at("thl")->fld_mean.data(), fields.sp.at("thl")->fld_mean_g, gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
+        cudaMemcpy(fields.sp.at("qt")->fld_mean.data(),  fields.sp.at("qt")->fld_mean_g,  gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
+    }
+
+    if (do_update_basestate())
     {
         //calc_hydrostatic_pressure<TF><<<1, 1>>>(bs.pref_g, bs.prefh_g, bs.exnref_g, bs.exnrefh_g,
         //                                        fields.sp.at("thl")->fld_mean_g, fields.sp.at("qt")->fld_mean_g,
         //                                        gd.z_g, gd.dz_g, gd.dzh_g, bs.pbot, gd.kstart, gd.kend);
         //cuda_check_error();
 
-        // BvS: Calculating hydrostatic pressure on GPU is extremely slow. As temporary solution, copy back mean profiles to host,
-        //      calculate pressure there and copy back the required profiles.
-        cudaMemcpy(fields.sp.at("thl")->fld_mean.data(), fields.sp.at("thl")->fld_mean_g, gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
-        cudaMemcpy(fields.sp.at("qt")->fld_mean.data(),  fields.sp.at("qt")->fld_mean_g,  gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
-
         auto tmp = fields.get_tmp();
 
         calc_base_state(
@@ -938,21 +793,30 @@ void Thermo_moist<TF>::exec(const double dt, Stats<TF>& stats)
 
         fields.release_tmp(tmp);
 
+        thl_mean_basestate = fields.sp.at("thl")->fld_mean;
+        qt_mean_basestate = fields.sp.at("qt")->fld_mean;
+
         // Copy basestate back to GPU.
         forward_device();
     }
 
-    calc_buoyancy_tend_2nd_g<TF><<<gridGPU, blockGPU>>>(
-            fields.mt.at("w")->fld_g,
+    // The buoyancy tendency is zero at the surface.
+    Grid_layout grid_layout = {
+            gd.istart, gd.iend,
+            gd.jstart, gd.jend,
+            gd.kstart+1, gd.kend,
+            gd.istride,
+            gd.jstride,
+            gd.kstride};
+
+    launch_grid_kernel<Thermo_moist_kernels::calc_buoyancy_tend_2nd_g<TF>>(
+            grid_layout,
+            fields.mt.at("w")->fld_g.view(),
             fields.sp.at("thl")->fld_g,
             fields.sp.at("qt")->fld_g,
             bs.thvrefh_g,
             bs.exnrefh_g,
-            bs.prefh_g,
-            gd.istart, gd.jstart, gd.kstart+1,
-            gd.iend,   gd.jend,   gd.kend,
-            gd.icells, gd.ijcells);
-    cuda_check_error();
+            bs.prefh_g);
 
     cudaDeviceSynchronize();
     stats.calc_tend(*fields.mt.at("w"), tend_name);
@@ -976,18 +840,22 @@ void Thermo_moist<TF>::get_thermo_field_g(
     dim3 blockGPU2(blocki, blockj, 1);
 
     // BvS: getthermofield() is called from subgrid-model, before thermo(), so re-calculate the hydrostatic pressure
-    if (bs.swupdatebasestate && (name != "N2"))
+    // BvS: Calculating hydrostatic pressure on GPU is extremely slow. As temporary solution, copy back mean profiles to host,
+    //      calculate pressure there and copy back the required profiles.
+    const bool check_basestate = bs.swupdatebasestate && (name != "N2") && (basestate_iteration % basestate_interval == 0);
+    if (check_basestate)
+    {
+        cudaMemcpy(fields.sp.at("thl")->fld_mean.data(), fields.sp.at("thl")->fld_mean_g, gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
+        cudaMemcpy(fields.sp.at("qt")->fld_mean.data(),  fields.sp.at("qt")->fld_mean_g,  gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
+    }
+
+    if (check_basestate && do_update_basestate())
     {
         //calc_hydrostatic_pressure_g<TF><<<1, 1>>>(bs.pref_g, bs.prefh_g, bs.exnref_g, bs.exnrefh_g,
         //                                          fields.sp.at("thl")->fld_mean_g, fields.sp.at("qt")->fld_mean_g,
         //                                          gd.z_g, gd.dz_g, gd.dzh_g, bs.pbot, gd.kstart, gd.kend);
         //cuda_check_error();
 
-        // BvS: Calculating hydrostatic pressure on GPU is extremely slow. As temporary solution, copy back mean profiles to host,
-        //      calculate pressure there and copy back the required profiles.
-        cudaMemcpy(fields.sp.at("thl")->fld_mean.data(), fields.sp.at("thl")->fld_mean_g, gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
-        cudaMemcpy(fields.sp.at("qt")->fld_mean.data(),  fields.sp.at("qt")->fld_mean_g,  gd.kcells*sizeof(TF), cudaMemcpyDeviceToHost);
-
         auto tmp = fields.get_tmp();
 
         calc_base_state(
@@ -1028,13 +896,18 @@ void Thermo_moist<TF>::get_thermo_field_g(
     }
     else if (name == "ql")
     {
-        calc_liquid_water_g<TF><<<gridGPU2, blockGPU2>>>(
-            fld.fld_g, fields.sp.at("thl")->fld_g, fields.sp.at("qt")->fld_g,
-            bs.exnref_g, bs.pref_g,
-            gd.istart,  gd.jstart,  gd.kstart,
-            gd.iend,    gd.jend,    gd.kend,
-            gd.icells, gd.ijcells);
-        cuda_check_error();
+        Grid_layout grid_layout = {
+                gd.istart, gd.iend,
+                gd.jstart, gd.jend,
+                gd.kstart, gd.kend,
+                gd.istride,
+                gd.jstride,
+                gd.kstride};
+
+        launch_grid_kernel<Thermo_moist_kernels::calc_liquid_water_g<TF>>(
+                grid_layout,
+                fld.fld_g.view(), fields.sp.at("thl")->fld_g, fields.sp.at("qt")->fld_g,
+                bs.exnref_g, bs.pref_g);
     }
     else if (name == "ql_h")
     {
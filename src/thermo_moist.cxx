@@ -99,14 +99,10 @@ namespace
                 }
 
             for (int j=jstart; j<jend; j++)
-                #pragma ivdep
-                for (int i=istart; i<iend; i++)
-                {
-                    const int ij  = i + j*jj;
-                    Struct_sat_adjust<TF> ssa = sat_adjust(thlh[ij], qth[ij], ph[k], exnh);
-                    ql[ij] = ssa.ql;
-                    qi[ij] = ssa.qi;
-                }
+            {
+                const int ij = istart + j*jj;
+                sat_adjust_row(&ql[ij], &qi[ij], &thlh[ij], &qth[ij], ph[k], exnh, iend-istart);
+            }
 
             for (int j=jstart; j<jend; j++)
                 #pragma ivdep
@@ -135,14 +131,10 @@ namespace
             if (k >= kstart && k < kend)
             {
                 for (int j=jstart; j<jend; j++)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; i++)
-                    {
-                        const int ijk = i + j*jj + k*kk;
-                        Struct_sat_adjust<TF> ssa = sat_adjust(thl[ijk], qt[ijk], p[k], ex);
-                        ql[ijk] = ssa.ql;
-                        qi[ijk] = ssa.qi;
-                    }
+                {
+                    const int ijk = istart + j*jj + k*kk;
+                    sat_adjust_row(&ql[ijk], &qi[ijk], &thl[ijk], &qt[ijk], p[k], ex, iend-istart);
+                }
             }
             else
             {
@@ -195,14 +187,10 @@ namespace
                     }
 
                 for (int j=jstart; j<jend; j++)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; i++)
-                    {
-                        const int ij  = i + j*jj;
-                        Struct_sat_adjust<TF> ssa = sat_adjust(thlh[ij], qth[ij], ph[k], exnh);
-                        ql[ij] = ssa.ql;
-                        qi[ij] = ssa.qi;
-                    }
+                {
+                    const int ij = istart + j*jj;
+                    sat_adjust_row(&ql[ij], &qi[ij], &thlh[ij], &qth[ij], ph[k], exnh, iend-istart);
+                }
             }
             else
             {
@@ -474,6 +462,73 @@ namespace
                 }
     }
 
+    template<typename TF>
+    void calc_saturation_adjust_fields(
+            TF* const restrict ql, TF* const restrict qi, TF* const restrict qs, TF* const restrict T,
+            const TF* const restrict thl, const TF* const restrict qt, const TF* const restrict p,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        // Store all outputs of a single saturation adjustment, so that the
+        // derived fields can be served without repeating the Newton iteration.
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+        {
+            const TF ex = exner(p[k]);
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const Struct_sat_adjust<TF> ssa = sat_adjust(thl[ijk], qt[ijk], p[k], ex);
+                    ql[ijk] = ssa.ql;
+                    qi[ijk] = ssa.qi;
+                    qs[ijk] = ssa.qs;
+                    T [ijk] = ssa.t;
+                }
+        }
+    }
+
+    template<typename TF>
+    void calc_condensate_from_qs(
+            TF* const restrict qc, const TF* const restrict qt, const TF* const restrict qs,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    qc[ijk] = std::max(qt[ijk] - qs[ijk], TF(0.));
+                }
+    }
+
+    template<typename TF>
+    void calc_relative_humidity_from_qs(
+            TF* const restrict rh, const TF* const restrict qt, const TF* const restrict qs,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        #pragma omp parallel for
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    rh[ijk] = std::min(qt[ijk] / qs[ijk], TF(1.));
+                }
+    }
+
     template<typename TF>
     void calc_T(TF* const restrict T, const TF* const restrict thl, const TF* const restrict qt,
                 const TF* const restrict pref, const TF* const restrict exnref,
@@ -1123,6 +1178,37 @@ Thermo_moist<TF>::Thermo_moist(Master& masterin, Grid<TF>& gridin, Fields<TF>& f
     // swupdate..=1 -> base state pressure updated before saturation calculation
     bs.swupdatebasestate = inputin.get_item<bool>("thermo", "swupdatebasestate", "", true);
 
+    // Update the base state only every basestateinterval iterations, and then only if the mean
+    // thl or qt profile changed more than its tolerance. The defaults update every iteration.
+    if (bs.swupdatebasestate)
+    {
+        basestate_interval = inputin.get_item<int>("thermo", "basestateinterval", "", 1);
+        basestate_tol_thl = inputin.get_item<TF>("thermo", "basestatetolthl", "", 0);
+        basestate_tol_qt = inputin.get_item<TF>("thermo", "basestatetolqt", "", 0);
+
+        if (basestate_interval < 1)
+            throw std::runtime_error("The basestateinterval has to be at least one iteration");
+    }
+    else
+    {
+        inputin.flag_as_used("thermo", "basestateinterval", "");
+        inputin.flag_as_used("thermo", "basestatetolthl", "");
+        inputin.flag_as_used("thermo", "basestatetolqt", "");
+
+        basestate_interval = 1;
+        basestate_tol_thl = TF(0.);
+        basestate_tol_qt = TF(0.);
+    }
+    basestate_iteration = 0;
+
+    // Keep the saturation adjustment of the current substep, so that repeated
+    // requests for ql, qi, qsat, rh, or T do not redo the Newton iteration.
+    swsatadjustcache = inputin.get_item<bool>("thermo", "swsatadjustcache", "", false);
+    sat_adjust_cache_valid = false;
+
+    // Compute the derived fields of an output step only once for all output modules.
+    swoutputcache = inputin.get_item<bool>("thermo", "swoutputcache", "", false);
+
     // Time variable surface pressure
     tdep_pbot = std::make_unique<Timedep<TF>>(master, grid, "p_sbot", inputin.get_item<bool>("thermo", "swtimedep_pbot", "", false));
 
@@ -1420,7 +1506,7 @@ void Thermo_moist<TF>::exec(const double dt, Stats<TF>& stats)
 
     // Re-calculate hydrostatic pressure and exner, pass dummy as thvref to prevent overwriting base state
     auto tmp = fields.get_tmp();
-    if (bs.swupdatebasestate)
+    if (do_update_basestate())
     {
         calc_base_state(
                 bs.pref.data(), bs.prefh.data(),
@@ -1431,15 +1517,20 @@ void Thermo_moist<TF>::exec(const double dt, Stats<TF>& stats)
                 fields.sp.at("qt")->fld_mean.data(),
                 bs.pbot, gd.kstart, gd.kend,
                 gd.z.data(), gd.dz.data(), gd.dzh.data());
+
+        thl_mean_basestate = fields.sp.at("thl")->fld_mean;
+        qt_mean_basestate = fields.sp.at("qt")->fld_mean;
     }
 
     // extend later for gravity vector not normal to surface
-    calc_buoyancy_tend_2nd(
-            fields.mt.at("w")->fld.data(), fields.sp.at("thl")->fld.data(), fields.sp.at("qt")->fld.data(), bs.prefh.data(),
-            &tmp->fld[0*gd.ijcells], &tmp->fld[1*gd.ijcells],
-            &tmp->fld[2*gd.ijcells], &tmp->fld[3*gd.ijcells], bs.thvrefh.data(),
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+    // The fused buoyancy is added by the advection of w.
+    if (!do_fused_buoyancy(stats))
+        calc_buoyancy_tend_2nd(
+                fields.mt.at("w")->fld.data(), fields.sp.at("thl")->fld.data(), fields.sp.at("qt")->fld.data(), bs.prefh.data(),
+                &tmp->fld[0*gd.ijcells], &tmp->fld[1*gd.ijcells],
+                &tmp->fld[2*gd.ijcells], &tmp->fld[3*gd.ijcells], bs.thvrefh.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
 
     fields.release_tmp(tmp);
 
@@ -1447,6 +1538,51 @@ void Thermo_moist<TF>::exec(const double dt, Stats<TF>& stats)
 }
 #endif
 
+template<typename TF>
+bool Thermo_moist<TF>::do_fused_buoyancy(const Stats<TF>& stats) const
+{
+    return sw_fuse_buoyancy && !stats.is_doing_tendency();
+}
+
+template<typename TF>
+void Thermo_moist<TF>::calc_buoyancy_plane_w(TF* const restrict b, TF* const restrict work, const int k) const
+{
+    auto& gd = grid.get_grid_data();
+    const TF* const restrict thl = fields.sp.at("thl")->fld.data();
+    const TF* const restrict qt = fields.sp.at("qt")->fld.data();
+
+    // The saturation adjustment at the half level works on rows of the planes in `work`.
+    TF* const restrict thlh = &work[0*gd.ijcells];
+    TF* const restrict qth  = &work[1*gd.ijcells];
+    TF* const restrict ql   = &work[2*gd.ijcells];
+    TF* const restrict qi   = &work[3*gd.ijcells];
+
+    const TF exnh = exner(bs.prefh[k]);
+    for (int j=gd.jstart; j<gd.jend; ++j)
+        #pragma ivdep
+        for (int i=gd.istart; i<gd.iend; ++i)
+        {
+            const int ij  = i + j*gd.icells;
+            const int ijk = ij + k*gd.ijcells;
+            thlh[ij] = interp2(thl[ijk-gd.ijcells], thl[ijk]);
+            qth[ij]  = interp2(qt[ijk-gd.ijcells], qt[ijk]);
+        }
+
+    for (int j=gd.jstart; j<gd.jend; ++j)
+    {
+        const int ij = gd.istart + j*gd.icells;
+        sat_adjust_row(&ql[ij], &qi[ij], &thlh[ij], &qth[ij], bs.prefh[k], exnh, gd.iend-gd.istart);
+    }
+
+    for (int j=gd.jstart; j<gd.jend; ++j)
+        #pragma ivdep
+        for (int i=gd.istart; i<gd.iend; ++i)
+        {
+            const int ij = i + j*gd.icells;
+            b[ij] = buoyancy(exnh, thlh[ij], qth[ij], ql[ij], qi[ij], bs.thvrefh[k]);
+        }
+}
+
 template<typename TF>
 unsigned long Thermo_moist<TF>::get_time_limit(unsigned long idt, const double dt)
 {
@@ -1490,8 +1626,7 @@ void Thermo_moist<TF>::get_mask(Stats<TF>& stats, std::string mask_name)
         get_thermo_field(*b, "b", true, true);
         get_thermo_field(*bh, "b_h", true, true);
 
-        field3d_operators.calc_mean_profile(b->fld_mean.data(), b->fld.data());
-        field3d_operators.calc_mean_profile(bh->fld_mean.data(), bh->fld.data());
+        field3d_operators.calc_mean_profiles({b->fld_mean.data(), bh->fld_mean.data()}, {b->fld.data(), bh->fld.data()});
         field3d_operators.subtract_mean_profile(b->fld.data(), b->fld_mean.data());
         field3d_operators.subtract_mean_profile(bh->fld.data(), bh->fld_mean.data());
 
@@ -1508,8 +1643,7 @@ void Thermo_moist<TF>::get_mask(Stats<TF>& stats, std::string mask_name)
         get_thermo_field(*b, "b", true, true);
         get_thermo_field(*bh, "b_h", true, true);
 
-        field3d_operators.calc_mean_profile(b->fld_mean.data(), b->fld.data());
-        field3d_operators.calc_mean_profile(bh->fld_mean.data(), bh->fld.data());
+        field3d_operators.calc_mean_profiles({b->fld_mean.data(), bh->fld_mean.data()}, {b->fld.data(), bh->fld.data()});
         field3d_operators.subtract_mean_profile(b->fld.data(), b->fld_mean.data());
         field3d_operators.subtract_mean_profile(bh->fld.data(), bh->fld_mean.data());
 
@@ -1551,11 +1685,135 @@ template<typename TF>
 void Thermo_moist<TF>::update_time_dependent(Timeloop<TF>& timeloop)
 {
     tdep_pbot->update_time_dependent(bs.pbot, timeloop);
+
+    // The interval of the base state updates is counted in iterations, not in substeps.
+    basestate_iteration = timeloop.get_iteration();
+
+    // Every substep starts with new prognostic fields.
+    #pragma omp critical (thermo_moist_sat_adjust_cache)
+    sat_adjust_cache_valid = false;
+
+    clear_output_cache();
+}
+
+template<typename TF>
+bool Thermo_moist<TF>::do_update_basestate()
+{
+    if (!bs.swupdatebasestate || basestate_iteration % basestate_interval != 0)
+        return false;
+
+    if ((basestate_tol_thl <= TF(0.) && basestate_tol_qt <= TF(0.)) || thl_mean_basestate.empty())
+        return true;
+
+    // The mean profiles are identical on all processes, such that they take the same decision.
+    auto& gd = grid.get_grid_data();
+    const std::vector<TF>& thl_mean = fields.sp.at("thl")->fld_mean;
+    const std::vector<TF>& qt_mean = fields.sp.at("qt")->fld_mean;
+
+    for (int k=gd.kstart; k<gd.kend; ++k)
+        if (std::abs(thl_mean[k] - thl_mean_basestate[k]) > basestate_tol_thl
+                || std::abs(qt_mean[k] - qt_mean_basestate[k]) > basestate_tol_qt)
+            return true;
+
+    return false;
+}
+
+template<typename TF>
+void Thermo_moist<TF>::clear_output_cache()
+{
+    #pragma omp critical (thermo_moist_output_cache)
+    {
+        for (auto& it : output_cache)
+            fields.release_tmp(it.second);
+        output_cache.clear();
+    }
+}
+
+template<typename TF>
+bool Thermo_moist<TF>::get_cached_thermo_field(Field3d<TF>& fld, const std::string& name, const TF* const pref)
+{
+    if (name != "ql" && name != "qi" && name != "qlqi" && name != "qsat" && name != "rh" && name != "T")
+        return false;
+
+    auto& gd = grid.get_grid_data();
+
+    // The statistics task can overlap with the main thread, protect the cache.
+    #pragma omp critical (thermo_moist_sat_adjust_cache)
+    {
+        if (!sat_adjust_cache_valid)
+        {
+            sat_adjust_cache_ql.resize(gd.ncells);
+            sat_adjust_cache_qi.resize(gd.ncells);
+            sat_adjust_cache_qs.resize(gd.ncells);
+            sat_adjust_cache_T .resize(gd.ncells);
+
+            calc_saturation_adjust_fields(
+                    sat_adjust_cache_ql.data(), sat_adjust_cache_qi.data(),
+                    sat_adjust_cache_qs.data(), sat_adjust_cache_T.data(),
+                    fields.sp.at("thl")->fld.data(), fields.sp.at("qt")->fld.data(), pref,
+                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
+
+            sat_adjust_cache_valid = true;
+        }
+
+        if (name == "qlqi")
+            calc_condensate_from_qs(
+                    fld.fld.data(), fields.sp.at("qt")->fld.data(), sat_adjust_cache_qs.data(),
+                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
+        else if (name == "rh")
+            calc_relative_humidity_from_qs(
+                    fld.fld.data(), fields.sp.at("qt")->fld.data(), sat_adjust_cache_qs.data(),
+                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
+        else
+        {
+            const std::vector<TF>& cache =
+                    (name == "ql")   ? sat_adjust_cache_ql :
+                    (name == "qi")   ? sat_adjust_cache_qi :
+                    (name == "qsat") ? sat_adjust_cache_qs : sat_adjust_cache_T;
+
+            std::copy(cache.begin() + gd.kstart*gd.ijcells, cache.begin() + gd.kend*gd.ijcells,
+                      fld.fld.begin() + gd.kstart*gd.ijcells);
+        }
+    }
+
+    return true;
 }
 
 template<typename TF>
 void Thermo_moist<TF>::get_thermo_field(
         Field3d<TF>& fld, const std::string& name, const bool cyclic, const bool is_stat)
+{
+    // The output modules share the derived fields of the output step. The surface flux
+    // of thv is a 2D field, and is cheap enough to be calculated on every request.
+    if (!swoutputcache || !is_stat || name == "thv_fluxbot")
+    {
+        calc_thermo_field(fld, name, cyclic, is_stat);
+        return;
+    }
+
+    // The statistics task can overlap with the main thread, protect the cache.
+    #pragma omp critical (thermo_moist_output_cache)
+    {
+        auto it = output_cache.find(name);
+        if (it == output_cache.end())
+        {
+            calc_thermo_field(fld, name, false, is_stat);
+
+            auto cached = fields.get_tmp();
+            std::copy(fld.fld.begin(), fld.fld.end(), cached->fld.begin());
+            output_cache.emplace(name, cached);
+        }
+        else
+            std::copy(it->second->fld.begin(), it->second->fld.end(), fld.fld.begin());
+    }
+
+    if (cyclic)
+        boundary_cyclic.exec(fld.fld.data());
+}
+
+template<typename TF>
+void Thermo_moist<TF>::calc_thermo_field(
+        Field3d<TF>& fld, const std::string& name, const bool cyclic, const bool is_stat)
 {
     auto& gd = grid.get_grid_data();
 
@@ -1567,7 +1825,7 @@ void Thermo_moist<TF>::get_thermo_field(
 
     // BvS: get_thermo_field() is called from subgrid-model, before thermo(), so re-calculate the hydrostatic pressure
     // Pass dummy as rhoref,bs.thvref to prevent overwriting base state
-    if (bs.swupdatebasestate)
+    if (do_update_basestate())
     {
         auto tmp = fields.get_tmp();
         calc_base_state(base.pref.data(), base.prefh.data(), &tmp->fld[0*gd.kcells], &tmp->fld[1*gd.kcells], &tmp->fld[2*gd.kcells],
@@ -1576,6 +1834,14 @@ void Thermo_moist<TF>::get_thermo_field(
         fields.release_tmp(tmp);
     }
 
+    // Serve the fields that derive from the saturation adjustment of this substep.
+    if (swsatadjustcache && !is_stat && get_cached_thermo_field(fld, name, base.pref.data()))
+    {
+        if (cyclic)
+            boundary_cyclic.exec(fld.fld.data());
+        return;
+    }
+
     if (name == "b")
     {
         auto tmp  = fields.get_tmp();
@@ -1884,6 +2150,18 @@ TF Thermo_moist<TF>::get_db_ref() const
 
 
 
+template<typename TF>
+void Thermo_moist<TF>::get_checkpoint_data(std::vector<std::vector<TF>*>& state)
+{
+    // The same base state and surface values as in the restart files.
+    if (bs.swupdatebasestate)
+        state.insert(state.end(), {
+                &bs.thl0, &bs.qt0, &bs.thvref, &bs.thvrefh, &bs.pref, &bs.prefh,
+                &bs.exnref, &bs.exnrefh, &bs.rhoref, &bs.rhorefh});
+
+    state.insert(state.end(), {&fields.sp.at("thl")->fld_bot, &fields.sp.at("qt")->fld_bot});
+}
+
 template<typename TF>
 void Thermo_moist<TF>::get_prog_vars(std::vector<std::string>& list)
 {
@@ -2401,6 +2679,9 @@ void Thermo_moist<TF>::exec_dump(Dump<TF>& dump, unsigned long iotime)
 
     for (auto& it : dumplist)
     {
+        if (!dump.do_dump_var(it))
+            continue;
+
         if (check_field_exists(it))
             get_thermo_field(*output, it, false, true);
         else
@@ -33,13 +33,15 @@ namespace
             const TF* const __restrict__ data,
             const TF fac0, const TF fac1,
             const int index0, const int index1,
-            const int kmax, const int kgc)
+            const int kmax, const int kgc, const int kstride)
     {
         const int k = blockIdx.x*blockDim.x + threadIdx.x;
-        const int kk = kmax;
+        const int v = blockIdx.y;
+        const int nvars = gridDim.y;
+        const int kk = nvars*kmax;
 
         if (k < kmax)
-            prof[k+kgc] = fac0*data[index0*kk+k] + fac1*data[index1*kk+k];
+            prof[v*kstride + k+kgc] = fac0*data[index0*kk + v*kmax+k] + fac1*data[index1*kk + v*kmax+k];
     }
 }
 
@@ -70,16 +72,20 @@ void Timedep<TF>::update_time_dependent_prof_g(TF* prof, Timeloop<TF>& timeloop)
     if (sw == Timedep_switch::Disabled)
         return;
 
+    if (is_up_to_date(prof, timeloop))
+        return;
+
     auto& gd = grid.get_grid_data();
     const int blockk = 128;
     const int gridk  = gd.kmax/blockk + (gd.kmax%blockk > 0);
 
     // Get/calculate the interpolation indexes/factors
-    Interpolation_factors<TF> ifac = timeloop.get_interpolation_factors(time);
+    const Interpolation_factors<TF>& ifac = get_interpolation_factors(timeloop);
 
-    // Calculate the new vertical profile
-    calc_time_dependent_prof_g<<<gridk, blockk>>>(
-            prof, data_g, ifac.fac0, ifac.fac1, ifac.index0, ifac.index1, gd.kmax, gd.kgc);
+    // Calculate the new vertical profiles, one row of blocks per variable.
+    dim3 gridGPU(gridk, varnames.size());
+    calc_time_dependent_prof_g<<<gridGPU, blockk>>>(
+            prof, data_g, ifac.fac0, ifac.fac1, ifac.index0, ifac.index1, gd.kmax, gd.kgc, gd.kcells);
     cuda_check_error();
 }
 #endif
@@ -91,16 +97,21 @@ void Timedep<TF>::update_time_dependent_prof_g(TF* prof, Timeloop<TF>& timeloop,
     if (sw == Timedep_switch::Disabled)
         return;
 
+    if (is_up_to_date(prof, timeloop))
+        return;
+
 //    auto& gd = grid.get_grid_data();
     const int blockk = 128;
     const int gridk  = int(z_dim_length)/blockk + (int(z_dim_length)%blockk > 0);
 
     // Get/calculate the interpolation indexes/factors
-    Interpolation_factors<TF> ifac = timeloop.get_interpolation_factors(time);
+    const Interpolation_factors<TF>& ifac = get_interpolation_factors(timeloop);
 
-    // Calculate the new vertical profile
-    calc_time_dependent_prof_g<<<gridk, blockk>>>(
-            prof, data_g, ifac.fac0, ifac.fac1, ifac.index0, ifac.index1, int(z_dim_length), 0);
+    // Calculate the new vertical profiles, one row of blocks per variable.
+    dim3 gridGPU(gridk, varnames.size());
+    calc_time_dependent_prof_g<<<gridGPU, blockk>>>(
+            prof, data_g, ifac.fac0, ifac.fac1, ifac.index0, ifac.index1,
+            int(z_dim_length), 0, int(z_dim_length));
     cuda_check_error();
 }
 #endif
@@ -24,16 +24,28 @@
 #include <iostream>
 
 #include "netcdf_interface.h"
+#include "constants.h"
 #include "timedep.h"
 
 template<typename TF>
 Timedep<TF>::Timedep(Master& masterin, Grid<TF>& gridin, const std::string varnamein, const bool is_timedep) :
-    master(masterin), grid(gridin), varname(varnamein)
+    Timedep(masterin, gridin, std::vector<std::string>(1, varnamein), is_timedep)
+{
+}
+
+template<typename TF>
+Timedep<TF>::Timedep(
+        Master& masterin, Grid<TF>& gridin, const std::vector<std::string>& varnamesin, const bool is_timedep) :
+    master(masterin), grid(gridin), varnames(varnamesin)
 {
     if (is_timedep)
         sw = Timedep_switch::Enabled;
     else
         sw = Timedep_switch::Disabled;
+
+    itime_ifac = Constants::ulhuge;
+    itime_prof = Constants::ulhuge;
+    prof_last = nullptr;
 }
 
 template<typename TF>
@@ -55,19 +67,32 @@ void Timedep<TF>::create_timedep_prof(
         
     Netcdf_group& group_nc = input_nc.get_group("timedep");
 
-    std::map<std::string, int> dims = group_nc.get_variable_dimensions(varname);
     int time_dim_length = group_nc.get_dimension_size(time_dim);
 
     time.resize(time_dim_length);
     group_nc.get_variable(time, time_dim, {0}, {time_dim_length});
 
-    data.resize(time_dim_length*kmax);
+    const int nvars = varnames.size();
+    std::vector<TF> data_in(time_dim_length*kmax);
+
+    data.resize(master, nvars*data_in.size());
 
-    group_nc.get_variable(data, varname, {0, 0}, {time_dim_length, kmax});
+    for (int v=0; v<nvars; ++v)
+    {
+        std::map<std::string, int> dims = group_nc.get_variable_dimensions(varnames[v]);
+        group_nc.get_variable(data_in, varnames[v], {0, 0}, {time_dim_length, kmax});
+
+        // Add offset
+        if (data.is_writer())
+            for (int t=0; t<time_dim_length; ++t)
+                for (int k=0; k<kmax; ++k)
+                    data[(t*nvars + v)*kmax + k] = data_in[t*kmax + k] + offset;
+    }
+    data.sync();
 
-    // Add offset
-    for (int i=0; i<data.size(); ++i)
-        data[i] += offset;
+    itime_in.resize(time.size());
+    for (size_t t=0; t<time.size(); ++t)
+        itime_in[t] = convert_to_itime(time[t]);
 
     #ifdef USECUDA
     prepare_device();
@@ -82,41 +107,102 @@ void Timedep<TF>::create_timedep(Netcdf_handle& input_nc, const std::string time
 
     Netcdf_group& group_nc = input_nc.get_group("timedep");
 
-    std::map<std::string, int> dims = group_nc.get_variable_dimensions(varname);
+    std::map<std::string, int> dims = group_nc.get_variable_dimensions(varnames[0]);
     int time_dim_length = group_nc.get_dimension_size(time_dim);
 
     time.resize(time_dim_length);
-    data.resize(time_dim_length);
+    std::vector<TF> data_in(time_dim_length);
 
     group_nc.get_variable(time, time_dim, {0}, {time_dim_length});
-    group_nc.get_variable(data, varname,  {0}, {time_dim_length});
+    group_nc.get_variable(data_in, varnames[0],  {0}, {time_dim_length});
+
+    data.resize(master, data_in.size());
+    if (data.is_writer())
+        std::copy(data_in.begin(), data_in.end(), data.data());
+    data.sync();
+
+    itime_in.resize(time.size());
+    for (size_t t=0; t<time.size(); ++t)
+        itime_in[t] = convert_to_itime(time[t]);
 
     #ifdef USECUDA
     prepare_device();
     #endif
 }
 
+template <typename TF>
+const Interpolation_factors<TF>& Timedep<TF>::get_interpolation_factors(Timeloop<TF>& timeloop)
+{
+    const unsigned long itime = timeloop.get_itime();
+
+    if (itime == itime_ifac)
+        return ifac;
+
+    // Within the bracket of the previous update only the factors change. Otherwise, including
+    // a step back in time in post-processing, the timeloop searches the bracket and checks the range.
+    const unsigned int nlast = itime_in.size()-1;
+    const bool in_bracket = (itime_ifac != Constants::ulhuge)
+        && (itime >= itime_in[ifac.index0])
+        && (itime < itime_in[ifac.index1] || (ifac.index1 == nlast && itime == itime_in[nlast]));
+
+    if (in_bracket)
+    {
+        const unsigned long t0 = itime_in[ifac.index0];
+        const unsigned long t1 = itime_in[ifac.index1];
+        ifac.fac0 = TF(t1 - itime) / TF(t1 - t0);
+        ifac.fac1 = TF(itime - t0) / TF(t1 - t0);
+    }
+    else
+        ifac = timeloop.get_interpolation_factors(time);
+
+    itime_ifac = itime;
+    return ifac;
+}
+
+template <typename TF>
+bool Timedep<TF>::is_up_to_date(const TF* prof, Timeloop<TF>& timeloop)
+{
+    // The substeps of a time step share the time, so the profile only changes in the first one.
+    const unsigned long itime = timeloop.get_itime();
+    if (prof == prof_last && itime == itime_prof)
+        return true;
+
+    prof_last = prof;
+    itime_prof = itime;
+    return false;
+}
+
 template <typename TF>
 void Timedep<TF>::update_time_dependent_prof(std::vector<TF>& prof, Timeloop<TF>& timeloop, const int kmax_in)
 {
     if (sw == Timedep_switch::Disabled)
         return;
 
+    if (is_up_to_date(prof.data(), timeloop))
+        return;
+
     auto& gd = grid.get_grid_data();
     int kmax = kmax_in;
     int kgc = 0;
+    int kstride = kmax_in;
     if (kmax_in == -1)
     {
         kmax = gd.kmax;
-        kgc  = gd.kgc;   
+        kgc  = gd.kgc;
+        kstride = gd.kcells;
     }
 
     // Get/calculate the interpolation indexes/factors
-    Interpolation_factors<TF> ifac = timeloop.get_interpolation_factors(time);
+    const Interpolation_factors<TF>& ifac = get_interpolation_factors(timeloop);
+
+    // Calculate the new vertical profiles, which follow each other in `prof`.
+    const int nvars = varnames.size();
+    const int index0 = ifac.index0*nvars*kmax;
+    const int index1 = ifac.index1*nvars*kmax;
 
-    // Calculate the new vertical profile
-    for (int k=0; k<kmax; ++k)
-        prof[k+kgc] = ifac.fac0 * data[ifac.index0*kmax+k] + ifac.fac1 * data[ifac.index1*kmax+k];
+    for (int v=0; v<nvars; ++v)
+        for (int k=0; k<kmax; ++k)
+            prof[v*kstride + k+kgc] = ifac.fac0 * data[index0 + v*kmax+k] + ifac.fac1 * data[index1 + v*kmax+k];
 }
 
 template <typename TF>
@@ -126,7 +212,7 @@ void Timedep<TF>::update_time_dependent(TF& val, Timeloop<TF>& timeloop)
         return;
 
     // Get/calculate the interpolation indexes/factors
-    Interpolation_factors<TF> ifac = timeloop.get_interpolation_factors(time);
+    const Interpolation_factors<TF>& ifac = get_interpolation_factors(timeloop);
     val = ifac.fac0 * data[ifac.index0] + ifac.fac1 * data[ifac.index1];
     return;
 }
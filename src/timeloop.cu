@@ -30,97 +30,41 @@
 #include "constants.h"
 #include "tools.h"
 #include "cuda_launcher.h"
+#include "cuda_streams.h"
 #include "cuda_tiling.h"
 
 namespace
 {
-    template<typename TF, int substep> __global__
-    void rk3_g(TF* __restrict__ a, TF* __restrict__ at, const TF dt,
-               const int jj, const int kk,
-               const int istart, const int jstart, const int kstart,
-               const int iend,   const int jend,   const int kend)
+    // Pointers of a batch of fields, passed by value such that no table on the device is needed.
+    template<typename TF>
+    struct Rk_batch
     {
-        const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
-        const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        constexpr TF cA1 = -5./9.;
-        constexpr TF cA2 = -153./128.;
-
-        constexpr TF cB0 =  1./ 3.;
-        constexpr TF cB1 = 15./16.;
-        constexpr TF cB2 =  8./15.;
-
-        if (i < iend && j < jend && k < kend)
-        {
-            const int ijk = i + j*jj + k*kk;
-
-            switch (substep)
-            {
-                case 0:
-                    a [ijk] = a[ijk] + cB0*dt*at[ijk];
-                    at[ijk] = cA1*at[ijk];
-                    break;
-                case 1:
-                    a [ijk] = a[ijk] + cB1*dt*at[ijk];
-                    at[ijk] = cA2*at[ijk];
-                    break;
-                case 2:
-                    a [ijk] = a[ijk] + cB2*dt*at[ijk];
-                    at[ijk] = TF(0.);
-                    break;
-            }
-        }
-    }
-
-    template<typename TF, int substep> __global__
-    void rk4_g(TF* __restrict__ a, TF* __restrict__ at, const TF dt,
-               const int jj, const int kk,
-               const int istart, const int jstart, const int kstart,
-               const int iend,   const int jend,   const int kend)
+        static constexpr int nmax = 32;
+        TF* a[nmax];
+        TF* at[nmax];
+        int n;
+    };
+
+    // Low-storage RK update of all fields of a batch, with the fields and levels along z of the grid.
+    template<typename TF> __global__
+    void rk_batch_g(const Rk_batch<TF> batch, const TF cBdt, const TF cAn,
+                    const int jj, const int kk,
+                    const int istart, const int jstart, const int kstart,
+                    const int iend,   const int jend,   const int kend)
     {
         const int i = blockIdx.x*blockDim.x + threadIdx.x + istart;
         const int j = blockIdx.y*blockDim.y + threadIdx.y + jstart;
-        const int k = blockIdx.z + kstart;
-
-        constexpr TF cA1 = - 567301805773./1357537059087.;
-        constexpr TF cA2 = -2404267990393./2016746695238.;
-        constexpr TF cA3 = -3550918686646./2091501179385.;
-        constexpr TF cA4 = -1275806237668./ 842570457699.;
+        const int n = blockIdx.z / (kend-kstart);
+        const int k = blockIdx.z % (kend-kstart) + kstart;
 
-        constexpr TF cB0 = 1432997174477./ 9575080441755.;
-        constexpr TF cB1 = 5161836677717./13612068292357.;
-        constexpr TF cB2 = 1720146321549./ 2090206949498.;
-        constexpr TF cB3 = 3134564353537./ 4481467310338.;
-        constexpr TF cB4 = 2277821191437./14882151754819.;
-
-        if (i < iend && j < jend && k < kend)
+        if (i < iend && j < jend)
         {
             const int ijk = i + j*jj + k*kk;
+            TF* const __restrict__ a  = batch.a [n];
+            TF* const __restrict__ at = batch.at[n];
 
-            switch (substep)
-            {
-                case 0:
-                    a [ijk] = a[ijk] + cB0*dt*at[ijk];
-                    at[ijk] = cA1*at[ijk];
-                    break;
-                case 1:
-                    a [ijk] = a[ijk] + cB1*dt*at[ijk];
-                    at[ijk] = cA2*at[ijk];
-                    break;
-                case 2:
-                    a [ijk] = a[ijk] + cB2*dt*at[ijk];
-                    at[ijk] = cA3*at[ijk];
-                    break;
-                case 3:
-                    a [ijk] = a[ijk] + cB3*dt*at[ijk];
-                    at[ijk] = cA4*at[ijk];
-                    break;
-                case 4:
-                    a [ijk] = a[ijk] + cB4*dt*at[ijk];
-                    at[ijk] = 0;
-                    break;
-            }
+            a [ijk] += cBdt*at[ijk];
+            at[ijk] = (cAn == TF(0.)) ? TF(0.) : cAn*at[ijk];
         }
     }
 }
@@ -138,41 +82,6 @@ void Timeloop<TF>::exec()
 
     if (rkorder == 3)
     {
-        auto rk3_substep = [&](
-            TF* const __restrict__ fld,
-            TF* const __restrict__ tend,
-            const int kstart, const int kend)
-        {
-            const int kmax = kend-kstart;
-
-            const int blocki = gd.ithread_block;
-            const int blockj = gd.jthread_block;
-            const int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
-            const int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
-
-            dim3 gridGPU (gridi, gridj, kmax);
-            dim3 blockGPU(blocki, blockj, 1);
-
-            if (substep == 0)
-                rk3_g<TF, 0><<<gridGPU, blockGPU>>>(
-                    fld, tend, TF(dt),
-                    gd.icells, gd.ijcells,
-                    gd.istart,  gd.jstart, kstart,
-                    gd.iend,    gd.jend,   kend);
-            else if (substep == 1)
-                rk3_g<TF, 1><<<gridGPU, blockGPU>>>(
-                    fld, tend, TF(dt),
-                    gd.icells, gd.ijcells,
-                    gd.istart,  gd.jstart, kstart,
-                    gd.iend,    gd.jend,   kend);
-            else if (substep == 2)
-                rk3_g<TF, 2><<<gridGPU, blockGPU>>>(
-                    fld, tend, TF(dt),
-                    gd.icells, gd.ijcells,
-                    gd.istart,  gd.jstart, kstart,
-                    gd.iend,    gd.jend,   kend);
-        };
-
         auto rk3_substep_launcher = [&](
                 cuda_vector<TF>& fld,
                 cuda_vector<TF>& tend)
@@ -196,73 +105,21 @@ void Timeloop<TF>::exec()
                         grid_layout, fld.view(), tend.view(), TF(dt));
         };
 
-        // Atmospheric fields
-        for (auto& f : fields.at)
-            rk3_substep_launcher(fields.ap.at(f.first)->fld_g, f.second->fld_g);
-
-        //for (auto& f : fields.at)
-        //    rk3_substep(fields.ap.at(f.first)->fld_g, f.second->fld_g, gd.kstart, gd.kend);
-
-        // Soil fields
-        for (auto& f : fields.sts)
-            rk3_substep(fields.sps.at(f.first)->fld_g, f.second->fld_g, sgd.kstart, sgd.kend);
-
-        // 2D fields
-        for (auto& f : fields.at2d)
-            rk3_substep(fields.ap2d.at(f.first)->fld_g, f.second->fld_g, kstart_2d, kend_2d);
+        // Atmospheric fields, which are independent of each other.
+        {
+            Cuda_streams streams;
+            int branch = 0;
 
-        substep = (substep+1) % 3;
+            for (int h=0; h<fields.get_nprog(); ++h)
+            {
+                streams.select(branch++);
+                rk3_substep_launcher(fields.get_prog(h).fld_g, fields.get_tend(h).fld_g);
+            }
+        }
     }
 
     else if (rkorder == 4)
     {
-        auto rk4_substep = [&](
-            TF* const __restrict__ fld,
-            TF* const __restrict__ tend,
-            const int kstart, const int kend)
-        {
-            const int kmax = kend-kstart;
-
-            const int blocki = gd.ithread_block;
-            const int blockj = gd.jthread_block;
-            const int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
-            const int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
-
-            dim3 gridGPU (gridi, gridj, kmax);
-            dim3 blockGPU(blocki, blockj, 1);
-
-            if (substep == 0)
-                rk4_g<TF, 0><<<gridGPU, blockGPU>>>(
-                    fld, tend, TF(dt),
-                    gd.icells, gd.ijcells,
-                    gd.istart,  gd.jstart, kstart,
-                    gd.iend,    gd.jend,   kend);
-            else if (substep == 1)
-                rk4_g<TF, 1><<<gridGPU, blockGPU>>>(
-                    fld, tend, TF(dt),
-                    gd.icells, gd.ijcells,
-                    gd.istart,  gd.jstart, kstart,
-                    gd.iend,    gd.jend,   kend);
-            else if (substep == 2)
-                rk4_g<TF, 2><<<gridGPU, blockGPU>>>(
-                    fld, tend, TF(dt),
-                    gd.icells, gd.ijcells,
-                    gd.istart,  gd.jstart, kstart,
-                    gd.iend,    gd.jend,   kend);
-            else if (substep == 3)
-                rk4_g<TF, 3><<<gridGPU, blockGPU>>>(
-                    fld, tend, TF(dt),
-                    gd.icells, gd.ijcells,
-                    gd.istart,  gd.jstart, kstart,
-                    gd.iend,    gd.jend,   kend);
-            else if (substep == 4)
-                rk4_g<TF, 4><<<gridGPU, blockGPU>>>(
-                    fld, tend, TF(dt),
-                    gd.icells, gd.ijcells,
-                    gd.istart,  gd.jstart, kstart,
-                    gd.iend,    gd.jend,   kend);
-        };
-
         auto rk4_substep_launcher = [&](
                 cuda_vector<TF>& fld,
                 cuda_vector<TF>& tend)
@@ -292,23 +149,66 @@ void Timeloop<TF>::exec()
                         grid_layout, fld.view(), tend.view(), TF(dt));
         };
 
-        // Atmospheric fields
-        for (auto& f : fields.at)
-            rk4_substep_launcher(fields.ap.at(f.first)->fld_g, f.second->fld_g);
+        // Atmospheric fields, which are independent of each other.
+        {
+            Cuda_streams streams;
+            int branch = 0;
 
-        //for (auto& f : fields.at)
-        //    rk4_substep(fields.ap.at(f.first)->fld_g, f.second->fld_g, gd.kstart, gd.kend);
+            for (int h=0; h<fields.get_nprog(); ++h)
+            {
+                streams.select(branch++);
+                rk4_substep_launcher(fields.get_prog(h).fld_g, fields.get_tend(h).fld_g);
+            }
+        }
+    }
 
-        // Soil fields
-        for (auto& f : fields.sts)
-            rk4_substep(fields.sps.at(f.first)->fld_g, f.second->fld_g, sgd.kstart, sgd.kend);
+    // The soil and 2D fields have few levels, such that each set is integrated by a single
+    // kernel over all its fields, with the tendency factor of the next substep.
+    const TF cBdt = get_sub_time_step();
+    substep = (substep+1) % ((rkorder == 3) ? 3 : 5);
+    const TF cAn = get_sub_time_step_tendency_factor();
 
-        // 2D fields
-        for (auto& f : fields.at2d)
-            rk4_substep(fields.ap2d.at(f.first)->fld_g, f.second->fld_g, kstart_2d, kend_2d);
+    auto rk_batch_substep = [&](Rk_batch<TF>& batch, const int kstart, const int kend)
+    {
+        if (batch.n == 0)
+            return;
 
-        substep = (substep+1) % 5;
-    }
+        const int blocki = gd.ithread_block;
+        const int blockj = gd.jthread_block;
+        const int gridi = gd.imax/blocki + (gd.imax%blocki > 0);
+        const int gridj = gd.jmax/blockj + (gd.jmax%blockj > 0);
+
+        dim3 gridGPU (gridi, gridj, batch.n*(kend-kstart));
+        dim3 blockGPU(blocki, blockj, 1);
+
+        rk_batch_g<TF><<<gridGPU, blockGPU>>>(
+                batch, cBdt, cAn,
+                gd.icells, gd.ijcells,
+                gd.istart, gd.jstart, kstart,
+                gd.iend,   gd.jend,   kend);
+
+        batch.n = 0;
+    };
+
+    auto integrate_batched = [&](auto& fld_map, auto& tend_map, const int kstart, const int kend)
+    {
+        Rk_batch<TF> batch;
+        batch.n = 0;
+
+        for (auto& f : tend_map)
+        {
+            batch.a [batch.n] = fld_map.at(f.first)->fld_g;
+            batch.at[batch.n] = f.second->fld_g;
+
+            if (++batch.n == Rk_batch<TF>::nmax)
+                rk_batch_substep(batch, kstart, kend);
+        }
+
+        rk_batch_substep(batch, kstart, kend);
+    };
+
+    integrate_batched(fields.sps, fields.sts, sgd.kstart, sgd.kend);
+    integrate_batched(fields.ap2d, fields.at2d, kstart_2d, kend_2d);
 
     cuda_check_error();
 }
@@ -20,6 +20,7 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -69,6 +70,20 @@ Timeloop<TF>::Timeloop(
     outputiter   = input.get_item<int>   ("time", "outputiter"  , "", 20             );
     iotimeprec   = input.get_item<int>   ("time", "iotimeprec"  , "", 0              );
 
+    // Time reserved at the end of the wall clock limit to write the restart files.
+    wall_clock_margin = input.get_item<double>("time", "wallclockmargin", "", 600.);
+
+    // Optionally tune the restart interval to a multiple of savetime from the measured cost of the saves.
+    swautosave = input.get_item<bool>("time", "swautosave", "", false);
+    if (swautosave)
+    {
+        mtbf = input.get_item<double>("time", "mtbf", "");
+        if (mtbf <= 0.)
+            throw std::runtime_error("The mtbf in [time] has to be positive");
+    }
+    else
+        input.flag_as_used("time", "mtbf", "");
+
     // Get a datetime in UTC.
     std::string datetime_utc_string = input.get_item<std::string>("time", "datetime_utc", "", "");
     if (datetime_utc_string != "")
@@ -126,6 +141,15 @@ Timeloop<TF>::Timeloop(
 
     gettimeofday(&start, NULL);
 
+    wall_time_prev = -1.;
+    wall_per_step = -1.;
+    wall_per_sim_time = -1.;
+
+    save_cost = -1.;
+    save_step = false;
+    nsave_interval = 1;
+    nsave_skipped = 0;
+
     if (sim_mode == Sim_mode::Init)
         input.flag_as_used("time", "starttime", "");
 }
@@ -141,7 +165,7 @@ void Timeloop<TF>::set_time_step_limit()
     idtlim = idtmax;
 
     // Check whether the run should be stopped because of the wall clock limit
-    if (master.at_wall_clock_limit())
+    if (at_wall_clock_limit())
     {
         // Set the time step to the nearest multiple of iotimeprec
         idtlim = std::min(idtlim, iiotimeprec - itime % iiotimeprec);
@@ -171,6 +195,28 @@ void Timeloop<TF>::step_time()
 
     ++iteration;
 
+    // Track the wall clock time per step. The first step is not measured, as it includes the start up.
+    // The restart files are written after the step that ends at the save time, such that their cost is
+    // the excess of the next step over the mean, which is left out of the mean.
+    const double wall_time = master.get_wall_clock_time();
+    if (wall_time_prev > 0. && save_step && wall_per_step > 0.)
+    {
+        const double cost = std::max(0., (wall_time - wall_time_prev) - wall_per_step);
+        save_cost = (save_cost < 0.) ? cost : save_cost + 0.5*(cost - save_cost);
+
+        if (swautosave)
+            set_save_interval();
+    }
+    else if (wall_time_prev > 0.)
+    {
+        const double wall_step = wall_time - wall_time_prev;
+        const double weight = (wall_per_step > 0.) ? 0.1 : 1.;
+        wall_per_step += weight*(wall_step - wall_per_step);
+        wall_per_sim_time += weight*(wall_step/dt - wall_per_sim_time);
+    }
+    wall_time_prev = wall_time;
+    save_step = false;
+
     if (itime >= iendtime)
         loop = false;
 }
@@ -192,22 +238,86 @@ bool Timeloop<TF>::do_save()
 {
     // Check whether the simulation has to stop due to the wallclock limit,
     // but only at a time step where actual saves can be made.
-    if (itime % iiotimeprec == 0 && !in_substep() && master.at_wall_clock_limit())
+    if (itime % iiotimeprec == 0 && !in_substep() && at_wall_clock_limit())
     {
         master.print_warning("Simulation will be stopped after saving the restart files due to wall clock limit\n");
 
         // Stop looping
         loop = false;
+        save_step = true;
         return true;
     }
 
     // Do not save directly after the start of the simulation and not in a substep
     if (itime % isavetime == 0 && iteration != 0 && !in_substep())
+    {
+        // With swautosave, only every nsave_interval-th save time is a save.
+        if (++nsave_skipped < nsave_interval)
+            return false;
+
+        nsave_skipped = 0;
+        save_step = true;
+
+        const double wall_time_remaining = get_wall_time_remaining();
+        if (wall_time_remaining > 0.)
+        {
+            const double core_hours = wall_time_remaining/3600.
+                * master.get_MPI_data().nprocs * master.get_npthreads();
+            master.print_message("Projected wall clock time to completion = %.2f h (%.1f core hours)\n",
+                    wall_time_remaining/3600., core_hours);
+        }
         return true;
+    }
 
     return false;
 }
 
+template<typename TF>
+bool Timeloop<TF>::at_wall_clock_limit()
+{
+    // Number of steps until a time at which the restart files can be written, including the current one.
+    const unsigned long irest = itime % iiotimeprec;
+    const unsigned long nsteps = 1 + ((irest == 0) ? 0 : (iiotimeprec - irest + idt - 1) / idt);
+
+    // Reserve the margin for the saving itself and the projected time of those steps.
+    const double wall_steps = (wall_per_step > 0.) ? nsteps*wall_per_step : 0.;
+
+    return master.get_wall_clock_time_left() < wall_clock_margin + wall_steps;
+}
+
+template<typename TF>
+void Timeloop<TF>::set_save_interval()
+{
+    // The clocks differ per process, while all processes have to agree on the saves,
+    // which are collective. The slowest process sets the interval.
+    double timings[2] = {save_cost, wall_per_sim_time};
+    master.max(timings, 2);
+
+    if (timings[1] <= 0.)
+        return;
+
+    // Young's optimum of the wall clock time between checkpoints, converted to simulated time.
+    const double interval_wall = std::sqrt(2.*timings[0]*mtbf);
+    const double interval = interval_wall / timings[1];
+
+    const int nsave_interval_new = std::max(1, static_cast<int>(std::lround(interval / savetime)));
+    if (nsave_interval_new != nsave_interval)
+    {
+        master.print_message("Restart interval set to %g s from a save cost of %.2f s\n",
+                nsave_interval_new*savetime, timings[0]);
+        nsave_interval = nsave_interval_new;
+    }
+}
+
+template<typename TF>
+double Timeloop<TF>::get_wall_time_remaining() const
+{
+    if (wall_per_sim_time < 0.)
+        return -1.;
+
+    return std::max(0., endtime - time) * wall_per_sim_time;
+}
+
 template<typename TF>
 bool Timeloop<TF>::is_finished()
 {
@@ -247,48 +357,119 @@ void Timeloop<TF>::set_time_step()
 
 namespace
 {
+    // Low-storage RK update fused with the scaling of the tendency for the next substep,
+    // such that every tendency is read and written only once per substep. As in the GPU
+    // kernels, the reset at the start of a new step only zeroes the interior.
     template<typename TF>
-    void rk3(TF* restrict const a, TF* restrict const at, const int substep, const TF dt,
-             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-             const int jj, const int kk, const int ncells)
+    void rk_update(TF* restrict const a, TF* restrict const at, const TF cBdt, const TF cAn,
+                   const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+                   const int jj, const int kk)
     {
-        constexpr TF cA [] = {0., -5./9., -153./128.};
-        constexpr TF cB [] = {1./3., 15./16., 8./15.};
+        if (cAn == TF(0.))
+        {
+            #pragma omp parallel for
+            for (int k=kstart; k<kend; ++k)
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        a [ijk] += cBdt*at[ijk];
+                        at[ijk] = TF(0.);
+                    }
+        }
+        else
+        {
+            #pragma omp parallel for
+            for (int k=kstart; k<kend; ++k)
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        a [ijk] += cBdt*at[ijk];
+                        at[ijk] *= cAn;
+                    }
+        }
+    }
 
+    // Low-storage RK update with the exponential decay and the lower limit of the field applied to the
+    // tendency on the fly. This gives the same result as the tendency passes of Decay and Limiter
+    // before the update, including the limited tendency that is kept for the next substep.
+    template<typename TF>
+    void rk_update_hook(TF* restrict const a, TF* restrict const at, const TF cBdt, const TF cAn,
+                        const TF decay_rate, const bool limit, const TF min_value,
+                        const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+                        const int jj, const int kk)
+    {
+        const TF cBdti = TF(1.)/cBdt;
+
+        #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
                 for (int i=istart; i<iend; ++i)
                 {
                     const int ijk = i + j*jj + k*kk;
-                    a[ijk] += cB[substep]*dt*at[ijk];
+                    TF tend = at[ijk] - decay_rate*a[ijk];
+
+                    if (limit)
+                    {
+                        const TF a_new = a[ijk] + cBdt*tend;
+                        tend += (a_new < min_value) ? (-a_new + min_value) * cBdti : TF(0.);
+                    }
+
+                    a [ijk] += cBdt*tend;
+                    at[ijk] = (cAn == TF(0.)) ? TF(0.) : cAn*tend;
                 }
+    }
 
-        const int substepn = (substep+1) % 3;
+    // Low-storage RK update of a batch of fields with few levels, such as the soil and 2D
+    // fields, in a single parallel loop over the fields and their rows.
+    template<typename TF>
+    void rk_update_batch(const std::vector<std::pair<TF*, TF*>>& batch, const TF cBdt, const TF cAn,
+                         const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+                         const int jj, const int kk)
+    {
+        const int nbatch = batch.size();
 
-        // substep 0 resets the tendencies, because cA[0] == 0
-        if (substepn == 0)
-        {
-            for (int n=0; n<ncells; ++n)
-                at[n] = TF(0.);
-        }
-        else
-        {
+        #pragma omp parallel for collapse(3)
+        for (int n=0; n<nbatch; ++n)
             for (int k=kstart; k<kend; ++k)
                 for (int j=jstart; j<jend; ++j)
+                {
+                    TF* restrict const a  = batch[n].first;
+                    TF* restrict const at = batch[n].second;
+
                     #pragma ivdep
                     for (int i=istart; i<iend; ++i)
                     {
                         const int ijk = i + j*jj + k*kk;
-                        at[ijk] *= cA[substepn];
+                        a [ijk] += cBdt*at[ijk];
+                        at[ijk] = (cAn == TF(0.)) ? TF(0.) : cAn*at[ijk];
                     }
-        }
+                }
+    }
+
+    template<typename TF>
+    void rk3(TF* restrict const a, TF* restrict const at, const int substep, const TF dt,
+             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+             const int jj, const int kk)
+    {
+        constexpr TF cA [] = {0., -5./9., -153./128.};
+        constexpr TF cB [] = {1./3., 15./16., 8./15.};
+
+        // substep 0 resets the tendencies, because cA[0] == 0
+        const int substepn = (substep+1) % 3;
+
+        rk_update<TF>(a, at, cB[substep]*dt, cA[substepn],
+                      istart, iend, jstart, jend, kstart, kend, jj, kk);
     }
 
     template<typename TF>
     void rk4(TF* restrict const a, TF* restrict const at, const int substep, const TF dt,
              const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-             const int jj, const int kk, const int ncells)
+             const int jj, const int kk)
     {
         constexpr TF cA [] = {
             0.,
@@ -304,34 +485,11 @@ namespace
             3134564353537./ 4481467310338.,
             2277821191437./14882151754819.};
 
-        for (int k=kstart; k<kend; ++k)
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    a[ijk] = a[ijk] + cB[substep]*dt*at[ijk];
-                }
-
+        // substep 0 resets the tendencies, because cA[0] == 0
         const int substepn = (substep+1) % 5;
 
-        // substep 0 resets the tendencies, because cA[0] == 0
-        if (substepn == 0)
-        {
-            for (int n=0; n<ncells; ++n)
-                at[n] = TF(0.);
-        }
-        else
-        {
-            for (int k=kstart; k<kend; ++k)
-                for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk = i + j*jj + k*kk;
-                        at[ijk] = cA[substepn]*at[ijk];
-                    }
-        }
+        rk_update<TF>(a, at, cB[substep]*dt, cA[substepn],
+                      istart, iend, jstart, jend, kstart, kend, jj, kk);
     }
 
     template<typename TF>
@@ -352,6 +510,25 @@ namespace
             2277821191437./14882151754819.};
         return cB[substep]*dt;
     }
+
+    template<typename TF>
+    inline TF rk3subcA(const int substep)
+    {
+        constexpr TF cA [] = {0., -5./9., -153./128.};
+        return cA[substep];
+    }
+
+    template<typename TF>
+    inline TF rk4subcA(const int substep)
+    {
+        constexpr TF cA [] = {
+            0.,
+            - 567301805773./1357537059087.,
+            -2404267990393./2016746695238.,
+            -3550918686646./2091501179385.,
+            -1275806237668./ 842570457699.};
+        return cA[substep];
+    }
 }
 
 #ifndef USECUDA
@@ -364,54 +541,83 @@ void Timeloop<TF>::exec()
     const int kstart_2d = 0;
     const int kend_2d = 1;
 
+    // Factors of the current substep and the tendency factor of the next one.
+    const int substep_next = (substep+1) % ((rkorder == 3) ? 3 : 5);
+    const TF cBdt = get_sub_time_step();
+    const TF cAn = (rkorder == 3) ? rk3subcA<double>(substep_next) : rk4subcA<double>(substep_next);
+
+    // Fields with hooks get the fused update.
+
+    auto exec_hook = [&](const int h)
+    {
+        auto it = rk_hooks.find(fields.get_prog_name(h));
+        if (it == rk_hooks.end())
+            return false;
+
+        rk_update_hook<TF>(fields.get_prog(h).fld.data(), fields.get_tend(h).fld.data(), cBdt, cAn,
+                it->second.decay_rate, it->second.limit, it->second.min_value,
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
+        return true;
+    };
+
     if (rkorder == 3)
     {
         // Atmospheric fields
-        for (auto& f : fields.at)
-            rk3<TF>(fields.ap.at(f.first)->fld.data(), f.second->fld.data(), substep, dt,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells, gd.ncells);
-
-        // Soil fields
-        for (auto& f : fields.sts)
-            rk3<TF>(fields.sps.at(f.first)->fld.data(), f.second->fld.data(), substep, dt,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, sgd.kstart, sgd.kend,
-                    gd.icells, gd.ijcells, sgd.ncells);
-
-        // 2D fields
-        for (auto& f : fields.at2d)
-            rk3<TF>(fields.ap2d.at(f.first)->fld.data(), f.second->fld.data(), substep, dt,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, kstart_2d, kend_2d,
-                    gd.icells, gd.ijcells, gd.ijcells);
-
-        substep = (substep+1) % 3;
+        for (int h=0; h<fields.get_nprog(); ++h)
+            if (!exec_hook(h))
+                rk3<TF>(fields.get_prog(h).fld.data(), fields.get_tend(h).fld.data(), substep, dt,
+                        gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                        gd.icells, gd.ijcells);
     }
 
     if (rkorder == 4)
     {
         // Atmospheric fields
-        for (auto& f : fields.at)
-            rk4<TF>(fields.ap.at(f.first)->fld.data(), f.second->fld.data(), substep, dt,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells, gd.ncells);
-
-        // Soil fields
-        for (auto& f : fields.sts)
-            rk4<TF>(fields.sps.at(f.first)->fld.data(), f.second->fld.data(), substep, dt,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, sgd.kstart, sgd.kend,
-                    gd.icells, gd.ijcells, sgd.ncells);
-
-        // 2D fields
-        for (auto& f : fields.at2d)
-            rk4<TF>(fields.ap2d.at(f.first)->fld.data(), f.second->fld.data(), substep, dt,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, kstart_2d, kend_2d,
-                    gd.icells, gd.ijcells, gd.ijcells);
-
-        substep = (substep+1) % 5;
+        for (int h=0; h<fields.get_nprog(); ++h)
+            if (!exec_hook(h))
+                rk4<TF>(fields.get_prog(h).fld.data(), fields.get_tend(h).fld.data(), substep, dt,
+                        gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                        gd.icells, gd.ijcells);
     }
+
+    // The soil and 2D fields have few levels, such that each set is integrated as a single
+    // batch, with the tendency factor of the next substep.
+    substep = substep_next;
+
+    auto make_batch = [](auto& fld_map, auto& tend_map)
+    {
+        std::vector<std::pair<TF*, TF*>> batch;
+        for (auto& f : tend_map)
+            batch.emplace_back(fld_map.at(f.first)->fld.data(), f.second->fld.data());
+        return batch;
+    };
+
+    rk_update_batch<TF>(make_batch(fields.sps, fields.sts), cBdt, cAn,
+            gd.istart, gd.iend, gd.jstart, gd.jend, sgd.kstart, sgd.kend,
+            gd.icells, gd.ijcells);
+
+    rk_update_batch<TF>(make_batch(fields.ap2d, fields.at2d), cBdt, cAn,
+            gd.istart, gd.iend, gd.jstart, gd.jend, kstart_2d, kend_2d,
+            gd.icells, gd.ijcells);
+
+    rk_hooks.clear();
 }
 #endif
 
+template<typename TF>
+void Timeloop<TF>::add_rk_decay(const std::string& name, const TF rate)
+{
+    rk_hooks[name].decay_rate = rate;
+}
+
+template<typename TF>
+void Timeloop<TF>::add_rk_limit(const std::string& name, const TF min_value)
+{
+    rk_hooks[name].limit = true;
+    rk_hooks[name].min_value = min_value;
+}
+
 template<typename TF>
 double Timeloop<TF>::get_sub_time_step() const
 {
@@ -422,6 +628,16 @@ double Timeloop<TF>::get_sub_time_step() const
         return rk4subdt(dt, substep);
 }
 
+template<typename TF>
+double Timeloop<TF>::get_sub_time_step_tendency_factor() const
+{
+    // Factor with which the low-storage tendency of the previous substep is retained.
+    if (rkorder == 3)
+        return rk3subcA<double>(substep);
+    else
+        return rk4subcA<double>(substep);
+}
+
 template<typename TF>
 bool Timeloop<TF>::in_substep()
 {
@@ -528,6 +744,18 @@ void Timeloop<TF>::load(int starttime)
     dt   = static_cast<double>(idt)   / ifactor;
 }
 
+template<typename TF>
+void Timeloop<TF>::set_checkpoint_time(const unsigned long itime_in, const unsigned long idt_in, const int iteration_in)
+{
+    itime = itime_in;
+    idt = idt_in;
+    iteration = iteration_in;
+    iotime = static_cast<int>(itime/iiotimeprec);
+
+    time = static_cast<double>(itime) / ifactor;
+    dt   = static_cast<double>(idt)   / ifactor;
+}
+
 template<typename TF>
 void Timeloop<TF>::step_post_proc_time()
 {
@@ -550,37 +778,37 @@ namespace
 }
 
 template<typename TF>
-double Timeloop<TF>::calc_hour_of_day() const
+double Timeloop<TF>::calc_hour_of_day(const double time_in) const
 {
     if (!flag_utc_time)
         throw std::runtime_error("No datetime in UTC specified");
 
-    std::tm tm_actual = calc_tm_actual(tm_utc_start, time);
+    std::tm tm_actual = calc_tm_actual(tm_utc_start, time_in);
     const double frac_hour = ( tm_actual.tm_min*60
-                             + tm_actual.tm_sec + std::fmod(time, 1.) ) / 3600.;
+                             + tm_actual.tm_sec + std::fmod(time_in, 1.) ) / 3600.;
     return tm_actual.tm_hour + frac_hour; // Counting starts at 0 in std::tm, thus add 1.
 }
 
 template<typename TF>
-double Timeloop<TF>::calc_day_of_year() const
+double Timeloop<TF>::calc_day_of_year(const double time_in) const
 {
     if (!flag_utc_time)
         throw std::runtime_error("No datetime in UTC specified");
 
-    std::tm tm_actual = calc_tm_actual(tm_utc_start, time);
+    std::tm tm_actual = calc_tm_actual(tm_utc_start, time_in);
     const double frac_day = ( tm_actual.tm_hour*3600.
                             + tm_actual.tm_min*60.
-                            + tm_actual.tm_sec + std::fmod(time, 1.) ) / 86400.;
+                            + tm_actual.tm_sec + std::fmod(time_in, 1.) ) / 86400.;
     return tm_actual.tm_yday+1. + frac_day; // Counting starts at 0 in std::tm, thus add 1.
 }
 
 template<typename TF>
-int Timeloop<TF>::get_year() const
+int Timeloop<TF>::get_year(const double time_in) const
 {
     if (!flag_utc_time)
         throw std::runtime_error("No datetime in UTC specified");
 
-    std::tm tm_actual = calc_tm_actual(tm_utc_start, time);
+    std::tm tm_actual = calc_tm_actual(tm_utc_start, time_in);
     return tm_actual.tm_year;
 }
 
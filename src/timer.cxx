@@ -0,0 +1,550 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <stdexcept>
+
+#include "master.h"
+#include "input.h"
+#include "timer.h"
+#include "nvtx_range.h"
+
+#ifdef USECUDA
+#include "tools.h"
+#endif
+
+Timer::Timer(Master& masterin, Input& inputin, const std::string& sim_name_in) :
+    master(masterin), sim_name(sim_name_in)
+{
+    swtimer = inputin.get_item<bool>("timer", "swtimer", "", false);
+    suspended = false;
+    timing_file = nullptr;
+    swenergy = false;
+    cpu_energy_total = 0.;
+    gpu_energy_total = 0.;
+    gpu_energy_last = 0;
+    use_papi = false;
+    papi_event_set = 0;
+
+    if (swtimer)
+    {
+        interval = inputin.get_item<int>("timer", "interval", "", 100);
+
+        if (interval < 1)
+            throw std::runtime_error("The timer interval has to be at least one iteration");
+
+        imbalance_threshold = inputin.get_item<double>("timer", "imbalance", "", 1.2);
+
+        swenergy = inputin.get_item<bool>("timer", "swenergy", "", false);
+        if (swenergy)
+            init_energy();
+
+        papi_events = inputin.get_list<std::string>("timer", "papievents", "", std::vector<std::string>());
+        const int papi_stride = inputin.get_item<int>("timer", "papistride", "", 1);
+
+        if (!papi_events.empty())
+        {
+            #ifndef USEPAPI
+            throw std::runtime_error("papievents requires USEPAPI");
+            #endif
+
+            if (papi_stride < 1)
+                throw std::runtime_error("The papistride has to be at least one");
+
+            use_papi = (master.get_mpiid() % papi_stride == 0);
+            if (use_papi)
+                init_papi();
+        }
+    }
+    else
+    {
+        inputin.flag_as_used("timer", "swenergy", "");
+        inputin.flag_as_used("timer", "papievents", "");
+        inputin.flag_as_used("timer", "papistride", "");
+    }
+}
+
+void Timer::init_papi()
+{
+    #ifdef USEPAPI
+    if (PAPI_library_init(PAPI_VER_CURRENT) != PAPI_VER_CURRENT)
+        throw std::runtime_error("Cannot initialize PAPI");
+
+    papi_event_set = PAPI_NULL;
+    if (PAPI_create_eventset(&papi_event_set) != PAPI_OK)
+        throw std::runtime_error("Cannot create the PAPI event set");
+
+    for (auto& event : papi_events)
+    {
+        int code;
+        if (PAPI_event_name_to_code(event.c_str(), &code) != PAPI_OK || PAPI_add_event(papi_event_set, code) != PAPI_OK)
+            throw std::runtime_error("PAPI event \"" + event + "\" is not available or cannot be combined with the others");
+    }
+
+    papi_values.resize(papi_events.size());
+
+    // The counters run freely, and the sections take the differences of their readings.
+    if (PAPI_start(papi_event_set) != PAPI_OK)
+        throw std::runtime_error("Cannot start the PAPI counters");
+    #endif
+}
+
+void Timer::init_energy()
+{
+    // The package domains of RAPL are the top level zones intel-rapl:0, intel-rapl:1, ...
+    for (int n=0; ; ++n)
+    {
+        const std::string zone = "/sys/class/powercap/intel-rapl:" + std::to_string(n);
+        std::ifstream energy(zone + "/energy_uj");
+        std::ifstream range(zone + "/max_energy_range_uj");
+
+        Rapl_domain domain = {zone + "/energy_uj", 0., 0.};
+        if (!(energy >> domain.last) || !(range >> domain.max_range))
+            break;
+
+        rapl_domains.push_back(domain);
+    }
+
+    if (rapl_domains.empty())
+        master.print_warning("No readable RAPL counters, the CPU energy is reported as zero\n");
+
+    #ifdef USENVML
+    has_nvml = false;
+
+    int device;
+    char pci_bus_id[32];
+    if (nvmlInit_v2() == NVML_SUCCESS &&
+        cudaGetDevice(&device) == cudaSuccess &&
+        cudaDeviceGetPCIBusId(pci_bus_id, 32, device) == cudaSuccess &&
+        nvmlDeviceGetHandleByPciBusId_v2(pci_bus_id, &nvml_device) == NVML_SUCCESS &&
+        nvmlDeviceGetTotalEnergyConsumption(nvml_device, &gpu_energy_last) == NVML_SUCCESS)
+        has_nvml = true;
+
+    if (!has_nvml)
+        master.print_warning("No NVML energy counter, the GPU energy is reported as zero\n");
+    #endif
+}
+
+double Timer::read_cpu_energy()
+{
+    for (auto& domain : rapl_domains)
+    {
+        std::ifstream file(domain.path);
+        double energy;
+        if (!(file >> energy))
+            continue;
+
+        // The counter wraps at its range, which takes minutes, such that at most one wrap
+        // occurs between two readings.
+        double delta = energy - domain.last;
+        if (delta < 0.)
+            delta += domain.max_range;
+
+        cpu_energy_total += 1.e-6*delta;
+        domain.last = energy;
+    }
+
+    return cpu_energy_total;
+}
+
+double Timer::read_gpu_energy()
+{
+    #ifdef USENVML
+    unsigned long long energy;
+    if (has_nvml && nvmlDeviceGetTotalEnergyConsumption(nvml_device, &energy) == NVML_SUCCESS)
+    {
+        gpu_energy_total += 1.e-3*static_cast<double>(energy - gpu_energy_last);
+        gpu_energy_last = energy;
+    }
+    #endif
+
+    return gpu_energy_total;
+}
+
+Timer::~Timer()
+{
+    if (timing_file != nullptr)
+        std::fclose(timing_file);
+
+    #ifdef USENVML
+    if (swenergy)
+        nvmlShutdown();
+    #endif
+
+    #ifdef USECUDA
+    for (auto& it : sections)
+    {
+        cudaEventDestroy(it.second.event_start);
+        cudaEventDestroy(it.second.event_stop);
+    }
+    #endif
+}
+
+void Timer::start(const std::string& name)
+{
+    // The ranges only mark the host side, such that they do not interfere with a graph capture.
+    #ifdef USENVTX
+    nvtxRangePushA(name.c_str());
+    #endif
+
+    if (!swtimer || suspended)
+        return;
+
+    auto it = sections.find(name);
+    if (it == sections.end())
+    {
+        Section section = {0, 0., 0., 0., 0., 0., 1., 0., 0., 0., 0., 0, 0.};
+        section.papi_start.resize(papi_events.size());
+        section.papi_count.assign(papi_events.size(), 0);
+
+        #ifdef USECUDA
+        cuda_safe_call(cudaEventCreate(&section.event_start));
+        cuda_safe_call(cudaEventCreate(&section.event_stop));
+        section.pending = false;
+        #endif
+
+        it = sections.emplace(name, section).first;
+        names.push_back(name);
+    }
+
+    Section& section = it->second;
+
+    #ifdef USECUDA
+    // The events of the previous call are reused, which requires their time to be added first.
+    // By now the device has normally passed the stop event, such that this does not stall.
+    if (section.pending)
+        add_gpu_time(section);
+
+    cuda_safe_call(cudaEventRecord(section.event_start));
+    #endif
+
+    if (swenergy)
+    {
+        #ifdef USECUDA
+        cuda_safe_call(cudaDeviceSynchronize());
+        #endif
+        section.cpu_energy_start = read_cpu_energy();
+        section.gpu_energy_start = read_gpu_energy();
+    }
+
+    #ifdef USEPAPI
+    if (use_papi && PAPI_read(papi_event_set, section.papi_start.data()) != PAPI_OK)
+        throw std::runtime_error("Cannot read the PAPI counters");
+    #endif
+
+    section.wall_start = master.get_wall_clock_time();
+    section.mpi_start = master.get_mpi_wait_time();
+}
+
+void Timer::stop(const std::string& name)
+{
+    #ifdef USENVTX
+    nvtxRangePop();
+    #endif
+
+    if (!swtimer || suspended)
+        return;
+
+    auto it = sections.find(name);
+    if (it == sections.end())
+        throw std::runtime_error("Timer section \"" + name + "\" is stopped before it is started");
+
+    Section& section = it->second;
+
+    #ifdef USEPAPI
+    if (use_papi)
+    {
+        if (PAPI_read(papi_event_set, papi_values.data()) != PAPI_OK)
+            throw std::runtime_error("Cannot read the PAPI counters");
+
+        for (size_t n=0; n<papi_values.size(); ++n)
+            section.papi_count[n] += papi_values[n] - section.papi_start[n];
+    }
+    #endif
+
+    const double wall_time = master.get_wall_clock_time() - section.wall_start;
+    section.wall_time += wall_time;
+    section.wall_time_total += wall_time;
+    section.mpi_time += master.get_mpi_wait_time() - section.mpi_start;
+    ++section.ncalls;
+    ++section.ncalls_total;
+
+    #ifdef USECUDA
+    cuda_safe_call(cudaEventRecord(section.event_stop));
+    section.pending = true;
+    #endif
+
+    if (swenergy)
+    {
+        #ifdef USECUDA
+        cuda_safe_call(cudaDeviceSynchronize());
+        #endif
+        section.cpu_energy += read_cpu_energy() - section.cpu_energy_start;
+        section.gpu_energy += read_gpu_energy() - section.gpu_energy_start;
+    }
+}
+
+double Timer::get_imbalance(const std::string& name) const
+{
+    auto it = sections.find(name);
+    return (it == sections.end()) ? 1. : it->second.imbalance;
+}
+
+void Timer::report_imbalance(const std::vector<double>& wall_local)
+{
+    const int nsections = names.size();
+    const int nprocs = master.get_MPI_data().nprocs;
+
+    // The times are gathered as [process][section] on the main process.
+    std::vector<double> wall_all;
+    if (master.get_mpiid() == 0)
+        wall_all.resize(nprocs*nsections);
+
+    master.gather(wall_local.data(), wall_all.data(), nsections);
+
+    if (master.get_mpiid() != 0)
+        return;
+
+    const int nbins = 10;
+
+    for (int n=0; n<nsections; ++n)
+    {
+        const double imbalance = sections.at(names[n]).imbalance;
+        if (imbalance <= imbalance_threshold)
+            continue;
+
+        double wall_min = wall_all[n];
+        double wall_max = wall_all[n];
+        int slowest = 0;
+        for (int p=1; p<nprocs; ++p)
+        {
+            const double wall = wall_all[p*nsections + n];
+            wall_min = std::min(wall_min, wall);
+            if (wall > wall_max)
+            {
+                wall_max = wall;
+                slowest = p;
+            }
+        }
+
+        // Number of processes per bin of equal width between the fastest and the slowest process.
+        std::vector<int> histogram(nbins, 0);
+        const double bin_width = (wall_max - wall_min) / nbins;
+        for (int p=0; p<nprocs; ++p)
+        {
+            const double wall = wall_all[p*nsections + n];
+            const int bin = (bin_width > 0.) ? std::min(static_cast<int>((wall - wall_min) / bin_width), nbins-1) : 0;
+            ++histogram[bin];
+        }
+
+        std::ostringstream message;
+        message << std::fixed << std::setprecision(2)
+            << "Imbalance in " << names[n] << ": max/mean = " << imbalance
+            << ", slowest process " << slowest
+            << ", time " << std::setprecision(3) << wall_min << " - " << wall_max << " s, histogram:";
+        for (const int count : histogram)
+            message << " " << count;
+        message << std::endl;
+
+        master.print_message(message);
+    }
+}
+
+#ifdef USECUDA
+void Timer::add_gpu_time(Section& section)
+{
+    float elapsed;
+    cuda_safe_call(cudaEventSynchronize(section.event_stop));
+    cuda_safe_call(cudaEventElapsedTime(&elapsed, section.event_start, section.event_stop));
+
+    // The events measure in milliseconds.
+    section.gpu_time += 1.e-3*elapsed;
+    section.pending = false;
+}
+#endif
+
+void Timer::exec(const int iteration, const double time)
+{
+    if (!swtimer || iteration == 0 || iteration % interval != 0)
+        return;
+
+    const int nsections = names.size();
+    const int nprocs = master.get_MPI_data().nprocs;
+
+    // The sections are stored as [wall, mpi, gpu] per section for a single reduction per operation,
+    // followed by the CPU and GPU energy per iteration with swenergy.
+    const int nvars = swenergy ? 5 : 3;
+    std::vector<double> times_min(nvars*nsections);
+
+    for (int n=0; n<nsections; ++n)
+    {
+        Section& section = sections.at(names[n]);
+
+        #ifdef USECUDA
+        if (section.pending)
+            add_gpu_time(section);
+        #endif
+
+        times_min[n*nvars  ] = section.wall_time;
+        times_min[n*nvars+1] = section.mpi_time;
+        times_min[n*nvars+2] = section.gpu_time;
+
+        if (swenergy)
+        {
+            times_min[n*nvars+3] = section.cpu_energy / interval;
+            times_min[n*nvars+4] = section.gpu_energy / interval;
+        }
+    }
+
+    std::vector<double> times_max(times_min);
+    std::vector<double> times_sum(times_min);
+
+    master.min(times_min.data(), nvars*nsections);
+    master.max(times_max.data(), nvars*nsections);
+    master.sum(times_sum.data(), nvars*nsections);
+
+    for (int n=0; n<nsections; ++n)
+    {
+        const double wall_mean = times_sum[n*nvars]/nprocs;
+        sections.at(names[n]).imbalance = (wall_mean > 0.) ? times_max[n*nvars]/wall_mean : 1.;
+    }
+
+    if (nprocs > 1)
+    {
+        std::vector<double> wall_local(nsections);
+        for (int n=0; n<nsections; ++n)
+            wall_local[n] = sections.at(names[n]).wall_time;
+        report_imbalance(wall_local);
+    }
+
+    if (master.get_mpiid() == 0)
+    {
+        if (timing_file == nullptr)
+        {
+            std::string filename = sim_name + ".timing";
+            timing_file = std::fopen(filename.c_str(), "a");
+            if (timing_file == nullptr)
+                throw std::runtime_error("Cannot open \"" + filename + "\"");
+
+            std::fprintf(timing_file,
+                    "iteration,time,section,ncalls,"
+                    "wall_min,wall_mean,wall_max,"
+                    "mpi_min,mpi_mean,mpi_max,"
+                    "gpu_min,gpu_mean,gpu_max%s\n",
+                    swenergy ?
+                        ",cpu_j_per_iter_min,cpu_j_per_iter_mean,cpu_j_per_iter_max"
+                        ",gpu_j_per_iter_min,gpu_j_per_iter_mean,gpu_j_per_iter_max" : "");
+        }
+
+        for (int n=0; n<nsections; ++n)
+        {
+            std::fprintf(timing_file, "%d,%.6G,%s,%d", iteration, time, names[n].c_str(), sections.at(names[n]).ncalls);
+
+            for (int v=0; v<nvars; ++v)
+            {
+                const int nv = n*nvars + v;
+                std::fprintf(timing_file, ",%.6E,%.6E,%.6E", times_min[nv], times_sum[nv]/nprocs, times_max[nv]);
+            }
+
+            std::fprintf(timing_file, "\n");
+        }
+
+        std::fflush(timing_file);
+    }
+
+    for (auto& it : sections)
+    {
+        it.second.ncalls = 0;
+        it.second.wall_time = 0.;
+        it.second.mpi_time = 0.;
+        it.second.gpu_time = 0.;
+        it.second.cpu_energy = 0.;
+        it.second.gpu_energy = 0.;
+    }
+}
+
+void Timer::finish()
+{
+    if (!swtimer || papi_events.empty())
+        return;
+
+    #ifdef USEPAPI
+    if (use_papi)
+        PAPI_stop(papi_event_set, papi_values.data());
+    #endif
+
+    // The counters and the wall clock time are summed over the counting processes. Every process
+    // has the same sections, as the sections follow the calls of the time loop.
+    const int nsections = names.size();
+    const int nevents = papi_events.size();
+    const int nvars = nevents + 1;
+
+    std::vector<double> totals(nvars*nsections+1, 0.);
+    for (int n=0; n<nsections; ++n)
+    {
+        const Section& section = sections.at(names[n]);
+        if (!use_papi)
+            continue;
+
+        for (int e=0; e<nevents; ++e)
+            totals[n*nvars + e] = static_cast<double>(section.papi_count[e]);
+        totals[n*nvars + nevents] = section.wall_time_total;
+    }
+    totals[nvars*nsections] = use_papi ? 1. : 0.;
+
+    master.sum(totals.data(), nvars*nsections+1);
+
+    if (master.get_mpiid() != 0)
+        return;
+
+    const double nsampled = std::max(1., totals[nvars*nsections]);
+
+    std::string filename = sim_name + ".papi";
+    std::FILE* papi_file = std::fopen(filename.c_str(), "w");
+    if (papi_file == nullptr)
+        throw std::runtime_error("Cannot open \"" + filename + "\"");
+
+    // Per section the mean over the counting processes of the total count and of the count per second.
+    std::fprintf(papi_file, "section,ncalls,wall_mean");
+    for (auto& event : papi_events)
+        std::fprintf(papi_file, ",%s,%s_per_s", event.c_str(), event.c_str());
+    std::fprintf(papi_file, "\n");
+
+    for (int n=0; n<nsections; ++n)
+    {
+        const double wall_mean = totals[n*nvars + nevents] / nsampled;
+        std::fprintf(papi_file, "%s,%d,%.6E", names[n].c_str(), sections.at(names[n]).ncalls_total, wall_mean);
+
+        for (int e=0; e<nevents; ++e)
+        {
+            const double count_mean = totals[n*nvars + e] / nsampled;
+            std::fprintf(papi_file, ",%.6E,%.6E", count_mean, (wall_mean > 0.) ? count_mean/wall_mean : 0.);
+        }
+
+        std::fprintf(papi_file, "\n");
+    }
+
+    std::fclose(papi_file);
+}
@@ -20,6 +20,10 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
 #include "master.h"
 #include "grid.h"
 #include "transpose.h"
@@ -28,8 +32,12 @@ template<typename TF>
 Transpose<TF>::Transpose(Master& masterin, Grid<TF>& gridin) :
     master(masterin),
     grid(gridin),
-    mpi_types_allocated(false)
+    mpi_types_allocated(false),
+    nchunks(1)
 {
+    #ifdef USEMPI
+    sw_packed = false;
+    #endif
 }
 
 template<typename TF>
@@ -39,11 +47,36 @@ Transpose<TF>::~Transpose()
 }
 
 template<typename TF>
-void Transpose<TF>::init()
+void Transpose<TF>::init(const int nchunks_in)
 {
+    set_nchunks(nchunks_in);
     init_mpi();
 }
 
+template<typename TF>
+void Transpose<TF>::set_nchunks(const int nchunks_in)
+{
+    auto& gd = grid.get_grid_data();
+
+    if (gd.kblock % nchunks_in != 0)
+    {
+        std::string msg = "kblock = " + std::to_string(gd.kblock) + " is not a multiple of nfftchunks = " + std::to_string(nchunks_in);
+        throw std::runtime_error(msg);
+    }
+
+    nchunks = nchunks_in;
+
+    // Only the chunk datatypes depend on the number of chunks.
+    #ifdef USEMPI
+    if (mpi_types_allocated)
+    {
+        MPI_Type_free(&transposex2_chunk);
+        MPI_Type_free(&transposey_chunk);
+        init_chunk_mpi();
+    }
+    #endif
+}
+
 #ifdef USEMPI
 namespace
 {
@@ -97,9 +130,118 @@ void Transpose<TF>::init_mpi()
     MPI_Type_vector(datacount, datablock, datastride, mpi_fp_type<TF>(), &transposey2);
     MPI_Type_commit(&transposey2);
 
+    init_chunk_mpi();
+
+    sw_packed = master.get_packed_transpose();
+
+    if (sw_packed)
+    {
+        auto& md = master.get_MPI_data();
+
+        // The buffers are allocated once, as the persistent requests are bound to their addresses.
+        const int nbuffer = std::max({
+                gd.imax*gd.jmax*gd.kblock*md.npx,
+                gd.iblock*gd.jmax*gd.kblock*md.npy,
+                gd.iblock*gd.jblock*gd.kblock*md.npx});
+
+        send_buffer.resize(nbuffer);
+        recv_buffer.resize(nbuffer);
+
+        // Base blocks with the same layouts as the MPI datatypes above.
+        const int blockz  = gd.imax*gd.jmax*gd.kblock;
+        const int blockz2 = gd.iblock*gd.jblock*gd.kblock;
+
+        const Block_layout z  = {blockz, 1, blockz, blockz};
+        const Block_layout z2 = {blockz2, 1, blockz2, blockz2};
+        const Block_layout x  = {gd.imax, gd.jmax*gd.kblock, gd.imax, gd.itot};
+        const Block_layout x2 = {gd.iblock, gd.jmax*gd.kblock, gd.iblock, gd.itot};
+        const Block_layout y  = {gd.iblock*gd.jmax, gd.kblock, gd.iblock*gd.jmax, gd.iblock*gd.jtot};
+        const Block_layout y2 = {gd.iblock*gd.jblock, gd.kblock, gd.iblock*gd.jblock, gd.iblock*gd.jtot};
+
+        init_plan(plan_zx, md.npx, md.commx, z , x , Comm_site::Transpose_zx);
+        init_plan(plan_xz, md.npx, md.commx, x , z , Comm_site::Transpose_xz);
+        init_plan(plan_xy, md.npy, md.commy, x2, y , Comm_site::Transpose_xy);
+        init_plan(plan_yx, md.npy, md.commy, y , x2, Comm_site::Transpose_yx);
+        init_plan(plan_yz, md.npx, md.commx, y2, z2, Comm_site::Transpose_yz);
+        init_plan(plan_zy, md.npx, md.commx, z2, y2, Comm_site::Transpose_zy);
+    }
+
     mpi_types_allocated = true;
 }
 
+template<typename TF>
+void Transpose<TF>::init_chunk_mpi()
+{
+    auto& gd = grid.get_grid_data();
+
+    int datacount, datablock, datastride;
+
+    // Chunks of kblock/nchunks slices of transposex2 and transposey.
+    const int kchunk = gd.kblock / nchunks;
+
+    datacount  = gd.jmax*kchunk;
+    datablock  = gd.iblock;
+    datastride = gd.itot;
+    MPI_Type_vector(datacount, datablock, datastride, mpi_fp_type<TF>(), &transposex2_chunk);
+    MPI_Type_commit(&transposex2_chunk);
+
+    datacount  = kchunk;
+    datablock  = gd.iblock*gd.jmax;
+    datastride = gd.iblock*gd.jtot;
+    MPI_Type_vector(datacount, datablock, datastride, mpi_fp_type<TF>(), &transposey_chunk);
+    MPI_Type_commit(&transposey_chunk);
+
+    chunk_reqs.resize(nchunks);
+    chunk_sites.resize(nchunks, Comm_site::Other);
+}
+
+template<typename TF>
+void Transpose<TF>::init_plan(
+        Transpose_plan& plan, const int np, MPI_Comm comm,
+        const Block_layout& send, const Block_layout& recv, Comm_site site)
+{
+    const int tag = 1;
+    const int nblock = send.count*send.blocklen;
+
+    plan.np = np;
+    plan.send = send;
+    plan.recv = recv;
+    plan.site = site;
+    plan.reqs.resize(2*np);
+
+    for (int n=0; n<np; ++n)
+    {
+        MPI_Send_init(&send_buffer[n*nblock], nblock, mpi_fp_type<TF>(), n, tag, comm, &plan.reqs[2*n  ]);
+        MPI_Recv_init(&recv_buffer[n*nblock], nblock, mpi_fp_type<TF>(), n, tag, comm, &plan.reqs[2*n+1]);
+    }
+}
+
+template<typename TF>
+void Transpose<TF>::exec_plan(Transpose_plan& plan, TF* const restrict ar, const TF* const restrict as)
+{
+    const Block_layout& send = plan.send;
+    const Block_layout& recv = plan.recv;
+    const int nblock = send.count*send.blocklen;
+
+    // Pack the blocks of all processes into the contiguous send buffer.
+    for (int n=0; n<plan.np; ++n)
+        for (int c=0; c<send.count; ++c)
+            #pragma ivdep
+            for (int b=0; b<send.blocklen; ++b)
+                send_buffer[n*nblock + c*send.blocklen + b] = as[n*send.offset + c*send.stride + b];
+
+    MPI_Startall(plan.reqs.size(), plan.reqs.data());
+    master.add_comm(plan.site, static_cast<double>(plan.np)*nblock*sizeof(TF), plan.np);
+    master.wait_all(plan.reqs.size(), plan.reqs.data(), plan.site);
+
+    // Unpack the received blocks into their strided positions.
+    for (int n=0; n<plan.np; ++n)
+        for (int c=0; c<recv.count; ++c)
+            #pragma ivdep
+            for (int b=0; b<recv.blocklen; ++b)
+                ar[n*recv.offset + c*recv.stride + b] = recv_buffer[n*nblock + c*recv.blocklen + b];
+}
+
 template<typename TF>
 void Transpose<TF>::exit_mpi()
 {
@@ -111,12 +253,27 @@ void Transpose<TF>::exit_mpi()
         MPI_Type_free(&transposex2);
         MPI_Type_free(&transposey);
         MPI_Type_free(&transposey2);
+        MPI_Type_free(&transposex2_chunk);
+        MPI_Type_free(&transposey_chunk);
+
+        if (sw_packed)
+        {
+            for (Transpose_plan* plan : {&plan_zx, &plan_xz, &plan_xy, &plan_yx, &plan_yz, &plan_zy})
+                for (MPI_Request& req : plan->reqs)
+                    MPI_Request_free(&req);
+        }
     }
 }
 
 template<typename TF>
 void Transpose<TF>::exec_zx(TF* const restrict ar, TF* const restrict as)
 {
+    if (sw_packed)
+    {
+        exec_plan(plan_zx, ar, as);
+        return;
+    }
+
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
 
@@ -137,12 +294,19 @@ void Transpose<TF>::exec_zx(TF* const restrict ar, TF* const restrict as)
         MPI_Irecv(&ar[ijkr], ncount, transposex, n, tag, md.commx, master.get_request_ptr());
     }
 
-    master.wait_all();
+    master.add_comm(Comm_site::Transpose_zx, transposez, md.npx);
+    master.wait_all(Comm_site::Transpose_zx);
 }
 
 template<typename TF>
 void Transpose<TF>::exec_xz(TF* const restrict ar, TF* const restrict as)
 {
+    if (sw_packed)
+    {
+        exec_plan(plan_xz, ar, as);
+        return;
+    }
+
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
 
@@ -163,12 +327,19 @@ void Transpose<TF>::exec_xz(TF* const restrict ar, TF* const restrict as)
         MPI_Irecv(&ar[ijkr], ncount, transposez, n, tag, md.commx, master.get_request_ptr());
     }
 
-    master.wait_all();
+    master.add_comm(Comm_site::Transpose_xz, transposex, md.npx);
+    master.wait_all(Comm_site::Transpose_xz);
 }
 
 template<typename TF>
 void Transpose<TF>::exec_xy(TF* const restrict ar, TF* const restrict as)
 {
+    if (sw_packed)
+    {
+        exec_plan(plan_xy, ar, as);
+        return;
+    }
+
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
 
@@ -189,12 +360,19 @@ void Transpose<TF>::exec_xy(TF* const restrict ar, TF* const restrict as)
         MPI_Irecv(&ar[ijkr], ncount, transposey , n, tag, md.commy, master.get_request_ptr());
     }
 
-    master.wait_all();
+    master.add_comm(Comm_site::Transpose_xy, transposex2, md.npy);
+    master.wait_all(Comm_site::Transpose_xy);
 }
 
 template<typename TF>
 void Transpose<TF>::exec_yx(TF* const restrict ar, TF* const restrict as)
 {
+    if (sw_packed)
+    {
+        exec_plan(plan_yx, ar, as);
+        return;
+    }
+
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
 
@@ -215,12 +393,19 @@ void Transpose<TF>::exec_yx(TF* const restrict ar, TF* const restrict as)
         MPI_Irecv(&ar[ijkr], ncount, transposex2, n, tag, md.commy, master.get_request_ptr());
     }
 
-    master.wait_all();
+    master.add_comm(Comm_site::Transpose_yx, transposey, md.npy);
+    master.wait_all(Comm_site::Transpose_yx);
 }
 
 template<typename TF>
 void Transpose<TF>::exec_yz(TF* const restrict ar, TF* const restrict as)
 {
+    if (sw_packed)
+    {
+        exec_plan(plan_yz, ar, as);
+        return;
+    }
+
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
 
@@ -241,12 +426,19 @@ void Transpose<TF>::exec_yz(TF* const restrict ar, TF* const restrict as)
         MPI_Irecv(&ar[ijkr], ncount, transposez2, n, tag, md.commx, master.get_request_ptr());
     }
 
-    master.wait_all();
+    master.add_comm(Comm_site::Transpose_yz, transposey2, md.npx);
+    master.wait_all(Comm_site::Transpose_yz);
 }
 
 template<typename TF>
 void Transpose<TF>::exec_zy(TF* const restrict ar, TF* const restrict as)
 {
+    if (sw_packed)
+    {
+        exec_plan(plan_zy, ar, as);
+        return;
+    }
+
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
 
@@ -267,8 +459,75 @@ void Transpose<TF>::exec_zy(TF* const restrict ar, TF* const restrict as)
         MPI_Irecv(&ar[ijkr], ncount, transposey2, n, tag, md.commx, master.get_request_ptr());
     }
 
-    master.wait_all();
+    master.add_comm(Comm_site::Transpose_zy, transposez2, md.npx);
+    master.wait_all(Comm_site::Transpose_zy);
+}
+template<typename TF>
+void Transpose<TF>::exec_xy_begin(TF* const restrict ar, TF* const restrict as, const int chunk)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int ncount = 1;
+    const int tag = chunk + 1;
+
+    // The x- and y-orientation have the same number of points per slice.
+    const int jj = gd.iblock;
+    const int kk = gd.iblock*gd.jmax;
+    const int k0 = chunk*(gd.kblock/nchunks)*gd.itot*gd.jmax;
+
+    std::vector<MPI_Request>& reqs = chunk_reqs[chunk];
+    reqs.resize(2*md.npy);
+
+    for (int n=0; n<md.npy; ++n)
+    {
+        const int ijks = n*jj + k0;
+        const int ijkr = n*kk + k0;
+
+        MPI_Isend(&as[ijks], ncount, transposex2_chunk, n, tag, md.commy, &reqs[2*n  ]);
+        MPI_Irecv(&ar[ijkr], ncount, transposey_chunk , n, tag, md.commy, &reqs[2*n+1]);
+    }
+
+    master.add_comm(Comm_site::Transpose_xy, transposex2_chunk, md.npy);
+    chunk_sites[chunk] = Comm_site::Transpose_xy;
+}
+
+template<typename TF>
+void Transpose<TF>::exec_yx_begin(TF* const restrict ar, TF* const restrict as, const int chunk)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const int ncount = 1;
+    const int tag = chunk + 1;
+
+    const int jj = gd.iblock;
+    const int kk = gd.iblock*gd.jmax;
+    const int k0 = chunk*(gd.kblock/nchunks)*gd.itot*gd.jmax;
+
+    std::vector<MPI_Request>& reqs = chunk_reqs[chunk];
+    reqs.resize(2*md.npy);
+
+    for (int n=0; n<md.npy; ++n)
+    {
+        const int ijks = n*kk + k0;
+        const int ijkr = n*jj + k0;
+
+        MPI_Isend(&as[ijks], ncount, transposey_chunk , n, tag, md.commy, &reqs[2*n  ]);
+        MPI_Irecv(&ar[ijkr], ncount, transposex2_chunk, n, tag, md.commy, &reqs[2*n+1]);
+    }
+
+    master.add_comm(Comm_site::Transpose_yx, transposey_chunk, md.npy);
+    chunk_sites[chunk] = Comm_site::Transpose_yx;
 }
+
+template<typename TF>
+void Transpose<TF>::exec_chunk_finish(const int chunk)
+{
+    std::vector<MPI_Request>& reqs = chunk_reqs[chunk];
+    master.wait_all(reqs.size(), reqs.data(), chunk_sites[chunk]);
+}
+
 #else
 
 template<typename TF>
@@ -276,10 +535,30 @@ void Transpose<TF>::init_mpi()
 {
 }
 
+template<typename TF>
+void Transpose<TF>::init_chunk_mpi()
+{
+}
+
 template<typename TF>
 void Transpose<TF>::exit_mpi()
 {
 }
+
+template<typename TF>
+void Transpose<TF>::exec_xy_begin(TF* const restrict, TF* const restrict, const int)
+{
+}
+
+template<typename TF>
+void Transpose<TF>::exec_yx_begin(TF* const restrict, TF* const restrict, const int)
+{
+}
+
+template<typename TF>
+void Transpose<TF>::exec_chunk_finish(const int)
+{
+}
 #endif
 
 
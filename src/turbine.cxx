@@ -56,6 +56,8 @@ Turbine<TF>::Turbine(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin,
     next_yaw = turbstarttime;
     // Precompute rotor disk area
     area = M_PI * diam * diam * TF(0.25);
+    umean = 0;
+    thrust = 0;
     power = 0;
 }
 
@@ -108,103 +110,102 @@ void Turbine<TF>::create()
             }
         }
 
-    // Normalise weights so they sum to one
-    TF wsum = std::accumulate(weights.begin(), weights.end(), TF(0));
+    // The weights are normalised by the windfarm, as the disk can span multiple ranks.
+}
+
+template<typename TF>
+TF Turbine<TF>::get_weight_sum() const
+{
+    return std::accumulate(weights.begin(), weights.end(), TF(0));
+}
+
+template<typename TF>
+void Turbine<TF>::normalise_weights(const TF wsum)
+{
+    // Normalise weights so they sum to one over the full disk
     if (wsum > TF(0))
         for (auto& w : weights)
             w /= wsum;
 }
 
 template<typename TF>
-void Turbine<TF>::exec(Stats<TF>&, double time)
+int Turbine<TF>::get_yaw_reference_index() const
 {
-    // Skip forcing until turbine start time
-    if (time < turbstarttime)
-        return;
-
-    // Access velocity fields and grid information
-    auto& u = fields.mp.at("u")->fld;
-    auto& v = fields.mp.at("v")->fld;
     auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
 
-    const int jj = gd.jstride;
-    const int kk = gd.kstride;
+    // Cell one diameter upstream of current yaw, on the periodic global grid
+    const TF xref = xpos - diam * std::cos(yaw);
+    const TF yref = ypos - diam * std::sin(yaw);
 
-    // Update yaw based on upstream flow measurement
-    if (swdynyaw && time >= next_yaw)
+    auto nearest_index = [](TF val, TF dx, int itot)
     {
-        // find cell one diameter upstream of current yaw
-        TF xref = xpos - diam * std::cos(yaw);
-        TF yref = ypos - diam * std::sin(yaw);
+        int i = static_cast<int>(std::floor(val / dx));
+        i %= itot;
+        return (i < 0) ? i + itot : i;
+    };
 
-        auto nearest_index = [](TF val, const std::vector<TF>& arr, int s, int e)
-        {
-            int idx = s;
-            TF md = std::abs(arr[s] - val);
-            for (int i=s+1; i<e; ++i)
-            {
-                TF d = std::abs(arr[i] - val);
-                if (d < md)
-                {
-                    md = d;
-                    idx = i;
-                }
-            }
-            return idx;
-        };
+    const int i_glob = nearest_index(xref, gd.dx, gd.itot);
+    const int j_glob = nearest_index(yref, gd.dy, gd.jtot);
 
-        int iu = nearest_index(xref, gd.x, gd.istart, gd.iend);
-        int ju = nearest_index(yref, gd.y, gd.jstart, gd.jend);
-        int idx = iu + ju*jj + k_hub*kk;
+    // Only the rank that contains the reference point returns its index
+    const int i = i_glob - md.mpicoordx*gd.imax;
+    const int j = j_glob - md.mpicoordy*gd.jmax;
 
-        TF ur = u[idx];
-        TF vr = v[idx];
+    if (i < 0 || i >= gd.imax || j < 0 || j >= gd.jmax)
+        return -1;
 
-        TF target = std::atan2(vr, ur);      // target wind direction
-        yaw += (target - yaw) * TF(0.2);      // relax toward target
+    return (i + gd.istart) + (j + gd.jstart)*gd.jstride + k_hub*gd.kstride;
+}
 
-        next_yaw += yawperiod;
-    }
+template<typename TF>
+void Turbine<TF>::update_yaw(const TF ur, const TF vr)
+{
+    TF target = std::atan2(vr, ur);      // target wind direction
+    yaw += (target - yaw) * TF(0.2);      // relax toward target
 
-    // Calculate disk-averaged incoming velocity
-    TF umean = 0;
-    for (size_t n=0; n<indices.size(); ++n)
-    {
-        int idx = indices[n];
-        umean += weights[n] * (u[idx]*std::cos(yaw) + v[idx]*std::sin(yaw));
-    }
+    next_yaw += yawperiod;
+}
 
-    // Compute thrust force and power from disk-averaged velocity
-    TF thrust = 0.5 * ct * umean * std::abs(umean);
-    TF powloc = cp * 0.5 * umean * umean * umean * area;
-    power = powloc;
+template<typename TF>
+void Turbine<TF>::calc_disk_sums(TF& su, TF& sv, const TF* const u, const TF* const v) const
+{
+    su = TF(0);
+    sv = TF(0);
 
-    // Apply actuator disk forcing to all covered cells
     for (size_t n=0; n<indices.size(); ++n)
     {
-        int idx = indices[n];
-        TF f = thrust * weights[n];
-        u[idx] -= f * std::cos(yaw);
-        v[idx] -= f * std::sin(yaw);
+        const int idx = indices[n];
+        su += weights[n] * u[idx];
+        sv += weights[n] * v[idx];
     }
 }
 
 template<typename TF>
-void Turbine<TF>::prepare_device()
+void Turbine<TF>::set_disk_velocity(const TF su, const TF sv)
 {
-#ifdef USECUDA
-    // Allocate GPU resources (placeholder)
-    dummy_g.allocate(1);
-#endif
+    // Disk-averaged incoming velocity in the rotor-normal direction
+    umean = su*std::cos(yaw) + sv*std::sin(yaw);
+
+    // Compute thrust force and power from disk-averaged velocity
+    thrust = 0.5 * ct * umean * std::abs(umean);
+    power  = cp * 0.5 * umean * umean * umean * area;
 }
 
 template<typename TF>
-void Turbine<TF>::clear_device()
+void Turbine<TF>::apply_forcing(TF* const u, TF* const v) const
 {
-#ifdef USECUDA
-    // Release GPU resources (placeholder)
-    dummy_g.clear();
-#endif
+    const TF cos_yaw = std::cos(yaw);
+    const TF sin_yaw = std::sin(yaw);
+
+    // Apply actuator disk forcing to all covered cells
+    for (size_t n=0; n<indices.size(); ++n)
+    {
+        const int idx = indices[n];
+        const TF f = thrust * weights[n];
+        u[idx] -= f * cos_yaw;
+        v[idx] -= f * sin_yaw;
+    }
 }
 
 #ifdef FLOAT_SINGLE
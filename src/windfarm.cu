@@ -20,10 +20,230 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <vector>
+
 #include "windfarm.h"
+#include "master.h"
+#include "grid.h"
+#include "fields.h"
+#include "stats.h"
+#include "tools.h"
 
 #ifdef USECUDA
+namespace
+{
+    // Weighted sums of u and v over the disk of each turbine, one block per turbine.
+    template<typename TF, int block_size> __global__
+    void calc_disk_sums_g(
+            TF* const __restrict__ disk_sums,
+            const TF* const __restrict__ u, const TF* const __restrict__ v,
+            const int* const __restrict__ indices, const TF* const __restrict__ weights,
+            const int* const __restrict__ cell_offsets)
+    {
+        __shared__ TF su[block_size];
+        __shared__ TF sv[block_size];
+
+        const int t = blockIdx.x;
+        const int tid = threadIdx.x;
+
+        TF su_loc = TF(0);
+        TF sv_loc = TF(0);
+
+        for (int n=cell_offsets[t]+tid; n<cell_offsets[t+1]; n+=block_size)
+        {
+            su_loc += weights[n] * u[indices[n]];
+            sv_loc += weights[n] * v[indices[n]];
+        }
+
+        su[tid] = su_loc;
+        sv[tid] = sv_loc;
+        __syncthreads();
+
+        for (int s=block_size/2; s>0; s/=2)
+        {
+            if (tid < s)
+            {
+                su[tid] += su[tid+s];
+                sv[tid] += sv[tid+s];
+            }
+            __syncthreads();
+        }
+
+        if (tid == 0)
+        {
+            disk_sums[2*t  ] = su[0];
+            disk_sums[2*t+1] = sv[0];
+        }
+    }
+
+    // Actuator disk forcing of the cells of all turbines.
+    template<typename TF> __global__
+    void apply_forcing_g(
+            TF* const __restrict__ u, TF* const __restrict__ v,
+            const int* const __restrict__ indices, const TF* const __restrict__ weights,
+            const int* const __restrict__ cell_turbine, const TF* const __restrict__ force,
+            const int n_cells)
+    {
+        const int n = blockIdx.x*blockDim.x + threadIdx.x;
+
+        if (n < n_cells)
+        {
+            const int t = cell_turbine[n];
+            u[indices[n]] -= force[2*t  ] * weights[n];
+            v[indices[n]] -= force[2*t+1] * weights[n];
+        }
+    }
+}
+
+template<typename TF>
+void Windfarm<TF>::prepare_device()
+{
+    // Concatenate the disk stencils of all turbines
+    std::vector<int> cell_turbine;
+    std::vector<int> indices;
+    std::vector<TF> weights;
+
+    cell_offsets.clear();
+    cell_offsets.push_back(0);
+
+    for (size_t n=0; n<turbines.size(); ++n)
+    {
+        const auto& ind = turbines[n].get_indices();
+        const auto& w = turbines[n].get_weights();
+
+        indices.insert(indices.end(), ind.begin(), ind.end());
+        weights.insert(weights.end(), w.begin(), w.end());
+        cell_turbine.insert(cell_turbine.end(), ind.size(), n);
+
+        cell_offsets.push_back(indices.size());
+    }
+
+    cell_offsets_g.from_vector(cell_offsets);
+    cell_turbine_g.from_vector(cell_turbine);
+    indices_g.from_vector(indices);
+    weights_g.from_vector(weights);
+
+    disk_sums_g.allocate(2*turbines.size());
+    force_g.allocate(2*turbines.size());
+
+    if (actuator_line)
+        actuator_line->prepare_device();
+}
+
+template<typename TF>
+void Windfarm<TF>::clear_device()
+{
+    cell_offsets_g.free();
+    cell_turbine_g.free();
+    indices_g.free();
+    weights_g.free();
+    disk_sums_g.free();
+    force_g.free();
+
+    if (actuator_line)
+        actuator_line->clear_device();
+}
+
+template<typename TF>
+void Windfarm<TF>::exec(Stats<TF>& stats, double time)
+{
+    farm_power = 0; // reset accumulator
+
+    const int nturb = turbines.size();
+    if (nturb == 0)
+        return;
+
+    TF* const u_g = fields.mp.at("u")->fld_g;
+    TF* const v_g = fields.mp.at("v")->fld_g;
+
+    const int n_cells = cell_offsets.back();
+    constexpr int block_size = 128;
+
+    // Disk sums of all turbines in one launch
+    std::vector<TF> disk_sums(2*nturb, TF(0));
+
+    if (n_cells > 0)
+    {
+        calc_disk_sums_g<TF, block_size><<<nturb, block_size>>>(
+                disk_sums_g, u_g, v_g, indices_g, weights_g, cell_offsets_g);
+        cuda_check_error();
+
+        cuda_copy<TF>(disk_sums_g, disk_sums.data(), 2*nturb);
+    }
+
+    // Combine the disk sums, yaw reference velocities and blade element velocities
+    // over the ranks in a single reduction.
+    const int n_elem = actuator_line ? actuator_line->get_n_elements() : 0;
+    std::vector<TF> sums(n_sums*nturb + 3*n_elem, TF(0));
+
+    if (actuator_line)
+    {
+        actuator_line->advance(turbines, time);
+        actuator_line->sample(&sums[n_sums*nturb]);
+    }
+
+    for (int n=0; n<nturb; ++n)
+    {
+        auto& t = turbines[n];
+
+        if (!t.is_active(time))
+            continue;
+
+        sums[n_sums*n  ] = disk_sums[2*n  ];
+        sums[n_sums*n+1] = disk_sums[2*n+1];
+
+        if (t.is_yaw_update(time))
+        {
+            const int idx = t.get_yaw_reference_index();
+            if (idx >= 0)
+            {
+                cuda_copy<TF>(u_g + idx, &sums[n_sums*n+2], 1);
+                cuda_copy<TF>(v_g + idx, &sums[n_sums*n+3], 1);
+            }
+        }
+    }
+
+    master.sum(sums.data(), sums.size());
+
+    std::vector<TF> force(2*nturb, TF(0));
+
+    for (int n=0; n<nturb; ++n)
+    {
+        auto& t = turbines[n];
+
+        if (!t.is_active(time))
+            continue;
+
+        if (t.is_yaw_update(time))
+            t.update_yaw(sums[n_sums*n+2], sums[n_sums*n+3]);
+
+        t.set_disk_velocity(sums[n_sums*n], sums[n_sums*n+1]);
+
+        force[2*n  ] = t.get_thrust() * std::cos(t.get_yaw());
+        force[2*n+1] = t.get_thrust() * std::sin(t.get_yaw());
+    }
+
+    if (actuator_line)
+        actuator_line->exec(turbines, &sums[n_sums*nturb], time);
+    else if (n_cells > 0)
+    {
+        cuda_copy<TF>(force.data(), force_g, 2*nturb);
+
+        const int grid_size = n_cells/block_size + (n_cells%block_size > 0);
+        apply_forcing_g<TF><<<grid_size, block_size>>>(
+                u_g, v_g, indices_g, weights_g, cell_turbine_g, force_g, n_cells);
+        cuda_check_error();
+    }
+
+    for (auto& t : turbines)
+        if (t.is_active(time))
+            farm_power += t.get_power();
+}
+#endif
 
-// Placeholder for future GPU kernels related to farm-level operations
 
+#ifdef FLOAT_SINGLE
+template class Windfarm<float>;
+#else
+template class Windfarm<double>;
 #endif
@@ -27,6 +27,7 @@
 #include "input.h"
 #include "stats.h"
 #include <fstream>
+#include <vector>
 #include <stdexcept>
 
 template<typename TF>
@@ -43,6 +44,12 @@ Windfarm<TF>::Windfarm(Master& masterin, Grid<TF>& gridin, Fields<TF>& fieldsin,
     farmlocy   = inputin.get_item<TF>("windfarm", "farmlocy", "", TF(0));
     layoutfile = inputin.get_item<std::string>("windfarm", "layoutfile", "", "");
     diam       = inputin.get_item<TF>("turbine", "diam", "");
+    swmodel    = inputin.get_item<std::string>("turbine", "swmodel", "", "disk");
+
+    if (swmodel == "line")
+        actuator_line = std::make_unique<Actuator_line<TF>>(masterin, gridin, fieldsin, inputin);
+    else if (swmodel != "disk")
+        throw std::runtime_error("Invalid option for \"swmodel\", options are \"disk\" and \"line\"");
     farm_power = 0; // initialise aggregate power
 }
 
@@ -94,34 +101,93 @@ void Windfarm<TF>::create()
             }
         }
     }
+
+    // Normalise the disk weights with their sums over all ranks,
+    // such that turbines that span a rank boundary are correct.
+    std::vector<TF> wsum(turbines.size());
+    for (size_t n=0; n<turbines.size(); ++n)
+        wsum[n] = turbines[n].get_weight_sum();
+
+    if (turbines.size() > 0)
+        master.sum(wsum.data(), turbines.size());
+
+    for (size_t n=0; n<turbines.size(); ++n)
+        turbines[n].normalise_weights(wsum[n]);
+
+    if (actuator_line)
+        actuator_line->create(turbines);
 }
 
+#ifndef USECUDA
 template<typename TF>
 void Windfarm<TF>::exec(Stats<TF>& stats, double time)
 {
     farm_power = 0; // reset accumulator
-    for (auto& t : turbines)
+
+    const int nturb = turbines.size();
+    if (nturb == 0)
+        return;
+
+    TF* const u = fields.mp.at("u")->fld.data();
+    TF* const v = fields.mp.at("v")->fld.data();
+
+    // Gather the local disk sums and yaw reference velocities of all turbines, and the
+    // velocities at the blade elements, and combine them over the ranks in a single reduction.
+    const int n_elem = actuator_line ? actuator_line->get_n_elements() : 0;
+    std::vector<TF> sums(n_sums*nturb + 3*n_elem, TF(0));
+
+    if (actuator_line)
     {
-        t.exec(stats, time);
-        farm_power += t.get_power();
+        actuator_line->advance(turbines, time);
+        actuator_line->sample(&sums[n_sums*nturb]);
     }
-}
 
-template<typename TF>
-void Windfarm<TF>::prepare_device()
-{
-    // Allocate GPU data for all turbines
-    for (auto& t : turbines)
-        t.prepare_device();
-}
+    for (int n=0; n<nturb; ++n)
+    {
+        auto& t = turbines[n];
+
+        if (!t.is_active(time))
+            continue;
+
+        t.calc_disk_sums(sums[n_sums*n], sums[n_sums*n+1], u, v);
+
+        if (t.is_yaw_update(time))
+        {
+            const int idx = t.get_yaw_reference_index();
+            if (idx >= 0)
+            {
+                sums[n_sums*n+2] = u[idx];
+                sums[n_sums*n+3] = v[idx];
+            }
+        }
+    }
+
+    master.sum(sums.data(), sums.size());
+
+    for (int n=0; n<nturb; ++n)
+    {
+        auto& t = turbines[n];
+
+        if (!t.is_active(time))
+            continue;
+
+        if (t.is_yaw_update(time))
+            t.update_yaw(sums[n_sums*n+2], sums[n_sums*n+3]);
+
+        t.set_disk_velocity(sums[n_sums*n], sums[n_sums*n+1]);
+
+        if (!actuator_line)
+            t.apply_forcing(u, v);
+    }
+
+    if (actuator_line)
+        actuator_line->exec(turbines, &sums[n_sums*nturb], time);
 
-template<typename TF>
-void Windfarm<TF>::clear_device()
-{
-    // Clear GPU data for all turbines
     for (auto& t : turbines)
-        t.clear_device();
+        if (t.is_active(time))
+            farm_power += t.get_power();
 }
+#endif
 
 #ifdef FLOAT_SINGLE
 template class Windfarm<float>;
@@ -0,0 +1,90 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Error bounds of the approximated transcendental functions of fast_math.h against the standard library.
+
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include "fast_math.h"
+
+namespace
+{
+    namespace fm = Fast_math;
+
+    // Maximum relative error of exp_approx over n points in [x0, x1], against std::exp in long double.
+    template<typename TF>
+    double max_exp_error(const TF x0, const TF x1, const int n)
+    {
+        double err_max = 0.;
+        for (int i=0; i<=n; ++i)
+        {
+            const TF x = x0 + (x1-x0)*TF(i)/TF(n);
+            const long double ref = std::exp(static_cast<long double>(x));
+            const double err = std::abs((static_cast<long double>(fm::exp_approx(x)) - ref) / ref);
+            err_max = std::max(err_max, err);
+        }
+        return err_max;
+    }
+
+    template<typename TF>
+    int check_exp(const char* type, const double bound)
+    {
+        int nerror = 0;
+
+        const TF x0 = fm::Ieee754<TF>::exp_min;
+        const TF x1 = fm::Ieee754<TF>::exp_max;
+
+        // The bounds of the documentation, over the full range of the type and around zero.
+        const double err_full = max_exp_error<TF>(x0, x1, 1000000);
+        const double err_zero = max_exp_error<TF>(TF(-1), TF(1), 100000);
+        std::printf("exp_approx<%s>: max relative error %.3e (full range), %.3e (|x| <= 1)\n", type, err_full, err_zero);
+
+        if (err_full > bound || err_zero > bound)
+        {
+            std::printf("exp_approx<%s>: relative error exceeds %.1e\n", type, bound);
+            ++nerror;
+        }
+
+        // Outside of the range, the results are clipped to finite normal numbers.
+        const TF low  = fm::exp_approx(TF(10)*x0);
+        const TF high = fm::exp_approx(TF(10)*x1);
+        if (!(low >= std::numeric_limits<TF>::min()) || !std::isfinite(high))
+        {
+            std::printf("exp_approx<%s>: clipped results %.3e and %.3e are not finite normal numbers\n",
+                    type, double(low), double(high));
+            ++nerror;
+        }
+
+        return nerror;
+    }
+}
+
+int main()
+{
+    int nerror = 0;
+
+    nerror += check_exp<double>("double", 1e-8);
+    nerror += check_exp<float>("float", 5e-7);
+
+    return (nerror > 0);
+}
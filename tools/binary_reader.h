@@ -0,0 +1,219 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINARY_READER_H
+#define BINARY_READER_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Readers of the binary output of MicroHH, which map the files into memory, such that
+ * only the pages of the requested subvolumes and slices are read from disk.
+ * The fields of the dumps and restarts are stored as [k][j][i] with i running fastest.
+ * Cross-sections are 2D fields with nk = 1. Compressed fields (USEZSTD) cannot be mapped.
+ */
+namespace Binary_reader
+{
+    class Mapped_file
+    {
+        public:
+            explicit Mapped_file(const std::string& filename)
+            {
+                fd = open(filename.c_str(), O_RDONLY);
+                if (fd < 0)
+                    throw std::runtime_error("Cannot open \"" + filename + "\"");
+
+                struct stat st;
+                if (fstat(fd, &st) != 0)
+                {
+                    close(fd);
+                    throw std::runtime_error("Cannot stat \"" + filename + "\"");
+                }
+
+                nbytes = st.st_size;
+                ptr = (nbytes > 0) ? mmap(nullptr, nbytes, PROT_READ, MAP_SHARED, fd, 0) : nullptr;
+                if (ptr == MAP_FAILED)
+                {
+                    close(fd);
+                    throw std::runtime_error("Cannot map \"" + filename + "\"");
+                }
+            }
+
+            ~Mapped_file()
+            {
+                if (ptr != nullptr)
+                    munmap(ptr, nbytes);
+                close(fd);
+            }
+
+            Mapped_file(const Mapped_file&) = delete;
+            Mapped_file& operator=(const Mapped_file&) = delete;
+
+            const char* data() const { return static_cast<const char*>(ptr); }
+            std::size_t size() const { return nbytes; }
+
+            /// Tell the kernel which pages will be read, such that it reads them ahead.
+            void will_need(const std::size_t offset, const std::size_t length) const
+            {
+                const std::size_t page = sysconf(_SC_PAGESIZE);
+                const std::size_t begin = (offset / page) * page;
+                madvise(static_cast<char*>(ptr) + begin, offset + length - begin, MADV_WILLNEED);
+            }
+
+        private:
+            int fd;
+            void* ptr;
+            std::size_t nbytes;
+    };
+
+    /// Coordinates of grid.0000000, of which the precision follows from the file size.
+    struct Grid
+    {
+        int itot, jtot, ktot;
+        int itemsize;
+        std::vector<double> x, xh, y, yh, z, zh;
+
+        Grid(const std::string& filename, const int itot_in, const int jtot_in, const int ktot_in) :
+            itot(itot_in), jtot(jtot_in), ktot(ktot_in)
+        {
+            Mapped_file file(filename);
+
+            const std::size_t nvalues = 2*(itot + jtot + ktot);
+            if (file.size() != nvalues*sizeof(double) && file.size() != nvalues*sizeof(float))
+                throw std::runtime_error("The size of \"" + filename + "\" does not match itot, jtot and ktot");
+
+            itemsize = file.size() / nvalues;
+
+            std::size_t offset = 0;
+            auto read = [&](std::vector<double>& v, const int n)
+            {
+                v.resize(n);
+                for (int i=0; i<n; ++i)
+                {
+                    if (itemsize == sizeof(double))
+                        std::memcpy(&v[i], file.data() + offset, sizeof(double));
+                    else
+                    {
+                        float value;
+                        std::memcpy(&value, file.data() + offset, sizeof(float));
+                        v[i] = value;
+                    }
+                    offset += itemsize;
+                }
+            };
+
+            read(x, itot);
+            read(xh, itot);
+            read(y, jtot);
+            read(yh, jtot);
+            read(z, ktot);
+            read(zh, ktot);
+        }
+    };
+
+    /// Random access to a field of ni x nj x nk values of type T.
+    template<typename T>
+    class Field
+    {
+        public:
+            Field(const std::string& filename, const int ni_in, const int nj_in, const int nk_in) :
+                file(filename), ni(ni_in), nj(nj_in), nk(nk_in)
+            {
+                const char magic[8] = {'M', 'H', 'H', 'Z', 'S', 'T', 'D', '1'};
+                if (file.size() >= sizeof(magic) && std::memcmp(file.data(), magic, sizeof(magic)) == 0)
+                    throw std::runtime_error("\"" + filename + "\" is compressed and cannot be mapped");
+
+                if (file.size() != std::size_t(ni)*nj*nk*sizeof(T))
+                    throw std::runtime_error("The size of \"" + filename + "\" does not match the dimensions");
+            }
+
+            T operator()(const int i, const int j, const int k) const
+            {
+                T value;
+                std::memcpy(&value, file.data() + index(i, j, k)*sizeof(T), sizeof(T));
+                return value;
+            }
+
+            /// Copy the box [i0,i1) x [j0,j1) x [k0,k1), taking every stride-th point, to out as [k][j][i].
+            template<typename TO>
+            void get_subvolume(
+                    TO* const out,
+                    const int i0, const int i1, const int j0, const int j1, const int k0, const int k1,
+                    const int stride=1) const
+            {
+                if (i0 < 0 || i1 > ni || i0 >= i1 || j0 < 0 || j1 > nj || j0 >= j1 || k0 < 0 || k1 > nk || k0 >= k1 || stride < 1)
+                    throw std::runtime_error("Invalid subvolume");
+
+                std::size_t n = 0;
+                for (int k=k0; k<k1; k+=stride)
+                {
+                    file.will_need(index(i0, j0, k)*sizeof(T), (index(i1-1, j1-1, k) - index(i0, j0, k) + 1)*sizeof(T));
+
+                    for (int j=j0; j<j1; j+=stride)
+                    {
+                        const char* row = file.data() + index(0, j, k)*sizeof(T);
+                        for (int i=i0; i<i1; i+=stride)
+                        {
+                            T value;
+                            std::memcpy(&value, row + i*sizeof(T), sizeof(T));
+                            out[n++] = static_cast<TO>(value);
+                        }
+                    }
+                }
+            }
+
+            /// Copy the horizontal slice at level k to out as [j][i].
+            template<typename TO>
+            void get_xy_slice(TO* const out, const int k) const { get_subvolume(out, 0, ni, 0, nj, k, k+1); }
+
+            /// Copy the vertical slice at index j to out as [k][i].
+            template<typename TO>
+            void get_xz_slice(TO* const out, const int j) const { get_subvolume(out, 0, ni, j, j+1, 0, nk); }
+
+            /// Copy the vertical slice at index i to out as [k][j].
+            template<typename TO>
+            void get_yz_slice(TO* const out, const int i) const { get_subvolume(out, i, i+1, 0, nj, 0, nk); }
+
+            int get_ni() const { return ni; }
+            int get_nj() const { return nj; }
+            int get_nk() const { return nk; }
+
+        private:
+            Mapped_file file;
+            int ni, nj, nk;
+
+            std::size_t index(const int i, const int j, const int k) const
+            {
+                return i + std::size_t(j)*ni + std::size_t(k)*ni*nj;
+            }
+    };
+}
+#endif
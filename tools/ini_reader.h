@@ -0,0 +1,87 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INI_READER_H
+#define INI_READER_H
+
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+// Reader of the values in the .ini file of a case, for the tools that need the grid and the output settings.
+namespace Ini_reader
+{
+    // Values of the ini file as [section][key].
+    using Ini = std::map<std::string, std::map<std::string, std::string>>;
+
+    inline Ini read_ini(const std::string& filename)
+    {
+        std::ifstream file(filename);
+        if (!file.good())
+            throw std::runtime_error("Cannot open \"" + filename + "\"");
+
+        Ini ini;
+        std::string line, section;
+        while (std::getline(file, line))
+        {
+            line = line.substr(0, line.find('#'));
+            line.erase(0, line.find_first_not_of(" \t\r"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+
+            if (line.empty())
+                continue;
+            else if (line.front() == '[' && line.back() == ']')
+                section = line.substr(1, line.size()-2);
+            else
+            {
+                const size_t n = line.find('=');
+                if (n == std::string::npos)
+                    continue;
+
+                std::string key = line.substr(0, n);
+                std::string value = line.substr(n+1);
+                key.erase(key.find_last_not_of(" \t") + 1);
+                value.erase(0, value.find_first_not_of(" \t"));
+                ini[section][key] = value;
+            }
+        }
+
+        return ini;
+    }
+
+    inline std::string get_value(const Ini& ini, const std::string& section, const std::string& key, const std::string& def="")
+    {
+        auto its = ini.find(section);
+        if (its != ini.end())
+        {
+            auto itk = its->second.find(key);
+            if (itk != its->second.end())
+                return itk->second;
+        }
+
+        if (def.empty())
+            throw std::runtime_error("Item [" + section + "][" + key + "] is missing in the ini file");
+        return def;
+    }
+}
+#endif
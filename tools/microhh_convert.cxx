@@ -0,0 +1,324 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Parallel converter of binary 3D dumps to NetCDF, as python/3d_to_nc.py, of which the
+// processes each convert a part of the variables. The dumps are mapped into memory and
+// only the requested box is read, one level at a time.
+//
+// Usage: microhh_convert case.ini [-v var ...] [-t0 time] [-t1 time] [-tstep time]
+//                        [-n nprocs] [-box i0 i1 j0 j1 k0 k1] [-stride n] [-single] [-nocompression]
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <netcdf.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "binary_reader.h"
+#include "ini_reader.h"
+
+namespace
+{
+    using Ini_reader::Ini;
+    using Ini_reader::read_ini;
+    using Ini_reader::get_value;
+
+    std::vector<std::string> split_list(const std::string& value)
+    {
+        std::vector<std::string> list;
+        std::stringstream ss(value);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            item.erase(0, item.find_first_not_of(" \t"));
+            item.erase(item.find_last_not_of(" \t") + 1);
+            if (!item.empty())
+                list.push_back(item);
+        }
+        return list;
+    }
+
+    void nc_check(const int err)
+    {
+        if (err != NC_NOERR)
+            throw std::runtime_error(std::string("NetCDF error: ") + nc_strerror(err));
+    }
+
+    struct Settings
+    {
+        std::vector<std::string> variables;
+        double starttime;
+        double endtime;
+        double sampletime;
+        int iotimeprec;
+        int nprocs;
+        int i0, i1, j0, j1, k0, k1;
+        int stride;
+        bool single;
+        bool compression;
+    };
+
+    template<typename T>
+    void convert_variable(const std::string& name, const Binary_reader::Grid& grid, const Settings& s)
+    {
+        const bool is_u = (name == "u");
+        const bool is_v = (name == "v");
+        const bool is_w = (name == "w" || name == "lflx" || name == "sflx");
+
+        const int ni = (s.i1 - s.i0 + s.stride - 1) / s.stride;
+        const int nj = (s.j1 - s.j0 + s.stride - 1) / s.stride;
+        const int nk = (s.k1 - s.k0 + s.stride - 1) / s.stride;
+
+        int ncid;
+        nc_check(nc_create((name + ".nc").c_str(), NC_NETCDF4 | NC_CLOBBER, &ncid));
+
+        auto def_dim = [&](const std::string& dim_name, const int n, const std::vector<double>& coord, const int start)
+        {
+            int dimid, varid;
+            nc_check(nc_def_dim(ncid, dim_name.c_str(), n, &dimid));
+            nc_check(nc_def_var(ncid, dim_name.c_str(), NC_DOUBLE, 1, &dimid, &varid));
+
+            std::vector<double> values(n);
+            for (int i=0; i<n; ++i)
+                values[i] = coord[start + i*s.stride];
+
+            return std::make_tuple(dimid, varid, values);
+        };
+
+        int dim_time, var_time;
+        nc_check(nc_def_dim(ncid, "time", NC_UNLIMITED, &dim_time));
+        nc_check(nc_def_var(ncid, "time", NC_DOUBLE, 1, &dim_time, &var_time));
+
+        auto dz = def_dim(is_w ? "zh" : "z", nk, is_w ? grid.zh : grid.z, s.k0);
+        auto dy = def_dim(is_v ? "yh" : "y", nj, is_v ? grid.yh : grid.y, s.j0);
+        auto dx = def_dim(is_u ? "xh" : "x", ni, is_u ? grid.xh : grid.x, s.i0);
+
+        const int dimids[4] = {dim_time, std::get<0>(dz), std::get<0>(dy), std::get<0>(dx)};
+        int varid;
+        nc_check(nc_def_var(ncid, name.c_str(), s.single ? NC_FLOAT : NC_DOUBLE, 4, dimids, &varid));
+
+        const size_t chunks[4] = {1, 1, size_t(nj), size_t(ni)};
+        nc_check(nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunks));
+        if (s.compression)
+            nc_check(nc_def_var_deflate(ncid, varid, 1, 1, 1));
+
+        nc_check(nc_enddef(ncid));
+
+        for (auto* d : {&dz, &dy, &dx})
+            nc_check(nc_put_var_double(ncid, std::get<1>(*d), std::get<2>(*d).data()));
+
+        std::vector<double> slice(size_t(ni)*nj);
+        size_t nt = 0;
+
+        const int nsamples = static_cast<int>(std::round((s.endtime - s.starttime) / s.sampletime)) + 1;
+        for (int t=0; t<nsamples; ++t)
+        {
+            const double time = s.starttime + t*s.sampletime;
+            const long iotime = std::lround(time / std::pow(10., s.iotimeprec));
+
+            char filename[256];
+            std::snprintf(filename, 256, "%s.%07ld", name.c_str(), iotime);
+            if (access(filename, R_OK) != 0)
+            {
+                std::printf("Cannot find %s, stopping %s\n", filename, name.c_str());
+                break;
+            }
+
+            std::printf("Processing %8s, time=%7ld\n", name.c_str(), iotime);
+            Binary_reader::Field<T> field(filename, grid.itot, grid.jtot, grid.ktot);
+
+            const size_t tstart[1] = {nt};
+            const size_t tcount[1] = {1};
+            nc_check(nc_put_vara_double(ncid, var_time, tstart, tcount, &time));
+
+            for (int k=0; k<nk; ++k)
+            {
+                const int kk = s.k0 + k*s.stride;
+                field.get_subvolume(slice.data(), s.i0, s.i1, s.j0, s.j1, kk, kk+1, s.stride);
+
+                const size_t start[4] = {nt, size_t(k), 0, 0};
+                const size_t count[4] = {1, 1, size_t(nj), size_t(ni)};
+                nc_check(nc_put_vara_double(ncid, varid, start, count, slice.data()));
+            }
+
+            ++nt;
+        }
+
+        nc_check(nc_close(ncid));
+    }
+
+    Settings parse_arguments(int argc, char** argv, const Ini& ini, const Binary_reader::Grid& grid)
+    {
+        Settings s;
+        s.variables = split_list(get_value(ini, "dump", "dumplist", " "));
+        s.starttime = 0.;
+        s.endtime = std::stod(get_value(ini, "time", "endtime"));
+        s.sampletime = std::stod(get_value(ini, "dump", "sampletime", "0"));
+        s.iotimeprec = std::stoi(get_value(ini, "time", "iotimeprec", "0"));
+        s.nprocs = 1;
+        s.i0 = 0; s.i1 = grid.itot;
+        s.j0 = 0; s.j1 = grid.jtot;
+        s.k0 = 0; s.k1 = grid.ktot;
+        s.stride = 1;
+        s.single = false;
+        s.compression = true;
+
+        for (int n=2; n<argc; ++n)
+        {
+            const std::string arg = argv[n];
+            auto next = [&]()
+            {
+                if (n+1 >= argc)
+                    throw std::runtime_error("Missing value of " + arg);
+                return std::string(argv[++n]);
+            };
+
+            if (arg == "-v")
+            {
+                s.variables.clear();
+                while (n+1 < argc && argv[n+1][0] != '-')
+                    s.variables.push_back(argv[++n]);
+            }
+            else if (arg == "-t0")
+                s.starttime = std::stod(next());
+            else if (arg == "-t1")
+                s.endtime = std::stod(next());
+            else if (arg == "-tstep")
+                s.sampletime = std::stod(next());
+            else if (arg == "-n")
+                s.nprocs = std::stoi(next());
+            else if (arg == "-box")
+            {
+                s.i0 = std::stoi(next()); s.i1 = std::stoi(next());
+                s.j0 = std::stoi(next()); s.j1 = std::stoi(next());
+                s.k0 = std::stoi(next()); s.k1 = std::stoi(next());
+            }
+            else if (arg == "-stride")
+                s.stride = std::stoi(next());
+            else if (arg == "-single")
+                s.single = true;
+            else if (arg == "-nocompression")
+                s.compression = false;
+            else
+                throw std::runtime_error("Unknown argument " + arg);
+        }
+
+        if (s.variables.empty())
+            throw std::runtime_error("No variables to convert, use -v");
+        if (s.sampletime <= 0.)
+            throw std::runtime_error("The sampletime has to be positive, use -tstep");
+        if (s.nprocs < 1 || s.stride < 1)
+            throw std::runtime_error("The number of processes and the stride have to be at least one");
+        if (s.i0 < 0 || s.i1 > grid.itot || s.i0 >= s.i1 ||
+            s.j0 < 0 || s.j1 > grid.jtot || s.j0 >= s.j1 ||
+            s.k0 < 0 || s.k1 > grid.ktot || s.k0 >= s.k1)
+            throw std::runtime_error("The box has to be a non-empty part of the grid");
+
+        return s;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        if (argc < 2)
+        {
+            std::cerr << "Usage: microhh_convert case.ini [-v var ...] [-t0 time] [-t1 time] [-tstep time] "
+                         "[-n nprocs] [-box i0 i1 j0 j1 k0 k1] [-stride n] [-single] [-nocompression]" << std::endl;
+            return 1;
+        }
+
+        const Ini ini = read_ini(argv[1]);
+        const Binary_reader::Grid grid(
+                "grid.0000000",
+                std::stoi(get_value(ini, "grid", "itot")),
+                std::stoi(get_value(ini, "grid", "jtot")),
+                std::stoi(get_value(ini, "grid", "ktot")));
+
+        const Settings s = parse_arguments(argc, argv, ini, grid);
+
+        // The NetCDF library is not thread safe, such that the variables are divided over processes.
+        std::vector<pid_t> children;
+        int rank = 0;
+        for (int n=1; n<s.nprocs; ++n)
+        {
+            const pid_t pid = fork();
+            if (pid < 0)
+                throw std::runtime_error("Cannot start a process");
+            else if (pid == 0)
+            {
+                rank = n;
+                children.clear();
+                break;
+            }
+            children.push_back(pid);
+        }
+
+        int nerror = 0;
+        for (size_t v=rank; v<s.variables.size(); v+=s.nprocs)
+        {
+            try
+            {
+                if (grid.itemsize == sizeof(double))
+                    convert_variable<double>(s.variables[v], grid, s);
+                else
+                    convert_variable<float>(s.variables[v], grid, s);
+            }
+            catch (const std::exception& e)
+            {
+                std::printf("Failed to convert %s: %s\n", s.variables[v].c_str(), e.what());
+                ++nerror;
+            }
+        }
+
+        // A child leaves with _exit, which does not flush the buffered output.
+        if (rank > 0)
+        {
+            std::fflush(stdout);
+            _exit(nerror > 0);
+        }
+
+        for (const pid_t pid : children)
+        {
+            int status;
+            waitpid(pid, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                ++nerror;
+        }
+
+        return (nerror > 0);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "EXCEPTION: " << e.what() << std::endl;
+        return 1;
+    }
+}
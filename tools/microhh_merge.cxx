@@ -0,0 +1,170 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Merges the 3D fields that are saved in a file per rank (swfileperrank) into the single
+// files of the regular output, such that they can be restarted with another decomposition
+// or read by the other tools. The merged field replaces the manifest, one level at a time.
+//
+// Usage: microhh_merge [-clean] file ...
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Manifest
+    {
+        int itot, jtot, kmax, itemsize;
+        int npx, npy, imax, jmax;
+        std::vector<int> i0, j0; ///< Global start of the block of every rank.
+    };
+
+    Manifest read_manifest(const std::string& filename)
+    {
+        std::ifstream file(filename);
+        std::string tag;
+        int version = 0;
+        if (!(file >> tag >> version) || tag != "microhh_file_per_rank" || version != 1)
+            throw std::runtime_error("\"" + filename + "\" is not a file-per-rank manifest");
+
+        Manifest m;
+        file >> m.itot >> m.jtot >> m.kmax >> m.itemsize >> m.npx >> m.npy >> m.imax >> m.jmax;
+
+        const int nprocs = m.npx*m.npy;
+        m.i0.resize(nprocs);
+        m.j0.resize(nprocs);
+        for (int n=0; n<nprocs; ++n)
+        {
+            int rank;
+            file >> rank >> m.i0[n] >> m.j0[n];
+            if (rank != n)
+                throw std::runtime_error("Corrupt block list in \"" + filename + "\"");
+        }
+
+        if (!file)
+            throw std::runtime_error("Cannot read \"" + filename + "\"");
+
+        return m;
+    }
+
+    std::string block_name(const std::string& filename, const int rank)
+    {
+        char name[256];
+        std::snprintf(name, 256, "%s.%05d", filename.c_str(), rank);
+        return name;
+    }
+
+    void merge(const std::string& filename, const bool clean)
+    {
+        const Manifest m = read_manifest(filename);
+        const int nprocs = m.npx*m.npy;
+
+        std::vector<FILE*> blocks(nprocs);
+        for (int n=0; n<nprocs; ++n)
+        {
+            blocks[n] = std::fopen(block_name(filename, n).c_str(), "rb");
+            if (blocks[n] == nullptr)
+                throw std::runtime_error("Cannot open \"" + block_name(filename, n) + "\"");
+        }
+
+        const std::string tmpname = filename + ".merge";
+        FILE* out = std::fopen(tmpname.c_str(), "wbx");
+        if (out == nullptr)
+            throw std::runtime_error("Cannot create \"" + tmpname + "\"");
+
+        // The blocks are stored consecutively per level, such that they are read sequentially.
+        const size_t row = m.imax*m.itemsize;
+        std::vector<char> block(m.jmax*row);
+        std::vector<char> level(static_cast<size_t>(m.itot)*m.jtot*m.itemsize);
+
+        for (int k=0; k<m.kmax; ++k)
+        {
+            for (int n=0; n<nprocs; ++n)
+            {
+                if (std::fread(block.data(), 1, block.size(), blocks[n]) != block.size())
+                    throw std::runtime_error("Cannot read \"" + block_name(filename, n) + "\"");
+
+                for (int j=0; j<m.jmax; ++j)
+                {
+                    const size_t ij = (static_cast<size_t>(m.j0[n]+j)*m.itot + m.i0[n])*m.itemsize;
+                    std::copy(block.begin() + j*row, block.begin() + (j+1)*row, level.begin() + ij);
+                }
+            }
+
+            if (std::fwrite(level.data(), 1, level.size(), out) != level.size())
+                throw std::runtime_error("Cannot write \"" + tmpname + "\"");
+        }
+
+        for (FILE* f : blocks)
+            std::fclose(f);
+
+        if (std::fclose(out) || std::rename(tmpname.c_str(), filename.c_str()))
+            throw std::runtime_error("Cannot replace \"" + filename + "\"");
+
+        if (clean)
+            for (int n=0; n<nprocs; ++n)
+                std::remove(block_name(filename, n).c_str());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool clean = false;
+    std::vector<std::string> files;
+    for (int n=1; n<argc; ++n)
+    {
+        const std::string arg = argv[n];
+        if (arg == "-clean")
+            clean = true;
+        else
+            files.push_back(arg);
+    }
+
+    if (files.empty())
+    {
+        std::cerr << "Usage: microhh_merge [-clean] file ..." << std::endl;
+        return 1;
+    }
+
+    int nerror = 0;
+    for (const std::string& file : files)
+    {
+        try
+        {
+            merge(file, clean);
+            std::cout << "Merged \"" << file << "\"" << std::endl;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            ++nerror;
+        }
+    }
+
+    return (nerror > 0);
+}
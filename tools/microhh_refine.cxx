@@ -0,0 +1,403 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2024 Chiel van Heerwaarden
+ * Copyright (c) 2011-2024 Thijs Heus
+ * Copyright (c) 2014-2024 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+// Interpolates the restart files of a coarse run onto the grid of a finer run, such that the fine
+// run starts from the developed turbulence of the coarse one. Run it in the directory of the fine
+// case after its `microhh init`, which provides the grid, the FFTW plan and the files of time 0.
+// The cell averages are remapped conservatively, at the staggered locations of u and v as well;
+// w and the half-level base state profiles are interpolated linearly in height, and the first
+// pressure solve of the fine run removes the divergence that the interpolation leaves. The
+// horizontal extent and the domain top of both runs have to be equal.
+//
+// Usage: microhh_refine coarse_dir/case.ini case.ini iotime
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+
+#include "binary_reader.h"
+#include "ini_reader.h"
+
+namespace
+{
+    // Weights of the source cells of every target cell.
+    using Weights = std::vector<std::vector<std::pair<int, double>>>;
+
+    // Conservative remap of the averages of the cells between the edges `src` onto the cells between
+    // the edges `dst`, of which the overlaps are periodic over `length` if it is positive.
+    Weights conservative_weights(const std::vector<double>& src, const std::vector<double>& dst, const double length)
+    {
+        const std::vector<double> shifts = (length > 0.) ? std::vector<double>{-length, 0., length} : std::vector<double>{0.};
+
+        Weights w(dst.size()-1);
+        for (size_t n=0; n<dst.size()-1; ++n)
+        {
+            double sum = 0.;
+            for (const double shift : shifts)
+                for (size_t m=0; m<src.size()-1; ++m)
+                {
+                    const double overlap = std::min(dst[n+1], src[m+1]+shift) - std::max(dst[n], src[m]+shift);
+                    if (overlap > 0.)
+                    {
+                        w[n].emplace_back(m, overlap);
+                        sum += overlap;
+                    }
+                }
+
+            if (sum <= 0.)
+                throw std::runtime_error("The fine grid exceeds the coarse grid");
+
+            for (auto& p : w[n])
+                p.second /= sum;
+        }
+
+        return w;
+    }
+
+    // Linear interpolation from the points `src` to `dst`, of which the points beyond `n_src` are zero.
+    Weights linear_weights(const std::vector<double>& src, const std::vector<double>& dst, const int n_src)
+    {
+        Weights w(dst.size());
+        for (size_t n=0; n<dst.size(); ++n)
+        {
+            const auto it = std::upper_bound(src.begin(), src.end(), dst[n]);
+            const int m = std::min(std::max(int(it - src.begin()) - 1, 0), int(src.size()) - 2);
+            const double f = std::min(std::max((dst[n] - src[m]) / (src[m+1] - src[m]), 0.), 1.);
+
+            if (m < n_src)
+                w[n].emplace_back(m, 1.-f);
+            if (m+1 < n_src)
+                w[n].emplace_back(m+1, f);
+        }
+
+        return w;
+    }
+
+    struct Case
+    {
+        int itot, jtot, ktot;
+        double xsize, ysize;
+        Binary_reader::Grid grid;
+        std::vector<double> zh; ///< Half levels, including the domain top.
+
+        explicit Case(const Ini_reader::Ini& ini, const std::string& dir) :
+            itot(std::stoi(Ini_reader::get_value(ini, "grid", "itot"))),
+            jtot(std::stoi(Ini_reader::get_value(ini, "grid", "jtot"))),
+            ktot(std::stoi(Ini_reader::get_value(ini, "grid", "ktot"))),
+            xsize(std::stod(Ini_reader::get_value(ini, "grid", "xsize"))),
+            ysize(std::stod(Ini_reader::get_value(ini, "grid", "ysize"))),
+            grid(dir + "grid.0000000", itot, jtot, ktot)
+        {
+            zh = grid.zh;
+            zh.push_back(2.*grid.z[ktot-1] - grid.zh[ktot-1]);
+        }
+
+        // Edges of the cells around the centres (staggered=false) or the faces in x and y.
+        std::vector<double> get_edges(const std::vector<double>& xh, const double size, const bool staggered) const
+        {
+            const double shift = staggered ? 0.5*size/xh.size() : 0.;
+            std::vector<double> edges;
+            for (const double x : xh)
+                edges.push_back(x - shift);
+            edges.push_back(size - shift);
+            return edges;
+        }
+    };
+
+    // Remaps the horizontal levels of a field, with a cache of the remapped source levels.
+    class Refiner
+    {
+        public:
+            Refiner(const Case& c, const Case& f, const bool stag_x, const bool stag_y) :
+                cc(c), cf(f),
+                wx(conservative_weights(c.get_edges(c.grid.xh, c.xsize, stag_x), f.get_edges(f.grid.xh, f.xsize, stag_x), f.xsize)),
+                wy(conservative_weights(c.get_edges(c.grid.yh, c.ysize, stag_y), f.get_edges(f.grid.yh, f.ysize, stag_y), f.ysize))
+            {}
+
+            // Remap the horizontal level `in` of the coarse grid onto `out` of the fine grid.
+            void remap_level(std::vector<double>& out, const std::vector<double>& in) const
+            {
+                std::vector<double> tmp(size_t(cc.jtot)*cf.itot, 0.);
+                for (int j=0; j<cc.jtot; ++j)
+                    for (int i=0; i<cf.itot; ++i)
+                        for (const auto& p : wx[i])
+                            tmp[i + size_t(j)*cf.itot] += p.second * in[p.first + size_t(j)*cc.itot];
+
+                out.assign(size_t(cf.jtot)*cf.itot, 0.);
+                for (int j=0; j<cf.jtot; ++j)
+                    for (const auto& p : wy[j])
+                        for (int i=0; i<cf.itot; ++i)
+                            out[i + size_t(j)*cf.itot] += p.second * tmp[i + size_t(p.first)*cf.itot];
+            }
+
+        private:
+            const Case& cc;
+            const Case& cf;
+            const Weights wx;
+            const Weights wy;
+    };
+
+    template<typename T>
+    void write_values(FILE* out, const std::vector<double>& values, const std::string& filename)
+    {
+        std::vector<T> buffer(values.begin(), values.end());
+        if (std::fwrite(buffer.data(), sizeof(T), buffer.size(), out) != buffer.size())
+            throw std::runtime_error("Cannot write \"" + filename + "\"");
+    }
+
+    FILE* create_file(const std::string& filename)
+    {
+        FILE* out = std::fopen(filename.c_str(), "wbx");
+        if (out == nullptr)
+            throw std::runtime_error("Cannot create \"" + filename + "\"");
+        return out;
+    }
+
+    // Refine the nk levels of a field, of which the fine levels are combined from the coarse ones with `wz`.
+    template<typename T>
+    void refine_field(
+            const std::string& src, const std::string& dst, const Case& c, const Case& f,
+            const int nk, const Weights& wz, const bool stag_x, const bool stag_y)
+    {
+        const Binary_reader::Field<T> field(src, c.itot, c.jtot, nk);
+        const Refiner refiner(c, f, stag_x, stag_y);
+
+        FILE* out = create_file(dst);
+
+        // The weights of the successive fine levels use increasing coarse levels, of which
+        // the remapped ones are kept until no later fine level needs them.
+        std::map<int, std::vector<double>> cache;
+        std::vector<double> level(size_t(c.itot)*c.jtot);
+        std::vector<double> fine;
+
+        for (size_t k=0; k<wz.size(); ++k)
+        {
+            std::vector<double> sum(size_t(f.itot)*f.jtot, 0.);
+            for (const auto& p : wz[k])
+            {
+                if (cache.find(p.first) == cache.end())
+                {
+                    field.get_xy_slice(level.data(), p.first);
+                    refiner.remap_level(cache[p.first], level);
+                }
+
+                const std::vector<double>& remapped = cache.at(p.first);
+                for (size_t n=0; n<sum.size(); ++n)
+                    sum[n] += p.second * remapped[n];
+            }
+
+            if (!wz[k].empty())
+                cache.erase(cache.begin(), cache.lower_bound(wz[k].front().first));
+
+            write_values<T>(out, sum, dst);
+        }
+
+        if (std::fclose(out))
+            throw std::runtime_error("Cannot write \"" + dst + "\"");
+    }
+
+    // Remap the profiles of the base state of Thermo_moist: thl0, qt0, then the pairs of full and half
+    // levels of thvref, pref, exnref and rhoref.
+    template<typename T>
+    void refine_basestate(const std::string& src, const std::string& dst, const Case& c, const Case& f)
+    {
+        const Binary_reader::Field<T> field(src, 6*c.ktot + 4*(c.ktot+1), 1, 1);
+
+        const Weights wz = conservative_weights(c.zh, f.zh, 0.);
+        const Weights wzh = linear_weights(c.zh, f.zh, c.ktot+1);
+        const bool half[10] = {false, false, false, true, false, true, false, true, false, true};
+
+        FILE* out = create_file(dst);
+
+        int offset = 0;
+        for (const bool h : half)
+        {
+            const int nk = h ? c.ktot+1 : c.ktot;
+            const Weights& w = h ? wzh : wz;
+
+            std::vector<double> profile(w.size(), 0.);
+            for (size_t k=0; k<w.size(); ++k)
+                for (const auto& p : w[k])
+                    profile[k] += p.second * field(offset + p.first, 0, 0);
+
+            write_values<T>(out, profile, dst);
+            offset += nk;
+        }
+
+        if (std::fclose(out))
+            throw std::runtime_error("Cannot write \"" + dst + "\"");
+    }
+
+    // Copy the time of the restart, of which the time step is reduced by the ratio of the grid spacings.
+    void refine_time(const std::string& src, const std::string& dst, const Case& c, const Case& f)
+    {
+        FILE* in = std::fopen(src.c_str(), "rb");
+        if (in == nullptr)
+            throw std::runtime_error("Cannot open \"" + src + "\"");
+
+        unsigned long itime, idt;
+        int iteration;
+        const bool ok = std::fread(&itime, sizeof(unsigned long), 1, in) == 1
+            && std::fread(&idt, sizeof(unsigned long), 1, in) == 1
+            && std::fread(&iteration, sizeof(int), 1, in) == 1;
+        std::fclose(in);
+        if (!ok)
+            throw std::runtime_error("Cannot read \"" + src + "\"");
+
+        auto get_dz_min = [](const Case& cs)
+        {
+            double dz_min = cs.zh[1] - cs.zh[0];
+            for (int k=1; k<cs.ktot; ++k)
+                dz_min = std::min(dz_min, cs.zh[k+1] - cs.zh[k]);
+            return dz_min;
+        };
+
+        double ratio = std::min(double(c.itot) / f.itot, get_dz_min(f) / get_dz_min(c));
+        if (c.jtot > 1)
+            ratio = std::min(ratio, double(c.jtot) / f.jtot);
+        idt = std::max(static_cast<unsigned long>(idt * std::min(ratio, 1.)), 1UL);
+
+        FILE* out = create_file(dst);
+        const bool written = std::fwrite(&itime, sizeof(unsigned long), 1, out) == 1
+            && std::fwrite(&idt, sizeof(unsigned long), 1, out) == 1
+            && std::fwrite(&iteration, sizeof(int), 1, out) == 1;
+        if (std::fclose(out) || !written)
+            throw std::runtime_error("Cannot write \"" + dst + "\"");
+    }
+
+    // Names of the restart files of the coarse run at iotime, which have no other dots in the name,
+    // unlike the cross-sections and the blocks of swfileperrank.
+    std::vector<std::string> list_restart_files(const std::string& dir, const std::string& suffix)
+    {
+        std::vector<std::string> names;
+
+        DIR* d = opendir(dir.empty() ? "." : dir.c_str());
+        if (d == nullptr)
+            throw std::runtime_error("Cannot open the directory \"" + dir + "\"");
+
+        while (dirent* e = readdir(d))
+        {
+            const std::string name = e->d_name;
+            if (name.size() > suffix.size()
+                    && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0
+                    && name.find('.') == name.size() - suffix.size())
+                names.push_back(name.substr(0, name.size() - suffix.size()));
+        }
+        closedir(d);
+
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    template<typename T>
+    void refine(const std::string& coarse_dir, const Case& c, const Case& f, const std::string& suffix)
+    {
+        const size_t n2d = size_t(c.itot)*c.jtot*sizeof(T);
+
+        const Weights wz = conservative_weights(c.zh, f.zh, 0.);
+        const Weights wzh = linear_weights(c.zh, std::vector<double>(f.zh.begin(), f.zh.end()-1), c.ktot);
+
+        for (const std::string& name : list_restart_files(coarse_dir, suffix))
+        {
+            const std::string src = coarse_dir + name + suffix;
+            const std::string dst = name + suffix;
+            const size_t size = Binary_reader::Mapped_file(src).size();
+
+            const bool soil = name.size() > 5 && name.compare(name.size()-5, 5, "_soil") == 0;
+
+            if (name == "time")
+                refine_time(src, dst, c, f);
+            else if (name == "thermo_basestate")
+                refine_basestate<T>(src, dst, c, f);
+            else if (size == n2d*c.ktot && !soil)
+                refine_field<T>(src, dst, c, f, c.ktot, (name == "w") ? wzh : wz, name == "u", name == "v");
+            else if (size > 0 && size % n2d == 0)
+            {
+                // Surface fields and the soil, of which the levels are only refined horizontally.
+                const int nk = size / n2d;
+                Weights wlev(nk);
+                for (int k=0; k<nk; ++k)
+                    wlev[k].emplace_back(k, 1.);
+                refine_field<T>(src, dst, c, f, nk, wlev, false, false);
+            }
+            else
+            {
+                std::cout << "Skipped \"" << src << "\", of which the size matches no grid" << std::endl;
+                continue;
+            }
+
+            std::cout << "Refined \"" << src << "\" to \"" << dst << "\"" << std::endl;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cerr << "Usage: microhh_refine coarse_dir/case.ini case.ini iotime" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        const std::string coarse_ini = argv[1];
+        const size_t slash = coarse_ini.find_last_of('/');
+        const std::string coarse_dir = (slash == std::string::npos) ? "" : coarse_ini.substr(0, slash+1);
+
+        const Case c(Ini_reader::read_ini(coarse_ini), coarse_dir);
+        const Case f(Ini_reader::read_ini(argv[2]), "");
+
+        if (std::abs(c.xsize - f.xsize) > 1.e-6*f.xsize || std::abs(c.ysize - f.ysize) > 1.e-6*f.ysize)
+            throw std::runtime_error("The horizontal extent of the coarse and fine runs differ");
+        if (std::abs(c.zh.back() - f.zh.back()) > 1.e-6*f.zh.back())
+            throw std::runtime_error("The domain top of the coarse and fine runs differ");
+        if (c.grid.itemsize != f.grid.itemsize)
+            throw std::runtime_error("The precision of the coarse and fine runs differ");
+
+        char suffix[16];
+        std::snprintf(suffix, 16, ".%07d", std::stoi(argv[3]));
+
+        if (c.grid.itemsize == sizeof(double))
+            refine<double>(coarse_dir, c, f, suffix);
+        else
+            refine<float>(coarse_dir, c, f, suffix);
+
+        std::cout << "Set [time] starttime of the fine run to the time of the restart" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
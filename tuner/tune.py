@@ -4,6 +4,7 @@ import argparse
 import traceback
 import socket
 import re
+import glob
 import datetime
 
 MICROHH_HOME = os.path.join(os.path.dirname(__file__), "..")
@@ -144,12 +145,17 @@ def main():
     parser.add_argument("--tolerance", "--atol", dest="atol", type=float,
                         help="Absolute tolerance used for verification as interpreted by numpy.isclose.")
     parser.add_argument("--append", "-a", default=False, action="store_true",
-                        help="Append new results to existing wisdom instead of overwriting them.")
+                        help="Append new results to existing wisdom instead of overwriting them. "
+                             "The wisdom stores results per device, so use this to add another GPU architecture.")
     parser.add_argument("--strategy", "-s", default="bayes", choices=["block", "bayes", "random"],
                         help="The strategy to use for tuning:\n"
                              " - random: try random configurations until time runs out.\n"
                              " - bayes: use Bayesian optimization to try configurations until time runs out.\n"
                              " - block: brute-force search block sizes and then optimize the remaining parameters.\n")
+    parser.add_argument("--captures", "-c", default=None,
+                        help="Directory with kernel captures (.json); all captures in it are tuned in addition to the given files.")
+    parser.add_argument("--kernel", "-k", default=None,
+                        help="Only tune the captures of which the file name matches this regular expression.")
     parser.add_argument("files", nargs="*")
 
     args = parser.parse_args()
@@ -158,10 +164,17 @@ def main():
         print(f"error: not a valid directory: {args.output}")
         return
 
-    if not args.files:
+    files = list(args.files)
+    if args.captures is not None:
+        files += sorted(glob.glob(os.path.join(args.captures, "*.json")))
+
+    if args.kernel is not None:
+        files = [f for f in files if re.search(args.kernel, os.path.basename(f))]
+
+    if not files:
         print(f"error: no files given")
 
-    for file in args.files:
+    for file in files:
         try:
             tune_kernel(file, args)
         except Exception as e: